@@ -251,6 +251,26 @@
 #endif
 
 
+/**
+ * Macro PJ_SCANNER_USE_SIMD, if non-zero, enables SIMD matching of
+ * character input specification in the scanner, so that runs of matching
+ * (or non-matching) characters are scanned 16 (SSSE3) or 32 (AVX2) bytes
+ * at a time. The instruction set is selected at run-time according to the
+ * CPU, falling back to the byte by byte matching. This requires GCC or
+ * Clang on x86 or x86-64.
+ *
+ * Default: enabled when supported by the compiler and target.
+ */
+#ifndef PJ_SCANNER_USE_SIMD
+#  if (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)) && \
+      (defined(__x86_64__) || defined(__i386__))
+#    define PJ_SCANNER_USE_SIMD                     1
+#  else
+#    define PJ_SCANNER_USE_SIMD                     0
+#  endif
+#endif
+
+
 
 /* **************************************************************************
  * STUN CLIENT CONFIGURATION
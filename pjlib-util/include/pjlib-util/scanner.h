@@ -37,6 +37,18 @@ PJ_BEGIN_DECL
  *
  * @{
  */
+
+#if defined(PJ_SCANNER_USE_SIMD) && PJ_SCANNER_USE_SIMD != 0
+/*
+ * With SIMD matching, the specification also keeps its characters in a
+ * nibble map: the low nibble of a character selects the byte of the map
+ * (the first 16 bytes for characters below 0x80, the next 16 bytes for the
+ * rest), and the high nibble selects the bit in that byte.
+ */
+#  define PJ_CIS_NIBBLE_IDX(c)  (((c) & 0x0F) | (((c) & 0x80) >> 3))
+#  define PJ_CIS_NIBBLE_BIT(c)  ((pj_uint8_t)(1 << (((c) >> 4) & 7)))
+#endif
+
 #if defined(PJ_SCANNER_USE_BITWISE) && PJ_SCANNER_USE_BITWISE != 0
 #  include <pjlib-util/scanner_cis_bitwise.h>
 #else
@@ -59,6 +59,9 @@ typedef struct pj_cis_t
 {
     pj_cis_elem_t   *cis_buf;       /**< Pointer to buffer.     */
     int              cis_id;        /**< Id.                    */
+#if defined(PJ_SCANNER_USE_SIMD) && PJ_SCANNER_USE_SIMD != 0
+    pj_uint8_t       nibble_map[32];/**< Map for SIMD matching. */
+#endif
 } pj_cis_t;
 
 
@@ -69,7 +72,13 @@ typedef struct pj_cis_t
  * @param cis       Pointer to character input specification.
  * @param c         The character.
  */
-#define PJ_CIS_SET(cis,c)   ((cis)->cis_buf[(int)(c)] |= (1 << (cis)->cis_id))
+#if defined(PJ_SCANNER_USE_SIMD) && PJ_SCANNER_USE_SIMD != 0
+#  define PJ_CIS_SET(cis,c) ((cis)->cis_buf[(int)(c)] |= (1 << (cis)->cis_id),\
+                             (cis)->nibble_map[PJ_CIS_NIBBLE_IDX((int)(c))] |= \
+                                PJ_CIS_NIBBLE_BIT((int)(c)))
+#else
+#  define PJ_CIS_SET(cis,c) ((cis)->cis_buf[(int)(c)] |= (1 << (cis)->cis_id))
+#endif
 
 /**
  * Remove the membership of the specified character.
@@ -78,7 +87,13 @@ typedef struct pj_cis_t
  * @param cis       Pointer to character input specification.
  * @param c         The character to be removed from the membership.
  */
-#define PJ_CIS_CLR(cis,c)   ((cis)->cis_buf[(int)c] &= ~(1 << (cis)->cis_id))
+#if defined(PJ_SCANNER_USE_SIMD) && PJ_SCANNER_USE_SIMD != 0
+#  define PJ_CIS_CLR(cis,c) ((cis)->cis_buf[(int)c] &= ~(1 << (cis)->cis_id),\
+                             (cis)->nibble_map[PJ_CIS_NIBBLE_IDX((int)(c))] &= \
+                                (pj_uint8_t)~PJ_CIS_NIBBLE_BIT((int)(c)))
+#else
+#  define PJ_CIS_CLR(cis,c) ((cis)->cis_buf[(int)c] &= ~(1 << (cis)->cis_id))
+#endif
 
 /**
  * Check the membership of the specified character.
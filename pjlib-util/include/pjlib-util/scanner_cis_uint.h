@@ -46,6 +46,9 @@ typedef int pj_cis_buf_t;
 typedef struct pj_cis_t
 {
     PJ_CIS_ELEM_TYPE    cis_buf[256];   /**< Internal buffer.   */
+#if defined(PJ_SCANNER_USE_SIMD) && PJ_SCANNER_USE_SIMD != 0
+    pj_uint8_t          nibble_map[32]; /**< Map for SIMD matching. */
+#endif
 } pj_cis_t;
 
 
@@ -56,7 +59,13 @@ typedef struct pj_cis_t
  * @param cis       Pointer to character input specification.
  * @param c         The character.
  */
-#define PJ_CIS_SET(cis,c)   ((cis)->cis_buf[(int)(c)] = 1)
+#if defined(PJ_SCANNER_USE_SIMD) && PJ_SCANNER_USE_SIMD != 0
+#  define PJ_CIS_SET(cis,c) ((cis)->cis_buf[(int)(c)] = 1, \
+                             (cis)->nibble_map[PJ_CIS_NIBBLE_IDX((int)(c))] |= \
+                                PJ_CIS_NIBBLE_BIT((int)(c)))
+#else
+#  define PJ_CIS_SET(cis,c) ((cis)->cis_buf[(int)(c)] = 1)
+#endif
 
 /**
  * Remove the membership of the specified character.
@@ -65,7 +74,13 @@ typedef struct pj_cis_t
  * @param cis       Pointer to character input specification.
  * @param c         The character to be removed from the membership.
  */
-#define PJ_CIS_CLR(cis,c)   ((cis)->cis_buf[(int)c] = 0)
+#if defined(PJ_SCANNER_USE_SIMD) && PJ_SCANNER_USE_SIMD != 0
+#  define PJ_CIS_CLR(cis,c) ((cis)->cis_buf[(int)c] = 0, \
+                             (cis)->nibble_map[PJ_CIS_NIBBLE_IDX((int)(c))] &= \
+                                (pj_uint8_t)~PJ_CIS_NIBBLE_BIT((int)(c)))
+#else
+#  define PJ_CIS_CLR(cis,c) ((cis)->cis_buf[(int)c] = 0)
+#endif
 
 /**
  * Check the membership of the specified character.
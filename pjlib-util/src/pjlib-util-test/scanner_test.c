@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "test.h"
+
+#define THIS_FILE       "scanner_test.c"
+
+#if INCLUDE_SCANNER_TEST
+
+#include <pjlib-util/scanner.h>
+#include <pjlib-util/config.h>
+#include <pj/log.h>
+#include <pj/os.h>
+#include <pj/pool.h>
+#include <pj/rand.h>
+#include <pj/string.h>
+
+#define MAX_LEN         96
+
+/* Keeps the benchmark loops from being optimized away */
+static volatile pj_size_t bench_sink;
+
+static void syntax_error(pj_scanner *scanner)
+{
+    PJ_UNUSED_ARG(scanner);
+}
+
+/* Reference: first position from s which is (in==0) or is not (in!=0)
+ * in the specification.
+ */
+static const char *ref_span(const pj_cis_t *cis, const char *s,
+                            const char *end, int in)
+{
+    while (s != end && (pj_cis_match(cis, *s) ? 1 : 0) == in)
+        ++s;
+    return s;
+}
+
+/* Build a random specification, with roughly density/256 of the characters
+ * set. Character zero is never set, as required by the scanner.
+ */
+static void rand_spec(pj_cis_t *cis, unsigned density)
+{
+    unsigned c;
+
+    for (c=1; c<256; ++c) {
+        if (((unsigned)pj_rand() & 0xFF) < density)
+            PJ_CIS_SET(cis, c);
+        else
+            PJ_CIS_CLR(cis, c);
+    }
+}
+
+/*
+ * Verify the span operations of the scanner against byte by byte matching,
+ * for all buffer lengths and alignments, so that both the vector loop and
+ * the tail are exercised.
+ */
+static int scanner_verify_span(void)
+{
+    enum { ROUNDS = 64 };
+    static const unsigned density[] = { 0, 16, 128, 240, 256 };
+    pj_cis_buf_t cis_buf;
+    pj_cis_t cis;
+    char buf[MAX_LEN + 64];
+    unsigned round;
+
+    pj_cis_buf_init(&cis_buf);
+    if (pj_cis_init(&cis_buf, &cis) != PJ_SUCCESS)
+        return -10;
+
+    for (round=0; round<ROUNDS; ++round) {
+        unsigned i, len, off;
+
+        rand_spec(&cis, density[round % PJ_ARRAY_SIZE(density)]);
+
+        for (i=0; i<sizeof(buf); ++i) {
+            /* Mostly matching characters, so that spans get long */
+            unsigned c = (unsigned)pj_rand() & 0xFF;
+            if ((pj_rand() & 7) != 0) {
+                unsigned tries;
+                for (tries=0; tries<256; ++tries, c=(c+1) & 0xFF) {
+                    int match = pj_cis_match(&cis, (pj_uint8_t)c) != 0;
+                    if (c && match == (int)(round & 1))
+                        break;
+                }
+            }
+            buf[i] = (char)c;
+        }
+
+        for (off=0; off<32; ++off) {
+            for (len=1; len<=MAX_LEN; ++len) {
+                pj_scanner scanner;
+                char *start = buf + off, *end = buf + off + len;
+                char saved = *end;
+                pj_str_t out;
+
+                /* The scanner wants a NULL terminated buffer */
+                *end = '\0';
+                pj_scan_init(&scanner, start, len, 0, &syntax_error);
+
+                pj_scan_peek(&scanner, &cis, &out);
+                if (out.ptr != start ||
+                    out.ptr + out.slen != ref_span(&cis, start, end, 1))
+                {
+                    PJ_LOG(1, (THIS_FILE, "  error: peek mismatch, round=%d "
+                               "off=%d len=%d", round, off, len));
+                    return -20;
+                }
+
+                pj_scan_peek_until(&scanner, &cis, &out);
+                if (out.ptr != start ||
+                    out.ptr + out.slen != ref_span(&cis, start, end, 0))
+                {
+                    PJ_LOG(1, (THIS_FILE, "  error: peek_until mismatch, "
+                               "round=%d off=%d len=%d", round, off, len));
+                    return -30;
+                }
+
+                if (pj_cis_match(&cis, *start)) {
+                    pj_scan_get(&scanner, &cis, &out);
+                    if (scanner.curptr != ref_span(&cis, start, end, 1)) {
+                        PJ_LOG(1, (THIS_FILE, "  error: get mismatch, "
+                                   "round=%d off=%d len=%d", round, off, len));
+                        return -40;
+                    }
+                } else {
+                    pj_scan_get_until(&scanner, &cis, &out);
+                    if (scanner.curptr != ref_span(&cis, start, end, 0)) {
+                        PJ_LOG(1, (THIS_FILE, "  error: get_until mismatch, "
+                                   "round=%d off=%d len=%d", round, off, len));
+                        return -50;
+                    }
+                }
+
+                pj_scan_fini(&scanner);
+                *end = saved;
+            }
+        }
+    }
+
+    /* pj_cis_dup() and pj_cis_invert() must keep the matching consistent */
+    {
+        pj_cis_t dup;
+        char *end;
+        unsigned i;
+
+        rand_spec(&cis, 0);
+        pj_cis_add_alpha(&cis);
+        if (pj_cis_dup(&dup, &cis) != PJ_SUCCESS)
+            return -60;
+        pj_cis_invert(&dup);
+
+        for (i=0; i<MAX_LEN; ++i)
+            buf[i] = (char)('a' + (i % 26));
+        buf[MAX_LEN-1] = '-';
+        buf[MAX_LEN] = '\0';
+
+        end = buf + MAX_LEN;
+        for (i=0; i<MAX_LEN; ++i) {
+            pj_scanner scanner;
+            pj_str_t out;
+
+            pj_scan_init(&scanner, buf + i, MAX_LEN - i, 0, &syntax_error);
+            pj_scan_peek(&scanner, &cis, &out);
+            if (out.ptr + out.slen != end - 1) {
+                pj_scan_fini(&scanner);
+                return -70;
+            }
+            pj_scan_peek(&scanner, &dup, &out);
+            if (i < MAX_LEN-1 && out.slen != 0) {
+                pj_scan_fini(&scanner);
+                return -80;
+            }
+            pj_scan_fini(&scanner);
+        }
+    }
+
+    return 0;
+}
+
+
+int scanner_test(void)
+{
+    int rc;
+
+    rc = scanner_verify_span();
+    if (rc)
+        return rc;
+
+    return 0;
+}
+
+
+#if WITH_BENCHMARK
+/*
+ * Measure scanning of tokens of several lengths separated by a single
+ * delimiter, with pj_scan_get() and with byte by byte matching.
+ */
+int scanner_benchmark(void)
+{
+    enum { BUF_LEN = 64 * 1024 };
+#if defined(PJ_DEBUG) && PJ_DEBUG!=0
+    enum { LOOP = 50 };
+#else
+    enum { LOOP = 500 };
+#endif
+    static const unsigned tok_len[] = { 4, 16, 64, 256 };
+    pj_pool_t *pool;
+    pj_cis_buf_t cis_buf;
+    pj_cis_t cis;
+    char *buf;
+    unsigned i;
+
+    pool = pj_pool_create(mem, "scanner", BUF_LEN + 256, 0, NULL);
+    if (!pool)
+        return PJ_ENOMEM;
+
+    buf = (char*)pj_pool_alloc(pool, BUF_LEN + 1);
+
+    pj_cis_buf_init(&cis_buf);
+    pj_cis_init(&cis_buf, &cis);
+    pj_cis_add_alpha(&cis);
+    pj_cis_add_num(&cis);
+    pj_cis_add_str(&cis, "-.!%*_+`'~");
+
+    PJ_LOG(3, (THIS_FILE, "  scanning %d Kbytes per run, SIMD %s",
+               BUF_LEN * LOOP / 1024,
+               PJ_SCANNER_USE_SIMD ? "enabled" : "disabled"));
+
+    for (i=0; i<PJ_ARRAY_SIZE(tok_len); ++i) {
+        pj_timestamp t1, t2;
+        pj_uint32_t t_scan, t_ref;
+        unsigned j, loop;
+        pj_size_t count = 0;
+
+        for (j=0; j<BUF_LEN; ++j) {
+            buf[j] = ((j+1) % (tok_len[i]+1) == 0) ? ';' :
+                     (char)('a' + (j % 26));
+        }
+        buf[BUF_LEN] = '\0';
+
+        pj_get_timestamp(&t1);
+        for (loop=0; loop<LOOP; ++loop) {
+            pj_scanner scanner;
+            pj_str_t tok;
+
+            pj_scan_init(&scanner, buf, BUF_LEN, 0, &syntax_error);
+            while (!pj_scan_is_eof(&scanner)) {
+                pj_scan_get(&scanner, &cis, &tok);
+                count += tok.slen;
+                if (!pj_scan_is_eof(&scanner))
+                    pj_scan_get_char(&scanner);
+            }
+            pj_scan_fini(&scanner);
+        }
+        pj_get_timestamp(&t2);
+        t_scan = pj_elapsed_usec(&t1, &t2);
+
+        pj_get_timestamp(&t1);
+        for (loop=0; loop<LOOP; ++loop) {
+            const char *p = buf, *end = buf + BUF_LEN;
+
+            while (p != end) {
+                const char *q = ref_span(&cis, p, end, 1);
+                count += (q - p);
+                p = (q == end) ? q : q + 1;
+            }
+        }
+        pj_get_timestamp(&t2);
+        t_ref = pj_elapsed_usec(&t1, &t2);
+
+        if (t_scan == 0) t_scan = 1;
+        if (t_ref == 0) t_ref = 1;
+
+        bench_sink += count;
+
+        PJ_LOG(3, (THIS_FILE, "  token length %3d: scanner %6d MB/s, "
+                   "byte by byte %6d MB/s",
+                   tok_len[i],
+                   (unsigned)((pj_uint64_t)BUF_LEN * LOOP / t_scan),
+                   (unsigned)((pj_uint64_t)BUF_LEN * LOOP / t_ref)));
+    }
+
+    pj_pool_release(pool);
+    return 0;
+}
+#endif  /* WITH_BENCHMARK */
+
+
+#else
+int scanner_test_dummy;
+#endif  /* INCLUDE_SCANNER_TEST */
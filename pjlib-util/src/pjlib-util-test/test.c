@@ -75,6 +75,13 @@ static int test_inner(int argc, char *argv[])
     UT_ADD_TEST(&test_app.ut_app, json_test, 0);
 #endif
 
+#if INCLUDE_SCANNER_TEST
+    UT_ADD_TEST(&test_app.ut_app, scanner_test, 0);
+#   if WITH_BENCHMARK
+    UT_ADD_TEST(&test_app.ut_app, scanner_benchmark, 0);
+#   endif
+#endif
+
 #if INCLUDE_ENCRYPTION_TEST
     UT_ADD_TEST(&test_app.ut_app, encryption_test, 0);
 #   if WITH_BENCHMARK
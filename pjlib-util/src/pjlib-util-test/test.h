@@ -27,6 +27,7 @@
 
 #define INCLUDE_XML_TEST            1
 #define INCLUDE_JSON_TEST           1
+#define INCLUDE_SCANNER_TEST        1
 #define INCLUDE_ENCRYPTION_TEST     1
 #define INCLUDE_STUN_TEST           1
 #define INCLUDE_RESOLVER_TEST       1
@@ -36,6 +37,8 @@
 
 extern int xml_test(void);
 extern int json_test(void);
+extern int scanner_test(void);
+extern int scanner_benchmark(void);
 extern int encryption_test();
 extern int encryption_benchmark();
 extern int stun_test();
@@ -39,6 +39,26 @@
 #  include "scanner_cis_uint.c"
 #endif
 
+#if defined(PJ_SCANNER_USE_SIMD) && PJ_SCANNER_USE_SIMD != 0
+#  include "scanner_simd.c"
+#else
+/* Return the first character in [s, end) which is not in spec. */
+PJ_INLINE(char*) cis_span(const pj_cis_t *spec, char *s, char *end)
+{
+    while (s != end && pj_cis_match(spec, *s))
+        ++s;
+    return s;
+}
+
+/* Return the first character in [s, end) which is in spec. */
+PJ_INLINE(char*) cis_cspan(const pj_cis_t *spec, char *s, char *end)
+{
+    while (s != end && !pj_cis_match(spec, *s))
+        ++s;
+    return s;
+}
+#endif
+
 
 /* coverity[+kill] */
 static void pj_scan_syntax_err(pj_scanner *scanner)
@@ -226,8 +246,7 @@ PJ_DEF(int) pj_scan_peek( pj_scanner *scanner,
         return -1;
     }
 
-    while (PJ_SCAN_CHECK_EOF(s) && pj_cis_match(spec, *s))
-        ++s;
+    s = cis_span(spec, s, scanner->end);
 
     pj_strset3(out, scanner->curptr, s);
     return *s;
@@ -260,8 +279,7 @@ PJ_DEF(int) pj_scan_peek_until( pj_scanner *scanner,
         return -1;
     }
 
-    while (PJ_SCAN_CHECK_EOF(s) && !pj_cis_match( spec, *s))
-        ++s;
+    s = cis_cspan(spec, s, scanner->end);
 
     pj_strset3(out, scanner->curptr, s);
     return *s;
@@ -280,9 +298,7 @@ PJ_DEF(void) pj_scan_get( pj_scanner *scanner,
         return;
     }
 
-    do {
-        ++s;
-    } while (PJ_SCAN_CHECK_EOF(s) && pj_cis_match(spec, *s));
+    s = cis_span(spec, s+1, scanner->end);
 
     pj_strset3(out, scanner->curptr, s);
 
@@ -337,9 +353,7 @@ PJ_DEF(void) pj_scan_get_unescape( pj_scanner *scanner,
         
         if (pj_cis_match(spec, *s)) {
             char *start = s;
-            do {
-                ++s;
-            } while (PJ_SCAN_CHECK_EOF(s) && pj_cis_match(spec, *s));
+            s = cis_span(spec, s+1, scanner->end);
 
             if (dst != start) pj_memmove(dst, start, s-start);
             dst += (s-start);
@@ -538,9 +552,7 @@ PJ_DEF(void) pj_scan_get_until( pj_scanner *scanner,
         return;
     }
 
-    while (PJ_SCAN_CHECK_EOF(s) && !pj_cis_match(spec, *s)) {
-        ++s;
-    }
+    s = cis_cspan(spec, s, scanner->end);
 
     pj_strset3(out, scanner->curptr, s);
 
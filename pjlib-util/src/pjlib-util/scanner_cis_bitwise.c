@@ -33,6 +33,9 @@ PJ_DEF(pj_status_t) pj_cis_init(pj_cis_buf_t *cis_buf, pj_cis_t *cis)
     unsigned i;
 
     cis->cis_buf = cis_buf->cis_buf;
+#if defined(PJ_SCANNER_USE_SIMD) && PJ_SCANNER_USE_SIMD != 0
+    pj_bzero(cis->nibble_map, sizeof(cis->nibble_map));
+#endif
 
     for (i=0; i<PJ_CIS_MAX_INDEX; ++i) {
         if ((cis_buf->use_mask & (1 << i)) == 0) {
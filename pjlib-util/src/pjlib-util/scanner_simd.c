@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * THIS FILE IS INCLUDED BY scanner.c.
+ * DO NOT COMPILE THIS FILE ALONE!
+ */
+
+/*
+ * SIMD matching of character input specification.
+ *
+ * Each input byte is looked up in the nibble map of the specification
+ * with pshufb: the low nibble selects the map byte (from the low or high
+ * half of the map, depending on the top bit of the input), and the high
+ * nibble selects the bit to test in that byte. This handles arbitrary sets
+ * of 256 characters, which the SSE4.2 string instructions cannot.
+ *
+ * The implementation is chosen on the first call according to the CPU.
+ */
+#include <immintrin.h>
+
+/* Scan from s while characters are (in!=0) or are not (in==0) in spec,
+ * and return the position of the first character that stops the scan.
+ */
+typedef const char* (*cis_span_func)(const pj_cis_t *spec, const char *s,
+                                     const char *end, int in);
+
+static const char *cis_span_scalar(const pj_cis_t *spec, const char *s,
+                                   const char *end, int in)
+{
+    if (in) {
+        while (s != end && pj_cis_match(spec, *s))
+            ++s;
+    } else {
+        while (s != end && !pj_cis_match(spec, *s))
+            ++s;
+    }
+    return s;
+}
+
+__attribute__((target("ssse3")))
+static const char *cis_span_ssse3(const pj_cis_t *spec, const char *s,
+                                  const char *end, int in)
+{
+    const __m128i map_lo = _mm_loadu_si128((const __m128i*)spec->nibble_map);
+    const __m128i map_hi = _mm_loadu_si128((const __m128i*)
+                                           (spec->nibble_map + 16));
+    const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                       1, 2, 4, 8, 16, 32, 64, -128);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i zero = _mm_setzero_si128();
+    const unsigned flip = in ? 0 : 0xFFFF;
+
+    while (end - s >= 16) {
+        __m128i v, lo, hi, top, row, bit, miss;
+        unsigned stop;
+
+        v = _mm_loadu_si128((const __m128i*)s);
+        lo = _mm_and_si128(v, nibble);
+        hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+        top = _mm_cmplt_epi8(v, zero);
+        row = _mm_or_si128(_mm_andnot_si128(top, _mm_shuffle_epi8(map_lo, lo)),
+                           _mm_and_si128(top, _mm_shuffle_epi8(map_hi, lo)));
+        bit = _mm_shuffle_epi8(bits, hi);
+        miss = _mm_cmpeq_epi8(_mm_and_si128(row, bit), zero);
+
+        stop = ((unsigned)_mm_movemask_epi8(miss)) ^ flip;
+        if (stop)
+            return s + __builtin_ctz(stop);
+        s += 16;
+    }
+
+    return cis_span_scalar(spec, s, end, in);
+}
+
+__attribute__((target("avx2")))
+static const char *cis_span_avx2(const pj_cis_t *spec, const char *s,
+                                 const char *end, int in)
+{
+    const __m256i map_lo = _mm256_broadcastsi128_si256(
+                        _mm_loadu_si128((const __m128i*)spec->nibble_map));
+    const __m256i map_hi = _mm256_broadcastsi128_si256(
+                        _mm_loadu_si128((const __m128i*)
+                                        (spec->nibble_map + 16)));
+    const __m256i bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                          1, 2, 4, 8, 16, 32, 64, -128,
+                                          1, 2, 4, 8, 16, 32, 64, -128,
+                                          1, 2, 4, 8, 16, 32, 64, -128);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i zero = _mm256_setzero_si256();
+    const unsigned flip = in ? 0 : 0xFFFFFFFF;
+
+    while (end - s >= 32) {
+        __m256i v, lo, hi, row, bit, miss;
+        unsigned stop;
+
+        v = _mm256_loadu_si256((const __m256i*)s);
+        lo = _mm256_and_si256(v, nibble);
+        hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+        row = _mm256_blendv_epi8(_mm256_shuffle_epi8(map_lo, lo),
+                                 _mm256_shuffle_epi8(map_hi, lo), v);
+        bit = _mm256_shuffle_epi8(bits, hi);
+        miss = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), zero);
+
+        stop = ((unsigned)_mm256_movemask_epi8(miss)) ^ flip;
+        if (stop)
+            return s + __builtin_ctz(stop);
+        s += 32;
+    }
+
+    return cis_span_ssse3(spec, s, end, in);
+}
+
+static const char *cis_span_select(const pj_cis_t *spec, const char *s,
+                                   const char *end, int in);
+
+static cis_span_func cis_span_impl = &cis_span_select;
+
+static const char *cis_span_select(const pj_cis_t *spec, const char *s,
+                                   const char *end, int in)
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        cis_span_impl = &cis_span_avx2;
+    else if (__builtin_cpu_supports("ssse3"))
+        cis_span_impl = &cis_span_ssse3;
+    else
+        cis_span_impl = &cis_span_scalar;
+
+    return (*cis_span_impl)(spec, s, end, in);
+}
+
+/* Number of characters to match one by one before switching to vector,
+ * since most tokens are short.
+ */
+#define CIS_SPAN_PREFIX     8
+
+/* Return the first character in [s, end) which is not in spec. */
+PJ_INLINE(char*) cis_span(const pj_cis_t *spec, char *s, char *end)
+{
+    char *lim = (end - s > CIS_SPAN_PREFIX) ? s + CIS_SPAN_PREFIX : end;
+
+    while (s != lim && pj_cis_match(spec, *s))
+        ++s;
+    if (s != lim || end - s < 16)
+        return (char*)cis_span_scalar(spec, s, end, 1);
+
+    return (char*)(*cis_span_impl)(spec, s, end, 1);
+}
+
+/* Return the first character in [s, end) which is in spec. */
+PJ_INLINE(char*) cis_cspan(const pj_cis_t *spec, char *s, char *end)
+{
+    char *lim = (end - s > CIS_SPAN_PREFIX) ? s + CIS_SPAN_PREFIX : end;
+
+    while (s != lim && !pj_cis_match(spec, *s))
+        ++s;
+    if (s != lim || end - s < 16)
+        return (char*)cis_span_scalar(spec, s, end, 0);
+
+    return (char*)(*cis_span_impl)(spec, s, end, 0);
+}
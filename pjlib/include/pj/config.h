@@ -605,6 +605,28 @@
 #  define PJ_TIMER_USE_LINKED_LIST    0
 #endif
 
+/**
+ * If enabled, the timer uses a hierarchical timing wheel instead of binary
+ * heap tree structure. Scheduling and cancelling an entry then take constant
+ * time regardless of the number of outstanding entries, and all entries
+ * which expire in the same millisecond are collected at once by
+ * pj_timer_heap_poll(). This suits applications with a very large number of
+ * outstanding timers, such as a SIP server handling many concurrent
+ * transactions.
+ *
+ * The wheel has a resolution of one millisecond. The delay returned by
+ * pj_timer_heap_poll() may be shorter than the time until the next entry
+ * actually expires, since entries far in the future are only moved closer
+ * to expiration as time passes.
+ *
+ * This setting cannot be enabled together with PJ_TIMER_USE_LINKED_LIST.
+ *
+ * Default: 0 (Use binary heap tree)
+ */
+#ifndef PJ_TIMER_USE_WHEEL
+#  define PJ_TIMER_USE_WHEEL    0
+#endif
+
 /**
  * If enabled, the hash TABLE (pj_hash_table_t) computes its bucket index with
  * a keyed hash (SipHash) using a per-process random key, instead of the plain
@@ -690,6 +712,30 @@
  */
 #ifndef PJ_HAS_IPV6
 #  define PJ_HAS_IPV6               0
+#endif
+
+/**
+ * Specify whether the platform supports recvmmsg() to receive multiple
+ * datagrams with a single system call. This is normally detected by the
+ * build system. When it is not available, #pj_sock_recvmmsg() falls back
+ * to calling #pj_sock_recvfrom() repeatedly.
+ *
+ * Default: 0 (unless detected)
+ */
+#ifndef PJ_HAS_RECVMMSG
+#  define PJ_HAS_RECVMMSG           0
+#endif
+
+/**
+ * Specify whether the platform supports sendmmsg() to transmit multiple
+ * datagrams with a single system call. This is normally detected by the
+ * build system. When it is not available, #pj_sock_sendmmsg() falls back
+ * to calling #pj_sock_sendto() repeatedly.
+ *
+ * Default: 0 (unless detected)
+ */
+#ifndef PJ_HAS_SENDMMSG
+#  define PJ_HAS_SENDMMSG           0
 #endif
 
  /**
@@ -744,6 +790,9 @@
 /** Using Symbian (deprecated) */
 #define PJ_IOQUEUE_IMP_SYMBIAN      6
 
+/** Using Linux io_uring (experimental) */
+#define PJ_IOQUEUE_IMP_IO_URING     7
+
 /**
  * I/O queue implementation backend.
  *
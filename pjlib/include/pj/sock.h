@@ -1493,6 +1493,83 @@ PJ_DECL(pj_status_t) pj_sock_sendto(pj_sock_t sockfd,
                                     const pj_sockaddr_t *to,
                                     int tolen);
 
+/**
+ * This structure describes one datagram in a batched socket operation
+ * such as #pj_sock_recvmmsg() and #pj_sock_sendmmsg().
+ */
+typedef struct pj_sock_mmsg
+{
+    /**
+     * The buffer to receive the datagram into, or the datagram to send.
+     */
+    void            *buf;
+
+    /**
+     * On input, the size of the buffer (when receiving) or the length of
+     * the datagram (when sending). Upon return, the length of the datagram
+     * received or sent.
+     */
+    pj_ssize_t       len;
+
+    /**
+     * When receiving, optional buffer to receive the source address of
+     * the datagram. When sending, the destination address, or NULL for
+     * connected socket.
+     */
+    pj_sockaddr_t   *addr;
+
+    /**
+     * When receiving, on input the size of the address buffer, and upon
+     * return the actual length of the address. When sending, the length
+     * of the destination address.
+     */
+    int              addr_len;
+
+} pj_sock_mmsg;
+
+/**
+ * Receive multiple datagrams from the socket with a single call. On
+ * platforms that support it (see #PJ_HAS_RECVMMSG), this is implemented
+ * with recvmmsg(), so only one system call is needed to receive the whole
+ * batch. On other platforms, this is emulated by calling
+ * #pj_sock_recvfrom() repeatedly until no more datagram is available.
+ *
+ * Application normally uses this on a non-blocking socket, where the
+ * function returns as soon as there is no more datagram to read.
+ *
+ * @param sockfd        The socket descriptor.
+ * @param msgs          Array of datagram descriptors.
+ * @param count         On input, the number of elements in \a msgs. Upon
+ *                      return, the number of datagrams received.
+ * @param flags         Flags (such as pj_MSG_PEEK()).
+ *
+ * @return              PJ_SUCCESS if at least one datagram has been
+ *                      received, or the error code of the failed receive.
+ */
+PJ_DECL(pj_status_t) pj_sock_recvmmsg(pj_sock_t sockfd,
+                                      pj_sock_mmsg msgs[],
+                                      unsigned *count,
+                                      unsigned flags);
+
+/**
+ * Transmit multiple datagrams with a single call. On platforms that
+ * support it (see #PJ_HAS_SENDMMSG), this is implemented with sendmmsg(),
+ * otherwise it is emulated by calling #pj_sock_sendto() for each datagram.
+ *
+ * @param sockfd        Socket descriptor.
+ * @param msgs          Array of datagram descriptors.
+ * @param count         On input, the number of elements in \a msgs. Upon
+ *                      return, the number of datagrams sent.
+ * @param flags         Flags (such as pj_MSG_DONTROUTE()).
+ *
+ * @return              PJ_SUCCESS if at least one datagram has been
+ *                      sent, or the error code of the failed send.
+ */
+PJ_DECL(pj_status_t) pj_sock_sendmmsg(pj_sock_t sockfd,
+                                      pj_sock_mmsg msgs[],
+                                      unsigned *count,
+                                      unsigned flags);
+
 #if PJ_HAS_TCP
 /**
  * The shutdown call causes all or part of a full-duplex connection on the
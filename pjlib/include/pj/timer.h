@@ -25,7 +25,7 @@
 #include <pj/types.h>
 #include <pj/lock.h>
 
-#if PJ_TIMER_USE_LINKED_LIST
+#if PJ_TIMER_USE_LINKED_LIST || PJ_TIMER_USE_WHEEL
 #  include <pj/list.h>
 #endif
 
@@ -50,6 +50,9 @@ PJ_BEGIN_DECL
  *      dynamic memory allocation, which is important for real-time
  *      systems.
  *
+ * Alternatively, when #PJ_TIMER_USE_WHEEL is enabled, the entries are kept
+ * in a hierarchical timing wheel, making scheduling and cancelling O(1).
+ *
  * You can find the fine ACE library at:
  *  http://www.cs.wustl.edu/~schmidt/ACE.html
  *
@@ -91,7 +94,7 @@ typedef void pj_timer_heap_callback(pj_timer_heap_t *timer_heap,
  */
 typedef struct pj_timer_entry
 {
-#if !PJ_TIMER_USE_COPY && PJ_TIMER_USE_LINKED_LIST
+#if !PJ_TIMER_USE_COPY && (PJ_TIMER_USE_LINKED_LIST || PJ_TIMER_USE_WHEEL)
     /**
     * Standard list members.
     */
@@ -207,6 +210,42 @@ PJ_DECL(void) pj_timer_heap_set_lock( pj_timer_heap_t *ht,
 PJ_DECL(unsigned) pj_timer_heap_set_max_timed_out_per_poll(pj_timer_heap_t *ht,
                                                            unsigned count );
 
+/**
+ * Split the timer heap into the specified number of sub-heaps, each with
+ * its own lock, to be polled by different threads. This is intended for
+ * applications polling the timer heap from several worker threads, to
+ * avoid contention on a single timer heap lock and to keep related timers
+ * on the same thread.
+ *
+ * Once split, an entry scheduled with a group lock is put in the sub-heap
+ * selected by its group lock, so all entries sharing a group lock (e.g.
+ * the timers of a dialog and its transactions) are always run by the same
+ * thread. Entries without group lock are spread over the sub-heaps.
+ *
+ * Each thread calling pj_timer_heap_poll() is assigned a sub-heap the
+ * first time it polls, and from then on only polls its own sub-heap, the
+ * sub-heaps which have no thread assigned, and the sub-heaps whose thread
+ * is late polling them (so that an entry doesn't wait when its thread is
+ * busy or stops polling). The delay returned by pj_timer_heap_poll() also
+ * covers the other sub-heaps, so that the polling threads are back in time
+ * to take over a late sub-heap. Since sub-heaps without a thread are
+ * shared, the thread running a group lock's entries is only fixed once all
+ * polling threads have started polling. All other timer heap functions
+ * keep operating on the whole timer heap.
+ *
+ * This function must be called before the timer heap is used by more than
+ * one thread, and can only be called once. Entries which have already been
+ * scheduled stay in the first sub-heap.
+ *
+ * @param ht        The timer heap.
+ * @param count     Number of sub-heaps, normally the number of threads
+ *                  polling the timer heap. The maximum is 127.
+ *
+ * @return          PJ_SUCCESS, or the appropriate error code.
+ */
+PJ_DECL(pj_status_t) pj_timer_heap_set_thread_heaps(pj_timer_heap_t *ht,
+                                                    unsigned count);
+
 /**
  * Initialize a timer entry. Application should call this function at least
  * once before scheduling the entry to the timer heap, to properly initialize
@@ -200,6 +200,149 @@ PJ_INLINE(int) key_has_pending_connect(pj_ioqueue_key_t *key)
 #define IS_CLOSING(key) (key->closing)
 
 
+/*
+ * Invoke the read callback of a finished read operation, which has been
+ * removed from the pending list and has its bytes_read set. The key must
+ * be locked, and it is unlocked by this function.
+ */
+static void ioqueue_complete_read(pj_ioqueue_key_t *h,
+                                  struct read_operation *read_op)
+{
+    pj_bool_t has_lock;
+    void (*on_read_complete)(pj_ioqueue_key_t *key,
+                             pj_ioqueue_op_key_t *op_key,
+                             pj_ssize_t bytes_read);
+
+    on_read_complete = h->cb.on_read_complete;
+
+    /* Unlock; from this point we don't need to hold key's mutex
+     * (unless concurrency is disabled, which in this case we should
+     * hold the mutex while calling the callback) */
+    if (h->allow_concurrent) {
+        /* concurrency may be changed while we're in the callback, so
+         * save it to a flag.
+         */
+        has_lock = PJ_FALSE;
+        pj_ioqueue_unlock_key(h);
+        PJ_RACE_ME(5);
+    } else {
+#if PJ_IOQUEUE_CALLBACK_NO_LOCK
+        /* If we're not allowing concurrency, we must prevent
+         * re-entrancy in the callback.
+         */
+        if (h->read_callback_thread) {
+            /* Another thread is in the read callback for this key,
+             * just queue this read_op, that thread will invoke the
+             * callback later.
+             */
+            pj_list_push_back(&h->read_cb_list, read_op);
+            pj_ioqueue_unlock_key(h);
+            return;
+        }
+
+        /* Save the thread invoking the read callback.
+         * Note that when threading is disabled or concurrency is allowed,
+         * this will always be NULL.
+         */
+        h->read_callback_thread = pj_thread_this();
+
+        /* Do not hold mutex while invoking callback */
+        has_lock = PJ_FALSE;
+        pj_ioqueue_unlock_key(h);
+        PJ_RACE_ME(5);
+#else
+        has_lock = PJ_TRUE;
+#endif
+    }
+
+    /* Call callback. */
+    /* Note that concurrency may be changed while we're in the callback. */
+    if (!IS_CLOSING(h) && on_read_complete) {
+        (*on_read_complete)(h,
+                            (pj_ioqueue_op_key_t*)read_op,
+                            read_op->bytes_read);
+    }
+
+    if (has_lock) {
+        pj_ioqueue_unlock_key(h);
+    }
+
+#if PJ_IOQUEUE_CALLBACK_NO_LOCK
+    /* If we have more pending read callback, process it now */
+    ioqueue_dispatch_read_event_no_lock(h, 0);
+#endif
+}
+
+/*
+ * Invoke the write callback of a finished write operation, which has been
+ * removed from the pending list (for stream sockets) and has its written
+ * field set. The key must be locked, and it is unlocked by this function.
+ */
+static void ioqueue_complete_write(pj_ioqueue_key_t *h,
+                                   struct write_operation *write_op)
+{
+    pj_bool_t has_lock;
+
+    /* Unlock; from this point we don't need to hold key's mutex
+     * (unless concurrency is disabled, which in this case we should
+     * hold the mutex while calling the callback) */
+    if (h->allow_concurrent) {
+        /* concurrency may be changed while we're in the callback, so
+         * save it to a flag.
+         */
+        has_lock = PJ_FALSE;
+        pj_ioqueue_unlock_key(h);
+        PJ_RACE_ME(5);
+    } else {
+#if PJ_IOQUEUE_CALLBACK_NO_LOCK
+        /* If we're not allowing concurrency, we must prevent
+         * re-entrancy in the callback.
+         */
+        if (h->write_callback_thread) {
+            /* Another thread is in the write callback for this key,
+             * just queue this write_op, that thread will invoke the
+             * callback later.
+             */
+            pj_list_push_back(&h->write_cb_list, write_op);
+            pj_ioqueue_unlock_key(h);
+            return;
+        }
+
+        /* Save the thread invoking the write callback.
+         * Note that when threading is disabled or concurrency is allowed,
+         * this will always be NULL.
+         */
+        h->write_callback_thread = pj_thread_this();
+
+        /* Do not hold mutex while invoking callback */
+        has_lock = PJ_FALSE;
+        pj_ioqueue_unlock_key(h);
+        PJ_RACE_ME(5);
+#else
+        has_lock = PJ_TRUE;
+#endif
+    }
+
+    /* Call callback. Do not skip when IS_CLOSING, as upper
+     * layers need the callback to release resources (e.g.,
+     * pjsip_tx_data_dec_ref). See #4878.
+     */
+    if (h->cb.on_write_complete) {
+        (*h->cb.on_write_complete)(h,
+                                   (pj_ioqueue_op_key_t*)write_op,
+                                   write_op->written);
+    }
+
+    if (has_lock) {
+        pj_ioqueue_unlock_key(h);
+    }
+
+#if PJ_IOQUEUE_CALLBACK_NO_LOCK
+    /* If we have more pending write callback, process it now */
+    ioqueue_dispatch_write_event_no_lock(h, 0);
+#endif
+}
+
 /*
  * ioqueue_dispatch_event()
  *
@@ -389,8 +532,6 @@ static pj_bool_t ioqueue_dispatch_write_event( pj_ioqueue_t *ioqueue,
             write_op->written == (pj_ssize_t)write_op->size ||
             h->fd_type == pj_SOCK_DGRAM()) 
         {
-            pj_bool_t has_lock;
-
             write_op->op = PJ_IOQUEUE_OP_NONE;
 
             if (h->fd_type != pj_SOCK_DGRAM()) {
@@ -403,64 +544,7 @@ static pj_bool_t ioqueue_dispatch_write_event( pj_ioqueue_t *ioqueue,
 
             }
 
-            /* Unlock; from this point we don't need to hold key's mutex
-             * (unless concurrency is disabled, which in this case we should
-             * hold the mutex while calling the callback) */
-            if (h->allow_concurrent) {
-                /* concurrency may be changed while we're in the callback, so
-                 * save it to a flag.
-                 */
-                has_lock = PJ_FALSE;
-                pj_ioqueue_unlock_key(h);
-                PJ_RACE_ME(5);
-            } else {
-#if PJ_IOQUEUE_CALLBACK_NO_LOCK
-                /* If we're not allowing concurrency, we must prevent
-                 * re-entrancy in the callback.
-                 */
-                if (h->write_callback_thread) {
-                    /* Another thread is in the write callback for this key,
-                     * just queue this write_op, that thread will invoke the
-                     * callback later.
-                     */
-                    pj_list_push_back(&h->write_cb_list, write_op);
-                    pj_ioqueue_unlock_key(h);
-                    return PJ_TRUE;
-                }
-
-                /* Save the thread invoking the write callback.
-                 * Note that when threading is disabled or concurrency is allowed,
-                 * this will always be NULL.
-                 */
-                h->write_callback_thread = pj_thread_this();
-
-                /* Do not hold mutex while invoking callback */
-                has_lock = PJ_FALSE;
-                pj_ioqueue_unlock_key(h);
-                PJ_RACE_ME(5);
-#else
-                has_lock = PJ_TRUE;
-#endif
-            }
-
-            /* Call callback. Do not skip when IS_CLOSING, as upper
-             * layers need the callback to release resources (e.g.,
-             * pjsip_tx_data_dec_ref). See #4878.
-             */
-            if (h->cb.on_write_complete) {
-                (*h->cb.on_write_complete)(h,
-                                           (pj_ioqueue_op_key_t*)write_op,
-                                           write_op->written);
-            }
-
-            if (has_lock) {
-                pj_ioqueue_unlock_key(h);
-            }
-
-#if PJ_IOQUEUE_CALLBACK_NO_LOCK
-            /* If we have more pending write callback, process it now */
-            ioqueue_dispatch_write_event_no_lock(h, 0);
-#endif
+            ioqueue_complete_write(h, write_op);
 
         } else {
             pj_ioqueue_unlock_key(h);
@@ -742,10 +826,6 @@ static pj_bool_t ioqueue_dispatch_read_event( pj_ioqueue_t *ioqueue,
     if (key_has_pending_read(h)) {
         struct read_operation *read_op;
         pj_ssize_t bytes_read;
-        pj_bool_t has_lock;
-        void (*on_read_complete)(pj_ioqueue_key_t *key,
-                                 pj_ioqueue_op_key_t *op_key,
-                                 pj_ssize_t bytes_read);
 
         /* Get one pending read operation from the list. */
         read_op = h->read_list.next;
@@ -833,64 +913,7 @@ static pj_bool_t ioqueue_dispatch_read_event( pj_ioqueue_t *ioqueue,
         }
 
         read_op->bytes_read = bytes_read;
-        on_read_complete = h->cb.on_read_complete;
-
-        /* Unlock; from this point we don't need to hold key's mutex
-         * (unless concurrency is disabled, which in this case we should
-         * hold the mutex while calling the callback) */
-        if (h->allow_concurrent) {
-            /* concurrency may be changed while we're in the callback, so
-             * save it to a flag.
-             */
-            has_lock = PJ_FALSE;
-            pj_ioqueue_unlock_key(h);
-            PJ_RACE_ME(5);
-        } else {
-#if PJ_IOQUEUE_CALLBACK_NO_LOCK
-            /* If we're not allowing concurrency, we must prevent
-             * re-entrancy in the callback.
-             */
-            if (h->read_callback_thread) {
-                /* Another thread is in the read callback for this key,
-                 * just queue this read_op, that thread will invoke the
-                 * callback later.
-                 */
-                pj_list_push_back(&h->read_cb_list, read_op);
-                pj_ioqueue_unlock_key(h);
-                return PJ_TRUE;
-            }
-
-            /* Save the thread invoking the read callback.
-             * Note that when threading is disabled or concurrency is allowed,
-             * this will always be NULL.
-             */
-            h->read_callback_thread = pj_thread_this();
-
-            /* Do not hold mutex while invoking callback */
-            has_lock = PJ_FALSE;
-            pj_ioqueue_unlock_key(h);
-            PJ_RACE_ME(5);
-#else
-            has_lock = PJ_TRUE;
-#endif
-        }
-
-        /* Call callback. */
-        /* Note that concurrency may be changed while we're in the callback. */
-        if (!IS_CLOSING(h) && on_read_complete) {
-            (*on_read_complete)(h,
-                                (pj_ioqueue_op_key_t*)read_op,
-                                read_op->bytes_read);
-        }
-
-        if (has_lock) {
-            pj_ioqueue_unlock_key(h);
-        }
-
-#if PJ_IOQUEUE_CALLBACK_NO_LOCK
-        /* If we have more pending read callback, process it now */
-        ioqueue_dispatch_read_event_no_lock(h, 0);
-#endif
+        ioqueue_complete_read(h, read_op);
 
     } else {
         /*
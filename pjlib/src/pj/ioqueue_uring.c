@@ -0,0 +1,1589 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+/*
+ * ioqueue_uring.c
+ *
+ * This is the implementation of IOQueue framework using Linux io_uring.
+ *
+ * Receive and send operations are completion based: the operation that
+ * is queued when the socket is not ready is submitted to the ring as an
+ * IORING_OP_RECVMSG or IORING_OP_SENDMSG request on the application's
+ * buffer, and its callback is called when the request completes. There
+ * is at most one such request in flight per key and direction, the next
+ * pending operation is submitted before the callback of the previous one
+ * is called. Accept and connect, as well as everything when safe
+ * unregistration is disabled, use one-shot IORING_OP_POLL_ADD readiness
+ * notification and the common ioqueue abstraction (ioqueue_common_abs.c)
+ * to do the socket operation, like the epoll backend.
+ *
+ * The application's buffer is used directly, so registered buffers and
+ * multishot receive with provided buffers are not used: the pj_ioqueue
+ * API hands over a buffer with every operation, and receiving into
+ * kernel selected buffers would need an extra copy, as well as storage
+ * for datagrams arriving while no read operation is pending.
+ *
+ * Submissions are queued in the shared submission ring and are submitted
+ * together with the next wait, so the steady state needs a single system
+ * call per poll iteration, and a completion is delivered to exactly one
+ * polling thread.
+ *
+ * The rings are driven with the raw system calls, so liburing is not
+ * required. Linux 5.11 or later (IORING_FEAT_EXT_ARG) is needed.
+ */
+
+#include <pj/ioqueue.h>
+#include <pj/os.h>
+#include <pj/lock.h>
+#include <pj/log.h>
+#include <pj/list.h>
+#include <pj/pool.h>
+#include <pj/string.h>
+#include <pj/assert.h>
+#include <pj/errno.h>
+#include <pj/sock.h>
+#include <pj/compat/socket.h>
+
+
+/* Only build when the backend is using io_uring. */
+#if PJ_IOQUEUE_IMP == PJ_IOQUEUE_IMP_IO_URING
+
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include <errno.h>
+#include <unistd.h>
+
+#define ioctl_val_type          unsigned long
+#define os_ioctl                ioctl
+#define os_close                close
+
+
+#define THIS_FILE   "ioq_uring"
+
+//#define TRACE_(expr) PJ_LOG(3,expr)
+#define TRACE_(expr)
+
+/* Enable this during development to warn against stray events.
+ * But don't enable this during production, for performance reason.
+ */
+//#define TRACE_WARN(expr)      PJ_LOG(2,expr)
+#define TRACE_WARN(expr)
+
+
+/* Bounds of the submission ring size. Each key needs at most two
+ * requests in flight at any time, the completion ring is sized accordingly
+ * and the kernel buffers any overflow (IORING_FEAT_NODROP).
+ */
+#define MIN_SQ_ENTRIES          64
+#define MAX_SQ_ENTRIES          4096
+
+/* The type of a request is encoded in the lowest two bits of the
+ * request's user_data, the rest is the key pointer. Requests that we are
+ * not interested in the completion of (i.e. poll removal and cancellation)
+ * use zero user_data.
+ */
+#define POLL_RD                 0
+#define POLL_WR                 1
+#define OP_RECV                 2
+#define OP_SEND                 3
+#define REQ_TYPE_MASK           3
+#define ARMED_RD                (1 << POLL_RD)
+#define ARMED_WR                (1 << POLL_WR)
+
+/* Receive and send operations are submitted to the ring only with safe
+ * unregistration, which keeps the key valid until the completion of the
+ * request has been reaped.
+ */
+#define HAS_COMPLETION_IO       PJ_IOQUEUE_HAS_SAFE_UNREG
+
+#define LOAD_ACQUIRE(p)         __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(p, v)     __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+
+/*
+ * Include common ioqueue abstraction.
+ */
+#include "ioqueue_common_abs.h"
+
+/*
+ * This describes each key.
+ */
+struct pj_ioqueue_key_t
+{
+    DECLARE_COMMON_KEY
+
+    /* Both fields below are protected by the ioqueue's ring_lock. */
+    unsigned            events;     /* Interest, ioqueue_event_type bits. */
+    unsigned            armed;      /* Armed poll requests, ARMED_xx bits.*/
+
+#if HAS_COMPLETION_IO
+    /* Receive and send requests in flight, protected by the key's lock.
+     * The operation is set to NULL when it is cancelled while its request
+     * is still in flight.
+     */
+    pj_bool_t               recv_busy;
+    struct read_operation  *recv_op;
+    struct msghdr           recv_msg;
+    struct iovec            recv_iov;
+
+    pj_bool_t               send_busy;
+    struct write_operation *send_op;
+    struct msghdr           send_msg;
+    struct iovec            send_iov;
+#endif
+};
+
+struct queue
+{
+    pj_ioqueue_key_t        *key;
+    enum ioqueue_event_type  event_type;
+};
+
+/*
+ * This describes the I/O queue.
+ */
+struct pj_ioqueue_t
+{
+    DECLARE_COMMON_IOQUEUE
+
+    unsigned            max, count;
+    pj_ioqueue_key_t    active_list;
+    int                 ring_fd;
+
+    /* Protects the rings and the key's events/armed fields. This is a
+     * leaf lock, no other lock is acquired while holding it.
+     */
+    pj_lock_t          *ring_lock;
+    unsigned            waiters;
+
+    /* Submission ring */
+    void               *sq_ring;
+    pj_size_t           sq_ring_sz;
+    unsigned           *sq_khead;
+    unsigned           *sq_ktail;
+    unsigned            sq_mask;
+    unsigned            sq_entries;
+    unsigned            sq_tail;
+    struct io_uring_sqe *sqes;
+    pj_size_t           sqes_sz;
+
+    /* Completion ring */
+    void               *cq_ring;
+    pj_size_t           cq_ring_sz;
+    unsigned           *cq_khead;
+    unsigned           *cq_ktail;
+    unsigned            cq_mask;
+    struct io_uring_cqe *cqes;
+
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+    pj_mutex_t         *ref_cnt_mutex;
+    pj_ioqueue_key_t    closing_list;
+    pj_ioqueue_key_t    free_list;
+#endif
+};
+
+/* Include implementation for common abstraction after we declare
+ * pj_ioqueue_key_t and pj_ioqueue_t.
+ */
+#include "ioqueue_common_abs.c"
+
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+/* Scan closing keys to be put to free list again */
+static void scan_closing_keys(pj_ioqueue_t *ioqueue);
+#endif
+
+#if HAS_COMPLETION_IO
+/* Release the references held by a receive or send request */
+static void release_key(pj_ioqueue_key_t *key);
+#endif
+
+
+static int os_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int os_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                          unsigned flags, void *arg, pj_size_t argsz)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                        flags, arg, argsz);
+}
+
+/* Number of queued submissions not yet consumed by the kernel.
+ * Must be called with ring_lock held.
+ */
+static unsigned sq_unsubmitted(pj_ioqueue_t *ioqueue)
+{
+    return ioqueue->sq_tail - LOAD_ACQUIRE(ioqueue->sq_khead);
+}
+
+/* Submit queued requests without waiting. Must be called with ring_lock
+ * held.
+ */
+static void sq_flush(pj_ioqueue_t *ioqueue)
+{
+    unsigned to_submit = sq_unsubmitted(ioqueue);
+
+    while (to_submit) {
+        int rc = os_uring_enter(ioqueue->ring_fd, to_submit, 0, 0, NULL, 0);
+        if (rc < 0) {
+            if (errno == EINTR)
+                continue;
+            PJ_PERROR(1,(THIS_FILE, pj_get_os_error(),
+                         "io_uring_enter() submit error"));
+            break;
+        }
+        to_submit = sq_unsubmitted(ioqueue);
+        if (rc == 0)
+            break;
+    }
+}
+
+/* Get a free submission entry. Must be called with ring_lock held. */
+static struct io_uring_sqe *sq_get(pj_ioqueue_t *ioqueue)
+{
+    struct io_uring_sqe *sqe;
+
+    if (sq_unsubmitted(ioqueue) >= ioqueue->sq_entries) {
+        sq_flush(ioqueue);
+        if (sq_unsubmitted(ioqueue) >= ioqueue->sq_entries)
+            return NULL;
+    }
+
+    sqe = &ioqueue->sqes[ioqueue->sq_tail & ioqueue->sq_mask];
+    pj_bzero(sqe, sizeof(*sqe));
+    return sqe;
+}
+
+/* Make the queued entry visible to the kernel. */
+static void sq_commit(pj_ioqueue_t *ioqueue)
+{
+    ++ioqueue->sq_tail;
+    STORE_RELEASE(ioqueue->sq_ktail, ioqueue->sq_tail);
+}
+
+/* Queue a one-shot poll request for the specified direction.
+ * Must be called with ring_lock held.
+ */
+static void arm_poll(pj_ioqueue_t *ioqueue, pj_ioqueue_key_t *key, int dir)
+{
+    struct io_uring_sqe *sqe = sq_get(ioqueue);
+
+    if (!sqe) {
+        PJ_LOG(1,(THIS_FILE, "io_uring submission queue is full"));
+        return;
+    }
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = key->fd;
+    sqe->poll32_events = (dir == POLL_RD) ? POLLIN : POLLOUT;
+    sqe->user_data = (pj_uint64_t)(pj_size_t)key | dir;
+    sq_commit(ioqueue);
+
+    key->armed |= (1 << dir);
+}
+
+/* Queue removal of the armed poll request for the specified direction.
+ * Must be called with ring_lock held.
+ */
+static void disarm_poll(pj_ioqueue_t *ioqueue, pj_ioqueue_key_t *key,
+                        int dir)
+{
+    struct io_uring_sqe *sqe = sq_get(ioqueue);
+
+    key->armed &= ~(1 << dir);
+    if (!sqe) {
+        PJ_LOG(1,(THIS_FILE, "io_uring submission queue is full"));
+        return;
+    }
+
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = (pj_uint64_t)(pj_size_t)key | dir;
+    sqe->user_data = 0;
+    sq_commit(ioqueue);
+}
+
+/* Arm poll requests for every direction the key is interested in but
+ * not yet armed. Must be called with ring_lock held.
+ */
+static void update_poll_set(pj_ioqueue_t *ioqueue, pj_ioqueue_key_t *key)
+{
+    if ((key->events & READABLE_EVENT) && !(key->armed & ARMED_RD))
+        arm_poll(ioqueue, key, POLL_RD);
+
+    if ((key->events & (WRITEABLE_EVENT | EXCEPTION_EVENT)) &&
+        !(key->armed & ARMED_WR))
+    {
+        arm_poll(ioqueue, key, POLL_WR);
+    }
+}
+
+
+/*
+ * pj_ioqueue_name()
+ */
+PJ_DEF(const char*) pj_ioqueue_name(void)
+{
+    return "io_uring";
+}
+
+static void unmap_rings(pj_ioqueue_t *ioqueue)
+{
+    if (ioqueue->sqes) {
+        munmap(ioqueue->sqes, ioqueue->sqes_sz);
+        ioqueue->sqes = NULL;
+    }
+    if (ioqueue->cq_ring && ioqueue->cq_ring != ioqueue->sq_ring)
+        munmap(ioqueue->cq_ring, ioqueue->cq_ring_sz);
+    ioqueue->cq_ring = NULL;
+    if (ioqueue->sq_ring) {
+        munmap(ioqueue->sq_ring, ioqueue->sq_ring_sz);
+        ioqueue->sq_ring = NULL;
+    }
+}
+
+/* Create the ring and map the submission and completion queues. */
+static pj_status_t create_ring(pj_ioqueue_t *ioqueue, pj_size_t max_fd)
+{
+    struct io_uring_params p;
+    unsigned entries = MIN_SQ_ENTRIES;
+    unsigned *sq_array, i;
+    char *ptr;
+    pj_status_t status;
+
+    while (entries < max_fd * 2 && entries < MAX_SQ_ENTRIES)
+        entries <<= 1;
+
+    pj_bzero(&p, sizeof(p));
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = entries * 2;
+
+    ioqueue->ring_fd = os_uring_setup(entries, &p);
+    if (ioqueue->ring_fd < 0)
+        return PJ_RETURN_OS_ERROR(pj_get_native_os_error());
+
+    if ((p.features & IORING_FEAT_EXT_ARG) == 0 ||
+        (p.features & IORING_FEAT_NODROP) == 0)
+    {
+        PJ_LOG(2,(THIS_FILE, "io_uring on this kernel lacks the required "
+                             "features (0x%x)", p.features));
+        status = PJ_ENOTSUP;
+        goto on_error;
+    }
+
+    ioqueue->sq_ring_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ioqueue->cq_ring_sz = p.cq_off.cqes +
+                          p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ioqueue->cq_ring_sz > ioqueue->sq_ring_sz)
+            ioqueue->sq_ring_sz = ioqueue->cq_ring_sz;
+        ioqueue->cq_ring_sz = ioqueue->sq_ring_sz;
+    }
+
+    ioqueue->sq_ring = mmap(NULL, ioqueue->sq_ring_sz,
+                            PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE,
+                            ioqueue->ring_fd, IORING_OFF_SQ_RING);
+    if (ioqueue->sq_ring == MAP_FAILED) {
+        ioqueue->sq_ring = NULL;
+        status = PJ_RETURN_OS_ERROR(pj_get_native_os_error());
+        goto on_error;
+    }
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        ioqueue->cq_ring = ioqueue->sq_ring;
+    } else {
+        ioqueue->cq_ring = mmap(NULL, ioqueue->cq_ring_sz,
+                                PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_POPULATE,
+                                ioqueue->ring_fd, IORING_OFF_CQ_RING);
+        if (ioqueue->cq_ring == MAP_FAILED) {
+            ioqueue->cq_ring = NULL;
+            status = PJ_RETURN_OS_ERROR(pj_get_native_os_error());
+            goto on_error;
+        }
+    }
+
+    ioqueue->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+    ioqueue->sqes = (struct io_uring_sqe*)
+                    mmap(NULL, ioqueue->sqes_sz, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ioqueue->ring_fd,
+                         IORING_OFF_SQES);
+    if (ioqueue->sqes == MAP_FAILED) {
+        ioqueue->sqes = NULL;
+        status = PJ_RETURN_OS_ERROR(pj_get_native_os_error());
+        goto on_error;
+    }
+
+    ptr = (char*)ioqueue->sq_ring;
+    ioqueue->sq_khead = (unsigned*)(ptr + p.sq_off.head);
+    ioqueue->sq_ktail = (unsigned*)(ptr + p.sq_off.tail);
+    ioqueue->sq_mask = *(unsigned*)(ptr + p.sq_off.ring_mask);
+    ioqueue->sq_entries = p.sq_entries;
+    ioqueue->sq_tail = *ioqueue->sq_ktail;
+
+    /* Submission entries are always used in ring order, so the index
+     * array is set up once as identity mapping.
+     */
+    sq_array = (unsigned*)(ptr + p.sq_off.array);
+    for (i=0; i<p.sq_entries; ++i)
+        sq_array[i] = i;
+
+    ptr = (char*)ioqueue->cq_ring;
+    ioqueue->cq_khead = (unsigned*)(ptr + p.cq_off.head);
+    ioqueue->cq_ktail = (unsigned*)(ptr + p.cq_off.tail);
+    ioqueue->cq_mask = *(unsigned*)(ptr + p.cq_off.ring_mask);
+    ioqueue->cqes = (struct io_uring_cqe*)(ptr + p.cq_off.cqes);
+
+    return PJ_SUCCESS;
+
+on_error:
+    unmap_rings(ioqueue);
+    os_close(ioqueue->ring_fd);
+    ioqueue->ring_fd = -1;
+    return status;
+}
+
+/*
+ * pj_ioqueue_create()
+ *
+ * Create io_uring ioqueue.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_create( pj_pool_t *pool,
+                                       pj_size_t max_fd,
+                                       pj_ioqueue_t **p_ioqueue)
+{
+    return pj_ioqueue_create2(pool, max_fd, NULL, p_ioqueue);
+}
+
+/*
+ * pj_ioqueue_create2()
+ *
+ * Create io_uring ioqueue.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_create2(pj_pool_t *pool,
+                                       pj_size_t max_fd,
+                                       const pj_ioqueue_cfg *cfg,
+                                       pj_ioqueue_t **p_ioqueue)
+{
+    pj_ioqueue_t *ioqueue;
+    pj_status_t rc;
+    pj_lock_t *lock;
+    pj_size_t i;
+
+    /* Check that arguments are valid. */
+    PJ_ASSERT_RETURN(pool != NULL && p_ioqueue != NULL &&
+                     max_fd > 0, PJ_EINVAL);
+
+    /* Check that size of pj_ioqueue_op_key_t is sufficient */
+    PJ_ASSERT_RETURN(sizeof(pj_ioqueue_op_key_t)-sizeof(void*) >=
+                     sizeof(union operation_key), PJ_EBUG);
+
+    ioqueue = PJ_POOL_ZALLOC_T(pool, pj_ioqueue_t);
+
+    ioqueue_init(ioqueue);
+
+    if (cfg)
+        pj_memcpy(&ioqueue->cfg, cfg, sizeof(*cfg));
+    else
+        pj_ioqueue_cfg_default(&ioqueue->cfg);
+    ioqueue->max = (unsigned)max_fd;
+    ioqueue->count = 0;
+    ioqueue->ring_fd = -1;
+    pj_list_init(&ioqueue->active_list);
+
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+    /* When safe unregistration is used (the default), we pre-create
+     * all keys and put them in the free list.
+     */
+
+    /* Mutex to protect key's reference counter
+     * We don't want to use key's mutex or ioqueue's mutex because
+     * that would create deadlock situation in some cases.
+     */
+    rc = pj_mutex_create_simple(pool, NULL, &ioqueue->ref_cnt_mutex);
+    if (rc != PJ_SUCCESS)
+        return rc;
+
+
+    /* Init key list */
+    pj_list_init(&ioqueue->free_list);
+    pj_list_init(&ioqueue->closing_list);
+
+
+    /* Pre-create all keys according to max_fd */
+    for ( i=0; i<max_fd; ++i) {
+        pj_ioqueue_key_t *key;
+
+        key = PJ_POOL_ALLOC_T(pool, pj_ioqueue_key_t);
+        key->ref_count = 0;
+        rc = pj_lock_create_recursive_mutex(pool, NULL, &key->lock);
+        if (rc != PJ_SUCCESS) {
+            key = ioqueue->free_list.next;
+            while (key != &ioqueue->free_list) {
+                pj_lock_destroy(key->lock);
+                key = key->next;
+            }
+            pj_mutex_destroy(ioqueue->ref_cnt_mutex);
+            return rc;
+        }
+
+        pj_list_push_back(&ioqueue->free_list, key);
+    }
+#else
+    PJ_UNUSED_ARG(i);
+#endif
+
+    rc = pj_lock_create_simple_mutex(pool, "ioq%p", &lock);
+    if (rc != PJ_SUCCESS)
+        return rc;
+
+    rc = pj_ioqueue_set_lock(ioqueue, lock, PJ_TRUE);
+    if (rc != PJ_SUCCESS)
+        return rc;
+
+    rc = pj_lock_create_simple_mutex(pool, "ioqr%p", &ioqueue->ring_lock);
+    if (rc != PJ_SUCCESS) {
+        pj_lock_acquire(ioqueue->lock);
+        ioqueue_destroy(ioqueue);
+        return rc;
+    }
+
+    rc = create_ring(ioqueue, max_fd);
+    if (rc != PJ_SUCCESS) {
+        PJ_PERROR(1,(THIS_FILE, rc, "Error creating io_uring"));
+        pj_lock_destroy(ioqueue->ring_lock);
+        pj_lock_acquire(ioqueue->lock);
+        ioqueue_destroy(ioqueue);
+        return rc;
+    }
+
+    PJ_LOG(4, ("pjlib", "io_uring I/O Queue created (entries:%u, ptr=%p)",
+               ioqueue->sq_entries, ioqueue));
+
+    *p_ioqueue = ioqueue;
+    return PJ_SUCCESS;
+}
+
+/*
+ * pj_ioqueue_destroy()
+ *
+ * Destroy ioqueue.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_destroy(pj_ioqueue_t *ioqueue)
+{
+    pj_ioqueue_key_t *key;
+
+    PJ_ASSERT_RETURN(ioqueue, PJ_EINVAL);
+    PJ_ASSERT_RETURN(ioqueue->ring_fd >= 0, PJ_EINVALIDOP);
+
+#if HAS_COMPLETION_IO
+    /* Release the references held by the receive and send requests whose
+     * completions have not been reaped, e.g. of the keys unregistered just
+     * before the ioqueue is destroyed.
+     */
+    for (;;) {
+        pj_ioqueue_key_t *h = NULL;
+        unsigned head, tail;
+
+        pj_lock_acquire(ioqueue->ring_lock);
+        head = *ioqueue->cq_khead;
+        tail = LOAD_ACQUIRE(ioqueue->cq_ktail);
+        for (; head != tail && !h; ++head) {
+            const struct io_uring_cqe *cqe;
+            int type;
+
+            cqe = &ioqueue->cqes[head & ioqueue->cq_mask];
+            type = (int)(cqe->user_data & REQ_TYPE_MASK);
+            if (cqe->user_data && (type == OP_RECV || type == OP_SEND)) {
+                h = (pj_ioqueue_key_t*)(pj_size_t)
+                    (cqe->user_data & ~(pj_uint64_t)REQ_TYPE_MASK);
+            }
+        }
+        STORE_RELEASE(ioqueue->cq_khead, head);
+        pj_lock_release(ioqueue->ring_lock);
+
+        if (!h)
+            break;
+        release_key(h);
+    }
+#endif
+
+    pj_lock_acquire(ioqueue->lock);
+    unmap_rings(ioqueue);
+    os_close(ioqueue->ring_fd);
+    ioqueue->ring_fd = -1;
+    pj_lock_destroy(ioqueue->ring_lock);
+
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+    /* Destroy reference counters */
+    key = ioqueue->active_list.next;
+    while (key != &ioqueue->active_list) {
+        pj_lock_destroy(key->lock);
+        key = key->next;
+    }
+
+    key = ioqueue->closing_list.next;
+    while (key != &ioqueue->closing_list) {
+        pj_lock_destroy(key->lock);
+        key = key->next;
+    }
+
+    key = ioqueue->free_list.next;
+    while (key != &ioqueue->free_list) {
+        pj_lock_destroy(key->lock);
+        key = key->next;
+    }
+
+    pj_mutex_destroy(ioqueue->ref_cnt_mutex);
+#else
+    PJ_UNUSED_ARG(key);
+#endif
+    return ioqueue_destroy(ioqueue);
+}
+
+/*
+ * pj_ioqueue_register_sock()
+ *
+ * Register a socket to ioqueue.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_register_sock2(pj_pool_t *pool,
+                                              pj_ioqueue_t *ioqueue,
+                                              pj_sock_t sock,
+                                              pj_grp_lock_t *grp_lock,
+                                              void *user_data,
+                                              const pj_ioqueue_callback *cb,
+                                              pj_ioqueue_key_t **p_key)
+{
+    pj_ioqueue_key_t *key = NULL;
+    pj_uint32_t value;
+    int rc;
+    pj_status_t status = PJ_SUCCESS;
+
+    PJ_ASSERT_RETURN(pool && ioqueue && sock != PJ_INVALID_SOCKET &&
+                     cb && p_key, PJ_EINVAL);
+
+    pj_lock_acquire(ioqueue->lock);
+
+    if (ioqueue->count >= ioqueue->max) {
+        status = PJ_ETOOMANY;
+        TRACE_((THIS_FILE, "pj_ioqueue_register_sock error: too many files"));
+        goto on_return;
+    }
+
+    /* Set socket to nonblocking. */
+    value = 1;
+    if ((rc=os_ioctl(sock, FIONBIO, (ioctl_val_type)&value))) {
+        TRACE_((THIS_FILE, "pj_ioqueue_register_sock error: ioctl rc=%d",
+                rc));
+        status = pj_get_netos_error();
+        goto on_return;
+    }
+
+    /* If safe unregistration (PJ_IOQUEUE_HAS_SAFE_UNREG) is used, get
+     * the key from the free list. Otherwise allocate a new one.
+     */
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+
+    /* Scan closing_keys first to let them come back to free_list */
+    scan_closing_keys(ioqueue);
+
+    pj_assert(!pj_list_empty(&ioqueue->free_list));
+    if (pj_list_empty(&ioqueue->free_list)) {
+        status = PJ_ETOOMANY;
+        goto on_return;
+    }
+
+    key = ioqueue->free_list.next;
+    pj_list_erase(key);
+#else
+    /* Create key. */
+    key = (pj_ioqueue_key_t*)pj_pool_zalloc(pool, sizeof(pj_ioqueue_key_t));
+#endif
+
+    status = ioqueue_init_key(pool, ioqueue, key, sock, grp_lock, user_data, cb);
+    if (status != PJ_SUCCESS) {
+        key = NULL;
+        goto on_return;
+    }
+
+    /* No poll request is armed until an operation is pending. */
+    pj_lock_acquire(ioqueue->ring_lock);
+    key->events = 0;
+    key->armed = 0;
+    pj_lock_release(ioqueue->ring_lock);
+#if HAS_COMPLETION_IO
+    key->recv_busy = key->send_busy = PJ_FALSE;
+    key->recv_op = NULL;
+    key->send_op = NULL;
+#endif
+
+    /* Register */
+    pj_list_insert_before(&ioqueue->active_list, key);
+    ++ioqueue->count;
+
+on_return:
+    if (status != PJ_SUCCESS) {
+        if (key && key->grp_lock)
+            pj_grp_lock_dec_ref_dbg(key->grp_lock, "ioqueue", 0);
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+        if (key) {
+            /* Return the pre-created key to the free list, see the
+             * equivalent code in ioqueue_epoll.c.
+             */
+            key->grp_lock = NULL;
+            key->ref_count = 0;
+            pj_list_push_back(&ioqueue->free_list, key);
+            key = NULL;
+        }
+#endif
+    }
+    *p_key = key;
+    pj_lock_release(ioqueue->lock);
+
+    return status;
+}
+
+PJ_DEF(pj_status_t) pj_ioqueue_register_sock( pj_pool_t *pool,
+                                              pj_ioqueue_t *ioqueue,
+                                              pj_sock_t sock,
+                                              void *user_data,
+                                              const pj_ioqueue_callback *cb,
+                                              pj_ioqueue_key_t **p_key)
+{
+    return pj_ioqueue_register_sock2(pool, ioqueue, sock, NULL, user_data,
+                                     cb, p_key);
+}
+
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+/* Increment key's reference counter */
+static void increment_counter(pj_ioqueue_key_t *key)
+{
+    pj_mutex_lock(key->ioqueue->ref_cnt_mutex);
+    ++key->ref_count;
+    pj_mutex_unlock(key->ioqueue->ref_cnt_mutex);
+}
+
+/* Decrement the key's reference counter, and when the counter reach zero,
+ * destroy the key.
+ *
+ * Note: MUST NOT CALL THIS FUNCTION WHILE HOLDING ioqueue's LOCK.
+ */
+static void decrement_counter(pj_ioqueue_key_t *key)
+{
+    pj_lock_acquire(key->ioqueue->lock);
+    pj_mutex_lock(key->ioqueue->ref_cnt_mutex);
+    --key->ref_count;
+    if (key->ref_count == 0) {
+
+        pj_assert(key->closing == 1);
+        pj_gettickcount(&key->free_time);
+        key->free_time.msec += PJ_IOQUEUE_KEY_FREE_DELAY;
+        pj_time_val_normalize(&key->free_time);
+
+        pj_list_erase(key);
+        pj_list_push_back(&key->ioqueue->closing_list, key);
+
+    }
+    pj_mutex_unlock(key->ioqueue->ref_cnt_mutex);
+    pj_lock_release(key->ioqueue->lock);
+}
+#endif
+
+#if HAS_COMPLETION_IO
+/* Keep the key, and the group lock which usually owns the operation's
+ * buffer, while a request for the key is in flight.
+ */
+static void hold_key(pj_ioqueue_key_t *key)
+{
+    increment_counter(key);
+    if (key->grp_lock)
+        pj_grp_lock_add_ref_dbg(key->grp_lock, "ioqueue", 0);
+}
+
+/* Release the references taken by hold_key(). Must not be called while
+ * holding any lock.
+ */
+static void release_key(pj_ioqueue_key_t *key)
+{
+    pj_grp_lock_t *grp_lock = key->grp_lock;
+
+    decrement_counter(key);
+    if (grp_lock)
+        pj_grp_lock_dec_ref_dbg(grp_lock, "ioqueue", 0);
+}
+
+/* Queue a request of the specified type for the key. Must be called with
+ * ring_lock held.
+ */
+static pj_bool_t submit_msg_request(pj_ioqueue_t *ioqueue,
+                                    pj_ioqueue_key_t *key,
+                                    int type, struct msghdr *msg,
+                                    unsigned flags)
+{
+    struct io_uring_sqe *sqe = sq_get(ioqueue);
+
+    if (!sqe) {
+        PJ_LOG(1,(THIS_FILE, "io_uring submission queue is full"));
+        return PJ_FALSE;
+    }
+
+    sqe->opcode = (type == OP_RECV) ? IORING_OP_RECVMSG : IORING_OP_SENDMSG;
+    sqe->fd = key->fd;
+    sqe->addr = (pj_uint64_t)(pj_size_t)msg;
+    sqe->len = 1;
+    /* The ring waits for the socket to become ready by itself */
+    sqe->msg_flags = flags & ~MSG_DONTWAIT;
+    sqe->user_data = (pj_uint64_t)(pj_size_t)key | type;
+    sq_commit(ioqueue);
+
+    /* Threads that are already waiting in pj_ioqueue_poll() would not
+     * see the new request, so submit it now.
+     */
+    if (ioqueue->waiters)
+        sq_flush(ioqueue);
+
+    return PJ_TRUE;
+}
+
+/* Queue cancellation of the request of the specified type in flight for
+ * the key. Must be called with ring_lock held.
+ */
+static void cancel_request(pj_ioqueue_t *ioqueue, pj_ioqueue_key_t *key,
+                           int type)
+{
+    struct io_uring_sqe *sqe = sq_get(ioqueue);
+
+    if (!sqe) {
+        PJ_LOG(1,(THIS_FILE, "io_uring submission queue is full"));
+        return;
+    }
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = (pj_uint64_t)(pj_size_t)key | type;
+    sqe->user_data = 0;
+    sq_commit(ioqueue);
+}
+
+/* Submit the first pending read operation of the key to the ring, unless
+ * a receive request is already in flight. Must be called with the key's
+ * lock held.
+ */
+static void start_recv(pj_ioqueue_t *ioqueue, pj_ioqueue_key_t *key)
+{
+    struct read_operation *read_op;
+    pj_bool_t submitted;
+
+    if (key->recv_busy || !key_has_pending_read(key) || IS_CLOSING(key))
+        return;
+
+    read_op = key->read_list.next;
+
+    pj_bzero(&key->recv_msg, sizeof(key->recv_msg));
+    key->recv_iov.iov_base = read_op->buf;
+    key->recv_iov.iov_len = read_op->size;
+    key->recv_msg.msg_iov = &key->recv_iov;
+    key->recv_msg.msg_iovlen = 1;
+    if (read_op->op == PJ_IOQUEUE_OP_RECV_FROM && read_op->rmt_addr) {
+        key->recv_msg.msg_name = read_op->rmt_addr;
+        key->recv_msg.msg_namelen = *read_op->rmt_addrlen;
+    }
+
+    pj_lock_acquire(ioqueue->ring_lock);
+    submitted = submit_msg_request(ioqueue, key, OP_RECV, &key->recv_msg,
+                                   read_op->flags);
+    pj_lock_release(ioqueue->ring_lock);
+
+    if (submitted) {
+        key->recv_busy = PJ_TRUE;
+        key->recv_op = read_op;
+        hold_key(key);
+    }
+}
+
+/* Submit the remaining data of the first pending write operation of the
+ * key to the ring, unless a send request is already in flight. Must be
+ * called with the key's lock held.
+ */
+static void start_send(pj_ioqueue_t *ioqueue, pj_ioqueue_key_t *key)
+{
+    struct write_operation *write_op;
+    pj_bool_t submitted;
+
+    if (key->send_busy || !key_has_pending_write(key) || IS_CLOSING(key))
+        return;
+
+    write_op = key->write_list.next;
+
+    pj_bzero(&key->send_msg, sizeof(key->send_msg));
+    key->send_iov.iov_base = write_op->buf + write_op->written;
+    key->send_iov.iov_len = write_op->size - write_op->written;
+    key->send_msg.msg_iov = &key->send_iov;
+    key->send_msg.msg_iovlen = 1;
+    if (write_op->op == PJ_IOQUEUE_OP_SEND_TO) {
+        key->send_msg.msg_name = &write_op->rmt_addr;
+        key->send_msg.msg_namelen = write_op->rmt_addrlen;
+    }
+
+    pj_lock_acquire(ioqueue->ring_lock);
+    submitted = submit_msg_request(ioqueue, key, OP_SEND, &key->send_msg,
+                                   write_op->flags | MSG_NOSIGNAL);
+    pj_lock_release(ioqueue->ring_lock);
+
+    if (submitted) {
+        key->send_busy = PJ_TRUE;
+        key->send_op = write_op;
+        hold_key(key);
+    }
+}
+
+/* Cancel the requests in flight whose operation is no longer pending, e.g.
+ * after pj_ioqueue_post_completion() or pj_ioqueue_clear_key(). Must be
+ * called with the key's lock and ring_lock held.
+ */
+static void cancel_stale_requests(pj_ioqueue_t *ioqueue,
+                                  pj_ioqueue_key_t *key,
+                                  unsigned event_types)
+{
+    pj_bool_t cancelled = PJ_FALSE;
+
+    if ((event_types & READABLE_EVENT) && key->recv_op &&
+        !pj_list_find_node(&key->read_list, key->recv_op))
+    {
+        key->recv_op = NULL;
+        cancel_request(ioqueue, key, OP_RECV);
+        cancelled = PJ_TRUE;
+    }
+    if ((event_types & WRITEABLE_EVENT) && key->send_op &&
+        !pj_list_find_node(&key->write_list, key->send_op))
+    {
+        key->send_op = NULL;
+        cancel_request(ioqueue, key, OP_SEND);
+        cancelled = PJ_TRUE;
+    }
+
+    /* The application may reuse the buffer as soon as we return */
+    if (cancelled)
+        sq_flush(ioqueue);
+}
+
+/* Handle completion of a receive request. Returns PJ_TRUE if the read
+ * callback has been called.
+ */
+static pj_bool_t complete_recv(pj_ioqueue_t *ioqueue, pj_ioqueue_key_t *h,
+                               int res)
+{
+    struct read_operation *read_op;
+
+    pj_ioqueue_lock_key(h);
+
+    read_op = h->recv_op;
+    h->recv_op = NULL;
+    h->recv_busy = PJ_FALSE;
+
+    /* The operation has been cancelled, continue with the next one */
+    if (IS_CLOSING(h) || !read_op || res == -EAGAIN) {
+        start_recv(ioqueue, h);
+        pj_ioqueue_unlock_key(h);
+        return PJ_FALSE;
+    }
+
+    pj_list_erase(read_op);
+    read_op->op = PJ_IOQUEUE_OP_NONE;
+    if (res >= 0) {
+        read_op->bytes_read = res;
+        if (h->recv_msg.msg_name) {
+            *read_op->rmt_addrlen = h->recv_msg.msg_namelen;
+            PJ_SOCKADDR_RESET_LEN(read_op->rmt_addr);
+        }
+    } else {
+        read_op->bytes_read = -(pj_ssize_t)PJ_STATUS_FROM_OS(-res);
+    }
+
+    /* Have the next operation in flight while the callback is running */
+    start_recv(ioqueue, h);
+
+    ioqueue_complete_read(h, read_op);
+    return PJ_TRUE;
+}
+
+/* Handle completion of a send request. Returns PJ_TRUE if the write
+ * callback has been called.
+ */
+static pj_bool_t complete_send(pj_ioqueue_t *ioqueue, pj_ioqueue_key_t *h,
+                               int res)
+{
+    struct write_operation *write_op;
+
+    pj_ioqueue_lock_key(h);
+
+    write_op = h->send_op;
+    h->send_op = NULL;
+    h->send_busy = PJ_FALSE;
+
+    /* The operation has been cancelled, continue with the next one. When
+     * the key is closing, the callback has been called by the key
+     * unregistration.
+     */
+    if (IS_CLOSING(h) || !write_op || res == -EAGAIN) {
+        start_send(ioqueue, h);
+        pj_ioqueue_unlock_key(h);
+        return PJ_FALSE;
+    }
+
+    if (res >= 0) {
+        write_op->written += res;
+
+        /* Send the rest of the stream */
+        if (h->fd_type != pj_SOCK_DGRAM() && res > 0 &&
+            write_op->written < (pj_ssize_t)write_op->size)
+        {
+            start_send(ioqueue, h);
+            pj_ioqueue_unlock_key(h);
+            return PJ_FALSE;
+        }
+    } else {
+        write_op->written = -(pj_ssize_t)PJ_STATUS_FROM_OS(-res);
+    }
+
+    write_op->op = PJ_IOQUEUE_OP_NONE;
+    pj_list_erase(write_op);
+
+    /* Have the next operation in flight while the callback is running */
+    start_send(ioqueue, h);
+
+    ioqueue_complete_write(h, write_op);
+    return PJ_TRUE;
+}
+#endif  /* HAS_COMPLETION_IO */
+
+/*
+ * pj_ioqueue_unregister()
+ *
+ * Unregister handle from ioqueue.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_unregister( pj_ioqueue_key_t *key)
+{
+    pj_ioqueue_t *ioqueue;
+
+    PJ_ASSERT_RETURN(key != NULL, PJ_EINVAL);
+
+    ioqueue = key->ioqueue;
+
+    /* Lock the key to make sure no callback is simultaneously modifying
+     * the key. We need to lock the key before ioqueue here to prevent
+     * deadlock.
+     */
+    pj_ioqueue_lock_key(key);
+
+    /* Best effort to avoid double key-unregistration */
+    if (IS_CLOSING(key)) {
+        pj_ioqueue_unlock_key(key);
+        return PJ_SUCCESS;
+    }
+
+    /* Also lock ioqueue */
+    pj_lock_acquire(ioqueue->lock);
+
+    /* Avoid "negative" ioqueue count */
+    if (ioqueue->count > 0) {
+        --ioqueue->count;
+    } else {
+        /* If this happens, very likely there is double unregistration
+         * of a key.
+         */
+        pj_assert(!"Bad ioqueue count in key unregistration!");
+        PJ_LOG(1,(THIS_FILE, "Bad ioqueue count in key unregistration!"));
+    }
+
+#if !PJ_IOQUEUE_HAS_SAFE_UNREG
+    pj_list_erase(key);
+#endif
+
+    /* Unlike epoll, closing the socket does not cancel the requests (they
+     * hold a reference to the file), so remove them explicitly and submit
+     * the removal right away. The completions of the receive and send
+     * requests keep a reference to the key until they are reaped.
+     */
+    pj_lock_acquire(ioqueue->ring_lock);
+    key->events = 0;
+    if (key->armed & ARMED_RD)
+        disarm_poll(ioqueue, key, POLL_RD);
+    if (key->armed & ARMED_WR)
+        disarm_poll(ioqueue, key, POLL_WR);
+#if HAS_COMPLETION_IO
+    if (key->recv_busy)
+        cancel_request(ioqueue, key, OP_RECV);
+    if (key->send_busy)
+        cancel_request(ioqueue, key, OP_SEND);
+#endif
+    sq_flush(ioqueue);
+    pj_lock_release(ioqueue->ring_lock);
+
+    /* Destroy the key. */
+    pj_sock_close(key->fd);
+
+    pj_lock_release(ioqueue->lock);
+
+    /* Mark key is closing. */
+    key->closing = 1;
+
+    pj_ioqueue_unlock_key(key);
+
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+    /* Drain pending write callbacks. See #4864, #4878. */
+    ioqueue_drain_pending_writes(key);
+
+    /* Decrement counter. */
+    decrement_counter(key);
+#else
+    /* Destroy the key lock */
+    pj_lock_destroy(key->lock);
+#endif
+
+    /* Done. */
+    if (key->grp_lock) {
+        pj_grp_lock_dec_ref_dbg(key->grp_lock, "ioqueue", 0);
+    }
+
+    return PJ_SUCCESS;
+}
+
+
+/* ioqueue_remove_from_set()
+ * This function is called from ioqueue_dispatch_event() to instruct
+ * the ioqueue to remove the specified descriptor from ioqueue's descriptor
+ * set for the specified event.
+ */
+static void ioqueue_remove_from_set( pj_ioqueue_t *ioqueue,
+                                     pj_ioqueue_key_t *key,
+                                     enum ioqueue_event_type event_type )
+{
+    ioqueue_remove_from_set2(ioqueue, key, event_type);
+}
+
+static void ioqueue_remove_from_set2(pj_ioqueue_t *ioqueue,
+                                     pj_ioqueue_key_t *key,
+                                     unsigned event_types)
+{
+    /* An already armed poll request is left to complete, the resulting
+     * event is discarded as there is no pending operation and the poll
+     * is not re-armed.
+     */
+    pj_lock_acquire(ioqueue->ring_lock);
+    key->events &= ~event_types;
+#if HAS_COMPLETION_IO
+    cancel_stale_requests(ioqueue, key, event_types);
+#endif
+    pj_lock_release(ioqueue->ring_lock);
+}
+
+/*
+ * ioqueue_add_to_set()
+ * This function is called from pj_ioqueue_recv(), pj_ioqueue_send() etc
+ * to instruct the ioqueue to add the specified handle to ioqueue's descriptor
+ * set for the specified event.
+ */
+static void ioqueue_add_to_set( pj_ioqueue_t *ioqueue,
+                                pj_ioqueue_key_t *key,
+                                enum ioqueue_event_type event_type )
+{
+    ioqueue_add_to_set2(ioqueue, key, event_type);
+}
+
+static void ioqueue_add_to_set2(pj_ioqueue_t *ioqueue,
+                                pj_ioqueue_key_t *key,
+                                unsigned event_types )
+{
+    unsigned armed;
+
+#if HAS_COMPLETION_IO
+    /* Receive and send operations are submitted to the ring, only accept
+     * and connect need the readiness notification.
+     */
+    if ((event_types & READABLE_EVENT) && !key_has_pending_accept(key)) {
+        start_recv(ioqueue, key);
+        event_types &= ~READABLE_EVENT;
+    }
+    if ((event_types & WRITEABLE_EVENT) && !key->connecting) {
+        start_send(ioqueue, key);
+        event_types &= ~WRITEABLE_EVENT;
+    }
+    if (event_types == 0)
+        return;
+#endif
+
+    pj_lock_acquire(ioqueue->ring_lock);
+    armed = key->armed;
+    key->events |= event_types;
+    update_poll_set(ioqueue, key);
+
+    /* Threads that are already waiting in pj_ioqueue_poll() would not
+     * see the new request, so submit it now. Otherwise it will be
+     * submitted together with the next wait.
+     */
+    if (key->armed != armed && ioqueue->waiters)
+        sq_flush(ioqueue);
+    pj_lock_release(ioqueue->ring_lock);
+}
+
+
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+/* Scan closing keys to be put to free list again */
+static void scan_closing_keys(pj_ioqueue_t *ioqueue)
+{
+    pj_time_val now;
+    pj_ioqueue_key_t *h;
+
+    pj_gettickcount(&now);
+    h = ioqueue->closing_list.next;
+    while (h != &ioqueue->closing_list) {
+        pj_ioqueue_key_t *next = h->next;
+
+        pj_assert(h->closing != 0);
+
+        if (PJ_TIME_VAL_GTE(now, h->free_time)) {
+            pj_list_erase(h);
+            // Don't set grp_lock to NULL otherwise the other thread
+            // will crash. Just leave it as dangling pointer, but this
+            // should be safe
+            //h->grp_lock = NULL;
+            pj_list_push_back(&ioqueue->free_list, h);
+        }
+        h = next;
+    }
+}
+#endif
+
+/*
+ * pj_ioqueue_poll()
+ *
+ */
+PJ_DEF(int) pj_ioqueue_poll( pj_ioqueue_t *ioqueue, const pj_time_val *timeout)
+{
+    int i, rc, count, event_cnt, processed_cnt;
+    int msec;
+    enum { MAX_EVENTS = PJ_IOQUEUE_MAX_CAND_EVENTS };
+    struct {
+        pj_ioqueue_key_t *key;
+        int               type;
+        int               res;
+    } events[MAX_EVENTS];
+    struct queue queue[MAX_EVENTS];
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec ts;
+    unsigned to_submit, head, tail;
+    pj_timestamp t1, t2;
+
+    PJ_CHECK_STACK();
+
+    msec = timeout ? PJ_TIME_VAL_MSEC(*timeout) : 9000;
+
+    ts.tv_sec = msec / 1000;
+    ts.tv_nsec = (msec % 1000) * 1000000;
+    pj_bzero(&arg, sizeof(arg));
+    arg.ts = (pj_uint64_t)(pj_size_t)&ts;
+
+    TRACE_((THIS_FILE, "start io_uring_enter, msec=%d", msec));
+    pj_get_timestamp(&t1);
+
+    /* Submit pending requests (including the poll re-arms from the
+     * previous iteration) and wait for completions in a single call.
+     */
+    pj_lock_acquire(ioqueue->ring_lock);
+    to_submit = sq_unsubmitted(ioqueue);
+    ++ioqueue->waiters;
+    pj_lock_release(ioqueue->ring_lock);
+
+    rc = os_uring_enter(ioqueue->ring_fd, to_submit, 1,
+                        IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                        &arg, sizeof(arg));
+    if (rc < 0 && errno != ETIME && errno != EINTR && errno != EBUSY) {
+        rc = -pj_get_netos_error();
+        pj_lock_acquire(ioqueue->ring_lock);
+        --ioqueue->waiters;
+        pj_lock_release(ioqueue->ring_lock);
+        TRACE_((THIS_FILE, "  io_uring_enter error"));
+        return rc;
+    }
+
+    /* Reap the completions */
+    pj_lock_acquire(ioqueue->ring_lock);
+    --ioqueue->waiters;
+
+    head = *ioqueue->cq_khead;
+    tail = LOAD_ACQUIRE(ioqueue->cq_ktail);
+    count = 0;
+    for (; head != tail && count < MAX_EVENTS; ++head) {
+        const struct io_uring_cqe *cqe;
+        pj_ioqueue_key_t *h;
+        int type;
+
+        cqe = &ioqueue->cqes[head & ioqueue->cq_mask];
+        if (cqe->user_data == 0)
+            continue;
+
+        h = (pj_ioqueue_key_t*)(pj_size_t)
+            (cqe->user_data & ~(pj_uint64_t)REQ_TYPE_MASK);
+        type = (int)(cqe->user_data & REQ_TYPE_MASK);
+
+        if (type == POLL_RD || type == POLL_WR) {
+            /* A poll that has been removed. Don't touch the key as it may
+             * have been unregistered.
+             */
+            if (cqe->res == -ECANCELED)
+                continue;
+
+            h->armed &= ~(1 << type);
+        }
+
+        events[count].key = h;
+        events[count].type = type;
+        events[count].res = cqe->res;
+        ++count;
+    }
+    STORE_RELEASE(ioqueue->cq_khead, head);
+
+    pj_lock_release(ioqueue->ring_lock);
+
+    if (count == 0) {
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+        /* Check the closing keys only when there's no activity and when
+         * there are pending closing keys.
+         */
+        if (!pj_list_empty(&ioqueue->closing_list)) {
+            pj_lock_acquire(ioqueue->lock);
+            scan_closing_keys(ioqueue);
+            pj_lock_release(ioqueue->lock);
+        }
+#endif
+        TRACE_((THIS_FILE, "  io_uring_enter timed out"));
+        return 0;
+    }
+
+    pj_get_timestamp(&t2);
+    TRACE_((THIS_FILE, "  io_uring_enter returns %d, time=%d usec",
+                       count, pj_elapsed_usec(&t1, &t2)));
+
+    /* Lock ioqueue. */
+    pj_lock_acquire(ioqueue->lock);
+
+    for (event_cnt=0, i=0; i<count; ++i) {
+        pj_ioqueue_key_t *h = events[i].key;
+        unsigned mask;
+
+        TRACE_((THIS_FILE, "     event %d: type=%d res=%d", i,
+                events[i].type, events[i].res));
+
+        /* Completions of receive and send are handled below */
+        if (events[i].type != POLL_RD && events[i].type != POLL_WR)
+            continue;
+
+        if (IS_CLOSING(h))
+            continue;
+
+        /* Report errors on the poll request itself as error condition */
+        mask = events[i].res < 0 ? POLLERR : (unsigned)events[i].res;
+
+        if (events[i].type == POLL_RD) {
+            /*
+             * Check readability. Error and hangup are reported as
+             * readable and the higher layers will handle it.
+             */
+            if ((mask & (POLLIN | POLLERR | POLLHUP)) &&
+                (key_has_pending_read(h) || key_has_pending_accept(h)))
+            {
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+                increment_counter(h);
+#endif
+                queue[event_cnt].key = h;
+                queue[event_cnt].event_type = READABLE_EVENT;
+                ++event_cnt;
+                continue;
+            }
+        } else {
+            /*
+             * Check for writeability.
+             */
+            if ((mask & POLLOUT) && key_has_pending_write(h)) {
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+                increment_counter(h);
+#endif
+                queue[event_cnt].key = h;
+                queue[event_cnt].event_type = WRITEABLE_EVENT;
+                ++event_cnt;
+                continue;
+            }
+
+#if PJ_HAS_TCP
+            /*
+             * Check for completion of connect() operation.
+             */
+            if ((mask & (POLLOUT | POLLERR | POLLHUP)) && h->connecting) {
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+                increment_counter(h);
+#endif
+                queue[event_cnt].key = h;
+                queue[event_cnt].event_type = (mask & POLLOUT) ?
+                                              WRITEABLE_EVENT :
+                                              EXCEPTION_EVENT;
+                ++event_cnt;
+                continue;
+            }
+#endif /* PJ_HAS_TCP */
+        }
+
+        /* Not processing this event (see the epoll backend for the
+         * innocent cases where this may happen). The poll is re-armed
+         * below if the key is still interested.
+         */
+        TRACE_WARN((THIS_FILE, "     UNHANDLED event %d: events=0x%x, h=%p",
+                    i, mask, h));
+    }
+    for (i=0; i<event_cnt; ++i) {
+        if (queue[i].key->grp_lock)
+            pj_grp_lock_add_ref_dbg(queue[i].key->grp_lock, "ioqueue", 0);
+    }
+
+    PJ_RACE_ME(5);
+
+    pj_lock_release(ioqueue->lock);
+
+    PJ_RACE_ME(5);
+
+    processed_cnt = 0;
+
+    /* Now process the events. */
+    for (i=0; i<event_cnt; ++i) {
+        /* Just do not exceed PJ_IOQUEUE_MAX_EVENTS_IN_SINGLE_POLL */
+        if (processed_cnt < PJ_IOQUEUE_MAX_EVENTS_IN_SINGLE_POLL) {
+            pj_bool_t event_done = PJ_FALSE;
+            switch (queue[i].event_type) {
+            case READABLE_EVENT:
+                event_done = ioqueue_dispatch_read_event(ioqueue,queue[i].key);
+
+                break;
+            case WRITEABLE_EVENT:
+                event_done = ioqueue_dispatch_write_event(ioqueue,
+                                                          queue[i].key);
+
+                break;
+            case EXCEPTION_EVENT:
+                event_done = ioqueue_dispatch_exception_event(ioqueue,
+                                                              queue[i].key);
+                break;
+            case NO_EVENT:
+                pj_assert(!"Invalid event!");
+                break;
+            }
+            if (event_done) {
+                ++processed_cnt;
+            }
+        }
+    }
+
+#if HAS_COMPLETION_IO
+    /* Process the completed receive and send requests. These are always
+     * processed, as their completion has been consumed from the ring.
+     */
+    for (i=0; i<count; ++i) {
+        pj_bool_t event_done = PJ_FALSE;
+
+        if (events[i].type == OP_RECV) {
+            event_done = complete_recv(ioqueue, events[i].key,
+                                       events[i].res);
+        } else if (events[i].type == OP_SEND) {
+            event_done = complete_send(ioqueue, events[i].key,
+                                       events[i].res);
+        }
+        if (event_done)
+            ++processed_cnt;
+    }
+#endif
+
+    /* Re-arm the one-shot polls as long as there are pending requests,
+     * for the same reason as the ONESHOT handling in the epoll backend.
+     * The keys are still referenced by the counter/group lock taken above
+     * (or belong to this iteration's completions, for events that were
+     * not dispatched), and the re-arm requests are submitted with the
+     * next wait unless another thread is already waiting.
+     */
+    pj_lock_acquire(ioqueue->ring_lock);
+    for (i=0; i<count; ++i) {
+        pj_ioqueue_key_t *h = events[i].key;
+        if ((events[i].type == POLL_RD || events[i].type == POLL_WR) &&
+            !IS_CLOSING(h))
+        {
+            update_poll_set(ioqueue, h);
+        }
+    }
+    if (ioqueue->waiters)
+        sq_flush(ioqueue);
+    pj_lock_release(ioqueue->ring_lock);
+
+    for (i=0; i<event_cnt; ++i) {
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+        decrement_counter(queue[i].key);
+#endif
+
+        if (queue[i].key->grp_lock)
+            pj_grp_lock_dec_ref_dbg(queue[i].key->grp_lock,
+                                    "ioqueue", 0);
+    }
+
+#if HAS_COMPLETION_IO
+    /* Release the references held by the completed requests */
+    for (i=0; i<count; ++i) {
+        if (events[i].type == OP_RECV || events[i].type == OP_SEND)
+            release_key(events[i].key);
+    }
+#endif
+
+    /* Special case:
+     * When io_uring returns > 0 but event_cnt, the number of events
+     * we want to process, is zero. See the epoll backend.
+     */
+    if (count > 0 && !event_cnt && !processed_cnt && msec > 0) {
+        int delay = msec - pj_elapsed_usec(&t1, &t2)/1000;
+        if (delay > 10) delay = 10;
+        if (delay > 0)
+            pj_thread_sleep(delay);
+    }
+
+    TRACE_((THIS_FILE, "     poll: count=%d events=%d processed=%d",
+                       count, event_cnt, processed_cnt));
+
+    pj_get_timestamp(&t1);
+    TRACE_((THIS_FILE, "ioqueue_poll() returns %d, time=%d usec",
+                       processed_cnt, pj_elapsed_usec(&t2, &t1)));
+
+    return processed_cnt;
+}
+
+PJ_DEF(pj_oshandle_t) pj_ioqueue_get_os_handle( pj_ioqueue_t *ioqueue )
+{
+    return ioqueue ? (pj_oshandle_t)&ioqueue->ring_fd : NULL;
+}
+
+#endif /* PJ_IOQUEUE_IMP == PJ_IOQUEUE_IMP_IO_URING */
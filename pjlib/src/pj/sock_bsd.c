@@ -16,6 +16,11 @@
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA 
  */
+/* recvmmsg() and sendmmsg() are GNU extensions on glibc */
+#ifndef _GNU_SOURCE
+#   define _GNU_SOURCE
+#endif
+
 #include <pj/sock.h>
 #include <pj/os.h>
 #include <pj/assert.h>
@@ -803,6 +808,109 @@ PJ_DEF(pj_status_t) pj_sock_recvfrom(pj_sock_t sock,
     }
 }
 
+#if defined(PJ_HAS_RECVMMSG) && PJ_HAS_RECVMMSG!=0
+/*
+ * Receive multiple datagrams with recvmmsg(). Platforms without
+ * recvmmsg() use the emulation in sock_common.c.
+ */
+PJ_DEF(pj_status_t) pj_sock_recvmmsg(pj_sock_t sock,
+                                     pj_sock_mmsg msgs[],
+                                     unsigned *count,
+                                     unsigned flags)
+{
+    enum { MAX_MSG = 64 };
+    struct mmsghdr hdr[MAX_MSG];
+    struct iovec iov[MAX_MSG];
+    unsigned i, cnt;
+    int rc;
+
+    PJ_CHECK_STACK();
+    PJ_ASSERT_RETURN(msgs && count && *count, PJ_EINVAL);
+
+    cnt = (*count < MAX_MSG) ? *count : MAX_MSG;
+    pj_bzero(hdr, cnt * sizeof(hdr[0]));
+    for (i = 0; i < cnt; ++i) {
+        iov[i].iov_base = msgs[i].buf;
+        iov[i].iov_len = msgs[i].len;
+        hdr[i].msg_hdr.msg_iov = &iov[i];
+        hdr[i].msg_hdr.msg_iovlen = 1;
+        if (msgs[i].addr) {
+            hdr[i].msg_hdr.msg_name = msgs[i].addr;
+            hdr[i].msg_hdr.msg_namelen = msgs[i].addr_len;
+        }
+    }
+
+    rc = recvmmsg(sock, hdr, cnt, flags, NULL);
+    if (rc < 0) {
+        *count = 0;
+        return PJ_RETURN_OS_ERROR(pj_get_native_netos_error());
+    }
+
+    for (i = 0; i < (unsigned)rc; ++i) {
+        msgs[i].len = hdr[i].msg_len;
+        if (msgs[i].addr) {
+            msgs[i].addr_len = hdr[i].msg_hdr.msg_namelen;
+            PJ_SOCKADDR_RESET_LEN(msgs[i].addr);
+        }
+    }
+    *count = rc;
+
+    return PJ_SUCCESS;
+}
+#endif  /* PJ_HAS_RECVMMSG */
+
+#if defined(PJ_HAS_SENDMMSG) && PJ_HAS_SENDMMSG!=0
+/*
+ * Send multiple datagrams with sendmmsg(). Platforms without sendmmsg()
+ * use the emulation in sock_common.c.
+ */
+PJ_DEF(pj_status_t) pj_sock_sendmmsg(pj_sock_t sock,
+                                     pj_sock_mmsg msgs[],
+                                     unsigned *count,
+                                     unsigned flags)
+{
+    enum { MAX_MSG = 64 };
+    struct mmsghdr hdr[MAX_MSG];
+    struct iovec iov[MAX_MSG];
+    unsigned i, cnt;
+    int rc;
+
+    PJ_CHECK_STACK();
+    PJ_ASSERT_RETURN(msgs && count && *count, PJ_EINVAL);
+
+#ifdef MSG_NOSIGNAL
+    /* Suppress SIGPIPE. See https://github.com/pjsip/pjproject/issues/1538 */
+    flags |= MSG_NOSIGNAL;
+#endif
+
+    cnt = (*count < MAX_MSG) ? *count : MAX_MSG;
+    pj_bzero(hdr, cnt * sizeof(hdr[0]));
+    for (i = 0; i < cnt; ++i) {
+        iov[i].iov_base = msgs[i].buf;
+        iov[i].iov_len = msgs[i].len;
+        hdr[i].msg_hdr.msg_iov = &iov[i];
+        hdr[i].msg_hdr.msg_iovlen = 1;
+        if (msgs[i].addr) {
+            CHECK_ADDR_LEN(msgs[i].addr, msgs[i].addr_len);
+            hdr[i].msg_hdr.msg_name = msgs[i].addr;
+            hdr[i].msg_hdr.msg_namelen = msgs[i].addr_len;
+        }
+    }
+
+    rc = sendmmsg(sock, hdr, cnt, flags);
+    if (rc < 0) {
+        *count = 0;
+        return PJ_RETURN_OS_ERROR(pj_get_native_netos_error());
+    }
+
+    for (i = 0; i < (unsigned)rc; ++i)
+        msgs[i].len = hdr[i].msg_len;
+    *count = rc;
+
+    return PJ_SUCCESS;
+}
+#endif  /* PJ_HAS_SENDMMSG */
+
 /*
  * Get socket option.
  */
@@ -1411,6 +1411,67 @@ PJ_DEF(pj_status_t) pj_sock_socketpair(int family,
 #endif
 
 
+#if !defined(PJ_HAS_RECVMMSG) || PJ_HAS_RECVMMSG == 0
+/*
+ * Emulate batched receive with repeated recvfrom() on platforms without
+ * recvmmsg().
+ */
+PJ_DEF(pj_status_t) pj_sock_recvmmsg(pj_sock_t sockfd,
+                                     pj_sock_mmsg msgs[],
+                                     unsigned *count,
+                                     unsigned flags)
+{
+    unsigned i;
+    pj_status_t status = PJ_SUCCESS;
+
+    PJ_CHECK_STACK();
+    PJ_ASSERT_RETURN(msgs && count && *count, PJ_EINVAL);
+
+    for (i = 0; i < *count; ++i) {
+        status = pj_sock_recvfrom(sockfd, msgs[i].buf, &msgs[i].len, flags,
+                                  msgs[i].addr,
+                                  msgs[i].addr ? &msgs[i].addr_len : NULL);
+        if (status != PJ_SUCCESS)
+            break;
+    }
+    *count = i;
+
+    return (i > 0) ? PJ_SUCCESS : status;
+}
+#endif
+
+#if !defined(PJ_HAS_SENDMMSG) || PJ_HAS_SENDMMSG == 0
+/*
+ * Emulate batched send with repeated sendto() on platforms without
+ * sendmmsg().
+ */
+PJ_DEF(pj_status_t) pj_sock_sendmmsg(pj_sock_t sockfd,
+                                     pj_sock_mmsg msgs[],
+                                     unsigned *count,
+                                     unsigned flags)
+{
+    unsigned i;
+    pj_status_t status = PJ_SUCCESS;
+
+    PJ_CHECK_STACK();
+    PJ_ASSERT_RETURN(msgs && count && *count, PJ_EINVAL);
+
+    for (i = 0; i < *count; ++i) {
+        if (msgs[i].addr) {
+            status = pj_sock_sendto(sockfd, msgs[i].buf, &msgs[i].len,
+                                    flags, msgs[i].addr, msgs[i].addr_len);
+        } else {
+            status = pj_sock_send(sockfd, msgs[i].buf, &msgs[i].len, flags);
+        }
+        if (status != PJ_SUCCESS)
+            break;
+    }
+    *count = i;
+
+    return (i > 0) ? PJ_SUCCESS : status;
+}
+#endif
+
 /* Check IP address type. */
 PJ_DEF(pj_bool_t) pj_check_addr_type(const pj_sockaddr *addr, unsigned type)
 {
@@ -32,6 +32,7 @@
 #include <pj/string.h>
 #include <pj/assert.h>
 #include <pj/errno.h>
+#include <pj/hash.h>
 #include <pj/lock.h>
 #include <pj/log.h>
 #include <pj/rand.h>
@@ -45,6 +46,40 @@
 
 #define DEFAULT_MAX_TIMED_OUT_PER_POLL  (64)
 
+/* When the timer heap is split into per-thread sub-heaps, a sub-heap whose
+ * thread is this late polling it is polled by any thread.
+ */
+#define THREAD_HEAP_GRACE_MSEC          (20)
+
+/* When the timer heap is split into sub-heaps, the index of the sub-heap
+ * is kept in the high bits of the entry's timer id, so that the entry can
+ * be cancelled without knowing where it was scheduled.
+ */
+#define TIMER_ID_HEAP_SHIFT             24
+#define TIMER_ID_MASK                   ((1 << TIMER_ID_HEAP_SHIFT) - 1)
+#define TIMER_ID_MAX_HEAPS              (0x7F)
+#define TIMER_ID(id)                    ((id) & TIMER_ID_MASK)
+#define TIMER_ID_HEAP(id)               ((unsigned)(id) >> TIMER_ID_HEAP_SHIFT)
+
+#if PJ_TIMER_USE_LINKED_LIST && PJ_TIMER_USE_WHEEL
+#  error "PJ_TIMER_USE_LINKED_LIST and PJ_TIMER_USE_WHEEL can't both be set"
+#endif
+
+#if PJ_TIMER_USE_WHEEL
+/* The timing wheel has WHEEL_LEVELS levels of WHEEL_SLOTS slots each. A slot
+ * in level 0 spans one millisecond, a slot in level n spans a whole level
+ * n-1. Entries further in the future than the wheel can hold are parked in
+ * the last level and reinserted when that slot is cascaded.
+ */
+#  define WHEEL_LEVELS          4
+#  define WHEEL_BITS            8
+#  define WHEEL_SLOTS           (1 << WHEEL_BITS)
+#  define WHEEL_MASK            (WHEEL_SLOTS - 1)
+#  define WHEEL_MAP_WORDS       (WHEEL_SLOTS / 32)
+#  define WHEEL_SHIFT(lvl)      ((lvl) * WHEEL_BITS)
+#  define WHEEL_SPAN(lvl)       ((pj_uint64_t)1 << WHEEL_SHIFT((lvl)+1))
+#endif
+
 /* Enable this to raise assertion in order to catch bug of timer entry
  * which has been deallocated without being cancelled. If disabled,
  * the timer heap will simply remove the destroyed entry (and print log)
@@ -66,7 +101,7 @@ enum
 /* Duplicate/copy of the timer entry. */
 typedef struct pj_timer_entry_dup
 {
-#if PJ_TIMER_USE_LINKED_LIST
+#if PJ_TIMER_USE_LINKED_LIST || PJ_TIMER_USE_WHEEL
     /**
     * Standard list members.
     */
@@ -102,7 +137,7 @@ typedef struct pj_timer_entry_dup
 
 } pj_timer_entry_dup;
 
-#define GET_TIMER(ht, node) &ht->timer_dups[node->_timer_id]
+#define GET_TIMER(ht, node) &ht->timer_dups[TIMER_ID(node->_timer_id)]
 #define GET_ENTRY(node) node->entry
 #define GET_FIELD(node, _timer_id) node->dup._timer_id
 
@@ -155,6 +190,20 @@ struct pj_timer_heap_t
     pj_timer_entry_dup head_list;
 #endif
 
+#if PJ_TIMER_USE_WHEEL
+    /** The next tick (in msec) to be processed by the wheel. */
+    pj_uint64_t wheel_tick;
+
+    /** The wheel slots, each is a list of pj_timer_entry_dup. */
+    pj_list wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+
+    /** Bitmap of non-empty slots in each level of the wheel. */
+    pj_uint32_t wheel_map[WHEEL_LEVELS][WHEEL_MAP_WORDS];
+
+    /** Entries which have expired but not been dispatched yet. */
+    pj_list expired;
+#endif
+
     /**
      * An array of "pointers" that allows each pj_timer_entry in the
      * <heap_> to be located in O(1) time.  Basically, <timer_id_[i]>
@@ -181,6 +230,34 @@ struct pj_timer_heap_t
     /** Callback to be called when a timer expires. */
     pj_timer_heap_callback *callback;
 
+    /**
+     * Sub-heaps, when the heap has been split with
+     * pj_timer_heap_set_thread_heaps(). The first one is this heap.
+     */
+    pj_timer_heap_t **sub_heaps;
+
+    /** Number of sub-heaps, zero if the heap has not been split. */
+    unsigned sub_cnt;
+
+    /** Number of polling threads which have been assigned a sub-heap. */
+    unsigned thread_cnt;
+
+    /** Thread local storage of the sub-heap assigned to a thread. */
+    long thread_heap_tls;
+
+    /** The heap which this heap is a sub-heap of, or this heap itself. */
+    pj_timer_heap_t *owner;
+
+    /** Index of this heap in the owner's sub-heaps. */
+    unsigned sub_idx;
+
+    /**
+     * The time by which the thread of this sub-heap is expected to poll
+     * it again, i.e. the earliest expiration seen by its last poll or by
+     * a later schedule.
+     */
+    pj_time_val poll_deadline;
+
 };
 
 
@@ -199,6 +276,273 @@ PJ_INLINE(void) unlock_timer_heap( pj_timer_heap_t *ht )
     }
 }
 
+#if PJ_TIMER_USE_WHEEL
+
+PJ_INLINE(pj_uint64_t) time_val_to_tick(const pj_time_val *t)
+{
+    return (pj_uint64_t)t->sec * 1000 + t->msec;
+}
+
+PJ_INLINE(void) wheel_set_slot(pj_timer_heap_t *ht, unsigned lvl,
+                               unsigned idx)
+{
+    ht->wheel_map[lvl][idx / 32] |= (1U << (idx % 32));
+}
+
+PJ_INLINE(void) wheel_clear_slot(pj_timer_heap_t *ht, unsigned lvl,
+                                 unsigned idx)
+{
+    ht->wheel_map[lvl][idx / 32] &= ~(1U << (idx % 32));
+}
+
+/* Find the first non-empty slot of a level, starting at index "from".
+ * Returns -1 if there is none.
+ */
+static int wheel_find_slot(const pj_uint32_t *map, unsigned from)
+{
+    unsigned w;
+
+    for (w = from / 32; w < WHEEL_MAP_WORDS; ++w) {
+        pj_uint32_t bits = map[w];
+        unsigned b = 0;
+
+        if (w == from / 32)
+            bits &= (0xFFFFFFFF << (from % 32));
+        if (!bits)
+            continue;
+
+        while ((bits & 1) == 0) {
+            bits >>= 1;
+            ++b;
+        }
+        return (int)(w * 32 + b);
+    }
+    return -1;
+}
+
+/* Get the tick at which a slot will be processed, i.e. the first tick not
+ * before the current wheel position which maps to that slot. Entries in
+ * the slot can't expire before this tick.
+ */
+static pj_uint64_t wheel_slot_tick(const pj_timer_heap_t *ht,
+                                   unsigned lvl, unsigned idx)
+{
+    pj_uint64_t tick;
+
+    tick = (ht->wheel_tick & ~(WHEEL_SPAN(lvl) - 1)) +
+           ((pj_uint64_t)idx << WHEEL_SHIFT(lvl));
+    if (tick < ht->wheel_tick)
+        tick += WHEEL_SPAN(lvl);
+
+    return tick;
+}
+
+/* Get the earliest tick at which the wheel has any slot to process, or
+ * (pj_uint64_t)-1 if the wheel is empty.
+ */
+static pj_uint64_t wheel_next_tick(const pj_timer_heap_t *ht)
+{
+    pj_uint64_t next = (pj_uint64_t)-1;
+    unsigned lvl;
+
+    for (lvl = 0; lvl < WHEEL_LEVELS; ++lvl) {
+        unsigned start;
+        int idx;
+
+        start = (unsigned)(ht->wheel_tick >> WHEEL_SHIFT(lvl)) & WHEEL_MASK;
+
+        /* Upper level slot at the current position has already been
+         * cascaded, unless we're exactly at its boundary.
+         */
+        if (ht->wheel_tick & ((WHEEL_SPAN(lvl) >> WHEEL_BITS) - 1))
+            ++start;
+
+        idx = wheel_find_slot(ht->wheel_map[lvl], start);
+        if (idx < 0)
+            idx = wheel_find_slot(ht->wheel_map[lvl], 0);
+        if (idx >= 0) {
+            pj_uint64_t tick = wheel_slot_tick(ht, lvl, idx);
+            if (tick < next)
+                next = tick;
+        }
+    }
+
+    return next;
+}
+
+/* Put an entry in the wheel according to its expiration time. */
+static void wheel_add(pj_timer_heap_t *ht, pj_timer_entry_dup *node)
+{
+    pj_uint64_t expires = time_val_to_tick(&node->_timer_value);
+    pj_uint64_t delta;
+    unsigned lvl, idx;
+
+    if (expires < ht->wheel_tick) {
+        /* Already expired, dispatch it on the next poll */
+        pj_list_push_back(&ht->expired, node);
+        return;
+    }
+
+    delta = expires - ht->wheel_tick;
+    for (lvl = 0; lvl < WHEEL_LEVELS-1 && delta >= WHEEL_SPAN(lvl); ++lvl)
+        ;
+
+    /* Too far in the future, park it in the farthest slot. It will be
+     * reinserted when that slot is cascaded.
+     */
+    if (delta >= WHEEL_SPAN(lvl))
+        expires = ht->wheel_tick + WHEEL_SPAN(lvl) - 1;
+
+    idx = (unsigned)(expires >> WHEEL_SHIFT(lvl)) & WHEEL_MASK;
+    pj_list_push_back(&ht->wheel[lvl][idx], node);
+    wheel_set_slot(ht, lvl, idx);
+}
+
+/* Remove an entry from the wheel or from the expired list. */
+static void wheel_erase(pj_timer_heap_t *ht, pj_timer_entry_dup *node)
+{
+    pj_list *prev = (pj_list*)node->prev;
+    pj_list *first = &ht->wheel[0][0];
+
+    pj_list_erase(node);
+
+    /* Clear the slot bit if this was the last entry of a wheel slot */
+    if (prev->next == prev && prev >= first &&
+        prev < first + WHEEL_LEVELS * WHEEL_SLOTS)
+    {
+        unsigned n = (unsigned)(prev - first);
+        wheel_clear_slot(ht, n / WHEEL_SLOTS, n % WHEEL_SLOTS);
+    }
+}
+
+/* Move the entries of an upper level slot down the wheel. */
+static void wheel_cascade(pj_timer_heap_t *ht, unsigned lvl, unsigned idx)
+{
+    pj_list list;
+
+    pj_list_init(&list);
+    pj_list_merge_last(&list, &ht->wheel[lvl][idx]);
+    wheel_clear_slot(ht, lvl, idx);
+
+    while (!pj_list_empty(&list)) {
+        pj_timer_entry_dup *node = (pj_timer_entry_dup*)list.next;
+
+        pj_list_erase(node);
+        wheel_add(ht, node);
+    }
+}
+
+/* Advance the wheel up to and including tick "now", moving the entries
+ * which have expired to the expired list. Ticks where there is nothing to
+ * do are skipped, so this doesn't depend on how long it has been since
+ * the last call.
+ */
+static void wheel_advance(pj_timer_heap_t *ht, const pj_time_val *now)
+{
+    pj_uint64_t now_tick = time_val_to_tick(now);
+
+    while (ht->wheel_tick <= now_tick) {
+        unsigned idx = (unsigned)ht->wheel_tick & WHEEL_MASK;
+        pj_uint64_t next;
+
+        if (idx == 0) {
+            unsigned lvl;
+
+            for (lvl = 1; lvl < WHEEL_LEVELS; ++lvl) {
+                unsigned i;
+
+                i = (unsigned)(ht->wheel_tick >> WHEEL_SHIFT(lvl)) &
+                    WHEEL_MASK;
+                wheel_cascade(ht, lvl, i);
+                if (i != 0)
+                    break;
+            }
+        }
+
+        pj_list_merge_last(&ht->expired, &ht->wheel[0][idx]);
+        wheel_clear_slot(ht, 0, idx);
+
+        ++ht->wheel_tick;
+        next = wheel_next_tick(ht);
+        if (next > now_tick) {
+            ht->wheel_tick = now_tick + 1;
+            break;
+        }
+        ht->wheel_tick = next;
+    }
+}
+
+/* Restart the (empty) wheel from the current time. */
+static void wheel_reset(pj_timer_heap_t *ht)
+{
+    pj_time_val now;
+
+    pj_gettickcount(&now);
+    ht->wheel_tick = time_val_to_tick(&now);
+    pj_bzero(ht->wheel_map, sizeof(ht->wheel_map));
+}
+
+/* Find the entry with the earliest expiration time. */
+static pj_timer_entry_dup *wheel_earliest(pj_timer_heap_t *ht)
+{
+    pj_timer_entry_dup *earliest = NULL;
+    pj_timer_entry_dup *node;
+    unsigned lvl, idx;
+
+    node = (pj_timer_entry_dup*)ht->expired.next;
+    for (; node != (pj_timer_entry_dup*)&ht->expired; node = node->next) {
+        if (!earliest ||
+            PJ_TIME_VAL_LT(node->_timer_value, earliest->_timer_value))
+        {
+            earliest = node;
+        }
+    }
+
+    for (lvl = 0; lvl < WHEEL_LEVELS; ++lvl) {
+        for (idx = 0; idx < WHEEL_SLOTS; ++idx) {
+            pj_list *slot = &ht->wheel[lvl][idx];
+
+            if (pj_list_empty(slot))
+                continue;
+            if (earliest &&
+                time_val_to_tick(&earliest->_timer_value) <=
+                    wheel_slot_tick(ht, lvl, idx))
+            {
+                continue;
+            }
+
+            node = (pj_timer_entry_dup*)slot->next;
+            for (; node != (pj_timer_entry_dup*)slot; node = node->next) {
+                if (!earliest ||
+                    PJ_TIME_VAL_LT(node->_timer_value,
+                                   earliest->_timer_value))
+                {
+                    earliest = node;
+                }
+            }
+        }
+    }
+
+    return earliest;
+}
+
+#if PJ_TIMER_USE_COPY
+/* Relink the entries of a list after the entry copies have been moved to
+ * a new array.
+ */
+static void wheel_relink(pj_list *head, pj_timer_entry_dup *old_dups,
+                         pj_timer_entry_dup *new_dups)
+{
+    pj_timer_entry_dup *node = (pj_timer_entry_dup*)head->next;
+
+    pj_list_init(head);
+    for (; node != (pj_timer_entry_dup*)head; node = node->next)
+        pj_list_push_back(head, &new_dups[node - old_dups]);
+}
+#endif
+
+#endif  /* PJ_TIMER_USE_WHEEL */
+
 
 static void copy_node( pj_timer_heap_t *ht, pj_size_t slot, 
                        pj_timer_entry_dup *moved_node )
@@ -209,7 +553,7 @@ static void copy_node( pj_timer_heap_t *ht, pj_size_t slot,
     ht->heap[slot] = moved_node;
 
     // Update the corresponding slot in the parallel <timer_ids_> array.
-    ht->timer_ids[GET_FIELD(moved_node, _timer_id)] = (int)slot;
+    ht->timer_ids[TIMER_ID(GET_FIELD(moved_node, _timer_id))] = (int)slot;
 }
 
 static pj_timer_id_t pop_freelist( pj_timer_heap_t *ht )
@@ -239,6 +583,7 @@ static void push_freelist (pj_timer_heap_t *ht, pj_timer_id_t old_id)
 }
 
 
+#if !PJ_TIMER_USE_LINKED_LIST && !PJ_TIMER_USE_WHEEL
 static void reheap_down(pj_timer_heap_t *ht, pj_timer_entry_dup *moved_node,
                         size_t slot, size_t child)
 {
@@ -297,6 +642,7 @@ static void reheap_up( pj_timer_heap_t *ht, pj_timer_entry_dup *moved_node,
     // update the corresponding slot in the parallel <timer_ids> array.
     copy_node(ht, slot, moved_node);
 }
+#endif
 
 
 static pj_timer_entry_dup * remove_node( pj_timer_heap_t *ht, size_t slot)
@@ -304,7 +650,7 @@ static pj_timer_entry_dup * remove_node( pj_timer_heap_t *ht, size_t slot)
     pj_timer_entry_dup *removed_node = ht->heap[slot];
 
     // Return this timer id to the freelist.
-    push_freelist( ht, GET_FIELD(removed_node, _timer_id) );
+    push_freelist( ht, TIMER_ID(GET_FIELD(removed_node, _timer_id)) );
 
     // Decrement the size of the heap by one since we're removing the
     // "slot"th node.
@@ -335,7 +681,9 @@ static pj_timer_entry_dup * remove_node( pj_timer_heap_t *ht, size_t slot)
     }
     GET_FIELD(removed_node, _timer_id) = -1;
 
-#if !PJ_TIMER_USE_LINKED_LIST
+#if PJ_TIMER_USE_WHEEL
+    wheel_erase(ht, removed_node);
+#elif !PJ_TIMER_USE_LINKED_LIST
     // Only try to reheapify if we're not deleting the last entry.
 
     if (slot < ht->cur_size)
@@ -382,6 +730,10 @@ static pj_status_t grow_heap(pj_timer_heap_t *ht)
     pj_timer_entry_dup *new_dup;
 #endif
 
+    // The timer id shares its bits with the sub-heap index.
+    if (new_size > TIMER_ID_MASK)
+        return PJ_ETOOMANY;
+
     PJ_LOG(6,(THIS_FILE, "Growing heap size from %lu to %lu",
                          (unsigned long)ht->max_size,
                          (unsigned long)new_size));
@@ -404,12 +756,25 @@ static pj_status_t grow_heap(pj_timer_heap_t *ht)
 
     memcpy(new_timer_dups, ht->timer_dups,
            ht->max_size * sizeof(pj_timer_entry_dup));
+#if PJ_TIMER_USE_WHEEL
+    // The heap is indexed by timer id, and the wheel lists need to be
+    // relinked to the new copies.
+    for (i = 0; i < ht->max_size; i++) {
+        if (ht->heap[i])
+            new_heap[i] = &new_timer_dups[ht->heap[i] - ht->timer_dups];
+    }
+    for (i = 0; i < WHEEL_LEVELS * WHEEL_SLOTS; i++) {
+        wheel_relink(&ht->wheel[0][0] + i, ht->timer_dups, new_timer_dups);
+    }
+    wheel_relink(&ht->expired, ht->timer_dups, new_timer_dups);
+#else
     for (i = 0; i < ht->cur_size; i++) {
         int idx = (int)(ht->heap[i] - ht->timer_dups);
         // Point to the address in the new array
         pj_assert(idx >= 0 && idx < (int)ht->max_size);
         new_heap[i] = &new_timer_dups[idx];
     }
+#endif
     ht->timer_dups = new_timer_dups;
 #else
     memcpy(new_heap, ht->heap, ht->max_size * sizeof(pj_timer_entry *));
@@ -420,7 +785,7 @@ static pj_status_t grow_heap(pj_timer_heap_t *ht)
     pj_list_init(&ht->head_list);
     for (; tmp_dup != &ht->head_list; tmp_dup = tmp_dup->next)
     {
-        int slot = ht->timer_ids[GET_FIELD(tmp_dup, _timer_id)];
+        int slot = ht->timer_ids[TIMER_ID(GET_FIELD(tmp_dup, _timer_id))];
         new_dup = new_heap[slot];
         pj_list_push_back(&ht->head_list, new_dup);
     }
@@ -474,13 +839,18 @@ static pj_status_t insert_node(pj_timer_heap_t *ht,
     timer_copy->entry = new_node;
 #endif
 
-#if PJ_TIMER_USE_LINKED_LIST
+#if PJ_TIMER_USE_LINKED_LIST || PJ_TIMER_USE_WHEEL
     pj_list_init(timer_copy);
 #endif
 
     timer_copy->_timer_value = *future_time;
 
-#if !PJ_TIMER_USE_LINKED_LIST
+#if PJ_TIMER_USE_WHEEL
+    if (ht->cur_size == 0)
+        wheel_reset(ht);
+    wheel_add(ht, timer_copy);
+    copy_node(ht, TIMER_ID(new_node->_timer_id)-1, timer_copy);
+#elif !PJ_TIMER_USE_LINKED_LIST
     reheap_up(ht, timer_copy, ht->cur_size, HEAP_PARENT(ht->cur_size));
 #else
     if (ht->cur_size == 0) {
@@ -503,7 +873,7 @@ static pj_status_t insert_node(pj_timer_heap_t *ht,
             pj_list_insert_after(tmp_node, timer_copy);
         }
     }
-    copy_node(ht, new_node->_timer_id-1, timer_copy);
+    copy_node(ht, TIMER_ID(new_node->_timer_id)-1, timer_copy);
 #endif
     ht->cur_size++;
 
@@ -519,7 +889,8 @@ static pj_status_t schedule_entry( pj_timer_heap_t *ht,
     {
         // Obtain the next unique sequence number.
         // Set the entry
-        entry->_timer_id = pop_freelist(ht);
+        entry->_timer_id = pop_freelist(ht) |
+                           (ht->sub_idx << TIMER_ID_HEAP_SHIFT);
 
         return insert_node( ht, entry, future_time );
     }
@@ -545,7 +916,7 @@ static int cancel( pj_timer_heap_t *ht,
     }
     */
 
-    timer_node_slot = ht->timer_ids[entry->_timer_id];
+    timer_node_slot = ht->timer_ids[TIMER_ID(entry->_timer_id)];
 
     if (timer_node_slot < 0) { // Check to see if timer_id is still valid.
         entry->_timer_id = -1;
@@ -611,6 +982,7 @@ PJ_DEF(pj_status_t) pj_timer_heap_create( pj_pool_t *pool,
     ht->max_entries_per_poll = DEFAULT_MAX_TIMED_OUT_PER_POLL;
     ht->timer_ids_freelist = 1;
     ht->pool = pool;
+    ht->owner = ht;
 
     /* Lock. */
     ht->lock = NULL;
@@ -647,12 +1019,28 @@ PJ_DEF(pj_status_t) pj_timer_heap_create( pj_pool_t *pool,
     pj_list_init(&ht->head_list);
 #endif
 
+#if PJ_TIMER_USE_WHEEL
+    for (i=0; i<WHEEL_LEVELS * WHEEL_SLOTS; ++i)
+        pj_list_init(&ht->wheel[0][0] + i);
+    pj_list_init(&ht->expired);
+    wheel_reset(ht);
+#endif
+
     *p_heap = ht;
     return PJ_SUCCESS;
 }
 
 PJ_DEF(void) pj_timer_heap_destroy( pj_timer_heap_t *ht )
 {
+    if (ht->sub_cnt) {
+        unsigned i;
+
+        for (i = 1; i < ht->sub_cnt; ++i)
+            pj_timer_heap_destroy(ht->sub_heaps[i]);
+        pj_thread_local_free(ht->thread_heap_tls);
+        ht->sub_cnt = 0;
+    }
+
     if (ht->lock && ht->auto_delete_lock) {
         pj_lock_destroy(ht->lock);
         ht->lock = NULL;
@@ -675,10 +1063,80 @@ PJ_DEF(unsigned) pj_timer_heap_set_max_timed_out_per_poll(pj_timer_heap_t *ht,
                                                           unsigned count )
 {
     unsigned old_count = ht->max_entries_per_poll;
+    unsigned i;
+
     ht->max_entries_per_poll = count;
+    for (i = 1; i < ht->sub_cnt; ++i)
+        ht->sub_heaps[i]->max_entries_per_poll = count;
+
     return old_count;
 }
 
+PJ_DEF(pj_status_t) pj_timer_heap_set_thread_heaps(pj_timer_heap_t *ht,
+                                                   unsigned count)
+{
+    pj_timer_heap_t **sub_heaps;
+    pj_status_t status;
+    unsigned i;
+
+    PJ_ASSERT_RETURN(ht && count, PJ_EINVAL);
+    PJ_ASSERT_RETURN(count <= TIMER_ID_MAX_HEAPS, PJ_ETOOMANY);
+    PJ_ASSERT_RETURN(ht->sub_cnt == 0 && ht->owner == ht, PJ_EINVALIDOP);
+
+    if (count == 1)
+        return PJ_SUCCESS;
+
+    sub_heaps = (pj_timer_heap_t**)
+                pj_pool_calloc(ht->pool, count, sizeof(pj_timer_heap_t*));
+    if (!sub_heaps)
+        return PJ_ENOMEM;
+
+    /* The sub-heaps are polled by different threads, they need a lock */
+    if (!ht->lock) {
+        pj_lock_t *lock;
+
+        status = pj_lock_create_simple_mutex(ht->pool, "tmrheap", &lock);
+        if (status != PJ_SUCCESS)
+            return status;
+        pj_timer_heap_set_lock(ht, lock, PJ_TRUE);
+    }
+
+    sub_heaps[0] = ht;
+    for (i = 1; i < count; ++i) {
+        pj_timer_heap_t *sub;
+        pj_lock_t *lock;
+
+        status = pj_timer_heap_create(ht->pool, ht->max_size / count, &sub);
+        if (status == PJ_SUCCESS) {
+            status = pj_lock_create_simple_mutex(ht->pool, "tmrheap%p",
+                                                 &lock);
+        }
+        if (status != PJ_SUCCESS) {
+            while (--i > 0)
+                pj_timer_heap_destroy(sub_heaps[i]);
+            return status;
+        }
+
+        pj_timer_heap_set_lock(sub, lock, PJ_TRUE);
+        sub->max_entries_per_poll = ht->max_entries_per_poll;
+        sub->owner = ht;
+        sub->sub_idx = i;
+        sub_heaps[i] = sub;
+    }
+
+    status = pj_thread_local_alloc(&ht->thread_heap_tls);
+    if (status != PJ_SUCCESS) {
+        for (i = 1; i < count; ++i)
+            pj_timer_heap_destroy(sub_heaps[i]);
+        return status;
+    }
+
+    ht->sub_heaps = sub_heaps;
+    ht->sub_cnt = count;
+
+    return PJ_SUCCESS;
+}
+
 PJ_DEF(pj_timer_entry*) pj_timer_entry_init( pj_timer_entry *entry,
                                              int id,
                                              void *user_data,
@@ -729,6 +1187,19 @@ static pj_status_t schedule_w_grp_lock(pj_timer_heap_t *ht,
     /* Prevent same entry from being scheduled more than once */
     //PJ_ASSERT_RETURN(entry->_timer_id < 1, PJ_EINVALIDOP);
 
+    /* Keep all entries sharing a group lock in the same sub-heap, and
+     * spread the others by their address.
+     */
+    if (ht->sub_cnt) {
+        unsigned idx;
+
+        if (grp_lock)
+            idx = pj_hash_calc(0, &grp_lock, sizeof(grp_lock)) % ht->sub_cnt;
+        else
+            idx = pj_hash_calc(0, &entry, sizeof(entry)) % ht->sub_cnt;
+        ht = ht->sub_heaps[idx];
+    }
+
     pj_gettickcount(&expires);
     PJ_TIME_VAL_ADD(expires, *delay);
 
@@ -748,6 +1219,12 @@ static pj_status_t schedule_w_grp_lock(pj_timer_heap_t *ht,
 
         if (set_id)
             GET_FIELD(timer_copy, id) = entry->id = id_val;
+
+        /* Pull the sub-heap's poll deadline in, so that it is polled by
+         * another thread if its own thread is not back in time.
+         */
+        if (PJ_TIME_VAL_LT(expires, ht->poll_deadline))
+            ht->poll_deadline = expires;
         timer_copy->_grp_lock = grp_lock;
         if (timer_copy->_grp_lock) {
             pj_grp_lock_add_ref(timer_copy->_grp_lock);
@@ -816,10 +1293,18 @@ static int cancel_timer(pj_timer_heap_t *ht,
 
     PJ_ASSERT_RETURN(ht && entry, PJ_EINVAL);
 
+    if (ht->sub_cnt && entry->_timer_id >= 1 &&
+        TIMER_ID_HEAP(entry->_timer_id) < ht->sub_cnt)
+    {
+        ht = ht->sub_heaps[TIMER_ID_HEAP(entry->_timer_id)];
+    }
+
     lock_timer_heap(ht);
 
     // Check to see if the timer_id is out of range
-    if (entry->_timer_id < 1 || (pj_size_t)entry->_timer_id >= ht->max_size) {
+    if (entry->_timer_id < 1 ||
+        (pj_size_t)TIMER_ID(entry->_timer_id) >= ht->max_size)
+    {
         unlock_timer_heap(ht);
         return 0;
     }
@@ -855,8 +1340,131 @@ PJ_DEF(int) pj_timer_heap_cancel_if_active(pj_timer_heap_t *ht,
     return cancel_timer(ht, entry, F_SET_ID | F_DONT_ASSERT, id_val);
 }
 
-PJ_DEF(unsigned) pj_timer_heap_poll( pj_timer_heap_t *ht, 
-                                     pj_time_val *next_delay )
+/* Check that an entry taken off the heap has not been modified or
+ * deallocated while it was scheduled.
+ */
+static pj_bool_t check_polled_entry(pj_timer_entry_dup *node)
+{
+    pj_timer_entry *entry = GET_ENTRY(node);
+
+    if (GET_FIELD(node, cb) != entry->cb ||
+        GET_FIELD(node, user_data) != entry->user_data)
+    {
+#if PJ_TIMER_DEBUG
+        PJ_LOG(3,(THIS_FILE, "Bug! Polling entry %p from %s line %d has "
+                             "been deallocated without being cancelled",
+                             GET_ENTRY(node),
+                             node->src_file, node->src_line));
+#else
+        PJ_LOG(3,(THIS_FILE, "Bug! Polling entry %p has "
+                             "been deallocated without being cancelled",
+                             GET_ENTRY(node)));
+#endif
+#if ASSERT_IF_ENTRY_DESTROYED
+        pj_assert(node->dup.cb == entry->cb);
+        pj_assert(node->dup.user_data == entry->user_data);
+#endif
+        return PJ_FALSE;
+    }
+
+    return PJ_TRUE;
+}
+
+/* Record when the thread polling this heap is expected to poll it again. */
+static void set_poll_deadline( pj_timer_heap_t *ht, const pj_time_val *now,
+                               const pj_time_val *next_delay )
+{
+    ht->poll_deadline = *next_delay;
+    if (next_delay->sec != PJ_MAXINT32) {
+        ht->poll_deadline = *now;
+        PJ_TIME_VAL_ADD(ht->poll_deadline, *next_delay);
+    }
+}
+
+#if PJ_TIMER_USE_WHEEL
+
+static unsigned poll_heap( pj_timer_heap_t *ht, pj_time_val *next_delay )
+{
+    pj_time_val now;
+    unsigned count;
+
+    PJ_ASSERT_RETURN(ht, 0);
+
+    lock_timer_heap(ht);
+    if (!ht->cur_size && next_delay) {
+        next_delay->sec = next_delay->msec = PJ_MAXINT32;
+        ht->poll_deadline = *next_delay;
+        unlock_timer_heap(ht);
+        return 0;
+    }
+
+    count = 0;
+    pj_gettickcount(&now);
+    wheel_advance(ht, &now);
+
+    /* Expired entries are taken off the wheel one at a time, so that an
+     * entry which is cancelled while another callback runs unlocked is
+     * never called.
+     */
+    while (!pj_list_empty(&ht->expired) &&
+           count < ht->max_entries_per_poll)
+    {
+        pj_timer_entry_dup *node;
+        pj_timer_entry *entry;
+        pj_grp_lock_t *grp_lock;
+        pj_bool_t valid;
+
+        node = (pj_timer_entry_dup*)ht->expired.next;
+        remove_node(ht, ht->timer_ids[TIMER_ID(GET_FIELD(node, _timer_id))]);
+        entry = GET_ENTRY(node);
+
+        ++count;
+
+        grp_lock = node->_grp_lock;
+        node->_grp_lock = NULL;
+        valid = check_polled_entry(node);
+
+        unlock_timer_heap(ht);
+
+        PJ_RACE_ME(5);
+
+        if (valid && entry->cb)
+            (*entry->cb)(ht->owner, entry);
+
+        if (valid && grp_lock)
+            pj_grp_lock_dec_ref(grp_lock);
+
+        lock_timer_heap(ht);
+
+        pj_gettickcount(&now);
+        wheel_advance(ht, &now);
+    }
+
+    if (ht->cur_size && next_delay) {
+        pj_uint64_t now_tick = time_val_to_tick(&now);
+        pj_uint64_t next_tick = wheel_next_tick(ht);
+
+        if (!pj_list_empty(&ht->expired) || next_tick <= now_tick) {
+            next_delay->sec = next_delay->msec = 0;
+        } else if (next_tick == (pj_uint64_t)-1) {
+            next_delay->sec = next_delay->msec = PJ_MAXINT32;
+        } else {
+            next_delay->sec = (long)((next_tick - now_tick) / 1000);
+            next_delay->msec = (long)((next_tick - now_tick) % 1000);
+        }
+    } else if (next_delay) {
+        next_delay->sec = next_delay->msec = PJ_MAXINT32;
+    }
+    if (next_delay)
+        set_poll_deadline(ht, &now, next_delay);
+    unlock_timer_heap(ht);
+
+    return count;
+}
+
+#else   /* PJ_TIMER_USE_WHEEL */
+
+static unsigned poll_heap( pj_timer_heap_t *ht, pj_time_val *next_delay )
 {
     pj_time_val now;
     pj_time_val min_time_node = {0,0};
@@ -868,6 +1476,7 @@ PJ_DEF(unsigned) pj_timer_heap_poll( pj_timer_heap_t *ht,
     lock_timer_heap(ht);
     if (!ht->cur_size && next_delay) {
         next_delay->sec = next_delay->msec = PJ_MAXINT32;
+        ht->poll_deadline = *next_delay;
         unlock_timer_heap(ht);
         return 0;
     }
@@ -877,7 +1486,8 @@ PJ_DEF(unsigned) pj_timer_heap_poll( pj_timer_heap_t *ht,
 
     if (ht->cur_size) {
 #if PJ_TIMER_USE_LINKED_LIST
-        slot = ht->timer_ids[GET_FIELD(ht->head_list.next, _timer_id)];
+        slot = ht->timer_ids[TIMER_ID(GET_FIELD(ht->head_list.next,
+                                                 _timer_id))];
 #endif
         min_time_node = ht->heap[slot]->_timer_value;
     }
@@ -892,38 +1502,20 @@ PJ_DEF(unsigned) pj_timer_heap_poll( pj_timer_heap_t *ht,
         ///Not necessary, even causes problem (see also #2176).
         ///pj_timer_id_t node_timer_id = pop_freelist(ht);
         pj_grp_lock_t *grp_lock;
-        pj_bool_t valid = PJ_TRUE;
+        pj_bool_t valid;
 
         ++count;
 
         grp_lock = node->_grp_lock;
         node->_grp_lock = NULL;
-        if (GET_FIELD(node, cb) != entry->cb ||
-            GET_FIELD(node, user_data) != entry->user_data)
-        {
-            valid = PJ_FALSE;
-#if PJ_TIMER_DEBUG
-            PJ_LOG(3,(THIS_FILE, "Bug! Polling entry %p from %s line %d has "
-                                 "been deallocated without being cancelled",
-                                 GET_ENTRY(node),
-                                 node->src_file, node->src_line));
-#else
-            PJ_LOG(3,(THIS_FILE, "Bug! Polling entry %p has "
-                                 "been deallocated without being cancelled",
-                                 GET_ENTRY(node)));
-#endif
-#if ASSERT_IF_ENTRY_DESTROYED
-            pj_assert(node->dup.cb == entry->cb);
-            pj_assert(node->dup.user_data == entry->user_data);
-#endif
-        }
+        valid = check_polled_entry(node);
 
         unlock_timer_heap(ht);
 
         PJ_RACE_ME(5);
 
         if (valid && entry->cb)
-            (*entry->cb)(ht, entry);
+            (*entry->cb)(ht->owner, entry);
 
         if (valid && grp_lock)
             pj_grp_lock_dec_ref(grp_lock);
@@ -934,7 +1526,8 @@ PJ_DEF(unsigned) pj_timer_heap_poll( pj_timer_heap_t *ht,
 
         if (ht->cur_size) {
 #if PJ_TIMER_USE_LINKED_LIST
-            slot = ht->timer_ids[GET_FIELD(ht->head_list.next, _timer_id)];
+            slot = ht->timer_ids[TIMER_ID(GET_FIELD(ht->head_list.next,
+                                                     _timer_id))];
 #endif
             min_time_node = ht->heap[slot]->_timer_value;
             /* Update now */
@@ -960,20 +1553,103 @@ PJ_DEF(unsigned) pj_timer_heap_poll( pj_timer_heap_t *ht,
     } else if (next_delay) {
         next_delay->sec = next_delay->msec = PJ_MAXINT32;
     }
+    if (next_delay)
+        set_poll_deadline(ht, &now, next_delay);
     unlock_timer_heap(ht);
 
     return count;
 }
 
+#endif  /* PJ_TIMER_USE_WHEEL */
+
+/* Poll the sub-heaps which belong to the calling thread. */
+static unsigned poll_thread_heaps( pj_timer_heap_t *ht,
+                                   pj_time_val *next_delay )
+{
+    pj_time_val now;
+    unsigned idx, thread_cnt, i, count = 0;
+
+    idx = (unsigned)(pj_ssize_t)pj_thread_local_get(ht->thread_heap_tls);
+    if (idx == 0 || idx > ht->sub_cnt) {
+        /* First poll by this thread, assign a sub-heap to it */
+        lock_timer_heap(ht);
+        idx = ht->thread_cnt++ % ht->sub_cnt + 1;
+        unlock_timer_heap(ht);
+
+        pj_thread_local_set(ht->thread_heap_tls, (void*)(pj_ssize_t)idx);
+    }
+    --idx;
+
+    /* Sub-heaps without thread are shared among the assigned threads */
+    thread_cnt = ht->thread_cnt;
+    if (thread_cnt > ht->sub_cnt)
+        thread_cnt = ht->sub_cnt;
+
+    if (next_delay)
+        next_delay->sec = next_delay->msec = PJ_MAXINT32;
+
+    pj_gettickcount(&now);
+
+    for (i = 0; i < ht->sub_cnt; ++i) {
+        pj_timer_heap_t *sub = ht->sub_heaps[i];
+        pj_time_val delay;
+
+        if (i != idx && (i < thread_cnt || i % thread_cnt != idx)) {
+            pj_time_val due;
+
+            /* Not ours, only poll it if its thread is late polling it.
+             * Otherwise make sure we're back in time to take over.
+             */
+            lock_timer_heap(sub);
+            due = sub->poll_deadline;
+            unlock_timer_heap(sub);
+
+            if (due.sec == PJ_MAXINT32)
+                continue;
+
+            due.msec += THREAD_HEAP_GRACE_MSEC;
+            pj_time_val_normalize(&due);
+            if (PJ_TIME_VAL_LT(now, due)) {
+                PJ_TIME_VAL_SUB(due, now);
+                if (next_delay && PJ_TIME_VAL_LT(due, *next_delay))
+                    *next_delay = due;
+                continue;
+            }
+        }
+
+        count += poll_heap(sub, &delay);
+        if (next_delay && PJ_TIME_VAL_LT(delay, *next_delay))
+            *next_delay = delay;
+    }
+
+    return count;
+}
+
+PJ_DEF(unsigned) pj_timer_heap_poll( pj_timer_heap_t *ht, 
+                                     pj_time_val *next_delay )
+{
+    PJ_ASSERT_RETURN(ht, 0);
+
+    if (ht->sub_cnt)
+        return poll_thread_heaps(ht, next_delay);
+
+    return poll_heap(ht, next_delay);
+}
+
 PJ_DEF(pj_size_t) pj_timer_heap_count( pj_timer_heap_t *ht )
 {
-    pj_size_t count;
+    pj_size_t count = 0;
+    unsigned i = 0;
 
     PJ_ASSERT_RETURN(ht, 0);
 
-    lock_timer_heap(ht);
-    count = ht->cur_size;
-    unlock_timer_heap(ht);
+    do {
+        pj_timer_heap_t *sub = ht->sub_cnt ? ht->sub_heaps[i] : ht;
+
+        lock_timer_heap(sub);
+        count += sub->cur_size;
+        unlock_timer_heap(sub);
+    } while (++i < ht->sub_cnt);
 
     return count;
 }
@@ -981,28 +1657,36 @@ PJ_DEF(pj_size_t) pj_timer_heap_count( pj_timer_heap_t *ht )
 PJ_DEF(pj_status_t) pj_timer_heap_earliest_time( pj_timer_heap_t * ht,
                                                  pj_time_val *timeval)
 {
-    pj_status_t status;
+    pj_status_t status = PJ_ENOTFOUND;
+    unsigned i = 0;
 
-    lock_timer_heap(ht);
+    do {
+        pj_timer_heap_t *sub = ht->sub_cnt ? ht->sub_heaps[i] : ht;
+        pj_time_val earliest;
 
-    if (ht->cur_size == 0) {
-        status = PJ_ENOTFOUND;
-    } else {
-#if PJ_TIMER_USE_LINKED_LIST
-        *timeval = ht->head_list.next->_timer_value;
+        lock_timer_heap(sub);
+
+        if (sub->cur_size) {
+#if PJ_TIMER_USE_WHEEL
+            earliest = wheel_earliest(sub)->_timer_value;
+#elif PJ_TIMER_USE_LINKED_LIST
+            earliest = sub->head_list.next->_timer_value;
 #else
-        *timeval = ht->heap[0]->_timer_value;
+            earliest = sub->heap[0]->_timer_value;
 #endif
-        status = PJ_SUCCESS;
-    }
+            if (status != PJ_SUCCESS || PJ_TIME_VAL_LT(earliest, *timeval))
+                *timeval = earliest;
+            status = PJ_SUCCESS;
+        }
 
-    unlock_timer_heap(ht);
+        unlock_timer_heap(sub);
+    } while (++i < ht->sub_cnt);
 
     return status;
 }
 
 #if PJ_TIMER_DEBUG
-PJ_DEF(void) pj_timer_heap_dump(pj_timer_heap_t *ht)
+static void dump_heap(pj_timer_heap_t *ht)
 {
     lock_timer_heap(ht);
 
@@ -1024,7 +1708,15 @@ PJ_DEF(void) pj_timer_heap_dump(pj_timer_heap_t *ht)
 
         pj_gettickcount(&now);
 
-#if !PJ_TIMER_USE_LINKED_LIST
+#if PJ_TIMER_USE_WHEEL
+        for (i=1; i<(unsigned)ht->max_size; ++i)
+        {
+            pj_timer_entry_dup *e;
+
+            if (ht->timer_ids[i] < 0)
+                continue;
+            e = ht->heap[ht->timer_ids[i]];
+#elif !PJ_TIMER_USE_LINKED_LIST
         for (i=0; i<(unsigned)ht->cur_size; ++i)
         {
             pj_timer_entry_dup *e = ht->heap[i];
@@ -1053,5 +1745,19 @@ PJ_DEF(void) pj_timer_heap_dump(pj_timer_heap_t *ht)
 
     unlock_timer_heap(ht);
 }
-#endif
 
+PJ_DEF(void) pj_timer_heap_dump(pj_timer_heap_t *ht)
+{
+    unsigned i;
+
+    if (ht->sub_cnt == 0) {
+        dump_heap(ht);
+        return;
+    }
+
+    for (i = 0; i < ht->sub_cnt; ++i) {
+        PJ_LOG(3,(THIS_FILE, "Sub-heap %d of %d:", i+1, ht->sub_cnt));
+        dump_heap(ht->sub_heaps[i]);
+    }
+}
+#endif
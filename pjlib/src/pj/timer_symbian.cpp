@@ -350,6 +350,15 @@ PJ_DEF(unsigned) pj_timer_heap_set_max_timed_out_per_poll(pj_timer_heap_t *ht,
     return ht->max_size;
 }
 
+PJ_DEF(pj_status_t) pj_timer_heap_set_thread_heaps(pj_timer_heap_t *ht,
+                                                   unsigned count)
+{
+    /* Not applicable */
+    PJ_UNUSED_ARG(ht);
+    PJ_UNUSED_ARG(count);
+    return PJ_ENOTSUP;
+}
+
 PJ_DEF(pj_timer_entry*) pj_timer_entry_init( pj_timer_entry *entry,
                                              int id,
                                              void *user_data,
@@ -625,6 +625,70 @@ on_error:
     return rc;
 }
 
+/* Test receiving several datagrams with one pj_sock_recvmmsg() call. */
+static int recvmmsg_test(pj_sock_t ss, pj_sock_t cs,
+                         const pj_sockaddr_in *dstaddr,
+                         const pj_sockaddr_in *srcaddr)
+{
+    enum { CNT = 4, PKT_LEN = 100 };
+    char rxbuf[CNT][PKT_LEN];
+    pj_sockaddr_in addr[CNT];
+    pj_sock_mmsg msg[CNT];
+    unsigned i, cnt;
+    pj_status_t rc;
+
+    PJ_LOG(3,("test", "...recvmmsg_test()"));
+
+    for (i=0; i<CNT; ++i) {
+        pj_ssize_t len = PKT_LEN - i;
+
+        rc = pj_sock_sendto(cs, bigdata + i, &len, 0, dstaddr,
+                            sizeof(*dstaddr));
+        if (rc != PJ_SUCCESS) {
+            app_perror("...sendto error", rc);
+            return -170;
+        }
+    }
+
+    for (i=0; i<CNT; ++i) {
+        msg[i].buf = rxbuf[i];
+        msg[i].len = PKT_LEN;
+        msg[i].addr = &addr[i];
+        msg[i].addr_len = sizeof(addr[i]);
+    }
+
+    /* Socket is blocking, so this returns once all CNT have arrived */
+    cnt = CNT;
+    rc = pj_sock_recvmmsg(ss, msg, &cnt, 0);
+    if (rc != PJ_SUCCESS) {
+        app_perror("...recvmmsg error", rc);
+        return -171;
+    }
+
+    /* The emulation may return early, get the rest one by one */
+    while (cnt < CNT) {
+        unsigned one = 1;
+
+        rc = pj_sock_recvmmsg(ss, &msg[cnt], &one, 0);
+        if (rc != PJ_SUCCESS || one != 1) {
+            app_perror("...recvmmsg error", rc);
+            return -172;
+        }
+        cnt += one;
+    }
+
+    for (i=0; i<CNT; ++i) {
+        if (msg[i].len != (pj_ssize_t)(PKT_LEN - i))
+            return -173;
+        if (pj_memcmp(rxbuf[i], bigdata + i, msg[i].len) != 0)
+            return -174;
+        if (pj_sockaddr_cmp(&addr[i], srcaddr) != 0)
+            return -175;
+    }
+
+    return 0;
+}
+
 static int udp_test(void)
 {
     pj_sock_t cs = PJ_INVALID_SOCKET, ss = PJ_INVALID_SOCKET;
@@ -694,6 +758,11 @@ static int udp_test(void)
     if (rc != 0)
         goto on_error;
 
+    /* Test batched receive */
+    rc = recvmmsg_test(ss, cs, &dstaddr, &srcaddr);
+    if (rc != 0)
+        goto on_error;
+
     /* Disable this test on Symbian since UDP connect()/send() failed
      * with S60 3rd edition (including MR2).
      * See https://github.com/pjsip/pjproject/issues/264
@@ -145,6 +145,122 @@ static int sock_producer_consumer(int sock_type,
     return 0;
 }
 
+/*
+ * sock_pps()
+ *
+ * Packet rate benchmarking with small (RTP sized) UDP packets. Send and
+ * receive loop number of packets, either with one system call per packet
+ * (batch_cnt==1), or in batches of batch_cnt packets with
+ * pj_sock_sendmmsg() and pj_sock_recvmmsg().
+ */
+static int sock_pps(pj_size_t pkt_size, unsigned batch_cnt, unsigned loop,
+                    unsigned *p_pps)
+{
+    enum { MAX_BATCH = 32 };
+    pj_sock_t consumer, producer;
+    pj_pool_t *pool;
+    char *outgoing_buffer, *incoming_buffer;
+    pj_sock_mmsg tx_msg[MAX_BATCH], rx_msg[MAX_BATCH];
+    pj_timestamp start, stop;
+    pj_highprec_t elapsed, pps;
+    unsigned i, j, total_received;
+    pj_status_t rc;
+
+    PJ_ASSERT_RETURN(batch_cnt > 0 && batch_cnt <= MAX_BATCH, -1);
+
+    pool = pj_pool_create(mem, NULL, 4096, 4096, NULL);
+    if (!pool)
+        return -10;
+
+    rc = app_socketpair(pj_AF_INET(), pj_SOCK_DGRAM(), 0, &consumer,
+                        &producer);
+    if (rc != PJ_SUCCESS) {
+        app_perror("...error: create socket pair", rc);
+        pj_pool_release(pool);
+        return -20;
+    }
+
+    outgoing_buffer = (char*) pj_pool_zalloc(pool, pkt_size * batch_cnt);
+    incoming_buffer = (char*) pj_pool_alloc(pool, pkt_size * batch_cnt);
+
+    pj_get_timestamp(&start);
+    total_received = 0;
+    for (i=0; i<loop; i+=batch_cnt) {
+        unsigned cnt;
+
+        if (batch_cnt == 1) {
+            pj_ssize_t len = pkt_size;
+
+            rc = pj_sock_send(producer, outgoing_buffer, &len, 0);
+            if (rc != PJ_SUCCESS) {
+                app_perror("...error: send()", rc);
+                rc = -30; goto on_return;
+            }
+
+            len = pkt_size;
+            rc = pj_sock_recv(consumer, incoming_buffer, &len, 0);
+            if (rc != PJ_SUCCESS || len != (pj_ssize_t)pkt_size) {
+                app_perror("...error: recv()", rc);
+                rc = -40; goto on_return;
+            }
+            ++total_received;
+            continue;
+        }
+
+        for (j=0; j<batch_cnt; ++j) {
+            tx_msg[j].buf = outgoing_buffer + j * pkt_size;
+            tx_msg[j].len = pkt_size;
+            tx_msg[j].addr = NULL;
+            tx_msg[j].addr_len = 0;
+        }
+        cnt = batch_cnt;
+        rc = pj_sock_sendmmsg(producer, tx_msg, &cnt, 0);
+        if (rc != PJ_SUCCESS || cnt != batch_cnt) {
+            app_perror("...error: sendmmsg()", rc);
+            rc = -50; goto on_return;
+        }
+
+        /* Socket is blocking, receive until the whole batch has arrived */
+        for (j=0; j<batch_cnt; j+=cnt) {
+            unsigned k;
+
+            for (k=j; k<batch_cnt; ++k) {
+                rx_msg[k].buf = incoming_buffer + k * pkt_size;
+                rx_msg[k].len = pkt_size;
+                rx_msg[k].addr = NULL;
+                rx_msg[k].addr_len = 0;
+            }
+            cnt = batch_cnt - j;
+            rc = pj_sock_recvmmsg(consumer, &rx_msg[j], &cnt, 0);
+            if (rc != PJ_SUCCESS || cnt == 0) {
+                app_perror("...error: recvmmsg()", rc);
+                rc = -60; goto on_return;
+            }
+            total_received += cnt;
+        }
+    }
+    rc = 0;
+
+    pj_get_timestamp(&stop);
+    elapsed = pj_elapsed_usec(&start, &stop);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    /* pps = total_received * 1000000 / elapsed */
+    pps = total_received;
+    pj_highprec_mul(pps, 1000000);
+    pj_highprec_div(pps, elapsed);
+
+    *p_pps = (unsigned)pps;
+
+on_return:
+    pj_sock_close(consumer);
+    pj_sock_close(producer);
+    pj_pool_release(pool);
+
+    return rc;
+}
+
 /*
  * sock_perf_test()
  *
@@ -168,6 +284,22 @@ int sock_perf_test(void)
     rc = sock_producer_consumer(pj_SOCK_DGRAM(), 512, LOOP, &bandwidth);
     if (rc != 0) return rc;
     PJ_LOG(3,("", "....bandwidth UDP = %d KB/s", bandwidth));
+
+    /* Benchmarking UDP packet rate with RTP sized packets */
+    {
+        const unsigned batch[] = { 1, 8, 32 };
+        unsigned i, pps;
+
+        PJ_LOG(3,("", "...benchmarking UDP packet rate (packet=172, "
+                      "recvmmsg=%d, sendmmsg=%d):",
+                  PJ_HAS_RECVMMSG, PJ_HAS_SENDMMSG));
+
+        for (i=0; i<PJ_ARRAY_SIZE(batch); ++i) {
+            rc = sock_pps(172, batch[i], LOOP, &pps);
+            if (rc != 0) return rc;
+            PJ_LOG(3,("", "....batch=%2d: %u pkt/s", batch[i], pps));
+        }
+    }
 #endif
 
     /* Benchmarking TCP */
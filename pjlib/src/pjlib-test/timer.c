@@ -182,6 +182,208 @@ static int test_timer_heap(void)
 }
 
 
+/*********************
+ * Thread heaps test *
+ *********************
+ * Split the timer heap into per-thread sub-heaps and start the polling
+ * threads. Once all threads have polled, schedule entries with several
+ * group locks, cancel some of them, and let the threads poll the rest.
+ * Entries sharing a group lock must always be run by the same thread.
+ */
+#define TH_THREAD_COUNT     4
+#define TH_GRP_LOCK_COUNT   16
+#define TH_ENTRY_COUNT      256
+#define TH_MAX_DELAY_MS     200
+
+static struct th_param
+{
+    pj_timer_heap_t *timer;
+    pj_bool_t        stopping;
+    pj_atomic_t     *n_started;
+    pj_atomic_t     *n_fired;
+    pj_thread_t     *grp_thread[TH_GRP_LOCK_COUNT];
+    int              err;
+} th_param;
+
+static void th_entry_callback(pj_timer_heap_t *ht, pj_timer_entry *e)
+{
+    unsigned grp_idx = (unsigned)(pj_ssize_t)e->user_data;
+    pj_thread_t *this_thread = pj_thread_this();
+
+    if (ht != th_param.timer) {
+        PJ_LOG(3,("test", "...error: callback called with sub-heap"));
+        th_param.err = -100;
+    }
+
+    if (th_param.grp_thread[grp_idx] == NULL) {
+        th_param.grp_thread[grp_idx] = this_thread;
+    } else if (th_param.grp_thread[grp_idx] != this_thread) {
+        PJ_LOG(3,("test", "...error: entries of group lock %d are run by "
+                          "different threads", grp_idx));
+        th_param.err = -110;
+    }
+
+    pj_atomic_inc(th_param.n_fired);
+}
+
+static int th_poll_worker(void *arg)
+{
+    PJ_UNUSED_ARG(arg);
+
+    /* The first poll assigns a sub-heap to this thread */
+    pj_timer_heap_poll(th_param.timer, NULL);
+    pj_atomic_inc(th_param.n_started);
+
+    while (!th_param.stopping) {
+        pj_timer_heap_poll(th_param.timer, NULL);
+        pj_thread_sleep(1);
+    }
+
+    return 0;
+}
+
+static int test_thread_heaps(void)
+{
+    pj_pool_t *pool;
+    pj_grp_lock_t *grp_locks[TH_GRP_LOCK_COUNT];
+    pj_thread_t *threads[TH_THREAD_COUNT];
+    pj_timer_entry *entries;
+    pj_time_val delay;
+    pj_status_t status;
+    unsigned i, expected, n_grp_lock = 0, n_thread = 0;
+    int err = 0;
+
+    PJ_LOG(3,("test", "...Thread heaps test"));
+
+    pj_bzero(&th_param, sizeof(th_param));
+
+    pool = pj_pool_create(mem, NULL, 4000, 4000, NULL);
+    if (!pool)
+        return -10;
+
+    status = pj_timer_heap_create(pool, TH_ENTRY_COUNT, &th_param.timer);
+    if (status != PJ_SUCCESS) {
+        app_perror("...error: unable to create timer heap", status);
+        err = -20;
+        goto on_return;
+    }
+
+    status = pj_timer_heap_set_thread_heaps(th_param.timer, TH_THREAD_COUNT);
+    if (status != PJ_SUCCESS) {
+        app_perror("...error: unable to set thread heaps", status);
+        err = -30;
+        goto on_return;
+    }
+
+    status = pj_atomic_create(pool, 0, &th_param.n_started);
+    if (status == PJ_SUCCESS)
+        status = pj_atomic_create(pool, 0, &th_param.n_fired);
+    if (status != PJ_SUCCESS) {
+        err = -40;
+        goto on_return;
+    }
+
+    for (n_grp_lock = 0; n_grp_lock < TH_GRP_LOCK_COUNT; ++n_grp_lock) {
+        status = pj_grp_lock_create(pool, NULL, &grp_locks[n_grp_lock]);
+        if (status != PJ_SUCCESS) {
+            app_perror("...error: unable to create group lock", status);
+            err = -50;
+            goto on_return;
+        }
+        pj_grp_lock_add_ref(grp_locks[n_grp_lock]);
+    }
+
+    for (n_thread = 0; n_thread < TH_THREAD_COUNT; ++n_thread) {
+        status = pj_thread_create(pool, "thpoll", &th_poll_worker, NULL, 0, 0,
+                                  &threads[n_thread]);
+        if (status != PJ_SUCCESS) {
+            app_perror("...error: unable to create thread", status);
+            err = -55;
+            goto on_return;
+        }
+    }
+
+    while (pj_atomic_get(th_param.n_started) < TH_THREAD_COUNT)
+        pj_thread_sleep(10);
+
+    /* Schedule the entries and cancel every fourth one */
+    entries = (pj_timer_entry*)pj_pool_calloc(pool, TH_ENTRY_COUNT,
+                                              sizeof(*entries));
+    expected = TH_ENTRY_COUNT;
+    for (i = 0; i < TH_ENTRY_COUNT; ++i) {
+        unsigned grp_idx = i % TH_GRP_LOCK_COUNT;
+
+        pj_timer_entry_init(&entries[i], 0, (void*)(pj_ssize_t)grp_idx,
+                            &th_entry_callback);
+        delay.sec = 0;
+        delay.msec = pj_rand() % TH_MAX_DELAY_MS;
+        status = pj_timer_heap_schedule_w_grp_lock(th_param.timer,
+                                                   &entries[i], &delay, 1,
+                                                   grp_locks[grp_idx]);
+        if (status != PJ_SUCCESS) {
+            app_perror("...error: unable to schedule timer entry", status);
+            err = -60;
+            goto on_return;
+        }
+    }
+    for (i = 0; i < TH_ENTRY_COUNT; i += 4) {
+        if (pj_timer_heap_cancel(th_param.timer, &entries[i]) != 1) {
+            PJ_LOG(3,("test", "...error: unable to cancel entry %d", i));
+            err = -70;
+            goto on_return;
+        }
+        --expected;
+    }
+    if (pj_timer_heap_count(th_param.timer) != expected) {
+        PJ_LOG(3,("test", "...error: invalid timer count %lu, expecting %d",
+                  (unsigned long)pj_timer_heap_count(th_param.timer),
+                  expected));
+        err = -80;
+        goto on_return;
+    }
+
+    /* Wait until all entries have fired, for up to 2 seconds */
+    for (i = 0; i < 200; ++i) {
+        if (pj_atomic_get(th_param.n_fired) == (pj_atomic_value_t)expected)
+            break;
+        pj_thread_sleep(10);
+    }
+
+on_return:
+    th_param.stopping = PJ_TRUE;
+    while (n_thread > 0) {
+        --n_thread;
+        pj_thread_join(threads[n_thread]);
+        pj_thread_destroy(threads[n_thread]);
+    }
+
+    if (!err && th_param.err)
+        err = th_param.err;
+
+    if (!err &&
+        (pj_atomic_get(th_param.n_fired) != (pj_atomic_value_t)expected ||
+         pj_timer_heap_count(th_param.timer) != 0))
+    {
+        PJ_LOG(3,("test", "...error: %ld of %d entries fired, %lu left",
+                  (long)pj_atomic_get(th_param.n_fired), expected,
+                  (unsigned long)pj_timer_heap_count(th_param.timer)));
+        err = -120;
+    }
+
+    while (n_grp_lock > 0)
+        pj_grp_lock_dec_ref(grp_locks[--n_grp_lock]);
+    if (th_param.n_started)
+        pj_atomic_destroy(th_param.n_started);
+    if (th_param.n_fired)
+        pj_atomic_destroy(th_param.n_fired);
+    if (th_param.timer)
+        pj_timer_heap_destroy(th_param.timer);
+    pj_pool_safe_release(&pool);
+
+    return err;
+}
+
+
 /***************
  * Stress test *
  ***************
@@ -247,6 +449,13 @@ static int test_timer_heap(void)
 #define BT_REPEAT_RANDOM_TEST 4
 #define BT_REPEAT_INC_TEST 4
 
+/* Throughput test with large number of outstanding entries, e.g. the
+ * retransmission and timeout timers of a busy SIP server.
+ */
+#define TP_ENTRY_COUNT 1000000
+#define TP_MAX_DELAY_MS 32000
+#define TP_EXPIRE_DELAY_MS 500
+
 struct thread_param
 {
     pj_timer_heap_t *timer;
@@ -961,6 +1170,132 @@ static int timer_bench_test(void)
     return err;
 }
 
+static void tp_print_rate(const char *title, pj_timestamp freq,
+                          const pj_timestamp *t1, unsigned count)
+{
+    char num_str[64];
+    pj_timestamp t2;
+    unsigned rate;
+
+    pj_get_timestamp(&t2);
+    pj_sub_timestamp(&t2, t1);
+    if (t2.u64 == 0)
+        t2.u64 = 1;
+
+    rate = (unsigned)(freq.u64 * count / t2.u64);
+    get_format_num(rate, num_str);
+    PJ_LOG(3,("test", "    %s: %s ent/sec", title, num_str));
+}
+
+static int timer_throughput_test(void)
+{
+    pj_pool_t *pool = NULL;
+    pj_timer_heap_t *timer = NULL;
+    pj_timer_entry *entries;
+    pj_timestamp freq, t1;
+    pj_time_val delay;
+    pj_status_t status;
+    unsigned i, cnt;
+    int err = 0;
+
+    PJ_LOG(3,("test", "...Throughput test with %d entries (%s)",
+              TP_ENTRY_COUNT,
+              (PJ_TIMER_USE_WHEEL ? "timing wheel" :
+               (PJ_TIMER_USE_LINKED_LIST ? "linked list" : "binary heap"))));
+
+    if (PJ_TIMER_USE_LINKED_LIST) {
+        PJ_LOG(3,("test", "....skipped, too slow with linked list"));
+        return 0;
+    }
+
+    status = pj_get_timestamp_freq(&freq);
+    if (status != PJ_SUCCESS) {
+        app_perror("...error: unable to get timestamp freq", status);
+        return -10;
+    }
+
+    pool = pj_pool_create(mem, NULL, 4000, 4000, NULL);
+    if (!pool)
+        return -20;
+
+    status = pj_timer_heap_create(pool, TP_ENTRY_COUNT, &timer);
+    if (status != PJ_SUCCESS) {
+        app_perror("...error: unable to create timer heap", status);
+        err = -30;
+        goto on_return;
+    }
+    pj_timer_heap_set_max_timed_out_per_poll(timer, TP_ENTRY_COUNT);
+
+    entries = (pj_timer_entry*)pj_pool_calloc(pool, TP_ENTRY_COUNT,
+                                              sizeof(*entries));
+    if (!entries) {
+        err = -40;
+        goto on_return;
+    }
+    for (i = 0; i < TP_ENTRY_COUNT; ++i)
+        pj_timer_entry_init(&entries[i], 0, NULL, &timer_callback);
+
+    /* Schedule all entries with random delays, then cancel them */
+    pj_get_timestamp(&t1);
+    for (i = 0; i < TP_ENTRY_COUNT; ++i) {
+        delay.sec = 0;
+        delay.msec = TP_EXPIRE_DELAY_MS + pj_rand() % TP_MAX_DELAY_MS;
+        pj_time_val_normalize(&delay);
+        status = pj_timer_heap_schedule(timer, &entries[i], &delay);
+        if (status != PJ_SUCCESS) {
+            app_perror("...error: unable to schedule timer entry", status);
+            err = -50;
+            goto on_return;
+        }
+    }
+    tp_print_rate("schedule", freq, &t1, TP_ENTRY_COUNT);
+
+    pj_get_timestamp(&t1);
+    for (i = 0; i < TP_ENTRY_COUNT; ++i) {
+        if (pj_timer_heap_cancel(timer, &entries[i]) != 1) {
+            PJ_LOG(3,("test", "...error: unable to cancel timer entry"));
+            err = -60;
+            goto on_return;
+        }
+    }
+    tp_print_rate("cancel", freq, &t1, TP_ENTRY_COUNT);
+
+    /* Schedule all entries to expire within a short period, wait until
+     * they're all due, and measure how fast the poll dispatches them.
+     */
+    for (i = 0; i < TP_ENTRY_COUNT; ++i) {
+        delay.sec = 0;
+        delay.msec = pj_rand() % TP_EXPIRE_DELAY_MS;
+        status = pj_timer_heap_schedule(timer, &entries[i], &delay);
+        if (status != PJ_SUCCESS) {
+            app_perror("...error: unable to schedule timer entry", status);
+            err = -70;
+            goto on_return;
+        }
+    }
+    pj_thread_sleep(TP_EXPIRE_DELAY_MS + 100);
+
+    cnt = 0;
+    pj_get_timestamp(&t1);
+    while (pj_timer_heap_count(timer) > 0) {
+        unsigned n = pj_timer_heap_poll(timer, NULL);
+        if (n == 0) {
+            PJ_LOG(3,("test", "...error: %lu entries not expired",
+                      (unsigned long)pj_timer_heap_count(timer)));
+            err = -80;
+            goto on_return;
+        }
+        cnt += n;
+    }
+    tp_print_rate("poll", freq, &t1, cnt);
+
+on_return:
+    if (timer)
+        pj_timer_heap_destroy(timer);
+    pj_pool_safe_release(&pool);
+    return err;
+}
+
 int timer_test()
 {
     int rc;
@@ -969,6 +1304,10 @@ int timer_test()
     if (rc != 0)
         return rc;
 
+    rc = test_thread_heaps();
+    if (rc != 0)
+        return rc;
+
     rc = timer_stress_test();
     if (rc != 0)
         return rc;
@@ -977,9 +1316,14 @@ int timer_test()
     rc = timer_bench_test();
     if (rc != 0)
         return rc;
+
+    rc = timer_throughput_test();
+    if (rc != 0)
+        return rc;
 #else
     /* Avoid unused warning */
     PJ_UNUSED_ARG(timer_bench_test);
+    PJ_UNUSED_ARG(timer_throughput_test);
 #endif
 
     return 0;
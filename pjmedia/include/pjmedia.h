@@ -45,7 +45,9 @@
 #include <pjmedia/jbuf.h>
 #include <pjmedia/master_port.h>
 #include <pjmedia/mem_port.h>
+#include <pjmedia/mix_kernel.h>
 #include <pjmedia/null_port.h>
+#include <pjmedia/pkt_buf.h>
 #include <pjmedia/plc.h>
 #include <pjmedia/port.h>
 #include <pjmedia/resample.h>
@@ -62,6 +64,7 @@
 #include <pjmedia/stereo.h>
 #include <pjmedia/stream.h>
 #include <pjmedia/stream_common.h>
+#include <pjmedia/tick_pool.h>
 #include <pjmedia/tonegen.h>
 #include <pjmedia/transport.h>
 #include <pjmedia/transport_adapter_sample.h>
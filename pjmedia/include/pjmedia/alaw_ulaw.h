@@ -139,72 +139,120 @@ PJ_DECL(unsigned char) pjmedia_ulaw2alaw(unsigned char uval);
 #endif
 
 /**
- * Encode 16-bit linear PCM data to 8-bit U-Law data.
+ * G.711 block conversion implementations.
+ */
+typedef enum pjmedia_g711_kernel_type
+{
+    /** The best implementation supported by the running CPU. */
+    PJMEDIA_G711_KERNEL_AUTO,
+
+    /** Portable C implementation, converting one sample at a time. */
+    PJMEDIA_G711_KERNEL_SCALAR,
+
+    /** x86 SSE2 implementation. */
+    PJMEDIA_G711_KERNEL_SSE2,
+
+    /** x86 AVX2 implementation. */
+    PJMEDIA_G711_KERNEL_AVX2,
+
+    /** ARM NEON implementation. */
+    PJMEDIA_G711_KERNEL_NEON
+
+} pjmedia_g711_kernel_type;
+
+
+/**
+ * A set of G.711 block conversion functions. The SIMD implementations
+ * compute the conversions arithmetically and give the same results as
+ * the conversion tables (see #PJMEDIA_HAS_ALAW_ULAW_TABLE). All functions
+ * accept any count of samples and any alignment of the buffers.
+ */
+typedef struct pjmedia_g711_kernel
+{
+    /** Implementation type. */
+    pjmedia_g711_kernel_type type;
+
+    /** Implementation name, e.g. "sse2". */
+    const char *name;
+
+    /** Encode 16-bit linear PCM samples to U-Law, see
+     *  #pjmedia_ulaw_encode(). */
+    void (*ulaw_encode)(pj_uint8_t *dst, const pj_int16_t *src,
+                        pj_size_t count);
+
+    /** Encode 16-bit linear PCM samples to A-Law, see
+     *  #pjmedia_alaw_encode(). */
+    void (*alaw_encode)(pj_uint8_t *dst, const pj_int16_t *src,
+                        pj_size_t count);
+
+    /** Decode U-Law data to 16-bit linear PCM samples, see
+     *  #pjmedia_ulaw_decode(). */
+    void (*ulaw_decode)(pj_int16_t *dst, const pj_uint8_t *src,
+                        pj_size_t len);
+
+    /** Decode A-Law data to 16-bit linear PCM samples, see
+     *  #pjmedia_alaw_decode(). */
+    void (*alaw_decode)(pj_int16_t *dst, const pj_uint8_t *src,
+                        pj_size_t len);
+
+} pjmedia_g711_kernel;
+
+
+/**
+ * Get a G.711 block conversion implementation.
+ *
+ * @param type      The implementation, or #PJMEDIA_G711_KERNEL_AUTO to
+ *                  select the best one for the running CPU.
+ *
+ * @return          The implementation, or NULL if it is not built in or
+ *                  not supported by the CPU.
+ */
+PJ_DECL(const pjmedia_g711_kernel*)
+pjmedia_g711_kernel_get(pjmedia_g711_kernel_type type);
+
+/**
+ * Encode 16-bit linear PCM data to 8-bit U-Law data, using the best
+ * implementation for the running CPU.
  *
  * @param dst       Destination buffer for 8-bit U-Law data.
  * @param src       Source, 16-bit linear PCM data.
  * @param count     Number of samples.
  */
-PJ_INLINE(void) pjmedia_ulaw_encode(pj_uint8_t *dst, const pj_int16_t *src, 
-                                    pj_size_t count)
-{
-    const pj_int16_t *end = src + count;
-    
-    while (src < end) {
-        *dst++ = pjmedia_linear2ulaw(*src++);
-    }
-}
+PJ_DECL(void) pjmedia_ulaw_encode(pj_uint8_t *dst, const pj_int16_t *src,
+                                  pj_size_t count);
 
 /**
- * Encode 16-bit linear PCM data to 8-bit A-Law data.
+ * Encode 16-bit linear PCM data to 8-bit A-Law data, using the best
+ * implementation for the running CPU.
  *
  * @param dst       Destination buffer for 8-bit A-Law data.
  * @param src       Source, 16-bit linear PCM data.
  * @param count     Number of samples.
  */
-PJ_INLINE(void) pjmedia_alaw_encode(pj_uint8_t *dst, const pj_int16_t *src, 
-                                    pj_size_t count)
-{
-    const pj_int16_t *end = src + count;
-    
-    while (src < end) {
-        *dst++ = pjmedia_linear2alaw(*src++);
-    }
-}
+PJ_DECL(void) pjmedia_alaw_encode(pj_uint8_t *dst, const pj_int16_t *src,
+                                  pj_size_t count);
 
 /**
- * Decode 8-bit U-Law data to 16-bit linear PCM data.
+ * Decode 8-bit U-Law data to 16-bit linear PCM data, using the best
+ * implementation for the running CPU.
  *
  * @param dst       Destination buffer for 16-bit PCM data.
  * @param src       Source, 8-bit U-Law data.
  * @param len       Encoded frame/source length in bytes.
  */
-PJ_INLINE(void) pjmedia_ulaw_decode(pj_int16_t *dst, const pj_uint8_t *src, 
-                                    pj_size_t len)
-{
-    const pj_uint8_t *end = src + len;
-    
-    while (src < end) {
-        *dst++ = pjmedia_ulaw2linear(*src++);
-    }
-}
+PJ_DECL(void) pjmedia_ulaw_decode(pj_int16_t *dst, const pj_uint8_t *src,
+                                  pj_size_t len);
 
 /**
- * Decode 8-bit A-Law data to 16-bit linear PCM data.
+ * Decode 8-bit A-Law data to 16-bit linear PCM data, using the best
+ * implementation for the running CPU.
  *
  * @param dst       Destination buffer for 16-bit PCM data.
  * @param src       Source, 8-bit A-Law data.
  * @param len       Encoded frame/source length in bytes.
  */
-PJ_INLINE(void) pjmedia_alaw_decode(pj_int16_t *dst, const pj_uint8_t *src, 
-                                    pj_size_t len)
-{
-    const pj_uint8_t *end = src + len;
-    
-    while (src < end) {
-        *dst++ = pjmedia_alaw2linear(*src++);
-    }
-}
+PJ_DECL(void) pjmedia_alaw_decode(pj_int16_t *dst, const pj_uint8_t *src,
+                                  pj_size_t len);
 
 PJ_END_DECL
 
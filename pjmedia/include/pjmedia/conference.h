@@ -92,6 +92,29 @@ typedef struct pjmedia_conf_port_info
     int                 rx_adj_level;       /**< Rx level adjustment.       */
 } pjmedia_conf_port_info;
 
+/**
+ * Processing statistics of a conference bridge thread, see
+ * #pjmedia_conf_get_thread_stat().
+ */
+typedef struct pjmedia_conf_thread_stat
+{
+    pj_uint64_t         ticks;              /**< Number of clock ticks.     */
+    pj_uint64_t         tasks;              /**< Number of ports processed,
+                                                 i.e. received from or
+                                                 transmitted to.            */
+    pj_uint64_t         stolen;             /**< Number of tasks taken from
+                                                 the queue of another
+                                                 thread.                    */
+    pj_uint64_t         total_busy_usec;    /**< Total processing time.     */
+    pj_uint64_t         total_wait_usec;    /**< Total time waiting for the
+                                                 other threads to finish
+                                                 receiving from the ports.  */
+    unsigned            last_busy_usec;     /**< Processing time of the last
+                                                 tick.                      */
+    unsigned            max_busy_usec;      /**< Longest processing time of
+                                                 a tick.                    */
+} pjmedia_conf_thread_stat;
+
 /** 
  * Conference operation type enumeration.
  */
@@ -225,8 +248,20 @@ enum pjmedia_conf_option
                                      microphone device.                     */
     PJMEDIA_CONF_NO_DEVICE = 2, /**< Do not create sound device.            */
     PJMEDIA_CONF_SMALL_FILTER=4,/**< Use small filter table when resampling */
-    PJMEDIA_CONF_USE_LINEAR=8   /**< Use linear resampling instead of filter
+    PJMEDIA_CONF_USE_LINEAR=8,  /**< Use linear resampling instead of filter
                                      based.                                 */
+    PJMEDIA_CONF_MIX_MINUS=16   /**< Mix-minus mode: compute one sum of all
+                                     talkers per clock tick and derive the
+                                     signal of each listener which hears
+                                     every other source as the sum minus its
+                                     own contribution. Connection level
+                                     adjustments are applied as correction
+                                     terms. This turns the mixing cost of a
+                                     full-mesh room of N ports from O(N^2)
+                                     into O(N). Listeners which do not hear
+                                     all other sources are mixed as usual.
+                                     Only the serial and parallel bridge
+                                     backends support this option.          */
 };
 
 /**
@@ -305,6 +340,32 @@ typedef struct pjmedia_conf_param
      * the pjsua2 level using the pjsua2::MediaConfig::confThreads parameter.
      */
     unsigned worker_threads;
+
+    /**
+     * Active speaker policy: the maximum number of sources to be mixed on
+     * each frame. When non-zero, the bridge ranks the sources by their
+     * signal level and only mixes the loudest ones. The other sources are
+     * still read, so that their level is known, but their frames are
+     * neither resampled, level adjusted nor mixed. The ranking of a frame
+     * is made from the levels measured on the previous frame.
+     *
+     * Zero means all sources are mixed. This value is ignored by the
+     * conference switch board backend.
+     *
+     * Default: #PJMEDIA_CONF_MAX_SPEAKERS
+     */
+    unsigned max_speakers;
+
+    /**
+     * Hysteresis of the active speaker policy, in units of signal level
+     * (0-255) as reported by #pjmedia_conf_get_signal_level(). A source
+     * which is being mixed keeps its place until another source is louder
+     * by more than this value, so that the selection does not switch on
+     * every frame.
+     *
+     * Default: #PJMEDIA_CONF_SPEAKER_HYSTERESIS
+     */
+    unsigned speaker_hysteresis;
 } pjmedia_conf_param;
 
 
@@ -318,6 +379,8 @@ PJ_INLINE(void) pjmedia_conf_param_default(pjmedia_conf_param *param)
 #if defined(PJMEDIA_CONF_THREADS) && PJMEDIA_CONF_THREADS > 1
     param->worker_threads = PJMEDIA_CONF_THREADS-1;
 #endif
+    param->max_speakers = PJMEDIA_CONF_MAX_SPEAKERS;
+    param->speaker_hysteresis = PJMEDIA_CONF_SPEAKER_HYSTERESIS;
 }
 
 /**
@@ -498,6 +561,9 @@ PJ_DECL(pj_status_t) pjmedia_conf_set_port0_name(pjmedia_conf *conf,
  * the bridge will continuosly call get_frame() and put_frame() to the
  * port, allowing media to flow to/from the port.
  * 
+ * Besides linear PCM ports, the serial bridge backend also accepts ports
+ * in PCMU or PCMA format, see #pjmedia_conf_set_port_passthrough().
+ *
  * This operation executes asynchronously, use the callback set from
  * #pjmedia_conf_set_op_cb() to receive notification upon completion.
  * 
@@ -587,6 +653,37 @@ PJ_DECL(pj_status_t) pjmedia_conf_configure_port( pjmedia_conf *conf,
                                                   pjmedia_port_op rx);
 
 
+/**
+ * Enable or disable passthrough of encoded frames to an encoded port, i.e.
+ * a port in PCMU or PCMA format such as a stream using passthrough codec.
+ * Passthrough is enabled by default.
+ *
+ * With the serial bridge backend, the bridge decodes the frames received
+ * from encoded ports and encodes the mixed signal transmitted to them, so
+ * encoded ports can be connected to any other port. When passthrough is
+ * enabled and the port's only source is an encoded port of the same format
+ * and ptime, the encoded frames of the source are forwarded to the port as
+ * is instead, as long as no level adjustment applies to the connection.
+ * This is evaluated on every clock tick, so a port falls back to the
+ * mixed signal as soon as it gets a second source, and gets the frames
+ * as is again when it is left with one.
+ *
+ * The switch board backend always forwards the frames as is, and the
+ * parallel bridge backend doesn't support encoded ports.
+ *
+ * @param conf          The conference bridge.
+ * @param slot          Port number/slot in the conference bridge.
+ * @param enabled       PJ_TRUE to enable passthrough to the port.
+ *
+ * @return              PJ_SUCCESS on success, PJ_EINVALIDOP if the port
+ *                      is not an encoded port, or PJ_ENOTSUP if not
+ *                      supported by the backend.
+ */
+PJ_DECL(pj_status_t) pjmedia_conf_set_port_passthrough(pjmedia_conf *conf,
+                                                       unsigned slot,
+                                                       pj_bool_t enabled);
+
+
 /**
  * Enable unidirectional audio from the specified source slot to the specified
  * sink slot.
@@ -803,6 +900,31 @@ PJ_DECL(pj_status_t) pjmedia_conf_get_signal_level(pjmedia_conf *conf,
                                                    unsigned *rx_level);
 
 
+/**
+ * Get the processing statistics of the threads of the conference bridge.
+ * The first entry is the thread calling get_frame() of the bridge's master
+ * port (e.g. the sound device or the media clock thread), the others are
+ * the worker threads (see \a worker_threads in #pjmedia_conf_param).
+ * The statistics are updated by the threads without locking, so the
+ * values may be slightly inconsistent with one another.
+ *
+ * This is only supported by the parallel conference bridge backend, see
+ * #PJMEDIA_CONF_PARALLEL_BRIDGE_BACKEND.
+ *
+ * @param conf          The conference bridge.
+ * @param count         On input, contains maximum number of statistics
+ *                      to be retrieved. On output, contains the actual
+ *                      number of statistics that have been copied.
+ * @param stat          Array of statistics.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjmedia_conf_get_thread_stat(
+                                            pjmedia_conf *conf,
+                                            unsigned *count,
+                                            pjmedia_conf_thread_stat stat[]);
+
+
 /**
  * Adjust the level of signal received from the specified port.
  * Application may adjust the level to make signal received from the port
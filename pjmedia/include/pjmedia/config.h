@@ -178,6 +178,59 @@
 #   define PJMEDIA_CONF_THREADS  1
 #endif
 
+/**
+ * The default value for the maximum number of sources to be mixed on each
+ * frame by the conference bridge (active speaker policy), see
+ * pjmedia_conf_param::max_speakers.
+ *
+ * Default value: 0 - all sources are mixed
+ */
+#ifndef PJMEDIA_CONF_MAX_SPEAKERS
+#   define PJMEDIA_CONF_MAX_SPEAKERS  0
+#endif
+
+/**
+ * The default hysteresis of the conference bridge active speaker policy,
+ * in units of signal level (0-255), see
+ * pjmedia_conf_param::speaker_hysteresis. Sixteen steps is approximately
+ * 6 dB.
+ *
+ * Default value: 16
+ */
+#ifndef PJMEDIA_CONF_SPEAKER_HYSTERESIS
+#   define PJMEDIA_CONF_SPEAKER_HYSTERESIS  16
+#endif
+
+/**
+ * Enable the SIMD implementations of the sample mixing kernels used by
+ * the conference bridge (see @ref PJMEDIA_MIX_KERNEL). The implementation
+ * is selected at run-time according to the CPU (SSE2 or AVX2 on x86, NEON
+ * on ARM), falling back to the scalar implementation. This requires GCC or
+ * Clang.
+ *
+ * Default: enabled when supported by the compiler and target.
+ */
+#ifndef PJMEDIA_MIX_KERNEL_USE_SIMD
+#   if (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)) && \
+       (defined(__x86_64__) || defined(__i386__) || \
+        defined(__aarch64__) || defined(__ARM_NEON))
+#       define PJMEDIA_MIX_KERNEL_USE_SIMD  1
+#   else
+#       define PJMEDIA_MIX_KERNEL_USE_SIMD  0
+#   endif
+#endif
+
+/**
+ * Default number of worker threads of a tick pool (see
+ * @ref PJMEDIA_TICK_POOL), which drives the master ports of multiple
+ * conference bridges.
+ *
+ * Default: 2
+ */
+#ifndef PJMEDIA_TICK_POOL_WORKERS
+#   define PJMEDIA_TICK_POOL_WORKERS        2
+#endif
+
 
 /*
  * Types of sound stream backends.
@@ -379,6 +432,28 @@
 #   define PJMEDIA_HAS_ALAW_ULAW_TABLE      1
 #endif
 
+/**
+ * Enable the SIMD implementations of the G.711 block conversions, i.e.
+ * #pjmedia_ulaw_encode() and friends, used by the G.711 codec and by the
+ * conference bridge for ports in G.711 format. The implementation is
+ * selected at run-time according to the CPU (SSE2 or AVX2 on x86, NEON on
+ * ARM), falling back to the scalar implementation. This requires GCC or
+ * Clang, and #PJMEDIA_HAS_ALAW_ULAW_TABLE since the SIMD implementations
+ * reproduce the results of the conversion tables.
+ *
+ * Default: enabled when supported by the compiler and target.
+ */
+#ifndef PJMEDIA_G711_KERNEL_USE_SIMD
+#   if (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)) && \
+       (defined(__x86_64__) || defined(__i386__) || \
+        defined(__aarch64__) || defined(__ARM_NEON)) && \
+       PJMEDIA_HAS_ALAW_ULAW_TABLE
+#       define PJMEDIA_G711_KERNEL_USE_SIMD 1
+#   else
+#       define PJMEDIA_G711_KERNEL_USE_SIMD 0
+#   endif
+#endif
+
 
 /**
  * Unless specified otherwise, G711 codec is included by default.
@@ -448,6 +523,9 @@
 /** Sample rate conversion using libsamplerate (a.k.a Secret Rabbit Code) */
 #define PJMEDIA_RESAMPLE_LIBSAMPLERATE      4
 
+/** Sample rate conversion using the built-in polyphase filter */
+#define PJMEDIA_RESAMPLE_POLYPHASE          5
+
 /**
  * Select which resample implementation to use. Currently pjmedia supports:
  *  - #PJMEDIA_RESAMPLE_LIBRESAMPLE, to use libresample-1.7, this is the default
@@ -455,6 +533,10 @@
  *  - #PJMEDIA_RESAMPLE_LIBSAMPLERATE, to use libsamplerate implementation
  *    (a.k.a. Secret Rabbit Code).
  *  - #PJMEDIA_RESAMPLE_SPEEX, to use sample rate conversion in Speex library.
+ *  - #PJMEDIA_RESAMPLE_POLYPHASE, to use the built-in rational polyphase
+ *    filter, with SIMD kernels and filter banks shared across instances.
+ *    It requires the output frame of each conversion to have a whole
+ *    number of samples.
  *  - #PJMEDIA_RESAMPLE_NONE, to disable sample rate conversion. Any calls to
  *    resample function will return error.
  *
@@ -464,6 +546,24 @@
 #   define PJMEDIA_RESAMPLE_IMP             PJMEDIA_RESAMPLE_LIBRESAMPLE
 #endif
 
+/**
+ * Enable the SIMD implementations of the #PJMEDIA_RESAMPLE_POLYPHASE
+ * filter. The implementation is selected at run-time according to the CPU
+ * (SSE2 or AVX2 on x86, NEON on ARM), falling back to the scalar
+ * implementation. This requires GCC or Clang.
+ *
+ * Default: enabled when supported by the compiler and target.
+ */
+#ifndef PJMEDIA_RESAMPLE_POLYPHASE_USE_SIMD
+#   if (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)) && \
+       (defined(__x86_64__) || defined(__i386__) || \
+        defined(__aarch64__) || defined(__ARM_NEON))
+#       define PJMEDIA_RESAMPLE_POLYPHASE_USE_SIMD  1
+#   else
+#       define PJMEDIA_RESAMPLE_POLYPHASE_USE_SIMD  0
+#   endif
+#endif
+
 
 /**
  * Specify whether libsamplerate, when used, should be linked statically
@@ -1273,6 +1373,64 @@
 #endif
 
 
+/**
+ * Number of worker threads processing the incoming DTLS-SRTP handshake
+ * packets. The handshake cryptography (key exchange and certificate
+ * signing and verification) is then done outside the media transport
+ * thread, so a burst of new calls does not delay the packets of the
+ * established streams. The packets of a transport are always processed
+ * in order by the same worker. The workers are created on the first
+ * handshake.
+ *
+ * Set to zero to process the packets in the media transport thread.
+ *
+ * Default: 2
+ */
+#ifndef PJMEDIA_SRTP_DTLS_WORKER_CNT
+#   define PJMEDIA_SRTP_DTLS_WORKER_CNT             2
+#endif
+
+
+/**
+ * Maximum number of DTLS-SRTP handshake packets queued for each worker,
+ * see #PJMEDIA_SRTP_DTLS_WORKER_CNT. A packet received while the queue
+ * is full is dropped, the peer will retransmit it.
+ *
+ * Default: 32
+ */
+#ifndef PJMEDIA_SRTP_DTLS_WORKER_QUEUE_LEN
+#   define PJMEDIA_SRTP_DTLS_WORKER_QUEUE_LEN       32
+#endif
+
+
+/**
+ * Enable DTLS session resumption. The DTLS-SRTP transports share their
+ * OpenSSL contexts, so a session ticket issued to a peer is accepted by
+ * any transport. As client, the session established with a peer is kept
+ * by the fingerprint of the peer certificate and resumed by the next
+ * handshake with the same peer, which skips the key exchange and the
+ * certificate signature. The peer certificate fingerprint is verified
+ * for resumed sessions as well.
+ *
+ * Default: 1 (enabled)
+ */
+#ifndef PJMEDIA_SRTP_DTLS_SESSION_RESUMPTION
+#   define PJMEDIA_SRTP_DTLS_SESSION_RESUMPTION     1
+#endif
+
+
+/**
+ * Maximum number of DTLS client sessions kept for resumption, see
+ * #PJMEDIA_SRTP_DTLS_SESSION_RESUMPTION. When the cache is full, the
+ * least recently used session is replaced.
+ *
+ * Default: 64
+ */
+#ifndef PJMEDIA_SRTP_DTLS_SESSION_CACHE_SIZE
+#   define PJMEDIA_SRTP_DTLS_SESSION_CACHE_SIZE     64
+#endif
+
+
 /**
  * Maximum number of SRTP cryptos.
  *
@@ -1555,6 +1713,45 @@
 #endif
 
 
+/**
+ * Maximum number of RTP packets that the UDP media transport drains from
+ * its socket with a single batched receive call (recvmmsg() where
+ * available) when the transport is created with PJMEDIA_UDP_BATCH_RECV
+ * option. Each entry costs one PJMEDIA_MAX_MRU sized buffer per transport.
+ *
+ * Default : 8
+ */
+#ifndef PJMEDIA_UDP_RECV_BATCH_CNT
+#   define PJMEDIA_UDP_RECV_BATCH_CNT           8
+#endif
+
+
+/**
+ * Number of RTP reads that the UDP media transport keeps outstanding on
+ * its socket when the transport is created with PJMEDIA_UDP_POOLED_RECV
+ * option. Each read holds one buffer from the media endpoint's packet
+ * buffer pool.
+ *
+ * Default : 4
+ */
+#ifndef PJMEDIA_UDP_RECV_ASYNC_CNT
+#   define PJMEDIA_UDP_RECV_ASYNC_CNT           4
+#endif
+
+
+/**
+ * Maximum number of free packet buffers that each thread keeps in its
+ * own cache of a packet buffer pool, see @ref PJMEDIA_PKT_BUF. Buffers
+ * beyond this are moved back to the shared free list of the pool, half
+ * of the cache at a time.
+ *
+ * Default : 16
+ */
+#ifndef PJMEDIA_PKT_BUF_CACHE_SIZE
+#   define PJMEDIA_PKT_BUF_CACHE_SIZE           16
+#endif
+
+
 /*
  * .... new stuffs ...
  */
@@ -1749,6 +1946,19 @@
 #endif
 
 
+/**
+ * Default target late loss of histogram jitter buffer algorithm
+ * (PJMEDIA_JB_DISCARD_HISTOGRAM), i.e: the fraction of packets that may
+ * arrive too late to be played, in 1/1000 unit. Application can change
+ * this per jitter buffer using pjmedia_jbuf_set_late_loss().
+ *
+ * Default: 20 (2%)
+ */
+#ifndef PJMEDIA_JBUF_HIST_LATE_LOSS
+#   define PJMEDIA_JBUF_HIST_LATE_LOSS              20
+#endif
+
+
 /**
  * Reset jitter buffer and return silent audio on stream playback start
  * (first get_frame()). This is useful to avoid possible noise that may be
@@ -37,6 +37,7 @@
  */
 
 #include <pjmedia/codec.h>
+#include <pjmedia/pkt_buf.h>
 #include <pjmedia/sdp.h>
 #include <pjmedia/transport.h>
 #include <pjmedia-audiodev/audiodev.h>
@@ -230,6 +231,20 @@ PJ_DECL(pj_status_t) pjmedia_endpt_get_flag(pjmedia_endpt *endpt,
 PJ_DECL(pj_ioqueue_t*) pjmedia_endpt_get_ioqueue(pjmedia_endpt *endpt);
 
 
+/**
+ * Get the pool of packet buffers of the media endpoint. Media transports
+ * receive packets into buffers from this pool, so that the packets can
+ * be passed up to the media streams by reference. The buffers are
+ * PJMEDIA_MAX_MRU bytes long.
+ *
+ * @param endpt         The media endpoint instance.
+ *
+ * @return              The packet buffer pool.
+ */
+PJ_DECL(pjmedia_pkt_buf_pool*) pjmedia_endpt_get_pkt_buf_pool(
+                                                    pjmedia_endpt *endpt);
+
+
 /**
  * Get the number of worker threads on the media endpoint
  *
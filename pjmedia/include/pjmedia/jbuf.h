@@ -28,6 +28,7 @@
  * @brief Adaptive jitter buffer implementation.
  */
 #include <pjmedia/types.h>
+#include <pjmedia/pkt_buf.h>
 
 /**
  * @defgroup PJMED_JBUF Adaptive jitter buffer
@@ -87,11 +88,50 @@ typedef enum pjmedia_jb_discard_algo
      * a new frame arrives, one frame will be discarded to make space for the
      * new frame.
      */
-    PJMEDIA_JB_DISCARD_PROGRESSIVE
+    PJMEDIA_JB_DISCARD_PROGRESSIVE,
+
+    /**
+     * The target latency is estimated from a histogram of packet arrival
+     * delay, so that only the configured fraction of packets (see
+     * #pjmedia_jbuf_set_late_loss()) would arrive too late to be played.
+     * Instead of discarding frames, the jitter buffer asks the application
+     * to compress or expand the playback (see #pjmedia_jbuf_get_stretch()),
+     * e.g: using WSOLA. Frames are only discarded when the latency grows
+     * far beyond the target, e.g: when the application does not perform
+     * the time-stretching.
+     */
+    PJMEDIA_JB_DISCARD_HISTOGRAM
 
 } pjmedia_jb_discard_algo;
 
 
+/**
+ * Time-stretching requested by the jitter buffer to the application when
+ * #PJMEDIA_JB_DISCARD_HISTOGRAM is used.
+ */
+typedef enum pjmedia_jb_stretch
+{
+    /**
+     * Play normally.
+     */
+    PJMEDIA_JB_STRETCH_NONE         = 0,
+
+    /**
+     * Latency is above the target, the application should compress the
+     * playback, i.e: play more than one frame in one frame time.
+     */
+    PJMEDIA_JB_STRETCH_COMPRESS,
+
+    /**
+     * Latency is below the target, the application should expand the
+     * playback, i.e: play a synthetic frame without getting a frame from
+     * the jitter buffer.
+     */
+    PJMEDIA_JB_STRETCH_EXPAND
+
+} pjmedia_jb_stretch;
+
+
 /**
  * This structure describes jitter buffer state.
  */
@@ -117,6 +157,9 @@ typedef struct pjmedia_jb_state
     unsigned    avg_burst;          /**< Average burst, in frames.          */
     unsigned    lost;               /**< Number of lost frames.             */
     unsigned    discard;            /**< Number of discarded frames.        */
+    unsigned    late;               /**< Number of frames that arrived after
+                                         their playout time, these are
+                                         included in discard too.           */
     unsigned    empty;              /**< Number of empty on GET events.     */
 } pjmedia_jb_state;
 
@@ -243,6 +286,50 @@ PJ_DECL(pj_status_t) pjmedia_jbuf_set_discard(pjmedia_jbuf *jb,
                                               pjmedia_jb_discard_algo algo);
 
 
+/**
+ * Set the target late loss of #PJMEDIA_JB_DISCARD_HISTOGRAM algorithm,
+ * i.e: the fraction of packets that may arrive too late to be played.
+ * Lower value gives less late loss with higher latency. The default value
+ * is PJMEDIA_JBUF_HIST_LATE_LOSS.
+ *
+ * @param jb            The jitter buffer.
+ * @param late_loss     The target late loss, in 1/1000 unit, e.g:
+ *                      20 means 2%.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjmedia_jbuf_set_late_loss(pjmedia_jbuf *jb,
+                                                unsigned late_loss);
+
+
+/**
+ * Get the time-stretching currently requested by the jitter buffer. This
+ * is only meaningful with #PJMEDIA_JB_DISCARD_HISTOGRAM, otherwise
+ * PJMEDIA_JB_STRETCH_NONE is always returned. Application that performs
+ * the time-stretching must report it using #pjmedia_jbuf_report_stretch().
+ *
+ * @param jb            The jitter buffer.
+ *
+ * @return              The requested time-stretching.
+ */
+PJ_DECL(pjmedia_jb_stretch) pjmedia_jbuf_get_stretch(const pjmedia_jbuf *jb);
+
+
+/**
+ * Report time-stretching performed by the application, so the jitter
+ * buffer can keep its playback clock in sync with the actual playback.
+ * The jitter buffer assumes that each GET operation plays one frame,
+ * this function corrects that assumption.
+ *
+ * @param jb            The jitter buffer.
+ * @param frames        Number of frames played without GET operation
+ *                      (positive, e.g: expansion), or number of frames
+ *                      got without being played (negative, e.g:
+ *                      compression).
+ */
+PJ_DECL(void) pjmedia_jbuf_report_stretch(pjmedia_jbuf *jb, int frames);
+
+
 /**
  * Destroy jitter buffer instance.
  *
@@ -335,6 +422,37 @@ PJ_DECL(void) pjmedia_jbuf_put_frame3( pjmedia_jbuf *jb,
                                        int frame_seq,
                                        pj_uint32_t frame_ts,
                                        pj_bool_t *discarded);
+
+/**
+ * Put a frame to the jitter buffer by reference. This works like
+ * #pjmedia_jbuf_put_frame3(), except that when the frame lies within a
+ * packet buffer, the jitter buffer keeps a reference to the packet buffer
+ * instead of copying the frame. The reference is released when the frame
+ * is retrieved, removed, or discarded, or when the jitter buffer is reset
+ * or destroyed.
+ *
+ * Application MUST manage it's own synchronization when multiple threads
+ * are accessing the jitter buffer at the same time.
+ *
+ * @param jb            The jitter buffer.
+ * @param pkt_buf       The packet buffer containing the frame. If it is
+ *                      NULL, the frame is copied.
+ * @param frame         Pointer to the frame inside the packet buffer.
+ * @param size          The frame size.
+ * @param bit_info      Bit precise info of the frame.
+ * @param frame_seq     The frame sequence number.
+ * @param frame_ts      The frame timestamp.
+ * @param discarded     Flag whether the frame is discarded by jitter buffer.
+ */
+PJ_DECL(void) pjmedia_jbuf_put_frame_ref(pjmedia_jbuf *jb,
+                                         pjmedia_pkt_buf *pkt_buf,
+                                         const void *frame,
+                                         pj_size_t size,
+                                         pj_uint32_t bit_info,
+                                         int frame_seq,
+                                         pj_uint32_t frame_ts,
+                                         pj_bool_t *discarded);
+
 /**
  * Get a frame from the jitter buffer. The jitter buffer will return the
  * oldest frame from it's buffer, when it is available.
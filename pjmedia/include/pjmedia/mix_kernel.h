@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef __PJMEDIA_MIX_KERNEL_H__
+#define __PJMEDIA_MIX_KERNEL_H__
+
+
+/**
+ * @file mix_kernel.h
+ * @brief Sample mixing kernels.
+ */
+#include <pjmedia/types.h>
+
+
+/**
+ * @defgroup PJMEDIA_MIX_KERNEL Sample Mixing Kernels
+ * @ingroup PJMEDIA_FRAME_OP
+ * @brief Vectorized level adjustment, mixing and signal level routines
+ * @{
+ *
+ * These are the inner loops of the audio conference bridge: level (gain)
+ * adjustment with clipping, accumulation of 16-bit samples into 32-bit
+ * mix buffers while tracking the range of the result, and the signal
+ * level calculation. Each set of kernels is implemented with a particular
+ * instruction set (SSE2, AVX2, NEON), and there is always the scalar
+ * implementation. All implementations give identical results.
+ *
+ * The gain is expressed the same way as the conference bridge level,
+ * i.e. as a multiplier in 1/128 unit, so 128 means unchanged.
+ *
+ * Use #pjmedia_mix_kernel_get() with #PJMEDIA_MIX_KERNEL_AUTO to get the
+ * best implementation for the running CPU.
+ */
+
+
+PJ_BEGIN_DECL
+
+
+/**
+ * Mixing kernel implementations.
+ */
+typedef enum pjmedia_mix_kernel_type
+{
+    /** The best implementation supported by the running CPU. */
+    PJMEDIA_MIX_KERNEL_AUTO,
+
+    /** Portable C implementation. */
+    PJMEDIA_MIX_KERNEL_SCALAR,
+
+    /** x86 SSE2 implementation. */
+    PJMEDIA_MIX_KERNEL_SSE2,
+
+    /** x86 AVX2 implementation. */
+    PJMEDIA_MIX_KERNEL_AVX2,
+
+    /** ARM NEON implementation. */
+    PJMEDIA_MIX_KERNEL_NEON
+
+} pjmedia_mix_kernel_type;
+
+
+/**
+ * A set of mixing kernels. All functions accept any count of samples
+ * and any alignment of the buffers.
+ */
+typedef struct pjmedia_mix_kernel
+{
+    /** Implementation type. */
+    pjmedia_mix_kernel_type type;
+
+    /** Implementation name, e.g. "sse2". */
+    const char *name;
+
+    /**
+     * Calculate the sum of the absolute values of the samples.
+     *
+     * @param src       The samples.
+     * @param count     Number of samples.
+     *
+     * @return          The sum of absolute values.
+     */
+    pj_uint32_t (*sum_abs)(const pj_int16_t *src, unsigned count);
+
+    /**
+     * Apply gain to 16-bit samples, clipping the result to 16-bit:
+     * dst[i] = clip((src[i] * gain) >> 7).
+     *
+     * @param dst       The destination, may be the same as src.
+     * @param src       The source samples.
+     * @param gain      The gain, 128 is unchanged.
+     * @param count     Number of samples.
+     *
+     * @return          The sum of absolute values of the result.
+     */
+    pj_uint32_t (*apply_gain)(pj_int16_t *dst, const pj_int16_t *src,
+                              unsigned gain, unsigned count);
+
+    /**
+     * Accumulate 16-bit samples into a 32-bit mix buffer:
+     * dst[i] += src[i]. Optionally, track the range of the result.
+     *
+     * @param dst       The mix buffer.
+     * @param src       The samples to add.
+     * @param count     Number of samples.
+     * @param p_min     Optional, on input the current minimum, on output
+     *                  the minimum of the input value and the result.
+     * @param p_max     Optional, as p_min, for the maximum. Both p_min and
+     *                  p_max must be specified or both NULL.
+     */
+    void (*accumulate)(pj_int32_t *dst, const pj_int16_t *src,
+                       unsigned count, pj_int32_t *p_min, pj_int32_t *p_max);
+
+    /**
+     * Accumulate a 32-bit mix buffer into another, optionally subtracting
+     * 16-bit samples: dst[i] += src[i] - sub[i]. Optionally, track the
+     * range of the result.
+     *
+     * @param dst       The mix buffer.
+     * @param src       The mix buffer to add.
+     * @param sub       Optional samples to subtract.
+     * @param count     Number of samples.
+     * @param p_min     Optional, see \a accumulate.
+     * @param p_max     Optional, see \a accumulate.
+     */
+    void (*accumulate32)(pj_int32_t *dst, const pj_int32_t *src,
+                         const pj_int16_t *sub, unsigned count,
+                         pj_int32_t *p_min, pj_int32_t *p_max);
+
+    /**
+     * Apply gain to a 32-bit mix buffer, saturating the result to 16-bit:
+     * dst[i] = clip((src[i] * gain) >> 7).
+     *
+     * @param dst       The destination samples, may point to the start
+     *                  of src for in-place conversion.
+     * @param src       The mix buffer.
+     * @param gain      The gain, 128 is unchanged.
+     * @param count     Number of samples.
+     *
+     * @return          The sum of absolute values of the result.
+     */
+    pj_uint32_t (*clamp)(pj_int16_t *dst, const pj_int32_t *src,
+                         unsigned gain, unsigned count);
+
+} pjmedia_mix_kernel;
+
+
+/**
+ * Get a mixing kernel implementation.
+ *
+ * @param type      The implementation, or #PJMEDIA_MIX_KERNEL_AUTO to
+ *                  select the best one for the running CPU.
+ *
+ * @return          The kernels, or NULL if the implementation is not
+ *                  built in or not supported by the CPU.
+ */
+PJ_DECL(const pjmedia_mix_kernel*)
+pjmedia_mix_kernel_get(pjmedia_mix_kernel_type type);
+
+
+PJ_END_DECL
+
+/**
+ * @}
+ */
+
+
+#endif  /* __PJMEDIA_MIX_KERNEL_H__ */
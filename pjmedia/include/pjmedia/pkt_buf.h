@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef __PJMEDIA_PKT_BUF_H__
+#define __PJMEDIA_PKT_BUF_H__
+
+
+/**
+ * @file pkt_buf.h
+ * @brief Reference counted packet buffers.
+ */
+#include <pjmedia/types.h>
+
+/**
+ * @defgroup PJMEDIA_PKT_BUF Packet Buffer Pool
+ * @ingroup PJMEDIA_TRANSPORT
+ * @brief Reference counted buffers to pass received packets by reference
+ * @{
+ *
+ * A packet buffer pool hands out fixed size, reference counted buffers.
+ * A media transport receives a packet into such a buffer and passes the
+ * buffer up in #pjmedia_tp_cb_param, so the packet can go through SRTP
+ * decryption and RTP parsing in place, and the jitter buffer can keep a
+ * reference to the payload instead of copying it. The buffer returns to
+ * the pool when its last reference is released.
+ *
+ * Each thread keeps a small cache of free buffers of the pool, so that
+ * allocating and releasing buffers normally does not take the pool lock.
+ * The cache size is configured with PJMEDIA_PKT_BUF_CACHE_SIZE.
+ *
+ * The media endpoint owns a pool for packets up to PJMEDIA_MAX_MRU bytes,
+ * see #pjmedia_endpt_get_pkt_buf_pool().
+ */
+
+PJ_BEGIN_DECL
+
+
+/**
+ * Opaque declaration for packet buffer pool.
+ */
+typedef struct pjmedia_pkt_buf_pool pjmedia_pkt_buf_pool;
+
+
+/**
+ * Reference counted packet buffer.
+ */
+typedef struct pjmedia_pkt_buf
+{
+    /**
+     * The buffer.
+     */
+    void                    *buf;
+
+    /**
+     * The size of the buffer, in bytes.
+     */
+    pj_size_t                size;
+
+    /**
+     * Length of the data in the buffer, in bytes. This is maintained by
+     * the user of the buffer.
+     */
+    pj_size_t                len;
+
+    /** Internal: the pool owning the buffer. */
+    pjmedia_pkt_buf_pool    *pool;
+
+    /** Internal: reference counter. */
+    pj_atomic_t             *ref_cnt;
+
+    /** Internal: free list link. */
+    struct pjmedia_pkt_buf  *next;
+
+} pjmedia_pkt_buf;
+
+
+/**
+ * Create a packet buffer pool.
+ *
+ * @param pf            The pool factory for the memory of the pool.
+ * @param name          Name of the pool, for logging purpose, or NULL.
+ * @param buf_size      The size of each buffer, in bytes.
+ * @param init_cnt      Number of buffers to allocate upfront. More
+ *                      buffers are allocated on demand.
+ * @param p_pool        Pointer to receive the pool.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjmedia_pkt_buf_pool_create(pj_pool_factory *pf,
+                                                 const char *name,
+                                                 pj_size_t buf_size,
+                                                 unsigned init_cnt,
+                                                 pjmedia_pkt_buf_pool **p_pool);
+
+
+/**
+ * Destroy a packet buffer pool. If some buffers are still referenced,
+ * the pool is only destroyed when the last of them is released.
+ *
+ * @param pool          The packet buffer pool.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjmedia_pkt_buf_pool_destroy(pjmedia_pkt_buf_pool *pool);
+
+
+/**
+ * Get a buffer from the pool. The returned buffer has a reference count
+ * of one and zero \a len.
+ *
+ * @param pool          The packet buffer pool.
+ * @param p_buf         Pointer to receive the buffer.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjmedia_pkt_buf_alloc(pjmedia_pkt_buf_pool *pool,
+                                           pjmedia_pkt_buf **p_buf);
+
+
+/**
+ * Add a reference to a packet buffer.
+ *
+ * @param buf           The packet buffer.
+ */
+PJ_DECL(void) pjmedia_pkt_buf_add_ref(pjmedia_pkt_buf *buf);
+
+
+/**
+ * Release a reference to a packet buffer. The buffer returns to its pool
+ * when the last reference is released.
+ *
+ * @param buf           The packet buffer.
+ */
+PJ_DECL(void) pjmedia_pkt_buf_dec_ref(pjmedia_pkt_buf *buf);
+
+
+/**
+ * Check whether a memory area lies within a packet buffer.
+ *
+ * @param buf           The packet buffer.
+ * @param ptr           Start of the memory area.
+ * @param len           Length of the memory area.
+ *
+ * @return              PJ_TRUE if the area lies within the buffer.
+ */
+PJ_INLINE(pj_bool_t) pjmedia_pkt_buf_contains(const pjmedia_pkt_buf *buf,
+                                              const void *ptr,
+                                              pj_size_t len)
+{
+    const char *start = (const char*)buf->buf;
+    const char *p = (const char*)ptr;
+
+    return p >= start && len <= buf->size && p - start <= (pj_ssize_t)
+           (buf->size - len);
+}
+
+
+PJ_END_DECL
+
+/**
+ * @}
+ */
+
+
+#endif  /* __PJMEDIA_PKT_BUF_H__ */
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef __PJMEDIA_TICK_POOL_H__
+#define __PJMEDIA_TICK_POOL_H__
+
+
+/**
+ * @file tick_pool.h
+ * @brief Shared clock and worker pool for multiple media ports.
+ */
+#include <pjmedia/port.h>
+
+/**
+ * @defgroup PJMEDIA_TICK_POOL Tick Pool
+ * @ingroup PJMEDIA_PORT_CLOCK
+ * @brief One media clock driving many ports with a pool of worker threads
+ * @{
+ *
+ * A tick pool drives any number of media ports, typically the master
+ * ports of conference bridges created with #PJMEDIA_CONF_NO_DEVICE, one
+ * bridge per conference room. At each tick of its @ref PJMEDIA_CLOCK, the
+ * tick pool queues every port, and the worker threads call
+ * <b><tt>get_frame()</tt></b> of the queued ports, like a sound device
+ * would. So independent bridges are processed concurrently by the worker
+ * threads rather than one after another in a single clock thread.
+ *
+ * A port that is still being processed when the next tick arrives skips
+ * that tick, so a port that takes too long can only delay itself, not
+ * the other ports of the pool.
+ */
+
+PJ_BEGIN_DECL
+
+
+/**
+ * Opaque declaration for tick pool.
+ */
+typedef struct pjmedia_tick_pool pjmedia_tick_pool;
+
+
+/**
+ * Tick pool settings.
+ */
+typedef struct pjmedia_tick_pool_param
+{
+    /**
+     * The interval of the ticks, in microseconds. All ports of the pool
+     * must have this frame time.
+     *
+     * Default: 20000 (20 msec)
+     */
+    unsigned            ptime_usec;
+
+    /**
+     * Number of worker threads.
+     *
+     * Default: PJMEDIA_TICK_POOL_WORKERS
+     */
+    unsigned            worker_cnt;
+
+    /**
+     * Options for the clock, bitmask combinations of
+     * pjmedia_clock_options.
+     *
+     * Default: 0
+     */
+    unsigned            clock_options;
+
+} pjmedia_tick_pool_param;
+
+
+/**
+ * Initialize tick pool settings with the default values.
+ *
+ * @param param         The settings to initialize.
+ */
+PJ_DECL(void) pjmedia_tick_pool_param_default(pjmedia_tick_pool_param *param);
+
+
+/**
+ * Create and start a tick pool.
+ *
+ * @param pool          Pool to allocate the tick pool from.
+ * @param param         The settings.
+ * @param p_tp          Pointer to receive the tick pool instance.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjmedia_tick_pool_create(
+                                        pj_pool_t *pool,
+                                        const pjmedia_tick_pool_param *param,
+                                        pjmedia_tick_pool **p_tp);
+
+
+/**
+ * Add a port to be driven by the tick pool. From the next tick,
+ * <b><tt>get_frame()</tt></b> of the port will be called at every tick
+ * by one of the worker threads. A port is only processed by one thread
+ * at a time.
+ *
+ * @param tp            The tick pool.
+ * @param port          The port. Its frame time must be the tick
+ *                      interval of the pool.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjmedia_tick_pool_add_port(pjmedia_tick_pool *tp,
+                                                pjmedia_port *port);
+
+
+/**
+ * Remove a port from the tick pool. If the port is being processed by a
+ * worker thread, this function waits until it is done, so the port may
+ * be destroyed once this function returns, unless it is called by the
+ * port's own <b><tt>get_frame()</tt></b>.
+ *
+ * @param tp            The tick pool.
+ * @param port          The port.
+ *
+ * @return              PJ_SUCCESS on success, or PJ_ENOTFOUND if the
+ *                      port is not in the pool.
+ */
+PJ_DECL(pj_status_t) pjmedia_tick_pool_remove_port(pjmedia_tick_pool *tp,
+                                                   pjmedia_port *port);
+
+
+/**
+ * Stop the clock and the worker threads, and destroy the tick pool.
+ * The ports that are still in the pool are not destroyed.
+ *
+ * @param tp            The tick pool.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjmedia_tick_pool_destroy(pjmedia_tick_pool *tp);
+
+
+PJ_END_DECL
+
+/**
+ * @}
+ */
+
+
+#endif  /* __PJMEDIA_TICK_POOL_H__ */
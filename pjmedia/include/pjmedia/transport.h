@@ -27,6 +27,7 @@
 
 #include <pjmedia/types.h>
 #include <pjmedia/errno.h>
+#include <pjmedia/pkt_buf.h>
 #include <pj/string.h>
 
 /**
@@ -612,6 +613,14 @@ typedef struct pjmedia_tp_cb_param
      */
     pj_bool_t           rem_switch;
 
+    /**
+     * The reference counted buffer holding \a pkt, or NULL if the packet
+     * is not in a pooled buffer. A receiver that wants to keep (part of)
+     * the packet beyond the callback may add a reference to the buffer
+     * instead of copying it, see @ref PJMEDIA_PKT_BUF.
+     */
+    pjmedia_pkt_buf    *pkt_buf;
+
 } pjmedia_tp_cb_param;
 
 /**
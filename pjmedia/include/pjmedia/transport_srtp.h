@@ -559,6 +559,100 @@ PJ_DECL(pj_status_t) pjmedia_transport_srtp_decrypt_pkt(pjmedia_transport *tp,
                                                         int *pkt_len);
 
 
+/**
+ * Maximum number of octets that protecting an RTP packet appends to it,
+ * i.e. the room that must be available after the packet in its buffer
+ * when it is protected in place by #pjmedia_transport_srtp_protect_batch().
+ */
+#define PJMEDIA_SRTP_MAX_TAG_LEN    16
+
+
+/**
+ * This structure describes an RTP packet in a batch of packets to be
+ * protected or unprotected in place, see
+ * #pjmedia_transport_srtp_protect_batch() and
+ * #pjmedia_transport_srtp_unprotect_batch().
+ */
+typedef struct pjmedia_srtp_batch_pkt
+{
+    /**
+     * The SRTP transport of the packet.
+     */
+    pjmedia_transport  *tp;
+
+    /**
+     * The packet buffer, which must be 32bit aligned. On output, it
+     * contains the processed packet.
+     */
+    void               *pkt;
+
+    /**
+     * On input, the length of the packet. On output, the length of the
+     * processed packet.
+     */
+    int                 len;
+
+    /**
+     * The size of the packet buffer. When protecting, it must have room
+     * for PJMEDIA_SRTP_MAX_TAG_LEN octets after the packet.
+     */
+    int                 buf_size;
+
+    /**
+     * On output, the status of the operation for this packet.
+     */
+    pj_status_t         status;
+
+} pjmedia_srtp_batch_pkt;
+
+
+/**
+ * Protect a batch of outgoing RTP packets in place, for example the
+ * packets of all the sessions that are due in one media clock tick. The
+ * packets may belong to different SRTP transports. Consecutive packets of
+ * the same transport are protected in one acquisition of the transport
+ * lock, and no packet is copied.
+ *
+ * Packets of transports which are not using SRTP (e.g: SRTP is optional
+ * and the remote does not use it) are left unchanged.
+ *
+ * @param pkts          The packets.
+ * @param count         Number of packets.
+ * @param send          If non-zero, send each successfully protected
+ *                      packet with the member transport of its SRTP
+ *                      transport, once all packets have been protected.
+ *
+ * @return              PJ_SUCCESS if all packets have been processed
+ *                      (and sent) successfully, otherwise the first error
+ *                      status. The status of each packet is returned in
+ *                      its \a status field.
+ */
+PJ_DECL(pj_status_t) pjmedia_transport_srtp_protect_batch(
+                                            pjmedia_srtp_batch_pkt pkts[],
+                                            unsigned count,
+                                            pj_bool_t send);
+
+
+/**
+ * Unprotect a batch of incoming SRTP packets in place. This works like
+ * #pjmedia_transport_srtp_decrypt_pkt() for each packet, except that
+ * consecutive packets of the same transport are unprotected in one
+ * acquisition of the transport lock. The packets are not delivered to
+ * the attached stream.
+ *
+ * @param pkts          The packets.
+ * @param count         Number of packets.
+ *
+ * @return              PJ_SUCCESS if all packets have been processed
+ *                      successfully, otherwise the first error status.
+ *                      The status of each packet is returned in its
+ *                      \a status field.
+ */
+PJ_DECL(pj_status_t) pjmedia_transport_srtp_unprotect_batch(
+                                            pjmedia_srtp_batch_pkt pkts[],
+                                            unsigned count);
+
+
 /**
  * Query member transport of SRTP.
  *
@@ -55,7 +55,27 @@ enum pjmedia_transport_udp_options
      * received.
      * Specifying this option will disable this feature.
      */
-    PJMEDIA_UDP_NO_SRC_ADDR_CHECKING = 1
+    PJMEDIA_UDP_NO_SRC_ADDR_CHECKING = 1,
+
+    /**
+     * Drain multiple RTP packets from the socket with one batched receive
+     * call (recvmmsg() where available) every time the socket becomes
+     * readable, instead of reading one packet per ioqueue callback. This
+     * reduces system calls and ioqueue dispatch overhead on servers
+     * handling many streams. Up to PJMEDIA_UDP_RECV_BATCH_CNT packets
+     * are read per call.
+     */
+    PJMEDIA_UDP_BATCH_RECV = 2,
+
+    /**
+     * Receive RTP packets into reference counted buffers from the media
+     * endpoint's packet buffer pool, keeping PJMEDIA_UDP_RECV_ASYNC_CNT
+     * reads outstanding on the socket. The buffer is passed up with the
+     * packet in #pjmedia_tp_cb_param, so that the stream can put the
+     * payload into its jitter buffer by reference instead of copying it.
+     * Packets drained with PJMEDIA_UDP_BATCH_RECV are still copied.
+     */
+    PJMEDIA_UDP_POOLED_RECV = 4
 };
 
 
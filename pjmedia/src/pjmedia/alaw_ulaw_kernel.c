@@ -0,0 +1,723 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <pjmedia/alaw_ulaw.h>
+
+
+#if defined(PJMEDIA_G711_KERNEL_USE_SIMD) && PJMEDIA_G711_KERNEL_USE_SIMD!=0
+#   if defined(__x86_64__) || defined(__i386__)
+#       define HAS_X86_KERNEL   1
+#       include <immintrin.h>
+#   elif defined(__aarch64__) || defined(__ARM_NEON)
+#       define HAS_NEON_KERNEL  1
+#       include <arm_neon.h>
+#   endif
+#endif
+
+#ifndef HAS_X86_KERNEL
+#   define HAS_X86_KERNEL       0
+#endif
+#ifndef HAS_NEON_KERNEL
+#   define HAS_NEON_KERNEL      0
+#endif
+
+
+/*
+ * Scalar implementation, using the per-sample conversions. This is also
+ * used by the SIMD implementations to process the remaining samples.
+ */
+static void ulaw_encode_scalar(pj_uint8_t *dst, const pj_int16_t *src,
+                               pj_size_t count)
+{
+    pj_size_t i;
+
+    for (i=0; i<count; ++i)
+        dst[i] = (pj_uint8_t)pjmedia_linear2ulaw(src[i]);
+}
+
+static void alaw_encode_scalar(pj_uint8_t *dst, const pj_int16_t *src,
+                               pj_size_t count)
+{
+    pj_size_t i;
+
+    for (i=0; i<count; ++i)
+        dst[i] = (pj_uint8_t)pjmedia_linear2alaw(src[i]);
+}
+
+static void ulaw_decode_scalar(pj_int16_t *dst, const pj_uint8_t *src,
+                               pj_size_t len)
+{
+    pj_size_t i;
+
+    for (i=0; i<len; ++i)
+        dst[i] = (pj_int16_t)pjmedia_ulaw2linear(src[i]);
+}
+
+static void alaw_decode_scalar(pj_int16_t *dst, const pj_uint8_t *src,
+                               pj_size_t len)
+{
+    pj_size_t i;
+
+    for (i=0; i<len; ++i)
+        dst[i] = (pj_int16_t)pjmedia_alaw2linear(src[i]);
+}
+
+static const pjmedia_g711_kernel scalar_kernel =
+{
+    PJMEDIA_G711_KERNEL_SCALAR,
+    "scalar",
+    &ulaw_encode_scalar,
+    &alaw_encode_scalar,
+    &ulaw_decode_scalar,
+    &alaw_decode_scalar
+};
+
+
+/*
+ * The SIMD implementations below compute the same results as the
+ * conversion tables, which are indexed by the sample shifted right by
+ * two bits:
+ *
+ *  - U-Law encoding: with i = pcm >> 2, the biased magnitude in the same
+ *    scale is m = |i| + 33, limited to 8191 which gives the maximum code
+ *    as for out of range values. With e the position of the highest bit
+ *    of m, the segment is e - 5 and the quantization bits are the four
+ *    bits below the highest bit. These are exactly the exponent and the
+ *    top of the mantissa of m converted to float, so the code is
+ *    (float bits >> 19) - ((127 + 5) << 4). The result is XOR-ed with
+ *    0xFF for positive and 0x7F for negative samples.
+ *
+ *  - A-Law encoding: with a = |pcm >> 2|, limited to 8191, the code is
+ *    obtained the same way for a >= 64, and it is a >> 2 (segment zero)
+ *    below that. The result is XOR-ed with 0xD5 for positive and 0x55 for
+ *    negative samples.
+ *
+ *  - Decoding follows the per-sample functions, with the variable shift
+ *    by the segment number done with a shift for each bit of it.
+ */
+#define FLOAT_SEG_BASE  ((127 + 5) << 4)
+
+#if HAS_X86_KERNEL
+/*
+ * SSE2 implementation, 16 samples per iteration.
+ */
+
+/* Select a where mask is set, b elsewhere. */
+__attribute__((target("sse2")))
+static inline __m128i select_sse2(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/* Shift left each 16-bit t by the corresponding e, 0 to 7. */
+__attribute__((target("sse2")))
+static inline __m128i shl_var_sse2(__m128i t, __m128i e)
+{
+    const __m128i b0 = _mm_set1_epi16(1);
+    const __m128i b1 = _mm_set1_epi16(2);
+    const __m128i b2 = _mm_set1_epi16(4);
+
+    t = select_sse2(_mm_cmpeq_epi16(_mm_and_si128(e, b0), b0),
+                    _mm_slli_epi16(t, 1), t);
+    t = select_sse2(_mm_cmpeq_epi16(_mm_and_si128(e, b1), b1),
+                    _mm_slli_epi16(t, 2), t);
+    t = select_sse2(_mm_cmpeq_epi16(_mm_and_si128(e, b2), b2),
+                    _mm_slli_epi16(t, 4), t);
+    return t;
+}
+
+/* Segment and quantization bits of eight magnitudes, 1 to 8191, as
+ * (segment << 4) | quantization, see above.
+ */
+__attribute__((target("sse2")))
+static inline __m128i seg_quant_sse2(__m128i m)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_castps_si128(_mm_cvtepi32_ps(_mm_unpacklo_epi16(m,
+                                                                     zero)));
+    __m128i hi = _mm_castps_si128(_mm_cvtepi32_ps(_mm_unpackhi_epi16(m,
+                                                                     zero)));
+
+    return _mm_sub_epi16(_mm_packs_epi32(_mm_srli_epi32(lo, 19),
+                                         _mm_srli_epi32(hi, 19)),
+                         _mm_set1_epi16(FLOAT_SEG_BASE));
+}
+
+/* U-Law codes of eight samples, in the low byte of each 16-bit lane. */
+__attribute__((target("sse2")))
+static inline __m128i ulaw_enc_sse2(__m128i x)
+{
+    __m128i i = _mm_srai_epi16(x, 2);
+    __m128i sign = _mm_srai_epi16(i, 15);
+    __m128i m = _mm_sub_epi16(_mm_xor_si128(i, sign), sign);
+    __m128i mask;
+
+    m = _mm_min_epi16(_mm_add_epi16(m, _mm_set1_epi16(33)),
+                      _mm_set1_epi16(8191));
+    mask = _mm_or_si128(_mm_set1_epi16(0x7F),
+                        _mm_andnot_si128(sign, _mm_set1_epi16(0x80)));
+    return _mm_xor_si128(seg_quant_sse2(m), mask);
+}
+
+/* A-Law codes of eight samples, in the low byte of each 16-bit lane. */
+__attribute__((target("sse2")))
+static inline __m128i alaw_enc_sse2(__m128i x)
+{
+    __m128i i = _mm_srai_epi16(x, 2);
+    __m128i sign = _mm_srai_epi16(i, 15);
+    __m128i a = _mm_sub_epi16(_mm_xor_si128(i, sign), sign);
+    __m128i code, mask;
+
+    a = _mm_min_epi16(a, _mm_set1_epi16(8191));
+    code = select_sse2(_mm_cmpgt_epi16(a, _mm_set1_epi16(63)),
+                       seg_quant_sse2(a), _mm_srli_epi16(a, 2));
+    mask = _mm_or_si128(_mm_set1_epi16(0x55),
+                        _mm_andnot_si128(sign, _mm_set1_epi16(0x80)));
+    return _mm_xor_si128(code, mask);
+}
+
+/* Linear samples of eight U-Law codes in 16-bit lanes. */
+__attribute__((target("sse2")))
+static inline __m128i ulaw_dec_sse2(__m128i c)
+{
+    const __m128i bias = _mm_set1_epi16(0x84);
+    __m128i u = _mm_xor_si128(c, _mm_set1_epi16(0xFF));
+    __m128i t, e, neg;
+
+    t = _mm_add_epi16(_mm_slli_epi16(_mm_and_si128(u, _mm_set1_epi16(0xF)),
+                                     3), bias);
+    e = _mm_and_si128(_mm_srli_epi16(u, 4), _mm_set1_epi16(7));
+    t = _mm_sub_epi16(shl_var_sse2(t, e), bias);
+
+    neg = _mm_cmpgt_epi16(u, _mm_set1_epi16(0x7F));
+    return _mm_sub_epi16(_mm_xor_si128(t, neg), neg);
+}
+
+/* Linear samples of eight A-Law codes in 16-bit lanes. */
+__attribute__((target("sse2")))
+static inline __m128i alaw_dec_sse2(__m128i c)
+{
+    __m128i a = _mm_xor_si128(c, _mm_set1_epi16(0x55));
+    __m128i t, seg, neg;
+
+    t = _mm_add_epi16(_mm_slli_epi16(_mm_and_si128(a, _mm_set1_epi16(0xF)),
+                                     4), _mm_set1_epi16(8));
+    seg = _mm_and_si128(_mm_srli_epi16(a, 4), _mm_set1_epi16(7));
+    t = _mm_add_epi16(t, _mm_and_si128(_mm_cmpgt_epi16(seg,
+                                                   _mm_setzero_si128()),
+                                       _mm_set1_epi16(0x100)));
+    t = shl_var_sse2(t, _mm_subs_epu16(seg, _mm_set1_epi16(1)));
+
+    neg = _mm_cmplt_epi16(a, _mm_set1_epi16(0x80));
+    return _mm_sub_epi16(_mm_xor_si128(t, neg), neg);
+}
+
+__attribute__((target("sse2")))
+static void ulaw_encode_sse2(pj_uint8_t *dst, const pj_int16_t *src,
+                             pj_size_t count)
+{
+    pj_size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m128i lo = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(src + i + 8));
+        _mm_storeu_si128((__m128i*)(dst + i),
+                         _mm_packus_epi16(ulaw_enc_sse2(lo),
+                                          ulaw_enc_sse2(hi)));
+    }
+    ulaw_encode_scalar(dst + i, src + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void alaw_encode_sse2(pj_uint8_t *dst, const pj_int16_t *src,
+                             pj_size_t count)
+{
+    pj_size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m128i lo = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(src + i + 8));
+        _mm_storeu_si128((__m128i*)(dst + i),
+                         _mm_packus_epi16(alaw_enc_sse2(lo),
+                                          alaw_enc_sse2(hi)));
+    }
+    alaw_encode_scalar(dst + i, src + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void ulaw_decode_sse2(pj_int16_t *dst, const pj_uint8_t *src,
+                             pj_size_t len)
+{
+    const __m128i zero = _mm_setzero_si128();
+    pj_size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + i),
+                         ulaw_dec_sse2(_mm_unpacklo_epi8(c, zero)));
+        _mm_storeu_si128((__m128i*)(dst + i + 8),
+                         ulaw_dec_sse2(_mm_unpackhi_epi8(c, zero)));
+    }
+    ulaw_decode_scalar(dst + i, src + i, len - i);
+}
+
+__attribute__((target("sse2")))
+static void alaw_decode_sse2(pj_int16_t *dst, const pj_uint8_t *src,
+                             pj_size_t len)
+{
+    const __m128i zero = _mm_setzero_si128();
+    pj_size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + i),
+                         alaw_dec_sse2(_mm_unpacklo_epi8(c, zero)));
+        _mm_storeu_si128((__m128i*)(dst + i + 8),
+                         alaw_dec_sse2(_mm_unpackhi_epi8(c, zero)));
+    }
+    alaw_decode_scalar(dst + i, src + i, len - i);
+}
+
+static const pjmedia_g711_kernel sse2_kernel =
+{
+    PJMEDIA_G711_KERNEL_SSE2,
+    "sse2",
+    &ulaw_encode_sse2,
+    &alaw_encode_sse2,
+    &ulaw_decode_sse2,
+    &alaw_decode_sse2
+};
+
+
+/*
+ * AVX2 implementation, 32 samples per iteration.
+ */
+
+__attribute__((target("avx2")))
+static inline __m256i select_avx2(__m256i mask, __m256i a, __m256i b)
+{
+    return _mm256_blendv_epi8(b, a, mask);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i shl_var_avx2(__m256i t, __m256i e)
+{
+    const __m256i b0 = _mm256_set1_epi16(1);
+    const __m256i b1 = _mm256_set1_epi16(2);
+    const __m256i b2 = _mm256_set1_epi16(4);
+
+    t = select_avx2(_mm256_cmpeq_epi16(_mm256_and_si256(e, b0), b0),
+                    _mm256_slli_epi16(t, 1), t);
+    t = select_avx2(_mm256_cmpeq_epi16(_mm256_and_si256(e, b1), b1),
+                    _mm256_slli_epi16(t, 2), t);
+    t = select_avx2(_mm256_cmpeq_epi16(_mm256_and_si256(e, b2), b2),
+                    _mm256_slli_epi16(t, 4), t);
+    return t;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i seg_quant_avx2(__m256i m)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i lo = _mm256_castps_si256(_mm256_cvtepi32_ps(
+                                         _mm256_unpacklo_epi16(m, zero)));
+    __m256i hi = _mm256_castps_si256(_mm256_cvtepi32_ps(
+                                         _mm256_unpackhi_epi16(m, zero)));
+
+    return _mm256_sub_epi16(_mm256_packs_epi32(_mm256_srli_epi32(lo, 19),
+                                               _mm256_srli_epi32(hi, 19)),
+                            _mm256_set1_epi16(FLOAT_SEG_BASE));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i ulaw_enc_avx2(__m256i x)
+{
+    __m256i i = _mm256_srai_epi16(x, 2);
+    __m256i sign = _mm256_srai_epi16(i, 15);
+    __m256i m = _mm256_abs_epi16(i);
+    __m256i mask;
+
+    m = _mm256_min_epi16(_mm256_add_epi16(m, _mm256_set1_epi16(33)),
+                         _mm256_set1_epi16(8191));
+    mask = _mm256_or_si256(_mm256_set1_epi16(0x7F),
+                           _mm256_andnot_si256(sign,
+                                               _mm256_set1_epi16(0x80)));
+    return _mm256_xor_si256(seg_quant_avx2(m), mask);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i alaw_enc_avx2(__m256i x)
+{
+    __m256i i = _mm256_srai_epi16(x, 2);
+    __m256i sign = _mm256_srai_epi16(i, 15);
+    __m256i a = _mm256_min_epi16(_mm256_abs_epi16(i),
+                                 _mm256_set1_epi16(8191));
+    __m256i code, mask;
+
+    code = select_avx2(_mm256_cmpgt_epi16(a, _mm256_set1_epi16(63)),
+                       seg_quant_avx2(a), _mm256_srli_epi16(a, 2));
+    mask = _mm256_or_si256(_mm256_set1_epi16(0x55),
+                           _mm256_andnot_si256(sign,
+                                               _mm256_set1_epi16(0x80)));
+    return _mm256_xor_si256(code, mask);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i ulaw_dec_avx2(__m256i c)
+{
+    const __m256i bias = _mm256_set1_epi16(0x84);
+    __m256i u = _mm256_xor_si256(c, _mm256_set1_epi16(0xFF));
+    __m256i t, e, neg;
+
+    t = _mm256_add_epi16(_mm256_slli_epi16(
+                             _mm256_and_si256(u, _mm256_set1_epi16(0xF)), 3),
+                         bias);
+    e = _mm256_and_si256(_mm256_srli_epi16(u, 4), _mm256_set1_epi16(7));
+    t = _mm256_sub_epi16(shl_var_avx2(t, e), bias);
+
+    neg = _mm256_cmpgt_epi16(u, _mm256_set1_epi16(0x7F));
+    return _mm256_sub_epi16(_mm256_xor_si256(t, neg), neg);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i alaw_dec_avx2(__m256i c)
+{
+    __m256i a = _mm256_xor_si256(c, _mm256_set1_epi16(0x55));
+    __m256i t, seg, neg;
+
+    t = _mm256_add_epi16(_mm256_slli_epi16(
+                             _mm256_and_si256(a, _mm256_set1_epi16(0xF)), 4),
+                         _mm256_set1_epi16(8));
+    seg = _mm256_and_si256(_mm256_srli_epi16(a, 4), _mm256_set1_epi16(7));
+    t = _mm256_add_epi16(t, _mm256_and_si256(
+                                _mm256_cmpgt_epi16(seg,
+                                                   _mm256_setzero_si256()),
+                                _mm256_set1_epi16(0x100)));
+    t = shl_var_avx2(t, _mm256_subs_epu16(seg, _mm256_set1_epi16(1)));
+
+    neg = _mm256_cmpgt_epi16(_mm256_set1_epi16(0x80), a);
+    return _mm256_sub_epi16(_mm256_xor_si256(t, neg), neg);
+}
+
+/* Pack two vectors of codes in 16-bit lanes to 32 bytes, in order. */
+__attribute__((target("avx2")))
+static inline __m256i pack_avx2(__m256i lo, __m256i hi)
+{
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi),
+                                    _MM_SHUFFLE(3,1,2,0));
+}
+
+__attribute__((target("avx2")))
+static void ulaw_encode_avx2(pj_uint8_t *dst, const pj_int16_t *src,
+                             pj_size_t count)
+{
+    pj_size_t i = 0;
+
+    for (; i + 32 <= count; i += 32) {
+        __m256i lo = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i hi = _mm256_loadu_si256((const __m256i*)(src + i + 16));
+        _mm256_storeu_si256((__m256i*)(dst + i),
+                            pack_avx2(ulaw_enc_avx2(lo),
+                                      ulaw_enc_avx2(hi)));
+    }
+    ulaw_encode_sse2(dst + i, src + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void alaw_encode_avx2(pj_uint8_t *dst, const pj_int16_t *src,
+                             pj_size_t count)
+{
+    pj_size_t i = 0;
+
+    for (; i + 32 <= count; i += 32) {
+        __m256i lo = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i hi = _mm256_loadu_si256((const __m256i*)(src + i + 16));
+        _mm256_storeu_si256((__m256i*)(dst + i),
+                            pack_avx2(alaw_enc_avx2(lo),
+                                      alaw_enc_avx2(hi)));
+    }
+    alaw_encode_sse2(dst + i, src + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void ulaw_decode_avx2(pj_int16_t *dst, const pj_uint8_t *src,
+                             pj_size_t len)
+{
+    pj_size_t i = 0;
+
+    for (; i + 32 <= len; i += 32) {
+        __m128i lo = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(src + i + 16));
+        _mm256_storeu_si256((__m256i*)(dst + i),
+                            ulaw_dec_avx2(_mm256_cvtepu8_epi16(lo)));
+        _mm256_storeu_si256((__m256i*)(dst + i + 16),
+                            ulaw_dec_avx2(_mm256_cvtepu8_epi16(hi)));
+    }
+    ulaw_decode_sse2(dst + i, src + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static void alaw_decode_avx2(pj_int16_t *dst, const pj_uint8_t *src,
+                             pj_size_t len)
+{
+    pj_size_t i = 0;
+
+    for (; i + 32 <= len; i += 32) {
+        __m128i lo = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(src + i + 16));
+        _mm256_storeu_si256((__m256i*)(dst + i),
+                            alaw_dec_avx2(_mm256_cvtepu8_epi16(lo)));
+        _mm256_storeu_si256((__m256i*)(dst + i + 16),
+                            alaw_dec_avx2(_mm256_cvtepu8_epi16(hi)));
+    }
+    alaw_decode_sse2(dst + i, src + i, len - i);
+}
+
+static const pjmedia_g711_kernel avx2_kernel =
+{
+    PJMEDIA_G711_KERNEL_AVX2,
+    "avx2",
+    &ulaw_encode_avx2,
+    &alaw_encode_avx2,
+    &ulaw_decode_avx2,
+    &alaw_decode_avx2
+};
+
+#endif  /* HAS_X86_KERNEL */
+
+
+#if HAS_NEON_KERNEL
+/*
+ * NEON implementation, 16 samples per iteration. NEON has variable
+ * shifts, so the shift counts are used directly.
+ */
+
+/* Segment and quantization bits of eight magnitudes, 1 to 8191, using
+ * the count of leading zeros for the position of the highest bit.
+ */
+static inline int16x8_t seg_quant_neon(int16x8_t m)
+{
+    int16x8_t seg = vsubq_s16(vdupq_n_s16(10), vclzq_s16(m));
+    int16x8_t q;
+
+    q = vshlq_s16(m, vnegq_s16(vaddq_s16(seg, vdupq_n_s16(1))));
+    return vorrq_s16(vshlq_n_s16(seg, 4), vandq_s16(q, vdupq_n_s16(0xF)));
+}
+
+static inline uint16x8_t ulaw_enc_neon(int16x8_t x)
+{
+    int16x8_t i = vshrq_n_s16(x, 2);
+    int16x8_t m = vminq_s16(vaddq_s16(vabsq_s16(i), vdupq_n_s16(33)),
+                            vdupq_n_s16(8191));
+    uint16x8_t mask;
+
+    mask = veorq_u16(vdupq_n_u16(0xFF),
+                     vandq_u16(vcltq_s16(i, vdupq_n_s16(0)),
+                               vdupq_n_u16(0x80)));
+    return veorq_u16(vreinterpretq_u16_s16(seg_quant_neon(m)), mask);
+}
+
+static inline uint16x8_t alaw_enc_neon(int16x8_t x)
+{
+    int16x8_t i = vshrq_n_s16(x, 2);
+    int16x8_t a = vminq_s16(vabsq_s16(i), vdupq_n_s16(8191));
+    int16x8_t code;
+    uint16x8_t mask;
+
+    code = vbslq_s16(vcgtq_s16(a, vdupq_n_s16(63)),
+                     seg_quant_neon(vmaxq_s16(a, vdupq_n_s16(1))),
+                     vshrq_n_s16(a, 2));
+    mask = veorq_u16(vdupq_n_u16(0xD5),
+                     vandq_u16(vcltq_s16(i, vdupq_n_s16(0)),
+                               vdupq_n_u16(0x80)));
+    return veorq_u16(vreinterpretq_u16_s16(code), mask);
+}
+
+static inline int16x8_t ulaw_dec_neon(uint16x8_t c)
+{
+    const int16x8_t bias = vdupq_n_s16(0x84);
+    uint16x8_t u = veorq_u16(c, vdupq_n_u16(0xFF));
+    int16x8_t t, e, neg;
+
+    t = vaddq_s16(vreinterpretq_s16_u16(
+                      vshlq_n_u16(vandq_u16(u, vdupq_n_u16(0xF)), 3)),
+                  bias);
+    e = vreinterpretq_s16_u16(vandq_u16(vshrq_n_u16(u, 4),
+                                        vdupq_n_u16(7)));
+    t = vsubq_s16(vshlq_s16(t, e), bias);
+
+    neg = vreinterpretq_s16_u16(vcgtq_u16(u, vdupq_n_u16(0x7F)));
+    return vsubq_s16(veorq_s16(t, neg), neg);
+}
+
+static inline int16x8_t alaw_dec_neon(uint16x8_t c)
+{
+    uint16x8_t a = veorq_u16(c, vdupq_n_u16(0x55));
+    uint16x8_t seg = vandq_u16(vshrq_n_u16(a, 4), vdupq_n_u16(7));
+    uint16x8_t t;
+    int16x8_t neg;
+
+    t = vaddq_u16(vshlq_n_u16(vandq_u16(a, vdupq_n_u16(0xF)), 4),
+                  vdupq_n_u16(8));
+    t = vaddq_u16(t, vandq_u16(vcgtq_u16(seg, vdupq_n_u16(0)),
+                               vdupq_n_u16(0x100)));
+    t = vshlq_u16(t, vreinterpretq_s16_u16(vqsubq_u16(seg,
+                                                      vdupq_n_u16(1))));
+
+    neg = vreinterpretq_s16_u16(vcltq_u16(a, vdupq_n_u16(0x80)));
+    return vsubq_s16(veorq_s16(vreinterpretq_s16_u16(t), neg), neg);
+}
+
+static void ulaw_encode_neon(pj_uint8_t *dst, const pj_int16_t *src,
+                             pj_size_t count)
+{
+    pj_size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        uint8x8_t lo = vmovn_u16(ulaw_enc_neon(vld1q_s16(src + i)));
+        uint8x8_t hi = vmovn_u16(ulaw_enc_neon(vld1q_s16(src + i + 8)));
+        vst1q_u8(dst + i, vcombine_u8(lo, hi));
+    }
+    ulaw_encode_scalar(dst + i, src + i, count - i);
+}
+
+static void alaw_encode_neon(pj_uint8_t *dst, const pj_int16_t *src,
+                             pj_size_t count)
+{
+    pj_size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        uint8x8_t lo = vmovn_u16(alaw_enc_neon(vld1q_s16(src + i)));
+        uint8x8_t hi = vmovn_u16(alaw_enc_neon(vld1q_s16(src + i + 8)));
+        vst1q_u8(dst + i, vcombine_u8(lo, hi));
+    }
+    alaw_encode_scalar(dst + i, src + i, count - i);
+}
+
+static void ulaw_decode_neon(pj_int16_t *dst, const pj_uint8_t *src,
+                             pj_size_t len)
+{
+    pj_size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t c = vld1q_u8(src + i);
+        vst1q_s16(dst + i, ulaw_dec_neon(vmovl_u8(vget_low_u8(c))));
+        vst1q_s16(dst + i + 8, ulaw_dec_neon(vmovl_u8(vget_high_u8(c))));
+    }
+    ulaw_decode_scalar(dst + i, src + i, len - i);
+}
+
+static void alaw_decode_neon(pj_int16_t *dst, const pj_uint8_t *src,
+                             pj_size_t len)
+{
+    pj_size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t c = vld1q_u8(src + i);
+        vst1q_s16(dst + i, alaw_dec_neon(vmovl_u8(vget_low_u8(c))));
+        vst1q_s16(dst + i + 8, alaw_dec_neon(vmovl_u8(vget_high_u8(c))));
+    }
+    alaw_decode_scalar(dst + i, src + i, len - i);
+}
+
+static const pjmedia_g711_kernel neon_kernel =
+{
+    PJMEDIA_G711_KERNEL_NEON,
+    "neon",
+    &ulaw_encode_neon,
+    &alaw_encode_neon,
+    &ulaw_decode_neon,
+    &alaw_decode_neon
+};
+
+#endif  /* HAS_NEON_KERNEL */
+
+
+/* The best implementation for the CPU, selected on the first call. */
+static const pjmedia_g711_kernel *auto_kernel;
+
+PJ_DEF(const pjmedia_g711_kernel*)
+pjmedia_g711_kernel_get(pjmedia_g711_kernel_type type)
+{
+    switch (type) {
+    case PJMEDIA_G711_KERNEL_AUTO:
+        if (auto_kernel == NULL) {
+            const pjmedia_g711_kernel *k = &scalar_kernel;
+#if HAS_X86_KERNEL
+            if (pjmedia_g711_kernel_get(PJMEDIA_G711_KERNEL_AVX2))
+                k = &avx2_kernel;
+            else if (pjmedia_g711_kernel_get(PJMEDIA_G711_KERNEL_SSE2))
+                k = &sse2_kernel;
+#elif HAS_NEON_KERNEL
+            k = &neon_kernel;
+#endif
+            auto_kernel = k;
+        }
+        return auto_kernel;
+
+    case PJMEDIA_G711_KERNEL_SCALAR:
+        return &scalar_kernel;
+
+#if HAS_X86_KERNEL
+    case PJMEDIA_G711_KERNEL_SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2")? &sse2_kernel : NULL;
+
+    case PJMEDIA_G711_KERNEL_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2")? &avx2_kernel : NULL;
+#endif
+
+#if HAS_NEON_KERNEL
+    case PJMEDIA_G711_KERNEL_NEON:
+        return &neon_kernel;
+#endif
+
+    default:
+        return NULL;
+    }
+}
+
+
+PJ_DEF(void) pjmedia_ulaw_encode(pj_uint8_t *dst, const pj_int16_t *src,
+                                 pj_size_t count)
+{
+    pjmedia_g711_kernel_get(PJMEDIA_G711_KERNEL_AUTO)->ulaw_encode(dst, src,
+                                                                   count);
+}
+
+PJ_DEF(void) pjmedia_alaw_encode(pj_uint8_t *dst, const pj_int16_t *src,
+                                 pj_size_t count)
+{
+    pjmedia_g711_kernel_get(PJMEDIA_G711_KERNEL_AUTO)->alaw_encode(dst, src,
+                                                                   count);
+}
+
+PJ_DEF(void) pjmedia_ulaw_decode(pj_int16_t *dst, const pj_uint8_t *src,
+                                 pj_size_t len)
+{
+    pjmedia_g711_kernel_get(PJMEDIA_G711_KERNEL_AUTO)->ulaw_decode(dst, src,
+                                                                   len);
+}
+
+PJ_DEF(void) pjmedia_alaw_decode(pj_int16_t *dst, const pj_uint8_t *src,
+                                 pj_size_t len)
+{
+    pjmedia_g711_kernel_get(PJMEDIA_G711_KERNEL_AUTO)->alaw_decode(dst, src,
+                                                                   len);
+}
@@ -19,6 +19,7 @@
 #include <pjmedia/conference.h>
 #include <pjmedia/alaw_ulaw.h>
 #include <pjmedia/errno.h>
+#include <pjmedia/mix_kernel.h>
 #include <pjmedia/port.h>
 #include <pjmedia/silencedet.h>
 #include <pjmedia/sound_port.h>
@@ -117,6 +118,7 @@ struct pjmedia_conf
     char                  master_name_buf[80]; /**< Port0 name buffer.      */
     pj_mutex_t           *mutex;        /**< Conference mutex.              */
     struct conf_port    **ports;        /**< Array of ports.                */
+    const pjmedia_mix_kernel *mk;       /**< Mixing kernels.                */
     pj_uint8_t            buf[BUFFER_SIZE];     /**< Common buffer.         */
 };
 
@@ -251,6 +253,7 @@ PJ_DEF(pj_status_t) pjmedia_conf_create( pj_pool_t *pool,
 
     conf->options = options;
     conf->max_ports = max_ports;
+    conf->mk = pjmedia_mix_kernel_get(PJMEDIA_MIX_KERNEL_AUTO);
     
     /* Create and initialize the master port interface. */
     conf->master_port = PJ_POOL_ZALLOC_T(pool, pjmedia_port);
@@ -528,6 +531,20 @@ PJ_DEF(pj_status_t) pjmedia_conf_configure_port( pjmedia_conf *conf,
 }
 
 
+/*
+ * Enable or disable passthrough of encoded frames to the port. The switch
+ * board always forwards the frames as is, so it can't be disabled.
+ */
+PJ_DEF(pj_status_t) pjmedia_conf_set_port_passthrough(pjmedia_conf *conf,
+                                                      unsigned slot,
+                                                      pj_bool_t enabled)
+{
+    PJ_ASSERT_RETURN(conf && slot<conf->max_ports, PJ_EINVAL);
+
+    return enabled? PJ_SUCCESS : PJ_ENOTSUP;
+}
+
+
 /*
  * Connect port.
  */
@@ -978,6 +995,22 @@ PJ_DEF(pj_status_t) pjmedia_conf_get_signal_level( pjmedia_conf *conf,
 }
 
 
+/*
+ * Get thread statistics, only supported by the parallel bridge.
+ */
+PJ_DEF(pj_status_t) pjmedia_conf_get_thread_stat(
+                                            pjmedia_conf *conf,
+                                            unsigned *count,
+                                            pjmedia_conf_thread_stat stat[])
+{
+    PJ_UNUSED_ARG(conf);
+    PJ_UNUSED_ARG(count);
+    PJ_UNUSED_ARG(stat);
+
+    return PJ_ENOTSUP;
+}
+
+
 /*
  * Adjust RX level of individual port.
  */
@@ -1064,7 +1097,8 @@ PJ_DEF(pj_status_t) pjmedia_conf_adjust_tx_level( pjmedia_conf *conf,
 /* Deliver frm_src to a listener port, eventually call  port's put_frame() 
  * when samples count in the frm_dst are equal to port's samples_per_frame.
  */
-static pj_status_t write_frame(struct conf_port *cport_dst,
+static pj_status_t write_frame(pjmedia_conf *conf,
+                               struct conf_port *cport_dst,
                                const pjmedia_frame *frm_src)
 {
     pjmedia_frame *frm_dst = (pjmedia_frame*)cport_dst->tx_buf;
@@ -1132,24 +1166,9 @@ static pj_status_t write_frame(struct conf_port *cport_dst,
 
             /* Adjust TX level. */
             if (cport_dst->tx_adj_level != NORMAL_LEVEL) {
-                pj_int16_t *p, *p_end;
-
-                p = f_start;
-                p_end = p + nsamples_to_copy;
-                while (p < p_end) {
-                    pj_int32_t itemp = *p;
-
-                    /* Adjust the level */
-                    itemp = (itemp * cport_dst->tx_adj_level) >> 7;
-
-                    /* Clip the signal if it's too loud */
-                    if (itemp > MAX_LEVEL) itemp = MAX_LEVEL;
-                    else if (itemp < MIN_LEVEL) itemp = MIN_LEVEL;
-
-                    /* Put back in the buffer. */
-                    *p = (pj_int16_t)itemp;
-                    ++p;
-                }
+                conf->mk->apply_gain(f_start, f_start,
+                                     cport_dst->tx_adj_level,
+                                     nsamples_to_copy);
             }
 
             pjmedia_copy_samples((pj_int16_t*)frm_dst->buf + (frm_dst->size>>1),
@@ -1312,26 +1331,10 @@ static pj_status_t get_frame(pjmedia_port *this_port,
             /* Calculate & adjust RX level. */
             if (f->type == PJMEDIA_FRAME_TYPE_AUDIO) {
                 if (cport->rx_adj_level != NORMAL_LEVEL) {
-                    pj_int16_t *p = (pj_int16_t*)f->buf;
-                    pj_int16_t *end;
-
-                    end = p + (f->size >> 1);
-                    while (p < end) {
-                        pj_int32_t itemp = *p;
-
-                        /* Adjust the level */
-                        itemp = (itemp * cport->rx_adj_level) >> 7;
-
-                        /* Clip the signal if it's too loud */
-                        if (itemp > MAX_LEVEL) itemp = MAX_LEVEL;
-                        else if (itemp < MIN_LEVEL) itemp = MIN_LEVEL;
-
-                        level += PJ_ABS(itemp);
-
-                        /* Put back in the buffer. */
-                        *p = (pj_int16_t)itemp;
-                        ++p;
-                    }
+                    level = conf->mk->apply_gain((pj_int16_t*)f->buf,
+                                                 (pj_int16_t*)f->buf,
+                                                 cport->rx_adj_level,
+                                                 (unsigned)(f->size >> 1));
                     level /= (f->size >> 1);
                 } else {
                     level = pjmedia_calc_avg_signal((const pj_int16_t*)f->buf,
@@ -1361,7 +1364,7 @@ static pj_status_t get_frame(pjmedia_port *this_port,
                     continue;
                 }
             
-                status = write_frame(listener, f);
+                status = write_frame(conf, listener, f);
                 if (status != PJ_SUCCESS) {
                     listener->tx_level = 0;
                     continue;
@@ -1535,26 +1538,10 @@ static pj_status_t put_frame(pjmedia_port *this_port,
     /* Calculate & adjust RX level. */
     if (f->type == PJMEDIA_FRAME_TYPE_AUDIO) {
         if (cport->rx_adj_level != NORMAL_LEVEL) {
-            pj_int16_t *p = (pj_int16_t*)f->buf;
-            pj_int16_t *end;
-
-            end = p + (f->size >> 1);
-            while (p < end) {
-                pj_int32_t itemp = *p;
-
-                /* Adjust the level */
-                itemp = (itemp * cport->rx_adj_level) >> 7;
-
-                /* Clip the signal if it's too loud */
-                if (itemp > MAX_LEVEL) itemp = MAX_LEVEL;
-                else if (itemp < MIN_LEVEL) itemp = MIN_LEVEL;
-
-                level += PJ_ABS(itemp);
-
-                /* Put back in the buffer. */
-                *p = (pj_int16_t)itemp;
-                ++p;
-            }
+            level = conf->mk->apply_gain((pj_int16_t*)f->buf,
+                                         (pj_int16_t*)f->buf,
+                                         cport->rx_adj_level,
+                                         (unsigned)(f->size >> 1));
             level /= (f->size >> 1);
         } else {
             level = pjmedia_calc_avg_signal((const pj_int16_t*)f->buf,
@@ -1593,7 +1580,7 @@ static pj_status_t put_frame(pjmedia_port *this_port,
             continue;
         }
             
-        status = write_frame(listener, f);
+        status = write_frame(conf, listener, f);
         if (status != PJ_SUCCESS) {
             listener->tx_level = 0;
             continue;
@@ -25,6 +25,7 @@
 #include <pjmedia/alaw_ulaw.h>
 #include <pjmedia/delaybuf.h>
 #include <pjmedia/errno.h>
+#include <pjmedia/mix_kernel.h>
 #include <pjmedia/port.h>
 #include <pjmedia/resample.h>
 #include <pjmedia/silencedet.h>
@@ -187,6 +188,9 @@ struct conf_port
                                         /**< Array of listeners' level
                                              adjustment.                    */
     unsigned             transmitter_cnt;/**<Number of transmitters.        */
+    unsigned             adj_listener_cnt;/**< Number of listeners with
+                                             connection level adjustment.   */
+    pj_bool_t            self_listen;   /**< Port is its own listener.      */
 
     /* Shortcut for port info. */
     unsigned             sampling_rate; /**< Port's sampling rate.          */
@@ -319,6 +323,30 @@ struct conf_port
                                          * that mixed data into this port's 
                                          * mix_buf during the current tick.*/
 
+    /* mix-minus mode (PJMEDIA_CONF_MIX_MINUS) support                      */
+    pj_timestamp         rx_timestamp;  /**< Timestamp of the tick when
+                                         * rx_frame_buf was added to the
+                                         * bridge's mix_sum                */
+    pj_bool_t            mix_minus;     /**< This tick, the port hears all
+                                         * other sources and its signal is
+                                         * derived from the mix_sum. Its
+                                         * mix_buf only gets the connection
+                                         * level corrections from sources  */
+
+    /* Active speaker policy support                                        */
+    unsigned             speaker_level; /**< RX level with instant attack
+                                         * and slow release, used to rank
+                                         * the sources                     */
+    pj_bool_t            speaking;      /**< The port is selected to be
+                                         * mixed at this tick              */
+
+    /* Work-stealing scheduler support                                      */
+    pj_uint32_t          rx_cost;       /**< Average time to get frame from
+                                         * the port and mix it, in
+                                         * timestamp units                 */
+    pj_uint32_t          tx_cost;       /**< Average time to put frame to
+                                         * the port, in timestamp units    */
+
     pj_atomic_slist     *buff_to_mix;    /**< queue to mix TX (source) data 
                                           * for current RX (listener) port */
     pj_atomic_t         *requests_to_mix;/**< counter of requests to data 
@@ -346,6 +374,38 @@ typedef struct PJ_ATOMIC_SLIST_ALIGN_PREFIX port_slot {
 } PJ_ATOMIC_SLIST_ALIGN_SUFFIX port_slot;
 
 
+/*
+ * Queue of tasks (port slots) of a thread for one phase of the tick,
+ * sorted from the most to the least expensive. Both the owner thread and
+ * the threads stealing from the queue take the tasks from the front.
+ */
+typedef struct task_queue
+{
+    SLOT_TYPE           *task;          /**< Slots of the ports to process  */
+    unsigned             cnt;           /**< Number of tasks                */
+    pj_atomic_t         *next;          /**< Index of the next task to take */
+} task_queue;
+
+
+/*
+ * Thread processing the conference bridge, either the get_frame() thread
+ * (index 0) or a thread of the pool.
+ */
+typedef struct conf_worker
+{
+    pjmedia_conf        *conf;          /**< The conference bridge          */
+    unsigned             idx;           /**< Index in conf->workers[]       */
+    task_queue           rx_queue;      /**< Ports to get frame from        */
+    task_queue           tx_queue;      /**< Ports to put frame to          */
+    pj_uint64_t          load;          /**< Total cost of the tasks given
+                                         * by schedule_phase()             */
+    SLOT_TYPE            task_slot;     /**< Slot of the current task, to
+                                         * measure the port's cost         */
+    pj_timestamp         task_start;    /**< Start time of the current task */
+    pjmedia_conf_thread_stat stat;      /**< Statistics                     */
+} conf_worker;
+
+
 /*
  * Conference bridge.
  */
@@ -414,18 +474,38 @@ struct pjmedia_conf
     pj_event_t          *barrier_evt;     /**< exit barrier                 */
     pj_bool_t            quit_flag;       /**< quit flag for threads        */
     pj_bool_t            running;         /**< thread pool is running       */
-    pj_atomic_t         *active_ports_idx;/**< index of the element of the
-                                           * active_ports[] array processed 
-                                           * by the current thread          */
-    pj_atomic_t         *listener_counter;/**< index of the element of the
-                                           * active_listener[] array 
-                                           * processed by the current thread*/
+    conf_worker         *workers;         /**< Threads, get_frame() thread
+                                           * first, with their task queues  */
+    SLOT_TYPE           *sched_buf;       /**< Ports sorted by cost, used
+                                           * by schedule_phase()            */
     pjmedia_frame       *frame;           /**< Frame buffer for conference 
                                            * bridge at the current tick.    */
     struct conf_port    *sound_port;      /**< Flag: if not NULL this port
                                            * has data in mix_buf to
                                            * return sound playback frame    */
 
+    /* mix-minus mode (PJMEDIA_CONF_MIX_MINUS) support                      */
+    pj_int32_t          *mix_sum;         /**< Sum of all sources received
+                                           * at the current tick            */
+    unsigned             mix_sum_cnt;     /**< Number of sources in mix_sum */
+    unsigned             direct_cnt;      /**< Number of listeners to be
+                                           * mixed source by source         */
+    pj_int32_t          *mix_part;        /**< Per thread partial sums of
+                                           * threads * samples_per_frame    */
+    pj_atomic_t         *mix_part_idx;    /**< Index of the next unused
+                                           * partial sum in mix_part        */
+    pj_lock_t           *mix_lock;        /**< Lock to add partial sums into
+                                           * mix_sum                        */
+
+    const pjmedia_mix_kernel *mk;         /**< Mixing kernels               */
+
+    /* Active speaker policy support                                        */
+    unsigned             max_speakers;    /**< Max sources to mix, 0=all    */
+    unsigned             speaker_hysteresis;/**< Ranking bonus of the
+                                           * current speakers               */
+    unsigned             speaker_cnt;     /**< Number of current speakers   */
+    SLOT_TYPE           *speakers;        /**< Slots of current speakers    */
+    struct conf_port   **ranking;         /**< Ranking buffer               */
 };
 
 
@@ -445,11 +525,16 @@ static pj_status_t destroy_port_pasv(pjmedia_port *this_port);
 
 static inline pj_int16_t *get_read_buffer(struct conf_port *conf_port, pjmedia_frame *frame);
 static pj_status_t thread_pool_start(pjmedia_conf *conf);
-static void perform_get_frame(pjmedia_conf *conf);
+static void schedule_tasks(pjmedia_conf *conf);
+static void perform_get_frame(pjmedia_conf *conf, conf_worker *worker);
 /* Conf thread pool's thread function.*/
 static int conf_thread(void *arg);
 
 /* mix and perhaps transmit data for listener from conf_port */
+static void mix_minus_prepare(pjmedia_conf *conf);
+static void select_speakers(pjmedia_conf *conf);
+static void mix_minus_listener(pjmedia_conf *conf, struct conf_port *listener,
+                               const pj_timestamp *timestamp);
 static void  mix_and_transmit(pjmedia_conf *conf, struct conf_port *listener, 
                               SLOT_TYPE listener_slot,
                               unsigned listener_adj_level, 
@@ -845,7 +930,12 @@ static pj_status_t create_conf_port( pj_pool_t *parent_pool,
         CONF_CHECK_NOT_NULL(conf_port->rx_frame_buf = (pj_int16_t*)pj_pool_zalloc(pool, conf->rx_frame_buf_cap), 
                          {status = PJ_ENOMEM;goto on_return;});
         CONF_CHECK_SUCCESS(status=pj_lock_create_simple_mutex(pool, "tx_lock", &conf_port->tx_lock), goto on_return);
+    } else if (conf->mix_sum) {
+        /* mix-minus mode needs the received frame until the end of tick */
+        CONF_CHECK_NOT_NULL(conf_port->rx_frame_buf = (pj_int16_t*)pj_pool_zalloc(pool, conf->rx_frame_buf_cap), 
+                         {status = PJ_ENOMEM;goto on_return;});
     }
+    conf_port->rx_timestamp.u64 = (pj_uint64_t)-1;
 
     CONF_CHECK_SUCCESS(status=pj_atomic_slist_create(pool, &conf_port->free_node_cache), goto on_return);
     CONF_CHECK_NOT_NULL(free_node = pj_atomic_slist_calloc(pool, 1, sizeof(rx_buffer_slist_node)), 
@@ -1065,6 +1155,7 @@ PJ_DEF(pj_status_t) pjmedia_conf_create2(pj_pool_t *pool_,
     conf->channel_count = param->channel_count;
     conf->samples_per_frame = param->samples_per_frame;
     conf->bits_per_sample = param->bits_per_sample;
+    conf->mk = pjmedia_mix_kernel_get(PJMEDIA_MIX_KERNEL_AUTO);
     conf->threads = param->worker_threads + 1;
     conf->is_parallel = (param->worker_threads>0);
 
@@ -1113,6 +1204,44 @@ PJ_DEF(pj_status_t) pjmedia_conf_create2(pj_pool_t *pool_,
         PJMEDIA_AFD_AVG_FSZ(pjmedia_format_get_audio_format_detail(
                                 &conf->master_port->info.fmt, PJ_TRUE));
 
+    /* Create the sum buffers for mix-minus mode. */
+    if (conf->options & PJMEDIA_CONF_MIX_MINUS) {
+        conf->mix_sum = (pj_int32_t*)
+                        pj_pool_calloc(pool, conf->samples_per_frame,
+                                       sizeof(conf->mix_sum[0]));
+        PJ_ASSERT_ON_FAIL(conf->mix_sum, 
+                          { status = PJ_ENOMEM; goto on_return; });
+
+        if (conf->is_parallel) {
+            conf->mix_part = (pj_int32_t*)
+                             pj_pool_calloc(pool, conf->threads *
+                                                  conf->samples_per_frame,
+                                            sizeof(conf->mix_part[0]));
+            PJ_ASSERT_ON_FAIL(conf->mix_part, 
+                              { status = PJ_ENOMEM; goto on_return; });
+
+            status = pj_atomic_create(pool, 0, &conf->mix_part_idx);
+            PJ_ASSERT_ON_FAIL(status == PJ_SUCCESS, goto on_return);
+
+            status = pj_lock_create_simple_mutex(pool, "mix_lock",
+                                                 &conf->mix_lock);
+            PJ_ASSERT_ON_FAIL(status == PJ_SUCCESS, goto on_return);
+        }
+    }
+
+    if (param->max_speakers) {
+        conf->max_speakers = param->max_speakers;
+        conf->speaker_hysteresis = param->speaker_hysteresis;
+        conf->speakers = (SLOT_TYPE*)
+                         pj_pool_calloc(pool, param->max_speakers,
+                                        sizeof(conf->speakers[0]));
+        conf->ranking = (struct conf_port**)
+                        pj_pool_calloc(pool, param->max_speakers,
+                                       sizeof(conf->ranking[0]));
+        PJ_ASSERT_ON_FAIL(conf->speakers && conf->ranking,
+                          { status = PJ_ENOMEM; goto on_return; });
+    }
+
     /* Create port zero for sound device. */
     status = create_sound_port(pool, conf);
     if (status != PJ_SUCCESS) {
@@ -1172,11 +1301,46 @@ PJ_DEF(pj_status_t) pjmedia_conf_create2(pj_pool_t *pool_,
         }
     }
 
-    status = pj_atomic_create(conf->pool, 0, &conf->active_ports_idx);
-    PJ_ASSERT_ON_FAIL(status == PJ_SUCCESS, goto on_return);
+    /* Create the threads' task queues. With worker threads, the queues
+     * are filled by schedule_tasks(), otherwise the single queue of each
+     * phase is the active ports array.
+     */
+    conf->workers = (conf_worker*)
+                    pj_pool_calloc(pool, conf->threads, sizeof(conf_worker));
+    PJ_ASSERT_ON_FAIL(conf->workers, { status = PJ_ENOMEM; goto on_return; });
+
+    for (i = 0; i < (unsigned)conf->threads; ++i) {
+        conf_worker *worker = &conf->workers[i];
 
-    status = pj_atomic_create(conf->pool, 0, &conf->listener_counter);
-    PJ_ASSERT_ON_FAIL(status == PJ_SUCCESS, goto on_return);
+        worker->conf = conf;
+        worker->idx = i;
+        worker->task_slot = INVALID_SLOT;
+
+        status = pj_atomic_create(pool, 0, &worker->rx_queue.next);
+        PJ_ASSERT_ON_FAIL(status == PJ_SUCCESS, goto on_return);
+
+        status = pj_atomic_create(pool, 0, &worker->tx_queue.next);
+        PJ_ASSERT_ON_FAIL(status == PJ_SUCCESS, goto on_return);
+
+        if (conf->is_parallel) {
+            worker->rx_queue.task = (SLOT_TYPE*)
+                                    pj_pool_calloc(pool, conf->max_ports,
+                                                   sizeof(SLOT_TYPE));
+            worker->tx_queue.task = (SLOT_TYPE*)
+                                    pj_pool_calloc(pool, conf->max_ports,
+                                                   sizeof(SLOT_TYPE));
+            PJ_ASSERT_ON_FAIL(worker->rx_queue.task && worker->tx_queue.task,
+                              { status = PJ_ENOMEM; goto on_return; });
+        }
+    }
+
+    if (conf->is_parallel) {
+        conf->sched_buf = (SLOT_TYPE*)
+                          pj_pool_calloc(pool, conf->max_ports,
+                                         sizeof(SLOT_TYPE));
+        PJ_ASSERT_ON_FAIL(conf->sched_buf,
+                          { status = PJ_ENOMEM; goto on_return; });
+    }
 
     if (conf->is_parallel) {
         status = thread_pool_start(conf);
@@ -1328,10 +1492,26 @@ PJ_DEF(pj_status_t) pjmedia_conf_destroy( pjmedia_conf *conf )
         pj_mutex_destroy(conf->mutex);
 
     /* Destroy atomic */
-    if (conf->active_ports_idx)
-        CONF_CHECK_SUCCESS(pj_atomic_destroy(conf->active_ports_idx), (void)0);
-    if (conf->listener_counter)
-        CONF_CHECK_SUCCESS(pj_atomic_destroy(conf->listener_counter), (void)0);
+    if (conf->workers) {
+        pj_atomic_value_t i;
+
+        for (i = 0; i < conf->threads; ++i) {
+            conf_worker *worker = &conf->workers[i];
+
+            if (worker->rx_queue.next)
+                CONF_CHECK_SUCCESS(pj_atomic_destroy(worker->rx_queue.next),
+                                   (void)0);
+            if (worker->tx_queue.next)
+                CONF_CHECK_SUCCESS(pj_atomic_destroy(worker->tx_queue.next),
+                                   (void)0);
+        }
+    }
+    if (conf->mix_part_idx)
+        CONF_CHECK_SUCCESS(pj_atomic_destroy(conf->mix_part_idx), (void)0);
+
+    /* Destroy mix-minus lock */
+    if (conf->mix_lock)
+        pj_lock_destroy(conf->mix_lock);
 
     /* Destroy pool */
     if (conf->pool)
@@ -1767,6 +1947,22 @@ PJ_DEF(pj_status_t) pjmedia_conf_configure_port( pjmedia_conf *conf,
 }
 
 
+/*
+ * Enable or disable passthrough of encoded frames to the port, only
+ * supported by the serial bridge.
+ */
+PJ_DEF(pj_status_t) pjmedia_conf_set_port_passthrough(pjmedia_conf *conf,
+                                                      unsigned slot,
+                                                      pj_bool_t enabled)
+{
+    PJ_UNUSED_ARG(conf);
+    PJ_UNUSED_ARG(slot);
+    PJ_UNUSED_ARG(enabled);
+
+    return PJ_ENOTSUP;
+}
+
+
 /*
  * Connect port.
  */
@@ -1878,6 +2074,12 @@ static pj_status_t op_connect_ports(pjmedia_conf *conf,
     src_port->listener_adj_level[src_port->listener_cnt] =
                                 prm->connect_ports.adj_level + NORMAL_LEVEL;
 
+    /* Update the counters used by mix-minus mode. */
+    if (prm->connect_ports.adj_level != 0)
+        ++src_port->adj_listener_cnt;
+    if (src_slot == sink_slot)
+        src_port->self_listen = PJ_TRUE;
+
     ++conf->connect_cnt;
     ++dst_port->transmitter_cnt;
 
@@ -1994,6 +2196,13 @@ static pj_status_t op_disconnect_ports(pjmedia_conf *conf,
                   src_port->listener_cnt <= conf->max_ports);
         pj_assert(dst_port->transmitter_cnt > 0 &&
                   dst_port->transmitter_cnt <= conf->max_ports);
+
+        /* Update the counters used by mix-minus mode. */
+        if (src_port->listener_adj_level[idx] != NORMAL_LEVEL)
+            --src_port->adj_listener_cnt;
+        if (src_slot == sink_slot)
+            src_port->self_listen = PJ_FALSE;
+
         pj_array_erase(src_port->listener_slots, sizeof(SLOT_TYPE),
                        src_port->listener_cnt, idx);
         pj_array_erase(src_port->listener_adj_level, sizeof(unsigned),
@@ -2149,6 +2358,12 @@ static pj_status_t op_adjust_conn_level(pjmedia_conf *conf,
         return PJ_EINVAL;
     }
 
+    /* Update the counter used by mix-minus mode. */
+    if (src_port->listener_adj_level[i] != NORMAL_LEVEL)
+        --src_port->adj_listener_cnt;
+    if (prm->adjust_conn_level.adj_level != 0)
+        ++src_port->adj_listener_cnt;
+
     /* Set normalized adjustment level. */
     src_port->listener_adj_level[i] =
                             prm->adjust_conn_level.adj_level + NORMAL_LEVEL;
@@ -2750,6 +2965,28 @@ PJ_DEF(pj_status_t) pjmedia_conf_get_signal_level( pjmedia_conf *conf,
 }
 
 
+/*
+ * Get thread statistics.
+ */
+PJ_DEF(pj_status_t) pjmedia_conf_get_thread_stat(
+                                            pjmedia_conf *conf,
+                                            unsigned *count,
+                                            pjmedia_conf_thread_stat stat[])
+{
+    unsigned i;
+
+    PJ_ASSERT_RETURN(conf && count && stat, PJ_EINVAL);
+
+    if (*count > (unsigned)conf->threads)
+        *count = (unsigned)conf->threads;
+
+    for (i = 0; i < *count; ++i)
+        pj_memcpy(&stat[i], &conf->workers[i].stat, sizeof(stat[i]));
+
+    return PJ_SUCCESS;
+}
+
+
 /*
  * Adjust RX level of individual port.
  */
@@ -2874,12 +3111,27 @@ PJ_DEF(pj_status_t) pjmedia_conf_adjust_conn_level( pjmedia_conf *conf,
 }
 
 
+/*
+ * Calculate the average absolute level of the samples.
+ */
+static pj_int32_t calc_avg_level(pjmedia_conf *conf,
+                                 const pj_int16_t *buf, unsigned count)
+{
+    return count? (pj_int32_t)(conf->mk->sum_abs(buf, count) / count) : 0;
+}
+
 /*
  * Read from port.
+ *
+ * If p_level is not NULL, the frame is read only to get its level: the
+ * samples are not converted to the bridge's clock rate and the content of
+ * the frame buffer is unspecified. The average absolute level of the frame
+ * is returned in p_level, before any level adjustment.
  */
 static pj_status_t read_port( pjmedia_conf *conf,
                               struct conf_port *cport, pj_int16_t *frame,
-                              pj_size_t count, pjmedia_frame_type *type )
+                              pj_size_t count, pjmedia_frame_type *type,
+                              pj_int32_t *p_level )
 {
 
     pj_assert(count == conf->samples_per_frame);
@@ -2908,6 +3160,12 @@ static pj_status_t read_port( pjmedia_conf *conf,
 
         *type = f.type;
 
+        if (p_level && status == PJ_SUCCESS &&
+            f.type == PJMEDIA_FRAME_TYPE_AUDIO)
+        {
+            *p_level = calc_avg_level(conf, frame, (unsigned)count);
+        }
+
         return status;
 
     } else {
@@ -2986,11 +3244,23 @@ static pj_status_t read_port( pjmedia_conf *conf,
             pj_assert(cport->rx_buf_count <= cport->rx_buf_cap);
         }
 
+        /*
+         * When only the level is wanted, take it from the samples in the
+         * port's clock rate and discard them.
+         */
+        if (p_level) {
+            *p_level = calc_avg_level(conf, cport->rx_buf, samples_req);
+            cport->rx_buf_count -= samples_req;
+            if (cport->rx_buf_count) {
+                pjmedia_move_samples(cport->rx_buf, cport->rx_buf+samples_req,
+                                     cport->rx_buf_count);
+            }
+
         /*
          * If port's clock_rate is different, resample.
          * Otherwise just copy.
          */
-        if (cport->sampling_rate != conf->sampling_rate) {
+        } else if (cport->sampling_rate != conf->sampling_rate) {
             
             unsigned src_count;
 
@@ -3033,9 +3303,8 @@ static pj_status_t write_port(pjmedia_conf *conf, struct conf_port *cport,
                               pjmedia_frame_type *frm_type)
 {
     pj_int16_t *buf;
-    pj_int32_t *mix_buf;
     unsigned samples_per_frame;
-    unsigned j, ts;
+    unsigned ts;
     pj_status_t status;
     pj_int32_t adj_level;
     pj_int32_t tx_level;
@@ -3131,57 +3400,13 @@ static pj_status_t write_port(pjmedia_conf *conf, struct conf_port *cport,
     adj_level = cport->tx_adj_level * cport->mix_adj;
     adj_level >>= 7;
 
-    tx_level = 0;
-    
-    /* Loops that support the MSVS Auto-Vectorizer feature must at least 
-     * not use global variables (create local copies of such variables) and 
-     * as a general rule not contains control flow-for example, "if" or "?:".
-     * All math functions support the Auto-Vectorizer feature.
-     * 
-     * You can specify the /Qvec-report (Auto-Vectorizer Reporting Level) 
-     * command-line option to report either successfully vectorized loops 
-     * only-/Qvec-report:1-or both successfully and unsuccessfully vectorized 
-     * loops-/Qvec-report:2).
-     * 
-     * See more: https://learn.microsoft.com/en-us/cpp/parallel/auto-parallelization-and-auto-vectorization?view=msvc-170&redirectedfrom=MSDN
-     * 
-     * Here we create local copies to automatically vectorize the main loops.
+    /* Convert the mixed samples from 32bit to 16bit in the mix_buf itself,
+     * adjusting the level, and calculate the average level at the same time.
      */
-
     buf = (pj_int16_t*) cport->mix_buf;
-    mix_buf = cport->mix_buf;
     samples_per_frame = conf->samples_per_frame;
-
-    if (adj_level != NORMAL_LEVEL) {
-        //loop vectorized
-        for (j=0; j<samples_per_frame; ++j) {
-            pj_int32_t itemp = mix_buf[j];
-
-            /* Adjust the level */
-            /*itemp = itemp * adj_level / NORMAL_LEVEL;*/
-            itemp = (itemp * adj_level) >> 7;
-
-            /* Clip the signal if it's too loud */
-            if (itemp > MAX_LEVEL) itemp = MAX_LEVEL;
-            else if (itemp < MIN_LEVEL) itemp = MIN_LEVEL;
-
-            /* Put back in the buffer. */
-            buf[j] = (pj_int16_t) itemp;
-
-            //auto-vectorizing compatible:
-            tx_level += abs(buf[j]);
-            //prevent auto-vectorizing:
-            //tx_level += (buf[j]>=0? buf[j] : -buf[j]);
-        }
-    } else {
-        //loop vectorized
-        for (j=0; j<samples_per_frame; ++j) {
-            buf[j] = (pj_int16_t) mix_buf[j];
-            tx_level += abs(buf[j]);
-            //tx_level += (buf[j]>=0? buf[j] : -buf[j]);
-        }
-    }
-
+    tx_level = conf->mk->clamp(buf, cport->mix_buf, adj_level,
+                               samples_per_frame);
     tx_level /= samples_per_frame;
 
     /* Convert level to 8bit complement ulaw */
@@ -3348,12 +3573,17 @@ static pj_status_t get_frame(pjmedia_port *this_port,
     /* Force frame type NONE */
     frame->type = PJMEDIA_FRAME_TYPE_NONE;
 
-    pj_atomic_set(conf->active_ports_idx, conf->upper_bound);
-    pj_atomic_set(conf->listener_counter, conf->upper_bound_reg);
+    schedule_tasks(conf);
 
     conf->frame = frame;
     conf->sound_port = NULL;
 
+    if (conf->max_speakers)
+        select_speakers(conf);
+
+    if (conf->mix_sum)
+        mix_minus_prepare(conf);
+
     /* Step 2-3
      * Get frames from all ports, and "mix" the signal
      * to mix_buf of all listeners of the port and
@@ -3378,14 +3608,13 @@ static pj_status_t get_frame(pjmedia_port *this_port,
                     rc));
     }
 
-    perform_get_frame(conf);
+    perform_get_frame(conf, &conf->workers[0]);
 
     if (conf->is_parallel) {
         /* wait until all worker threads have completed their work */
         CONF_CHECK_SUCCESS(pj_event_wait(conf->barrier_evt),(void)0);
         pj_atomic_set(conf->active_thread_cnt, conf->threads-1);
     }
-    pj_assert(pj_atomic_get(conf->active_ports_idx) == -conf->threads);
 
     /* Return sound playback frame. */
     if (conf->sound_port != NULL) {
@@ -3454,7 +3683,7 @@ static pj_status_t thread_pool_start(pjmedia_conf *conf)
         char        obj_name[PJ_MAX_OBJ_NAME];
         pj_ansi_snprintf(obj_name, sizeof(obj_name), "conf_pool_%d", i);
 
-        CONF_CHECK_SUCCESS(pj_thread_create(conf->pool, obj_name, &conf_thread, conf, 0, 0, &conf->pool_threads[i]), 
+        CONF_CHECK_SUCCESS(pj_thread_create(conf->pool, obj_name, &conf_thread, &conf->workers[i+1], 0, 0, &conf->pool_threads[i]), 
                            return tmp_status_);
     }
 
@@ -3468,7 +3697,8 @@ static pj_status_t thread_pool_start(pjmedia_conf *conf)
  */
 static int conf_thread(void *arg)
 {
-    pjmedia_conf *conf = (pjmedia_conf *)arg;
+    conf_worker *worker = (conf_worker *)arg;
+    pjmedia_conf *conf = worker->conf;
     pj_int32_t rc;
     pj_assert(conf->is_parallel);
 
@@ -3512,7 +3742,7 @@ static int conf_thread(void *arg)
                           rc));
             }
 
-            perform_get_frame(conf);
+            perform_get_frame(conf, worker);
 
             /* signal to the get_frame() thread if all worker threads have completed their work */
             if (!pj_atomic_dec_and_get(conf->active_thread_cnt))
@@ -3524,23 +3754,193 @@ static int conf_thread(void *arg)
     return 0;
 }
 
-static void perform_get_frame(pjmedia_conf *conf)
+/* Cost class of a port for the scheduling, i.e. the bit length of the cost.
+ * Ports are only reordered when their costs differ by a factor of two, so
+ * the timing jitter of ports of similar cost does not matter.
+ */
+static unsigned cost_class(pj_uint32_t cost)
+{
+    unsigned cls = 0;
+
+    while (cost) {
+        ++cls;
+        cost >>= 1;
+    }
+    return cls;
+}
+
+static pj_uint32_t port_cost(pjmedia_conf *conf, SLOT_TYPE slot, pj_bool_t rx)
+{
+    struct conf_port *cport = conf->ports[slot];
+
+    if (!cport)
+        return 0;
+    return rx? cport->rx_cost : cport->tx_cost;
+}
+
+/*
+ * Distribute the ports of a phase of the tick to the threads' queues.
+ * The ports are sorted by cost class from the most expensive one, then
+ * each port is given to the thread with the least total cost so far
+ * (longest processing time first). A thread that has finished its own
+ * queue steals the tasks left in the queues of the other threads, which
+ * covers the error of the cost estimates.
+ */
+static void schedule_phase(pjmedia_conf *conf, const SLOT_TYPE *slots,
+                           unsigned cnt, pj_bool_t rx)
+{
+    unsigned start[33];
+    unsigned i, j;
+
+    /* Counting sort by cost class, most expensive first */
+    pj_bzero(start, sizeof(start));
+    for (i = 0; i < cnt; ++i)
+        ++start[cost_class(port_cost(conf, slots[i], rx))];
+    i = PJ_ARRAY_SIZE(start);
+    j = 0;
+    while (i--) {
+        unsigned n = start[i];
+        start[i] = j;
+        j += n;
+    }
+    for (i = 0; i < cnt; ++i) {
+        unsigned cls = cost_class(port_cost(conf, slots[i], rx));
+        conf->sched_buf[start[cls]++] = slots[i];
+    }
+
+    for (i = 0; i < (unsigned)conf->threads; ++i) {
+        conf_worker *worker = &conf->workers[i];
+        task_queue *queue = rx? &worker->rx_queue : &worker->tx_queue;
+
+        queue->cnt = 0;
+        pj_atomic_set(queue->next, 0);
+        worker->load = 0;
+    }
+
+    for (i = 0; i < cnt; ++i) {
+        SLOT_TYPE slot = conf->sched_buf[i];
+        conf_worker *worker = &conf->workers[0];
+        task_queue *queue;
+
+        for (j = 1; j < (unsigned)conf->threads; ++j) {
+            if (conf->workers[j].load < worker->load)
+                worker = &conf->workers[j];
+        }
+
+        queue = rx? &worker->rx_queue : &worker->tx_queue;
+        queue->task[queue->cnt++] = slot;
+        /* Count a port with no cost yet as one unit, to spread such ports */
+        worker->load += port_cost(conf, slot, rx) + 1;
+    }
+}
+
+/*
+ * Fill the threads' task queues for the current tick.
+ * This is called by get_frame() thread before the worker threads start.
+ */
+static void schedule_tasks(pjmedia_conf *conf)
+{
+    if (!conf->is_parallel) {
+        conf_worker *worker = &conf->workers[0];
+
+        worker->rx_queue.task = conf->active_ports;
+        worker->rx_queue.cnt = conf->upper_bound;
+        pj_atomic_set(worker->rx_queue.next, 0);
+        worker->tx_queue.task = conf->active_listener;
+        worker->tx_queue.cnt = conf->upper_bound_reg;
+        pj_atomic_set(worker->tx_queue.next, 0);
+        return;
+    }
+
+    schedule_phase(conf, conf->active_ports, conf->upper_bound, PJ_TRUE);
+    schedule_phase(conf, conf->active_listener, conf->upper_bound_reg,
+                   PJ_FALSE);
+}
+
+/*
+ * Take the next task of a phase of the tick, from the thread's own queue
+ * first, then from the queues of the other threads. With worker threads,
+ * the time since the previous task was taken is added to the average cost
+ * of the port of that task.
+ */
+static pj_bool_t take_task(pjmedia_conf *conf, conf_worker *worker,
+                           pj_bool_t rx, SLOT_TYPE *slot)
+{
+    unsigned i;
+
+    if (conf->is_parallel) {
+        pj_timestamp now;
+
+        pj_get_timestamp(&now);
+        if (worker->task_slot != INVALID_SLOT) {
+            struct conf_port *cport = conf->ports[worker->task_slot];
+
+            if (cport) {
+                pj_uint32_t *cost = rx? &cport->rx_cost : &cport->tx_cost;
+                pj_uint32_t elapsed = now.u32.lo - worker->task_start.u32.lo;
+
+                /* Moving average of the last 8 ticks or so */
+                *cost = *cost - (*cost >> 3) + (elapsed >> 3);
+            }
+            worker->task_slot = INVALID_SLOT;
+        }
+        worker->task_start = now;
+    }
+
+    for (i = 0; i < (unsigned)conf->threads; ++i) {
+        conf_worker *owner = &conf->workers[(worker->idx + i) %
+                                            conf->threads];
+        task_queue *queue = rx? &owner->rx_queue : &owner->tx_queue;
+        pj_atomic_value_t idx;
+
+        /* Don't touch the counter of a queue that is done */
+        if (pj_atomic_get(queue->next) >= (pj_atomic_value_t)queue->cnt)
+            continue;
+
+        idx = pj_atomic_inc_and_get(queue->next) - 1;
+        if (idx >= (pj_atomic_value_t)queue->cnt)
+            continue;
+
+        /* Without worker threads, keep processing the active ports from
+         * the last one as before, so the mixing order stays the same.
+         */
+        if (!conf->is_parallel)
+            idx = queue->cnt - 1 - idx;
+
+        *slot = queue->task[idx];
+        ++worker->stat.tasks;
+        if (owner != worker)
+            ++worker->stat.stolen;
+        if (conf->is_parallel)
+            worker->task_slot = *slot;
+        return PJ_TRUE;
+    }
+
+    return PJ_FALSE;
+}
+
+static void perform_get_frame(pjmedia_conf *conf, conf_worker *worker)
 {
 
     pj_status_t status;
-    pj_atomic_value_t i;
+    SLOT_TYPE port_idx;
     pjmedia_frame *frame = conf->frame;
+    pj_int32_t *mix_part = NULL;
+    unsigned mix_part_cnt = 0;
+    pj_timestamp t_start, t_rx_done, t_tx_start, t_end;
+    pj_uint32_t busy_usec;
+
+    pj_get_timestamp(&t_start);
 
-    while ((i = pj_atomic_dec_and_get(conf->active_ports_idx)) >= 0) {
+    while (take_task(conf, worker, PJ_TRUE, &port_idx)) {
         pj_int16_t *p_in;
-        unsigned j, samples_per_frame = conf->samples_per_frame;
+        unsigned samples_per_frame = conf->samples_per_frame;
         pj_int32_t cj, listener_cnt;
         pj_int32_t level = 0;
-        SLOT_TYPE port_idx;
         struct conf_port *conf_port;
         unsigned rx_adj_level;
+        pj_bool_t level_only;
 
-        port_idx = conf->active_ports[i];
         pj_assert(port_idx < conf->max_ports);
         conf_port = conf->ports[port_idx];
         PJ_ASSERT_ON_FAIL(conf_port, continue);
@@ -3552,6 +3952,12 @@ static void perform_get_frame(pjmedia_conf *conf)
             continue;
         }
 
+        /* The active speaker policy only needs the level of a source
+         * that is not selected to be mixed, so that it can be selected
+         * on the next tick.
+         */
+        level_only = (conf->max_speakers && !conf_port->speaking);
+
         p_in = get_read_buffer(conf_port, frame);
         /* Get frame from this port.
          * For passive ports, get the frame from the delay_buf.
@@ -3573,6 +3979,9 @@ static void perform_get_frame(pjmedia_conf *conf)
                 continue;
             } 
 
+            if (level_only)
+                level = calc_avg_level(conf, p_in, samples_per_frame);
+
         } else {
             pjmedia_frame_type frame_type;
 
@@ -3580,7 +3989,8 @@ static void perform_get_frame(pjmedia_conf *conf)
             pj_assert(frame->size == conf/*_port */->rx_frame_buf_cap);
             /* read data to different buffers to different conf_port's parallel processing */
             status = read_port(conf, conf_port, p_in,
-                               conf->samples_per_frame, &frame_type);
+                               conf->samples_per_frame, &frame_type,
+                               level_only? &level : NULL);
 
             /* Check that the port is not removed when we call get_frame() */
             /*
@@ -3646,40 +4056,25 @@ static void perform_get_frame(pjmedia_conf *conf)
             }
         }
 
+        if (level_only) {
+            /* Apply the RX level adjustment to the level only */
+            level = (level * (pj_int32_t)rx_adj_level) >> 7;
+            if (level > MAX_LEVEL)
+                level = MAX_LEVEL;
+
+            /* Convert level to 8bit complement ulaw */
+            conf_port->rx_level = pjmedia_linear2ulaw(level) ^ 0xff;
+            continue;
+        }
+
         /* Adjust the RX level from this port
          * and calculate the average level at the same time.
          */
         if (rx_adj_level != NORMAL_LEVEL) {
-            //loop vectorized
-            for (j=0; j<samples_per_frame; ++j) {
-                /* For the level adjustment, we need to store the sample to
-                 * a temporary 32bit integer value to avoid overflowing the
-                 * 16bit sample storage.
-                 */
-                pj_int32_t itemp;
-
-                itemp = p_in[j];
-                /*itemp = itemp * adj / NORMAL_LEVEL;*/
-                /* bad code (signed/unsigned badness):
-                 *  itemp = (itemp * conf_port->rx_adj_level) >> 7;
-                 */
-                itemp *= rx_adj_level;
-                itemp >>= 7;
-
-                /* Clip the signal if it's too loud */
-                if (itemp > MAX_LEVEL) itemp = MAX_LEVEL;
-                else if (itemp < MIN_LEVEL) itemp = MIN_LEVEL;
-
-                p_in[j] = (pj_int16_t) itemp;
-                level += abs(p_in[j]);
-                //level += (p_in[j]>=0 ? p_in[j] : -p_in[j]);
-            }
+            level = conf->mk->apply_gain(p_in, p_in, rx_adj_level,
+                                         samples_per_frame);
         } else {
-            //loop vectorized
-            for (j=0; j<samples_per_frame; ++j) {
-                level += abs(p_in[j]);
-                //level += (p_in[j]>=0 ? p_in[j] : -p_in[j]);
-            }
+            level = conf->mk->sum_abs(p_in, samples_per_frame);
         }
 
         level /= samples_per_frame;
@@ -3696,6 +4091,36 @@ static void perform_get_frame(pjmedia_conf *conf)
         //if (level == 0)
         //    continue;
 
+        /* In mix-minus mode, add the signal to the sum of all sources.
+         * With worker threads, each thread sums into its own partial
+         * buffer first, which is added to the mix_sum before the barrier.
+         */
+        if (conf->mix_sum) {
+            if (mix_part == NULL) {
+                if (conf->is_parallel) {
+                    pj_atomic_value_t idx;
+
+                    idx = pj_atomic_inc_and_get(conf->mix_part_idx) - 1;
+                    pj_assert(idx >= 0 && idx < conf->threads);
+                    mix_part = conf->mix_part + idx * samples_per_frame;
+                    pj_bzero(mix_part, samples_per_frame * sizeof(*mix_part));
+                } else {
+                    mix_part = conf->mix_sum;
+                }
+            }
+            conf->mk->accumulate(mix_part, p_in, samples_per_frame,
+                                 NULL, NULL);
+            ++mix_part_cnt;
+            conf_port->rx_timestamp = frame->timestamp;
+
+            /* Listeners hearing all sources will take the signal from the
+             * sum, so we are done with this port if it has no listener to
+             * be mixed individually and no connection level to correct.
+             */
+            if (conf->direct_cnt == 0 && conf_port->adj_listener_cnt == 0)
+                continue;
+        }
+
         /* Add the signal to all listeners. */
         for (cj = 0, listener_cnt = conf_port->listener_cnt; cj < listener_cnt; ++cj) {
             struct conf_port *listener;
@@ -3718,6 +4143,15 @@ static void perform_get_frame(pjmedia_conf *conf)
                 continue;
             }
 
+            /* Mix-minus listener gets the signal from the sum, only the
+             * correction for connection level, if not normal, is needed.
+             */
+            if (listener->mix_minus &&
+                conf_port->listener_adj_level[cj] == NORMAL_LEVEL)
+            {
+                continue;
+            }
+
             mix_node = pj_atomic_slist_pop(listener->free_node_cache);
             pj_assert(mix_node || (listener->transmitter_cnt > 1 && conf->is_parallel));
             pj_assert(conf->is_parallel == (listener->tx_lock != NULL));
@@ -3769,6 +4203,21 @@ static void perform_get_frame(pjmedia_conf *conf)
 
     } /* loop of all conf ports */
 
+    /* Add this thread's partial sum into the mix_sum. */
+    if (mix_part) {
+        if (mix_part != conf->mix_sum) {
+            pj_lock_acquire(conf->mix_lock);
+            conf->mk->accumulate32(conf->mix_sum, mix_part, NULL,
+                                   conf->samples_per_frame, NULL, NULL);
+            conf->mix_sum_cnt += mix_part_cnt;
+            pj_lock_release(conf->mix_lock);
+        } else {
+            conf->mix_sum_cnt += mix_part_cnt;
+        }
+    }
+
+    pj_get_timestamp(&t_rx_done);
+
     if (conf->is_parallel) {
         pj_int32_t rc;
         TRACE_EX((THIS_FILE, "%s: timestamp=%llu, ARRIVE AT BARRIER",
@@ -3788,14 +4237,19 @@ static void perform_get_frame(pjmedia_conf *conf)
         PJ_UNUSED_ARG(rc);
     }
 
+    pj_get_timestamp(&t_tx_start);
+
     /* Step 3
      * Time for all ports to transmit whatever they have in their
      * buffer.
      */
-    while ((i = pj_atomic_dec_and_get(conf->listener_counter)) >= 0) {
-        SLOT_TYPE port_idx = conf->active_listener[i];
+    while (take_task(conf, worker, PJ_FALSE, &port_idx)) {
         struct conf_port *listener = conf->ports[port_idx];
         pjmedia_frame_type frame_type;
+
+        if (listener->mix_minus)
+            mix_minus_listener(conf, listener, &frame->timestamp);
+
         status = write_port(conf, listener, &frame->timestamp, &frame_type);
 #if 0
         if (status != PJ_SUCCESS) {
@@ -3824,6 +4278,172 @@ static void perform_get_frame(pjmedia_conf *conf)
             conf->sound_port = listener;
         }
     }
+
+    /* Update this thread's statistics */
+    pj_get_timestamp(&t_end);
+    busy_usec = pj_elapsed_usec(&t_start, &t_rx_done) +
+                pj_elapsed_usec(&t_tx_start, &t_end);
+    ++worker->stat.ticks;
+    worker->stat.total_busy_usec += busy_usec;
+    worker->stat.total_wait_usec += pj_elapsed_usec(&t_rx_done, &t_tx_start);
+    worker->stat.last_busy_usec = busy_usec;
+    if (busy_usec > worker->stat.max_busy_usec)
+        worker->stat.max_busy_usec = busy_usec;
+}
+
+/*
+ * Prepare mix-minus mode for the current tick: reset the mix_sum and find
+ * the listeners that hear every source other than themselves. As all
+ * transmitters of a port are sources, comparing the counts is enough.
+ * This is called by get_frame() thread before the worker threads start.
+ */
+static void mix_minus_prepare(pjmedia_conf *conf)
+{
+    pj_uint32_t i;
+
+    pj_bzero(conf->mix_sum, conf->samples_per_frame * sizeof(conf->mix_sum[0]));
+    conf->mix_sum_cnt = 0;
+    conf->direct_cnt = 0;
+    if (conf->mix_part_idx)
+        pj_atomic_set(conf->mix_part_idx, 0);
+
+    for (i = 0; i < conf->upper_bound_reg; ++i) {
+        struct conf_port *listener = conf->ports[conf->active_listener[i]];
+        unsigned others;
+
+        listener->mix_minus = PJ_FALSE;
+        if (!listener->transmitter_cnt ||
+            listener->tx_setting != PJMEDIA_PORT_ENABLE)
+        {
+            continue;
+        }
+
+        others = listener->transmitter_cnt - (listener->self_listen? 1 : 0);
+        if (others == conf->upper_bound - (listener->listener_cnt? 1 : 0))
+            listener->mix_minus = PJ_TRUE;
+        else
+            ++conf->direct_cnt;
+    }
+}
+
+/*
+ * Ranking score of a source for the active speaker policy. The current
+ * speakers get a bonus so that the selection doesn't keep switching
+ * between sources of similar level.
+ */
+static inline unsigned speaker_score(const pjmedia_conf *conf,
+                                     const struct conf_port *cport)
+{
+    return cport->speaker_level +
+           (cport->speaking? conf->speaker_hysteresis : 0);
+}
+
+/*
+ * Active speaker policy: select the loudest sources to be mixed at this
+ * tick, ranked by their (smoothed) level at the previous tick.
+ */
+static void select_speakers(pjmedia_conf *conf)
+{
+    struct conf_port **ranking = conf->ranking;
+    pj_uint32_t i, k, cnt = 0;
+
+    for (i = 0; i < conf->upper_bound; ++i) {
+        struct conf_port *cport = conf->ports[conf->active_ports[i]];
+        unsigned score;
+
+        /* Instant attack, slow release. */
+        if (cport->rx_level >= cport->speaker_level) {
+            cport->speaker_level = cport->rx_level;
+        } else {
+            cport->speaker_level -= (cport->speaker_level -
+                                     cport->rx_level + 7) >> 3;
+        }
+
+        /* Only sources with some signal compete. */
+        if (cport->speaker_level == 0)
+            continue;
+
+        /* Insert to the ranking, loudest first. */
+        score = speaker_score(conf, cport);
+        if (cnt == conf->max_speakers) {
+            if (score <= speaker_score(conf, ranking[cnt-1]))
+                continue;
+            k = cnt - 1;
+        } else {
+            k = cnt++;
+        }
+        while (k > 0 && speaker_score(conf, ranking[k-1]) < score) {
+            ranking[k] = ranking[k-1];
+            --k;
+        }
+        ranking[k] = cport;
+    }
+
+    /* Replace the current speakers. Previous speakers are kept by slot
+     * since they may have been removed from the bridge.
+     */
+    for (k = 0; k < conf->speaker_cnt; ++k) {
+        struct conf_port *cport = conf->ports[conf->speakers[k]];
+        if (cport)
+            cport->speaking = PJ_FALSE;
+    }
+    for (k = 0; k < cnt; ++k)
+        ranking[k]->speaking = PJ_TRUE;
+    for (i = 0, k = 0; k < cnt && i < conf->upper_bound; ++i) {
+        if (conf->ports[conf->active_ports[i]]->speaking)
+            conf->speakers[k++] = conf->active_ports[i];
+    }
+    conf->speaker_cnt = cnt;
+}
+
+/*
+ * Complete the mix_buf of a mix-minus listener, which so far only contains
+ * the connection level corrections, by adding the sum of all sources minus
+ * the listener's own signal (unless it listens to itself).
+ */
+static void mix_minus_listener(pjmedia_conf *conf, struct conf_port *listener,
+                               const pj_timestamp *timestamp)
+{
+    const pj_int16_t *own = NULL;
+    pj_int32_t mix_buf_min = 0;
+    pj_int32_t mix_buf_max = 0;
+    unsigned src_cnt = conf->mix_sum_cnt;
+
+    if (listener->rx_timestamp.u64 == timestamp->u64 &&
+        !listener->self_listen)
+    {
+        own = listener->rx_frame_buf;
+        --src_cnt;
+    }
+
+    if (listener->last_timestamp.u64 != timestamp->u64) {
+        /* No source to hear, let write_port() send heart-beat */
+        if (src_cnt == 0)
+            return;
+
+        /* this is the first data for the listener */
+        listener->last_timestamp = *timestamp;
+        listener->mix_adj = NORMAL_LEVEL;
+        pj_bzero(listener->mix_buf,
+                 conf->samples_per_frame * sizeof(listener->mix_buf[0]));
+    }
+
+    conf->mk->accumulate32(listener->mix_buf, conf->mix_sum, own,
+                           conf->samples_per_frame,
+                           &mix_buf_min, &mix_buf_max);
+
+    /* Check if normalization adjustment needed. */
+    if (mix_buf_min < MIN_LEVEL || mix_buf_max > MAX_LEVEL) {
+        int tmp_adj;
+
+        if (-mix_buf_min > mix_buf_max)
+            mix_buf_max = -mix_buf_min;
+
+        /* NORMAL_LEVEL * MAX_LEVEL / mix_buf_max; */
+        tmp_adj = (MAX_LEVEL<<7) / mix_buf_max;
+        if (tmp_adj < listener->mix_adj)
+            listener->mix_adj = tmp_adj;
+    }
 }
 
 static void mix_and_transmit(pjmedia_conf *conf, struct conf_port *listener, 
@@ -3840,23 +4460,22 @@ static void mix_and_transmit(pjmedia_conf *conf, struct conf_port *listener,
     PJ_UNUSED_ARG(conf_port);
     PJ_UNUSED_ARG(listener_slot);
 
-    /* apply connection level, if not normal */
-    if (listener_adj_level != NORMAL_LEVEL) {
-        /* take the leveled frame */
-        p_in_conn_leveled = listener->adj_level_buf;
-        //loop vectorized
+    /* Mix-minus listener gets the source signal from the mix_sum at Step 3,
+     * here we only add the difference made by the connection level.
+     */
+    if (listener->mix_minus) {
+        pj_bool_t first = (listener->last_timestamp.u64 != timestamp->u64);
+
+        pj_assert(listener_adj_level != NORMAL_LEVEL);
+        if (first) {
+            listener->last_timestamp = *timestamp;
+            listener->mix_adj = NORMAL_LEVEL;
+        }
+
         for (k = 0; k < samples_per_frame; ++k) {
-            /* For the level adjustment, we need to store the sample to
-             * a temporary 32bit integer value to avoid overflowing the
-             * 16bit sample storage.
-             */
             pj_int32_t itemp;
 
             itemp = p_in[k];
-            /*itemp = itemp * adj / NORMAL_LEVEL;*/
-            /* bad code (signed/unsigned badness):
-             *  itemp = (itemp * conf_port->listsener_adj_level) >> 7;
-             */
             itemp *= listener_adj_level;
             itemp >>= 7;
 
@@ -3864,8 +4483,18 @@ static void mix_and_transmit(pjmedia_conf *conf, struct conf_port *listener,
             if (itemp > MAX_LEVEL) itemp = MAX_LEVEL;
             else if (itemp < MIN_LEVEL) itemp = MIN_LEVEL;
 
-            p_in_conn_leveled[k] = (pj_int16_t)itemp;
+            itemp -= p_in[k];
+            mix_buf[k] = first? itemp : mix_buf[k] + itemp;
         }
+        return;
+    }
+
+    /* apply connection level, if not normal */
+    if (listener_adj_level != NORMAL_LEVEL) {
+        /* take the leveled frame */
+        p_in_conn_leveled = listener->adj_level_buf;
+        conf->mk->apply_gain(p_in_conn_leveled, p_in, listener_adj_level,
+                             samples_per_frame);
 
     } else {
         /* take the frame as-is */
@@ -3882,14 +4511,9 @@ static void mix_and_transmit(pjmedia_conf *conf, struct conf_port *listener,
 
         if (listener->last_timestamp.u64 == timestamp->u64) {
             /* this frame is NOT from the first transmitter */
-            //loop vectorized
-            for (k = 0; k < samples_per_frame; ++k) {
-                mix_buf[k] += p_in_conn_leveled[k]; // not the first - sum
-                if (mix_buf[k] < mix_buf_min)
-                    mix_buf_min = mix_buf[k];
-                if (mix_buf[k] > mix_buf_max)
-                    mix_buf_max = mix_buf[k];
-            }
+            conf->mk->accumulate(mix_buf, p_in_conn_leveled,
+                                 samples_per_frame,
+                                 &mix_buf_min, &mix_buf_max);
             TRACE_EX((THIS_FILE, "%s: listener (%.*s, %d, transmitter_cnt=%d) get (sum) audio from the port (%.*s, %d, listener_cnt=%d)",
                 pj_thread_get_name(pj_thread_this()),
                 (int)listener->name.slen,
@@ -3907,14 +4531,13 @@ static void mix_and_transmit(pjmedia_conf *conf, struct conf_port *listener,
             listener->mix_adj = NORMAL_LEVEL;
 
 
-            /* We do not want to reset buffer, we just copy the first frame there. */
+            /* We do not want to reset buffer, we just copy the first frame
+             * there. A 16bit frame can't overflow, so no need to check
+             * the range.
+             */
             //loop vectorized
             for (k = 0; k < samples_per_frame; ++k) {
                 mix_buf[k] = p_in_conn_leveled[k]; // the first - copy
-                if (mix_buf[k] < mix_buf_min)
-                    mix_buf_min = mix_buf[k];
-                if (mix_buf[k] > mix_buf_max)
-                    mix_buf_max = mix_buf[k];
             }
             TRACE_EX((THIS_FILE, "%s: listener %p (%.*s, %d, transmitter_cnt=%d) get (copy) audio from the port %p (%.*s, %d, listener_cnt=%d)",
                 pj_thread_get_name(pj_thread_this()),
@@ -20,6 +20,7 @@
 #include <pjmedia/alaw_ulaw.h>
 #include <pjmedia/delaybuf.h>
 #include <pjmedia/errno.h>
+#include <pjmedia/mix_kernel.h>
 #include <pjmedia/port.h>
 #include <pjmedia/resample.h>
 #include <pjmedia/silencedet.h>
@@ -115,12 +116,19 @@ struct conf_port
     pjmedia_port        *port;          /**< get_frame() and put_frame()    */
     pjmedia_port_op      rx_setting;    /**< Can we receive from this port  */
     pjmedia_port_op      tx_setting;    /**< Can we transmit to this port   */
+
+    /* Connections of the port in the connection matrix version used by
+     * the clock, only updated by the clock (see conf_topo).
+     */
     unsigned             listener_cnt;  /**< Number of listeners.           */
     SLOT_TYPE           *listener_slots;/**< Array of listeners.            */
     unsigned            *listener_adj_level;
                                         /**< Array of listeners' level
                                              adjustment.                    */
     unsigned             transmitter_cnt;/**<Number of transmitters.        */
+    unsigned             adj_listener_cnt;/**< Number of listeners with
+                                             connection level adjustment.   */
+    pj_bool_t            self_listen;   /**< Port is its own listener.      */
 
     /* Shortcut for port info. */
     unsigned             clock_rate;    /**< Port's clock rate.             */
@@ -172,6 +180,45 @@ struct conf_port
     int                  last_mix_adj;  /**< Last adjustment level.         */
     pj_int32_t          *mix_buf;       /**< Total sum of signal.           */
 
+    /* In mix-minus mode (PJMEDIA_CONF_MIX_MINUS), the frame received from
+     * this port is kept in rx_frame_buf until the end of the clock tick, so
+     * that it can be subtracted from the bridge's mix_sum when producing
+     * the signal for this port. The mix_minus flag is evaluated on each
+     * tick and tells whether this port hears all other sources, in which
+     * case its mix_buf only gets the connection level correction terms
+     * while the sources are read.
+     */
+    pj_int16_t          *rx_frame_buf;  /**< Received frame of this tick.   */
+    pj_bool_t            rx_active;     /**< rx_frame_buf is in mix_sum.    */
+    pj_bool_t            mix_minus;     /**< Mixed as sum minus own signal. */
+
+    /* Active speaker policy: the port is only mixed while it is one of the
+     * loudest sources. The ranking uses speaker_level, the RX level with
+     * instant attack and slow release.
+     */
+    unsigned             speaker_level; /**< Smoothed RX level for ranking. */
+    pj_bool_t            speaking;      /**< Selected to be mixed.          */
+
+    /* Encoded port (G.711 format, e.g. a stream using passthrough codec).
+     * The bridge decodes the frames received from the port and encodes the
+     * frames transmitted to it, unless the port is the only listener of a
+     * source with the same format, in which case the encoded frame of the
+     * source is forwarded as is (passthrough). The passthrough of a
+     * listener is evaluated on each tick, it only applies when the ports
+     * have the bridge's ptime and no level adjustment is involved.
+     */
+    pj_uint32_t          fmt_id;        /**< Port's format id.              */
+    pj_bool_t            pt_capable;    /**< Encoded and bridge's ptime.    */
+    pj_bool_t            passthrough;   /**< Passthrough setting.           */
+    SLOT_TYPE            only_src;      /**< The only transmitter, if any.  */
+    unsigned             only_src_adj;  /**< Its connection level.          */
+    struct conf_port    *pt_src;        /**< Source forwarded on this tick. */
+    unsigned             pt_listener_cnt;/**<Listeners forwarded to.        */
+    pjmedia_frame_ext   *enc_rx;        /**< Frame received from the port.  */
+    pj_bool_t            enc_rx_ok;     /**< enc_rx has a frame this tick.  */
+    pjmedia_frame_ext   *enc_tx;        /**< Frame transmitted to the port. */
+    pj_uint8_t          *enc_buf;       /**< Encoding buffer.               */
+
     /* Tx buffer is a temporary buffer to be used when there's mismatch 
      * between port's clock rate or ptime with conference's sample rate
      * or ptime. This buffer is used as the source of the sampling rate
@@ -234,6 +281,52 @@ struct conf_port
 typedef struct op_entry op_entry;
 
 
+/*
+ * Connection matrix.
+ *
+ * The connections are kept in versioned snapshots which are never modified
+ * once published. Connect, disconnect and level adjustment build the next
+ * version under the conference mutex and publish it, and the clock picks
+ * up the latest version at the start of the next tick, so a burst of
+ * control operations never holds the clock. A new version shares the
+ * listener sets of the unchanged source ports with the previous one.
+ *
+ * The objects replaced by a new version are recycled once the clock has
+ * picked up a version that doesn't use them. As the clock only uses the
+ * last version it has picked up, only the objects of that version may be
+ * waiting to be recycled.
+ */
+
+/* Listener set of a source port. */
+typedef struct conf_listeners
+{
+    struct conf_listeners *next;        /**< Free or retired list.          */
+    pj_uint64_t          ver;           /**< Version that created it.       */
+    pj_uint64_t          retire_ver;    /**< Version that replaced it.      */
+    unsigned             cnt;           /**< Number of listeners.           */
+    unsigned             adj_cnt;       /**< Number of listeners with
+                                             connection level adjustment.   */
+    pj_bool_t            self_listen;   /**< Port is its own listener.      */
+    SLOT_TYPE           *slots;         /**< Array of listeners.            */
+    unsigned            *adj_level;     /**< Array of listeners' level
+                                             adjustment.                    */
+} conf_listeners;
+
+/* A version of the connection matrix. */
+typedef struct conf_topo
+{
+    struct conf_topo    *next;          /**< Free or retired list.          */
+    pj_uint64_t          ver;           /**< Version number.                */
+    pj_uint64_t          retire_ver;    /**< Version that replaced it.      */
+    unsigned             connect_cnt;   /**< Total number of connections.   */
+    unsigned             src_cnt;       /**< Number of ports with listener. */
+    conf_listeners     **listeners;     /**< Listener set of each slot.     */
+    unsigned            *transmitter_cnt;/**<Transmitters of each slot.     */
+    conf_listeners      *replaced;      /**< Listener sets replaced by this
+                                             version, while building it.    */
+} conf_topo;
+
+
 /*
  * Conference bridge.
  */
@@ -243,7 +336,6 @@ struct pjmedia_conf
     unsigned              options;      /**< Bitmask options.               */
     unsigned              max_ports;    /**< Maximum ports.                 */
     unsigned              port_cnt;     /**< Current number of ports.       */
-    unsigned              connect_cnt;  /**< Total number of connections    */
     pjmedia_snd_port     *snd_dev_port; /**< Sound device port.             */
     pjmedia_port         *master_port;  /**< Port zero's port.              */
     char                  master_name_buf[80]; /**< Port0 name buffer.      */
@@ -254,9 +346,40 @@ struct pjmedia_conf
     unsigned              samples_per_frame;    /**< Samples per frame.     */
     unsigned              bits_per_sample;      /**< Bits per sample.       */
 
+    pj_mutex_t           *sync_mutex;   /**< Protects the op queue and the
+                                             published topology, only held
+                                             for a few instructions.        */
     op_entry             *op_queue;     /**< Queue of operations.           */
     op_entry             *op_queue_free;/**< Queue of free entries.         */
     pjmedia_conf_op_cb    cb;           /**< OP callback.                   */
+
+    /* Connection matrix. */
+    conf_topo            *topo;         /**< Latest version.                */
+    conf_topo            *topo_used;    /**< Version used by the clock.     */
+    pj_uint64_t           topo_used_ver;/**< Its version number.            */
+    pj_bool_t             topo_stale;   /**< Ports activated, the version
+                                             must be applied again.         */
+    conf_listeners        no_listener;  /**< Empty listener set.            */
+    conf_topo            *topo_free;    /**< Recycled versions.             */
+    conf_topo            *topo_retired; /**< Replaced, maybe still used.    */
+    conf_listeners       *lset_free;    /**< Recycled listener sets.        */
+    conf_listeners       *lset_retired; /**< Replaced, maybe still used.    */
+
+    /* Mix-minus mode support. */
+    unsigned              src_cnt;      /**< Number of ports with listener. */
+    pj_int32_t           *mix_sum;      /**< Sum of all sources this tick.  */
+
+    const pjmedia_mix_kernel *mk;       /**< Mixing kernels.                */
+
+    /* Active speaker policy. */
+    unsigned              max_speakers; /**< Max sources to mix, 0=all.     */
+    unsigned              speaker_hysteresis; /**< Ranking hysteresis.      */
+    unsigned              speaker_cnt;  /**< Number of current speakers.    */
+    SLOT_TYPE            *speakers;     /**< Slots of current speakers.     */
+    struct conf_port    **ranking;      /**< Ranking buffer.                */
+
+    /* Encoded ports. */
+    unsigned              enc_port_cnt; /**< Number of encoded ports.       */
 };
 
 
@@ -274,10 +397,11 @@ static pj_status_t destroy_port_pasv(pjmedia_port *this_port);
 #endif
 
 
-/* As we don't hold mutex in the clock/get_frame(), some conference operations
- * that change conference states need to be synchronized with the clock.
- * So some steps of the operations needs to be executed within the clock tick
- * context, especially the steps related to changing ports connection.
+/* As we don't hold mutex in the clock/get_frame(), adding and removing
+ * ports need to be synchronized with the clock, so these steps are queued
+ * and executed within the clock tick context. Connection changes are
+ * published as a new version of the connection matrix instead, and are
+ * only queued to report them to the op callback from the clock.
  */
 
 /* Synchronized operation list entry. */
@@ -285,6 +409,7 @@ typedef struct op_entry {
     PJ_DECL_LIST_MEMBER(struct op_entry);
     pjmedia_conf_op_type          type;
     pjmedia_conf_op_param         param;
+    pj_status_t                   status;   /**< Result of connection op.  */
 } op_entry;
 
 /* Prototypes of synchronized operation */
@@ -294,12 +419,6 @@ static pj_status_t op_remove_port(pjmedia_conf *conf,
                                   const pjmedia_conf_op_param *prm);
 static void op_remove_port2(pjmedia_conf *conf,
                             const pjmedia_conf_op_param *prm);
-static pj_status_t op_connect_ports(pjmedia_conf *conf,
-                                    const pjmedia_conf_op_param *prm);
-static pj_status_t op_disconnect_ports(pjmedia_conf *conf,
-                                       const pjmedia_conf_op_param *prm);
-static pj_status_t op_adjust_conn_level(pjmedia_conf *conf,
-                                        const pjmedia_conf_op_param *prm);
 
 static void destroy_conf_port_resources(struct conf_port *conf_port);
 
@@ -317,6 +436,41 @@ static op_entry* get_free_op_entry(pjmedia_conf *conf)
     return ope;
 }
 
+/* Queue an operation, the caller must hold the conference mutex. */
+static pj_status_t queue_op(pjmedia_conf *conf,
+                            pjmedia_conf_op_type type,
+                            const pjmedia_conf_op_param *prm,
+                            pj_status_t status)
+{
+    op_entry *ope;
+
+    pj_mutex_lock(conf->sync_mutex);
+    ope = get_free_op_entry(conf);
+    if (ope) {
+        ope->type = type;
+        ope->param = *prm;
+        ope->status = status;
+        pj_list_push_back(conf->op_queue, ope);
+    }
+    pj_mutex_unlock(conf->sync_mutex);
+
+    return ope? PJ_SUCCESS : PJ_ENOMEM;
+}
+
+/* Report the result of a connection change to the op callback. The
+ * change itself has already been published.
+ */
+static pj_status_t report_conn_op(pjmedia_conf *conf,
+                                  pjmedia_conf_op_type type,
+                                  const pjmedia_conf_op_param *prm,
+                                  pj_status_t status)
+{
+    if (!conf->cb)
+        return PJ_SUCCESS;
+
+    return queue_op(conf, type, prm, status);
+}
+
 static void handle_op_queue(pjmedia_conf *conf)
 {
     /* The queue may grow while mutex is released, better put a limit? */
@@ -329,11 +483,11 @@ static void handle_op_queue(pjmedia_conf *conf)
         pjmedia_conf_op_param param;
         pj_status_t status;
 
-        pj_mutex_lock(conf->mutex);
+        pj_mutex_lock(conf->sync_mutex);
 
         /* Stop when queue empty */
         if (pj_list_empty(conf->op_queue)) {
-            pj_mutex_unlock(conf->mutex);
+            pj_mutex_unlock(conf->sync_mutex);
             break;
         }
 
@@ -341,13 +495,14 @@ static void handle_op_queue(pjmedia_conf *conf)
         op = conf->op_queue->next;
         type = op->type;
         param = op->param;
+        status = op->status;
 
         /* Free op */
         pj_list_erase(op);
         op->type = PJMEDIA_CONF_OP_UNKNOWN;
         pj_list_push_back(conf->op_queue_free, op);
 
-        pj_mutex_unlock(conf->mutex);
+        pj_mutex_unlock(conf->sync_mutex);
 
         /* Process op */
         switch(type) {
@@ -358,13 +513,9 @@ static void handle_op_queue(pjmedia_conf *conf)
                 status = op_remove_port(conf, &param);
                 break;
             case PJMEDIA_CONF_OP_CONNECT_PORTS:
-                status = op_connect_ports(conf, &param);
-                break;
             case PJMEDIA_CONF_OP_DISCONNECT_PORTS:
-                status = op_disconnect_ports(conf, &param);
-                break;
             case PJMEDIA_CONF_OP_ADJUST_CONN_LEVEL:
-                status = op_adjust_conn_level(conf, &param);
+                /* Already applied, just report the result */
                 break;
             default:
                 status = PJ_EINVALIDOP;
@@ -391,6 +542,448 @@ static void handle_op_queue(pjmedia_conf *conf)
 }
 
 
+/* Allocate a listener set, or reuse a recycled one. */
+static conf_listeners *lset_alloc(pjmedia_conf *conf)
+{
+    conf_listeners *ls = conf->lset_free;
+
+    if (ls) {
+        conf->lset_free = ls->next;
+        return ls;
+    }
+
+    ls = PJ_POOL_ZALLOC_T(conf->pool, conf_listeners);
+    ls->slots = (SLOT_TYPE*) pj_pool_calloc(conf->pool, conf->max_ports,
+                                            sizeof(SLOT_TYPE));
+    ls->adj_level = (unsigned*) pj_pool_calloc(conf->pool, conf->max_ports,
+                                               sizeof(unsigned));
+    return ls;
+}
+
+/* Allocate a version of the connection matrix, or reuse a recycled one. */
+static conf_topo *topo_alloc(pjmedia_conf *conf)
+{
+    conf_topo *topo = conf->topo_free;
+
+    if (topo) {
+        conf->topo_free = topo->next;
+        return topo;
+    }
+
+    topo = PJ_POOL_ZALLOC_T(conf->pool, conf_topo);
+    topo->listeners = (conf_listeners**)
+                      pj_pool_calloc(conf->pool, conf->max_ports,
+                                     sizeof(conf_listeners*));
+    topo->transmitter_cnt = (unsigned*)
+                            pj_pool_calloc(conf->pool, conf->max_ports,
+                                           sizeof(unsigned));
+    return topo;
+}
+
+/* Create the first version of the connection matrix, without connection. */
+static void topo_init(pjmedia_conf *conf)
+{
+    conf_topo *topo = topo_alloc(conf);
+    unsigned i;
+
+    /* The empty set is shared by all versions, and never replaced. */
+    conf->no_listener.slots = (SLOT_TYPE*)
+                              pj_pool_calloc(conf->pool, 1, sizeof(SLOT_TYPE));
+    conf->no_listener.adj_level = (unsigned*)
+                              pj_pool_calloc(conf->pool, 1, sizeof(unsigned));
+
+    topo->ver = 1;
+    for (i=0; i<conf->max_ports; ++i)
+        topo->listeners[i] = &conf->no_listener;
+
+    conf->topo = topo;
+}
+
+/* Get the latest connections: the version being built, if any. */
+PJ_INLINE(conf_topo*) topo_latest(pjmedia_conf *conf, conf_topo *next)
+{
+    return next? next : conf->topo;
+}
+
+/* Start building the next version of the connection matrix from the
+ * latest one, if not started yet. The caller must hold the conference
+ * mutex.
+ */
+static conf_topo *topo_begin(pjmedia_conf *conf, conf_topo **p_next)
+{
+    conf_topo *cur = conf->topo, *next;
+
+    if (*p_next)
+        return *p_next;
+
+    next = topo_alloc(conf);
+    next->ver = cur->ver + 1;
+    next->connect_cnt = cur->connect_cnt;
+    next->src_cnt = cur->src_cnt;
+    next->replaced = NULL;
+    pj_memcpy(next->listeners, cur->listeners,
+              conf->max_ports * sizeof(next->listeners[0]));
+    pj_memcpy(next->transmitter_cnt, cur->transmitter_cnt,
+              conf->max_ports * sizeof(next->transmitter_cnt[0]));
+
+    *p_next = next;
+    return next;
+}
+
+/* Get the listener set of a source in the version being built, to modify
+ * it. The set is copied unless it has been created by this version.
+ */
+static conf_listeners *topo_edit(pjmedia_conf *conf, conf_topo *next,
+                                 unsigned src_slot)
+{
+    conf_listeners *ls = next->listeners[src_slot], *copy;
+
+    if (ls->ver == next->ver)
+        return ls;
+
+    copy = lset_alloc(conf);
+    copy->ver = next->ver;
+    copy->cnt = ls->cnt;
+    copy->adj_cnt = ls->adj_cnt;
+    copy->self_listen = ls->self_listen;
+    pj_memcpy(copy->slots, ls->slots, ls->cnt * sizeof(ls->slots[0]));
+    pj_memcpy(copy->adj_level, ls->adj_level,
+              ls->cnt * sizeof(ls->adj_level[0]));
+
+    if (ls != &conf->no_listener) {
+        ls->next = next->replaced;
+        next->replaced = ls;
+    }
+    next->listeners[src_slot] = copy;
+
+    return copy;
+}
+
+/* Recycle the replaced objects that the clock doesn't use anymore. */
+static void topo_reclaim(pjmedia_conf *conf, pj_uint64_t used_ver)
+{
+    conf_topo **pt = &conf->topo_retired;
+    conf_listeners **pl = &conf->lset_retired;
+
+    while (*pt) {
+        conf_topo *topo = *pt;
+        if (topo->retire_ver <= used_ver) {
+            *pt = topo->next;
+            topo->next = conf->topo_free;
+            conf->topo_free = topo;
+        } else {
+            pt = &topo->next;
+        }
+    }
+
+    while (*pl) {
+        conf_listeners *ls = *pl;
+        if (ls->retire_ver <= used_ver) {
+            *pl = ls->next;
+            ls->next = conf->lset_free;
+            conf->lset_free = ls;
+        } else {
+            pl = &ls->next;
+        }
+    }
+}
+
+/* Publish the version being built, the clock will use it on its next
+ * tick. The caller must hold the conference mutex.
+ */
+static void topo_commit(pjmedia_conf *conf, conf_topo *next)
+{
+    conf_topo *prev = conf->topo;
+    conf_listeners *ls;
+    pj_uint64_t used_ver;
+
+    pj_mutex_lock(conf->sync_mutex);
+    conf->topo = next;
+    used_ver = conf->topo_used_ver;
+    pj_mutex_unlock(conf->sync_mutex);
+
+    topo_reclaim(conf, used_ver);
+
+    /* An object created after the version used by the clock has never
+     * been seen by the clock and can be recycled right away, since the
+     * clock can only pick up the version just published from now on.
+     */
+    prev->retire_ver = next->ver;
+    if (prev->ver > used_ver) {
+        prev->next = conf->topo_free;
+        conf->topo_free = prev;
+    } else {
+        prev->next = conf->topo_retired;
+        conf->topo_retired = prev;
+    }
+
+    while ((ls = next->replaced) != NULL) {
+        next->replaced = ls->next;
+        ls->retire_ver = next->ver;
+        if (ls->ver > used_ver) {
+            ls->next = conf->lset_free;
+            conf->lset_free = ls;
+        } else {
+            ls->next = conf->lset_retired;
+            conf->lset_retired = ls;
+        }
+    }
+}
+
+/* Pick up the latest version of the connection matrix and apply it to the
+ * ports, this is called by the clock.
+ */
+static void topo_update(pjmedia_conf *conf)
+{
+    conf_topo *topo;
+    unsigned i;
+
+    pj_mutex_lock(conf->sync_mutex);
+    topo = conf->topo;
+    if (topo->ver == conf->topo_used_ver && !conf->topo_stale) {
+        pj_mutex_unlock(conf->sync_mutex);
+        return;
+    }
+    conf->topo_used = topo;
+    conf->topo_used_ver = topo->ver;
+    pj_mutex_unlock(conf->sync_mutex);
+
+    /* New ports are applied once they are activated. */
+    for (i=0; i<conf->max_ports; ++i) {
+        struct conf_port *cport = conf->ports[i];
+        const conf_listeners *ls = topo->listeners[i];
+
+        if (!cport || cport->is_new)
+            continue;
+
+        /* If source port is passive port and has no listener,
+         * reset delaybuf.
+         */
+        if (cport->delay_buf && cport->listener_cnt && ls->cnt == 0)
+            pjmedia_delay_buf_reset(cport->delay_buf);
+
+        cport->listener_cnt = ls->cnt;
+        cport->listener_slots = ls->slots;
+        cport->listener_adj_level = ls->adj_level;
+        cport->adj_listener_cnt = ls->adj_cnt;
+        cport->self_listen = ls->self_listen;
+        cport->transmitter_cnt = topo->transmitter_cnt[i];
+        cport->only_src = INVALID_SLOT;
+    }
+
+    /* Find the only transmitter of the ports, for passthrough. */
+    if (conf->enc_port_cnt) {
+        for (i=0; i<conf->max_ports; ++i) {
+            const conf_listeners *ls = topo->listeners[i];
+            unsigned j;
+
+            if (!conf->ports[i] || conf->ports[i]->is_new)
+                continue;
+
+            for (j=0; j<ls->cnt; ++j) {
+                struct conf_port *sink = conf->ports[ls->slots[j]];
+
+                if (sink && topo->transmitter_cnt[ls->slots[j]] == 1) {
+                    sink->only_src = i;
+                    sink->only_src_adj = ls->adj_level[j];
+                }
+            }
+        }
+    }
+    conf->src_cnt = topo->src_cnt;
+    conf->topo_stale = PJ_FALSE;
+}
+
+/* Connect ports in the version being built. */
+static pj_status_t topo_connect(pjmedia_conf *conf, conf_topo **p_next,
+                                unsigned src_slot, unsigned sink_slot,
+                                int adj_level)
+{
+    const conf_listeners *cur;
+    conf_listeners *ls;
+    conf_topo *next;
+    unsigned i;
+
+    /* Check if connection has been made */
+    cur = topo_latest(conf, *p_next)->listeners[src_slot];
+    for (i=0; i<cur->cnt; ++i) {
+        if (cur->slots[i] == sink_slot) {
+            PJ_LOG(3,(THIS_FILE, "Ports connection %d->%d already exists",
+                      src_slot, sink_slot));
+            return PJ_EEXISTS;
+        }
+    }
+
+    next = topo_begin(conf, p_next);
+    ls = topo_edit(conf, next, src_slot);
+
+    ls->slots[ls->cnt] = sink_slot;
+
+    /* Set normalized adjustment level. */
+    ls->adj_level[ls->cnt] = adj_level + NORMAL_LEVEL;
+
+    /* Update the counters used by mix-minus mode. */
+    if (ls->cnt == 0)
+        ++next->src_cnt;
+    if (adj_level != 0)
+        ++ls->adj_cnt;
+    if (src_slot == sink_slot)
+        ls->self_listen = PJ_TRUE;
+
+    ++next->connect_cnt;
+    ++ls->cnt;
+    ++next->transmitter_cnt[sink_slot];
+
+    PJ_LOG(4,(THIS_FILE,"Port %d (%.*s) transmitting to port %d (%.*s)",
+              src_slot,
+              (int)conf->ports[src_slot]->name.slen,
+              conf->ports[src_slot]->name.ptr,
+              sink_slot,
+              (int)conf->ports[sink_slot]->name.slen,
+              conf->ports[sink_slot]->name.ptr));
+
+    return PJ_SUCCESS;
+}
+
+/* Disconnect ports in the version being built. */
+static pj_status_t topo_disconnect(pjmedia_conf *conf, conf_topo **p_next,
+                                   unsigned src_slot, unsigned sink_slot)
+{
+    const conf_listeners *cur;
+    conf_listeners *ls;
+    conf_topo *next;
+    unsigned i;
+
+    /* Check if connection has been made */
+    cur = topo_latest(conf, *p_next)->listeners[src_slot];
+    for (i=0; i<cur->cnt; ++i) {
+        if (cur->slots[i] == sink_slot)
+            break;
+    }
+    if (i == cur->cnt) {
+        PJ_LOG(3,(THIS_FILE, "Ports connection %d->%d does not exist",
+                  src_slot, sink_slot));
+        return PJ_EINVAL;
+    }
+
+    next = topo_begin(conf, p_next);
+    ls = topo_edit(conf, next, src_slot);
+
+    /* Sanity checks */
+    pj_assert(ls->cnt > 0 && ls->cnt <= conf->max_ports);
+    pj_assert(next->transmitter_cnt[sink_slot] > 0 &&
+              next->transmitter_cnt[sink_slot] <= conf->max_ports);
+
+    /* Update the counters used by mix-minus mode. */
+    if (ls->adj_level[i] != NORMAL_LEVEL)
+        --ls->adj_cnt;
+    if (src_slot == sink_slot)
+        ls->self_listen = PJ_FALSE;
+    if (ls->cnt == 1)
+        --next->src_cnt;
+
+    pj_array_erase(ls->slots, sizeof(SLOT_TYPE), ls->cnt, i);
+    pj_array_erase(ls->adj_level, sizeof(unsigned), ls->cnt, i);
+    --next->connect_cnt;
+    --ls->cnt;
+    --next->transmitter_cnt[sink_slot];
+
+    /* The set has been created by this version, so it can be recycled
+     * right away when it becomes empty.
+     */
+    if (ls->cnt == 0) {
+        next->listeners[src_slot] = &conf->no_listener;
+        ls->next = conf->lset_free;
+        conf->lset_free = ls;
+    }
+
+    PJ_LOG(4,(THIS_FILE,
+              "Port %d (%.*s) stop transmitting to port %d (%.*s)",
+              src_slot,
+              (int)conf->ports[src_slot]->name.slen,
+              conf->ports[src_slot]->name.ptr,
+              sink_slot,
+              (int)conf->ports[sink_slot]->name.slen,
+              conf->ports[sink_slot]->name.ptr));
+
+    return PJ_SUCCESS;
+}
+
+/* Adjust the level of a connection in the version being built. */
+static pj_status_t topo_adjust_level(pjmedia_conf *conf, conf_topo **p_next,
+                                     unsigned src_slot, unsigned sink_slot,
+                                     int adj_level)
+{
+    const conf_listeners *cur;
+    conf_listeners *ls;
+    unsigned i;
+
+    /* Find the connection */
+    cur = topo_latest(conf, *p_next)->listeners[src_slot];
+    for (i=0; i<cur->cnt; ++i) {
+        if (cur->slots[i] == sink_slot)
+            break;
+    }
+
+    if (i == cur->cnt) {
+        PJ_LOG(3,(THIS_FILE,
+                  "Adjust conn level: connection %d->%d does not exist",
+                  src_slot, sink_slot));
+        return PJ_EINVAL;
+    }
+
+    ls = topo_edit(conf, topo_begin(conf, p_next), src_slot);
+
+    /* Update the counter used by mix-minus mode. */
+    if (ls->adj_level[i] != NORMAL_LEVEL)
+        --ls->adj_cnt;
+    if (adj_level != 0)
+        ++ls->adj_cnt;
+
+    /* Set normalized adjustment level. */
+    ls->adj_level[i] = adj_level + NORMAL_LEVEL;
+
+    PJ_LOG(5,(THIS_FILE, "Adjusted conn level %d->%d to %d",
+              src_slot, sink_slot, adj_level));
+
+    return PJ_SUCCESS;
+}
+
+/* Disconnect a port from all its sources and/or sinks in the version
+ * being built.
+ */
+static void topo_disconnect_all(pjmedia_conf *conf, conf_topo **p_next,
+                                unsigned slot, pj_bool_t from_sources,
+                                pj_bool_t from_sinks)
+{
+    unsigned i;
+
+    if (from_sources) {
+        for (i=0; i<conf->max_ports; ++i) {
+            const conf_listeners *ls;
+            unsigned j;
+
+            ls = topo_latest(conf, *p_next)->listeners[i];
+            for (j=0; j<ls->cnt; ++j) {
+                if (ls->slots[j] == slot) {
+                    topo_disconnect(conf, p_next, i, slot);
+                    break;
+                }
+            }
+        }
+    }
+
+    if (from_sinks) {
+        const conf_listeners *ls;
+
+        /* The last listener is removed until there's none left */
+        while ((ls = topo_latest(conf, *p_next)->listeners[slot])->cnt) {
+            topo_disconnect(conf, p_next, slot, ls->slots[ls->cnt-1]);
+        }
+    }
+}
+
+
 /* Group lock handler */
 static void conf_port_on_destroy(void *arg)
 {
@@ -457,17 +1050,11 @@ static pj_status_t create_conf_port( pj_pool_t *parent_pool,
     conf_port->tx_adj_level = NORMAL_LEVEL;
     conf_port->rx_adj_level = NORMAL_LEVEL;
 
-    /* Create transmit flag array */
-    conf_port->listener_slots = (SLOT_TYPE*) pj_pool_zalloc(pool, 
-                                          conf->max_ports * sizeof(SLOT_TYPE));
-    PJ_ASSERT_ON_FAIL(conf_port->listener_slots,
-                      {status = PJ_ENOMEM; goto on_return;});
-
-    /* Create adjustment level array */
-    conf_port->listener_adj_level = (unsigned *) pj_pool_zalloc(pool, 
-                                       conf->max_ports * sizeof(unsigned));
-    PJ_ASSERT_ON_FAIL(conf_port->listener_adj_level,
-                      {status = PJ_ENOMEM; goto on_return;});
+    /* No connection yet, the clock applies the listeners from the
+     * connection matrix.
+     */
+    conf_port->listener_slots = conf->no_listener.slots;
+    conf_port->listener_adj_level = conf->no_listener.adj_level;
 
     /* Save some port's infos, for convenience. */
     if (port) {
@@ -484,6 +1071,41 @@ static pj_status_t create_conf_port( pj_pool_t *parent_pool,
         conf_port->samples_per_frame = conf->samples_per_frame;
         conf_port->channel_count = conf->channel_count;
     }
+    conf_port->only_src = INVALID_SLOT;
+
+    /* Encoded port, the bridge can only transcode G.711. */
+    conf_port->fmt_id = port? port->info.fmt.id : PJMEDIA_FORMAT_L16;
+    if (conf_port->fmt_id != PJMEDIA_FORMAT_L16) {
+        unsigned enc_size;
+
+        if (conf_port->fmt_id != PJMEDIA_FORMAT_PCMU &&
+            conf_port->fmt_id != PJMEDIA_FORMAT_PCMA)
+        {
+            PJ_LOG(3,(THIS_FILE, "Cannot create conf port: unsupported "
+                      "format of encoded port"));
+            status = PJMEDIA_EBADFMT;
+            goto on_return;
+        }
+
+        conf_port->passthrough = PJ_TRUE;
+        conf_port->pt_capable = (conf_port->samples_per_frame /
+                                 conf_port->channel_count * conf->clock_rate ==
+                                 conf->samples_per_frame /
+                                 conf->channel_count * conf_port->clock_rate);
+
+        /* One byte per sample, with room for the subframe headers. */
+        enc_size = sizeof(pjmedia_frame_ext) +
+                   conf_port->samples_per_frame * 2;
+        conf_port->enc_rx = (pjmedia_frame_ext*)
+                            pj_pool_zalloc(pool, enc_size);
+        conf_port->enc_tx = (pjmedia_frame_ext*)
+                            pj_pool_zalloc(pool, enc_size);
+        conf_port->enc_buf = (pj_uint8_t*)
+                             pj_pool_alloc(pool, conf_port->samples_per_frame);
+        PJ_ASSERT_ON_FAIL(conf_port->enc_rx && conf_port->enc_tx &&
+                          conf_port->enc_buf,
+                          {status = PJ_ENOMEM; goto on_return;});
+    }
 
     /* Create adjustment level buffer. */
     conf_port->adj_level_buf = (pj_int16_t*) pj_pool_zalloc(pool, 
@@ -616,6 +1238,15 @@ static pj_status_t create_conf_port( pj_pool_t *parent_pool,
                       {status = PJ_ENOMEM; goto on_return;});
     conf_port->last_mix_adj = NORMAL_LEVEL;
 
+    /* Create buffer to keep the received frame for mix-minus mode. */
+    if (conf->options & PJMEDIA_CONF_MIX_MINUS) {
+        conf_port->rx_frame_buf = (pj_int16_t*)
+                                  pj_pool_zalloc(pool, conf->samples_per_frame *
+                                                sizeof(pj_int16_t));
+        PJ_ASSERT_ON_FAIL(conf_port->rx_frame_buf,
+                          {status = PJ_ENOMEM; goto on_return;});
+    }
+
 
     /* Done */
     *p_conf_port = conf_port;
@@ -751,21 +1382,7 @@ static pj_status_t create_sound_port( pj_pool_t *pool,
     return PJ_SUCCESS;
 }
 
-PJ_DEF(pj_status_t) pjmedia_conf_create2(pj_pool_t *pool,
-                                         const pjmedia_conf_param *param,
-                                         pjmedia_conf **p_conf)
-{
-    PJ_ASSERT_RETURN(param, PJ_EINVAL);
-    return pjmedia_conf_create(pool, 
-                               param->max_slots, param->sampling_rate, 
-                               param->channel_count, param->samples_per_frame, 
-                               param->bits_per_sample, param->options, p_conf);
-}
-
-/*
- * Create conference bridge.
- */
-PJ_DEF(pj_status_t) pjmedia_conf_create( pj_pool_t *pool_,
+PJ_DEF(pj_status_t) pjmedia_conf_create( pj_pool_t *pool,
                                          unsigned max_ports,
                                          unsigned clock_rate,
                                          unsigned channel_count,
@@ -773,12 +1390,44 @@ PJ_DEF(pj_status_t) pjmedia_conf_create( pj_pool_t *pool_,
                                          unsigned bits_per_sample,
                                          unsigned options,
                                          pjmedia_conf **p_conf )
+{
+    pjmedia_conf_param param;
+
+    pjmedia_conf_param_default(&param);
+
+    param.max_slots = max_ports;
+    param.sampling_rate = clock_rate;
+    param.channel_count = channel_count;
+    param.samples_per_frame = samples_per_frame;
+    param.bits_per_sample = bits_per_sample;
+    param.options = options;
+
+    return pjmedia_conf_create2(pool, &param, p_conf);
+}
+
+/*
+ * Create conference bridge.
+ */
+PJ_DEF(pj_status_t) pjmedia_conf_create2(pj_pool_t *pool_,
+                                         const pjmedia_conf_param *param,
+                                         pjmedia_conf **p_conf)
 {
     pj_pool_t *pool;
     pjmedia_conf *conf;
     const pj_str_t name = { "Conf", 4 };
+    unsigned max_ports, clock_rate, channel_count;
+    unsigned samples_per_frame, bits_per_sample, options;
     pj_status_t status;
 
+    PJ_ASSERT_RETURN(param && p_conf, PJ_EINVAL);
+
+    max_ports = param->max_slots;
+    clock_rate = param->sampling_rate;
+    channel_count = param->channel_count;
+    samples_per_frame = param->samples_per_frame;
+    bits_per_sample = param->bits_per_sample;
+    options = param->options;
+
     PJ_ASSERT_RETURN(samples_per_frame > 0, PJ_EINVAL);
     /* Can only accept 16bits per sample, for now.. */
     PJ_ASSERT_RETURN(bits_per_sample == 16, PJ_EINVAL);
@@ -808,7 +1457,26 @@ PJ_DEF(pj_status_t) pjmedia_conf_create( pj_pool_t *pool_,
     conf->channel_count = channel_count;
     conf->samples_per_frame = samples_per_frame;
     conf->bits_per_sample = bits_per_sample;
+    conf->mk = pjmedia_mix_kernel_get(PJMEDIA_MIX_KERNEL_AUTO);
+
+    if (options & PJMEDIA_CONF_MIX_MINUS) {
+        conf->mix_sum = (pj_int32_t*)
+                        pj_pool_zalloc(pool, samples_per_frame *
+                                             sizeof(conf->mix_sum[0]));
+        PJ_ASSERT_RETURN(conf->mix_sum, PJ_ENOMEM);
+    }
 
+    if (param->max_speakers) {
+        conf->max_speakers = param->max_speakers;
+        conf->speaker_hysteresis = param->speaker_hysteresis;
+        conf->speakers = (SLOT_TYPE*)
+                         pj_pool_calloc(pool, param->max_speakers,
+                                        sizeof(conf->speakers[0]));
+        conf->ranking = (struct conf_port**)
+                        pj_pool_calloc(pool, param->max_speakers,
+                                       sizeof(conf->ranking[0]));
+        PJ_ASSERT_RETURN(conf->speakers && conf->ranking, PJ_ENOMEM);
+    }
     
     /* Create and initialize the master port interface. */
     conf->master_port = PJ_POOL_ZALLOC_T(pool, pjmedia_port);
@@ -826,6 +1494,9 @@ PJ_DEF(pj_status_t) pjmedia_conf_create( pj_pool_t *pool_,
     conf->master_port->on_destroy = &destroy_port;
 
 
+    /* Create the connection matrix. */
+    topo_init(conf);
+
     /* Create port zero for sound device. */
     status = create_sound_port(pool, conf);
     if (status != PJ_SUCCESS) {
@@ -839,6 +1510,11 @@ PJ_DEF(pj_status_t) pjmedia_conf_create( pj_pool_t *pool_,
         pjmedia_conf_destroy(conf);
         return status;
     }
+    status = pj_mutex_create_simple(pool, "confsync", &conf->sync_mutex);
+    if (status != PJ_SUCCESS) {
+        pjmedia_conf_destroy(conf);
+        return status;
+    }
 
     /* If sound device was created, connect sound device to the
      * master port.
@@ -913,7 +1589,8 @@ PJ_DEF(pj_status_t) pjmedia_conf_destroy( pjmedia_conf *conf )
     }
 
     /* Flush any pending operation (connect, disconnect, etc) */
-    handle_op_queue(conf);
+    if (conf->op_queue)
+        handle_op_queue(conf);
 
     /* Remove all ports (may destroy them too). */
     for (i=0; i<conf->max_ports; ++i) {
@@ -944,6 +1621,8 @@ PJ_DEF(pj_status_t) pjmedia_conf_destroy( pjmedia_conf *conf )
     }
 
     /* Destroy mutex */
+    if (conf->sync_mutex)
+        pj_mutex_destroy(conf->sync_mutex);
     if (conf->mutex)
         pj_mutex_destroy(conf->mutex);
 
@@ -1047,7 +1726,7 @@ PJ_DEF(pj_status_t) pjmedia_conf_add_port( pjmedia_conf *conf,
 {
     struct conf_port *conf_port;
     unsigned index;
-    op_entry *ope;
+    pjmedia_conf_op_param prm;
     pj_status_t status = PJ_SUCCESS;
 
     PJ_ASSERT_RETURN(conf && pool && strm_port, PJ_EINVAL);
@@ -1101,11 +1780,9 @@ PJ_DEF(pj_status_t) pjmedia_conf_add_port( pjmedia_conf *conf,
     //conf->port_cnt++;
 
     /* Queue the operation */
-    ope = get_free_op_entry(conf);
-    if (ope) {
-        ope->type = PJMEDIA_CONF_OP_ADD_PORT;
-        ope->param.add_port.port = index;
-        pj_list_push_back(conf->op_queue, ope);
+    prm.add_port.port = index;
+    status = queue_op(conf, PJMEDIA_CONF_OP_ADD_PORT, &prm, PJ_SUCCESS);
+    if (status == PJ_SUCCESS) {
         PJ_LOG(4,(THIS_FILE, "Add port %d (%.*s) queued",
                              index, (int)port_name->slen, port_name->ptr));
     } else {
@@ -1141,9 +1818,14 @@ static pj_status_t op_add_port(pjmedia_conf *conf,
     if (!cport || !cport->is_new)
         return PJ_EINVAL;
 
-    /* Activate newly added port */
+    /* Activate newly added port, its connections are applied on
+     * the next update of the connection matrix.
+     */
     cport->is_new = PJ_FALSE;
     ++conf->port_cnt;
+    if (cport->enc_rx)
+        ++conf->enc_port_cnt;
+    conf->topo_stale = PJ_TRUE;
 
     PJ_LOG(4,(THIS_FILE, "Added port %d (%.*s), port count=%d",
               port, (int)cport->name.slen, cport->name.ptr, conf->port_cnt));
@@ -1293,17 +1975,53 @@ PJ_DEF(pj_status_t) pjmedia_conf_configure_port( pjmedia_conf *conf,
 
 
 /*
- * Connect port.
+ * Enable or disable passthrough of encoded frames to the port.
  */
-PJ_DEF(pj_status_t) pjmedia_conf_connect_port( pjmedia_conf *conf,
-                                               unsigned src_slot,
-                                               unsigned sink_slot,
-                                               int adj_level )
+PJ_DEF(pj_status_t) pjmedia_conf_set_port_passthrough(pjmedia_conf *conf,
+                                                      unsigned slot,
+                                                      pj_bool_t enabled)
+{
+    struct conf_port *conf_port;
+
+    /* Check arguments */
+    PJ_ASSERT_RETURN(conf && slot<conf->max_ports, PJ_EINVAL);
+
+    pj_mutex_lock(conf->mutex);
+
+    /* Port must be valid and not being removed. */
+    conf_port = conf->ports[slot];
+    if (conf_port == NULL || conf_port->removing) {
+        pj_mutex_unlock(conf->mutex);
+        return PJ_EINVAL;
+    }
+
+    /* Only applicable to encoded port. */
+    if (!conf_port->enc_rx) {
+        pj_mutex_unlock(conf->mutex);
+        return PJ_EINVALIDOP;
+    }
+
+    conf_port->passthrough = enabled;
+
+    pj_mutex_unlock(conf->mutex);
+
+    return PJ_SUCCESS;
+}
+
+
+/*
+ * Connect port.
+ */
+PJ_DEF(pj_status_t) pjmedia_conf_connect_port( pjmedia_conf *conf,
+                                               unsigned src_slot,
+                                               unsigned sink_slot,
+                                               int adj_level )
 {
     struct conf_port *src_port, *dst_port;
     pj_bool_t start_sound = PJ_FALSE;
-    op_entry *ope;
-    pj_status_t status = PJ_SUCCESS;
+    conf_topo *next = NULL;
+    pjmedia_conf_op_param prm;
+    pj_status_t op_status, status = PJ_SUCCESS;
 
     /* Check arguments */
     PJ_ASSERT_RETURN(conf && src_slot<conf->max_ports &&
@@ -1330,26 +2048,24 @@ PJ_DEF(pj_status_t) pjmedia_conf_connect_port( pjmedia_conf *conf,
         goto on_return;
     }
 
-    /* Queue the operation */
-    ope = get_free_op_entry(conf);
-    if (ope) {
-        ope->type = PJMEDIA_CONF_OP_CONNECT_PORTS;
-        ope->param.connect_ports.src = src_slot;
-        ope->param.connect_ports.sink = sink_slot;
-        ope->param.connect_ports.adj_level = adj_level;
-        pj_list_push_back(conf->op_queue, ope);
-
-        PJ_LOG(4,(THIS_FILE, "Connect ports %d->%d queued",
-                             src_slot, sink_slot));
-    } else {
-        status = PJ_ENOMEM;
-        goto on_return;
-    }
-
     /* This is first connection, start clock */
-    if (conf->connect_cnt == 0)
+    if (conf->topo->connect_cnt == 0)
         start_sound = 1;
 
+    /* Publish the new connection. As when the connection was made by
+     * the clock, an existing connection is only reported to the op
+     * callback.
+     */
+    prm.connect_ports.src = src_slot;
+    prm.connect_ports.sink = sink_slot;
+    prm.connect_ports.adj_level = adj_level;
+    op_status = topo_connect(conf, &next, src_slot, sink_slot, adj_level);
+    if (next)
+        topo_commit(conf, next);
+
+    status = report_conn_op(conf, PJMEDIA_CONF_OP_CONNECT_PORTS, &prm,
+                            op_status);
+
 on_return:
     pj_mutex_unlock(conf->mutex);
 
@@ -1369,54 +2085,58 @@ on_return:
     return status;
 }
 
-static pj_status_t op_connect_ports(pjmedia_conf *conf, 
-                                    const pjmedia_conf_op_param *prm)
+/*
+ * Disconnect ports in the connection matrix and report it to the op
+ * callback. Either slot may be INVALID_SLOT to disconnect the other port
+ * from all its sinks or sources. The caller must hold the conference mutex.
+ */
+static pj_status_t disconnect_ports(pjmedia_conf *conf,
+                                    unsigned src_slot,
+                                    unsigned sink_slot)
 {
-    unsigned src_slot, sink_slot;
-    struct conf_port *src_port, *dst_port;
-    unsigned i;
+    conf_topo *next = NULL;
+    pjmedia_conf_op_param prm;
+    pj_status_t op_status = PJ_SUCCESS;
 
-    /* Ports must be valid. */
-    src_slot = prm->connect_ports.src;
-    sink_slot = prm->connect_ports.sink;
-    src_port = conf->ports[src_slot];
-    dst_port = conf->ports[sink_slot];
+    /* Disconnect source -> sink */
+    if (src_slot != INVALID_SLOT && sink_slot != INVALID_SLOT) {
+        op_status = topo_disconnect(conf, &next, src_slot, sink_slot);
 
-    if (!src_port || !dst_port) {
-        PJ_PERROR(3,(THIS_FILE, PJ_EINVAL,
-                     "Failed connecting %d->%d, make sure ports are valid",
-                     src_slot, sink_slot));
-        return PJ_EINVAL;
-    }
+    /* Disconnect multiple conn: any -> sink */
+    } else if (sink_slot != INVALID_SLOT) {
+        PJ_LOG(4,(THIS_FILE,
+                  "Stop any transmission to port %d (%.*s)",
+                  sink_slot,
+                  (int)conf->ports[sink_slot]->name.slen,
+                  conf->ports[sink_slot]->name.ptr));
 
-    /* Check if connection has been made */
-    for (i=0; i<src_port->listener_cnt; ++i) {
-        if (src_port->listener_slots[i] == sink_slot) {
-            PJ_LOG(3,(THIS_FILE, "Ports connection %d->%d already exists",
-                      src_slot, sink_slot));
-            return PJ_EEXISTS;
-        }
-    }
+        topo_disconnect_all(conf, &next, sink_slot, PJ_TRUE, PJ_FALSE);
 
-    src_port->listener_slots[src_port->listener_cnt] = sink_slot;
+    /* Disconnect multiple conn: source -> any */
+    } else {
+        PJ_LOG(4,(THIS_FILE,
+                  "Stop any transmission from port %d (%.*s)",
+                  src_slot,
+                  (int)conf->ports[src_slot]->name.slen,
+                  conf->ports[src_slot]->name.ptr));
 
-    /* Set normalized adjustment level. */
-    src_port->listener_adj_level[src_port->listener_cnt] =
-                                prm->connect_ports.adj_level + NORMAL_LEVEL;
+        topo_disconnect_all(conf, &next, src_slot, PJ_FALSE, PJ_TRUE);
+    }
 
-    ++conf->connect_cnt;
-    ++src_port->listener_cnt;
-    ++dst_port->transmitter_cnt;
+    if (next)
+        topo_commit(conf, next);
 
-    PJ_LOG(4,(THIS_FILE,"Port %d (%.*s) transmitting to port %d (%.*s)",
-              src_slot,
-              (int)src_port->name.slen,
-              src_port->name.ptr,
-              sink_slot,
-              (int)dst_port->name.slen,
-              dst_port->name.ptr));
+    /* Pause sound dev when there is no connection, note that
+     * pause_sound() is a no-op (just maintaining old code).
+     */
+    if (conf->topo->connect_cnt == 0) {
+        pause_sound(conf);
+    }
 
-    return PJ_SUCCESS;
+    prm.disconnect_ports.src = src_slot;
+    prm.disconnect_ports.sink = sink_slot;
+    return report_conn_op(conf, PJMEDIA_CONF_OP_DISCONNECT_PORTS, &prm,
+                          op_status);
 }
 
 /*
@@ -1427,7 +2147,6 @@ PJ_DEF(pj_status_t) pjmedia_conf_disconnect_port( pjmedia_conf *conf,
                                                   unsigned sink_slot )
 {
     struct conf_port *src_port, *dst_port;
-    op_entry *ope;
     pj_status_t status = PJ_SUCCESS;
 
     /* Check arguments */
@@ -1449,20 +2168,7 @@ PJ_DEF(pj_status_t) pjmedia_conf_disconnect_port( pjmedia_conf *conf,
         goto on_return;
     }
 
-    /* Queue the operation */
-    ope = get_free_op_entry(conf);
-    if (ope) {
-        ope->type = PJMEDIA_CONF_OP_DISCONNECT_PORTS;
-        ope->param.disconnect_ports.src = src_slot;
-        ope->param.disconnect_ports.sink = sink_slot;
-        pj_list_push_back(conf->op_queue, ope);
-
-        PJ_LOG(4,(THIS_FILE, "Disconnect ports %d->%d queued",
-                             src_slot, sink_slot));
-    } else {
-        status = PJ_ENOMEM;
-        goto on_return;
-    }
+    status = disconnect_ports(conf, src_slot, sink_slot);
 
 on_return:
     pj_mutex_unlock(conf->mutex);
@@ -1477,187 +2183,6 @@ on_return:
     return status;
 }
 
-static pj_status_t op_disconnect_ports(pjmedia_conf *conf,
-                                       const pjmedia_conf_op_param *prm)
-{
-    unsigned src_slot, sink_slot;
-    struct conf_port *src_port = NULL, *dst_port = NULL;
-    int i;
-
-    /* Ports must be valid. */
-    src_slot = prm->disconnect_ports.src;
-    sink_slot = prm->disconnect_ports.sink;
-
-    if (src_slot != INVALID_SLOT) {
-        src_port = conf->ports[src_slot];
-        if (!src_port)
-            return PJ_EINVAL;
-    }
-    if (sink_slot != INVALID_SLOT) {
-        dst_port = conf->ports[sink_slot];
-        if (!dst_port)
-            return PJ_EINVAL;
-    }
-
-    /* Disconnect source -> sink */
-    if (src_port && dst_port) {
-        /* Check if connection has been made */
-        for (i=0; i<(int)src_port->listener_cnt; ++i) {
-            if (src_port->listener_slots[i] == sink_slot)
-                break;
-        }
-        if (i == (int)src_port->listener_cnt) {
-            PJ_LOG(3,(THIS_FILE, "Ports connection %d->%d does not exist",
-                      src_slot, sink_slot));
-            return PJ_EINVAL;
-        }
-
-        /* Sanity checks */
-        pj_assert(src_port->listener_cnt > 0 &&
-                  src_port->listener_cnt <= conf->max_ports);
-        pj_assert(dst_port->transmitter_cnt > 0 &&
-                  dst_port->transmitter_cnt <= conf->max_ports);
-
-        pj_array_erase(src_port->listener_slots, sizeof(SLOT_TYPE),
-                       src_port->listener_cnt, i);
-        pj_array_erase(src_port->listener_adj_level, sizeof(unsigned),
-                       src_port->listener_cnt, i);
-        --conf->connect_cnt;
-        --src_port->listener_cnt;
-        --dst_port->transmitter_cnt;
-
-        PJ_LOG(4,(THIS_FILE,
-                  "Port %d (%.*s) stop transmitting to port %d (%.*s)",
-                  src_slot,
-                  (int)src_port->name.slen,
-                  src_port->name.ptr,
-                  sink_slot,
-                  (int)dst_port->name.slen,
-                  dst_port->name.ptr));
-
-        /* if source port is passive port and has no listener,
-         * reset delaybuf.
-         */
-        if (src_port->delay_buf && src_port->listener_cnt == 0)
-            pjmedia_delay_buf_reset(src_port->delay_buf);
-
-    /* Disconnect multiple conn: any -> sink */
-    } else if (dst_port) {
-        PJ_LOG(4,(THIS_FILE,
-                  "Stop any transmission to port %d (%.*s)",
-                  sink_slot,
-                  (int)dst_port->name.slen,
-                  dst_port->name.ptr));
-
-        for (i=0; i<(int)conf->max_ports; ++i) {
-            int j;
-
-            src_port = conf->ports[i];
-            if (!src_port || src_port->listener_cnt == 0)
-                continue;
-
-            /* We need to iterate backwards since the listener count
-             * can potentially decrease.
-             */
-            for (j=src_port->listener_cnt-1; j>=0; --j) {
-                if (src_port->listener_slots[j] == sink_slot) {
-                    pj_status_t status;
-                    pjmedia_conf_op_param op_prm = {0};
-
-                    op_prm.disconnect_ports.src = i;
-                    op_prm.disconnect_ports.sink = sink_slot;
-                    status = op_disconnect_ports(conf, &op_prm);
-                    if (status != PJ_SUCCESS) {
-                        PJ_PERROR(4, (THIS_FILE, status,
-                                      "Fail to stop transmission from port "
-                                      "%d to port %d", 
-                                      i, sink_slot));
-                    }
-                    break;
-                }
-            }
-        }
-
-    /* Disconnect multiple conn: source -> any */
-    } else if (src_port) {
-        PJ_LOG(4,(THIS_FILE,
-                  "Stop any transmission from port %d (%.*s)",
-                  src_slot,
-                  (int)src_port->name.slen,
-                  src_port->name.ptr));
-
-        /* We need to iterate backwards since the listener count
-         * will keep decreasing.
-         */
-        for (i=src_port->listener_cnt-1; i>=0; --i) {
-            pj_status_t status;
-            pjmedia_conf_op_param op_prm = {0};
-
-            op_prm.disconnect_ports.src = src_slot;
-            op_prm.disconnect_ports.sink = src_port->listener_slots[i];
-            status = op_disconnect_ports(conf, &op_prm);
-            if (status != PJ_SUCCESS) {
-                PJ_PERROR(4, (THIS_FILE, status,
-                              "Fail to stop transmission from port "
-                              "%d to port %d",
-                              src_slot, src_port->listener_slots[i]));
-            }
-        }
-
-    /* Invalid ports */
-    } else {
-        PJ_ASSERT_RETURN(!"Invalid ports specified in conf disconnect", 
-                         PJ_EINVAL);
-    }
-
-    /* Pause sound dev when there is no connection, the pause should be done
-     * outside mutex to avoid possible deadlock.
-     * Note that currently this is done with mutex, it is safe because
-     * pause_sound() is a no-op (just maintaining old code).
-     */
-    if (conf->connect_cnt == 0) {
-        pause_sound(conf);
-    }
-    return PJ_SUCCESS;
-}
-
-static pj_status_t op_adjust_conn_level(pjmedia_conf *conf,
-                                        const pjmedia_conf_op_param *prm)
-{
-    unsigned src_slot, sink_slot;
-    struct conf_port *src_port;
-    unsigned i;
-
-    src_slot = prm->adjust_conn_level.src;
-    sink_slot = prm->adjust_conn_level.sink;
-    src_port = conf->ports[src_slot];
-
-    if (!src_port || !conf->ports[sink_slot])
-        return PJ_EINVAL;
-
-    /* Find the connection */
-    for (i=0; i<src_port->listener_cnt; ++i) {
-        if (src_port->listener_slots[i] == sink_slot)
-            break;
-    }
-
-    if (i == src_port->listener_cnt) {
-        PJ_LOG(3,(THIS_FILE,
-                  "Adjust conn level: connection %d->%d does not exist",
-                  src_slot, sink_slot));
-        return PJ_EINVAL;
-    }
-
-    /* Set normalized adjustment level. */
-    src_port->listener_adj_level[i] =
-                            prm->adjust_conn_level.adj_level + NORMAL_LEVEL;
-
-    PJ_LOG(5,(THIS_FILE, "Adjusted conn level %d->%d to %d",
-              src_slot, sink_slot, prm->adjust_conn_level.adj_level));
-
-    return PJ_SUCCESS;
-}
-
 /*
  * Disconnect port from all sources
  */
@@ -1666,7 +2191,6 @@ pjmedia_conf_disconnect_port_from_sources( pjmedia_conf *conf,
                                            unsigned sink_slot)
 {
     struct conf_port *dst_port;
-    op_entry *ope;
     pj_status_t status = PJ_SUCCESS;
 
     /* Check arguments */
@@ -1685,19 +2209,7 @@ pjmedia_conf_disconnect_port_from_sources( pjmedia_conf *conf,
         goto on_return;
     }
 
-    /* Queue the operation */
-    ope = get_free_op_entry(conf);
-    if (ope) {
-        ope->type = PJMEDIA_CONF_OP_DISCONNECT_PORTS;
-        ope->param.disconnect_ports.src = INVALID_SLOT;
-        ope->param.disconnect_ports.sink = sink_slot;
-        pj_list_push_back(conf->op_queue, ope);
-
-        PJ_LOG(4,(THIS_FILE, "Disconnect ports any->%d queued", sink_slot));
-    } else {
-        status = PJ_ENOMEM;
-        goto on_return;
-    }
+    status = disconnect_ports(conf, INVALID_SLOT, sink_slot);
 
 on_return:
     pj_mutex_unlock(conf->mutex);
@@ -1721,7 +2233,6 @@ pjmedia_conf_disconnect_port_from_sinks( pjmedia_conf *conf,
                                          unsigned src_slot)
 {
     struct conf_port *src_port;
-    op_entry *ope;
     pj_status_t status = PJ_SUCCESS;
 
     /* Check arguments */
@@ -1741,18 +2252,7 @@ pjmedia_conf_disconnect_port_from_sinks( pjmedia_conf *conf,
         goto on_return;
     }
 
-    ope = get_free_op_entry(conf);
-    if (ope) {
-        ope->type = PJMEDIA_CONF_OP_DISCONNECT_PORTS;
-        ope->param.disconnect_ports.src = src_slot;
-        ope->param.disconnect_ports.sink = INVALID_SLOT;
-        pj_list_push_back(conf->op_queue, ope);
-
-        PJ_LOG(4,(THIS_FILE, "Disconnect ports %d->any queued", src_slot));
-    } else {
-        status = PJ_ENOMEM;
-        goto on_return;
-    }
+    status = disconnect_ports(conf, src_slot, INVALID_SLOT);
 
 on_return:
     pj_mutex_unlock(conf->mutex);
@@ -1781,7 +2281,13 @@ PJ_DEF(unsigned) pjmedia_conf_get_port_count(pjmedia_conf *conf)
  */
 PJ_DEF(unsigned) pjmedia_conf_get_connect_count(pjmedia_conf *conf)
 {
-    return conf->connect_cnt;
+    unsigned connect_cnt;
+
+    pj_mutex_lock(conf->mutex);
+    connect_cnt = conf->topo->connect_cnt;
+    pj_mutex_unlock(conf->mutex);
+
+    return connect_cnt;
 }
 
 
@@ -1792,7 +2298,8 @@ PJ_DEF(pj_status_t) pjmedia_conf_remove_port( pjmedia_conf *conf,
                                               unsigned port )
 {
     struct conf_port *conf_port;
-    op_entry *ope;
+    conf_topo *next = NULL;
+    pjmedia_conf_op_param prm;
     pj_status_t status = PJ_SUCCESS;
 
     pj_log_push_indent();
@@ -1810,73 +2317,61 @@ PJ_DEF(pj_status_t) pjmedia_conf_remove_port( pjmedia_conf *conf,
         goto on_return;
     }
 
+    /* Disconnect port from all sources which are transmitting to it and
+     * from all sinks to which it is transmitting to. The clock will have
+     * picked up this version by the time it removes the port.
+     */
+    topo_disconnect_all(conf, &next, port, PJ_TRUE, PJ_TRUE);
+    if (next)
+        topo_commit(conf, next);
+
     /* If port is new, remove it synchronously */
     if (conf_port->is_new) {
+        const conf_topo *used;
+        op_entry *ope;
         pj_bool_t found = PJ_FALSE;
 
-        /* Find & cancel the add-op.
-         * Also cancel all following ops involving the slot.
-         * Note that after removed, the slot may be reused by another port
-         * so if not cancelled, those following ops may be applied to the
-         * wrong port.
+        /* Find & cancel the add-op, unless the connection matrix used by
+         * the clock still connects the port. The queued connection ops
+         * are only reports of changes already applied, so they are kept.
          */
-        ope = conf->op_queue->next;
-        while (ope != conf->op_queue) {
-            op_entry* cancel_op;
-
-            cancel_op = NULL;
-            if (ope->type == PJMEDIA_CONF_OP_ADD_PORT && 
-                ope->param.add_port.port == port)
-            {
-                found = PJ_TRUE;
-                cancel_op = ope;
-            } else if (found && ope->type == PJMEDIA_CONF_OP_CONNECT_PORTS &&
-                       (ope->param.connect_ports.src == port ||
-                        ope->param.connect_ports.sink == port))
-            {
-                cancel_op = ope;
-            } else if (found && ope->type == PJMEDIA_CONF_OP_DISCONNECT_PORTS &&
-                       (ope->param.disconnect_ports.src == port ||
-                        ope->param.disconnect_ports.sink == port))
-            {
-                cancel_op = ope;
-            } else if (found &&
-                       ope->type == PJMEDIA_CONF_OP_ADJUST_CONN_LEVEL &&
-                       (ope->param.adjust_conn_level.src == port ||
-                        ope->param.adjust_conn_level.sink == port))
-            {
-                cancel_op = ope;
+        pj_mutex_lock(conf->sync_mutex);
+        used = conf->topo_used;
+        if (!used || (used->listeners[port]->cnt == 0 &&
+                      used->transmitter_cnt[port] == 0))
+        {
+            ope = conf->op_queue->next;
+            while (ope != conf->op_queue) {
+                if (ope->type == PJMEDIA_CONF_OP_ADD_PORT &&
+                    ope->param.add_port.port == port)
+                {
+                    pj_list_erase(ope);
+                    ope->type = PJMEDIA_CONF_OP_UNKNOWN;
+                    pj_list_push_back(conf->op_queue_free, ope);
+                    found = PJ_TRUE;
+                    break;
+                }
+                ope = ope->next;
             }
+        }
+        pj_mutex_unlock(conf->sync_mutex);
 
-            ope = ope->next;
-
-            /* Cancel op */
-            if (cancel_op) {
-                pjmedia_conf_op_info op_info = { 0 };
-
-                op_info.op_type = cancel_op->type;
-                op_info.op_param = cancel_op->param;
-
-                pj_list_erase(cancel_op);
-                cancel_op->type = PJMEDIA_CONF_OP_UNKNOWN;
-                pj_list_push_back(conf->op_queue_free, cancel_op);
+        if (found && conf->cb) {
+            pjmedia_conf_op_info op_info = { 0 };
 
-                if (conf->cb) {
-                    pj_log_push_indent();
-                    op_info.conf = conf;
-                    op_info.status = PJ_ECANCELLED;
-                    (*conf->cb)(&op_info);
-                    pj_log_pop_indent();
-                }
-            }
+            pj_log_push_indent();
+            op_info.conf = conf;
+            op_info.op_type = PJMEDIA_CONF_OP_ADD_PORT;
+            op_info.op_param.add_port.port = port;
+            op_info.status = PJ_ECANCELLED;
+            (*conf->cb)(&op_info);
+            pj_log_pop_indent();
         }
 
         /* If the add-op is not found, it may be being executed,
          * do not remove it synchronously to avoid race condition.
          */
         if (found) {
-            pjmedia_conf_op_param prm;
-
             /* Mark the port as removing before releasing the mutex, so
              * other threads can no longer queue any operation on it
              * (e.g: connect/disconnect) nor remove it again while it is
@@ -1888,13 +2383,12 @@ PJ_DEF(pj_status_t) pjmedia_conf_remove_port( pjmedia_conf *conf,
             pj_mutex_unlock(conf->mutex);
 
             /* The port has never been active (its add-op has just been
-             * cancelled above), so it has no connection and the clock
-             * thread never touches it. It is safe to destroy the port
-             * resources from this thread. Note that op_remove_port()
-             * must not be called from here as it modifies states shared
-             * with the clock thread (e.g: while disconnecting the port
-             * from other ports), so it can only be run by the clock
-             * thread.
+             * cancelled above), and it has no connection in the version
+             * used by the clock, so the clock thread never touches it.
+             * It is safe to destroy the port resources from this thread.
+             * Note that op_remove_port() must not be called from here as
+             * it modifies states shared with the clock thread, so it can
+             * only be run by the clock thread.
              */
             destroy_conf_port_resources(conf_port);
 
@@ -1925,18 +2419,14 @@ PJ_DEF(pj_status_t) pjmedia_conf_remove_port( pjmedia_conf *conf,
     }
 
     /* Queue the operation */
-    ope = get_free_op_entry(conf);
-    if (ope) {
-        ope->type = PJMEDIA_CONF_OP_REMOVE_PORT;
-        ope->param.remove_port.port = port;
-        pj_list_push_back(conf->op_queue, ope);
-        conf_port->removing = PJ_TRUE;
-
-        PJ_LOG(4,(THIS_FILE, "Remove port %d queued", port));
-    } else {
-        status = PJ_ENOMEM;
+    prm.remove_port.port = port;
+    status = queue_op(conf, PJMEDIA_CONF_OP_REMOVE_PORT, &prm, PJ_SUCCESS);
+    if (status != PJ_SUCCESS)
         goto on_return;
-    }
+
+    conf_port->removing = PJ_TRUE;
+
+    PJ_LOG(4,(THIS_FILE, "Remove port %d queued", port));
 
 on_return:
     pj_mutex_unlock(conf->mutex);
@@ -1992,8 +2482,6 @@ static pj_status_t op_remove_port(pjmedia_conf *conf,
 {
     unsigned port = prm->remove_port.port;
     struct conf_port *conf_port;
-    pjmedia_conf_op_param op_prm;
-    pj_status_t status;
 
     /* Port must be valid. */
     conf_port = conf->ports[port];
@@ -2004,27 +2492,14 @@ static pj_status_t op_remove_port(pjmedia_conf *conf,
 
     conf_port->tx_setting = PJMEDIA_PORT_DISABLE;
     conf_port->rx_setting = PJMEDIA_PORT_DISABLE;
+    if (conf_port->enc_rx && !conf_port->is_new)
+        --conf->enc_port_cnt;
 
-    /* disconnect port from all sources which are transmitting to it */
-    pj_bzero(&op_prm, sizeof(op_prm));
-    op_prm.disconnect_ports.src = INVALID_SLOT;
-    op_prm.disconnect_ports.sink = port;
-    status = op_disconnect_ports(conf, &op_prm);
-    if (status != PJ_SUCCESS) {
-        PJ_PERROR(4, (THIS_FILE, status,
-                      "Fail to stop transmission from any->%d", port));
-    }
+    /* The port has been disconnected from other ports when the removal
+     * was requested, pick up that version before the slot is freed.
+     */
+    topo_update(conf);
 
-    /* disconnect port from all sinks to which it is transmitting to */
-    pj_bzero(&op_prm, sizeof(op_prm));
-    op_prm.disconnect_ports.src = port;
-    op_prm.disconnect_ports.sink = INVALID_SLOT;
-    status = op_disconnect_ports(conf, &op_prm);
-    if (status != PJ_SUCCESS) {
-        PJ_PERROR(4, (THIS_FILE, status,
-                      "Fail to stop transmission from %d->any", port));
-    }
-    
     /* Destroy the port's own resources. */
     destroy_conf_port_resources(conf_port);
 
@@ -2139,9 +2614,9 @@ PJ_DEF(pj_status_t) pjmedia_conf_get_port_info( pjmedia_conf *conf,
     }
     info->tx_setting = conf_port->tx_setting;
     info->rx_setting = conf_port->rx_setting;
-    info->listener_cnt = conf_port->listener_cnt;
-    info->listener_slots = conf_port->listener_slots;
-    info->transmitter_cnt = conf_port->transmitter_cnt;
+    info->listener_cnt = conf->topo->listeners[slot]->cnt;
+    info->listener_slots = conf->topo->listeners[slot]->slots;
+    info->transmitter_cnt = conf->topo->transmitter_cnt[slot];
     info->clock_rate = conf_port->clock_rate;
     info->channel_count = conf_port->channel_count;
     info->samples_per_frame = conf_port->samples_per_frame;
@@ -2220,6 +2695,22 @@ PJ_DEF(pj_status_t) pjmedia_conf_get_signal_level( pjmedia_conf *conf,
 }
 
 
+/*
+ * Get thread statistics, only supported by the parallel bridge.
+ */
+PJ_DEF(pj_status_t) pjmedia_conf_get_thread_stat(
+                                            pjmedia_conf *conf,
+                                            unsigned *count,
+                                            pjmedia_conf_thread_stat stat[])
+{
+    PJ_UNUSED_ARG(conf);
+    PJ_UNUSED_ARG(count);
+    PJ_UNUSED_ARG(stat);
+
+    return PJ_ENOTSUP;
+}
+
+
 /*
  * Adjust RX level of individual port.
  */
@@ -2304,8 +2795,9 @@ PJ_DEF(pj_status_t) pjmedia_conf_adjust_conn_level( pjmedia_conf *conf,
                                                     int adj_level )
 {
     struct conf_port *src_port, *dst_port;
-    op_entry *ope;
-    pj_status_t status = PJ_SUCCESS;
+    conf_topo *next = NULL;
+    pjmedia_conf_op_param prm;
+    pj_status_t op_status, status;
 
     /* Check arguments */
     PJ_ASSERT_RETURN(conf && src_slot<conf->max_ports &&
@@ -2327,29 +2819,185 @@ PJ_DEF(pj_status_t) pjmedia_conf_adjust_conn_level( pjmedia_conf *conf,
         return PJ_EINVAL;
     }
 
-    /* Queue the operation */
-    ope = get_free_op_entry(conf);
-    if (ope) {
-        ope->type = PJMEDIA_CONF_OP_ADJUST_CONN_LEVEL;
-        ope->param.adjust_conn_level.src = src_slot;
-        ope->param.adjust_conn_level.sink = sink_slot;
-        ope->param.adjust_conn_level.adj_level = adj_level;
-        pj_list_push_back(conf->op_queue, ope);
-    } else {
-        status = PJ_ENOMEM;
-    }
+    /* Publish the new level */
+    op_status = topo_adjust_level(conf, &next, src_slot, sink_slot,
+                                  adj_level);
+    if (next)
+        topo_commit(conf, next);
+
+    prm.adjust_conn_level.src = src_slot;
+    prm.adjust_conn_level.sink = sink_slot;
+    prm.adjust_conn_level.adj_level = adj_level;
+    status = report_conn_op(conf, PJMEDIA_CONF_OP_ADJUST_CONN_LEVEL, &prm,
+                            op_status);
 
     pj_mutex_unlock(conf->mutex);
     return status;
 }
 
 
+/*
+ * Calculate the average absolute level of the samples.
+ */
+static pj_int32_t calc_avg_level(pjmedia_conf *conf,
+                                 const pj_int16_t *buf, unsigned count)
+{
+    return count? (pj_int32_t)(conf->mk->sum_abs(buf, count) / count) : 0;
+}
+
+/*
+ * Get the encoded frame from an encoded port into its enc_rx.
+ */
+static pj_status_t get_enc_frame(struct conf_port *cport)
+{
+    pjmedia_frame_ext *f = cport->enc_rx;
+    pj_status_t status;
+
+    pj_bzero(f, sizeof(*f));
+    f->base.type = PJMEDIA_FRAME_TYPE_EXTENDED;
+
+    status = pjmedia_port_get_frame(cport->port, &f->base);
+    cport->enc_rx_ok = (status == PJ_SUCCESS &&
+                        f->base.type == PJMEDIA_FRAME_TYPE_EXTENDED &&
+                        f->subframe_cnt != 0);
+    return status;
+}
+
+/*
+ * Decode the frame in enc_rx of an encoded port. Missing samples, e.g.
+ * lost subframes, are filled with silence.
+ */
+static void decode_enc_frame(struct conf_port *cport, pj_int16_t *buf)
+{
+    const pjmedia_frame_ext *f = cport->enc_rx;
+    unsigned i, samples_per_subframe, count = 0;
+
+    samples_per_subframe = f->samples_cnt / f->subframe_cnt;
+
+    for (i = 0; i < f->subframe_cnt &&
+                count < cport->samples_per_frame; ++i)
+    {
+        pjmedia_frame_ext_subframe *sf;
+        unsigned n = samples_per_subframe;
+
+        sf = pjmedia_frame_ext_get_subframe(f, i);
+        if (n > cport->samples_per_frame - count)
+            n = cport->samples_per_frame - count;
+
+        if ((unsigned)(sf->bitlen >> 3) < n) {
+            pjmedia_zero_samples(buf + count, n);
+        } else if (cport->fmt_id == PJMEDIA_FORMAT_PCMU) {
+            pjmedia_ulaw_decode(buf + count, sf->data, n);
+        } else {
+            pjmedia_alaw_decode(buf + count, sf->data, n);
+        }
+        count += n;
+    }
+
+    if (count < cport->samples_per_frame)
+        pjmedia_zero_samples(buf + count, cport->samples_per_frame - count);
+}
+
+/*
+ * Calculate the average absolute level of the frame in enc_rx of an
+ * encoded port, without decoding it to a buffer.
+ */
+static pj_int32_t calc_enc_level(const struct conf_port *cport)
+{
+    const pjmedia_frame_ext *f = cport->enc_rx;
+    pj_uint32_t sum = 0;
+    unsigned i, j, count = 0;
+
+    for (i = 0; i < f->subframe_cnt; ++i) {
+        pjmedia_frame_ext_subframe *sf;
+        unsigned len;
+
+        sf = pjmedia_frame_ext_get_subframe(f, i);
+        len = sf->bitlen >> 3;
+        if (cport->fmt_id == PJMEDIA_FORMAT_PCMU) {
+            for (j = 0; j < len; ++j) {
+                int s = pjmedia_ulaw2linear(sf->data[j]);
+                sum += (s < 0)? -s : s;
+            }
+        } else {
+            for (j = 0; j < len; ++j) {
+                int s = pjmedia_alaw2linear(sf->data[j]);
+                sum += (s < 0)? -s : s;
+            }
+        }
+        count += len;
+    }
+
+    return count? (pj_int32_t)(sum / count) : 0;
+}
+
+/*
+ * Get a PCM frame from the port, decoding it for encoded port.
+ */
+static pj_status_t get_port_frame(struct conf_port *cport,
+                                  pjmedia_frame *frame)
+{
+    pj_status_t status;
+
+    if (!cport->enc_rx)
+        return pjmedia_port_get_frame(cport->port, frame);
+
+    status = get_enc_frame(cport);
+    if (status != PJ_SUCCESS)
+        return status;
+
+    if (cport->enc_rx_ok) {
+        decode_enc_frame(cport, (pj_int16_t*)frame->buf);
+        frame->type = PJMEDIA_FRAME_TYPE_AUDIO;
+        frame->size = cport->samples_per_frame * BYTES_PER_SAMPLE;
+    } else {
+        frame->type = PJMEDIA_FRAME_TYPE_NONE;
+        frame->size = 0;
+    }
+    frame->timestamp = cport->enc_rx->base.timestamp;
+
+    return PJ_SUCCESS;
+}
+
+/*
+ * Put a PCM frame to the port, encoding it for encoded port.
+ */
+static pj_status_t put_port_frame(struct conf_port *cport,
+                                  pjmedia_frame *frame)
+{
+    pjmedia_frame_ext *f = cport->enc_tx;
+    unsigned count;
+
+    if (!f || frame->type != PJMEDIA_FRAME_TYPE_AUDIO)
+        return pjmedia_port_put_frame(cport->port, frame);
+
+    count = (unsigned)(frame->size / BYTES_PER_SAMPLE);
+    if (cport->fmt_id == PJMEDIA_FORMAT_PCMU) {
+        pjmedia_ulaw_encode(cport->enc_buf, (pj_int16_t*)frame->buf, count);
+    } else {
+        pjmedia_alaw_encode(cport->enc_buf, (pj_int16_t*)frame->buf, count);
+    }
+
+    pj_bzero(f, sizeof(*f));
+    f->base.type = PJMEDIA_FRAME_TYPE_EXTENDED;
+    f->base.timestamp = frame->timestamp;
+    pjmedia_frame_ext_append_subframe(f, cport->enc_buf, count << 3, count);
+
+    return pjmedia_port_put_frame(cport->port, &f->base);
+}
+
 /*
  * Read from port.
+ *
+ * If p_level is not NULL, the frame is read only to get its level: the
+ * samples are not converted to the bridge's clock rate and the content of
+ * the frame buffer is unspecified. The average absolute level of the frame
+ * is returned in p_level, before any level adjustment.
  */
 static pj_status_t read_port( pjmedia_conf *conf,
                               struct conf_port *cport, pj_int16_t *frame,
-                              pj_size_t count, pjmedia_frame_type *type )
+                              pj_size_t count, pjmedia_frame_type *type,
+                              pj_int32_t *p_level )
 {
 
     pj_assert(count == conf->samples_per_frame);
@@ -2374,10 +3022,16 @@ static pj_status_t read_port( pjmedia_conf *conf,
                    (int)cport->name.slen, cport->name.ptr,
                    count));
 
-        status = pjmedia_port_get_frame(cport->port, &f);
+        status = get_port_frame(cport, &f);
 
         *type = f.type;
 
+        if (p_level && status == PJ_SUCCESS &&
+            f.type == PJMEDIA_FRAME_TYPE_AUDIO)
+        {
+            *p_level = calc_avg_level(conf, frame, (unsigned)count);
+        }
+
         return status;
 
     } else {
@@ -2411,7 +3065,7 @@ static pj_status_t read_port( pjmedia_conf *conf,
             TRACE_((THIS_FILE, "  get_frame, count=%d", 
                        cport->samples_per_frame));
 
-            status = pjmedia_port_get_frame(cport->port, &f);
+            status = get_port_frame(cport, &f);
 
             if (status != PJ_SUCCESS) {
                 /* Fatal error! */
@@ -2456,11 +3110,23 @@ static pj_status_t read_port( pjmedia_conf *conf,
             pj_assert(cport->rx_buf_count <= cport->rx_buf_cap);
         }
 
+        /*
+         * When only the level is wanted, take it from the samples in the
+         * port's clock rate and discard them.
+         */
+        if (p_level) {
+            *p_level = calc_avg_level(conf, cport->rx_buf, samples_req);
+            cport->rx_buf_count -= samples_req;
+            if (cport->rx_buf_count) {
+                pjmedia_move_samples(cport->rx_buf, cport->rx_buf+samples_req,
+                                     cport->rx_buf_count);
+            }
+
         /*
          * If port's clock_rate is different, resample.
          * Otherwise just copy.
          */
-        if (cport->clock_rate != conf->clock_rate) {
+        } else if (cport->clock_rate != conf->clock_rate) {
             
             unsigned src_count;
 
@@ -2503,7 +3169,7 @@ static pj_status_t write_port(pjmedia_conf *conf, struct conf_port *cport,
                               pjmedia_frame_type *frm_type)
 {
     pj_int16_t *buf;
-    unsigned j, ts;
+    unsigned ts;
     pj_status_t status;
     pj_int32_t adj_level;
     pj_int32_t tx_level;
@@ -2562,6 +3228,33 @@ static pj_status_t write_port(pjmedia_conf *conf, struct conf_port *cport,
     /* Reset heart-beat sample count */
     cport->tx_heart_beat = 0;
 
+    /* Passthrough: forward the encoded frame of the only source as is.
+     * The port has the bridge's ptime, so it takes one frame per tick.
+     */
+    if (cport->pt_src) {
+        const struct conf_port *src = cport->pt_src;
+        pjmedia_frame_ext *f = src->enc_rx;
+        pjmedia_frame none_frame;
+        pjmedia_frame *frame = &f->base;
+
+        cport->tx_buf_count = 0;
+        if (src->enc_rx_ok) {
+            cport->tx_level = src->rx_level;
+            *frm_type = PJMEDIA_FRAME_TYPE_EXTENDED;
+        } else {
+            none_frame.type = PJMEDIA_FRAME_TYPE_NONE;
+            none_frame.buf = NULL;
+            none_frame.size = 0;
+            frame = &none_frame;
+            cport->tx_level = 0;
+            *frm_type = PJMEDIA_FRAME_TYPE_NONE;
+        }
+        frame->timestamp.u64 = timestamp->u64 * cport->clock_rate /
+                               conf->clock_rate;
+
+        return pjmedia_port_put_frame(cport->port, frame);
+    }
+
     buf = (pj_int16_t*) cport->mix_buf;
 
     /* If there are sources in the mix buffer, convert the mixed samples
@@ -2591,30 +3284,11 @@ static pj_status_t write_port(pjmedia_conf *conf, struct conf_port *cport,
 
     tx_level = 0;
 
-    if (adj_level != NORMAL_LEVEL) {
-        for (j=0; j<conf->samples_per_frame; ++j) {
-            pj_int32_t itemp = cport->mix_buf[j];
-
-            /* Adjust the level */
-            /*itemp = itemp * adj_level / NORMAL_LEVEL;*/
-            itemp = (itemp * adj_level) >> 7;
-
-            /* Clip the signal if it's too loud */
-            if (itemp > MAX_LEVEL) itemp = MAX_LEVEL;
-            else if (itemp < MIN_LEVEL) itemp = MIN_LEVEL;
-
-            /* Put back in the buffer. */
-            buf[j] = (pj_int16_t) itemp;
-
-            tx_level += (buf[j]>=0? buf[j] : -buf[j]);
-        }
-    } else {
-        for (j=0; j<conf->samples_per_frame; ++j) {
-            buf[j] = (pj_int16_t) cport->mix_buf[j];
-            tx_level += (buf[j]>=0? buf[j] : -buf[j]);
-        }
-    }
-
+    /* Adjust the level, clip the signal if it's too loud, and calculate
+     * the average level at the same time.
+     */
+    tx_level = conf->mk->clamp(buf, cport->mix_buf, adj_level,
+                               conf->samples_per_frame);
     tx_level /= conf->samples_per_frame;
 
     /* Convert level to 8bit complement ulaw */
@@ -2645,7 +3319,7 @@ static pj_status_t write_port(pjmedia_conf *conf, struct conf_port *cport,
                                (int)cport->name.slen, cport->name.ptr,
                                frame.size / BYTES_PER_SAMPLE));
 
-            return pjmedia_port_put_frame(cport->port, &frame);
+            return put_port_frame(cport, &frame);
         } else
             return PJ_SUCCESS;
     }
@@ -2716,7 +3390,7 @@ static pj_status_t write_port(pjmedia_conf *conf, struct conf_port *cport,
                                (int)cport->name.slen, cport->name.ptr,
                                frame.size / BYTES_PER_SAMPLE));
 
-            status = pjmedia_port_put_frame(cport->port, &frame);
+            status = put_port_frame(cport, &frame);
 
         } else
             status = PJ_SUCCESS;
@@ -2736,6 +3410,227 @@ static pj_status_t write_port(pjmedia_conf *conf, struct conf_port *cport,
 }
 
 
+/*
+ * Check if the port hears every source other than itself, i.e. its signal
+ * can be derived from the sum of all sources in mix-minus mode. As all
+ * transmitters of a port are sources, comparing the counts is enough.
+ */
+PJ_INLINE(pj_bool_t) hears_all_sources(const pjmedia_conf *conf,
+                                       const struct conf_port *cport)
+{
+    unsigned others = cport->transmitter_cnt - (cport->self_listen? 1 : 0);
+
+    return others == conf->src_cnt - (cport->listener_cnt? 1 : 0);
+}
+
+/*
+ * Complete the mix buffer of a mix-minus listener, which so far only
+ * contains the connection level corrections, by adding the sum of all
+ * sources minus the port's own signal (unless it listens to itself).
+ */
+static void mix_minus_listener(pjmedia_conf *conf, struct conf_port *cport)
+{
+    const pj_int16_t *own = NULL;
+    pj_int32_t mix_buf_min = 0;
+    pj_int32_t mix_buf_max = 0;
+
+    if (cport->rx_active && !cport->self_listen)
+        own = cport->rx_frame_buf;
+
+    conf->mk->accumulate32(cport->mix_buf, conf->mix_sum, own,
+                           conf->samples_per_frame,
+                           &mix_buf_min, &mix_buf_max);
+
+    /* Check if normalization adjustment needed. */
+    if (mix_buf_min < MIN_LEVEL || mix_buf_max > MAX_LEVEL) {
+        int tmp_adj;
+
+        if (-mix_buf_min > mix_buf_max)
+            mix_buf_max = -mix_buf_min;
+
+        /* NORMAL_LEVEL * MAX_LEVEL / mix_buf_max; */
+        tmp_adj = (MAX_LEVEL<<7) / mix_buf_max;
+        if (tmp_adj < cport->mix_adj)
+            cport->mix_adj = tmp_adj;
+    }
+}
+
+/*
+ * Ranking score of a source for the active speaker policy. The current
+ * speakers get a bonus so that the selection doesn't keep switching
+ * between sources of similar level.
+ */
+PJ_INLINE(unsigned) speaker_score(const pjmedia_conf *conf,
+                                  const struct conf_port *cport)
+{
+    return cport->speaker_level +
+           (cport->speaking? conf->speaker_hysteresis : 0);
+}
+
+/*
+ * Active speaker policy: select the loudest sources to be mixed on this
+ * frame, ranked by their (smoothed) level on the previous frame.
+ */
+static void select_speakers(pjmedia_conf *conf)
+{
+    struct conf_port **ranking = conf->ranking;
+    unsigned i, ci, k, cnt = 0;
+
+    for (i=0, ci=0; i<conf->max_ports && ci<conf->port_cnt; ++i) {
+        struct conf_port *cport = conf->ports[i];
+        unsigned score;
+
+        /* Skip empty or new port. */
+        if (!cport || cport->is_new)
+            continue;
+
+        /* Var "ci" is to count how many ports have been visited so far. */
+        ++ci;
+
+        /* Instant attack, slow release. */
+        if (cport->rx_level >= cport->speaker_level) {
+            cport->speaker_level = cport->rx_level;
+        } else {
+            cport->speaker_level -= (cport->speaker_level -
+                                     cport->rx_level + 7) >> 3;
+        }
+
+        /* Only sources with some signal compete. */
+        if (cport->listener_cnt == 0 || cport->speaker_level == 0)
+            continue;
+
+        /* Insert to the ranking, loudest first. */
+        score = speaker_score(conf, cport);
+        if (cnt == conf->max_speakers) {
+            if (score <= speaker_score(conf, ranking[cnt-1]))
+                continue;
+            k = cnt - 1;
+        } else {
+            k = cnt++;
+        }
+        while (k > 0 && speaker_score(conf, ranking[k-1]) < score) {
+            ranking[k] = ranking[k-1];
+            --k;
+        }
+        ranking[k] = cport;
+    }
+
+    /* Replace the current speakers. Previous speakers are kept by slot
+     * since they may have been removed from the bridge.
+     */
+    for (k=0; k<conf->speaker_cnt; ++k) {
+        struct conf_port *cport = conf->ports[conf->speakers[k]];
+        if (cport)
+            cport->speaking = PJ_FALSE;
+    }
+    for (k=0; k<cnt; ++k) {
+        ranking[k]->speaking = PJ_TRUE;
+    }
+    for (i=0, k=0; k<cnt && i<conf->max_ports; ++i) {
+        if (conf->ports[i] && conf->ports[i]->speaking)
+            conf->speakers[k++] = (SLOT_TYPE)i;
+    }
+    conf->speaker_cnt = cnt;
+}
+
+/*
+ * Get the level of a source which is not selected to be mixed by the
+ * active speaker policy, without converting its frame.
+ */
+static unsigned probe_port(pjmedia_conf *conf, struct conf_port *cport,
+                           pj_int16_t *buf)
+{
+    pj_int32_t level = 0;
+
+    if (cport->delay_buf != NULL) {
+        if (pjmedia_delay_buf_get(cport->delay_buf, buf) != PJ_SUCCESS)
+            return 0;
+        level = calc_avg_level(conf, buf, conf->samples_per_frame);
+    } else {
+        pjmedia_frame_type frame_type;
+        pj_status_t status;
+
+        status = read_port(conf, cport, buf, conf->samples_per_frame,
+                           &frame_type, &level);
+        if (status != PJ_SUCCESS || frame_type != PJMEDIA_FRAME_TYPE_AUDIO)
+            return 0;
+    }
+
+    /* Apply the RX level adjustment */
+    level = (level * (pj_int32_t)cport->rx_adj_level) >> 7;
+    if (level > MAX_LEVEL)
+        level = MAX_LEVEL;
+
+    /* Convert level to 8bit complement ulaw */
+    return pjmedia_linear2ulaw(level) ^ 0xff;
+}
+
+/*
+ * Get the source whose encoded frame can be forwarded as is to the port on
+ * this tick: the port's only source, with the same format and ptime, and
+ * no level adjustment or speaker selection to apply to the signal.
+ */
+static struct conf_port *passthrough_src(const pjmedia_conf *conf,
+                                         const struct conf_port *cport)
+{
+    struct conf_port *src;
+
+    if (!cport->pt_capable || !cport->passthrough ||
+        cport->only_src == INVALID_SLOT ||
+        cport->tx_setting != PJMEDIA_PORT_ENABLE ||
+        cport->tx_adj_level != NORMAL_LEVEL ||
+        cport->only_src_adj != NORMAL_LEVEL)
+    {
+        return NULL;
+    }
+
+    src = conf->ports[cport->only_src];
+    if (!src || src->is_new || !src->pt_capable ||
+        src->fmt_id != cport->fmt_id ||
+        src->clock_rate != cport->clock_rate ||
+        src->channel_count != cport->channel_count ||
+        src->rx_setting != PJMEDIA_PORT_ENABLE ||
+        src->rx_adj_level != NORMAL_LEVEL ||
+        (conf->max_speakers && !src->speaking))
+    {
+        return NULL;
+    }
+
+    return src;
+}
+
+/*
+ * Select the listeners which get the encoded frame of their source as is
+ * on this tick.
+ */
+static void update_passthrough(pjmedia_conf *conf)
+{
+    unsigned i, ci;
+
+    for (i=0, ci=0; i<conf->max_ports && ci<conf->port_cnt; ++i) {
+        struct conf_port *cport = conf->ports[i];
+
+        if (!cport || cport->is_new)
+            continue;
+        ++ci;
+
+        cport->pt_listener_cnt = 0;
+        cport->enc_rx_ok = PJ_FALSE;
+    }
+
+    for (i=0, ci=0; i<conf->max_ports && ci<conf->port_cnt; ++i) {
+        struct conf_port *cport = conf->ports[i];
+
+        if (!cport || cport->is_new)
+            continue;
+        ++ci;
+
+        cport->pt_src = passthrough_src(conf, cport);
+        if (cport->pt_src)
+            ++cport->pt_src->pt_listener_cnt;
+    }
+}
+
 /*
  * Player callback.
  */
@@ -2744,8 +3639,10 @@ static pj_status_t get_frame(pjmedia_port *this_port,
 {
     pjmedia_conf *conf = (pjmedia_conf*) this_port->port_data.pdata;
     pjmedia_frame_type speaker_frame_type = PJMEDIA_FRAME_TYPE_NONE;
-    unsigned ci, cj, i, j;
+    unsigned ci, cj, i;
     pj_int16_t *p_in;
+    pj_bool_t mix_minus = (conf->mix_sum != NULL);
+    unsigned direct_cnt = 0;
     
     TRACE_((THIS_FILE, "- clock -"));
 
@@ -2754,7 +3651,7 @@ static pj_status_t get_frame(pjmedia_port *this_port,
                              conf->bits_per_sample / 8);
 
     /* Perform any queued operations that need to be synchronized with
-     * the clock such as connect, disonnect, remove.
+     * the clock such as add and remove port.
      */
     if (!pj_list_empty(conf->op_queue)) {
         pj_log_push_indent();
@@ -2762,6 +3659,9 @@ static pj_status_t get_frame(pjmedia_port *this_port,
         pj_log_pop_indent();
     }
 
+    /* Pick up the latest connections. */
+    topo_update(conf);
+
     /* No mutex from this point! Otherwise it may cause deadlock as
      * put_frame()/get_frame() may invoke callback.
      *
@@ -2769,6 +3669,20 @@ static pj_status_t get_frame(pjmedia_port *this_port,
      * synchronized.
      */
 
+    /* Select the sources to be mixed by the active speaker policy. */
+    if (conf->max_speakers)
+        select_speakers(conf);
+
+    /* Select the listeners getting the encoded frame of their source. */
+    if (conf->enc_port_cnt)
+        update_passthrough(conf);
+
+    /* In mix-minus mode, reset the sum of all sources. */
+    if (mix_minus) {
+        pj_bzero(conf->mix_sum,
+                 conf->samples_per_frame*sizeof(conf->mix_sum[0]));
+    }
+
     /* Reset port source count. We will only reset port's mix
      * buffer when we have someone transmitting to it.
      */
@@ -2782,9 +3696,17 @@ static pj_status_t get_frame(pjmedia_port *this_port,
         /* Var "ci" is to count how many ports have been visited so far. */
         ++ci;
 
-        /* Skip if we're not allowed to transmit to this port. */
-        if (conf_port->tx_setting != PJMEDIA_PORT_ENABLE)
+        conf_port->rx_active = PJ_FALSE;
+        conf_port->mix_minus = PJ_FALSE;
+
+        /* Skip if we're not allowed to transmit to this port, or if the
+         * port gets the encoded frame of its source.
+         */
+        if (conf_port->tx_setting != PJMEDIA_PORT_ENABLE ||
+            conf_port->pt_src)
+        {
             continue;
+        }
 
         /* Reset buffer (only necessary if the port has transmitter) and
          * reset auto adjustment level for mixed signal.
@@ -2793,6 +3715,13 @@ static pj_status_t get_frame(pjmedia_port *this_port,
         if (conf_port->transmitter_cnt) {
             pj_bzero(conf_port->mix_buf,
                      conf->samples_per_frame*sizeof(conf_port->mix_buf[0]));
+
+            /* Count listeners that must be mixed source by source. */
+            if (mix_minus) {
+                conf_port->mix_minus = hears_all_sources(conf, conf_port);
+                if (!conf_port->mix_minus)
+                    ++direct_cnt;
+            }
         }
     }
 
@@ -2822,6 +3751,35 @@ static pj_status_t get_frame(pjmedia_port *this_port,
             continue;
         }
 
+        /* Only get the level of a source that the active speaker policy
+         * doesn't mix, so that it can be selected on the next frame.
+         */
+        if (conf->max_speakers && !conf_port->speaking) {
+            conf_port->rx_level = probe_port(conf, conf_port,
+                                             (pj_int16_t*)frame->buf);
+            continue;
+        }
+
+        /* If all listeners get the encoded frame as is, there is no
+         * need to decode it.
+         */
+        if (conf_port->pt_listener_cnt == conf_port->listener_cnt) {
+            pj_int32_t enc_level = 0;
+
+            if (get_enc_frame(conf_port) == PJ_SUCCESS &&
+                conf_port->enc_rx_ok)
+            {
+                enc_level = calc_enc_level(conf_port);
+            }
+            conf_port->rx_level = pjmedia_linear2ulaw(enc_level) ^ 0xff;
+            continue;
+        }
+
+        /* In mix-minus mode, the frame must be kept until the end of
+         * the tick, so read it into the port's own buffer.
+         */
+        p_in = mix_minus? conf_port->rx_frame_buf : (pj_int16_t*)frame->buf;
+
         /* Get frame from this port.
          * For passive ports, get the frame from the delay_buf.
          * For other ports, get the frame from the port. 
@@ -2829,8 +3787,7 @@ static pj_status_t get_frame(pjmedia_port *this_port,
         if (conf_port->delay_buf != NULL) {
             pj_status_t status;
         
-            status = pjmedia_delay_buf_get(conf_port->delay_buf,
-                                  (pj_int16_t*)frame->buf);
+            status = pjmedia_delay_buf_get(conf_port->delay_buf, p_in);
             if (status != PJ_SUCCESS) {
                 conf_port->rx_level = 0;
                 continue;
@@ -2841,8 +3798,8 @@ static pj_status_t get_frame(pjmedia_port *this_port,
             pj_status_t status;
             pjmedia_frame_type frame_type;
 
-            status = read_port(conf, conf_port, (pj_int16_t*)frame->buf, 
-                               conf->samples_per_frame, &frame_type);
+            status = read_port(conf, conf_port, p_in,
+                               conf->samples_per_frame, &frame_type, NULL);
             
             if (status != PJ_SUCCESS) {
                 /* bennylp: why do we need this????
@@ -2865,38 +3822,14 @@ static pj_status_t get_frame(pjmedia_port *this_port,
             }
         }
 
-        p_in = (pj_int16_t*) frame->buf;
-
         /* Adjust the RX level from this port
          * and calculate the average level at the same time.
          */
         if (conf_port->rx_adj_level != NORMAL_LEVEL) {
-            for (j=0; j<conf->samples_per_frame; ++j) {
-                /* For the level adjustment, we need to store the sample to
-                 * a temporary 32bit integer value to avoid overflowing the
-                 * 16bit sample storage.
-                 */
-                pj_int32_t itemp;
-
-                itemp = p_in[j];
-                /*itemp = itemp * adj / NORMAL_LEVEL;*/
-                /* bad code (signed/unsigned badness):
-                 *  itemp = (itemp * conf_port->rx_adj_level) >> 7;
-                 */
-                itemp *= conf_port->rx_adj_level;
-                itemp >>= 7;
-
-                /* Clip the signal if it's too loud */
-                if (itemp > MAX_LEVEL) itemp = MAX_LEVEL;
-                else if (itemp < MIN_LEVEL) itemp = MIN_LEVEL;
-
-                p_in[j] = (pj_int16_t) itemp;
-                level += (p_in[j]>=0? p_in[j] : -p_in[j]);
-            }
+            level = conf->mk->apply_gain(p_in, p_in, conf_port->rx_adj_level,
+                                         conf->samples_per_frame);
         } else {
-            for (j=0; j<conf->samples_per_frame; ++j) {
-                level += (p_in[j]>=0? p_in[j] : -p_in[j]);
-            }
+            level = conf->mk->sum_abs(p_in, conf->samples_per_frame);
         }
 
         level /= conf->samples_per_frame;
@@ -2913,6 +3846,20 @@ static pj_status_t get_frame(pjmedia_port *this_port,
         //if (level == 0)
         //    continue;
 
+        /* In mix-minus mode, add the signal to the sum of all sources.
+         * Listeners hearing all sources will take it from there, so we
+         * are done with this port if it has no listener to be mixed
+         * individually and no connection level to correct.
+         */
+        if (mix_minus) {
+            conf->mk->accumulate(conf->mix_sum, p_in,
+                                 conf->samples_per_frame, NULL, NULL);
+            conf_port->rx_active = PJ_TRUE;
+
+            if (direct_cnt == 0 && conf_port->adj_listener_cnt == 0)
+                continue;
+        }
+
         /* Add the signal to all listeners. */
         for (cj=0; cj < conf_port->listener_cnt; ++cj) 
         {
@@ -2922,36 +3869,48 @@ static pj_status_t get_frame(pjmedia_port *this_port,
 
             listener = conf->ports[conf_port->listener_slots[cj]];
 
-            /* Skip if this listener doesn't want to receive audio */
-            if (listener->tx_setting != PJMEDIA_PORT_ENABLE)
+            /* Skip if this listener doesn't want to receive audio, or
+             * gets the encoded frame as is.
+             */
+            if (listener->tx_setting != PJMEDIA_PORT_ENABLE ||
+                listener->pt_src)
+            {
                 continue;
+            }
 
             mix_buf = listener->mix_buf;
 
-            /* apply connection level, if not normal */
-            if (conf_port->listener_adj_level[cj] != NORMAL_LEVEL) {
-                unsigned k = 0;
-                for (; k < conf->samples_per_frame; ++k) {
-                    /* For the level adjustment, we need to store the sample to
-                     * a temporary 32bit integer value to avoid overflowing the
-                     * 16bit sample storage.
-                     */
+            /* Mix-minus listener already gets the signal from the sum,
+             * only add the correction for connection level, if not normal.
+             */
+            if (listener->mix_minus) {
+                unsigned adj = conf_port->listener_adj_level[cj];
+                unsigned k;
+
+                if (adj == NORMAL_LEVEL)
+                    continue;
+
+                for (k=0; k < conf->samples_per_frame; ++k) {
                     pj_int32_t itemp;
 
                     itemp = p_in[k];
-                    /*itemp = itemp * adj / NORMAL_LEVEL;*/
-                    /* bad code (signed/unsigned badness):
-                     *  itemp = (itemp * conf_port->listsener_adj_level) >> 7;
-                     */
-                    itemp *= conf_port->listener_adj_level[cj];
+                    itemp *= adj;
                     itemp >>= 7;
 
                     /* Clip the signal if it's too loud */
                     if (itemp > MAX_LEVEL) itemp = MAX_LEVEL;
                     else if (itemp < MIN_LEVEL) itemp = MIN_LEVEL;
 
-                    conf_port->adj_level_buf[k] = (pj_int16_t)itemp;
+                    mix_buf[k] += itemp - p_in[k];
                 }
+                continue;
+            }
+
+            /* apply connection level, if not normal */
+            if (conf_port->listener_adj_level[cj] != NORMAL_LEVEL) {
+                conf->mk->apply_gain(conf_port->adj_level_buf, p_in,
+                                     conf_port->listener_adj_level[cj],
+                                     conf->samples_per_frame);
 
                 /* take the leveled frame */
                 p_in_conn_leveled = conf_port->adj_level_buf;
@@ -2965,17 +3924,12 @@ static pj_status_t get_frame(pjmedia_port *this_port,
                  * and calculate appropriate level adjustment if there is
                  * any overflowed level in the mixed signal.
                  */
-                unsigned k, samples_per_frame = conf->samples_per_frame;
                 pj_int32_t mix_buf_min = 0;
                 pj_int32_t mix_buf_max = 0;
 
-                for (k = 0; k < samples_per_frame; ++k) {
-                    mix_buf[k] += p_in_conn_leveled[k];
-                    if (mix_buf[k] < mix_buf_min)
-                        mix_buf_min = mix_buf[k];
-                    if (mix_buf[k] > mix_buf_max)
-                        mix_buf_max = mix_buf[k];
-                }
+                conf->mk->accumulate(mix_buf, p_in_conn_leveled,
+                                     conf->samples_per_frame,
+                                     &mix_buf_min, &mix_buf_max);
 
                 /* Check if normalization adjustment needed. */
                 if (mix_buf_min < MIN_LEVEL || mix_buf_max > MAX_LEVEL) {
@@ -3017,6 +3971,9 @@ static pj_status_t get_frame(pjmedia_port *this_port,
         /* Var "ci" is to count how many ports have been visited. */
         ++ci;
 
+        if (conf_port->mix_minus)
+            mix_minus_listener(conf, conf_port);
+
         status = write_port( conf, conf_port, &frame->timestamp,
                              &frm_type);
         if (status != PJ_SUCCESS) {
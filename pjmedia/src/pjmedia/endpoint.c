@@ -104,6 +104,9 @@ struct pjmedia_endpt
 
     /** List of exit callback. */
     exit_cb               exit_cb_list;
+
+    /** Pool of buffers for received packets. */
+    pjmedia_pkt_buf_pool *pkt_buf_pool;
 };
 
 
@@ -164,6 +167,13 @@ PJ_DEF(pj_status_t) pjmedia_endpt_create2(pj_pool_factory *pf,
     /* Initialize exit callback list. */
     pj_list_init(&endpt->exit_cb_list);
 
+    /* Create the packet buffer pool. */
+    status = pjmedia_pkt_buf_pool_create(endpt->pf, "med-pktbuf",
+                                         PJMEDIA_MAX_MRU, 0,
+                                         &endpt->pkt_buf_pool);
+    if (status != PJ_SUCCESS)
+        goto on_error;
+
     /* Create ioqueue if none is specified. */
     if (endpt->ioqueue == NULL) {
         
@@ -205,6 +215,9 @@ on_error:
     if (endpt->ioqueue && endpt->own_ioqueue)
         pj_ioqueue_destroy(endpt->ioqueue);
 
+    if (endpt->pkt_buf_pool)
+        pjmedia_pkt_buf_pool_destroy(endpt->pkt_buf_pool);
+
     pjmedia_codec_mgr_destroy(&endpt->codec_mgr);
     //pjmedia_aud_subsys_shutdown();
     pj_pool_release(pool);
@@ -236,6 +249,12 @@ PJ_DEF(pj_status_t) pjmedia_endpt_destroy2 (pjmedia_endpt *endpt)
 
     endpt->pf = NULL;
 
+    /* Buffers still held by media transports keep the pool alive. */
+    if (endpt->pkt_buf_pool) {
+        pjmedia_pkt_buf_pool_destroy(endpt->pkt_buf_pool);
+        endpt->pkt_buf_pool = NULL;
+    }
+
     pjmedia_codec_mgr_destroy(&endpt->codec_mgr);
     //pjmedia_aud_subsys_shutdown();
 
@@ -294,6 +313,16 @@ PJ_DEF(pj_ioqueue_t*) pjmedia_endpt_get_ioqueue(pjmedia_endpt *endpt)
     return endpt->ioqueue;
 }
 
+/**
+ * Get the packet buffer pool of the media endpoint.
+ */
+PJ_DEF(pjmedia_pkt_buf_pool*) pjmedia_endpt_get_pkt_buf_pool(
+                                                    pjmedia_endpt *endpt)
+{
+    PJ_ASSERT_RETURN(endpt, NULL);
+    return endpt->pkt_buf_pool;
+}
+
 /**
  * Get the number of worker threads in media endpoint.
  */
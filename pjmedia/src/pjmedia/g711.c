@@ -527,22 +527,11 @@ static pj_status_t  g711_encode(pjmedia_codec *codec,
 
     /* Encode */
     if (priv->pt == PJMEDIA_RTP_PT_PCMA) {
-        unsigned i, n;
-        pj_uint8_t *dst = (pj_uint8_t*) output->buf;
-
-        n = ((unsigned)input->size >> 1);
-        for (i=0; i!=n; ++i, ++dst) {
-            *dst = pjmedia_linear2alaw(samples[i]);
-        }
+        pjmedia_alaw_encode((pj_uint8_t*)output->buf, samples,
+                            input->size >> 1);
     } else if (priv->pt == PJMEDIA_RTP_PT_PCMU) {
-        unsigned i, n;
-        pj_uint8_t *dst = (pj_uint8_t*) output->buf;
-
-        n = ((unsigned)input->size >> 1);
-        for (i=0; i!=n; ++i, ++dst) {
-            *dst = pjmedia_linear2ulaw(samples[i]);
-        }
-
+        pjmedia_ulaw_encode((pj_uint8_t*)output->buf, samples,
+                            input->size >> 1);
     } else {
         return PJMEDIA_EINVALIDPT;
     }
@@ -571,22 +560,11 @@ static pj_status_t  g711_decode(pjmedia_codec *codec,
 
     /* Decode */
     if (priv->pt == PJMEDIA_RTP_PT_PCMA) {
-        unsigned i;
-        pj_uint8_t *src = (pj_uint8_t*) input->buf;
-        pj_uint16_t *dst = (pj_uint16_t*) output->buf;
-
-        for (i=0; i!=input->size; ++i) {
-            *dst++ = (pj_uint16_t) pjmedia_alaw2linear(*src++);
-        }
+        pjmedia_alaw_decode((pj_int16_t*)output->buf,
+                            (const pj_uint8_t*)input->buf, input->size);
     } else if (priv->pt == PJMEDIA_RTP_PT_PCMU) {
-        unsigned i;
-        pj_uint8_t *src = (pj_uint8_t*) input->buf;
-        pj_uint16_t *dst = (pj_uint16_t*) output->buf;
-
-        for (i=0; i!=input->size; ++i) {
-            *dst++ = (pj_uint16_t) pjmedia_ulaw2linear(*src++);
-        }
-
+        pjmedia_ulaw_decode((pj_int16_t*)output->buf,
+                            (const pj_uint8_t*)input->buf, input->size);
     } else {
         return PJMEDIA_EINVALIDPT;
     }
@@ -59,6 +59,24 @@
 #define STA_DISC_SAFE_SHRINKING_DIFF    1
 
 
+/* Number of recent frames used as the arrival reference in histogram
+ * algorithm, i.e: the relative delay of a frame is measured against the
+ * earliest arrival among these frames.
+ */
+#define HIST_WINDOW             100
+
+/* Forgetting factor of the delay histogram, in Q15 (0.9993). */
+#define HIST_FORGET_FACTOR      32745
+
+/* Weight of a new sample in the delay histogram, in Q30. */
+#define HIST_SAMPLE_WEIGHT      ((32768 - HIST_FORGET_FACTOR) << 15)
+
+/* In histogram algorithm, frames are only discarded when the JB size
+ * exceeds twice the target level plus this value, in frames.
+ */
+#define HIST_DISC_MARGIN        2
+
+
 /* Struct of JB internal buffer, represented in a circular buffer containing
  * frame content, frame type, frame length, and frame bit info.
  */
@@ -74,6 +92,9 @@ typedef struct jb_framelist_t
     pj_size_t       *content_len;       /**< frame length array             */
     pj_uint32_t     *bit_info;          /**< frame bit info array           */
     pj_uint32_t     *ts;                /**< timestamp array                */
+    pjmedia_pkt_buf **pkt_buf;          /**< packet buffer array, for frames
+                                             stored by reference            */
+    const char     **ref;               /**< frame stored by reference      */
 
     /* States */
     unsigned         head;              /**< index of head, pointed frame
@@ -90,6 +111,7 @@ typedef struct jb_framelist_t
 typedef void (*discard_algo)(pjmedia_jbuf *jb);
 static void jbuf_discard_static(pjmedia_jbuf *jb);
 static void jbuf_discard_progressive(pjmedia_jbuf *jb);
+static void jbuf_discard_histogram(pjmedia_jbuf *jb);
 
 
 struct pjmedia_jbuf
@@ -144,12 +166,30 @@ struct pjmedia_jbuf
     unsigned        jb_discard_dist;    /**< Distance from jb_discard_ref
                                              to perform discard (in frm)    */
 
+    /* Histogram algorithm */
+    pj_bool_t       jb_hist_mode;       /**< Histogram algorithm is used.   */
+    unsigned        jb_late_loss;       /**< Target late loss, in 1/1000    */
+    pj_uint32_t    *jb_hist;            /**< Relative arrival delay
+                                             histogram, in Q30              */
+    unsigned        jb_hist_size;       /**< Number of histogram buckets    */
+    int             jb_hist_win[HIST_WINDOW];
+                                        /**< Recent arrival offsets         */
+    unsigned        jb_hist_win_pos;    /**< Next position in the window    */
+    unsigned        jb_hist_win_cnt;    /**< Number of offsets in window    */
+    int             jb_tick;            /**< Playback clock, in frames      */
+    int             jb_target;          /**< Target level, in frames        */
+    int             jb_filt_level;      /**< Filtered level on GET, in Q8   */
+    int             jb_filt_target;     /**< Target of jb_filt_level, in Q8 */
+    pjmedia_jb_stretch jb_stretch;      /**< Requested time-stretching      */
+
     /* Statistics */
     pj_math_stat    jb_delay;           /**< Delay statistics of jitter buffer
                                              (in ms)                        */
     pj_math_stat    jb_burst;           /**< Burst statistics (in frames)   */
     unsigned        jb_lost;            /**< Number of lost frames.         */
     unsigned        jb_discard;         /**< Number of discarded frames.    */
+    unsigned        jb_late;            /**< Number of frames arrived too
+                                             late, also counted as discarded*/
     unsigned        jb_empty;           /**< Number of empty/prefetching frame
                                              returned by GET. */
 };
@@ -186,6 +226,24 @@ static pj_status_t jb_framelist_reset(jb_framelist_t *framelist);
 static unsigned jb_framelist_remove_head(jb_framelist_t *framelist,
                                          unsigned count);
 
+/* Release the packet buffer referenced by a slot, if any */
+PJ_INLINE(void) jb_framelist_release(jb_framelist_t *framelist, unsigned pos)
+{
+    if (framelist->pkt_buf[pos]) {
+        pjmedia_pkt_buf_dec_ref(framelist->pkt_buf[pos]);
+        framelist->pkt_buf[pos] = NULL;
+        framelist->ref[pos] = NULL;
+    }
+}
+
+/* Get the content of a slot */
+PJ_INLINE(const char*) jb_framelist_content(const jb_framelist_t *framelist,
+                                            unsigned pos)
+{
+    return framelist->pkt_buf[pos]? framelist->ref[pos] :
+           framelist->content + pos * framelist->frame_size;
+}
+
 static pj_status_t jb_framelist_init( pj_pool_t *pool,
                                       jb_framelist_t *framelist,
                                       unsigned frame_size,
@@ -217,6 +275,14 @@ static pj_status_t jb_framelist_init( pj_pool_t *pool,
                               pj_pool_alloc(pool,
                                             sizeof(framelist->ts[0])*
                                             framelist->max_count);
+    framelist->pkt_buf      = (pjmedia_pkt_buf**)
+                              pj_pool_zalloc(pool,
+                                             sizeof(framelist->pkt_buf[0])*
+                                             framelist->max_count);
+    framelist->ref          = (const char**)
+                              pj_pool_zalloc(pool,
+                                             sizeof(framelist->ref[0])*
+                                             framelist->max_count);
 
     return jb_framelist_reset(framelist);
 
@@ -224,12 +290,21 @@ static pj_status_t jb_framelist_init( pj_pool_t *pool,
 
 static pj_status_t jb_framelist_destroy(jb_framelist_t *framelist)
 {
-    PJ_UNUSED_ARG(framelist);
+    unsigned i;
+
+    for (i = 0; i < framelist->max_count; ++i)
+        jb_framelist_release(framelist, i);
+
     return PJ_SUCCESS;
 }
 
 static pj_status_t jb_framelist_reset(jb_framelist_t *framelist)
 {
+    unsigned i;
+
+    for (i = 0; i < framelist->max_count; ++i)
+        jb_framelist_release(framelist, i);
+
     framelist->head = 0;
     framelist->origin = INVALID_OFFSET;
     framelist->size = 0;
@@ -316,8 +391,7 @@ static pj_bool_t jb_framelist_get(jb_framelist_t *framelist,
                 }
 
                 pj_memcpy(frame,
-                          framelist->content +
-                          framelist->head * framelist->frame_size,
+                          jb_framelist_content(framelist, framelist->head),
                           copy_size);
                 *p_type = (pjmedia_jb_frame_type)
                           framelist->frame_type[framelist->head];
@@ -334,6 +408,7 @@ static pj_bool_t jb_framelist_get(jb_framelist_t *framelist,
             //pj_bzero(framelist->content +
             //   framelist->head * framelist->frame_size,
             //   framelist->frame_size);
+            jb_framelist_release(framelist, framelist->head);
             framelist->frame_type[framelist->head] = PJMEDIA_JB_MISSING_FRAME;
             framelist->content_len[framelist->head] = 0;
             framelist->bit_info[framelist->head] = 0;
@@ -384,7 +459,7 @@ static pj_bool_t jb_framelist_peek(jb_framelist_t *framelist,
 
     /* Return the frame pointer */
     if (frame)
-        *frame = framelist->content + pos*framelist->frame_size;
+        *frame = jb_framelist_content(framelist, pos);
     if (type)
         *type = (pjmedia_jb_frame_type)
                 framelist->frame_type[pos];
@@ -427,6 +502,7 @@ static unsigned jb_framelist_remove_head(jb_framelist_t *framelist,
                 pj_assert(framelist->discarded_num > 0);
                 framelist->discarded_num--;
             }
+            jb_framelist_release(framelist, i);
         }
 
         //pj_bzero(framelist->content +
@@ -444,6 +520,7 @@ static unsigned jb_framelist_remove_head(jb_framelist_t *framelist,
                     pj_assert(framelist->discarded_num > 0);
                     framelist->discarded_num--;
                 }
+                jb_framelist_release(framelist, i);
             }
             //pj_bzero( framelist->content,
             //        step2*framelist->frame_size);
@@ -468,6 +545,7 @@ static pj_status_t jb_framelist_put_at(jb_framelist_t *framelist,
                                        int index,
                                        const void *frame,
                                        unsigned frame_size,
+                                       pjmedia_pkt_buf *pkt_buf,
                                        pj_uint32_t bit_info,
                                        pj_uint32_t ts,
                                        unsigned frame_type)
@@ -552,10 +630,17 @@ static pj_status_t jb_framelist_put_at(jb_framelist_t *framelist,
     if (framelist->origin + (int)framelist->size <= index)
         framelist->size = distance + 1;
 
-    if(PJMEDIA_JB_NORMAL_FRAME == frame_type) {
-        /* copy frame content */
-        pj_memcpy(framelist->content + pos * framelist->frame_size,
-                  frame, frame_size);
+    if (PJMEDIA_JB_NORMAL_FRAME == frame_type) {
+        if (pkt_buf) {
+            /* keep a reference to the frame content */
+            pjmedia_pkt_buf_add_ref(pkt_buf);
+            framelist->pkt_buf[pos] = pkt_buf;
+            framelist->ref[pos] = (const char*)frame;
+        } else {
+            /* copy frame content */
+            pj_memcpy(framelist->content + pos * framelist->frame_size,
+                      frame, frame_size);
+        }
     }
 
     return PJ_SUCCESS;
@@ -576,6 +661,7 @@ static pj_status_t jb_framelist_discard(jb_framelist_t *framelist,
           framelist->max_count;
 
     /* Discard the frame */
+    jb_framelist_release(framelist, pos);
     framelist->frame_type[pos] = PJMEDIA_JB_DISCARDED_FRAME;
     framelist->discarded_num++;
 
@@ -617,6 +703,10 @@ PJ_DEF(pj_status_t) pjmedia_jbuf_create(pj_pool_t *pool,
     jb->jb_max_count     = max_count;
     jb->jb_min_shrink_gap= PJMEDIA_JBUF_DISC_MIN_GAP / ptime;
     jb->jb_max_burst     = PJ_MAX(MAX_BURST_MSEC / ptime, max_count*3/4);
+    jb->jb_late_loss     = PJMEDIA_JBUF_HIST_LATE_LOSS;
+    jb->jb_hist_size     = max_count;
+    jb->jb_hist          = (pj_uint32_t*)
+                           pj_pool_calloc(pool, max_count, sizeof(pj_uint32_t));
 
     pj_math_stat_init(&jb->jb_delay);
     pj_math_stat_init(&jb->jb_burst);
@@ -697,9 +787,14 @@ PJ_DEF(pj_status_t) pjmedia_jbuf_set_discard( pjmedia_jbuf *jb,
 {
     PJ_ASSERT_RETURN(jb, PJ_EINVAL);
     PJ_ASSERT_RETURN(algo >= PJMEDIA_JB_DISCARD_NONE &&
-                     algo <= PJMEDIA_JB_DISCARD_PROGRESSIVE,
+                     algo <= PJMEDIA_JB_DISCARD_HISTOGRAM,
                      PJ_EINVAL);
 
+    jb->jb_hist_mode = (algo == PJMEDIA_JB_DISCARD_HISTOGRAM);
+    jb->jb_target = PJ_MAX(jb->jb_prefetch, 1);
+    jb->jb_filt_target = jb->jb_target << 8;
+    jb->jb_stretch = PJMEDIA_JB_STRETCH_NONE;
+
     switch(algo) {
     case PJMEDIA_JB_DISCARD_PROGRESSIVE:
         jb->jb_discard_algo = &jbuf_discard_progressive;
@@ -707,6 +802,9 @@ PJ_DEF(pj_status_t) pjmedia_jbuf_set_discard( pjmedia_jbuf *jb,
     case PJMEDIA_JB_DISCARD_STATIC:
         jb->jb_discard_algo = &jbuf_discard_static;
         break;
+    case PJMEDIA_JB_DISCARD_HISTOGRAM:
+        jb->jb_discard_algo = &jbuf_discard_histogram;
+        break;
     default:
         jb->jb_discard_algo = NULL;
         break;
@@ -716,6 +814,17 @@ PJ_DEF(pj_status_t) pjmedia_jbuf_set_discard( pjmedia_jbuf *jb,
 }
 
 
+PJ_DEF(pj_status_t) pjmedia_jbuf_set_late_loss(pjmedia_jbuf *jb,
+                                               unsigned late_loss)
+{
+    PJ_ASSERT_RETURN(jb && late_loss < 1000, PJ_EINVAL);
+
+    jb->jb_late_loss = late_loss;
+
+    return PJ_SUCCESS;
+}
+
+
 PJ_DEF(pj_status_t) pjmedia_jbuf_reset(pjmedia_jbuf *jb)
 {
     jb->jb_level         = 0;
@@ -726,6 +835,13 @@ PJ_DEF(pj_status_t) pjmedia_jbuf_reset(pjmedia_jbuf *jb)
     jb->jb_max_hist_level= 0;
     jb->jb_prefetching   = (jb->jb_prefetch != 0);
     jb->jb_discard_dist  = 0;
+    jb->jb_hist_win_pos  = 0;
+    jb->jb_hist_win_cnt  = 0;
+    jb->jb_target        = PJ_MAX(jb->jb_prefetch, 1);
+    jb->jb_filt_level    = 0;
+    jb->jb_filt_target   = jb->jb_target << 8;
+    jb->jb_stretch       = PJMEDIA_JB_STRETCH_NONE;
+    pj_bzero(jb->jb_hist, jb->jb_hist_size * sizeof(pj_uint32_t));
 
     jb_framelist_reset(&jb->jb_framelist);
 
@@ -742,7 +858,7 @@ PJ_DEF(pj_status_t) pjmedia_jbuf_destroy(pjmedia_jbuf *jb)
                "  size=%d/eff=%d prefetch=%d level=%d\n"
                "  delay (min/max/avg/dev)=%d/%d/%d/%d ms\n"
                "  burst (min/max/avg/dev)=%d/%d/%d/%d frames\n"
-               "  lost=%d discard=%d empty=%d",
+               "  lost=%d discard=%d late=%d empty=%d",
                jb_framelist_size(&jb->jb_framelist),
                jb_framelist_eff_size(&jb->jb_framelist),
                jb->jb_prefetch, jb->jb_eff_level,
@@ -750,7 +866,7 @@ PJ_DEF(pj_status_t) pjmedia_jbuf_destroy(pjmedia_jbuf *jb)
                pj_math_stat_get_stddev(&jb->jb_delay),
                jb->jb_burst.min, jb->jb_burst.max, jb->jb_burst.mean,
                pj_math_stat_get_stddev(&jb->jb_burst),
-               jb->jb_lost, jb->jb_discard, jb->jb_empty));
+               jb->jb_lost, jb->jb_discard, jb->jb_late, jb->jb_empty));
 
     return jb_framelist_destroy(&jb->jb_framelist);
 }
@@ -975,6 +1091,144 @@ static void jbuf_discard_progressive(pjmedia_jbuf *jb)
 }
 
 
+static void jbuf_discard_histogram(pjmedia_jbuf *jb)
+{
+    /* The latency is normally adjusted by the application using
+     * time-stretching, see jbuf_hist_stretch(). Only discard frames when
+     * the latency has grown far beyond the target, e.g: the application
+     * ignores the time-stretching request.
+     */
+    if ((int)jb_framelist_eff_size(&jb->jb_framelist) >
+        jb->jb_target * 2 + HIST_DISC_MARGIN)
+    {
+        jbuf_discard_progressive(jb);
+    } else {
+        jb->jb_discard_dist = 0;
+    }
+}
+
+
+/* Update the relative arrival delay histogram with a newly arrived frame,
+ * then recalculate the target level so that only jb_late_loss of frames
+ * would arrive after their playback time.
+ */
+static void jbuf_hist_update(pjmedia_jbuf *jb, int frame_seq)
+{
+    pj_uint64_t total, sum, limit, moment;
+    int offset, min_offset, target, filt_target, mean, lo;
+    unsigned i, delay;
+
+    /* Arrival offset, i.e: playback clock relative to the frame sequence,
+     * it grows by the delay experienced by the frame.
+     */
+    offset = jb->jb_tick - frame_seq;
+
+    /* Restart the reference window on sequence restart or jump */
+    if (jb->jb_hist_win_cnt) {
+        int last, diff;
+
+        last = jb->jb_hist_win[(jb->jb_hist_win_pos + HIST_WINDOW - 1) %
+                               HIST_WINDOW];
+        diff = offset - last;
+        if (diff > (int)jb->jb_max_count || -diff > (int)jb->jb_max_count) {
+            jb->jb_hist_win_pos = 0;
+            jb->jb_hist_win_cnt = 0;
+        }
+    }
+
+    jb->jb_hist_win[jb->jb_hist_win_pos] = offset;
+    jb->jb_hist_win_pos = (jb->jb_hist_win_pos + 1) % HIST_WINDOW;
+    if (jb->jb_hist_win_cnt < HIST_WINDOW)
+        ++jb->jb_hist_win_cnt;
+
+    /* Delay relative to the earliest recent arrival */
+    min_offset = offset;
+    for (i = 0; i < jb->jb_hist_win_cnt; ++i) {
+        if (jb->jb_hist_win[i] < min_offset)
+            min_offset = jb->jb_hist_win[i];
+    }
+    delay = (unsigned)(offset - min_offset);
+    if (delay >= jb->jb_hist_size)
+        delay = jb->jb_hist_size - 1;
+
+    /* Age the histogram and add the new sample */
+    total = moment = 0;
+    for (i = 0; i < jb->jb_hist_size; ++i) {
+        jb->jb_hist[i] = (pj_uint32_t)(((pj_uint64_t)jb->jb_hist[i] *
+                                        HIST_FORGET_FACTOR) >> 15);
+        total += jb->jb_hist[i];
+        moment += (pj_uint64_t)jb->jb_hist[i] * i;
+    }
+    jb->jb_hist[delay] += HIST_SAMPLE_WEIGHT;
+    total += HIST_SAMPLE_WEIGHT;
+    moment += (pj_uint64_t)HIST_SAMPLE_WEIGHT * delay;
+
+    /* Find the lowest delay that covers all but jb_late_loss of frames */
+    limit = total * (1000 - jb->jb_late_loss) / 1000;
+    sum = 0;
+    for (i = 0; i < jb->jb_hist_size - 1; ++i) {
+        sum += jb->jb_hist[i];
+        if (sum >= limit)
+            break;
+    }
+
+    /* A frame with zero relative delay still needs one frame in the
+     * buffer on GET. The level seen by playback drops to this only when
+     * the most delayed frames are due, on average it is higher by the mean
+     * delay, so the time-stretching follows the target minus the mean
+     * delay (in Q8).
+     */
+    target = (int)i + 1;
+    mean = (int)((moment << 8) / total);
+    filt_target = (target << 8) - mean;
+
+    if (target < jb->jb_min_prefetch)
+        target = jb->jb_min_prefetch;
+    if (target < (int)jb->jb_min_delay)
+        target = jb->jb_min_delay;
+    if (target > jb->jb_max_prefetch)
+        target = jb->jb_max_prefetch;
+    if (target < 1)
+        target = 1;
+
+    lo = PJ_MAX(jb->jb_min_prefetch, (int)jb->jb_min_delay);
+    filt_target = PJ_MAX(filt_target, lo << 8);
+    filt_target = PJ_MIN(filt_target, jb->jb_max_prefetch << 8);
+    filt_target = PJ_MAX(filt_target, 256);
+
+    if (target != jb->jb_target) {
+        TRACE__((jb->jb_name.ptr, "jb target %d -> %d, size=%d",
+                 jb->jb_target, target,
+                 jb_framelist_eff_size(&jb->jb_framelist)));
+    }
+
+    jb->jb_target = target;
+    jb->jb_filt_target = filt_target;
+    jb->jb_eff_level = target;
+    if (jb->jb_init_prefetch)
+        jb->jb_prefetch = target;
+}
+
+
+/* Decide the time-stretching from the filtered level on GET */
+static void jbuf_hist_stretch(pjmedia_jbuf *jb)
+{
+    int target = jb->jb_filt_target;
+
+    if (jb->jb_prefetching) {
+        jb->jb_stretch = PJMEDIA_JB_STRETCH_NONE;
+    } else if (jb->jb_filt_level >= target + 256 &&
+               jb_framelist_eff_size(&jb->jb_framelist) >= 2)
+    {
+        jb->jb_stretch = PJMEDIA_JB_STRETCH_COMPRESS;
+    } else if (jb->jb_filt_level + 128 < target) {
+        jb->jb_stretch = PJMEDIA_JB_STRETCH_EXPAND;
+    } else {
+        jb->jb_stretch = PJMEDIA_JB_STRETCH_NONE;
+    }
+}
+
+
 PJ_INLINE(void) jbuf_update(pjmedia_jbuf *jb, int oper)
 {
     if(jb->jb_last_op != oper) {
@@ -1004,8 +1258,13 @@ PJ_INLINE(void) jbuf_update(pjmedia_jbuf *jb, int oper)
          * the GET op may be idle, in this case, we better skip the jitter
          * calculation.
          */
-        if (oper == JB_OP_GET && jb->jb_level <= jb->jb_max_burst)
-            jbuf_calculate_jitter(jb);
+        if (oper == JB_OP_GET && jb->jb_level <= jb->jb_max_burst) {
+            /* Histogram algorithm maintains its own target level */
+            if (jb->jb_hist_mode)
+                pj_math_stat_update(&jb->jb_burst, jb->jb_level);
+            else
+                jbuf_calculate_jitter(jb);
+        }
 
         jb->jb_level = 0;
     }
@@ -1035,13 +1294,14 @@ PJ_DEF(void) pjmedia_jbuf_put_frame2(pjmedia_jbuf *jb,
                             discarded);
 }
 
-PJ_DEF(void) pjmedia_jbuf_put_frame3(pjmedia_jbuf *jb,
-                                     const void *frame,
-                                     pj_size_t frame_size,
-                                     pj_uint32_t bit_info,
-                                     int frame_seq,
-                                     pj_uint32_t ts,
-                                     pj_bool_t *discarded)
+static void jbuf_put_frame(pjmedia_jbuf *jb,
+                           pjmedia_pkt_buf *pkt_buf,
+                           const void *frame,
+                           pj_size_t frame_size,
+                           pj_uint32_t bit_info,
+                           int frame_seq,
+                           pj_uint32_t ts,
+                           pj_bool_t *discarded)
 {
     pj_size_t min_frame_size;
     int new_size, cur_size;
@@ -1058,8 +1318,8 @@ PJ_DEF(void) pjmedia_jbuf_put_frame3(pjmedia_jbuf *jb,
     /* Attempt to store the frame */
     min_frame_size = PJ_MIN(frame_size, jb->jb_frame_size);
     status = jb_framelist_put_at(&jb->jb_framelist, frame_seq, frame,
-                                 (unsigned)min_frame_size, bit_info, ts,
-                                 PJMEDIA_JB_NORMAL_FRAME);
+                                 (unsigned)min_frame_size, pkt_buf,
+                                 bit_info, ts, PJMEDIA_JB_NORMAL_FRAME);
 
     /* Jitter buffer is full, remove some older frames */
     while (status == PJ_ETOOMANY) {
@@ -1077,12 +1337,16 @@ PJ_DEF(void) pjmedia_jbuf_put_frame3(pjmedia_jbuf *jb,
 
         removed = jb_framelist_remove_head(&jb->jb_framelist, distance);
         status = jb_framelist_put_at(&jb->jb_framelist, frame_seq, frame,
-                                     (unsigned)min_frame_size, bit_info, ts,
-                                     PJMEDIA_JB_NORMAL_FRAME);
+                                     (unsigned)min_frame_size, pkt_buf,
+                                     bit_info, ts, PJMEDIA_JB_NORMAL_FRAME);
 
         jb->jb_discard += removed;
     }
 
+    /* Late frames are counted too, they are what the histogram is for */
+    if (jb->jb_hist_mode && status != PJ_EEXISTS)
+        jbuf_hist_update(jb, frame_seq);
+
     /* Get new JB size after PUT */
     new_size = jb_framelist_eff_size(&jb->jb_framelist);
 
@@ -1099,8 +1363,40 @@ PJ_DEF(void) pjmedia_jbuf_put_frame3(pjmedia_jbuf *jb,
         }
         jb->jb_level += (new_size > cur_size ? new_size-cur_size : 1);
         jbuf_update(jb, JB_OP_PUT);
-    } else
+    } else {
+        if (status == PJ_ETOOSMALL)
+            jb->jb_late++;
         jb->jb_discard++;
+    }
+}
+
+PJ_DEF(void) pjmedia_jbuf_put_frame3(pjmedia_jbuf *jb,
+                                     const void *frame,
+                                     pj_size_t frame_size,
+                                     pj_uint32_t bit_info,
+                                     int frame_seq,
+                                     pj_uint32_t ts,
+                                     pj_bool_t *discarded)
+{
+    jbuf_put_frame(jb, NULL, frame, frame_size, bit_info, frame_seq, ts,
+                   discarded);
+}
+
+PJ_DEF(void) pjmedia_jbuf_put_frame_ref(pjmedia_jbuf *jb,
+                                        pjmedia_pkt_buf *pkt_buf,
+                                        const void *frame,
+                                        pj_size_t frame_size,
+                                        pj_uint32_t bit_info,
+                                        int frame_seq,
+                                        pj_uint32_t ts,
+                                        pj_bool_t *discarded)
+{
+    PJ_ASSERT_ON_FAIL(!pkt_buf ||
+                      pjmedia_pkt_buf_contains(pkt_buf, frame, frame_size),
+                      pkt_buf = NULL);
+
+    jbuf_put_frame(jb, pkt_buf, frame, frame_size, bit_info, frame_seq, ts,
+                   discarded);
 }
 
 /*
@@ -1138,6 +1434,13 @@ PJ_DEF(void) pjmedia_jbuf_get_frame3(pjmedia_jbuf *jb,
                                      pj_uint32_t *ts,
                                      int *seq)
 {
+    /* Advance the playback clock and track the level seen by playback */
+    ++jb->jb_tick;
+    if (jb->jb_hist_mode) {
+        int cur_size = jb_framelist_eff_size(&jb->jb_framelist);
+        jb->jb_filt_level = (jb->jb_filt_level * 15 + (cur_size << 8)) >> 4;
+    }
+
     if (jb->jb_prefetching) {
 
         /* Can't return frame because jitter buffer is filling up
@@ -1203,6 +1506,42 @@ PJ_DEF(void) pjmedia_jbuf_get_frame3(pjmedia_jbuf *jb,
 
     jb->jb_level++;
     jbuf_update(jb, JB_OP_GET);
+
+    if (jb->jb_hist_mode)
+        jbuf_hist_stretch(jb);
+}
+
+
+/*
+ * Get the requested time-stretching.
+ */
+PJ_DEF(pjmedia_jb_stretch) pjmedia_jbuf_get_stretch(const pjmedia_jbuf *jb)
+{
+    PJ_ASSERT_RETURN(jb, PJMEDIA_JB_STRETCH_NONE);
+
+    return jb->jb_stretch;
+}
+
+
+/*
+ * Report time-stretching performed by application.
+ */
+PJ_DEF(void) pjmedia_jbuf_report_stretch(pjmedia_jbuf *jb, int frames)
+{
+    PJ_ASSERT_ON_FAIL(jb, return);
+
+    jb->jb_tick += frames;
+
+    if (jb->jb_hist_mode) {
+        /* Reflect the stretching on the filtered level immediately,
+         * otherwise the same request would be repeated until the filter
+         * catches up.
+         */
+        jb->jb_filt_level += frames * 256;
+        if (jb->jb_filt_level < 0)
+            jb->jb_filt_level = 0;
+        jbuf_hist_stretch(jb);
+    }
 }
 
 /*
@@ -1231,6 +1570,7 @@ PJ_DEF(pj_status_t) pjmedia_jbuf_get_state( const pjmedia_jbuf *jb,
     state->avg_burst = jb->jb_burst.mean;
     state->empty = jb->jb_empty;
     state->discard = jb->jb_discard;
+    state->late = jb->jb_late;
     state->lost = jb->jb_lost;
 
     return PJ_SUCCESS;
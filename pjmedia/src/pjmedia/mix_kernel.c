@@ -0,0 +1,742 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <pjmedia/mix_kernel.h>
+
+
+#if defined(PJMEDIA_MIX_KERNEL_USE_SIMD) && PJMEDIA_MIX_KERNEL_USE_SIMD!=0
+#   if defined(__x86_64__) || defined(__i386__)
+#       define HAS_X86_KERNEL   1
+#       include <immintrin.h>
+#   elif defined(__aarch64__) || defined(__ARM_NEON)
+#       define HAS_NEON_KERNEL  1
+#       include <arm_neon.h>
+#   endif
+#endif
+
+#ifndef HAS_X86_KERNEL
+#   define HAS_X86_KERNEL       0
+#endif
+#ifndef HAS_NEON_KERNEL
+#   define HAS_NEON_KERNEL      0
+#endif
+
+#define MAX_LEVEL   (32767)
+#define MIN_LEVEL   (-32768)
+
+/* Clip 32-bit value to 16-bit sample */
+#define CLIP(x)     ((x) > MAX_LEVEL ? MAX_LEVEL : \
+                     ((x) < MIN_LEVEL ? MIN_LEVEL : (x)))
+
+
+/*
+ * Scalar implementation. This is also used by the SIMD implementations to
+ * process the remaining samples.
+ */
+static pj_uint32_t sum_abs_scalar(const pj_int16_t *src, unsigned count)
+{
+    pj_uint32_t sum = 0;
+    unsigned i;
+
+    for (i=0; i<count; ++i)
+        sum += (src[i] >= 0 ? src[i] : -src[i]);
+
+    return sum;
+}
+
+static pj_uint32_t apply_gain_scalar(pj_int16_t *dst, const pj_int16_t *src,
+                                     unsigned gain, unsigned count)
+{
+    pj_uint32_t sum = 0;
+    unsigned i;
+
+    for (i=0; i<count; ++i) {
+        pj_int32_t itemp = src[i] * (pj_int32_t)gain;
+
+        itemp >>= 7;
+        itemp = CLIP(itemp);
+        dst[i] = (pj_int16_t)itemp;
+        sum += (itemp >= 0 ? itemp : -itemp);
+    }
+
+    return sum;
+}
+
+static void accumulate_scalar(pj_int32_t *dst, const pj_int16_t *src,
+                              unsigned count, pj_int32_t *p_min,
+                              pj_int32_t *p_max)
+{
+    unsigned i;
+
+    if (p_min) {
+        pj_int32_t min = *p_min, max = *p_max;
+
+        for (i=0; i<count; ++i) {
+            dst[i] += src[i];
+            if (dst[i] < min) min = dst[i];
+            if (dst[i] > max) max = dst[i];
+        }
+        *p_min = min;
+        *p_max = max;
+    } else {
+        for (i=0; i<count; ++i)
+            dst[i] += src[i];
+    }
+}
+
+static void accumulate32_scalar(pj_int32_t *dst, const pj_int32_t *src,
+                                const pj_int16_t *sub, unsigned count,
+                                pj_int32_t *p_min, pj_int32_t *p_max)
+{
+    unsigned i;
+
+    if (sub) {
+        for (i=0; i<count; ++i)
+            dst[i] += src[i] - sub[i];
+    } else {
+        for (i=0; i<count; ++i)
+            dst[i] += src[i];
+    }
+
+    if (p_min) {
+        pj_int32_t min = *p_min, max = *p_max;
+
+        for (i=0; i<count; ++i) {
+            if (dst[i] < min) min = dst[i];
+            if (dst[i] > max) max = dst[i];
+        }
+        *p_min = min;
+        *p_max = max;
+    }
+}
+
+static pj_uint32_t clamp_scalar(pj_int16_t *dst, const pj_int32_t *src,
+                                unsigned gain, unsigned count)
+{
+    pj_uint32_t sum = 0;
+    unsigned i;
+
+    for (i=0; i<count; ++i) {
+        pj_int32_t itemp = src[i];
+
+        if (gain != 128)
+            itemp = (pj_int32_t)((pj_uint32_t)itemp * gain) >> 7;
+        itemp = CLIP(itemp);
+        dst[i] = (pj_int16_t)itemp;
+        sum += (itemp >= 0 ? itemp : -itemp);
+    }
+
+    return sum;
+}
+
+static const pjmedia_mix_kernel scalar_kernel =
+{
+    PJMEDIA_MIX_KERNEL_SCALAR,
+    "scalar",
+    &sum_abs_scalar,
+    &apply_gain_scalar,
+    &accumulate_scalar,
+    &accumulate32_scalar,
+    &clamp_scalar
+};
+
+
+#if HAS_X86_KERNEL
+/*
+ * SSE2 implementation, 8 samples per iteration.
+ *
+ * Absolute values of 16-bit samples are handled as unsigned 16-bit, so
+ * that -32768 gives 32768 as in the scalar implementation.
+ */
+
+/* Sum of the absolute values of v as four 32-bit partial sums. */
+__attribute__((target("sse2")))
+static inline __m128i abs_sum_sse2(__m128i v)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sign = _mm_srai_epi16(v, 15);
+    __m128i a = _mm_sub_epi16(_mm_xor_si128(v, sign), sign);
+
+    return _mm_add_epi32(_mm_unpacklo_epi16(a, zero),
+                         _mm_unpackhi_epi16(a, zero));
+}
+
+__attribute__((target("sse2")))
+static inline pj_uint32_t hsum_sse2(__m128i v)
+{
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1,0,3,2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2,3,0,1)));
+    return (pj_uint32_t)_mm_cvtsi128_si32(v);
+}
+
+/* SSE2 has no 32-bit min/max nor 32-bit multiplication. */
+__attribute__((target("sse2")))
+static inline __m128i min32_sse2(__m128i a, __m128i b)
+{
+    __m128i gt = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(gt, b), _mm_andnot_si128(gt, a));
+}
+
+__attribute__((target("sse2")))
+static inline __m128i max32_sse2(__m128i a, __m128i b)
+{
+    __m128i gt = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(gt, a), _mm_andnot_si128(gt, b));
+}
+
+__attribute__((target("sse2")))
+static inline __m128i mullo32_sse2(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+}
+
+__attribute__((target("sse2")))
+static void minmax_store_sse2(__m128i vmin, __m128i vmax,
+                              pj_int32_t *p_min, pj_int32_t *p_max)
+{
+    pj_int32_t a[4], b[4];
+    unsigned i;
+
+    _mm_storeu_si128((__m128i*)a, vmin);
+    _mm_storeu_si128((__m128i*)b, vmax);
+    for (i=0; i<4; ++i) {
+        if (a[i] < *p_min) *p_min = a[i];
+        if (b[i] > *p_max) *p_max = b[i];
+    }
+}
+
+__attribute__((target("sse2")))
+static pj_uint32_t sum_abs_sse2(const pj_int16_t *src, unsigned count)
+{
+    __m128i acc = _mm_setzero_si128();
+    unsigned i;
+
+    for (i=0; i+8<=count; i+=8)
+        acc = _mm_add_epi32(acc, abs_sum_sse2(
+                            _mm_loadu_si128((const __m128i*)(src+i))));
+
+    return hsum_sse2(acc) + sum_abs_scalar(src+i, count-i);
+}
+
+__attribute__((target("sse2")))
+static pj_uint32_t apply_gain_sse2(pj_int16_t *dst, const pj_int16_t *src,
+                                   unsigned gain, unsigned count)
+{
+    __m128i acc = _mm_setzero_si128();
+    __m128i g;
+    unsigned i = 0;
+
+    /* The gain is multiplied as a signed 16-bit value. */
+    if (gain < 0x8000) {
+        g = _mm_set1_epi32((int)gain);
+        for (; i+8<=count; i+=8) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src+i));
+            __m128i lo, hi;
+
+            lo = _mm_madd_epi16(_mm_unpacklo_epi16(v, v), g);
+            hi = _mm_madd_epi16(_mm_unpackhi_epi16(v, v), g);
+            v = _mm_packs_epi32(_mm_srai_epi32(lo, 7), _mm_srai_epi32(hi, 7));
+            _mm_storeu_si128((__m128i*)(dst+i), v);
+            acc = _mm_add_epi32(acc, abs_sum_sse2(v));
+        }
+    }
+
+    return hsum_sse2(acc) + apply_gain_scalar(dst+i, src+i, gain, count-i);
+}
+
+__attribute__((target("sse2")))
+static void accumulate_sse2(pj_int32_t *dst, const pj_int16_t *src,
+                            unsigned count, pj_int32_t *p_min,
+                            pj_int32_t *p_max)
+{
+    __m128i vmin = _mm_set1_epi32(p_min? *p_min : 0);
+    __m128i vmax = _mm_set1_epi32(p_max? *p_max : 0);
+    unsigned i;
+
+    for (i=0; i+8<=count; i+=8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src+i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+        lo = _mm_add_epi32(lo, _mm_loadu_si128((const __m128i*)(dst+i)));
+        hi = _mm_add_epi32(hi, _mm_loadu_si128((const __m128i*)(dst+i+4)));
+        _mm_storeu_si128((__m128i*)(dst+i), lo);
+        _mm_storeu_si128((__m128i*)(dst+i+4), hi);
+        vmin = min32_sse2(vmin, min32_sse2(lo, hi));
+        vmax = max32_sse2(vmax, max32_sse2(lo, hi));
+    }
+
+    if (p_min)
+        minmax_store_sse2(vmin, vmax, p_min, p_max);
+    accumulate_scalar(dst+i, src+i, count-i, p_min, p_max);
+}
+
+__attribute__((target("sse2")))
+static void accumulate32_sse2(pj_int32_t *dst, const pj_int32_t *src,
+                              const pj_int16_t *sub, unsigned count,
+                              pj_int32_t *p_min, pj_int32_t *p_max)
+{
+    __m128i vmin = _mm_set1_epi32(p_min? *p_min : 0);
+    __m128i vmax = _mm_set1_epi32(p_max? *p_max : 0);
+    unsigned i;
+
+    for (i=0; i+8<=count; i+=8) {
+        __m128i lo = _mm_loadu_si128((const __m128i*)(dst+i));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(dst+i+4));
+
+        lo = _mm_add_epi32(lo, _mm_loadu_si128((const __m128i*)(src+i)));
+        hi = _mm_add_epi32(hi, _mm_loadu_si128((const __m128i*)(src+i+4)));
+        if (sub) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(sub+i));
+
+            lo = _mm_sub_epi32(lo, _mm_srai_epi32(_mm_unpacklo_epi16(v, v),
+                                                  16));
+            hi = _mm_sub_epi32(hi, _mm_srai_epi32(_mm_unpackhi_epi16(v, v),
+                                                  16));
+        }
+        _mm_storeu_si128((__m128i*)(dst+i), lo);
+        _mm_storeu_si128((__m128i*)(dst+i+4), hi);
+        vmin = min32_sse2(vmin, min32_sse2(lo, hi));
+        vmax = max32_sse2(vmax, max32_sse2(lo, hi));
+    }
+
+    if (p_min)
+        minmax_store_sse2(vmin, vmax, p_min, p_max);
+    accumulate32_scalar(dst+i, src+i, sub? sub+i : NULL, count-i,
+                        p_min, p_max);
+}
+
+__attribute__((target("sse2")))
+static pj_uint32_t clamp_sse2(pj_int16_t *dst, const pj_int32_t *src,
+                              unsigned gain, unsigned count)
+{
+    __m128i acc = _mm_setzero_si128();
+    __m128i g = _mm_set1_epi32((int)gain);
+    unsigned i;
+
+    for (i=0; i+8<=count; i+=8) {
+        __m128i lo = _mm_loadu_si128((const __m128i*)(src+i));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(src+i+4));
+        __m128i v;
+
+        if (gain != 128) {
+            lo = _mm_srai_epi32(mullo32_sse2(lo, g), 7);
+            hi = _mm_srai_epi32(mullo32_sse2(hi, g), 7);
+        }
+        v = _mm_packs_epi32(lo, hi);
+        _mm_storeu_si128((__m128i*)(dst+i), v);
+        acc = _mm_add_epi32(acc, abs_sum_sse2(v));
+    }
+
+    return hsum_sse2(acc) + clamp_scalar(dst+i, src+i, gain, count-i);
+}
+
+static const pjmedia_mix_kernel sse2_kernel =
+{
+    PJMEDIA_MIX_KERNEL_SSE2,
+    "sse2",
+    &sum_abs_sse2,
+    &apply_gain_sse2,
+    &accumulate_sse2,
+    &accumulate32_sse2,
+    &clamp_sse2
+};
+
+
+/*
+ * AVX2 implementation, 16 samples per iteration. The unpack and pack
+ * instructions work within 128-bit lanes, so unpacking the low and high
+ * halves of each lane and packing them back keeps the sample order.
+ */
+__attribute__((target("avx2")))
+static inline __m256i abs_sum_avx2(__m256i v)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i a = _mm256_abs_epi16(v);
+
+    return _mm256_add_epi32(_mm256_unpacklo_epi16(a, zero),
+                            _mm256_unpackhi_epi16(a, zero));
+}
+
+__attribute__((target("avx2")))
+static inline pj_uint32_t hsum_avx2(__m256i v)
+{
+    __m128i x = _mm_add_epi32(_mm256_castsi256_si128(v),
+                              _mm256_extracti128_si256(v, 1));
+
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1,0,3,2)));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2,3,0,1)));
+    return (pj_uint32_t)_mm_cvtsi128_si32(x);
+}
+
+__attribute__((target("avx2")))
+static void minmax_store_avx2(__m256i vmin, __m256i vmax,
+                              pj_int32_t *p_min, pj_int32_t *p_max)
+{
+    pj_int32_t a[8], b[8];
+    unsigned i;
+
+    _mm256_storeu_si256((__m256i*)a, vmin);
+    _mm256_storeu_si256((__m256i*)b, vmax);
+    for (i=0; i<8; ++i) {
+        if (a[i] < *p_min) *p_min = a[i];
+        if (b[i] > *p_max) *p_max = b[i];
+    }
+}
+
+__attribute__((target("avx2")))
+static pj_uint32_t sum_abs_avx2(const pj_int16_t *src, unsigned count)
+{
+    __m256i acc = _mm256_setzero_si256();
+    unsigned i;
+
+    for (i=0; i+16<=count; i+=16)
+        acc = _mm256_add_epi32(acc, abs_sum_avx2(
+                               _mm256_loadu_si256((const __m256i*)(src+i))));
+
+    return hsum_avx2(acc) + sum_abs_scalar(src+i, count-i);
+}
+
+__attribute__((target("avx2")))
+static pj_uint32_t apply_gain_avx2(pj_int16_t *dst, const pj_int16_t *src,
+                                   unsigned gain, unsigned count)
+{
+    __m256i acc = _mm256_setzero_si256();
+    __m256i g;
+    unsigned i = 0;
+
+    /* The gain is multiplied as a signed 16-bit value. */
+    if (gain < 0x8000) {
+        g = _mm256_set1_epi32((int)gain);
+        for (; i+16<=count; i+=16) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(src+i));
+            __m256i lo, hi;
+
+            lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(v, v), g);
+            hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(v, v), g);
+            v = _mm256_packs_epi32(_mm256_srai_epi32(lo, 7),
+                                   _mm256_srai_epi32(hi, 7));
+            _mm256_storeu_si256((__m256i*)(dst+i), v);
+            acc = _mm256_add_epi32(acc, abs_sum_avx2(v));
+        }
+    }
+
+    return hsum_avx2(acc) + apply_gain_scalar(dst+i, src+i, gain, count-i);
+}
+
+__attribute__((target("avx2")))
+static void accumulate_avx2(pj_int32_t *dst, const pj_int16_t *src,
+                            unsigned count, pj_int32_t *p_min,
+                            pj_int32_t *p_max)
+{
+    __m256i vmin = _mm256_set1_epi32(p_min? *p_min : 0);
+    __m256i vmax = _mm256_set1_epi32(p_max? *p_max : 0);
+    unsigned i;
+
+    for (i=0; i+8<=count; i+=8) {
+        __m256i v = _mm256_cvtepi16_epi32(
+                        _mm_loadu_si128((const __m128i*)(src+i)));
+
+        v = _mm256_add_epi32(v, _mm256_loadu_si256((const __m256i*)(dst+i)));
+        _mm256_storeu_si256((__m256i*)(dst+i), v);
+        vmin = _mm256_min_epi32(vmin, v);
+        vmax = _mm256_max_epi32(vmax, v);
+    }
+
+    if (p_min)
+        minmax_store_avx2(vmin, vmax, p_min, p_max);
+    accumulate_scalar(dst+i, src+i, count-i, p_min, p_max);
+}
+
+__attribute__((target("avx2")))
+static void accumulate32_avx2(pj_int32_t *dst, const pj_int32_t *src,
+                              const pj_int16_t *sub, unsigned count,
+                              pj_int32_t *p_min, pj_int32_t *p_max)
+{
+    __m256i vmin = _mm256_set1_epi32(p_min? *p_min : 0);
+    __m256i vmax = _mm256_set1_epi32(p_max? *p_max : 0);
+    unsigned i;
+
+    for (i=0; i+8<=count; i+=8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(dst+i));
+
+        v = _mm256_add_epi32(v, _mm256_loadu_si256((const __m256i*)(src+i)));
+        if (sub) {
+            v = _mm256_sub_epi32(v, _mm256_cvtepi16_epi32(
+                                 _mm_loadu_si128((const __m128i*)(sub+i))));
+        }
+        _mm256_storeu_si256((__m256i*)(dst+i), v);
+        vmin = _mm256_min_epi32(vmin, v);
+        vmax = _mm256_max_epi32(vmax, v);
+    }
+
+    if (p_min)
+        minmax_store_avx2(vmin, vmax, p_min, p_max);
+    accumulate32_scalar(dst+i, src+i, sub? sub+i : NULL, count-i,
+                        p_min, p_max);
+}
+
+__attribute__((target("avx2")))
+static pj_uint32_t clamp_avx2(pj_int16_t *dst, const pj_int32_t *src,
+                              unsigned gain, unsigned count)
+{
+    __m256i acc = _mm256_setzero_si256();
+    __m256i g = _mm256_set1_epi32((int)gain);
+    unsigned i;
+
+    for (i=0; i+16<=count; i+=16) {
+        __m256i lo = _mm256_loadu_si256((const __m256i*)(src+i));
+        __m256i hi = _mm256_loadu_si256((const __m256i*)(src+i+8));
+        __m256i v;
+
+        if (gain != 128) {
+            lo = _mm256_srai_epi32(_mm256_mullo_epi32(lo, g), 7);
+            hi = _mm256_srai_epi32(_mm256_mullo_epi32(hi, g), 7);
+        }
+        /* Pack within lanes, then put the 64-bit quarters in order. */
+        v = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi),
+                                     _MM_SHUFFLE(3,1,2,0));
+        _mm256_storeu_si256((__m256i*)(dst+i), v);
+        acc = _mm256_add_epi32(acc, abs_sum_avx2(v));
+    }
+
+    return hsum_avx2(acc) + clamp_scalar(dst+i, src+i, gain, count-i);
+}
+
+static const pjmedia_mix_kernel avx2_kernel =
+{
+    PJMEDIA_MIX_KERNEL_AVX2,
+    "avx2",
+    &sum_abs_avx2,
+    &apply_gain_avx2,
+    &accumulate_avx2,
+    &accumulate32_avx2,
+    &clamp_avx2
+};
+
+#endif  /* HAS_X86_KERNEL */
+
+
+#if HAS_NEON_KERNEL
+/*
+ * NEON implementation, 8 samples per iteration. NEON is mandatory on
+ * AArch64, and on 32-bit ARM it is only built when enabled at compile
+ * time, so there's no run-time detection.
+ */
+
+/* Absolute values, as unsigned so that -32768 gives 32768. */
+static inline uint16x8_t abs_u16_neon(int16x8_t v)
+{
+    return vreinterpretq_u16_s16(vabsq_s16(v));
+}
+
+static inline pj_uint32_t hsum_neon(uint32x4_t v)
+{
+    uint32x2_t x = vadd_u32(vget_low_u32(v), vget_high_u32(v));
+    return vget_lane_u32(vpadd_u32(x, x), 0);
+}
+
+static void minmax_store_neon(int32x4_t vmin, int32x4_t vmax,
+                              pj_int32_t *p_min, pj_int32_t *p_max)
+{
+    pj_int32_t a[4], b[4];
+    unsigned i;
+
+    vst1q_s32(a, vmin);
+    vst1q_s32(b, vmax);
+    for (i=0; i<4; ++i) {
+        if (a[i] < *p_min) *p_min = a[i];
+        if (b[i] > *p_max) *p_max = b[i];
+    }
+}
+
+static pj_uint32_t sum_abs_neon(const pj_int16_t *src, unsigned count)
+{
+    uint32x4_t acc = vdupq_n_u32(0);
+    unsigned i;
+
+    for (i=0; i+8<=count; i+=8)
+        acc = vpadalq_u16(acc, abs_u16_neon(vld1q_s16(src+i)));
+
+    return hsum_neon(acc) + sum_abs_scalar(src+i, count-i);
+}
+
+static pj_uint32_t apply_gain_neon(pj_int16_t *dst, const pj_int16_t *src,
+                                   unsigned gain, unsigned count)
+{
+    uint32x4_t acc = vdupq_n_u32(0);
+    unsigned i = 0;
+
+    /* The gain is multiplied as a signed 16-bit value. */
+    if (gain < 0x8000) {
+        int16x4_t g = vdup_n_s16((pj_int16_t)gain);
+
+        for (; i+8<=count; i+=8) {
+            int16x8_t v = vld1q_s16(src+i);
+            int32x4_t lo = vshrq_n_s32(vmull_s16(vget_low_s16(v), g), 7);
+            int32x4_t hi = vshrq_n_s32(vmull_s16(vget_high_s16(v), g), 7);
+
+            v = vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi));
+            vst1q_s16(dst+i, v);
+            acc = vpadalq_u16(acc, abs_u16_neon(v));
+        }
+    }
+
+    return hsum_neon(acc) + apply_gain_scalar(dst+i, src+i, gain, count-i);
+}
+
+static void accumulate_neon(pj_int32_t *dst, const pj_int16_t *src,
+                            unsigned count, pj_int32_t *p_min,
+                            pj_int32_t *p_max)
+{
+    int32x4_t vmin = vdupq_n_s32(p_min? *p_min : 0);
+    int32x4_t vmax = vdupq_n_s32(p_max? *p_max : 0);
+    unsigned i;
+
+    for (i=0; i+8<=count; i+=8) {
+        int16x8_t v = vld1q_s16(src+i);
+        int32x4_t lo = vaddw_s16(vld1q_s32(dst+i), vget_low_s16(v));
+        int32x4_t hi = vaddw_s16(vld1q_s32(dst+i+4), vget_high_s16(v));
+
+        vst1q_s32(dst+i, lo);
+        vst1q_s32(dst+i+4, hi);
+        vmin = vminq_s32(vmin, vminq_s32(lo, hi));
+        vmax = vmaxq_s32(vmax, vmaxq_s32(lo, hi));
+    }
+
+    if (p_min)
+        minmax_store_neon(vmin, vmax, p_min, p_max);
+    accumulate_scalar(dst+i, src+i, count-i, p_min, p_max);
+}
+
+static void accumulate32_neon(pj_int32_t *dst, const pj_int32_t *src,
+                              const pj_int16_t *sub, unsigned count,
+                              pj_int32_t *p_min, pj_int32_t *p_max)
+{
+    int32x4_t vmin = vdupq_n_s32(p_min? *p_min : 0);
+    int32x4_t vmax = vdupq_n_s32(p_max? *p_max : 0);
+    unsigned i;
+
+    for (i=0; i+8<=count; i+=8) {
+        int32x4_t lo = vaddq_s32(vld1q_s32(dst+i), vld1q_s32(src+i));
+        int32x4_t hi = vaddq_s32(vld1q_s32(dst+i+4), vld1q_s32(src+i+4));
+
+        if (sub) {
+            int16x8_t v = vld1q_s16(sub+i);
+
+            lo = vsubw_s16(lo, vget_low_s16(v));
+            hi = vsubw_s16(hi, vget_high_s16(v));
+        }
+        vst1q_s32(dst+i, lo);
+        vst1q_s32(dst+i+4, hi);
+        vmin = vminq_s32(vmin, vminq_s32(lo, hi));
+        vmax = vmaxq_s32(vmax, vmaxq_s32(lo, hi));
+    }
+
+    if (p_min)
+        minmax_store_neon(vmin, vmax, p_min, p_max);
+    accumulate32_scalar(dst+i, src+i, sub? sub+i : NULL, count-i,
+                        p_min, p_max);
+}
+
+static pj_uint32_t clamp_neon(pj_int16_t *dst, const pj_int32_t *src,
+                              unsigned gain, unsigned count)
+{
+    uint32x4_t acc = vdupq_n_u32(0);
+    int32x4_t g = vdupq_n_s32((pj_int32_t)gain);
+    unsigned i;
+
+    for (i=0; i+8<=count; i+=8) {
+        int32x4_t lo = vld1q_s32(src+i);
+        int32x4_t hi = vld1q_s32(src+i+4);
+        int16x8_t v;
+
+        if (gain != 128) {
+            lo = vshrq_n_s32(vmulq_s32(lo, g), 7);
+            hi = vshrq_n_s32(vmulq_s32(hi, g), 7);
+        }
+        v = vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi));
+        vst1q_s16(dst+i, v);
+        acc = vpadalq_u16(acc, abs_u16_neon(v));
+    }
+
+    return hsum_neon(acc) + clamp_scalar(dst+i, src+i, gain, count-i);
+}
+
+static const pjmedia_mix_kernel neon_kernel =
+{
+    PJMEDIA_MIX_KERNEL_NEON,
+    "neon",
+    &sum_abs_neon,
+    &apply_gain_neon,
+    &accumulate_neon,
+    &accumulate32_neon,
+    &clamp_neon
+};
+
+#endif  /* HAS_NEON_KERNEL */
+
+
+/* The best implementation for the CPU, selected on the first call. */
+static const pjmedia_mix_kernel *auto_kernel;
+
+PJ_DEF(const pjmedia_mix_kernel*)
+pjmedia_mix_kernel_get(pjmedia_mix_kernel_type type)
+{
+    switch (type) {
+    case PJMEDIA_MIX_KERNEL_AUTO:
+        if (auto_kernel == NULL) {
+            const pjmedia_mix_kernel *k = &scalar_kernel;
+#if HAS_X86_KERNEL
+            if (pjmedia_mix_kernel_get(PJMEDIA_MIX_KERNEL_AVX2))
+                k = &avx2_kernel;
+            else if (pjmedia_mix_kernel_get(PJMEDIA_MIX_KERNEL_SSE2))
+                k = &sse2_kernel;
+#elif HAS_NEON_KERNEL
+            k = &neon_kernel;
+#endif
+            auto_kernel = k;
+        }
+        return auto_kernel;
+
+    case PJMEDIA_MIX_KERNEL_SCALAR:
+        return &scalar_kernel;
+
+#if HAS_X86_KERNEL
+    case PJMEDIA_MIX_KERNEL_SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2")? &sse2_kernel : NULL;
+
+    case PJMEDIA_MIX_KERNEL_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2")? &avx2_kernel : NULL;
+#endif
+
+#if HAS_NEON_KERNEL
+    case PJMEDIA_MIX_KERNEL_NEON:
+        return &neon_kernel;
+#endif
+
+    default:
+        return NULL;
+    }
+}
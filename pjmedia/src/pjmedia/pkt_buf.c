@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <pjmedia/pkt_buf.h>
+#include <pjmedia/errno.h>
+#include <pj/assert.h>
+#include <pj/lock.h>
+#include <pj/log.h>
+#include <pj/os.h>
+#include <pj/pool.h>
+
+
+#define THIS_FILE       "pkt_buf.c"
+
+/* Number of buffers moved between a thread cache and the free list */
+#define CACHE_BATCH     ((PJMEDIA_PKT_BUF_CACHE_SIZE + 1) / 2)
+
+
+/* Free buffers of a pool kept by one thread. It is only accessed by its
+ * own thread, so it does not need locking. Buffers left in the cache of
+ * a thread that has exited are only reclaimed when the pool is released.
+ */
+typedef struct thread_cache
+{
+    unsigned             cnt;
+    pjmedia_pkt_buf     *bufs[PJMEDIA_PKT_BUF_CACHE_SIZE + 1];
+} thread_cache;
+
+
+struct pjmedia_pkt_buf_pool
+{
+    pj_pool_t           *pool;
+    pj_size_t            buf_size;
+    pj_lock_t           *lock;
+    long                 tls_id;        /* Index of the thread caches       */
+    pj_bool_t            has_tls;
+
+    pjmedia_pkt_buf     *free_list;     /* Shared free buffers              */
+    unsigned             total_cnt;     /* Number of buffers allocated      */
+
+    /* Number of buffers given out, plus one reference held by the pool
+     * itself until it is destroyed. The pool is released when this
+     * reaches zero.
+     */
+    pj_atomic_t         *busy_cnt;
+};
+
+
+/* Allocate a new buffer. Must be called with the lock held. */
+static pjmedia_pkt_buf *create_buf(pjmedia_pkt_buf_pool *pool)
+{
+    pjmedia_pkt_buf *buf;
+
+    buf = PJ_POOL_ZALLOC_T(pool->pool, pjmedia_pkt_buf);
+    buf->buf = pj_pool_alloc(pool->pool, pool->buf_size);
+    buf->size = pool->buf_size;
+    buf->pool = pool;
+    if (pj_atomic_create(pool->pool, 0, &buf->ref_cnt) != PJ_SUCCESS)
+        return NULL;
+
+    ++pool->total_cnt;
+    return buf;
+}
+
+
+/* Get the cache of the calling thread, creating it if necessary. */
+static thread_cache *get_cache(pjmedia_pkt_buf_pool *pool)
+{
+    thread_cache *cache;
+
+    if (!pool->has_tls)
+        return NULL;
+
+    cache = (thread_cache*) pj_thread_local_get(pool->tls_id);
+    if (cache)
+        return cache;
+
+    pj_lock_acquire(pool->lock);
+    cache = PJ_POOL_ZALLOC_T(pool->pool, thread_cache);
+    pj_lock_release(pool->lock);
+
+    if (pj_thread_local_set(pool->tls_id, cache) != PJ_SUCCESS)
+        return NULL;
+
+    return cache;
+}
+
+
+static void release_pool(pjmedia_pkt_buf_pool *pool)
+{
+    PJ_LOG(5,(THIS_FILE, "Packet buffer pool %s destroyed, %u buffers",
+              pool->pool->obj_name, pool->total_cnt));
+
+    if (pool->has_tls)
+        pj_thread_local_free(pool->tls_id);
+    if (pool->busy_cnt)
+        pj_atomic_destroy(pool->busy_cnt);
+    if (pool->lock)
+        pj_lock_destroy(pool->lock);
+    pj_pool_safe_release(&pool->pool);
+}
+
+
+static void pool_dec_busy(pjmedia_pkt_buf_pool *pool)
+{
+    if (pj_atomic_dec_and_get(pool->busy_cnt) == 0)
+        release_pool(pool);
+}
+
+
+/*
+ * Create the pool.
+ */
+PJ_DEF(pj_status_t) pjmedia_pkt_buf_pool_create(pj_pool_factory *pf,
+                                                const char *name,
+                                                pj_size_t buf_size,
+                                                unsigned init_cnt,
+                                                pjmedia_pkt_buf_pool **p_pool)
+{
+    pj_pool_t *pool;
+    pjmedia_pkt_buf_pool *bp;
+    unsigned i;
+    pj_status_t status;
+
+    PJ_ASSERT_RETURN(pf && buf_size && p_pool, PJ_EINVAL);
+
+    if (!name)
+        name = "pktbuf%p";
+
+    pool = pj_pool_create(pf, name, 512 + init_cnt * buf_size,
+                          16 * buf_size, NULL);
+    if (!pool)
+        return PJ_ENOMEM;
+
+    bp = PJ_POOL_ZALLOC_T(pool, pjmedia_pkt_buf_pool);
+    bp->pool = pool;
+    bp->buf_size = buf_size;
+
+    status = pj_lock_create_simple_mutex(pool, pool->obj_name, &bp->lock);
+    if (status != PJ_SUCCESS)
+        goto on_error;
+
+    status = pj_atomic_create(pool, 1, &bp->busy_cnt);
+    if (status != PJ_SUCCESS)
+        goto on_error;
+
+#if PJMEDIA_PKT_BUF_CACHE_SIZE > 0
+    status = pj_thread_local_alloc(&bp->tls_id);
+    if (status != PJ_SUCCESS)
+        goto on_error;
+    bp->has_tls = PJ_TRUE;
+#endif
+
+    for (i = 0; i < init_cnt; ++i) {
+        pjmedia_pkt_buf *buf = create_buf(bp);
+        if (!buf) {
+            status = PJ_ENOMEM;
+            goto on_error;
+        }
+        buf->next = bp->free_list;
+        bp->free_list = buf;
+    }
+
+    PJ_LOG(5,(THIS_FILE, "Packet buffer pool %s created, buf_size=%lu",
+              pool->obj_name, (unsigned long)buf_size));
+
+    *p_pool = bp;
+    return PJ_SUCCESS;
+
+on_error:
+    release_pool(bp);
+    return status;
+}
+
+
+/*
+ * Destroy the pool.
+ */
+PJ_DEF(pj_status_t) pjmedia_pkt_buf_pool_destroy(pjmedia_pkt_buf_pool *pool)
+{
+    PJ_ASSERT_RETURN(pool, PJ_EINVAL);
+
+    /* Release the reference of the pool itself, buffers that are still
+     * in use keep the pool alive.
+     */
+    pool_dec_busy(pool);
+    return PJ_SUCCESS;
+}
+
+
+/*
+ * Get a buffer.
+ */
+PJ_DEF(pj_status_t) pjmedia_pkt_buf_alloc(pjmedia_pkt_buf_pool *pool,
+                                          pjmedia_pkt_buf **p_buf)
+{
+    thread_cache *cache;
+    pjmedia_pkt_buf *buf = NULL;
+
+    PJ_ASSERT_RETURN(pool && p_buf, PJ_EINVAL);
+
+    cache = get_cache(pool);
+    if (cache && cache->cnt) {
+        buf = cache->bufs[--cache->cnt];
+    } else {
+        pj_lock_acquire(pool->lock);
+
+        /* Grow the pool by a batch of buffers */
+        if (!pool->free_list) {
+            unsigned i;
+
+            for (i = 0; i <= CACHE_BATCH; ++i) {
+                pjmedia_pkt_buf *b = create_buf(pool);
+                if (!b)
+                    break;
+                b->next = pool->free_list;
+                pool->free_list = b;
+            }
+        }
+
+        buf = pool->free_list;
+        if (buf)
+            pool->free_list = buf->next;
+
+        /* Refill the thread cache */
+        while (cache && cache->cnt < CACHE_BATCH && pool->free_list) {
+            cache->bufs[cache->cnt++] = pool->free_list;
+            pool->free_list = pool->free_list->next;
+        }
+
+        pj_lock_release(pool->lock);
+    }
+
+    if (!buf)
+        return PJ_ENOMEM;
+
+    buf->len = 0;
+    buf->next = NULL;
+    pj_atomic_set(buf->ref_cnt, 1);
+    pj_atomic_inc(pool->busy_cnt);
+
+    *p_buf = buf;
+    return PJ_SUCCESS;
+}
+
+
+/*
+ * Add reference.
+ */
+PJ_DEF(void) pjmedia_pkt_buf_add_ref(pjmedia_pkt_buf *buf)
+{
+    pj_assert(buf && pj_atomic_get(buf->ref_cnt) > 0);
+    pj_atomic_inc(buf->ref_cnt);
+}
+
+
+/*
+ * Release reference.
+ */
+PJ_DEF(void) pjmedia_pkt_buf_dec_ref(pjmedia_pkt_buf *buf)
+{
+    pjmedia_pkt_buf_pool *pool;
+    thread_cache *cache;
+
+    pj_assert(buf && pj_atomic_get(buf->ref_cnt) > 0);
+    if (pj_atomic_dec_and_get(buf->ref_cnt) != 0)
+        return;
+
+    pool = buf->pool;
+    cache = get_cache(pool);
+    if (cache) {
+        cache->bufs[cache->cnt++] = buf;
+
+        /* Spill half of a full cache back to the free list */
+        if (cache->cnt > PJMEDIA_PKT_BUF_CACHE_SIZE) {
+            pj_lock_acquire(pool->lock);
+            while (cache->cnt > PJMEDIA_PKT_BUF_CACHE_SIZE + 1 - CACHE_BATCH)
+            {
+                pjmedia_pkt_buf *b = cache->bufs[--cache->cnt];
+                b->next = pool->free_list;
+                pool->free_list = b;
+            }
+            pj_lock_release(pool->lock);
+        }
+    } else {
+        pj_lock_acquire(pool->lock);
+        buf->next = pool->free_list;
+        pool->free_list = buf;
+        pj_lock_release(pool->lock);
+    }
+
+    pool_dec_busy(pool);
+}
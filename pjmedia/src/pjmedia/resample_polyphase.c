@@ -0,0 +1,596 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <pjmedia/resample.h>
+#include <pjmedia/errno.h>
+#include <pj/assert.h>
+#include <pj/log.h>
+#include <pj/math.h>
+#include <pj/os.h>
+#include <pj/pool.h>
+#include <pj/string.h>
+
+#if PJMEDIA_RESAMPLE_IMP==PJMEDIA_RESAMPLE_POLYPHASE
+
+#include <math.h>
+
+#define THIS_FILE   "resample_polyphase.c"
+
+/*
+ * Rational polyphase sample rate converter.
+ *
+ * The conversion ratio rate_out/rate_in is reduced to L/M. Conceptually
+ * the input is upsampled by L, low-pass filtered, then decimated by M.
+ * Only the filter phases actually needed are evaluated: output sample n
+ * sits at t=n*M on the upsampled time line, i.e. after input sample t/L,
+ * and is the dot product of the last "taps" input samples with phase t%L
+ * of the filter. Each phase is stored reversed so that the dot product
+ * runs forward over contiguous input, which is what the SIMD kernels
+ * below want.
+ *
+ * Filter banks for the conversions between 8, 16, 32 and 48 KHz are
+ * computed once and shared, read-only, by all resample instances, so a
+ * conference bridge with many ports does not hold many copies of the
+ * same filter.
+ */
+
+#if defined(PJMEDIA_RESAMPLE_POLYPHASE_USE_SIMD) && \
+    PJMEDIA_RESAMPLE_POLYPHASE_USE_SIMD!=0
+#   if defined(__x86_64__) || defined(__i386__)
+#       define HAS_X86_KERNEL   1
+#       include <immintrin.h>
+#   elif defined(__aarch64__) || defined(__ARM_NEON)
+#       define HAS_NEON_KERNEL  1
+#       include <arm_neon.h>
+#   endif
+#endif
+
+#ifndef HAS_X86_KERNEL
+#   define HAS_X86_KERNEL       0
+#endif
+#ifndef HAS_NEON_KERNEL
+#   define HAS_NEON_KERNEL      0
+#endif
+
+#define MAX_LEVEL   (32767)
+#define MIN_LEVEL   (-32768)
+
+/* Clip 32-bit value to 16-bit sample */
+#define CLIP(x)     ((x) > MAX_LEVEL ? MAX_LEVEL : \
+                     ((x) < MIN_LEVEL ? MIN_LEVEL : (x)))
+
+/* Filter coefficients are Q14, the largest coefficient is below 1.0 */
+#define COEF_SHIFT  14
+
+/* Taps per phase are rounded up to this, for the SIMD kernels */
+#define TAPS_ALIGN  8
+
+/* Largest filter bank (phases * taps) we are willing to build */
+#define MAX_BANK_SIZE   (64 * 1024)
+
+/* Filter quality, from pjmedia_resample_create() arguments */
+enum
+{
+    QUALITY_LOW,        /* !high_quality                    */
+    QUALITY_HIGH,       /* high_quality && !large_filter    */
+    QUALITY_LARGE,      /* high_quality && large_filter     */
+    QUALITY_CNT
+};
+
+/* Zero crossings of the sinc on each side, at the lower of both rates */
+static const unsigned filter_zc[QUALITY_CNT] = { 4, 8, 16 };
+
+/* Passband edge, relative to the Nyquist frequency of the lower rate */
+static const double filter_rolloff[QUALITY_CNT] = { 0.80, 0.88, 0.92 };
+
+/* Kaiser window beta */
+static const double filter_beta[QUALITY_CNT] = { 5.0, 6.5, 8.0 };
+
+
+typedef struct filter_bank
+{
+    unsigned            L;          /* Interpolation factor             */
+    unsigned            M;          /* Decimation factor                */
+    unsigned            taps;       /* Taps per phase, TAPS_ALIGN-ed    */
+    const pj_int16_t   *coef;       /* L phases of taps coefficients    */
+} filter_bank;
+
+/* Filter a channel: produce count output samples from buf. */
+typedef void (*filter_func)(const filter_bank *fb, const pj_int16_t *buf,
+                            unsigned count, pj_int16_t *out,
+                            unsigned stride);
+
+
+/*
+ * Shared filter banks for the common conversions between 8, 16, 32 and
+ * 48 KHz, as reduced L/M ratios.
+ */
+#define SHARED_BANK_SIZE    192
+
+static const struct
+{
+    pj_uint8_t  L;
+    pj_uint8_t  M;
+} shared_ratio[] =
+{
+    { 2, 1 }, { 4, 1 }, { 6, 1 }, { 3, 1 }, { 3, 2 },
+    { 1, 2 }, { 1, 4 }, { 1, 6 }, { 1, 3 }, { 2, 3 }
+};
+
+#define SHARED_RATIO_CNT    PJ_ARRAY_SIZE(shared_ratio)
+
+static pj_int16_t  shared_coef[QUALITY_CNT][SHARED_RATIO_CNT]
+                              [SHARED_BANK_SIZE];
+static filter_bank shared_bank[QUALITY_CNT][SHARED_RATIO_CNT];
+
+
+struct pjmedia_resample
+{
+    const filter_bank  *fb;
+    filter_func         filter;
+    unsigned            channel_count;
+    unsigned            in_samples_per_frame;
+    unsigned            out_samples_per_frame;
+    unsigned            frame_len;      /* Input samples per channel    */
+    unsigned            hist_len;       /* History samples, taps-1      */
+    pj_int16_t        **buf;            /* Per channel, hist+frame_len  */
+};
+
+
+/* Zeroth order modified Bessel function of the first kind. */
+static double bessel_i0(double x)
+{
+    double sum = 1.0, term = 1.0, k;
+
+    for (k = 1.0; term > sum * 1e-12; k += 1.0) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+/* Kaiser windowed sinc prototype filter, tap k of n. */
+static double prototype(unsigned k, unsigned n, double fc, double beta)
+{
+    double x = k - (n - 1) / 2.0;
+    double r = 2.0 * k / (n - 1) - 1.0;
+    double h;
+
+    h = (x == 0.0) ? 2.0 * fc : sin(2.0 * PJ_PI * fc * x) / (PJ_PI * x);
+    return h * bessel_i0(beta * sqrt(1.0 - r * r)) / bessel_i0(beta);
+}
+
+static unsigned calc_taps(unsigned L, unsigned M, unsigned quality)
+{
+    unsigned taps;
+
+    taps = (2 * filter_zc[quality] * PJ_MAX(L, M) + L - 1) / L;
+    return (taps + TAPS_ALIGN - 1) / TAPS_ALIGN * TAPS_ALIGN;
+}
+
+/* Design the filter and store it as L reversed phases. */
+static void init_bank(filter_bank *fb, pj_int16_t *coef, unsigned L,
+                      unsigned M, unsigned quality)
+{
+    unsigned n, p, j;
+    double fc, beta, sum, scale;
+
+    fb->L = L;
+    fb->M = M;
+    fb->taps = calc_taps(L, M, quality);
+    fb->coef = coef;
+
+    n = L * fb->taps;
+    fc = 0.5 * filter_rolloff[quality] / PJ_MAX(L, M);
+    beta = filter_beta[quality];
+
+    /* Normalize for unity gain: each phase sums to approximately one */
+    for (j = 0, sum = 0.0; j < n; ++j)
+        sum += prototype(j, n, fc, beta);
+    scale = L * (1 << COEF_SHIFT) / sum;
+
+    for (p = 0; p < L; ++p) {
+        for (j = 0; j < fb->taps; ++j) {
+            double h = prototype(p + (fb->taps - 1 - j) * L, n, fc, beta);
+            coef[p * fb->taps + j] = (pj_int16_t)floor(h * scale + 0.5);
+        }
+    }
+}
+
+/* Get the shared bank for the ratio, or NULL if there is none. */
+static const filter_bank *get_shared_bank(unsigned L, unsigned M,
+                                          unsigned quality)
+{
+    filter_bank *fb;
+    unsigned i;
+
+    for (i = 0; i < SHARED_RATIO_CNT; ++i) {
+        if (shared_ratio[i].L == L && shared_ratio[i].M == M)
+            break;
+    }
+    if (i == SHARED_RATIO_CNT ||
+        L * calc_taps(L, M, quality) > SHARED_BANK_SIZE)
+    {
+        return NULL;
+    }
+
+    fb = &shared_bank[quality][i];
+    pj_enter_critical_section();
+    if (fb->coef == NULL)
+        init_bank(fb, shared_coef[quality][i], L, M, quality);
+    pj_leave_critical_section();
+
+    return fb;
+}
+
+
+static pj_int16_t round_sample(pj_int32_t acc)
+{
+    acc = (acc + (1 << (COEF_SHIFT - 1))) >> COEF_SHIFT;
+    return (pj_int16_t)CLIP(acc);
+}
+
+/*
+ * Scalar implementation.
+ */
+static pj_int32_t dot_scalar(const pj_int16_t *x, const pj_int16_t *h,
+                             unsigned taps)
+{
+    pj_int32_t acc = 0;
+    unsigned j;
+
+    for (j = 0; j < taps; ++j)
+        acc += x[j] * h[j];
+
+    return acc;
+}
+
+static void filter_scalar(const filter_bank *fb, const pj_int16_t *buf,
+                          unsigned count, pj_int16_t *out, unsigned stride)
+{
+    unsigned n, i = 0, p = 0;
+
+    for (n = 0; n < count; ++n) {
+        pj_int32_t acc = dot_scalar(buf + i, fb->coef + p * fb->taps,
+                                    fb->taps);
+        out[n * stride] = round_sample(acc);
+
+        p += fb->M;
+        i += p / fb->L;
+        p %= fb->L;
+    }
+}
+
+
+#if HAS_X86_KERNEL
+/*
+ * SSE2 implementation, 8 taps per iteration. The coefficients are at most
+ * 2^14, so the pairwise sums of _mm_madd_epi16() cannot overflow.
+ */
+__attribute__((target("sse2")))
+static inline pj_int32_t dot_sse2(const pj_int16_t *x, const pj_int16_t *h,
+                                  unsigned taps)
+{
+    __m128i acc = _mm_setzero_si128();
+    unsigned j;
+
+    for (j = 0; j < taps; j += 8) {
+        __m128i vx = _mm_loadu_si128((const __m128i*)(x + j));
+        __m128i vh = _mm_loadu_si128((const __m128i*)(h + j));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(vx, vh));
+    }
+
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1,0,3,2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2,3,0,1)));
+    return _mm_cvtsi128_si32(acc);
+}
+
+__attribute__((target("sse2")))
+static void filter_sse2(const filter_bank *fb, const pj_int16_t *buf,
+                        unsigned count, pj_int16_t *out, unsigned stride)
+{
+    unsigned n, i = 0, p = 0;
+
+    for (n = 0; n < count; ++n) {
+        pj_int32_t acc = dot_sse2(buf + i, fb->coef + p * fb->taps,
+                                  fb->taps);
+        out[n * stride] = round_sample(acc);
+
+        p += fb->M;
+        i += p / fb->L;
+        p %= fb->L;
+    }
+}
+
+/*
+ * AVX2 implementation, 16 taps per iteration and the remaining 8 taps
+ * with SSE2.
+ */
+__attribute__((target("avx2")))
+static inline pj_int32_t dot_avx2(const pj_int16_t *x, const pj_int16_t *h,
+                                  unsigned taps)
+{
+    __m256i acc256 = _mm256_setzero_si256();
+    __m128i acc;
+    unsigned j;
+
+    for (j = 0; j + 16 <= taps; j += 16) {
+        __m256i vx = _mm256_loadu_si256((const __m256i*)(x + j));
+        __m256i vh = _mm256_loadu_si256((const __m256i*)(h + j));
+        acc256 = _mm256_add_epi32(acc256, _mm256_madd_epi16(vx, vh));
+    }
+
+    acc = _mm_add_epi32(_mm256_castsi256_si128(acc256),
+                        _mm256_extracti128_si256(acc256, 1));
+    if (j < taps) {
+        __m128i vx = _mm_loadu_si128((const __m128i*)(x + j));
+        __m128i vh = _mm_loadu_si128((const __m128i*)(h + j));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(vx, vh));
+    }
+
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1,0,3,2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2,3,0,1)));
+    return _mm_cvtsi128_si32(acc);
+}
+
+__attribute__((target("avx2")))
+static void filter_avx2(const filter_bank *fb, const pj_int16_t *buf,
+                        unsigned count, pj_int16_t *out, unsigned stride)
+{
+    unsigned n, i = 0, p = 0;
+
+    for (n = 0; n < count; ++n) {
+        pj_int32_t acc = dot_avx2(buf + i, fb->coef + p * fb->taps,
+                                  fb->taps);
+        out[n * stride] = round_sample(acc);
+
+        p += fb->M;
+        i += p / fb->L;
+        p %= fb->L;
+    }
+}
+
+#endif  /* HAS_X86_KERNEL */
+
+
+#if HAS_NEON_KERNEL
+/*
+ * NEON implementation, 8 taps per iteration.
+ */
+static inline pj_int32_t dot_neon(const pj_int16_t *x, const pj_int16_t *h,
+                                  unsigned taps)
+{
+    int32x4_t acc0 = vdupq_n_s32(0);
+    int32x4_t acc1 = vdupq_n_s32(0);
+    int32x2_t sum;
+    unsigned j;
+
+    for (j = 0; j < taps; j += 8) {
+        int16x8_t vx = vld1q_s16(x + j);
+        int16x8_t vh = vld1q_s16(h + j);
+        acc0 = vmlal_s16(acc0, vget_low_s16(vx), vget_low_s16(vh));
+        acc1 = vmlal_s16(acc1, vget_high_s16(vx), vget_high_s16(vh));
+    }
+
+    acc0 = vaddq_s32(acc0, acc1);
+    sum = vadd_s32(vget_low_s32(acc0), vget_high_s32(acc0));
+    sum = vpadd_s32(sum, sum);
+    return vget_lane_s32(sum, 0);
+}
+
+static void filter_neon(const filter_bank *fb, const pj_int16_t *buf,
+                        unsigned count, pj_int16_t *out, unsigned stride)
+{
+    unsigned n, i = 0, p = 0;
+
+    for (n = 0; n < count; ++n) {
+        pj_int32_t acc = dot_neon(buf + i, fb->coef + p * fb->taps,
+                                  fb->taps);
+        out[n * stride] = round_sample(acc);
+
+        p += fb->M;
+        i += p / fb->L;
+        p %= fb->L;
+    }
+}
+
+#endif  /* HAS_NEON_KERNEL */
+
+
+/* Select the best implementation for the CPU. */
+static filter_func get_filter(const char **p_name)
+{
+#if HAS_X86_KERNEL
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        *p_name = "avx2";
+        return &filter_avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        *p_name = "sse2";
+        return &filter_sse2;
+    }
+#elif HAS_NEON_KERNEL
+    *p_name = "neon";
+    return &filter_neon;
+#endif
+    *p_name = "scalar";
+    return &filter_scalar;
+}
+
+
+static unsigned gcd(unsigned a, unsigned b)
+{
+    while (b) {
+        unsigned t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+
+PJ_DEF(pj_status_t) pjmedia_resample_create( pj_pool_t *pool,
+                                             pj_bool_t high_quality,
+                                             pj_bool_t large_filter,
+                                             unsigned channel_count,
+                                             unsigned rate_in,
+                                             unsigned rate_out,
+                                             unsigned samples_per_frame,
+                                             pjmedia_resample **p_resample)
+{
+    pjmedia_resample *resample;
+    const filter_bank *fb;
+    const char *kernel_name;
+    unsigned quality, L, M, g, i;
+
+    PJ_ASSERT_RETURN(pool && p_resample && rate_in &&
+                     rate_out && samples_per_frame, PJ_EINVAL);
+    PJ_ASSERT_RETURN(channel_count &&
+                     samples_per_frame % channel_count == 0, PJ_EINVAL);
+
+    g = gcd(rate_in, rate_out);
+    L = rate_out / g;
+    M = rate_in / g;
+
+    /* The output frame must be a whole number of samples, so that every
+     * frame starts at filter phase zero. E.g: 8000 to 11025 Hz needs a
+     * multiple of 320 input samples, 10 ms frames are not supported.
+     */
+    if ((samples_per_frame / channel_count * L) % M != 0) {
+        PJ_LOG(4,(THIS_FILE, "Unsupported frame size %d for resample "
+                  "ratio %d/%d", samples_per_frame / channel_count,
+                  rate_in, rate_out));
+        return PJ_ENOTSUP;
+    }
+
+    if (high_quality)
+        quality = large_filter ? QUALITY_LARGE : QUALITY_HIGH;
+    else
+        quality = QUALITY_LOW;
+
+    if (L * calc_taps(L, M, quality) > MAX_BANK_SIZE) {
+        PJ_LOG(4,(THIS_FILE, "Unsupported resample ratio %d/%d",
+                  rate_in, rate_out));
+        return PJ_ENOTSUP;
+    }
+
+    resample = PJ_POOL_ZALLOC_T(pool, pjmedia_resample);
+    PJ_ASSERT_RETURN(resample, PJ_ENOMEM);
+
+    fb = get_shared_bank(L, M, quality);
+    if (!fb) {
+        filter_bank *own;
+        pj_int16_t *coef;
+
+        own = PJ_POOL_ZALLOC_T(pool, filter_bank);
+        coef = (pj_int16_t*)
+               pj_pool_alloc(pool, L * calc_taps(L, M, quality) *
+                                   sizeof(pj_int16_t));
+        PJ_ASSERT_RETURN(own && coef, PJ_ENOMEM);
+
+        init_bank(own, coef, L, M, quality);
+        fb = own;
+    }
+
+    resample->fb = fb;
+    resample->filter = get_filter(&kernel_name);
+    resample->channel_count = channel_count;
+    resample->in_samples_per_frame = samples_per_frame;
+    resample->frame_len = samples_per_frame / channel_count;
+    resample->out_samples_per_frame = resample->frame_len * L / M *
+                                      channel_count;
+    resample->hist_len = fb->taps - 1;
+
+    resample->buf = (pj_int16_t**)
+                    pj_pool_calloc(pool, channel_count, sizeof(pj_int16_t*));
+    PJ_ASSERT_RETURN(resample->buf, PJ_ENOMEM);
+
+    for (i = 0; i < channel_count; ++i) {
+        resample->buf[i] = (pj_int16_t*)
+                           pj_pool_calloc(pool,
+                                          resample->hist_len +
+                                            resample->frame_len,
+                                          sizeof(pj_int16_t));
+        PJ_ASSERT_RETURN(resample->buf[i], PJ_ENOMEM);
+    }
+
+    *p_resample = resample;
+
+    PJ_LOG(5,(THIS_FILE,
+              "resample created: quality=%d, ch=%d, in/out rate=%d/%d, "
+              "L/M=%d/%d, taps=%d, kernel=%s",
+              quality, channel_count, rate_in, rate_out, L, M, fb->taps,
+              kernel_name));
+    return PJ_SUCCESS;
+}
+
+
+PJ_DEF(void) pjmedia_resample_run( pjmedia_resample *resample,
+                                   const pj_int16_t *input,
+                                   pj_int16_t *output )
+{
+    unsigned ch, cnt, i;
+
+    PJ_ASSERT_ON_FAIL(resample, return);
+
+    cnt = resample->channel_count;
+
+    for (ch = 0; ch < cnt; ++ch) {
+        pj_int16_t *buf = resample->buf[ch];
+        pj_int16_t *dst = buf + resample->hist_len;
+
+        if (cnt == 1) {
+            pjmedia_copy_samples(dst, input, resample->frame_len);
+        } else {
+            for (i = 0; i < resample->frame_len; ++i)
+                dst[i] = input[i * cnt + ch];
+        }
+
+        (*resample->filter)(resample->fb, buf,
+                            resample->out_samples_per_frame / cnt,
+                            output + ch, cnt);
+
+        /* Keep the tail of this frame as history for the next one */
+        pjmedia_move_samples(buf, buf + resample->frame_len,
+                             resample->hist_len);
+    }
+}
+
+
+PJ_DEF(unsigned) pjmedia_resample_get_input_size(pjmedia_resample *resample)
+{
+    PJ_ASSERT_RETURN(resample != NULL, 0);
+    return resample->in_samples_per_frame;
+}
+
+
+PJ_DEF(void) pjmedia_resample_destroy(pjmedia_resample *resample)
+{
+    /* Everything is allocated from the pool, and shared filter banks
+     * live for the lifetime of the library.
+     */
+    PJ_UNUSED_ARG(resample);
+}
+
+#else /* PJMEDIA_RESAMPLE_IMP==PJMEDIA_RESAMPLE_POLYPHASE */
+
+int pjmedia_resample_polyphase_excluded;
+
+#endif  /* PJMEDIA_RESAMPLE_IMP==PJMEDIA_RESAMPLE_POLYPHASE */
+
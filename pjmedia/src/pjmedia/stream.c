@@ -21,6 +21,7 @@
 #include <pjmedia/rtp.h>
 #include <pjmedia/rtcp.h>
 #include <pjmedia/jbuf.h>
+#include <pjmedia/wsola.h>
 #include <pj/array.h>
 #include <pj/assert.h>
 #include <pj/ctype.h>
@@ -122,6 +123,17 @@ struct pjmedia_stream
     unsigned                 plc_cnt;       /**< # of consecutive PLC frames*/
     unsigned                 max_plc_cnt;   /**< Max # of PLC frames        */
 
+    pjmedia_wsola           *wsola;         /**< Time-stretcher, only used
+                                                 with histogram jitter
+                                                 buffer algorithm.          */
+    pj_int16_t              *ts_buf;        /**< Time-stretch buffer, three
+                                                 frames.                    */
+    unsigned                 ts_buf_cnt;    /**< Samples in ts_buf.         */
+    int                      ts_clock_adj;  /**< Jitter buffer clock
+                                                 correction, in samples.    */
+    pj_bool_t                ts_expanded;   /**< Last frame was expanded.   */
+    pj_bool_t                ts_has_audio;  /**< Last frame was audio.      */
+
     unsigned                 vad_enabled;   /**< VAD enabled in param.      */
     unsigned                 frame_size;    /**< Size of encoded base frame.*/
     pj_bool_t                is_streaming;  /**< Currently streaming?. This
@@ -645,6 +657,143 @@ static pj_status_t get_frame( pjmedia_port *port, pjmedia_frame *frame)
 }
 
 
+/* Fill the time-stretch buffer with decoded frames until it contains at
+ * least the specified number of samples. Returns the number of samples
+ * taken from the jitter buffer.
+ */
+static unsigned fill_stretch_buf(pjmedia_port *port, unsigned count)
+{
+    pjmedia_stream *stream = (pjmedia_stream*) port->port_data.pdata;
+    unsigned spf = PJMEDIA_PIA_SPF(&port->info);
+    unsigned decoded = 0;
+
+    while (stream->ts_buf_cnt < count) {
+        pjmedia_frame frame;
+
+        pj_bzero(&frame, sizeof(frame));
+        frame.buf = stream->ts_buf + stream->ts_buf_cnt;
+        frame.size = spf * BYTES_PER_SAMPLE;
+
+        get_frame(port, &frame);
+        if (frame.type != PJMEDIA_FRAME_TYPE_AUDIO)
+            break;
+
+        stream->ts_buf_cnt += spf;
+        decoded += spf;
+    }
+
+    return decoded;
+}
+
+
+/* The version of get_frame callback used when the jitter buffer runs the
+ * histogram algorithm. The jitter buffer latency is adjusted by following
+ * its time-stretching request with WSOLA, instead of discarding frames.
+ */
+static pj_status_t get_frame_stretch(pjmedia_port *port, pjmedia_frame *frame)
+{
+    pjmedia_stream *stream = (pjmedia_stream*) port->port_data.pdata;
+    pjmedia_stream_common *c_strm = &stream->base;
+    pj_int16_t *p_out_samp = (pj_int16_t*) frame->buf;
+    unsigned spf = PJMEDIA_PIA_SPF(&port->info);
+    unsigned samples_per_frame, decoded = 0;
+    pjmedia_jb_stretch stretch;
+    int frames;
+
+    samples_per_frame = stream->dec_ptime *
+                        stream->codec_param.info.clock_rate *
+                        stream->codec_param.info.channel_cnt /
+                        stream->dec_ptime_denum /
+                        1000;
+
+    pj_mutex_lock( c_strm->jb_mutex );
+    stretch = pjmedia_jbuf_get_stretch(c_strm->jb);
+    if (stretch == PJMEDIA_JB_STRETCH_COMPRESS) {
+        pjmedia_jb_state jb_state;
+
+        /* WSOLA may erase up to two frames when asked for one, so only
+         * compress when three port frames are available, otherwise the
+         * jitter buffer would run empty and PLC frames would be played.
+         * Note that a port frame may span several jitter buffer frames.
+         */
+        pjmedia_jbuf_get_state(c_strm->jb, &jb_state);
+        if (jb_state.size * samples_per_frame + stream->ts_buf_cnt <
+            spf * 3)
+        {
+            stretch = PJMEDIA_JB_STRETCH_NONE;
+        }
+    }
+    pj_mutex_unlock( c_strm->jb_mutex );
+
+    if (stretch == PJMEDIA_JB_STRETCH_EXPAND && stream->ts_has_audio &&
+        stream->ts_buf_cnt < spf)
+    {
+        /* Play a synthetic frame, the jitter buffer is left untouched */
+        pjmedia_wsola_generate(stream->wsola, p_out_samp);
+        stream->ts_expanded = PJ_TRUE;
+
+    } else {
+        if (stretch == PJMEDIA_JB_STRETCH_COMPRESS) {
+            /* Play two frames in one frame time */
+            decoded = fill_stretch_buf(port, spf * 2);
+            if (stream->ts_buf_cnt >= spf * 2) {
+                unsigned erase_cnt = spf;
+
+                if (pjmedia_wsola_discard(stream->wsola, stream->ts_buf,
+                                          stream->ts_buf_cnt, NULL, 0,
+                                          &erase_cnt) == PJ_SUCCESS)
+                {
+                    stream->ts_buf_cnt -= erase_cnt;
+                }
+            }
+        }
+        decoded += fill_stretch_buf(port, spf);
+
+        if (stream->ts_buf_cnt == 0) {
+            /* No frame at all, e.g: stream is paused or starting */
+            stream->ts_has_audio = PJ_FALSE;
+            frame->type = PJMEDIA_FRAME_TYPE_NONE;
+            frame->size = 0;
+            return PJ_SUCCESS;
+        }
+
+        if (stream->ts_buf_cnt < spf) {
+            pjmedia_zero_samples(stream->ts_buf + stream->ts_buf_cnt,
+                                 spf - stream->ts_buf_cnt);
+            stream->ts_buf_cnt = spf;
+        }
+
+        pjmedia_copy_samples(p_out_samp, stream->ts_buf, spf);
+        stream->ts_buf_cnt -= spf;
+        pjmedia_move_samples(stream->ts_buf, stream->ts_buf + spf,
+                             stream->ts_buf_cnt);
+
+        pjmedia_wsola_save(stream->wsola, p_out_samp, stream->ts_expanded);
+        stream->ts_expanded = PJ_FALSE;
+    }
+
+    stream->ts_has_audio = PJ_TRUE;
+
+    /* The jitter buffer assumes one frame is played on each GET, report
+     * the difference in whole frames.
+     */
+    stream->ts_clock_adj += (int)spf - (int)decoded;
+    frames = stream->ts_clock_adj / (int)samples_per_frame;
+    if (frames) {
+        stream->ts_clock_adj -= frames * (int)samples_per_frame;
+        pj_mutex_lock( c_strm->jb_mutex );
+        pjmedia_jbuf_report_stretch(c_strm->jb, frames);
+        pj_mutex_unlock( c_strm->jb_mutex );
+    }
+
+    frame->type = PJMEDIA_FRAME_TYPE_AUDIO;
+    frame->size = spf * BYTES_PER_SAMPLE;
+    frame->timestamp.u64 = 0;
+
+    return PJ_SUCCESS;
+}
+
+
 /* The other version of get_frame callback used when stream port format
  * is non linear PCM.
  */
@@ -1592,6 +1741,7 @@ static pj_status_t on_stream_rx_rtp(pjmedia_stream_common *c_strm,
                                     const pjmedia_rtp_hdr *hdr,
                                     const void *payload,
                                     unsigned payloadlen,
+                                    pjmedia_pkt_buf *pkt_buf,
                                     pjmedia_rtp_status seq_st,
                                     pj_bool_t *pkt_discarded)
 {
@@ -1774,9 +1924,22 @@ static pj_status_t on_stream_rx_rtp(pjmedia_stream_common *c_strm,
             pj_bool_t discarded;
 
             ext_seq = (unsigned)(frames[i].timestamp.u64 / ts_span);
-            pjmedia_jbuf_put_frame3(c_strm->jb, frames[i].buf, frames[i].size,
-                                    frames[i].bit_info, ext_seq, ts.u32.lo,
-                                    &discarded);
+
+            /* Keep a reference to the packet instead of copying the frame,
+             * unless the codec parser has put the frame elsewhere.
+             */
+            if (pkt_buf && pjmedia_pkt_buf_contains(pkt_buf, frames[i].buf,
+                                                    frames[i].size))
+            {
+                pjmedia_jbuf_put_frame_ref(c_strm->jb, pkt_buf,
+                                           frames[i].buf, frames[i].size,
+                                           frames[i].bit_info, ext_seq,
+                                           ts.u32.lo, &discarded);
+            } else {
+                pjmedia_jbuf_put_frame3(c_strm->jb, frames[i].buf,
+                                        frames[i].size, frames[i].bit_info,
+                                        ext_seq, ts.u32.lo, &discarded);
+            }
             if (discarded)
                 *pkt_discarded = PJ_TRUE;
         }
@@ -2244,6 +2407,27 @@ PJ_DEF(pj_status_t) pjmedia_stream_create( pjmedia_endpt *endpt,
     pjmedia_jbuf_set_adaptive( c_strm->jb, jb_init, jb_min_pre, jb_max_pre);
     pjmedia_jbuf_set_discard(c_strm->jb, info->jb_discard_algo);
 
+    /* Histogram algorithm adjusts the latency with time-stretching, which
+     * can only be done on linear PCM.
+     */
+    if (info->jb_discard_algo == PJMEDIA_JB_DISCARD_HISTOGRAM &&
+        c_strm->port.get_frame == &get_frame)
+    {
+        unsigned spf = PJMEDIA_PIA_SPF(&c_strm->port.info);
+
+        status = pjmedia_wsola_create(pool,
+                                      PJMEDIA_PIA_SRATE(&c_strm->port.info),
+                                      spf,
+                                      PJMEDIA_PIA_CCNT(&c_strm->port.info),
+                                      0, &stream->wsola);
+        if (status != PJ_SUCCESS)
+            goto err_cleanup;
+
+        stream->ts_buf = (pj_int16_t*)
+                         pj_pool_calloc(pool, spf * 3, sizeof(pj_int16_t));
+        c_strm->port.get_frame = &get_frame_stretch;
+    }
+
     /* buf buffer is used for sending and receiving, so lets calculate
      * its size based on both. For receiving, we have c_strm->frame_size,
      * which is used in configuring jitter buffer frame length.
@@ -2536,6 +2720,11 @@ static void on_stream_destroy(void *arg)
         pjmedia_codec_mgr_dealloc_codec(stream->codec_mgr, stream->codec);
         stream->codec = NULL;
     }
+
+    if (stream->wsola) {
+        pjmedia_wsola_destroy(stream->wsola);
+        stream->wsola = NULL;
+    }
 }
 
 
@@ -22,6 +22,7 @@ static pj_status_t on_stream_rx_rtp(pjmedia_stream_common *c_strm,
                                     const pjmedia_rtp_hdr *hdr,
                                     const void *payload,
                                     unsigned payloadlen,
+                                    pjmedia_pkt_buf *pkt_buf,
                                     pjmedia_rtp_status seq_st,
                                     pj_bool_t *pkt_discarded);
 
@@ -588,8 +589,8 @@ static void on_rx_rtp( pjmedia_tp_cb_param *param)
     }
 
     /* Pass it to specific stream for further processing. */
-    on_stream_rx_rtp(c_strm, hdr, payload, payloadlen, seq_st,
-                     &pkt_discarded);
+    on_stream_rx_rtp(c_strm, hdr, payload, payloadlen, param->pkt_buf,
+                     seq_st, &pkt_discarded);
 
 on_return:
     /* Update RTCP session */
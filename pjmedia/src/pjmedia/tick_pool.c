@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <pjmedia/tick_pool.h>
+#include <pjmedia/clock.h>
+#include <pjmedia/errno.h>
+#include <pj/assert.h>
+#include <pj/list.h>
+#include <pj/lock.h>
+#include <pj/log.h>
+#include <pj/os.h>
+#include <pj/pool.h>
+#include <pj/string.h>
+
+
+#define THIS_FILE       "tick_pool.c"
+
+
+/* A port in the tick pool. Each entry has its own pool, so that it can be
+ * released as soon as the port has been removed and is not processed.
+ */
+typedef struct tick_entry
+{
+    PJ_DECL_LIST_MEMBER(struct tick_entry);
+
+    pj_pool_t           *pool;
+    pjmedia_port        *port;
+    void                *buf;           /* Frame buffer                     */
+    unsigned             buf_size;
+    unsigned             ts_inc;        /* Timestamp increment per tick     */
+    pj_timestamp         ts;            /* Timestamp of the next frame      */
+
+    pj_bool_t            busy;          /* Queued or being processed        */
+    pj_thread_t         *thread;        /* Thread processing the port       */
+    pj_bool_t            removed;       /* Port has been removed            */
+    pj_bool_t            orphan;        /* Removed by its own get_frame(),
+                                           to be released by the worker     */
+    unsigned             overrun;       /* Number of skipped ticks          */
+    struct tick_entry   *next_ready;    /* Next entry in the ready queue    */
+} tick_entry;
+
+
+struct pjmedia_tick_pool
+{
+    pj_pool_t           *pool;
+    unsigned             ptime_usec;
+    pjmedia_clock       *clock;
+    pj_lock_t           *lock;
+    pj_sem_t            *sem;           /* Count of queued entries          */
+    unsigned             worker_cnt;
+    pj_thread_t        **workers;
+    pj_bool_t            quit;
+
+    tick_entry           ports;         /* List of the ports                */
+    tick_entry          *ready_head;    /* Queue of the ports to process    */
+    tick_entry          *ready_tail;
+};
+
+
+static void clock_callback(const pj_timestamp *ts, void *user_data);
+static int worker_thread(void *arg);
+
+
+PJ_DEF(void) pjmedia_tick_pool_param_default(pjmedia_tick_pool_param *param)
+{
+    pj_bzero(param, sizeof(*param));
+    param->ptime_usec = 20000;
+    param->worker_cnt = PJMEDIA_TICK_POOL_WORKERS;
+}
+
+
+/*
+ * Create and start a tick pool.
+ */
+PJ_DEF(pj_status_t) pjmedia_tick_pool_create(
+                                        pj_pool_t *pool,
+                                        const pjmedia_tick_pool_param *param,
+                                        pjmedia_tick_pool **p_tp)
+{
+    pjmedia_tick_pool *tp;
+    pjmedia_clock_param cparam;
+    unsigned i;
+    pj_status_t status;
+
+    PJ_ASSERT_RETURN(pool && param && p_tp, PJ_EINVAL);
+    PJ_ASSERT_RETURN(param->ptime_usec && param->worker_cnt, PJ_EINVAL);
+
+    tp = PJ_POOL_ZALLOC_T(pool, pjmedia_tick_pool);
+    tp->pool = pool;
+    tp->ptime_usec = param->ptime_usec;
+    pj_list_init(&tp->ports);
+
+    status = pj_lock_create_simple_mutex(pool, "tickpool", &tp->lock);
+    if (status != PJ_SUCCESS)
+        goto on_error;
+
+    status = pj_sem_create(pool, "tickpool", 0, 0x7FFFFFFF, &tp->sem);
+    if (status != PJ_SUCCESS)
+        goto on_error;
+
+    tp->workers = (pj_thread_t**)
+                  pj_pool_calloc(pool, param->worker_cnt,
+                                 sizeof(pj_thread_t*));
+    for (i = 0; i < param->worker_cnt; ++i) {
+        status = pj_thread_create(pool, "tickpool%p", &worker_thread, tp,
+                                  0, 0, &tp->workers[i]);
+        if (status != PJ_SUCCESS)
+            goto on_error;
+        ++tp->worker_cnt;
+    }
+
+    /* The clock rate only sets the timestamp of the callback, which
+     * is not used.
+     */
+    cparam.usec_interval = param->ptime_usec;
+    cparam.clock_rate = 1000000;
+    status = pjmedia_clock_create2(pool, &cparam, param->clock_options,
+                                   &clock_callback, tp, &tp->clock);
+    if (status != PJ_SUCCESS)
+        goto on_error;
+
+    status = pjmedia_clock_start(tp->clock);
+    if (status != PJ_SUCCESS)
+        goto on_error;
+
+    PJ_LOG(5,(THIS_FILE, "Tick pool created, ptime=%uus, %u workers",
+              tp->ptime_usec, tp->worker_cnt));
+
+    *p_tp = tp;
+    return PJ_SUCCESS;
+
+on_error:
+    pjmedia_tick_pool_destroy(tp);
+    return status;
+}
+
+
+/*
+ * Add a port.
+ */
+PJ_DEF(pj_status_t) pjmedia_tick_pool_add_port(pjmedia_tick_pool *tp,
+                                               pjmedia_port *port)
+{
+    pj_pool_t *pool;
+    tick_entry *e;
+
+    PJ_ASSERT_RETURN(tp && port, PJ_EINVAL);
+    PJ_ASSERT_RETURN(port->info.fmt.type == PJMEDIA_TYPE_AUDIO,
+                     PJMEDIA_EBADFMT);
+
+    /* The port is called once per tick */
+    if (port->info.fmt.det.aud.frame_time_usec != tp->ptime_usec)
+        return PJMEDIA_ENCSAMPLESPFRAME;
+
+    pool = pj_pool_create(tp->pool->factory, "tickport%p", 256, 256, NULL);
+    if (!pool)
+        return PJ_ENOMEM;
+
+    e = PJ_POOL_ZALLOC_T(pool, tick_entry);
+    e->pool = pool;
+    e->port = port;
+    e->buf_size = PJMEDIA_PIA_AVG_FSZ(&port->info);
+    e->buf = pj_pool_alloc(pool, e->buf_size);
+    e->ts_inc = PJMEDIA_PIA_SPF(&port->info);
+
+    pj_lock_acquire(tp->lock);
+    pj_list_push_back(&tp->ports, e);
+    pj_lock_release(tp->lock);
+
+    PJ_LOG(5,(THIS_FILE, "Port %.*s added to tick pool",
+              (int)port->info.name.slen, port->info.name.ptr));
+
+    return PJ_SUCCESS;
+}
+
+
+/*
+ * Remove a port.
+ */
+PJ_DEF(pj_status_t) pjmedia_tick_pool_remove_port(pjmedia_tick_pool *tp,
+                                                  pjmedia_port *port)
+{
+    tick_entry *e;
+
+    PJ_ASSERT_RETURN(tp && port, PJ_EINVAL);
+
+    pj_lock_acquire(tp->lock);
+
+    e = tp->ports.next;
+    while (e != &tp->ports && e->port != port)
+        e = e->next;
+
+    if (e == &tp->ports) {
+        pj_lock_release(tp->lock);
+        return PJ_ENOTFOUND;
+    }
+
+    pj_list_erase(e);
+    e->removed = PJ_TRUE;
+
+    /* Called by the port's own get_frame(), let the worker release it */
+    if (e->busy && e->thread == pj_thread_this()) {
+        e->orphan = PJ_TRUE;
+        pj_lock_release(tp->lock);
+        return PJ_SUCCESS;
+    }
+
+    /* Wait until the port is no longer queued or being processed */
+    while (e->busy) {
+        pj_lock_release(tp->lock);
+        pj_thread_sleep(1);
+        pj_lock_acquire(tp->lock);
+    }
+
+    pj_lock_release(tp->lock);
+
+    PJ_LOG(5,(THIS_FILE, "Port %.*s removed from tick pool (%u overruns)",
+              (int)port->info.name.slen, port->info.name.ptr, e->overrun));
+
+    pj_pool_release(e->pool);
+
+    return PJ_SUCCESS;
+}
+
+
+/*
+ * Destroy the tick pool.
+ */
+PJ_DEF(pj_status_t) pjmedia_tick_pool_destroy(pjmedia_tick_pool *tp)
+{
+    unsigned i;
+
+    PJ_ASSERT_RETURN(tp, PJ_EINVAL);
+
+    if (tp->clock) {
+        pjmedia_clock_destroy(tp->clock);
+        tp->clock = NULL;
+    }
+
+    /* Stop the workers */
+    tp->quit = PJ_TRUE;
+    for (i = 0; i < tp->worker_cnt; ++i)
+        pj_sem_post(tp->sem);
+    for (i = 0; i < tp->worker_cnt; ++i) {
+        pj_thread_join(tp->workers[i]);
+        pj_thread_destroy(tp->workers[i]);
+    }
+    tp->worker_cnt = 0;
+
+    /* Release the ports left in the pool */
+    while (!pj_list_empty(&tp->ports)) {
+        tick_entry *e = tp->ports.next;
+
+        pj_list_erase(e);
+        pj_pool_release(e->pool);
+    }
+
+    if (tp->sem) {
+        pj_sem_destroy(tp->sem);
+        tp->sem = NULL;
+    }
+    if (tp->lock) {
+        pj_lock_destroy(tp->lock);
+        tp->lock = NULL;
+    }
+
+    return PJ_SUCCESS;
+}
+
+
+/*
+ * Clock tick: queue all ports that are not still busy from the previous
+ * ticks. This never waits for the ports to be processed.
+ */
+static void clock_callback(const pj_timestamp *ts, void *user_data)
+{
+    pjmedia_tick_pool *tp = (pjmedia_tick_pool*) user_data;
+    tick_entry *e;
+    unsigned cnt = 0;
+
+    PJ_UNUSED_ARG(ts);
+
+    pj_lock_acquire(tp->lock);
+
+    for (e = tp->ports.next; e != &tp->ports; e = e->next) {
+        if (e->busy) {
+            if (e->overrun++ == 0) {
+                PJ_LOG(4,(THIS_FILE, "Port %.*s is too slow for the tick "
+                          "pool, skipping ticks",
+                          (int)e->port->info.name.slen,
+                          e->port->info.name.ptr));
+            }
+            continue;
+        }
+
+        e->busy = PJ_TRUE;
+        e->next_ready = NULL;
+        if (tp->ready_tail)
+            tp->ready_tail->next_ready = e;
+        else
+            tp->ready_head = e;
+        tp->ready_tail = e;
+        ++cnt;
+    }
+
+    pj_lock_release(tp->lock);
+
+    while (cnt--)
+        pj_sem_post(tp->sem);
+}
+
+
+/*
+ * Worker thread: process the queued ports.
+ */
+static int worker_thread(void *arg)
+{
+    pjmedia_tick_pool *tp = (pjmedia_tick_pool*) arg;
+
+    for (;;) {
+        pjmedia_frame frame;
+        tick_entry *e;
+        pj_bool_t release;
+
+        pj_sem_wait(tp->sem);
+        if (tp->quit)
+            break;
+
+        pj_lock_acquire(tp->lock);
+        e = tp->ready_head;
+        if (e) {
+            tp->ready_head = e->next_ready;
+            if (!tp->ready_head)
+                tp->ready_tail = NULL;
+
+            if (e->removed) {
+                /* The remover is waiting for the entry to be idle */
+                e->busy = PJ_FALSE;
+                e = NULL;
+            } else {
+                e->thread = pj_thread_this();
+            }
+        }
+        pj_lock_release(tp->lock);
+
+        if (!e)
+            continue;
+
+        frame.type = PJMEDIA_FRAME_TYPE_AUDIO;
+        frame.buf = e->buf;
+        frame.size = e->buf_size;
+        frame.timestamp = e->ts;
+        frame.bit_info = 0;
+        pjmedia_port_get_frame(e->port, &frame);
+        e->ts.u64 += e->ts_inc;
+
+        pj_lock_acquire(tp->lock);
+        e->busy = PJ_FALSE;
+        e->thread = NULL;
+        release = e->orphan;
+        pj_lock_release(tp->lock);
+
+        if (release)
+            pj_pool_release(e->pool);
+    }
+
+    return 0;
+}
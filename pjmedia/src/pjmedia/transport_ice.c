@@ -2624,6 +2624,7 @@ static void ice_on_rx_data(pj_ice_strans *ice_st, unsigned comp_id,
                 param.src_addr = (tp_ice->use_ice? NULL:
                                   (pj_sockaddr_t *)src_addr);
                 param.rem_switch = PJ_FALSE;
+                param.pkt_buf = NULL;
                 (*rtp_cb2)(&param);
                 rem_switch = param.rem_switch;
             } else {
@@ -267,7 +267,11 @@ typedef struct transport_srtp
 {
     pjmedia_transport    base;              /**< Base transport interface.  */
     pj_pool_t           *pool;              /**< Pool for transport SRTP.   */
-    pj_lock_t           *mutex;             /**< Mutex for libsrtp contexts.*/
+    pj_lock_t           *mutex;             /**< Mutex for the session and
+                                                 RX libsrtp contexts.       */
+    pj_lock_t           *tx_mutex;          /**< Mutex for TX libsrtp
+                                                 contexts and TX buffers,
+                                                 acquired after mutex.      */
     char                 rtp_tx_buffer[MAX_RTP_BUFFER_LEN];
     char                 rtcp_tx_buffer[MAX_RTCP_BUFFER_LEN];
     pjmedia_srtp_setting setting;
@@ -567,7 +571,7 @@ PJ_DEF(pj_status_t) pjmedia_srtp_init_lib(pjmedia_endpt *endpt)
 #endif
 
 #if defined(PJMEDIA_SRTP_HAS_DTLS) && (PJMEDIA_SRTP_HAS_DTLS != 0)
-    dtls_init();
+    dtls_init(endpt);
 #endif
 
     status = pjmedia_endpt_atexit(endpt, pjmedia_srtp_deinit_lib);
@@ -844,6 +848,17 @@ PJ_DEF(pj_status_t) pjmedia_transport_srtp_create(
         return status;
     }
 
+    /* Sending only takes the TX mutex, so it does not contend with the
+     * receiving thread.
+     */
+    status = pj_lock_create_simple_mutex(pool, pool->obj_name,
+                                         &srtp->tx_mutex);
+    if (status != PJ_SUCCESS) {
+        pj_lock_destroy(srtp->mutex);
+        pj_pool_release(pool);
+        return status;
+    }
+
     /* Initialize base pjmedia_transport */
     pj_memcpy(srtp->base.name, pool->obj_name, PJ_MAX_OBJ_NAME);
     if (tp)
@@ -945,6 +960,7 @@ static pj_status_t create_srtp_ctx(transport_srtp *srtp,
     pj_status_t      status = PJ_SUCCESS;
 
     pj_lock_acquire(srtp->mutex);
+    pj_lock_acquire(srtp->tx_mutex);
 
     if (ctx->srtp_tx_ctx || ctx->srtp_rx_ctx)
         destroy_srtp_ctx(srtp, ctx);
@@ -1130,6 +1146,7 @@ static pj_status_t create_srtp_ctx(transport_srtp *srtp,
 #endif
 
 on_return:
+    pj_lock_release(srtp->tx_mutex);
     pj_lock_release(srtp->mutex);
     return status;
 }
@@ -1155,12 +1172,14 @@ PJ_DEF(pj_status_t) pjmedia_transport_srtp_start(
 
     status = create_srtp_ctx(srtp, &srtp->srtp_ctx, &srtp->setting, tx, rx);
     if (status == PJ_SUCCESS) {
+        pj_lock_acquire(srtp->tx_mutex);
         if (srtp->srtp_ctx.srtp_tx_ctx && srtp->srtp_ctx.srtp_rx_ctx) {
             /* Declare SRTP session initialized */
             srtp->session_inited = PJ_TRUE;
         } else {
             srtp->bypass_srtp = PJ_TRUE;
         }
+        pj_lock_release(srtp->tx_mutex);
     }
 
     pj_lock_release(srtp->mutex);
@@ -1212,10 +1231,12 @@ PJ_DEF(pj_status_t) pjmedia_transport_srtp_stop(pjmedia_transport *srtp)
         return PJ_SUCCESS;
     }
 
+    pj_lock_acquire(p_srtp->tx_mutex);
     destroy_srtp_ctx(p_srtp, &p_srtp->srtp_ctx);
     destroy_srtp_ctx(p_srtp, &p_srtp->srtp_rtcp);
 
     p_srtp->session_inited = PJ_FALSE;
+    pj_lock_release(p_srtp->tx_mutex);
 
     pj_lock_release(p_srtp->mutex);
 
@@ -1415,6 +1436,33 @@ static void transport_detach(pjmedia_transport *tp, void *strm)
     srtp->member_tp_attached = PJ_FALSE;
 }
 
+/* Protect an outgoing RTP packet in place. The TX mutex must be held and
+ * the session must have been initialized.
+ */
+static srtp_err_status_t protect_rtp(transport_srtp *srtp,
+                                     void *pkt,
+                                     int *len)
+{
+    /* Save outgoing SSRC */
+    srtp->tx_ssrc = ntohl(((pjmedia_rtp_hdr*)pkt)->ssrc);
+
+#if TEST_ROC
+    if (srtp->setting.tx_roc.ssrc == 0) {
+        srtp_err_status_t status;
+        status = srtp_set_stream_roc(srtp->srtp_ctx.srtp_tx_ctx, srtp->tx_ssrc,
+                                     (srtp->offerer_side? 1: 2));
+        if (status == srtp_err_status_ok) {
+            srtp->setting.tx_roc.ssrc = srtp->tx_ssrc;
+            srtp->setting.tx_roc.roc = (srtp->offerer_side? 1: 2);
+            PJ_LOG(4, (THIS_FILE, "Setting TX ROC to SSRC %u to %d",
+                   srtp->tx_ssrc, srtp->setting.tx_roc.roc));
+        }
+    }
+#endif
+
+    return srtp_protect(srtp->srtp_ctx.srtp_tx_ctx, pkt, len);
+}
+
 static pj_status_t transport_send_rtp( pjmedia_transport *tp,
                                        const void *pkt,
                                        pj_size_t size)
@@ -1430,33 +1478,15 @@ static pj_status_t transport_send_rtp( pjmedia_transport *tp,
     if (size > sizeof(srtp->rtp_tx_buffer) - MAX_TRAILER_LEN)
         return PJ_ETOOBIG;
 
-    pj_memcpy(srtp->rtp_tx_buffer, pkt, size);
-
-    pj_lock_acquire(srtp->mutex);
+    pj_lock_acquire(srtp->tx_mutex);
     if (!srtp->session_inited) {
-        pj_lock_release(srtp->mutex);
+        pj_lock_release(srtp->tx_mutex);
         return PJMEDIA_SRTP_EKEYNOTREADY;
     }
 
-    /* Save outgoing SSRC */
-    srtp->tx_ssrc = ntohl(((pjmedia_rtp_hdr*)pkt)->ssrc);
-
-#if TEST_ROC
-    if (srtp->setting.tx_roc.ssrc == 0) {
-        srtp_err_status_t status;
-        status = srtp_set_stream_roc(srtp->srtp_ctx.srtp_tx_ctx, srtp->tx_ssrc,
-                                     (srtp->offerer_side? 1: 2));
-        if (status == srtp_err_status_ok) {
-            srtp->setting.tx_roc.ssrc = srtp->tx_ssrc;
-            srtp->setting.tx_roc.roc = (srtp->offerer_side? 1: 2);
-            PJ_LOG(4, (THIS_FILE, "Setting TX ROC to SSRC %u to %d",
-                   srtp->tx_ssrc, srtp->setting.tx_roc.roc));
-        }
-    }
-#endif
-
-    err = srtp_protect(srtp->srtp_ctx.srtp_tx_ctx, srtp->rtp_tx_buffer, &len);
-    pj_lock_release(srtp->mutex);
+    pj_memcpy(srtp->rtp_tx_buffer, pkt, size);
+    err = protect_rtp(srtp, srtp->rtp_tx_buffer, &len);
+    pj_lock_release(srtp->tx_mutex);
 
     if (err == srtp_err_status_ok) {
         status = pjmedia_transport_send_rtp(srtp->member_tp,
@@ -1494,18 +1524,17 @@ static pj_status_t transport_send_rtcp2(pjmedia_transport *tp,
     if (size > sizeof(srtp->rtcp_tx_buffer) - (MAX_TRAILER_LEN+4))
         return PJ_ETOOBIG;
 
-    pj_memcpy(srtp->rtcp_tx_buffer, pkt, size);
-
-    pj_lock_acquire(srtp->mutex);
+    pj_lock_acquire(srtp->tx_mutex);
     if (!srtp->session_inited) {
-        pj_lock_release(srtp->mutex);
+        pj_lock_release(srtp->tx_mutex);
         return PJMEDIA_SRTP_EKEYNOTREADY;
     }
+    pj_memcpy(srtp->rtcp_tx_buffer, pkt, size);
     err = srtp_protect_rtcp(srtp->srtp_rtcp.srtp_tx_ctx?
                             srtp->srtp_rtcp.srtp_tx_ctx:
                             srtp->srtp_ctx.srtp_tx_ctx,
                             srtp->rtcp_tx_buffer, &len);
-    pj_lock_release(srtp->mutex);
+    pj_lock_release(srtp->tx_mutex);
 
     if (err == srtp_err_status_ok) {
         status = pjmedia_transport_send_rtcp2(srtp->member_tp, addr, addr_len,
@@ -1537,6 +1566,7 @@ static void srtp_on_destroy(void *arg)
 
     PJ_LOG(4, (srtp->pool->obj_name, "SRTP transport destroyed"));
 
+    pj_lock_destroy(srtp->tx_mutex);
     pj_lock_destroy(srtp->mutex);
     pj_pool_safe_release(&srtp->pool);
 }
@@ -1581,6 +1611,8 @@ static pj_status_t transport_destroy  (pjmedia_transport *tp)
          * transport does not provide a group lock.
          */
         pj_lock_acquire(srtp->mutex);
+        pj_lock_acquire(srtp->tx_mutex);
+        pj_lock_release(srtp->tx_mutex);
         pj_lock_release(srtp->mutex);
 
         srtp_on_destroy(srtp);
@@ -2269,4 +2301,143 @@ PJ_DEF(pj_status_t) pjmedia_transport_srtp_decrypt_pkt(pjmedia_transport *tp,
                                        PJMEDIA_ERRNO_FROM_LIBSRTP(err);
 }
 
+
+/* Check a packet of a batch, return NULL if it does not need processing */
+static transport_srtp *check_batch_pkt(pjmedia_srtp_batch_pkt *p,
+                                       int room)
+{
+    transport_srtp *srtp = (transport_srtp*) p->tp;
+
+    if (!srtp || !p->pkt || p->len <= 0 || (((pj_ssize_t)p->pkt) & 0x03)) {
+        p->status = PJ_EINVAL;
+        return NULL;
+    }
+
+    p->status = PJ_SUCCESS;
+    if (srtp->bypass_srtp)
+        return NULL;
+
+    if (p->buf_size - p->len < room) {
+        p->status = PJ_ETOOBIG;
+        return NULL;
+    }
+
+    return srtp;
+}
+
+
+/* Switch the lock held during a batch to the lock of another transport */
+static void switch_batch_lock(pj_lock_t **locked, pj_lock_t *lock)
+{
+    if (*locked == lock)
+        return;
+
+    if (*locked)
+        pj_lock_release(*locked);
+    if (lock)
+        pj_lock_acquire(lock);
+    *locked = lock;
+}
+
+
+/*
+ * Protect a batch of RTP packets.
+ */
+PJ_DEF(pj_status_t) pjmedia_transport_srtp_protect_batch(
+                                            pjmedia_srtp_batch_pkt pkts[],
+                                            unsigned count,
+                                            pj_bool_t send)
+{
+    pj_lock_t *locked = NULL;
+    pj_status_t status = PJ_SUCCESS;
+    unsigned i;
+
+    PJ_ASSERT_RETURN(pkts || count == 0, PJ_EINVAL);
+
+    /* Run all the crypto first, so that the lock of a transport is only
+     * taken once for consecutive packets and no lock is held while
+     * sending.
+     */
+    for (i = 0; i < count; ++i) {
+        pjmedia_srtp_batch_pkt *p = &pkts[i];
+        transport_srtp *srtp;
+        srtp_err_status_t err;
+
+        srtp = check_batch_pkt(p, PJMEDIA_SRTP_MAX_TAG_LEN);
+        if (!srtp)
+            continue;
+
+        switch_batch_lock(&locked, srtp->tx_mutex);
+        if (!srtp->session_inited) {
+            p->status = PJMEDIA_SRTP_EKEYNOTREADY;
+            continue;
+        }
+
+        err = protect_rtp(srtp, p->pkt, &p->len);
+        if (err != srtp_err_status_ok)
+            p->status = PJMEDIA_ERRNO_FROM_LIBSRTP(err);
+    }
+    switch_batch_lock(&locked, NULL);
+
+    for (i = 0; i < count; ++i) {
+        pjmedia_srtp_batch_pkt *p = &pkts[i];
+
+        if (send && p->status == PJ_SUCCESS) {
+            transport_srtp *srtp = (transport_srtp*) p->tp;
+            p->status = pjmedia_transport_send_rtp(srtp->member_tp, p->pkt,
+                                                  p->len);
+        }
+        if (status == PJ_SUCCESS)
+            status = p->status;
+    }
+
+    return status;
+}
+
+
+/*
+ * Unprotect a batch of RTP packets.
+ */
+PJ_DEF(pj_status_t) pjmedia_transport_srtp_unprotect_batch(
+                                            pjmedia_srtp_batch_pkt pkts[],
+                                            unsigned count)
+{
+    pj_lock_t *locked = NULL;
+    pj_status_t status = PJ_SUCCESS;
+    unsigned i;
+
+    PJ_ASSERT_RETURN(pkts || count == 0, PJ_EINVAL);
+
+    for (i = 0; i < count; ++i) {
+        pjmedia_srtp_batch_pkt *p = &pkts[i];
+        transport_srtp *srtp;
+        srtp_err_status_t err;
+
+        srtp = check_batch_pkt(p, 0);
+        if (!srtp)
+            goto on_next;
+
+        switch_batch_lock(&locked, srtp->mutex);
+        if (!srtp->session_inited) {
+            p->status = PJ_EINVALIDOP;
+            goto on_next;
+        }
+
+        err = srtp_unprotect(srtp->srtp_ctx.srtp_rx_ctx, p->pkt, &p->len);
+        if (err != srtp_err_status_ok) {
+            PJ_LOG(5,(srtp->pool->obj_name,
+                      "Failed to unprotect SRTP, pkt size=%d, err=%s",
+                      p->len, get_libsrtp_errstr(err)));
+            p->status = PJMEDIA_ERRNO_FROM_LIBSRTP(err);
+        }
+
+on_next:
+        if (status == PJ_SUCCESS)
+            status = p->status;
+    }
+    switch_batch_lock(&locked, NULL);
+
+    return status;
+}
+
 #endif
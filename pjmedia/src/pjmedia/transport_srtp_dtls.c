@@ -140,6 +140,7 @@ typedef struct dtls_srtp
                                                the SRTP once the nego done  */
     pj_bool_t            is_destroying;     /* DTLS being destroyed?        */
     pj_bool_t            got_keys;          /* DTLS nego done & keys ready  */
+    unsigned             worker_idx;        /* Handshake worker index       */
     pjmedia_srtp_crypto  tx_crypto[NUM_CHANNEL];
     pjmedia_srtp_crypto  rx_crypto[NUM_CHANNEL];
 
@@ -193,12 +194,105 @@ static unsigned valid_profiles_cnt;
 static X509     *dtls_cert;
 static EVP_PKEY *dtls_priv_key;
 static pj_status_t ssl_generate_cert(X509 **p_cert, EVP_PKEY **p_priv_key);
+static pj_status_t ssl_get_fingerprint(X509 *cert, pj_bool_t is_sha256,
+                                       char *buf, pj_size_t *buf_len);
+
+/* Fingerprints of the certificate, for SDP a=fingerprint */
+static char      dtls_fp_sha256[128];
+static pj_size_t dtls_fp_sha256_len;
+static char      dtls_fp_sha1[128];
+static pj_size_t dtls_fp_sha1_len;
+
+/* Pool and lock for the states shared by all DTLS-SRTP instances */
+static pj_pool_t *dtls_pool;
+static pj_lock_t *dtls_lock;
+
+/* DTLS contexts, shared by the instances using the same SRTP profiles.
+ * OpenSSL prior to 1.1.0 cannot reference count SSL_CTX, so there each
+ * instance has its own context.
+ */
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+#   define DTLS_SHARE_CTX       1
+#else
+#   define DTLS_SHARE_CTX       0
+#endif
+#define DTLS_CTX_CACHE_SIZE     4
+
+typedef struct dtls_shared_ctx
+{
+    char                 profiles[OPENSSL_PROFILE_NUM*25];
+    SSL_CTX             *ctx;
+} dtls_shared_ctx;
+
+#if DTLS_SHARE_CTX
+static dtls_shared_ctx dtls_ctx_cache[DTLS_CTX_CACHE_SIZE];
+#endif
+
+/* Client sessions for resumption, by the remote certificate fingerprint */
+#if PJMEDIA_SRTP_DTLS_SESSION_RESUMPTION
+#define DTLS_SESS_ID_CTX        "pjmedia-dtls-srtp"
+
+typedef struct dtls_session
+{
+    char                 rem_fp[128];
+    SSL_SESSION         *sess;
+    pj_uint32_t          last_used;
+} dtls_session;
+
+static dtls_session dtls_sessions[PJMEDIA_SRTP_DTLS_SESSION_CACHE_SIZE];
+static pj_uint32_t  dtls_session_clock;
+#endif
+
+/* Handshake workers */
+#if PJMEDIA_SRTP_DTLS_WORKER_CNT > 0
+typedef struct dtls_job
+{
+    dtls_srtp           *ds;
+    unsigned             idx;
+    pj_size_t            len;
+    char                 pkt[PJMEDIA_MAX_MRU];
+} dtls_job;
+
+typedef struct dtls_worker
+{
+    pj_thread_t         *thread;
+    pj_sem_t            *sem;
+    pj_lock_t           *lock;
+    unsigned             head;
+    unsigned             cnt;
+    dtls_job             jobs[PJMEDIA_SRTP_DTLS_WORKER_QUEUE_LEN];
+} dtls_worker;
+
+static dtls_worker *dtls_workers;
+static pj_bool_t    dtls_workers_quit;
+static pj_bool_t    dtls_workers_disabled;
+static unsigned     dtls_next_worker;
+
+static void dtls_destroy_workers(dtls_worker *workers);
+#endif
 
 /* Forward declaration */
 static void dtls_media_stop_channel(dtls_srtp* ds, unsigned idx);
 
-static pj_status_t dtls_init()
+static pj_status_t dtls_init(pjmedia_endpt *endpt)
 {
+    /* Create pool and lock for the shared states */
+    if (!dtls_pool) {
+        pj_status_t status;
+
+        dtls_pool = pjmedia_endpt_create_pool(endpt, "dtls_shared",
+                                              1000, 1000);
+        if (!dtls_pool)
+            return PJ_ENOMEM;
+
+        status = pj_lock_create_simple_mutex(dtls_pool, "dtls_shared",
+                                             &dtls_lock);
+        if (status != PJ_SUCCESS) {
+            pj_pool_safe_release(&dtls_pool);
+            return status;
+        }
+    }
+
     /* Make sure OpenSSL library has been initialized */
     {
         pj_ssl_cipher ciphers[1];
@@ -217,6 +311,26 @@ static pj_status_t dtls_init()
         }
     }
 
+    /* Calculate the cert fingerprints, they are the same for all calls */
+    if (!dtls_fp_sha256_len) {
+        pj_status_t status;
+
+        dtls_fp_sha1_len = sizeof(dtls_fp_sha1);
+        status = ssl_get_fingerprint(dtls_cert, PJ_FALSE, dtls_fp_sha1,
+                                     &dtls_fp_sha1_len);
+        if (status == PJ_SUCCESS) {
+            dtls_fp_sha256_len = sizeof(dtls_fp_sha256);
+            status = ssl_get_fingerprint(dtls_cert, PJ_TRUE, dtls_fp_sha256,
+                                         &dtls_fp_sha256_len);
+        }
+        if (status != PJ_SUCCESS) {
+            dtls_fp_sha1_len = dtls_fp_sha256_len = 0;
+            pj_perror(4, "DTLS-SRTP", status,
+                      "Failed getting DTLS certificate fingerprint");
+            return status;
+        }
+    }
+
     if (valid_profiles_cnt == 0) {
         unsigned n, j;
         int rc;
@@ -259,6 +373,35 @@ static pj_status_t dtls_init()
 
 static void dtls_deinit()
 {
+    unsigned i;
+
+#if PJMEDIA_SRTP_DTLS_WORKER_CNT > 0
+    if (dtls_workers) {
+        dtls_destroy_workers(dtls_workers);
+        dtls_workers = NULL;
+    }
+    dtls_workers_disabled = PJ_FALSE;
+#endif
+
+#if DTLS_SHARE_CTX
+    for (i = 0; i < PJ_ARRAY_SIZE(dtls_ctx_cache); ++i) {
+        if (dtls_ctx_cache[i].ctx)
+            SSL_CTX_free(dtls_ctx_cache[i].ctx);
+    }
+    pj_bzero(dtls_ctx_cache, sizeof(dtls_ctx_cache));
+#endif
+
+#if PJMEDIA_SRTP_DTLS_SESSION_RESUMPTION
+    for (i = 0; i < PJ_ARRAY_SIZE(dtls_sessions); ++i) {
+        if (dtls_sessions[i].sess)
+            SSL_SESSION_free(dtls_sessions[i].sess);
+    }
+    pj_bzero(dtls_sessions, sizeof(dtls_sessions));
+#endif
+
+    PJ_UNUSED_ARG(i);
+    dtls_fp_sha256_len = dtls_fp_sha1_len = 0;
+
     if (dtls_cert) {
         X509_free(dtls_cert);
         dtls_cert = NULL;
@@ -268,6 +411,29 @@ static void dtls_deinit()
     }
 
     valid_profiles_cnt = 0;
+
+    if (dtls_lock) {
+        pj_lock_destroy(dtls_lock);
+        dtls_lock = NULL;
+    }
+    pj_pool_safe_release(&dtls_pool);
+}
+
+/* Get fingerprint of our certificate, see ssl_get_fingerprint() */
+static pj_status_t get_local_fingerprint(pj_bool_t is_sha256,
+                                         char *buf, pj_size_t *buf_len)
+{
+    const char *fp = is_sha256? dtls_fp_sha256 : dtls_fp_sha1;
+    pj_size_t len = is_sha256? dtls_fp_sha256_len : dtls_fp_sha1_len;
+
+    if (len == 0)
+        return PJ_EINVALIDOP;
+    if (*buf_len < len + 1)
+        return PJ_ETOOSMALL;
+
+    pj_memcpy(buf, fp, len + 1);
+    *buf_len = len;
+    return PJ_SUCCESS;
 }
 
 
@@ -290,6 +456,15 @@ static pj_status_t dtls_create(transport_srtp *srtp,
     ds->base.user_data = srtp;
     ds->srtp = srtp;
 
+#if PJMEDIA_SRTP_DTLS_WORKER_CNT > 0
+    /* Spread the instances over the handshake workers */
+    if (dtls_lock) {
+        pj_lock_acquire(dtls_lock);
+        ds->worker_idx = dtls_next_worker++ % PJMEDIA_SRTP_DTLS_WORKER_CNT;
+        pj_lock_release(dtls_lock);
+    }
+#endif
+
     /* Setup group lock handler for destroy and callback synchronization */
     if (srtp->base.grp_lock) {
         pj_grp_lock_t *grp_lock = srtp->base.grp_lock;
@@ -540,56 +715,25 @@ on_error:
     return PJ_EUNKNOWN;
 }
 
-/* Create and initialize new SSL context and instance */
-static pj_status_t ssl_create(dtls_srtp *ds, unsigned idx)
+/* Create DTLS context for the SRTP profiles, e.g: "SRTP_AES128_CM_SHA1_80" */
+static pj_status_t ssl_ctx_create(dtls_srtp *ds, const char *profiles,
+                                  SSL_CTX **p_ctx)
 {
     SSL_CTX *ctx;
-    unsigned i;
-    int mode, rc;
+    int rc;
 
-    /* Check if it is already instantiated */
-    if (ds->ossl_ssl[idx])
-        return PJ_SUCCESS;
-
-    /* Create DTLS context */
     ctx = SSL_CTX_new(DTLS_method());
     if (ctx == NULL) {
         return GET_SSL_STATUS(ds);
     }
 
-    if (valid_profiles_cnt == 0) {
-        SSL_CTX_free(ctx);
-        return PJMEDIA_SRTP_DTLS_ENOPROFILE;
-    }
-
     /* Set crypto */
-    if (1) {
-        char *p, *end, buf[PJ_ARRAY_SIZE(ossl_profiles)*25];
-        unsigned n;
-
-        p = buf;
-        end = buf + sizeof(buf);
-        for (i=0; i<ds->srtp->setting.crypto_count && p < end; ++i) {
-            pjmedia_srtp_crypto *crypto = &ds->srtp->setting.crypto[i];
-            unsigned j;
-            for (j=0; j < valid_profiles_cnt; ++j) {
-                if (!pj_ansi_strcmp(crypto->name.ptr,
-                                    valid_pj_profiles_list[j]))
-                {
-                    n = pj_ansi_snprintf(p, end-p, ":%s",
-                                         valid_ossl_profiles_list[j]);
-                    p += n;
-                    break;
-                }
-            }
-
-        }
-        rc = SSL_CTX_set_tlsext_use_srtp(ctx, buf+1);
-        PJ_LOG(4,(ds->base.name, "Setting crypto [%s], errcode=%d", buf, rc));
-        if (rc != 0) {
-            SSL_CTX_free(ctx);
-            return GET_SSL_STATUS(ds);
-        }
+    rc = SSL_CTX_set_tlsext_use_srtp(ctx, profiles);
+    PJ_LOG(4,(ds->base.name, "Setting crypto [:%s], errcode=%d", profiles,
+              rc));
+    if (rc != 0) {
+        SSL_CTX_free(ctx);
+        return GET_SSL_STATUS(ds);
     }
 
     /* Set ciphers */
@@ -603,11 +747,108 @@ static pj_status_t ssl_create(dtls_srtp *ds, unsigned idx)
     rc = SSL_CTX_check_private_key(ctx);
     pj_assert(rc);
 
+#if PJMEDIA_SRTP_DTLS_SESSION_RESUMPTION
+    /* Server side session cache and tickets. The client side sessions are
+     * kept by us, see ssl_save_session().
+     */
+    SSL_CTX_set_session_id_context(ctx,
+                                   (const unsigned char*)DTLS_SESS_ID_CTX,
+                                   sizeof(DTLS_SESS_ID_CTX)-1);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+#else
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+    SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+#endif
+
+    *p_ctx = ctx;
+    return PJ_SUCCESS;
+}
+
+/* Get DTLS context for the SRTP cryptos setting of the instance */
+static pj_status_t ssl_get_ctx(dtls_srtp *ds, SSL_CTX **p_ctx)
+{
+    char *p, *end, buf[PJ_ARRAY_SIZE(ossl_profiles)*25];
+    unsigned i, n;
+    pj_status_t status;
+
+    buf[0] = buf[1] = '\0';
+    p = buf;
+    end = buf + sizeof(buf);
+    for (i=0; i<ds->srtp->setting.crypto_count && p < end; ++i) {
+        pjmedia_srtp_crypto *crypto = &ds->srtp->setting.crypto[i];
+        unsigned j;
+        for (j=0; j < valid_profiles_cnt; ++j) {
+            if (!pj_ansi_strcmp(crypto->name.ptr,
+                                valid_pj_profiles_list[j]))
+            {
+                n = pj_ansi_snprintf(p, end-p, ":%s",
+                                     valid_ossl_profiles_list[j]);
+                p += n;
+                break;
+            }
+        }
+    }
+
+#if DTLS_SHARE_CTX
+    pj_lock_acquire(dtls_lock);
+
+    for (i = 0; i < PJ_ARRAY_SIZE(dtls_ctx_cache); ++i) {
+        dtls_shared_ctx *sc = &dtls_ctx_cache[i];
+        if (sc->ctx && !pj_ansi_strcmp(sc->profiles, buf+1)) {
+            SSL_CTX_up_ref(sc->ctx);
+            *p_ctx = sc->ctx;
+            pj_lock_release(dtls_lock);
+            return PJ_SUCCESS;
+        }
+    }
+
+    status = ssl_ctx_create(ds, buf+1, p_ctx);
+    if (status == PJ_SUCCESS) {
+        /* Keep it for the next instances, unless the cache is full */
+        for (i = 0; i < PJ_ARRAY_SIZE(dtls_ctx_cache); ++i) {
+            dtls_shared_ctx *sc = &dtls_ctx_cache[i];
+            if (!sc->ctx) {
+                pj_ansi_strxcpy(sc->profiles, buf+1, sizeof(sc->profiles));
+                sc->ctx = *p_ctx;
+                SSL_CTX_up_ref(sc->ctx);
+                break;
+            }
+        }
+    }
+
+    pj_lock_release(dtls_lock);
+#else
+    status = ssl_ctx_create(ds, buf+1, p_ctx);
+#endif
+
+    return status;
+}
+
+/* Create and initialize new SSL instance */
+static pj_status_t ssl_create(dtls_srtp *ds, unsigned idx)
+{
+    SSL_CTX *ctx = NULL;
+    int mode;
+    pj_status_t status;
+
+    /* Check if it is already instantiated */
+    if (ds->ossl_ssl[idx])
+        return PJ_SUCCESS;
+
+    if (valid_profiles_cnt == 0)
+        return PJMEDIA_SRTP_DTLS_ENOPROFILE;
+
+    /* Get DTLS context, it is shared with other instances */
+    status = ssl_get_ctx(ds, &ctx);
+    if (status != PJ_SUCCESS)
+        return status;
+
     /* Create SSL instance */
     ds->ossl_ctx[idx] = ctx;
     ds->ossl_ssl[idx] = SSL_new(ds->ossl_ctx[idx]);
     if (ds->ossl_ssl[idx] == NULL) {
         SSL_CTX_free(ctx);
+        ds->ossl_ctx[idx] = NULL;
         return GET_SSL_STATUS(ds);
     }
 
@@ -659,7 +900,7 @@ static void ssl_destroy(dtls_srtp *ds, unsigned idx)
         ds->ossl_wbio[idx] = NULL;
     }
 
-    /* Destroy SSL context */
+    /* Release SSL context, it may still be used by other instances */
     if (ds->ossl_ctx[idx]) {
         SSL_CTX_free(ds->ossl_ctx[idx]);
         ds->ossl_ctx[idx] = NULL;
@@ -837,6 +1078,87 @@ static pj_status_t udp_member_transport_media_start(dtls_srtp *ds)
 }
 
 
+#if PJMEDIA_SRTP_DTLS_SESSION_RESUMPTION
+/* Find the client session with the peer, dtls_lock must be held */
+static dtls_session *find_session(const pj_str_t *rem_fp)
+{
+    unsigned i;
+
+    for (i = 0; i < PJ_ARRAY_SIZE(dtls_sessions); ++i) {
+        if (dtls_sessions[i].sess &&
+            !pj_stricmp2(rem_fp, dtls_sessions[i].rem_fp))
+        {
+            return &dtls_sessions[i];
+        }
+    }
+    return NULL;
+}
+
+/* As client, offer to resume the last session with the peer */
+static void ssl_resume_session(dtls_srtp *ds, unsigned idx)
+{
+    dtls_session *s;
+
+    if (!ds->rem_fingerprint.slen)
+        return;
+
+    pj_lock_acquire(dtls_lock);
+    s = find_session(&ds->rem_fingerprint);
+    if (s) {
+        SSL_set_session(ds->ossl_ssl[idx], s->sess);
+        s->last_used = ++dtls_session_clock;
+    }
+    pj_lock_release(dtls_lock);
+}
+
+/* As client, keep the session with the peer, whose certificate has been
+ * verified, for the next handshake.
+ */
+static void ssl_save_session(dtls_srtp *ds, unsigned idx)
+{
+    SSL_SESSION *sess = NULL;
+    dtls_session *s;
+    unsigned i;
+
+    if (ds->setup != DTLS_SETUP_ACTIVE ||
+        ds->rem_fingerprint.slen >= (pj_ssize_t)sizeof(s->rem_fp))
+    {
+        return;
+    }
+
+    DTLS_LOCK(ds);
+    if (ds->ossl_ssl[idx])
+        sess = SSL_get1_session(ds->ossl_ssl[idx]);
+    DTLS_UNLOCK(ds);
+    if (!sess)
+        return;
+
+    pj_lock_acquire(dtls_lock);
+    s = find_session(&ds->rem_fingerprint);
+    if (!s) {
+        /* Use a free entry, or replace the least recently used one */
+        s = &dtls_sessions[0];
+        for (i = 0; i < PJ_ARRAY_SIZE(dtls_sessions); ++i) {
+            if (!dtls_sessions[i].sess) {
+                s = &dtls_sessions[i];
+                break;
+            }
+            if (dtls_sessions[i].last_used < s->last_used)
+                s = &dtls_sessions[i];
+        }
+        pj_memcpy(s->rem_fp, ds->rem_fingerprint.ptr,
+                  ds->rem_fingerprint.slen);
+        s->rem_fp[ds->rem_fingerprint.slen] = '\0';
+    }
+    if (s->sess)
+        SSL_SESSION_free(s->sess);
+    s->sess = sess;
+    s->last_used = ++dtls_session_clock;
+    pj_lock_release(dtls_lock);
+}
+#endif
+
+
 /* Flush write BIO */
 static pj_status_t ssl_flush_wbio(dtls_srtp *ds, unsigned idx)
 {
@@ -885,8 +1207,10 @@ static pj_status_t ssl_flush_wbio(dtls_srtp *ds, unsigned idx)
 
     /* Yes, SSL handshake is done! */
     ds->nego_completed[idx] = PJ_TRUE;
-    PJ_LOG(2,(ds->base.name, "DTLS-SRTP negotiation for %s completed!",
-                             CHANNEL_TO_STRING(idx)));
+    PJ_LOG(2,(ds->base.name, "DTLS-SRTP negotiation for %s completed%s!",
+                             CHANNEL_TO_STRING(idx),
+                             (SSL_session_reused(ds->ossl_ssl[idx])?
+                              " (session resumed)" : "")));
 
     /* Stop the retransmission clock. Note that the clock may not be stopped
      * if this function is called from clock thread context. We'll try again
@@ -916,6 +1240,11 @@ static pj_status_t ssl_flush_wbio(dtls_srtp *ds, unsigned idx)
         }
     }
 
+#if PJMEDIA_SRTP_DTLS_SESSION_RESUMPTION
+    if (idx == RTP_CHANNEL && ds->rem_fprint_status == PJ_SUCCESS)
+        ssl_save_session(ds, idx);
+#endif
+
     /* If media_start() has been called, start SRTP now */
     if (ds->pending_start && idx == RTP_CHANNEL) {
         ds->pending_start = PJ_FALSE;
@@ -1019,6 +1348,9 @@ static pj_status_t ssl_handshake_channel(dtls_srtp *ds, unsigned idx)
     /* Perform SSL handshake */
     if (ds->setup == DTLS_SETUP_ACTIVE) {
         SSL_set_connect_state(ds->ossl_ssl[idx]);
+#if PJMEDIA_SRTP_DTLS_SESSION_RESUMPTION
+        ssl_resume_session(ds, idx);
+#endif
     } else {
         SSL_set_accept_state(ds->ossl_ssl[idx]);
     }
@@ -1338,6 +1670,168 @@ static void on_ice_complete2(pjmedia_transport *tp,
 }
 
 
+#if PJMEDIA_SRTP_DTLS_WORKER_CNT > 0
+/* Handshake worker thread, processes the queued packets in order */
+static int dtls_worker_proc(void *arg)
+{
+    dtls_worker *w = (dtls_worker*)arg;
+
+    for (;;) {
+        dtls_job *job;
+
+        pj_sem_wait(w->sem);
+        if (dtls_workers_quit)
+            break;
+
+        /* The job stays in the queue while it is processed, so its slot
+         * is not reused.
+         */
+        pj_lock_acquire(w->lock);
+        job = &w->jobs[w->head];
+        pj_lock_release(w->lock);
+
+        if (!job->ds->is_destroying)
+            ssl_on_recv_packet(job->ds, job->idx, job->pkt, job->len);
+        pj_grp_lock_dec_ref(job->ds->base.grp_lock);
+
+        pj_lock_acquire(w->lock);
+        w->head = (w->head + 1) % PJMEDIA_SRTP_DTLS_WORKER_QUEUE_LEN;
+        --w->cnt;
+        pj_lock_release(w->lock);
+    }
+
+    return 0;
+}
+
+static void dtls_destroy_workers(dtls_worker *workers)
+{
+    unsigned i;
+
+    dtls_workers_quit = PJ_TRUE;
+    for (i = 0; i < PJMEDIA_SRTP_DTLS_WORKER_CNT; ++i) {
+        if (workers[i].thread)
+            pj_sem_post(workers[i].sem);
+    }
+
+    for (i = 0; i < PJMEDIA_SRTP_DTLS_WORKER_CNT; ++i) {
+        dtls_worker *w = &workers[i];
+
+        if (w->thread) {
+            pj_thread_join(w->thread);
+            pj_thread_destroy(w->thread);
+        }
+
+        /* Release the packets which have not been processed */
+        while (w->cnt) {
+            pj_grp_lock_dec_ref(w->jobs[w->head].ds->base.grp_lock);
+            w->head = (w->head + 1) % PJMEDIA_SRTP_DTLS_WORKER_QUEUE_LEN;
+            --w->cnt;
+        }
+
+        if (w->lock)
+            pj_lock_destroy(w->lock);
+        if (w->sem)
+            pj_sem_destroy(w->sem);
+    }
+}
+
+/* Create the handshake workers, dtls_lock must be held */
+static pj_status_t dtls_create_workers(void)
+{
+    dtls_worker *workers;
+    unsigned i;
+    pj_status_t status = PJ_SUCCESS;
+
+    workers = (dtls_worker*)
+              pj_pool_calloc(dtls_pool, PJMEDIA_SRTP_DTLS_WORKER_CNT,
+                             sizeof(dtls_worker));
+    dtls_workers_quit = PJ_FALSE;
+
+    for (i = 0; i < PJMEDIA_SRTP_DTLS_WORKER_CNT; ++i) {
+        dtls_worker *w = &workers[i];
+
+        status = pj_sem_create(dtls_pool, "dtlsw%p", 0,
+                               PJMEDIA_SRTP_DTLS_WORKER_QUEUE_LEN + 1,
+                               &w->sem);
+        if (status == PJ_SUCCESS) {
+            status = pj_lock_create_simple_mutex(dtls_pool, "dtlsw%p",
+                                                 &w->lock);
+        }
+        if (status == PJ_SUCCESS) {
+            status = pj_thread_create(dtls_pool, "dtlsw%p",
+                                      &dtls_worker_proc, w, 0, 0,
+                                      &w->thread);
+        }
+        if (status != PJ_SUCCESS) {
+            dtls_destroy_workers(workers);
+            return status;
+        }
+    }
+
+    dtls_workers = workers;
+    return PJ_SUCCESS;
+}
+
+/* Queue incoming handshake packet to the worker of the instance. Returns
+ * PJ_FALSE if the packet should be processed by the caller instead.
+ */
+static pj_bool_t dtls_queue_packet(dtls_srtp *ds, unsigned idx,
+                                   const void *pkt, pj_size_t size)
+{
+    dtls_worker *w;
+    dtls_job *job;
+
+    /* Without group lock, the instance may be gone before the worker
+     * gets to the packet.
+     */
+    if (!ds->base.grp_lock || size > PJMEDIA_MAX_MRU || !dtls_lock ||
+        dtls_workers_disabled)
+    {
+        return PJ_FALSE;
+    }
+
+    if (!dtls_workers) {
+        pj_lock_acquire(dtls_lock);
+        if (!dtls_workers && !dtls_workers_disabled) {
+            pj_status_t status = dtls_create_workers();
+            if (status != PJ_SUCCESS) {
+                pj_perror(3, "DTLS-SRTP", status, "Failed creating "
+                          "handshake workers, handshake will be done in "
+                          "media thread");
+                dtls_workers_disabled = PJ_TRUE;
+            }
+        }
+        pj_lock_release(dtls_lock);
+
+        if (!dtls_workers)
+            return PJ_FALSE;
+    }
+
+    w = &dtls_workers[ds->worker_idx];
+    pj_lock_acquire(w->lock);
+    if (w->cnt == PJMEDIA_SRTP_DTLS_WORKER_QUEUE_LEN) {
+        pj_lock_release(w->lock);
+        PJ_LOG(4,(ds->base.name, "DTLS-SRTP %s dropping %lu bytes, "
+                  "handshake worker queue is full", CHANNEL_TO_STRING(idx),
+                  (unsigned long)size));
+        return PJ_TRUE;
+    }
+
+    job = &w->jobs[(w->head + w->cnt) % PJMEDIA_SRTP_DTLS_WORKER_QUEUE_LEN];
+    job->ds = ds;
+    job->idx = idx;
+    job->len = size;
+    pj_memcpy(job->pkt, pkt, size);
+    pj_grp_lock_add_ref(ds->base.grp_lock);
+    ++w->cnt;
+    pj_lock_release(w->lock);
+
+    pj_sem_post(w->sem);
+    return PJ_TRUE;
+}
+#endif
+
+
 /* *************************************
  *
  * DTLS-SRTP transport keying operations
@@ -1349,6 +1843,12 @@ static pj_status_t dtls_on_recv(pjmedia_transport *tp, unsigned idx,
 {
     dtls_srtp *ds = (dtls_srtp*)tp;
 
+    /* Skip the lock for media packets, unless there is clean up to do */
+    if (size < 1 || !IS_DTLS_PKT(pkt, size)) {
+        if (!ds->clock[idx] || !ds->nego_completed[idx])
+            return PJ_EIGNORED;
+    }
+
     DTLS_LOCK(ds);
 
     /* Destroy the retransmission clock if handshake has been completed. */
@@ -1515,7 +2015,11 @@ static pj_status_t dtls_on_recv(pjmedia_transport *tp, unsigned idx,
 
     DTLS_UNLOCK(ds);
 
-    /* Send it to OpenSSL */
+    /* Send it to OpenSSL, in the handshake worker if any */
+#if PJMEDIA_SRTP_DTLS_WORKER_CNT > 0
+    if (dtls_queue_packet(ds, idx, pkt, size))
+        return PJ_SUCCESS;
+#endif
     ssl_on_recv_packet(ds, idx, pkt, size);
 
     return PJ_SUCCESS;
@@ -1751,7 +2255,7 @@ static pj_status_t dtls_encode_sdp( pjmedia_transport *tp,
         pj_size_t buf_len = sizeof(buf);
         pj_str_t fp;
 
-        status = ssl_get_fingerprint(dtls_cert, PJ_TRUE, buf, &buf_len);
+        status = get_local_fingerprint(PJ_TRUE, buf, &buf_len);
         if (status != PJ_SUCCESS)
             goto on_return;
 
@@ -2106,9 +2610,8 @@ PJ_DEF(pj_status_t) pjmedia_transport_srtp_dtls_get_fingerprint(
                      pj_ansi_strcmp(hash, "SHA-1")==0, PJ_EINVAL);
     PJ_UNUSED_ARG(tp);
 
-    return ssl_get_fingerprint(dtls_cert,
-                               pj_ansi_strcmp(hash, "SHA-256")==0,
-                               buf, len);
+    return get_local_fingerprint(pj_ansi_strcmp(hash, "SHA-256")==0,
+                                 buf, len);
 }
 
 
@@ -23,6 +23,7 @@
 #include <pj/errno.h>
 #include <pj/ioqueue.h>
 #include <pj/log.h>
+#include <pj/os.h>
 #include <pj/pool.h>
 #include <pj/rand.h>
 #include <pj/string.h>
@@ -55,6 +56,17 @@ typedef struct pending_write
     pj_bool_t           is_pending;
 } pending_write;
 
+/* Outstanding RTP read into a pooled packet buffer. The op_key must be
+ * the first member, the read is looked up from it in on_rx_rtp().
+ */
+typedef struct pending_read
+{
+    pj_ioqueue_op_key_t op_key;
+    pjmedia_pkt_buf    *pkt;
+    pj_sockaddr         src_addr;
+    int                 addrlen;
+} pending_read;
+
 
 struct transport_udp
 {
@@ -93,6 +105,13 @@ struct transport_udp
     int                 rtp_addrlen;    /**< Address length.                */
     char                rtp_pkt[RTP_LEN];/**< Incoming RTP packet buffer    */
     unsigned            rtp_trunc_cnt;  /**< Truncated RTP pkt count.        */
+    unsigned            batch_cnt;      /**< Batched RTP receive size.      */
+    char               *batch_pkt;      /**< Batched RTP packet buffers.    */
+    pj_sockaddr        *batch_addr;     /**< Batched RTP source addresses.  */
+    pj_sock_mmsg       *batch_msg;      /**< Batched RTP receive desc.      */
+    pjmedia_pkt_buf_pool *pkt_buf_pool; /**< Pool of RTP packet buffers.    */
+    unsigned            read_cnt;       /**< Number of pooled RTP reads.    */
+    pending_read       *rtp_reads;      /**< Pooled RTP reads.              */
 
     pj_bool_t           enable_rtcp_mux;/**< Enable RTP & RTCP multiplexing?*/
     pj_bool_t           use_rtcp_mux;   /**< Use RTP & RTCP multiplexing?   */
@@ -334,6 +353,27 @@ PJ_DEF(pj_status_t) pjmedia_transport_udp_attach( pjmedia_endpt *endpt,
     tp->rtcp_sock = si->rtcp_sock;
     tp->rtcp_addr_name = si->rtcp_addr_name;
 
+    /* Allocate batched RTP receive buffers */
+    if (options & PJMEDIA_UDP_BATCH_RECV) {
+        tp->batch_cnt = PJMEDIA_UDP_RECV_BATCH_CNT;
+        tp->batch_pkt = (char*) pj_pool_alloc(pool, tp->batch_cnt * RTP_LEN);
+        tp->batch_addr = (pj_sockaddr*)
+                         pj_pool_calloc(pool, tp->batch_cnt,
+                                        sizeof(pj_sockaddr));
+        tp->batch_msg = (pj_sock_mmsg*)
+                        pj_pool_calloc(pool, tp->batch_cnt,
+                                       sizeof(pj_sock_mmsg));
+    }
+
+    /* Pooled RTP reads, the buffers are allocated in media_start() */
+    if (options & PJMEDIA_UDP_POOLED_RECV) {
+        tp->pkt_buf_pool = pjmedia_endpt_get_pkt_buf_pool(endpt);
+        tp->read_cnt = PJMEDIA_UDP_RECV_ASYNC_CNT;
+        tp->rtp_reads = (pending_read*)
+                        pj_pool_calloc(pool, tp->read_cnt,
+                                       sizeof(pending_read));
+    }
+
     /* If address is 0.0.0.0, use host's IP address */
     if (!pj_sockaddr_has_addr(&tp->rtp_addr_name)) {
         pj_sockaddr hostip;
@@ -445,6 +485,14 @@ on_error:
 static void transport_on_destroy(void *arg)
 {
     struct transport_udp *udp = (struct transport_udp*) arg;
+    unsigned i;
+
+    for (i = 0; i < udp->read_cnt; ++i) {
+        if (udp->rtp_reads[i].pkt) {
+            pjmedia_pkt_buf_dec_ref(udp->rtp_reads[i].pkt);
+            udp->rtp_reads[i].pkt = NULL;
+        }
+    }
 
     PJ_LOG(4, (udp->base.name, "UDP media transport destroyed"));
     pj_pool_safe_release(&udp->pool);
@@ -530,7 +578,8 @@ static void warn_if_truncated(const char *name, const char *proto,
  * rather than reading udp->rtp_src_addr directly, since the latter can
  * be raced by transport_attach2().
  */
-static void call_rtp_cb(struct transport_udp *udp, pj_ssize_t bytes_read,
+static void call_rtp_cb(struct transport_udp *udp, void *pkt,
+                        pj_ssize_t bytes_read, pjmedia_pkt_buf *pkt_buf,
                         pj_bool_t *rem_switch, pj_sockaddr *src_addr)
 {
     void (*cb)(void*,void*,pj_ssize_t);
@@ -593,16 +642,17 @@ static void call_rtp_cb(struct transport_udp *udp, pj_ssize_t bytes_read,
         }
 
         param.user_data = user_data;
-        param.pkt = udp->rtp_pkt;
+        param.pkt = pkt;
         param.size = bytes_read;
         param.src_addr = src_addr;
         param.rem_switch = PJ_FALSE;
+        param.pkt_buf = pkt_buf;
         (*cb2)(&param);
         if (rem_switch)
             *rem_switch = param.rem_switch;
     } else if (cb) {
         /* Legacy cb doesn't consume src_addr; deliver unconditionally. */
-        (*cb)(user_data, udp->rtp_pkt, bytes_read);
+        (*cb)(user_data, pkt, bytes_read);
     }
 
     if (cb_grp_lock)
@@ -639,23 +689,169 @@ static void call_rtcp_cb(struct transport_udp *udp, pj_ssize_t bytes_read)
         pj_grp_lock_dec_ref(cb_grp_lock);
 }
 
+/* Process a received RTP packet. Returns PJ_FALSE if the transport has
+ * been stopped or destroyed by the callback.
+ */
+static pj_bool_t process_rx_rtp(struct transport_udp *udp, void *pkt,
+                                pj_ssize_t bytes_read,
+                                pjmedia_pkt_buf *pkt_buf)
+{
+    pj_bool_t discard = PJ_FALSE;
+    pj_bool_t rem_switch = PJ_FALSE;
+    pj_sockaddr src_addr;
+
+    /* Simulate packet lost on RX direction */
+    if (udp->rx_drop_pct) {
+        if ((pj_rand() % 100) <= (int)udp->rx_drop_pct) {
+            PJ_LOG(5,(udp->base.name,
+                      "RX RTP packet dropped because of pkt lost "
+                      "simulation"));
+            discard = PJ_TRUE;
+        }
+    }
+
+    //if (!discard && udp->attached && cb)
+    if (!discard &&
+        (-bytes_read != PJ_STATUS_FROM_OS(PJ_BLOCKING_ERROR_VAL)))
+    {
+        call_rtp_cb(udp, pkt, bytes_read, pkt_buf, &rem_switch, &src_addr);
+    }
+
+    /* Transport may be destroyed from the callback! */
+    if (!udp->rtp_key || !udp->started)
+        return PJ_FALSE;
+
+#if defined(PJMEDIA_TRANSPORT_SWITCH_REMOTE_ADDR) && \
+    (PJMEDIA_TRANSPORT_SWITCH_REMOTE_ADDR == 1)
+    if (rem_switch &&
+        (udp->options & PJMEDIA_UDP_NO_SRC_ADDR_CHECKING)==0)
+    {
+        char addr_text[PJ_INET6_ADDRSTRLEN+10];
+
+        /* Set remote RTP address to source address. Use the snapshot
+         * filled in by call_rtp_cb() rather than udp->rtp_src_addr,
+         * since the latter can be zeroed by a concurrent
+         * transport_attach2().
+         */
+        pj_sockaddr_cp(&udp->rem_rtp_addr, &src_addr);
+
+        PJ_LOG(4,(udp->base.name,
+                  "Remote RTP address switched to %s",
+                  pj_sockaddr_print(&src_addr, addr_text,
+                                    sizeof(addr_text), 3)));
+
+        if (udp->use_rtcp_mux) {
+            pj_sockaddr_cp(&udp->rem_rtcp_addr, &udp->rem_rtp_addr);
+            pj_sockaddr_cp(&udp->rtcp_src_addr, &udp->rem_rtcp_addr);
+        } else if (!pj_sockaddr_has_addr(&udp->rtcp_src_addr)) {
+            /* Also update remote RTCP address if actual RTCP source
+             * address is not heard yet.
+             */
+            pj_uint16_t port;
+
+            pj_sockaddr_cp(&udp->rem_rtcp_addr, &udp->rem_rtp_addr);
+            port = (pj_uint16_t)
+                   (pj_sockaddr_get_port(&udp->rem_rtp_addr)+1);
+            pj_sockaddr_set_port(&udp->rem_rtcp_addr, port);
+
+            pj_sockaddr_cp(&udp->rtcp_src_addr, &udp->rem_rtcp_addr);
+
+            PJ_LOG(4,(udp->base.name,
+                      "Remote RTCP address switched to predicted"
+                      " address %s",
+                      pj_sockaddr_print(&udp->rtcp_src_addr, addr_text,
+                                        sizeof(addr_text), 3)));
+        }
+    }
+#endif
+
+    return PJ_TRUE;
+}
+
+/* Drain the RTP packets already queued in the socket with one batched
+ * receive call. Receive errors are left for the subsequent ioqueue read
+ * to report. Returns PJ_FALSE if the transport has been stopped or
+ * destroyed by the callback.
+ */
+static pj_bool_t drain_rx_rtp_batch(struct transport_udp *udp)
+{
+    unsigned i, cnt = udp->batch_cnt;
+    pj_status_t status;
+
+    for (i = 0; i < cnt; ++i) {
+        udp->batch_msg[i].buf = udp->batch_pkt + i * RTP_LEN;
+        udp->batch_msg[i].len = RTP_LEN;
+        udp->batch_msg[i].addr = &udp->batch_addr[i];
+        udp->batch_msg[i].addr_len = sizeof(pj_sockaddr);
+    }
+
+    status = pj_sock_recvmmsg(udp->rtp_sock, udp->batch_msg, &cnt, 0);
+    if (status != PJ_SUCCESS)
+        return PJ_TRUE;
+
+    for (i = 0; i < cnt; ++i) {
+        /* Update source address just like the ioqueue recvfrom() does */
+        pj_memcpy(&udp->rtp_src_addr, &udp->batch_addr[i],
+                  sizeof(pj_sockaddr));
+        udp->rtp_addrlen = udp->batch_msg[i].addr_len;
+
+        if (!process_rx_rtp(udp, udp->batch_msg[i].buf,
+                            udp->batch_msg[i].len, NULL))
+        {
+            return PJ_FALSE;
+        }
+    }
+
+    return PJ_TRUE;
+}
+
+/* Start a pooled RTP read. The buffer of the previous read is reused if
+ * nobody else has kept a reference to it, otherwise it is released and a
+ * fresh buffer is taken from the pool.
+ */
+static pj_status_t start_pooled_read(struct transport_udp *udp,
+                                     pending_read *read,
+                                     pj_uint32_t flags,
+                                     pj_ssize_t *size)
+{
+    pj_status_t status;
+
+    if (read->pkt && pj_atomic_get(read->pkt->ref_cnt) > 1) {
+        pjmedia_pkt_buf_dec_ref(read->pkt);
+        read->pkt = NULL;
+    }
+
+    if (!read->pkt) {
+        status = pjmedia_pkt_buf_alloc(udp->pkt_buf_pool, &read->pkt);
+        if (status != PJ_SUCCESS)
+            return status;
+    }
+
+    read->addrlen = sizeof(read->src_addr);
+    *size = RTP_LEN;
+    return pj_ioqueue_recvfrom(udp->rtp_key, &read->op_key, read->pkt->buf,
+                               size, flags, &read->src_addr,
+                               &read->addrlen);
+}
+
 /* Notification from ioqueue about incoming RTP packet */
 static void on_rx_rtp(pj_ioqueue_key_t *key,
                       pj_ioqueue_op_key_t *op_key,
                       pj_ssize_t bytes_read)
 {
     struct transport_udp *udp;
+    pending_read *read = NULL;
     pj_status_t status;
-    pj_bool_t rem_switch = PJ_FALSE;
     pj_sockaddr src_addr;
     pj_bool_t transport_restarted = PJ_FALSE;
     unsigned num_err = 0;
     pj_status_t last_err = PJ_SUCCESS;
 
-    PJ_UNUSED_ARG(op_key);
-
     udp = (struct transport_udp*) pj_ioqueue_get_user_data(key);
 
+    if (op_key != &udp->rtp_read_op)
+        read = (pending_read*) op_key;
+
     if (-bytes_read == PJ_ECANCELLED) {
         TRACE_((udp->base.name, "on_rx_rtp(): got PJ_ECANCELLED"));
         return;
@@ -668,91 +864,52 @@ static void on_rx_rtp(pj_ioqueue_key_t *key,
         status = transport_restart(PJ_TRUE, udp);
         if (status != PJ_SUCCESS) {
             bytes_read = -PJ_ESOCKETSTOP;
-            call_rtp_cb(udp, bytes_read, NULL, &src_addr);
+            call_rtp_cb(udp, udp->rtp_pkt, bytes_read, NULL, NULL, &src_addr);
         }
         return;
     }
 
     do {
-        pj_bool_t discard = PJ_FALSE;
-
-        /* Simulate packet lost on RX direction */
-        if (udp->rx_drop_pct) {
-            if ((pj_rand() % 100) <= (int)udp->rx_drop_pct) {
-                PJ_LOG(5,(udp->base.name,
-                          "RX RTP packet dropped because of pkt lost "
-                          "simulation"));
-                discard = PJ_TRUE;
+        if (read && read->pkt) {
+            /* Update source address just like the ioqueue recvfrom()
+             * does for the non-pooled read.
+             */
+            if (bytes_read > 0) {
+                read->pkt->len = bytes_read;
+                pj_memcpy(&udp->rtp_src_addr, &read->src_addr,
+                          sizeof(pj_sockaddr));
+                udp->rtp_addrlen = read->addrlen;
             }
+            if (!process_rx_rtp(udp, read->pkt->buf, bytes_read, read->pkt))
+                break;
+        } else {
+            if (!process_rx_rtp(udp, udp->rtp_pkt, bytes_read, NULL))
+                break;
         }
 
-        //if (!discard && udp->attached && cb)
-        if (!discard &&
-            (-bytes_read != PJ_STATUS_FROM_OS(PJ_BLOCKING_ERROR_VAL)))
-        {
-            call_rtp_cb(udp, bytes_read, &rem_switch, &src_addr);
+        /* Drain more queued packets with batched receive */
+        if (udp->batch_cnt && bytes_read > 0) {
+            if (!drain_rx_rtp_batch(udp))
+                break;
         }
 
-        /* Transport may be destroyed from the callback! */
-        if (!udp->rtp_key || !udp->started)
-            break;
-
-#if defined(PJMEDIA_TRANSPORT_SWITCH_REMOTE_ADDR) && \
-    (PJMEDIA_TRANSPORT_SWITCH_REMOTE_ADDR == 1)
-        if (rem_switch &&
-            (udp->options & PJMEDIA_UDP_NO_SRC_ADDR_CHECKING)==0)
-        {
-            char addr_text[PJ_INET6_ADDRSTRLEN+10];
-
-            /* Set remote RTP address to source address. Use the snapshot
-             * filled in by call_rtp_cb() rather than udp->rtp_src_addr,
-             * since the latter can be zeroed by a concurrent
-             * transport_attach2().
-             */
-            pj_sockaddr_cp(&udp->rem_rtp_addr, &src_addr);
-
-            PJ_LOG(4,(udp->base.name,
-                      "Remote RTP address switched to %s",
-                      pj_sockaddr_print(&src_addr, addr_text,
-                                        sizeof(addr_text), 3)));
-
-            if (udp->use_rtcp_mux) {
-                pj_sockaddr_cp(&udp->rem_rtcp_addr, &udp->rem_rtp_addr);
-                pj_sockaddr_cp(&udp->rtcp_src_addr, &udp->rem_rtcp_addr);
-            } else if (!pj_sockaddr_has_addr(&udp->rtcp_src_addr)) {
-                /* Also update remote RTCP address if actual RTCP source
-                 * address is not heard yet.
-                 */
-                pj_uint16_t port;
-
-                pj_sockaddr_cp(&udp->rem_rtcp_addr, &udp->rem_rtp_addr);
-                port = (pj_uint16_t)
-                       (pj_sockaddr_get_port(&udp->rem_rtp_addr)+1);
-                pj_sockaddr_set_port(&udp->rem_rtcp_addr, port);
-
-                pj_sockaddr_cp(&udp->rtcp_src_addr, &udp->rem_rtcp_addr);
-
-                PJ_LOG(4,(udp->base.name,
-                          "Remote RTCP address switched to predicted"
-                          " address %s",
-                          pj_sockaddr_print(&udp->rtcp_src_addr, addr_text,
-                                            sizeof(addr_text), 3)));
-            }
+        if (read) {
+            status = start_pooled_read(udp, read, 0, &bytes_read);
+        } else {
+            bytes_read = sizeof(udp->rtp_pkt);
+            udp->rtp_addrlen = sizeof(udp->rtp_src_addr);
+            status = pj_ioqueue_recvfrom(udp->rtp_key, &udp->rtp_read_op,
+                                         udp->rtp_pkt, &bytes_read, 0,
+                                         &udp->rtp_src_addr,
+                                         &udp->rtp_addrlen);
         }
-#endif
-
-        bytes_read = sizeof(udp->rtp_pkt);
-        udp->rtp_addrlen = sizeof(udp->rtp_src_addr);
-        status = pj_ioqueue_recvfrom(udp->rtp_key, &udp->rtp_read_op,
-                                     udp->rtp_pkt, &bytes_read, 0,
-                                     &udp->rtp_src_addr,
-                                     &udp->rtp_addrlen);
 
         if (status != PJ_EPENDING && status != PJ_SUCCESS) {
             if (transport_restarted && last_err == status) {
                 /* Still the same error after restart */
                 bytes_read = -PJ_ESOCKETSTOP;
-                call_rtp_cb(udp, bytes_read, NULL, &src_addr);
+                call_rtp_cb(udp, udp->rtp_pkt, bytes_read, NULL, NULL,
+                            &src_addr);
                 break;
             } else if (PJMEDIA_IGNORE_RECV_ERR_CNT) {
                 if (last_err == status) {
@@ -768,7 +925,8 @@ static void on_rx_rtp(pj_ioqueue_key_t *key,
                     status = transport_restart(PJ_TRUE, udp);
                     if (status != PJ_SUCCESS) {
                         bytes_read = -PJ_ESOCKETSTOP;
-                        call_rtp_cb(udp, bytes_read, NULL, &src_addr);
+                        call_rtp_cb(udp, udp->rtp_pkt, bytes_read, NULL,
+                                    NULL, &src_addr);
                         break;
                     }
                     transport_restarted = PJ_TRUE;
@@ -1456,15 +1614,29 @@ static pj_status_t transport_media_start(pjmedia_transport *tp,
 
     TRACE_((udp->base.name, "media_start(): before recvfrom RTP"));
 
-    /* Kick off pending RTP read from the ioqueue */
-    udp->rtp_addrlen = sizeof(udp->rtp_src_addr);
-    size = sizeof(udp->rtp_pkt);
-    status = pj_ioqueue_recvfrom(udp->rtp_key, &udp->rtp_read_op,
-                                 udp->rtp_pkt, &size, PJ_IOQUEUE_ALWAYS_ASYNC,
-                                 &udp->rtp_src_addr, &udp->rtp_addrlen);
+    /* Kick off pending RTP read(s) from the ioqueue */
+    if (udp->read_cnt) {
+        for (i = 0; i < udp->read_cnt; ++i) {
+            pending_read *read = &udp->rtp_reads[i];
+
+            pj_ioqueue_op_key_init(&read->op_key, sizeof(read->op_key));
+            status = start_pooled_read(udp, read, PJ_IOQUEUE_ALWAYS_ASYNC,
+                                       &size);
+            if (status != PJ_EPENDING)
+                break;
+        }
+    } else {
+        udp->rtp_addrlen = sizeof(udp->rtp_src_addr);
+        size = sizeof(udp->rtp_pkt);
+        status = pj_ioqueue_recvfrom(udp->rtp_key, &udp->rtp_read_op,
+                                     udp->rtp_pkt, &size,
+                                     PJ_IOQUEUE_ALWAYS_ASYNC,
+                                     &udp->rtp_src_addr, &udp->rtp_addrlen);
+    }
     if (status != PJ_EPENDING) {
         PJ_PERROR(3, (udp->base.name, status,
                       "media_start(): recvfrom RTP failed"));
+        pj_ioqueue_clear_key(udp->rtp_key);
         return status;
     }
 
@@ -647,6 +647,7 @@ static pj_status_t decode_red(pjmedia_txt_stream *stream, unsigned pt, int seq,
 static pj_status_t on_stream_rx_rtp(pjmedia_stream_common *c_strm,
                                     const pjmedia_rtp_hdr *hdr,
                                     const void *payload, unsigned payloadlen,
+                                    pjmedia_pkt_buf *pkt_buf,
                                     pjmedia_rtp_status seq_st,
                                     pj_bool_t *pkt_discarded)
 {
@@ -656,6 +657,8 @@ static pj_status_t on_stream_rx_rtp(pjmedia_stream_common *c_strm,
     pj_int16_t diff = 0;
     pj_status_t status = PJ_SUCCESS;
 
+    PJ_UNUSED_ARG(pkt_buf);
+
     /* Initialize to prevent uninitialized memory reads on success paths */
     *pkt_discarded = PJ_FALSE;
 
@@ -679,6 +679,7 @@ static pj_status_t on_stream_rx_rtp(pjmedia_stream_common *c_strm,
                                     const pjmedia_rtp_hdr *hdr,
                                     const void *payload,
                                     unsigned payloadlen,
+                                    pjmedia_pkt_buf *pkt_buf,
                                     pjmedia_rtp_status seq_st,
                                     pj_bool_t *pkt_discarded)
 {
@@ -687,6 +688,9 @@ static pj_status_t on_stream_rx_rtp(pjmedia_stream_common *c_strm,
     pj_status_t status = PJ_SUCCESS;
     long ts_diff;
 
+    /* Video payloads are copied to the jitter buffer */
+    PJ_UNUSED_ARG(pkt_buf);
+
     pj_grp_lock_acquire( c_strm->grp_lock );
 
     /* Quickly see if there may be a full picture in the jitter buffer, and
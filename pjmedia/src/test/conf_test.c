@@ -0,0 +1,987 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <pjmedia/conference.h>
+#include <pjmedia/alaw_ulaw.h>
+#include <pj/log.h>
+#include <pj/os.h>
+#include <pj/pool.h>
+#include <pj/rand.h>
+#include <pj/string.h>
+#include "test.h"
+
+#define THIS_FILE       "conf_test.c"
+
+#define CLOCK_RATE      8000
+#define SPF             160
+#define MAX_SLOTS       32
+#define PORT_CNT        8
+#define OP_CNT          20000
+#define RECYCLE_EVERY   500
+
+/* Connection changes from a control thread while the clock is ticking,
+ * the resulting connections must match the requested ones.
+ */
+
+typedef struct test_port
+{
+    pjmedia_port        base;
+    unsigned            slot;
+    pjmedia_frame_type  last_type;      /* Type of last received frame  */
+    pj_int16_t          last_sample;    /* First sample of last frame   */
+    pj_int16_t          last_frame[SPF];/* Last received audio frame    */
+    pj_uint8_t          last_code;      /* First byte of last ext frame */
+} test_port;
+
+static struct
+{
+    pj_pool_t          *pool;
+    pjmedia_conf       *conf;
+    test_port           ports[PORT_CNT];
+    pj_bool_t           conn[MAX_SLOTS][MAX_SLOTS]; /* Expected connections */
+    unsigned            requested;      /* Operations requested         */
+    pj_atomic_t        *reported;       /* Operations reported          */
+    volatile pj_bool_t  quit;
+    int                 rc;
+    pj_timestamp        ts;             /* Timestamp of the next frame  */
+} test;
+
+/* Each port transmits its index + 1 */
+static pj_status_t tp_get_frame(pjmedia_port *this_port,
+                                pjmedia_frame *frame)
+{
+    pj_int16_t *samples = (pj_int16_t*)frame->buf;
+    unsigned i;
+
+    for (i = 0; i < SPF; ++i)
+        samples[i] = (pj_int16_t)(this_port->port_data.ldata + 1);
+    frame->type = PJMEDIA_FRAME_TYPE_AUDIO;
+    frame->size = SPF * 2;
+    return PJ_SUCCESS;
+}
+
+#if PJMEDIA_CONF_BACKEND == PJMEDIA_CONF_SERIAL_BRIDGE_BACKEND
+/* Encoded port transmits the code in its ldata */
+static pj_status_t tp_get_frame_ext(pjmedia_port *this_port,
+                                    pjmedia_frame *frame)
+{
+    pjmedia_frame_ext *f = (pjmedia_frame_ext*)frame;
+    pj_uint8_t code[SPF];
+
+    pj_memset(code, (int)this_port->port_data.ldata, sizeof(code));
+    f->base.type = PJMEDIA_FRAME_TYPE_EXTENDED;
+    f->samples_cnt = 0;
+    f->subframe_cnt = 0;
+    pjmedia_frame_ext_append_subframe(f, code, SPF * 8, SPF);
+    return PJ_SUCCESS;
+}
+#endif
+
+static pj_status_t tp_put_frame(pjmedia_port *this_port,
+                                pjmedia_frame *frame)
+{
+    test_port *tp = (test_port*)this_port;
+
+    tp->last_type = frame->type;
+    if (frame->type == PJMEDIA_FRAME_TYPE_AUDIO) {
+        tp->last_sample = *(pj_int16_t*)frame->buf;
+        pjmedia_copy_samples(tp->last_frame, (pj_int16_t*)frame->buf, SPF);
+    } else if (frame->type == PJMEDIA_FRAME_TYPE_EXTENDED) {
+        pjmedia_frame_ext *f = (pjmedia_frame_ext*)frame;
+        pjmedia_frame_ext_subframe *sf;
+
+        sf = pjmedia_frame_ext_get_subframe(f, 0);
+        tp->last_code = (f->samples_cnt == SPF && sf && sf->bitlen)?
+                        sf->data[0] : 0;
+    }
+    return PJ_SUCCESS;
+}
+
+static pj_status_t tp_on_destroy(pjmedia_port *this_port)
+{
+    PJ_UNUSED_ARG(this_port);
+    return PJ_SUCCESS;
+}
+
+static void on_conf_op(const pjmedia_conf_op_info *info)
+{
+    PJ_UNUSED_ARG(info);
+    pj_atomic_inc(test.reported);
+}
+
+static void tick(unsigned cnt)
+{
+    pjmedia_port *master = pjmedia_conf_get_master_port(test.conf);
+    pj_int16_t buf[SPF];
+
+    while (cnt--) {
+        pjmedia_frame frame;
+
+        frame.type = PJMEDIA_FRAME_TYPE_AUDIO;
+        frame.buf = buf;
+        frame.size = sizeof(buf);
+        frame.timestamp = test.ts;
+        frame.bit_info = 0;
+        pjmedia_port_get_frame(master, &frame);
+        test.ts.u64 += SPF;
+    }
+}
+
+/* Remove a port and add it again, it loses its connections. */
+static pj_status_t recycle_port(test_port *tp)
+{
+    unsigned i;
+    pj_status_t status;
+
+    status = pjmedia_conf_remove_port(test.conf, tp->slot);
+    if (status != PJ_SUCCESS)
+        return status;
+    ++test.requested;
+
+    for (i = 0; i < MAX_SLOTS; ++i) {
+        test.conn[tp->slot][i] = PJ_FALSE;
+        test.conn[i][tp->slot] = PJ_FALSE;
+    }
+
+    status = pjmedia_conf_add_port(test.conf, test.pool, &tp->base, NULL,
+                                   &tp->slot);
+    if (status == PJ_SUCCESS)
+        ++test.requested;
+    return status;
+}
+
+static int control_thread(void *arg)
+{
+    unsigned i;
+
+    PJ_UNUSED_ARG(arg);
+
+    for (i = 0; i < OP_CNT; ++i) {
+        test_port *src = &test.ports[pj_rand() % PORT_CNT];
+        test_port *dst = &test.ports[pj_rand() % PORT_CNT];
+        pjmedia_conf_port_info info;
+        pj_status_t status;
+
+        if (i % RECYCLE_EVERY == RECYCLE_EVERY - 1) {
+            status = recycle_port(src);
+            PJ_TEST_SUCCESS(status, "recycle port",
+                            {test.rc = -10; break;});
+            continue;
+        }
+
+        switch (pj_rand() % 4) {
+        case 0:
+        case 1:
+            status = pjmedia_conf_connect_port(test.conf, src->slot,
+                                               dst->slot, 0);
+            test.conn[src->slot][dst->slot] = PJ_TRUE;
+            break;
+        case 2:
+            status = pjmedia_conf_disconnect_port(test.conf, src->slot,
+                                                  dst->slot);
+            test.conn[src->slot][dst->slot] = PJ_FALSE;
+            break;
+        default:
+            status = pjmedia_conf_adjust_conn_level(test.conf, src->slot,
+                                                    dst->slot, -10);
+            break;
+        }
+        PJ_TEST_SUCCESS(status, "connection op", {test.rc = -20; break;});
+        ++test.requested;
+
+        /* Stats are read while the connections keep changing */
+        status = pjmedia_conf_get_port_info(test.conf, src->slot, &info);
+        PJ_TEST_SUCCESS(status, "get port info", {test.rc = -30; break;});
+    }
+
+    test.quit = PJ_TRUE;
+    return 0;
+}
+
+static int connect_test(void)
+{
+    pjmedia_conf_param param;
+    pj_thread_t *thread = NULL;
+    unsigned i, j, ticks = 0, connect_cnt = 0;
+    int old_log_level = pj_log_get_level();
+    pj_status_t status;
+    int rc = 0;
+
+    pj_bzero(&test, sizeof(test));
+    pj_srand(0x5eed);
+
+    test.pool = pj_pool_create(mem, "conftest", 4000, 4000, NULL);
+    PJ_TEST_NOT_NULL(test.pool, "pool create", return -1);
+
+    status = pj_atomic_create(test.pool, 0, &test.reported);
+    PJ_TEST_SUCCESS(status, "atomic create", {rc=-90; goto on_return;});
+
+    pjmedia_conf_param_default(&param);
+    param.max_slots = MAX_SLOTS;
+    param.sampling_rate = CLOCK_RATE;
+    param.channel_count = 1;
+    param.samples_per_frame = SPF;
+    param.bits_per_sample = 16;
+    param.options = PJMEDIA_CONF_NO_DEVICE;
+    status = pjmedia_conf_create2(test.pool, &param, &test.conf);
+    PJ_TEST_SUCCESS(status, "conf create", {rc=-100; goto on_return;});
+
+    pjmedia_conf_set_op_cb(test.conf, &on_conf_op);
+
+    for (i = 0; i < PORT_CNT; ++i) {
+        test_port *tp = &test.ports[i];
+        pj_str_t name = pj_str("confport");
+
+        pjmedia_port_info_init(&tp->base.info, &name,
+                               PJMEDIA_SIG_CLASS_PORT_AUD('T','C'),
+                               CLOCK_RATE, 1, 16, SPF);
+        tp->base.port_data.ldata = i;
+        tp->base.get_frame = &tp_get_frame;
+        tp->base.put_frame = &tp_put_frame;
+        tp->base.on_destroy = &tp_on_destroy;
+
+        /* The port keeps its group lock while it is removed and added */
+        status = pjmedia_port_init_grp_lock(&tp->base, test.pool, NULL);
+        PJ_TEST_SUCCESS(status, "port grp lock", {rc=-110; goto on_return;});
+
+        status = pjmedia_conf_add_port(test.conf, test.pool, &tp->base,
+                                       NULL, &tp->slot);
+        PJ_TEST_SUCCESS(status, "add port", {rc=-120; goto on_return;});
+        ++test.requested;
+    }
+
+    status = pj_thread_create(test.pool, "confctl", &control_thread, NULL,
+                              0, 0, &thread);
+    PJ_TEST_SUCCESS(status, "thread create", {rc=-130; goto on_return;});
+
+    /* Keep the clock ticking while the connections are being changed.
+     * Connecting connected ports and the like is logged, so mute it.
+     */
+    pj_log_set_level(2);
+    while (!test.quit) {
+        tick(1);
+        ++ticks;
+    }
+    pj_thread_join(thread);
+    pj_log_set_level(old_log_level);
+
+    PJ_TEST_EQ(test.rc, 0, NULL, {rc=test.rc; goto on_return;});
+
+    /* Let the bridge process the queued operations */
+    for (i = 0; i < 1000 &&
+                (unsigned)pj_atomic_get(test.reported) != test.requested; ++i)
+    {
+        tick(1);
+    }
+
+    PJ_LOG(3,(THIS_FILE, "  %d ops in %d ticks, %d reported",
+              test.requested, ticks, (int)pj_atomic_get(test.reported)));
+    PJ_TEST_EQ((unsigned)pj_atomic_get(test.reported), test.requested,
+               "ops reported",
+               {rc=-200; goto on_return;});
+
+    /* Compare the connections with the requested ones */
+    for (i = 0; i < PORT_CNT; ++i) {
+        unsigned src = test.ports[i].slot;
+        pjmedia_conf_port_info info;
+        unsigned listener_cnt = 0, transmitter_cnt = 0;
+
+        status = pjmedia_conf_get_port_info(test.conf, src, &info);
+        PJ_TEST_SUCCESS(status, "get port info", {rc=-210; goto on_return;});
+
+        for (j = 0; j < MAX_SLOTS; ++j) {
+            listener_cnt += test.conn[src][j];
+            transmitter_cnt += test.conn[j][src];
+        }
+        for (j = 0; j < info.listener_cnt; ++j) {
+            PJ_TEST_TRUE(test.conn[src][info.listener_slots[j]],
+                         "unexpected listener", {rc=-220; goto on_return;});
+        }
+        PJ_TEST_EQ(info.listener_cnt, listener_cnt, "listener count",
+                   {rc=-230; goto on_return;});
+        PJ_TEST_EQ(info.transmitter_cnt, transmitter_cnt,
+                   "transmitter count", {rc=-240; goto on_return;});
+        connect_cnt += listener_cnt;
+    }
+    PJ_TEST_EQ(pjmedia_conf_get_connect_count(test.conf), connect_cnt,
+               "connect count", {rc=-250; goto on_return;});
+
+    /* The audio must follow the connections: port 0 to port 1 only */
+    for (i = 0; i < PORT_CNT; ++i)
+        pjmedia_conf_disconnect_port_from_sinks(test.conf,
+                                                test.ports[i].slot);
+    pjmedia_conf_connect_port(test.conf, test.ports[0].slot,
+                              test.ports[1].slot, 0);
+    tick(2);
+
+    PJ_TEST_EQ(test.ports[1].last_type, PJMEDIA_FRAME_TYPE_AUDIO,
+               "listener frame", {rc=-300; goto on_return;});
+    PJ_TEST_EQ(test.ports[1].last_sample, 1, "listener signal",
+               {rc=-310; goto on_return;});
+    PJ_TEST_NEQ(test.ports[2].last_type, PJMEDIA_FRAME_TYPE_AUDIO,
+                "disconnected port frame", {rc=-320; goto on_return;});
+
+on_return:
+    pj_log_set_level(old_log_level);
+    if (test.conf)
+        pjmedia_conf_destroy(test.conf);
+    if (test.reported)
+        pj_atomic_destroy(test.reported);
+    for (i = 0; i < PORT_CNT; ++i) {
+        if (test.ports[i].base.grp_lock)
+            pjmedia_port_destroy(&test.ports[i].base);
+    }
+    pj_pool_release(test.pool);
+    return rc;
+}
+
+/* The active speaker policy mixes the loudest sources only, a speaker
+ * keeps its place until another source is louder by more than the
+ * hysteresis, and a source that goes silent is released slowly.
+ */
+static int speaker_test(void)
+{
+    enum { SRC_A, SRC_B, SRC_C, SINK, CNT };
+    pjmedia_conf_param param;
+    pj_pool_t *pool;
+    pjmedia_conf *conf = NULL;
+    test_port ports[CNT];
+    unsigned i, lvl_b, lvl_c;
+    pj_status_t status;
+    int rc = 0;
+
+    const pj_int16_t a = 3000, b = 2000, c_low = 1000, c_near = 2300,
+                     c_loud = 12000;
+
+    pool = pj_pool_create(mem, "conftest", 4000, 4000, NULL);
+    PJ_TEST_NOT_NULL(pool, "pool create", return -1);
+    pj_bzero(ports, sizeof(ports));
+
+    pjmedia_conf_param_default(&param);
+    param.max_slots = CNT + 1;
+    param.sampling_rate = CLOCK_RATE;
+    param.channel_count = 1;
+    param.samples_per_frame = SPF;
+    param.bits_per_sample = 16;
+    param.options = PJMEDIA_CONF_NO_DEVICE;
+    param.max_speakers = 2;
+    param.speaker_hysteresis = 16;
+    status = pjmedia_conf_create2(pool, &param, &conf);
+    PJ_TEST_SUCCESS(status, "conf create", {rc=-600; goto on_return;});
+    test.conf = conf;
+
+    for (i = 0; i < CNT; ++i) {
+        test_port *tp = &ports[i];
+        pj_str_t name = pj_str("spkport");
+
+        pjmedia_port_info_init(&tp->base.info, &name,
+                               PJMEDIA_SIG_CLASS_PORT_AUD('T','C'),
+                               CLOCK_RATE, 1, 16, SPF);
+        tp->base.get_frame = &tp_get_frame;
+        tp->base.put_frame = &tp_put_frame;
+        tp->base.on_destroy = &tp_on_destroy;
+
+        status = pjmedia_port_init_grp_lock(&tp->base, pool, NULL);
+        PJ_TEST_SUCCESS(status, "port grp lock", {rc=-610; goto on_return;});
+
+        status = pjmedia_conf_add_port(conf, pool, &tp->base, NULL,
+                                       &tp->slot);
+        PJ_TEST_SUCCESS(status, "add port", {rc=-620; goto on_return;});
+    }
+    ports[SRC_A].base.port_data.ldata = a - 1;
+    ports[SRC_B].base.port_data.ldata = b - 1;
+    ports[SRC_C].base.port_data.ldata = c_low - 1;
+    ports[SINK].base.port_data.ldata = -1;
+
+    for (i = SRC_A; i <= SRC_C; ++i) {
+        status = pjmedia_conf_connect_port(conf, ports[i].slot,
+                                           ports[SINK].slot, 0);
+        PJ_TEST_SUCCESS(status, "connect", {rc=-630; goto on_return;});
+    }
+
+    /* The speakers are selected by the levels of the previous frame */
+    tick(3);
+    PJ_TEST_EQ(ports[SINK].last_sample, a + b, "two loudest mixed",
+               {rc=-640; goto on_return;});
+
+    /* C gets louder than B, but not by more than the hysteresis */
+    lvl_b = pjmedia_linear2ulaw(b) ^ 0xff;
+    lvl_c = pjmedia_linear2ulaw(c_near) ^ 0xff;
+    PJ_TEST_TRUE(lvl_c > lvl_b && lvl_c <= lvl_b + param.speaker_hysteresis,
+                 "level within hysteresis", {rc=-650; goto on_return;});
+    ports[SRC_C].base.port_data.ldata = c_near - 1;
+    tick(20);
+    PJ_TEST_EQ(ports[SINK].last_sample, a + b, "speaker kept",
+               {rc=-660; goto on_return;});
+
+    /* Much louder C replaces B, the quietest speaker */
+    ports[SRC_C].base.port_data.ldata = c_loud - 1;
+    tick(2);
+    PJ_TEST_EQ(ports[SINK].last_sample, a + c_loud, "loud source mixed",
+               {rc=-670; goto on_return;});
+
+    /* C goes silent, it is held for a while before B takes over */
+    ports[SRC_C].base.port_data.ldata = -1;
+    tick(2);
+    PJ_TEST_EQ(ports[SINK].last_sample, a, "silent speaker held",
+               {rc=-680; goto on_return;});
+    tick(50);
+    PJ_TEST_EQ(ports[SINK].last_sample, a + b, "silent speaker released",
+               {rc=-690; goto on_return;});
+
+    /* Without listener, a source doesn't compete */
+    status = pjmedia_conf_disconnect_port(conf, ports[SRC_A].slot,
+                                          ports[SINK].slot);
+    PJ_TEST_SUCCESS(status, "disconnect", {rc=-700; goto on_return;});
+    ports[SRC_C].base.port_data.ldata = c_low - 1;
+    tick(3);
+    PJ_TEST_EQ(ports[SINK].last_sample, b + c_low, "remaining sources mixed",
+               {rc=-710; goto on_return;});
+
+on_return:
+    if (conf)
+        pjmedia_conf_destroy(conf);
+    test.conf = NULL;
+    for (i = 0; i < CNT; ++i) {
+        if (ports[i].base.grp_lock)
+            pjmedia_port_destroy(&ports[i].base);
+    }
+    pj_pool_release(pool);
+    return rc;
+}
+
+
+/* Mix-minus mode must give every listener the same signal as mixing it
+ * from its sources: with connection level adjustments (applied as
+ * correction terms), for a port listening to itself, and for a listener
+ * which doesn't hear all sources and falls back to per-source mixing.
+ */
+enum { MM_MESH = 5, MM_PARTIAL = MM_MESH, MM_CNT };
+
+/* Each port transmits a ramp scaled by its index + 1 */
+static pj_status_t mm_get_frame(pjmedia_port *this_port,
+                                pjmedia_frame *frame)
+{
+    pj_int16_t *samples = (pj_int16_t*)frame->buf;
+    unsigned i;
+
+    for (i = 0; i < SPF; ++i) {
+        samples[i] = (pj_int16_t)((this_port->port_data.ldata + 1) * 10 *
+                                  (1 + i % 16));
+    }
+    frame->type = PJMEDIA_FRAME_TYPE_AUDIO;
+    frame->size = SPF * 2;
+    return PJ_SUCCESS;
+}
+
+static int mm_create(pj_pool_t *pool, unsigned options, test_port ports[],
+                     pjmedia_conf **p_conf)
+{
+    pjmedia_conf_param param;
+    pjmedia_conf *conf;
+    unsigned i, j;
+    pj_status_t status;
+
+    pjmedia_conf_param_default(&param);
+    param.max_slots = MM_CNT + 1;
+    param.sampling_rate = CLOCK_RATE;
+    param.channel_count = 1;
+    param.samples_per_frame = SPF;
+    param.bits_per_sample = 16;
+    param.options = PJMEDIA_CONF_NO_DEVICE | options;
+    status = pjmedia_conf_create2(pool, &param, p_conf);
+    PJ_TEST_SUCCESS(status, "conf create", return -1000);
+    conf = *p_conf;
+
+    for (i = 0; i < MM_CNT; ++i) {
+        test_port *tp = &ports[i];
+        pj_str_t name = pj_str("mmport");
+
+        pjmedia_port_info_init(&tp->base.info, &name,
+                               PJMEDIA_SIG_CLASS_PORT_AUD('T','C'),
+                               CLOCK_RATE, 1, 16, SPF);
+        tp->base.port_data.ldata = i;
+        tp->base.get_frame = &mm_get_frame;
+        tp->base.put_frame = &tp_put_frame;
+        tp->base.on_destroy = &tp_on_destroy;
+
+        status = pjmedia_port_init_grp_lock(&tp->base, pool, NULL);
+        PJ_TEST_SUCCESS(status, "port grp lock", return -1010);
+
+        status = pjmedia_conf_add_port(conf, pool, &tp->base, NULL,
+                                       &tp->slot);
+        PJ_TEST_SUCCESS(status, "add port", return -1020);
+    }
+
+    /* Full mesh, with some connection levels adjusted */
+    for (i = 0; i < MM_MESH; ++i) {
+        for (j = 0; j < MM_MESH; ++j) {
+            int level = 0;
+
+            if (i == j)
+                continue;
+            if (i == 0 && j == 1)
+                level = 64;
+            else if (i == 3 && j == 4)
+                level = -64;
+            else if (i == 4 && j == 2)
+                level = 32;
+
+            status = pjmedia_conf_connect_port(conf, ports[i].slot,
+                                               ports[j].slot, level);
+            PJ_TEST_SUCCESS(status, "connect", return -1030);
+        }
+    }
+    status = pjmedia_conf_adjust_conn_level(conf, ports[1].slot,
+                                            ports[3].slot, -32);
+    PJ_TEST_SUCCESS(status, "adjust conn level", return -1040);
+    status = pjmedia_conf_adjust_rx_level(conf, ports[3].slot, 20);
+    PJ_TEST_SUCCESS(status, "adjust rx level", return -1050);
+
+    /* Port 2 also listens to itself */
+    status = pjmedia_conf_connect_port(conf, ports[2].slot, ports[2].slot,
+                                       0);
+    PJ_TEST_SUCCESS(status, "connect self", return -1060);
+
+    /* The partial listener hears two of the sources only */
+    status = pjmedia_conf_connect_port(conf, ports[0].slot,
+                                       ports[MM_PARTIAL].slot, 0);
+    if (status == PJ_SUCCESS) {
+        status = pjmedia_conf_connect_port(conf, ports[1].slot,
+                                           ports[MM_PARTIAL].slot, -64);
+    }
+    PJ_TEST_SUCCESS(status, "connect partial", return -1070);
+
+    return 0;
+}
+
+/* Tick both bridges and compare the signal received by each port */
+static int mm_compare(pjmedia_conf *conf_ref, test_port ref[],
+                      pjmedia_conf *conf_mm, test_port mm[])
+{
+    unsigned i;
+
+    test.conf = conf_ref;
+    tick(3);
+    test.conf = conf_mm;
+    tick(3);
+
+    for (i = 0; i < MM_CNT; ++i) {
+        PJ_TEST_EQ(mm[i].last_type, PJMEDIA_FRAME_TYPE_AUDIO,
+                   "mix-minus frame", return -1100);
+        PJ_TEST_EQ(ref[i].last_type, PJMEDIA_FRAME_TYPE_AUDIO,
+                   "per-source frame", return -1110);
+        if (pj_memcmp(mm[i].last_frame, ref[i].last_frame,
+                      sizeof(ref[i].last_frame)) != 0)
+        {
+            PJ_LOG(3,(THIS_FILE, "  port %d: mix-minus %d, per-source %d",
+                      i, mm[i].last_frame[SPF-1], ref[i].last_frame[SPF-1]));
+            return -1120;
+        }
+    }
+
+    return 0;
+}
+
+static int mixminus_test(void)
+{
+    pj_pool_t *pool;
+    pjmedia_conf *conf_ref = NULL, *conf_mm = NULL;
+    test_port ref[MM_CNT], mm[MM_CNT];
+    unsigned i;
+    int rc;
+
+    pool = pj_pool_create(mem, "conftest", 4000, 4000, NULL);
+    PJ_TEST_NOT_NULL(pool, "pool create", return -1);
+    pj_bzero(ref, sizeof(ref));
+    pj_bzero(mm, sizeof(mm));
+
+    rc = mm_create(pool, 0, ref, &conf_ref);
+    if (rc == 0)
+        rc = mm_create(pool, PJMEDIA_CONF_MIX_MINUS, mm, &conf_mm);
+    if (rc == 0)
+        rc = mm_compare(conf_ref, ref, conf_mm, mm);
+
+    /* Port 0 and half of port 1 */
+    if (rc == 0) {
+        PJ_TEST_EQ(ref[MM_PARTIAL].last_sample, 10 + 10,
+                   "partial listener signal", rc = -1200);
+    }
+
+    /* Port 4 stops hearing port 3, and falls back to per-source mixing */
+    if (rc == 0) {
+        pjmedia_conf_disconnect_port(conf_ref, ref[3].slot, ref[4].slot);
+        pjmedia_conf_disconnect_port(conf_mm, mm[3].slot, mm[4].slot);
+        rc = mm_compare(conf_ref, ref, conf_mm, mm);
+    }
+
+    /* Port 3 is no longer a source for anybody but port 4 */
+    if (rc == 0) {
+        pjmedia_conf_connect_port(conf_ref, ref[3].slot, ref[4].slot, 0);
+        pjmedia_conf_connect_port(conf_mm, mm[3].slot, mm[4].slot, 0);
+        for (i = 0; i < MM_CNT; ++i) {
+            if (i == 3 || i == 4 || i == MM_PARTIAL)
+                continue;
+            pjmedia_conf_disconnect_port(conf_ref, ref[3].slot, ref[i].slot);
+            pjmedia_conf_disconnect_port(conf_mm, mm[3].slot, mm[i].slot);
+        }
+        rc = mm_compare(conf_ref, ref, conf_mm, mm);
+    }
+
+    if (conf_ref)
+        pjmedia_conf_destroy(conf_ref);
+    if (conf_mm)
+        pjmedia_conf_destroy(conf_mm);
+    test.conf = NULL;
+    for (i = 0; i < MM_CNT; ++i) {
+        if (ref[i].base.grp_lock)
+            pjmedia_port_destroy(&ref[i].base);
+        if (mm[i].base.grp_lock)
+            pjmedia_port_destroy(&mm[i].base);
+    }
+    pj_pool_release(pool);
+    return rc;
+}
+
+
+#if PJMEDIA_CONF_BACKEND == PJMEDIA_CONF_SERIAL_BRIDGE_BACKEND
+
+/* Encoded frames are forwarded as is to a listener with a single encoded
+ * source, and transcoded when mixing.
+ */
+static int passthrough_test(void)
+{
+    enum { ENC_SRC, ENC_SINK, PCM_SRC, CNT };
+    pjmedia_conf_param param;
+    pj_pool_t *pool;
+    pjmedia_conf *conf = NULL;
+    test_port ports[CNT];
+    unsigned i;
+    pj_status_t status;
+    int rc = 0;
+
+    /* The code of the encoded source is not kept when transcoded, as
+     * it decodes to zero which is encoded to 0xFF.
+     */
+    const pj_uint8_t code = 0x7F;
+    const pj_int16_t pcm = 1000;
+
+    pool = pj_pool_create(mem, "conftest", 4000, 4000, NULL);
+    PJ_TEST_NOT_NULL(pool, "pool create", return -1);
+    pj_bzero(ports, sizeof(ports));
+
+    pjmedia_conf_param_default(&param);
+    param.max_slots = CNT + 1;
+    param.sampling_rate = CLOCK_RATE;
+    param.channel_count = 1;
+    param.samples_per_frame = SPF;
+    param.bits_per_sample = 16;
+    param.options = PJMEDIA_CONF_NO_DEVICE;
+    status = pjmedia_conf_create2(pool, &param, &conf);
+    PJ_TEST_SUCCESS(status, "conf create", {rc=-400; goto on_return;});
+    test.conf = conf;
+
+    for (i = 0; i < CNT; ++i) {
+        test_port *tp = &ports[i];
+        pj_str_t name = pj_str("ptport");
+
+        pjmedia_port_info_init(&tp->base.info, &name,
+                               PJMEDIA_SIG_CLASS_PORT_AUD('T','C'),
+                               CLOCK_RATE, 1, 16, SPF);
+        if (i == PCM_SRC) {
+            tp->base.port_data.ldata = pcm - 1;
+            tp->base.get_frame = &tp_get_frame;
+        } else {
+            tp->base.info.fmt.id = PJMEDIA_FORMAT_PCMU;
+            tp->base.port_data.ldata = code;
+            tp->base.get_frame = &tp_get_frame_ext;
+        }
+        tp->base.put_frame = &tp_put_frame;
+        tp->base.on_destroy = &tp_on_destroy;
+
+        status = pjmedia_port_init_grp_lock(&tp->base, pool, NULL);
+        PJ_TEST_SUCCESS(status, "port grp lock", {rc=-410; goto on_return;});
+
+        status = pjmedia_conf_add_port(conf, pool, &tp->base, NULL,
+                                       &tp->slot);
+        PJ_TEST_SUCCESS(status, "add port", {rc=-420; goto on_return;});
+    }
+
+    /* Passthrough only applies to encoded ports */
+    status = pjmedia_conf_set_port_passthrough(conf, ports[PCM_SRC].slot,
+                                               PJ_TRUE);
+    PJ_TEST_EQ(status, PJ_EINVALIDOP, "passthrough on PCM port",
+               {rc=-430; goto on_return;});
+
+    /* Single encoded source: the frame is forwarded as is */
+    pjmedia_conf_connect_port(conf, ports[ENC_SRC].slot,
+                              ports[ENC_SINK].slot, 0);
+    tick(2);
+    PJ_TEST_EQ(ports[ENC_SINK].last_type, PJMEDIA_FRAME_TYPE_EXTENDED,
+               "passthrough frame", {rc=-440; goto on_return;});
+    PJ_TEST_EQ(ports[ENC_SINK].last_code, code, "passthrough code",
+               {rc=-450; goto on_return;});
+
+    /* A second source: the mix is encoded */
+    pjmedia_conf_connect_port(conf, ports[PCM_SRC].slot,
+                              ports[ENC_SINK].slot, 0);
+    tick(2);
+    PJ_TEST_EQ(ports[ENC_SINK].last_type, PJMEDIA_FRAME_TYPE_EXTENDED,
+               "mixed frame", {rc=-460; goto on_return;});
+    PJ_TEST_EQ(ports[ENC_SINK].last_code, pjmedia_linear2ulaw(pcm),
+               "mixed code", {rc=-470; goto on_return;});
+
+    /* Back to a single source, with passthrough disabled */
+    pjmedia_conf_disconnect_port(conf, ports[PCM_SRC].slot,
+                                 ports[ENC_SINK].slot);
+    status = pjmedia_conf_set_port_passthrough(conf, ports[ENC_SINK].slot,
+                                               PJ_FALSE);
+    PJ_TEST_SUCCESS(status, "disable passthrough", {rc=-480; goto on_return;});
+    tick(2);
+    PJ_TEST_EQ(ports[ENC_SINK].last_code, pjmedia_linear2ulaw(0),
+               "transcoded code", {rc=-490; goto on_return;});
+
+    /* And enabled again */
+    pjmedia_conf_set_port_passthrough(conf, ports[ENC_SINK].slot, PJ_TRUE);
+    tick(2);
+    PJ_TEST_EQ(ports[ENC_SINK].last_code, code, "passthrough code again",
+               {rc=-500; goto on_return;});
+
+    /* Encoded source to PCM listener is decoded */
+    pjmedia_conf_disconnect_port(conf, ports[ENC_SRC].slot,
+                                 ports[ENC_SINK].slot);
+    pjmedia_conf_connect_port(conf, ports[ENC_SRC].slot,
+                              ports[PCM_SRC].slot, 0);
+    ports[ENC_SRC].base.port_data.ldata = pjmedia_linear2ulaw(pcm);
+    tick(2);
+    PJ_TEST_EQ(ports[PCM_SRC].last_type, PJMEDIA_FRAME_TYPE_AUDIO,
+               "decoded frame", {rc=-510; goto on_return;});
+    PJ_TEST_EQ(ports[PCM_SRC].last_sample,
+               pjmedia_ulaw2linear(pjmedia_linear2ulaw(pcm)),
+               "decoded sample", {rc=-520; goto on_return;});
+
+on_return:
+    if (conf)
+        pjmedia_conf_destroy(conf);
+    test.conf = NULL;
+    for (i = 0; i < CNT; ++i) {
+        if (ports[i].base.grp_lock)
+            pjmedia_port_destroy(&ports[i].base);
+    }
+    pj_pool_release(pool);
+    return rc;
+}
+
+#endif  /* PJMEDIA_CONF_SERIAL_BRIDGE_BACKEND */
+
+
+#if PJMEDIA_CONF_BACKEND == PJMEDIA_CONF_PARALLEL_BRIDGE_BACKEND
+
+#define SCHED_WORKERS   2
+#define SCHED_LIGHT     6
+#define SCHED_WARMUP    10
+#define SCHED_TICKS     50
+#define LIGHT_MSEC      1
+#define HEAVY_MSEC      8
+
+/* Source port taking some time to get a frame, recording the thread
+ * that received from it.
+ */
+typedef struct sched_port
+{
+    test_port           tp;
+    unsigned            msec;           /* Duration of get_frame()      */
+    pj_thread_t        *thread;         /* Thread of last get_frame()   */
+    unsigned            calls;          /* Number of get_frame() calls  */
+} sched_port;
+
+static pj_status_t sp_get_frame(pjmedia_port *this_port,
+                                pjmedia_frame *frame)
+{
+    sched_port *sp = (sched_port*)this_port;
+
+    if (sp->msec)
+        pj_thread_sleep(sp->msec);
+    sp->thread = pj_thread_this();
+    ++sp->calls;
+    return tp_get_frame(this_port, frame);
+}
+
+/* The ports are distributed to the threads by their cost, the port that
+ * takes longer than all the others together gets a thread for itself.
+ * Each port is still processed once per tick, and the mix is complete.
+ */
+static int sched_test(void)
+{
+    enum { HEAVY = SCHED_LIGHT, SINK, CNT };
+    pjmedia_conf_param param;
+    pj_pool_t *pool;
+    pjmedia_conf *conf = NULL;
+    sched_port ports[CNT];
+    pjmedia_conf_thread_stat stat[SCHED_WORKERS + 1];
+    pj_uint64_t tasks0 = 0, stolen0 = 0, tasks = 0, stolen = 0;
+    unsigned i, t, stat_cnt, shared = 0;
+    pj_int16_t sum = 0;
+    pj_status_t status;
+    int rc = 0;
+
+    pool = pj_pool_create(mem, "conftest", 4000, 4000, NULL);
+    PJ_TEST_NOT_NULL(pool, "pool create", return -1);
+    pj_bzero(ports, sizeof(ports));
+
+    pjmedia_conf_param_default(&param);
+    param.max_slots = CNT + 1;
+    param.sampling_rate = CLOCK_RATE;
+    param.channel_count = 1;
+    param.samples_per_frame = SPF;
+    param.bits_per_sample = 16;
+    param.options = PJMEDIA_CONF_NO_DEVICE;
+    param.worker_threads = SCHED_WORKERS;
+    status = pjmedia_conf_create2(pool, &param, &conf);
+    PJ_TEST_SUCCESS(status, "conf create", {rc=-800; goto on_return;});
+    test.conf = conf;
+
+    for (i = 0; i < CNT; ++i) {
+        test_port *tp = &ports[i].tp;
+        pj_str_t name = pj_str("schedport");
+
+        pjmedia_port_info_init(&tp->base.info, &name,
+                               PJMEDIA_SIG_CLASS_PORT_AUD('T','C'),
+                               CLOCK_RATE, 1, 16, SPF);
+        tp->base.port_data.ldata = i;
+        tp->base.get_frame = &sp_get_frame;
+        tp->base.put_frame = &tp_put_frame;
+        tp->base.on_destroy = &tp_on_destroy;
+        if (i < SINK)
+            ports[i].msec = (i == HEAVY)? HEAVY_MSEC : LIGHT_MSEC;
+
+        status = pjmedia_port_init_grp_lock(&tp->base, pool, NULL);
+        PJ_TEST_SUCCESS(status, "port grp lock", {rc=-810; goto on_return;});
+
+        status = pjmedia_conf_add_port(conf, pool, &tp->base, NULL,
+                                       &tp->slot);
+        PJ_TEST_SUCCESS(status, "add port", {rc=-820; goto on_return;});
+    }
+
+    for (i = 0; i < SINK; ++i) {
+        status = pjmedia_conf_connect_port(conf, ports[i].tp.slot,
+                                           ports[SINK].tp.slot, 0);
+        PJ_TEST_SUCCESS(status, "connect", {rc=-830; goto on_return;});
+        sum = (pj_int16_t)(sum + i + 1);
+    }
+
+    /* Let the bridge learn the cost of the ports */
+    tick(SCHED_WARMUP);
+
+    stat_cnt = PJ_ARRAY_SIZE(stat);
+    status = pjmedia_conf_get_thread_stat(conf, &stat_cnt, stat);
+    PJ_TEST_SUCCESS(status, "get thread stat", {rc=-840; goto on_return;});
+    PJ_TEST_EQ(stat_cnt, SCHED_WORKERS + 1, "thread count",
+               {rc=-850; goto on_return;});
+    for (i = 0; i < stat_cnt; ++i) {
+        tasks0 += stat[i].tasks;
+        stolen0 += stat[i].stolen;
+    }
+    for (i = 0; i < CNT; ++i)
+        ports[i].calls = 0;
+
+    for (t = 0; t < SCHED_TICKS; ++t) {
+        tick(1);
+
+        PJ_TEST_EQ(ports[SINK].tp.last_sample, sum, "mixed signal",
+                   {rc=-860; goto on_return;});
+
+        for (i = 0; i < SCHED_LIGHT; ++i) {
+            if (ports[i].thread == ports[HEAVY].thread) {
+                ++shared;
+                break;
+            }
+        }
+    }
+
+    for (i = 0; i < SINK; ++i) {
+        PJ_TEST_EQ(ports[i].calls, SCHED_TICKS, "get_frame calls",
+                   {rc=-870; goto on_return;});
+    }
+
+    stat_cnt = PJ_ARRAY_SIZE(stat);
+    pjmedia_conf_get_thread_stat(conf, &stat_cnt, stat);
+    for (i = 0; i < stat_cnt; ++i) {
+        PJ_TEST_EQ(stat[i].ticks, SCHED_WARMUP + SCHED_TICKS, "thread ticks",
+                   {rc=-880; goto on_return;});
+        tasks += stat[i].tasks;
+        stolen += stat[i].stolen;
+    }
+    tasks -= tasks0;
+    stolen -= stolen0;
+    PJ_TEST_TRUE(tasks >= (pj_uint64_t)SCHED_TICKS * (SINK + 1),
+                 "tasks count", {rc=-890; goto on_return;});
+    PJ_TEST_TRUE(stolen <= tasks, "stolen count", {rc=-900; goto on_return;});
+
+    /* The heavy port runs alone in its thread, unless the thread is
+     * too late to take its first task and gets it stolen.
+     */
+    PJ_LOG(3,(THIS_FILE, "  heavy port shared its thread in %d of %d ticks,"
+                         " %d of %d tasks stolen",
+              shared, SCHED_TICKS, (int)stolen, (int)tasks));
+    PJ_TEST_TRUE(shared <= SCHED_TICKS / 5, "heavy port isolation",
+                 {rc=-910; goto on_return;});
+
+on_return:
+    if (conf)
+        pjmedia_conf_destroy(conf);
+    test.conf = NULL;
+    for (i = 0; i < CNT; ++i) {
+        if (ports[i].tp.base.grp_lock)
+            pjmedia_port_destroy(&ports[i].tp.base);
+    }
+    pj_pool_release(pool);
+    return rc;
+}
+
+#endif  /* PJMEDIA_CONF_PARALLEL_BRIDGE_BACKEND */
+
+
+int conf_test(void)
+{
+    int rc;
+
+    rc = connect_test();
+    if (rc != 0)
+        return rc;
+
+    rc = speaker_test();
+    if (rc != 0)
+        return rc;
+
+    rc = mixminus_test();
+    if (rc != 0)
+        return rc;
+
+#if PJMEDIA_CONF_BACKEND == PJMEDIA_CONF_PARALLEL_BRIDGE_BACKEND
+    rc = sched_test();
+    if (rc != 0)
+        return rc;
+#endif
+
+#if PJMEDIA_CONF_BACKEND == PJMEDIA_CONF_SERIAL_BRIDGE_BACKEND
+    rc = passthrough_test();
+#endif
+
+    return rc;
+}
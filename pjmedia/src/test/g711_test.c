@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <pjmedia/alaw_ulaw.h>
+#include <pj/log.h>
+#include <pj/os.h>
+#include <pj/pool.h>
+#include <pj/rand.h>
+#include <pj/string.h>
+#include "test.h"
+
+#define THIS_FILE       "g711_test.c"
+
+/* Every 16-bit value, plus room for misaligned start. */
+#define MAX_COUNT       (65536 + 64)
+
+/* Number of random rounds with short buffers for each kernel. */
+#define ROUNDS          2000
+
+/* Benchmark: frame size (20ms at 8KHz) and number of frames. */
+#define BENCH_COUNT     160
+#define BENCH_FRAMES    200000
+
+typedef struct buffers
+{
+    pj_int16_t  pcm[MAX_COUNT];
+    pj_uint8_t  code[MAX_COUNT];
+    pj_uint8_t  ref8[MAX_COUNT];
+    pj_uint8_t  out8[MAX_COUNT];
+    pj_int16_t  ref16[MAX_COUNT];
+    pj_int16_t  out16[MAX_COUNT];
+} buffers;
+
+static const pjmedia_g711_kernel_type simd_types[] =
+{
+    PJMEDIA_G711_KERNEL_SSE2,
+    PJMEDIA_G711_KERNEL_AVX2,
+    PJMEDIA_G711_KERNEL_NEON
+};
+
+/* Compare kernel k against the scalar reference for count samples. */
+static int compare_block(const pjmedia_g711_kernel *ref,
+                         const pjmedia_g711_kernel *k, buffers *b,
+                         unsigned off, unsigned count)
+{
+    ref->ulaw_encode(b->ref8, b->pcm + off, count);
+    k->ulaw_encode(b->out8, b->pcm + off, count);
+    PJ_TEST_EQ(pj_memcmp(b->out8, b->ref8, count), 0, "ulaw_encode",
+               return -10);
+
+    ref->alaw_encode(b->ref8, b->pcm + off, count);
+    k->alaw_encode(b->out8, b->pcm + off, count);
+    PJ_TEST_EQ(pj_memcmp(b->out8, b->ref8, count), 0, "alaw_encode",
+               return -20);
+
+    ref->ulaw_decode(b->ref16, b->code + off, count);
+    k->ulaw_decode(b->out16, b->code + off, count);
+    PJ_TEST_EQ(pj_memcmp(b->out16, b->ref16, count * 2), 0, "ulaw_decode",
+               return -30);
+
+    ref->alaw_decode(b->ref16, b->code + off, count);
+    k->alaw_decode(b->out16, b->code + off, count);
+    PJ_TEST_EQ(pj_memcmp(b->out16, b->ref16, count * 2), 0, "alaw_decode",
+               return -40);
+
+    return 0;
+}
+
+static int compare_kernel(const pjmedia_g711_kernel *ref,
+                          const pjmedia_g711_kernel *k, buffers *b)
+{
+    unsigned round, i;
+    int rc;
+
+    /* All sample values and all codes */
+    for (i = 0; i < MAX_COUNT; ++i) {
+        b->pcm[i] = (pj_int16_t)(i - 32768);
+        b->code[i] = (pj_uint8_t)i;
+    }
+    rc = compare_block(ref, k, b, 0, MAX_COUNT);
+    if (rc != 0)
+        return rc;
+
+    /* Short buffers, for the remaining samples handling */
+    for (round = 0; round < ROUNDS; ++round) {
+        unsigned off = pj_rand() % 64;
+        unsigned count = pj_rand() % 200;
+
+        for (i = 0; i < count; ++i) {
+            b->pcm[off + i] = (pj_int16_t)(pj_rand() & 0xFFFF);
+            b->code[off + i] = (pj_uint8_t)pj_rand();
+        }
+        rc = compare_block(ref, k, b, off, count);
+        if (rc != 0)
+            return rc;
+    }
+
+    return 0;
+}
+
+#if WITH_BENCHMARK
+/* Time the kernels processing BENCH_FRAMES frames, in usec per frame. */
+static void bench_kernel(const pjmedia_g711_kernel *k, buffers *b)
+{
+    pj_timestamp t0, t1;
+    float usec[4];
+    unsigned i;
+
+    pj_get_timestamp(&t0);
+    for (i = 0; i < BENCH_FRAMES; ++i)
+        k->ulaw_encode(b->out8, b->pcm + (i & 0xFF), BENCH_COUNT);
+    pj_get_timestamp(&t1);
+    usec[0] = (float)pj_elapsed_usec(&t0, &t1) / BENCH_FRAMES;
+
+    pj_get_timestamp(&t0);
+    for (i = 0; i < BENCH_FRAMES; ++i)
+        k->alaw_encode(b->out8, b->pcm + (i & 0xFF), BENCH_COUNT);
+    pj_get_timestamp(&t1);
+    usec[1] = (float)pj_elapsed_usec(&t0, &t1) / BENCH_FRAMES;
+
+    pj_get_timestamp(&t0);
+    for (i = 0; i < BENCH_FRAMES; ++i)
+        k->ulaw_decode(b->out16, b->code + (i & 0xFF), BENCH_COUNT);
+    pj_get_timestamp(&t1);
+    usec[2] = (float)pj_elapsed_usec(&t0, &t1) / BENCH_FRAMES;
+
+    pj_get_timestamp(&t0);
+    for (i = 0; i < BENCH_FRAMES; ++i)
+        k->alaw_decode(b->out16, b->code + (i & 0xFF), BENCH_COUNT);
+    pj_get_timestamp(&t1);
+    usec[3] = (float)pj_elapsed_usec(&t0, &t1) / BENCH_FRAMES;
+
+    PJ_LOG(3,(THIS_FILE, "  %-7s %9.3f %9.3f %9.3f %9.3f",
+              k->name, usec[0], usec[1], usec[2], usec[3]));
+}
+#endif
+
+int g711_test(void)
+{
+    pj_pool_t *pool;
+    buffers *b;
+    const pjmedia_g711_kernel *ref, *k;
+    unsigned i;
+    int rc = 0;
+
+    pool = pj_pool_create(mem, "g711", sizeof(buffers) + 1000, 4000, NULL);
+    PJ_TEST_NOT_NULL(pool, "pool create", return -1);
+    b = PJ_POOL_ZALLOC_T(pool, buffers);
+    PJ_TEST_NOT_NULL(b, "buffers alloc", {rc=-2; goto on_return;});
+
+    ref = pjmedia_g711_kernel_get(PJMEDIA_G711_KERNEL_SCALAR);
+    PJ_TEST_NOT_NULL(ref, "scalar kernel", {rc=-3; goto on_return;});
+    k = pjmedia_g711_kernel_get(PJMEDIA_G711_KERNEL_AUTO);
+    PJ_TEST_NOT_NULL(k, "auto kernel", {rc=-4; goto on_return;});
+
+    PJ_LOG(3,(THIS_FILE, "  selected kernel: %s", k->name));
+
+    /* The scalar kernel against the per-sample conversions */
+    for (i = 0; i < 65536; ++i) {
+        pj_int16_t pcm = (pj_int16_t)(i - 32768);
+
+        ref->ulaw_encode(b->out8, &pcm, 1);
+        PJ_TEST_EQ(b->out8[0], pjmedia_linear2ulaw(pcm), "linear2ulaw",
+                   {rc=-5; goto on_return;});
+        ref->alaw_encode(b->out8, &pcm, 1);
+        PJ_TEST_EQ(b->out8[0], pjmedia_linear2alaw(pcm), "linear2alaw",
+                   {rc=-6; goto on_return;});
+    }
+
+    for (i = 0; i < PJ_ARRAY_SIZE(simd_types); ++i) {
+        k = pjmedia_g711_kernel_get(simd_types[i]);
+        if (!k)
+            continue;
+
+        PJ_LOG(3,(THIS_FILE, "  comparing %s with scalar", k->name));
+        rc = compare_kernel(ref, k, b);
+        if (rc != 0)
+            goto on_return;
+    }
+
+#if WITH_BENCHMARK
+    for (i = 0; i < MAX_COUNT; ++i) {
+        b->pcm[i] = (pj_int16_t)(pj_rand() & 0xFFFF);
+        b->code[i] = (pj_uint8_t)pj_rand();
+    }
+
+    PJ_LOG(3,(THIS_FILE, "  usec per %d samples frame:", BENCH_COUNT));
+    PJ_LOG(3,(THIS_FILE, "  kernel   ulaw enc  alaw enc  ulaw dec"
+                         "  alaw dec"));
+    bench_kernel(ref, b);
+    for (i = 0; i < PJ_ARRAY_SIZE(simd_types); ++i) {
+        k = pjmedia_g711_kernel_get(simd_types[i]);
+        if (k)
+            bench_kernel(k, b);
+    }
+#endif
+
+on_return:
+    pj_pool_release(pool);
+    return rc;
+}
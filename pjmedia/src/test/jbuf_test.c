@@ -34,6 +34,8 @@
 
 typedef struct test_param_t {
     pj_bool_t adaptive;
+    pj_bool_t histogram;
+    pj_bool_t stretch;
     unsigned init_prefetch;
     unsigned min_prefetch;
     unsigned max_prefetch;
@@ -46,8 +48,15 @@ typedef struct test_cond_t {
     int empty;
     int delay;      /**< Average delay, in frames.          */
     int delay_min;  /**< Minimum delay, in frames.          */
+    int compress;   /**< Minimum number of compressed GETs. */
+    int expand;     /**< Minimum number of expanded GETs.   */
 } test_cond_t;
 
+typedef struct test_stat_t {
+    unsigned compress;
+    unsigned expand;
+} test_stat_t;
+
 static pj_bool_t parse_test_headers(char *line, test_param_t *param,
                                test_cond_t *cond)
 {
@@ -59,7 +68,11 @@ static pj_bool_t parse_test_headers(char *line, test_param_t *param,
 
         sscanf(p+1, "%s %u %u %u", mode_st, &param->init_prefetch,
                &param->min_prefetch, &param->max_prefetch);
-        param->adaptive = (pj_ansi_stricmp(mode_st, "adaptive") == 0);
+        param->stretch = (pj_ansi_stricmp(mode_st, "stretch") == 0);
+        param->histogram = param->stretch ||
+                           (pj_ansi_stricmp(mode_st, "histogram") == 0);
+        param->adaptive = param->histogram ||
+                          (pj_ansi_stricmp(mode_st, "adaptive") == 0);
 
     } else if (*p == '!') {
         /* Success condition. */
@@ -79,6 +92,10 @@ static pj_bool_t parse_test_headers(char *line, test_param_t *param,
             cond->empty = cond_val;
         else if (pj_ansi_stricmp(cond_st, "lost") == 0)
             cond->lost = cond_val;
+        else if (pj_ansi_stricmp(cond_st, "compress") == 0)
+            cond->compress = cond_val;
+        else if (pj_ansi_stricmp(cond_st, "expand") == 0)
+            cond->expand = cond_val;
 
     } else if (*p == '=') {
         char *newline_pos;
@@ -109,7 +126,36 @@ static pj_bool_t parse_test_headers(char *line, test_param_t *param,
     return PJ_TRUE;
 }
 
+/* Follow the time-stretching request of the jitter buffer on GET, the
+ * same way the stream does: a compressed GET plays two frames in one frame
+ * time, an expanded GET plays a synthetic frame without touching the
+ * jitter buffer.
+ */
+static void get_frame_stretch(pjmedia_jbuf *jb, char *frame,
+                              test_stat_t *stat)
+{
+    char f_type;
+
+    switch (pjmedia_jbuf_get_stretch(jb)) {
+    case PJMEDIA_JB_STRETCH_COMPRESS:
+        pjmedia_jbuf_get_frame(jb, frame, &f_type);
+        pjmedia_jbuf_get_frame(jb, frame, &f_type);
+        pjmedia_jbuf_report_stretch(jb, -1);
+        ++stat->compress;
+        break;
+    case PJMEDIA_JB_STRETCH_EXPAND:
+        pjmedia_jbuf_report_stretch(jb, 1);
+        ++stat->expand;
+        break;
+    default:
+        pjmedia_jbuf_get_frame(jb, frame, &f_type);
+        break;
+    }
+}
+
 static pj_bool_t process_test_data(char data, pjmedia_jbuf *jb,
+                                   const test_param_t *param,
+                                   test_stat_t *stat,
                                    pj_uint16_t *seq, pj_uint16_t *last_seq)
 {
     char frame[1] = {0};
@@ -119,7 +165,10 @@ static pj_bool_t process_test_data(char data, pjmedia_jbuf *jb,
 
     switch (toupper(data)) {
     case 'G': /* Get */
-        pjmedia_jbuf_get_frame(jb, frame, &f_type);
+        if (param->stretch)
+            get_frame_stretch(jb, frame, stat);
+        else
+            pjmedia_jbuf_get_frame(jb, frame, &f_type);
         break;
     case 'P': /* Put */
         pjmedia_jbuf_put_frame(jb, (void*)frame, 1, *seq);
@@ -172,6 +221,140 @@ static pj_bool_t process_test_data(char data, pjmedia_jbuf *jb,
     return PJ_TRUE;
 }
 
+/* Number of ticks and drift of the stream time-stretching test, the
+ * sender puts one extra frame (or skips one) every STRETCH_DRIFT ticks.
+ */
+#define STRETCH_TICKS       500
+#define STRETCH_DRIFT       10
+#define STRETCH_WARMUP      20
+
+/* Run a PCMU stream looped back to itself with the histogram jitter
+ * buffer, so the clock drift is absorbed by WSOLA time-stretching in the
+ * stream instead of by discarding frames or playing empty frames.
+ */
+static int stream_stretch_test(int drift)
+{
+    pjmedia_endpt *endpt = NULL;
+    pjmedia_transport *tp = NULL;
+    pjmedia_stream *stream = NULL;
+    pjmedia_port *port;
+    pj_pool_t *pool;
+    pjmedia_stream_info si;
+    const pjmedia_codec_info *ci[1];
+    pjmedia_jb_state state;
+    pj_str_t codec_id = {"pcmu", 4};
+    pj_int16_t buf[160];
+    unsigned count, spf, phase = 0, tick, i;
+    pj_status_t status;
+    int rc = 0;
+
+    PJ_LOG(3,(THIS_FILE, "--- Stream time-stretching (%s) ---",
+              (drift > 0 ? "PUT > GET" : "PUT < GET")));
+
+    pool = pj_pool_create(mem, "JBSTRETCH", 4000, 4000, NULL);
+    PJ_TEST_NOT_NULL(pool, "pool create", return -200);
+
+    status = pjmedia_endpt_create2(mem, NULL, 0, &endpt);
+    PJ_TEST_SUCCESS(status, "endpt create", {rc = -210; goto on_return;});
+
+    status = pjmedia_codec_g711_init(endpt);
+    PJ_TEST_SUCCESS(status, "g711 init", {rc = -220; goto on_return;});
+
+    count = 1;
+    status = pjmedia_codec_mgr_find_codecs_by_id(
+                            pjmedia_endpt_get_codec_mgr(endpt),
+                            &codec_id, &count, ci, NULL);
+    PJ_TEST_SUCCESS(status, "find pcmu", {rc = -230; goto on_return;});
+
+    pj_bzero(&si, sizeof(si));
+    si.type = PJMEDIA_TYPE_AUDIO;
+    si.proto = PJMEDIA_TP_PROTO_RTP_AVP;
+    si.dir = PJMEDIA_DIR_ENCODING_DECODING;
+    pj_sockaddr_in_init(&si.rem_addr.ipv4, NULL, 4000);
+    pj_sockaddr_in_init(&si.rem_rtcp.ipv4, NULL, 4001);
+    pj_memcpy(&si.fmt, ci[0], sizeof(pjmedia_codec_info));
+    si.tx_pt = ci[0]->pt;
+    si.ssrc = pj_rand();
+    si.jb_init = si.jb_min_pre = si.jb_max_pre = si.jb_max = -1;
+    si.jb_discard_algo = PJMEDIA_JB_DISCARD_HISTOGRAM;
+
+    status = pjmedia_transport_loop_create(endpt, &tp);
+    PJ_TEST_SUCCESS(status, "loop transport create",
+                    {rc = -240; goto on_return;});
+
+    status = pjmedia_stream_create(endpt, pool, &si, tp, NULL, &stream);
+    PJ_TEST_SUCCESS(status, "stream create", {rc = -250; goto on_return;});
+
+    status = pjmedia_stream_start(stream);
+    PJ_TEST_SUCCESS(status, "stream start", {rc = -260; goto on_return;});
+
+    pjmedia_stream_get_port(stream, &port);
+    spf = PJMEDIA_PIA_SPF(&port->info);
+    PJ_TEST_LTE(spf, PJ_ARRAY_SIZE(buf), "samples per frame",
+                {rc = -270; goto on_return;});
+
+    for (tick = 0; tick < STRETCH_TICKS; ++tick) {
+        pjmedia_frame frame;
+        unsigned put_cnt = 1;
+
+        if (tick % STRETCH_DRIFT == STRETCH_DRIFT - 1)
+            put_cnt = (drift > 0 ? 2 : 0);
+
+        /* Sawtooth, so WSOLA has something periodic to work on */
+        while (put_cnt--) {
+            for (i = 0; i < spf; ++i, ++phase)
+                buf[i] = (pj_int16_t)((phase % 40) * 400 - 8000);
+
+            pj_bzero(&frame, sizeof(frame));
+            frame.type = PJMEDIA_FRAME_TYPE_AUDIO;
+            frame.buf = buf;
+            frame.size = spf * sizeof(pj_int16_t);
+            status = pjmedia_port_put_frame(port, &frame);
+            PJ_TEST_SUCCESS(status, "put frame",
+                            {rc = -280; goto on_return;});
+        }
+
+        pj_bzero(&frame, sizeof(frame));
+        frame.buf = buf;
+        frame.size = spf * sizeof(pj_int16_t);
+        status = pjmedia_port_get_frame(port, &frame);
+        PJ_TEST_SUCCESS(status, "get frame", {rc = -290; goto on_return;});
+
+        /* Every frame played is audio, either decoded or stretched */
+        if (tick >= STRETCH_WARMUP) {
+            PJ_TEST_EQ(frame.type, PJMEDIA_FRAME_TYPE_AUDIO, "frame type",
+                       {rc = -300; goto on_return;});
+            PJ_TEST_GT(pjmedia_calc_avg_signal(buf, spf), 1000,
+                       "stretched frame is not silent",
+                       {rc = -310; goto on_return;});
+        }
+    }
+
+    pjmedia_stream_get_stat_jbuf(stream, &state);
+    PJ_LOG(3,(THIS_FILE, "  size=%d discard=%d empty=%d lost=%d",
+              state.size, state.discard, state.empty, state.lost));
+
+    /* There is STRETCH_TICKS/STRETCH_DRIFT frames of drift, without
+     * time-stretching they would be discarded or played as empty frames.
+     */
+    PJ_TEST_EQ(state.discard, 0, "frames discarded",
+               {rc = -320; goto on_return;});
+    PJ_TEST_LTE(state.size, 6, "jitter buffer size",
+                {rc = -330; goto on_return;});
+    PJ_TEST_LTE(state.empty, STRETCH_TICKS / STRETCH_DRIFT / 5,
+                "empty frames", {rc = -340; goto on_return;});
+
+on_return:
+    if (stream)
+        pjmedia_stream_destroy(stream);
+    if (tp)
+        pjmedia_transport_close(tp);
+    if (endpt)
+        pjmedia_endpt_destroy(endpt);
+    pj_pool_release(pool);
+    return rc;
+}
+
 int jbuf_test(void)
 {
     FILE *input;
@@ -219,8 +402,11 @@ int jbuf_test(void)
 
         test_param_t param;
         test_cond_t cond;
+        test_stat_t stat;
 
         param.adaptive = PJ_TRUE;
+        param.histogram = PJ_FALSE;
+        param.stretch = PJ_FALSE;
         param.init_prefetch = JB_INIT_PREFETCH;
         param.min_prefetch = JB_MIN_PREFETCH;
         param.max_prefetch = JB_MAX_PREFETCH;
@@ -231,6 +417,10 @@ int jbuf_test(void)
         cond.discard = -1;
         cond.empty = -1;
         cond.lost = -1;
+        cond.compress = -1;
+        cond.expand = -1;
+
+        pj_bzero(&stat, sizeof(stat));
 
         PJ_LOG(3,(THIS_FILE, "%s", ""));
 
@@ -253,6 +443,8 @@ int jbuf_test(void)
                                       param.init_prefetch,
                                       param.min_prefetch,
                                       param.max_prefetch);
+            if (param.histogram)
+                pjmedia_jbuf_set_discard(jb, PJMEDIA_JB_DISCARD_HISTOGRAM);
         } else {
             pjmedia_jbuf_set_fixed(jb, param.init_prefetch);
         }
@@ -296,7 +488,7 @@ int jbuf_test(void)
             }
 
             /* Process test data */
-            if (!process_test_data(c, jb, &seq, &last_seq))
+            if (!process_test_data(c, jb, &param, &stat, &seq, &last_seq))
                 break;
         }
 
@@ -310,6 +502,10 @@ int jbuf_test(void)
                   state.dev_delay));
         PJ_LOG(3,(THIS_FILE, "  lost=%d discard=%d empty=%d burst(avg)=%d",
                   state.lost, state.discard, state.empty, state.avg_burst));
+        if (param.stretch) {
+            PJ_LOG(3,(THIS_FILE, "  compress=%u expand=%u",
+                      stat.compress, stat.expand));
+        }
 
         /* Evaluate test session */
         if (cond.burst >= 0 && (int)state.avg_burst > cond.burst) {
@@ -342,6 +538,16 @@ int jbuf_test(void)
                       cond.lost, state.lost));
             rc |= 16;
         }
+        if (cond.compress >= 0 && (int)stat.compress < cond.compress) {
+            PJ_LOG(3,(THIS_FILE, "! 'Compress' should be at least %d, it is %d",
+                      cond.compress, stat.compress));
+            rc |= 64;
+        }
+        if (cond.expand >= 0 && (int)stat.expand < cond.expand) {
+            PJ_LOG(3,(THIS_FILE, "! 'Expand' should be at least %d, it is %d",
+                      cond.expand, stat.expand));
+            rc |= 128;
+        }
 
         pjmedia_jbuf_destroy(jb);
         pj_pool_release(pool);
@@ -350,5 +556,10 @@ int jbuf_test(void)
     fclose(input);
     pj_log_set_level(old_log_level);
 
+    if (rc == 0)
+        rc = stream_stretch_test(1);
+    if (rc == 0)
+        rc = stream_stretch_test(-1);
+
     return rc;
 }
@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <pjmedia/mix_kernel.h>
+#include <pj/log.h>
+#include <pj/os.h>
+#include <pj/pool.h>
+#include <pj/rand.h>
+#include <pj/string.h>
+#include "test.h"
+
+#define THIS_FILE       "mix_kernel_test.c"
+
+/* Largest count of samples to test, plus room for misaligned start. */
+#define MAX_COUNT       (960 + 16)
+
+/* Number of random rounds for each kernel. */
+#define ROUNDS          2000
+
+/* Benchmark: frame size (20ms at 48KHz) and number of frames. */
+#define BENCH_COUNT     960
+#define BENCH_FRAMES    20000
+
+typedef struct buffers
+{
+    pj_int16_t  src16[MAX_COUNT];
+    pj_int16_t  sub16[MAX_COUNT];
+    pj_int32_t  src32[MAX_COUNT];
+    pj_int16_t  ref16[MAX_COUNT];
+    pj_int16_t  out16[MAX_COUNT];
+    pj_int32_t  ref32[MAX_COUNT];
+    pj_int32_t  out32[MAX_COUNT];
+} buffers;
+
+static const pjmedia_mix_kernel_type simd_types[] =
+{
+    PJMEDIA_MIX_KERNEL_SSE2,
+    PJMEDIA_MIX_KERNEL_AVX2,
+    PJMEDIA_MIX_KERNEL_NEON
+};
+
+/* Random sample, with a good share of extreme values. */
+static pj_int16_t rand_sample(void)
+{
+    switch (pj_rand() % 8) {
+    case 0:
+        return -32768;
+    case 1:
+        return 32767;
+    default:
+        return (pj_int16_t)(pj_rand() & 0xFFFF);
+    }
+}
+
+/* Random mix buffer value, possibly overflowing 16-bit. */
+static pj_int32_t rand_mix(void)
+{
+    return (pj_int32_t)((pj_rand() & 0x3FFFF) - 0x20000);
+}
+
+static unsigned rand_gain(void)
+{
+    static const unsigned gains[] = { 0, 1, 64, 127, 128, 129, 255, 1000,
+                                     40000 };
+    return gains[pj_rand() % PJ_ARRAY_SIZE(gains)];
+}
+
+/* Compare kernel k against the scalar reference with random input. */
+static int compare_kernel(const pjmedia_mix_kernel *ref,
+                          const pjmedia_mix_kernel *k, buffers *b)
+{
+    unsigned round, i;
+
+    for (round = 0; round < ROUNDS; ++round) {
+        unsigned off = pj_rand() % 16;
+        unsigned count = pj_rand() % (MAX_COUNT - 16 + 1);
+        unsigned gain = rand_gain();
+        pj_int32_t rmin, rmax, omin, omax;
+        pj_uint32_t rsum, osum;
+
+        for (i = 0; i < MAX_COUNT; ++i) {
+            b->src16[i] = rand_sample();
+            b->sub16[i] = rand_sample();
+            b->src32[i] = rand_mix();
+            b->ref32[i] = b->out32[i] = rand_mix();
+        }
+
+        /* sum_abs */
+        rsum = ref->sum_abs(b->src16 + off, count);
+        osum = k->sum_abs(b->src16 + off, count);
+        PJ_TEST_EQ(osum, rsum, "sum_abs", return -10);
+
+        /* apply_gain, out of place and in place */
+        rsum = ref->apply_gain(b->ref16, b->src16 + off, gain, count);
+        osum = k->apply_gain(b->out16, b->src16 + off, gain, count);
+        PJ_TEST_EQ(osum, rsum, "apply_gain level", return -20);
+        PJ_TEST_EQ(pj_memcmp(b->out16, b->ref16, count * 2), 0,
+                   "apply_gain samples", return -21);
+        pj_memcpy(b->out16, b->src16 + off, count * 2);
+        osum = k->apply_gain(b->out16, b->out16, gain, count);
+        PJ_TEST_EQ(osum, rsum, "apply_gain in place level", return -22);
+        PJ_TEST_EQ(pj_memcmp(b->out16, b->ref16, count * 2), 0,
+                   "apply_gain in place samples", return -23);
+
+        /* accumulate, with and without range */
+        rmin = omin = (pj_int32_t)(pj_rand() % 1000) - 1000;
+        rmax = omax = (pj_int32_t)(pj_rand() % 1000);
+        ref->accumulate(b->ref32, b->src16 + off, count, &rmin, &rmax);
+        k->accumulate(b->out32, b->src16 + off, count, &omin, &omax);
+        PJ_TEST_EQ(pj_memcmp(b->out32, b->ref32, count * 4), 0,
+                   "accumulate samples", return -30);
+        PJ_TEST_EQ(omin, rmin, "accumulate min", return -31);
+        PJ_TEST_EQ(omax, rmax, "accumulate max", return -32);
+        ref->accumulate(b->ref32, b->sub16, count, NULL, NULL);
+        k->accumulate(b->out32, b->sub16, count, NULL, NULL);
+        PJ_TEST_EQ(pj_memcmp(b->out32, b->ref32, count * 4), 0,
+                   "accumulate no range", return -33);
+
+        /* accumulate32, with and without subtraction */
+        rmin = omin = 0;
+        rmax = omax = 0;
+        ref->accumulate32(b->ref32, b->src32 + off, b->sub16, count,
+                          &rmin, &rmax);
+        k->accumulate32(b->out32, b->src32 + off, b->sub16, count,
+                        &omin, &omax);
+        PJ_TEST_EQ(pj_memcmp(b->out32, b->ref32, count * 4), 0,
+                   "accumulate32 samples", return -40);
+        PJ_TEST_EQ(omin, rmin, "accumulate32 min", return -41);
+        PJ_TEST_EQ(omax, rmax, "accumulate32 max", return -42);
+        ref->accumulate32(b->ref32, b->src32, NULL, count, NULL, NULL);
+        k->accumulate32(b->out32, b->src32, NULL, count, NULL, NULL);
+        PJ_TEST_EQ(pj_memcmp(b->out32, b->ref32, count * 4), 0,
+                   "accumulate32 no sub", return -43);
+
+        /* clamp */
+        rsum = ref->clamp(b->ref16, b->src32 + off, gain, count);
+        osum = k->clamp(b->out16, b->src32 + off, gain, count);
+        PJ_TEST_EQ(osum, rsum, "clamp level", return -50);
+        PJ_TEST_EQ(pj_memcmp(b->out16, b->ref16, count * 2), 0,
+                   "clamp samples", return -51);
+        pj_memcpy(b->out32, b->src32 + off, count * 4);
+        osum = k->clamp((pj_int16_t*)b->out32, b->out32, gain, count);
+        PJ_TEST_EQ(osum, rsum, "clamp in place level", return -52);
+        PJ_TEST_EQ(pj_memcmp(b->out32, b->ref16, count * 2), 0,
+                   "clamp in place samples", return -53);
+
+        /* accumulate and accumulate32 with a range not including zero,
+         * e.g. all positive samples.
+         */
+        for (i = 0; i < MAX_COUNT; ++i) {
+            b->src16[i] = (pj_int16_t)(pj_rand() % 1000 + 1);
+            b->sub16[i] = 0;
+            b->src32[i] = (pj_int32_t)(pj_rand() % 1000 + 1);
+            b->ref32[i] = b->out32[i] = (pj_int32_t)(pj_rand() % 1000 + 1);
+        }
+        rmin = omin = 0x7FFFFFFF;
+        rmax = omax = 1;
+        ref->accumulate(b->ref32, b->src16 + off, count, &rmin, &rmax);
+        k->accumulate(b->out32, b->src16 + off, count, &omin, &omax);
+        PJ_TEST_EQ(omin, rmin, "positive accumulate min", return -60);
+        PJ_TEST_EQ(omax, rmax, "positive accumulate max", return -61);
+        rmin = omin = 0x7FFFFFFF;
+        rmax = omax = 1;
+        ref->accumulate32(b->ref32, b->src32 + off, b->sub16, count,
+                          &rmin, &rmax);
+        k->accumulate32(b->out32, b->src32 + off, b->sub16, count,
+                        &omin, &omax);
+        PJ_TEST_EQ(omin, rmin, "positive accumulate32 min", return -62);
+        PJ_TEST_EQ(omax, rmax, "positive accumulate32 max", return -63);
+        PJ_TEST_EQ(pj_memcmp(b->out32, b->ref32, count * 4), 0,
+                   "positive accumulate samples", return -64);
+    }
+
+    return 0;
+}
+
+#if WITH_BENCHMARK
+/* Time the kernels processing BENCH_FRAMES frames, in usec per frame. */
+static void bench_kernel(const pjmedia_mix_kernel *k, buffers *b)
+{
+    pj_timestamp t0, t1;
+    pj_uint32_t sink = 0;
+    pj_int32_t vmin = 0, vmax = 0;
+    float usec[5];
+    unsigned i;
+
+    pj_get_timestamp(&t0);
+    for (i = 0; i < BENCH_FRAMES; ++i)
+        sink += k->sum_abs(b->src16, BENCH_COUNT);
+    pj_get_timestamp(&t1);
+    usec[0] = (float)pj_elapsed_usec(&t0, &t1) / BENCH_FRAMES;
+
+    pj_get_timestamp(&t0);
+    for (i = 0; i < BENCH_FRAMES; ++i)
+        sink += k->apply_gain(b->out16, b->src16, 100, BENCH_COUNT);
+    pj_get_timestamp(&t1);
+    usec[1] = (float)pj_elapsed_usec(&t0, &t1) / BENCH_FRAMES;
+
+    pj_get_timestamp(&t0);
+    for (i = 0; i < BENCH_FRAMES; ++i)
+        k->accumulate(b->out32, b->src16, BENCH_COUNT, &vmin, &vmax);
+    pj_get_timestamp(&t1);
+    usec[2] = (float)pj_elapsed_usec(&t0, &t1) / BENCH_FRAMES;
+
+    pj_get_timestamp(&t0);
+    for (i = 0; i < BENCH_FRAMES; ++i)
+        k->accumulate32(b->out32, b->src32, b->sub16, BENCH_COUNT,
+                        &vmin, &vmax);
+    pj_get_timestamp(&t1);
+    usec[3] = (float)pj_elapsed_usec(&t0, &t1) / BENCH_FRAMES;
+
+    pj_get_timestamp(&t0);
+    for (i = 0; i < BENCH_FRAMES; ++i)
+        sink += k->clamp(b->out16, b->src32, 100, BENCH_COUNT);
+    pj_get_timestamp(&t1);
+    usec[4] = (float)pj_elapsed_usec(&t0, &t1) / BENCH_FRAMES;
+
+    PJ_LOG(3,(THIS_FILE, "  %-7s %9.3f %9.3f %9.3f %9.3f %9.3f",
+              k->name, usec[0], usec[1], usec[2], usec[3], usec[4]));
+
+    /* Keep the results alive */
+    if (sink == 1 && vmin == vmax)
+        PJ_LOG(5,(THIS_FILE, "."));
+}
+#endif
+
+int mix_kernel_test(void)
+{
+    pj_pool_t *pool;
+    buffers *b;
+    const pjmedia_mix_kernel *ref, *k;
+    unsigned i;
+    int rc = 0;
+
+    pool = pj_pool_create(mem, "mixkernel", 4000, 4000, NULL);
+    PJ_TEST_NOT_NULL(pool, "pool create", return -1);
+    b = PJ_POOL_ZALLOC_T(pool, buffers);
+    PJ_TEST_NOT_NULL(b, "buffers alloc", {rc=-2; goto on_return;});
+
+    ref = pjmedia_mix_kernel_get(PJMEDIA_MIX_KERNEL_SCALAR);
+    PJ_TEST_NOT_NULL(ref, "scalar kernel", {rc=-3; goto on_return;});
+    k = pjmedia_mix_kernel_get(PJMEDIA_MIX_KERNEL_AUTO);
+    PJ_TEST_NOT_NULL(k, "auto kernel", {rc=-4; goto on_return;});
+
+    PJ_LOG(3,(THIS_FILE, "  selected kernel: %s", k->name));
+
+    for (i = 0; i < PJ_ARRAY_SIZE(simd_types); ++i) {
+        k = pjmedia_mix_kernel_get(simd_types[i]);
+        if (!k)
+            continue;
+
+        PJ_LOG(3,(THIS_FILE, "  comparing %s with scalar", k->name));
+        rc = compare_kernel(ref, k, b);
+        if (rc != 0)
+            goto on_return;
+    }
+
+#if WITH_BENCHMARK
+    for (i = 0; i < BENCH_COUNT; ++i) {
+        b->src16[i] = (pj_int16_t)(pj_rand() & 0xFFFF);
+        b->sub16[i] = (pj_int16_t)(pj_rand() & 0xFFFF);
+        /* Small, so that repeated accumulation doesn't overflow */
+        b->src32[i] = (pj_int32_t)(pj_rand() % 256) - 128;
+    }
+
+    PJ_LOG(3,(THIS_FILE, "  usec per %d samples frame:", BENCH_COUNT));
+    PJ_LOG(3,(THIS_FILE, "  kernel    sum_abs      gain       acc     acc32"
+                         "     clamp"));
+    bench_kernel(ref, b);
+    for (i = 0; i < PJ_ARRAY_SIZE(simd_types); ++i) {
+        k = pjmedia_mix_kernel_get(simd_types[i]);
+        if (k)
+            bench_kernel(k, b);
+    }
+#endif
+
+on_return:
+    pj_pool_release(pool);
+    return rc;
+}
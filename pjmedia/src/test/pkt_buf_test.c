@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <pjmedia/pkt_buf.h>
+#include <pjmedia/jbuf.h>
+#include <pj/log.h>
+#include <pj/os.h>
+#include <pj/pool.h>
+#include <pj/string.h>
+#include "test.h"
+
+#define THIS_FILE       "pkt_buf_test.c"
+
+#define BUF_SIZE        200
+#define FRAME_SIZE      160
+#define THREAD_CNT      4
+#define LOOP_CNT        20000
+#define HELD_CNT        (PJMEDIA_PKT_BUF_CACHE_SIZE * 3)
+
+typedef struct worker_arg
+{
+    pjmedia_pkt_buf_pool *pool;
+    pj_uint8_t           id;
+    pj_bool_t            corrupt;
+    pj_status_t          status;
+} worker_arg;
+
+/* Allocate and release buffers in bursts, so that buffers move between
+ * the thread caches and the shared free list, and check that no buffer
+ * is given to two users at once.
+ */
+static int worker_proc(void *arg)
+{
+    worker_arg *w = (worker_arg*)arg;
+    pjmedia_pkt_buf *held[HELD_CNT];
+    unsigned i, j, n;
+
+    for (i = 0; i < LOOP_CNT; i += n) {
+        n = 1 + (i % HELD_CNT);
+
+        for (j = 0; j < n; ++j) {
+            w->status = pjmedia_pkt_buf_alloc(w->pool, &held[j]);
+            if (w->status != PJ_SUCCESS)
+                return -1;
+            pj_memset(held[j]->buf, w->id, BUF_SIZE);
+        }
+
+        for (j = 0; j < n; ++j) {
+            const pj_uint8_t *p = (const pj_uint8_t*)held[j]->buf;
+
+            if (p[0] != w->id || p[BUF_SIZE-1] != w->id)
+                w->corrupt = PJ_TRUE;
+            pjmedia_pkt_buf_add_ref(held[j]);
+            pjmedia_pkt_buf_dec_ref(held[j]);
+            pjmedia_pkt_buf_dec_ref(held[j]);
+        }
+    }
+
+    return 0;
+}
+
+static int refcount_test(pjmedia_pkt_buf_pool *pool)
+{
+    pjmedia_pkt_buf *b1, *b2, *b3;
+    pj_status_t status;
+
+    status = pjmedia_pkt_buf_alloc(pool, &b1);
+    PJ_TEST_SUCCESS(status, "alloc", return -10);
+    status = pjmedia_pkt_buf_alloc(pool, &b2);
+    PJ_TEST_SUCCESS(status, "alloc", return -11);
+
+    PJ_TEST_TRUE(b1 != b2 && b1->buf != b2->buf, "distinct buffers",
+                 return -12);
+    PJ_TEST_EQ(b1->size, BUF_SIZE, "buffer size", return -13);
+    PJ_TEST_EQ(b1->len, 0, "buffer len", return -14);
+    PJ_TEST_EQ(pj_atomic_get(b1->ref_cnt), 1, "initial ref", return -15);
+
+    PJ_TEST_TRUE(pjmedia_pkt_buf_contains(b1, (char*)b1->buf + 10, 20),
+                 "contains", return -16);
+    PJ_TEST_TRUE(!pjmedia_pkt_buf_contains(b1, (char*)b1->buf + 10,
+                                           BUF_SIZE), "past end",
+                 return -17);
+    PJ_TEST_TRUE(!pjmedia_pkt_buf_contains(b1, b2->buf, 1), "other buffer",
+                 return -18);
+
+    /* A buffer is only reused after its last reference is gone */
+    pjmedia_pkt_buf_add_ref(b1);
+    pjmedia_pkt_buf_dec_ref(b1);
+    status = pjmedia_pkt_buf_alloc(pool, &b3);
+    PJ_TEST_SUCCESS(status, "alloc", return -20);
+    PJ_TEST_TRUE(b3 != b1 && b3 != b2, "buffer still referenced reused",
+                 return -21);
+
+    pjmedia_pkt_buf_dec_ref(b1);
+    pjmedia_pkt_buf_dec_ref(b3);
+    status = pjmedia_pkt_buf_alloc(pool, &b1);
+    PJ_TEST_SUCCESS(status, "alloc", return -22);
+    PJ_TEST_TRUE(b1 == b3, "free buffer not reused from the cache",
+                 return -23);
+
+    pjmedia_pkt_buf_dec_ref(b1);
+    pjmedia_pkt_buf_dec_ref(b2);
+    return 0;
+}
+
+/* The jitter buffer keeps a reference to frames put by reference until
+ * they are retrieved or dropped.
+ */
+static int jbuf_ref_test(pjmedia_pkt_buf_pool *pool)
+{
+    pj_pool_t *mpool;
+    pjmedia_jbuf *jb;
+    pj_str_t jb_name = pj_str("pktbufjb");
+    pjmedia_pkt_buf *pkt[3];
+    char frame[FRAME_SIZE];
+    pj_size_t size;
+    char type;
+    pj_bool_t discarded;
+    unsigned i;
+    pj_status_t status;
+    int rc = 0;
+
+    mpool = pj_pool_create(mem, "pktbufjb", 4000, 4000, NULL);
+    PJ_TEST_NOT_NULL(mpool, "pool create", return -30);
+
+    pj_bzero(pkt, sizeof(pkt));
+    status = pjmedia_jbuf_create(mpool, &jb_name, FRAME_SIZE, 20, 10, &jb);
+    PJ_TEST_SUCCESS(status, "jbuf create", {rc=-31; goto on_return;});
+    pjmedia_jbuf_set_fixed(jb, 0);
+
+    for (i = 0; i < PJ_ARRAY_SIZE(pkt); ++i) {
+        status = pjmedia_pkt_buf_alloc(pool, &pkt[i]);
+        PJ_TEST_SUCCESS(status, "alloc", {rc=-32; goto on_return;});
+
+        /* The payload follows a 12 bytes header in the packet */
+        pj_memset(pkt[i]->buf, 0, 12);
+        pj_memset((char*)pkt[i]->buf + 12, 'a' + i, FRAME_SIZE);
+        pjmedia_jbuf_put_frame_ref(jb, pkt[i], (char*)pkt[i]->buf + 12,
+                                   FRAME_SIZE, 0, i, 0, &discarded);
+        PJ_TEST_TRUE(!discarded, "frame discarded", {rc=-33; goto on_return;});
+        PJ_TEST_EQ(pj_atomic_get(pkt[i]->ref_cnt), 2, "jbuf reference",
+                   {rc=-34; goto on_return;});
+    }
+
+    /* A duplicate must not take another reference */
+    pjmedia_jbuf_put_frame_ref(jb, pkt[1], (char*)pkt[1]->buf + 12,
+                               FRAME_SIZE, 0, 1, 0, &discarded);
+    PJ_TEST_TRUE(discarded, "duplicate accepted", {rc=-35; goto on_return;});
+    PJ_TEST_EQ(pj_atomic_get(pkt[1]->ref_cnt), 2, "duplicate reference",
+               {rc=-36; goto on_return;});
+
+    size = sizeof(frame);
+    pjmedia_jbuf_get_frame2(jb, frame, &size, &type, NULL);
+    PJ_TEST_EQ(type, PJMEDIA_JB_NORMAL_FRAME, "frame type",
+               {rc=-40; goto on_return;});
+    PJ_TEST_EQ(size, FRAME_SIZE, "frame size", {rc=-41; goto on_return;});
+    PJ_TEST_TRUE(frame[0] == 'a' && frame[FRAME_SIZE-1] == 'a',
+                 "frame content", {rc=-42; goto on_return;});
+    PJ_TEST_EQ(pj_atomic_get(pkt[0]->ref_cnt), 1, "released after get",
+               {rc=-43; goto on_return;});
+
+    pjmedia_jbuf_remove_frame(jb, 1);
+    PJ_TEST_EQ(pj_atomic_get(pkt[1]->ref_cnt), 1, "released after remove",
+               {rc=-44; goto on_return;});
+
+    pjmedia_jbuf_reset(jb);
+    PJ_TEST_EQ(pj_atomic_get(pkt[2]->ref_cnt), 1, "released after reset",
+               {rc=-45; goto on_return;});
+
+    /* Without a packet buffer the frame is copied */
+    pjmedia_jbuf_put_frame_ref(jb, NULL, frame, FRAME_SIZE, 0, 10, 0,
+                               &discarded);
+    pjmedia_jbuf_put_frame_ref(jb, pkt[2], (char*)pkt[2]->buf + 12,
+                               FRAME_SIZE, 0, 11, 0, &discarded);
+    pjmedia_jbuf_destroy(jb);
+    PJ_TEST_EQ(pj_atomic_get(pkt[2]->ref_cnt), 1, "released after destroy",
+               {rc=-46; goto on_return;});
+
+on_return:
+    for (i = 0; i < PJ_ARRAY_SIZE(pkt); ++i) {
+        if (pkt[i])
+            pjmedia_pkt_buf_dec_ref(pkt[i]);
+    }
+    pj_pool_release(mpool);
+    return rc;
+}
+
+static int thread_test(pjmedia_pkt_buf_pool *pool)
+{
+    pj_pool_t *mpool;
+    pj_thread_t *threads[THREAD_CNT];
+    worker_arg args[THREAD_CNT];
+    unsigned i;
+    pj_status_t status;
+    int rc = 0;
+
+    mpool = pj_pool_create(mem, "pktbufth", 4000, 4000, NULL);
+    PJ_TEST_NOT_NULL(mpool, "pool create", return -50);
+
+    pj_bzero(threads, sizeof(threads));
+    pj_bzero(args, sizeof(args));
+    for (i = 0; i < THREAD_CNT; ++i) {
+        args[i].pool = pool;
+        args[i].id = (pj_uint8_t)(i + 1);
+        status = pj_thread_create(mpool, "pktbuf%p", &worker_proc, &args[i],
+                                  0, 0, &threads[i]);
+        PJ_TEST_SUCCESS(status, "thread create", {rc=-51; break;});
+    }
+
+    for (i = 0; i < THREAD_CNT; ++i) {
+        if (!threads[i])
+            continue;
+        pj_thread_join(threads[i]);
+        pj_thread_destroy(threads[i]);
+
+        if (rc == 0) {
+            PJ_TEST_SUCCESS(args[i].status, "alloc in thread", rc=-52);
+            PJ_TEST_TRUE(!args[i].corrupt, "buffer shared by two users",
+                         rc=-53);
+        }
+    }
+
+    pj_pool_release(mpool);
+    return rc;
+}
+
+int pkt_buf_test(void)
+{
+    pjmedia_pkt_buf_pool *pool;
+    pjmedia_pkt_buf *held;
+    pj_status_t status;
+    int rc;
+
+    status = pjmedia_pkt_buf_pool_create(mem, "pktbuftest", BUF_SIZE, 2,
+                                         &pool);
+    PJ_TEST_SUCCESS(status, "pool create", return -1);
+
+    rc = refcount_test(pool);
+    if (rc == 0)
+        rc = jbuf_ref_test(pool);
+    if (rc == 0)
+        rc = thread_test(pool);
+
+    /* The pool lives on until the last buffer is released */
+    status = pjmedia_pkt_buf_alloc(pool, &held);
+    PJ_TEST_SUCCESS(status, "alloc", {pjmedia_pkt_buf_pool_destroy(pool);
+                                      return -60;});
+    pjmedia_pkt_buf_pool_destroy(pool);
+    pj_memset(held->buf, 0, held->size);
+    pjmedia_pkt_buf_dec_ref(held);
+
+    return rc;
+}
@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <pjmedia/resample.h>
+#include <pj/log.h>
+#include <pj/math.h>
+#include <pj/os.h>
+#include <pj/pool.h>
+#include "test.h"
+
+#include <math.h>
+
+#define THIS_FILE       "resample_test.c"
+
+/* Frame length and number of frames to convert for each rate pair. The
+ * first frames are skipped from the measurement to let the filter settle.
+ */
+#define FRAME_MSEC      20
+#define FRAMES          25
+#define SKIP_FRAMES     5
+
+/* Test tone amplitude, and frequencies for the first and second channel */
+#define AMPLITUDE       16000
+#define FREQ_LEFT       1000
+#define FREQ_RIGHT      1500
+
+/* Largest frame, all channels */
+#define MAX_FRAME       (48000 * FRAME_MSEC / 1000 * 2)
+
+/* Benchmark: number of frames */
+#define BENCH_FRAMES    5000
+
+static const unsigned rates[] = { 8000, 16000, 32000, 48000 };
+
+static const struct
+{
+    const char  *name;
+    pj_bool_t    high_quality;
+    pj_bool_t    large_filter;
+    int          min_snr;       /* dB */
+} qualities[] =
+{
+    { "large",  PJ_TRUE,  PJ_TRUE,  40 },
+    { "small",  PJ_TRUE,  PJ_FALSE, 40 },
+    { "linear", PJ_FALSE, PJ_FALSE, 20 }
+};
+
+typedef struct tone_fit
+{
+    double      sum_sin;
+    double      sum_cos;
+    double      sum_sq;
+    unsigned    count;
+} tone_fit;
+
+/* Accumulate a sample at time n for fitting a tone of angular freq w. */
+static void fit_add(tone_fit *fit, double w, unsigned n, pj_int16_t sample)
+{
+    fit->sum_sin += sample * sin(w * n);
+    fit->sum_cos += sample * cos(w * n);
+    fit->sum_sq += (double)sample * sample;
+    fit->count++;
+}
+
+/* Get the amplitude of the tone and the SNR, in dB, of the signal. The
+ * measurement spans a whole number of periods of the tone.
+ */
+static void fit_get(const tone_fit *fit, int *amplitude, int *snr)
+{
+    double a = 2.0 * fit->sum_sin / fit->count;
+    double b = 2.0 * fit->sum_cos / fit->count;
+    double signal = (a * a + b * b) * fit->count / 2.0;
+    double noise = fit->sum_sq - signal;
+
+    *amplitude = (int)(sqrt(a * a + b * b) + 0.5);
+    if (noise < 1.0)
+        noise = 1.0;
+    *snr = (int)(10.0 * log10(signal / noise));
+}
+
+static int test_convert(pj_pool_t *pool, unsigned q, unsigned channel_count,
+                        unsigned rate_in, unsigned rate_out,
+                        unsigned frame_msec)
+{
+    pjmedia_resample *resample;
+    pj_int16_t input[MAX_FRAME], output[MAX_FRAME];
+    unsigned in_len = rate_in * frame_msec / 1000;
+    unsigned out_len = rate_out * frame_msec / 1000;
+    static const unsigned freq[2] = { FREQ_LEFT, FREQ_RIGHT };
+    tone_fit fit[2];
+    unsigned f, i, ch;
+
+    PJ_TEST_SUCCESS(pjmedia_resample_create(pool, qualities[q].high_quality,
+                                            qualities[q].large_filter,
+                                            channel_count, rate_in,
+                                            rate_out,
+                                            in_len * channel_count,
+                                            &resample),
+                    NULL, return -10);
+    PJ_TEST_EQ(pjmedia_resample_get_input_size(resample),
+               in_len * channel_count, NULL,
+               {pjmedia_resample_destroy(resample); return -20;});
+
+    pj_bzero(fit, sizeof(fit));
+
+    for (f = 0; f < FRAMES; ++f) {
+        for (i = 0; i < in_len; ++i) {
+            unsigned n = f * in_len + i;
+
+            for (ch = 0; ch < channel_count; ++ch) {
+                double w = 2.0 * PJ_PI * freq[ch] / rate_in;
+                input[i * channel_count + ch] =
+                    (pj_int16_t)(AMPLITUDE * sin(w * n));
+            }
+        }
+
+        pjmedia_resample_run(resample, input, output);
+
+        if (f < SKIP_FRAMES)
+            continue;
+
+        for (i = 0; i < out_len; ++i) {
+            unsigned n = f * out_len + i;
+
+            for (ch = 0; ch < channel_count; ++ch) {
+                double w = 2.0 * PJ_PI * freq[ch] / rate_out;
+                fit_add(&fit[ch], w, n, output[i * channel_count + ch]);
+            }
+        }
+    }
+
+    pjmedia_resample_destroy(resample);
+
+    for (ch = 0; ch < channel_count; ++ch) {
+        int amplitude, snr;
+
+        fit_get(&fit[ch], &amplitude, &snr);
+        PJ_LOG(4,(THIS_FILE, "    %s %5d -> %5d ch%d: amplitude=%d snr=%ddB",
+                  qualities[q].name, rate_in, rate_out, ch, amplitude, snr));
+
+        /* Within 1 dB of the input tone */
+        PJ_TEST_GTE(amplitude, AMPLITUDE * 89 / 100, "tone attenuated",
+                    return -30);
+        PJ_TEST_LTE(amplitude, AMPLITUDE * 112 / 100, "tone amplified",
+                    return -40);
+        PJ_TEST_GTE(snr, qualities[q].min_snr, "low SNR", return -50);
+    }
+
+    return 0;
+}
+
+/* Rate pair that doesn't divide evenly: 8000 to 11025 Hz gives 110.25
+ * output samples per 10 ms frame, and a whole number only for multiples
+ * of 40 ms.
+ */
+static int test_uneven_ratio(pj_pool_t *pool, unsigned q)
+{
+    pjmedia_resample *resample;
+    pj_status_t status;
+
+    status = pjmedia_resample_create(pool, qualities[q].high_quality,
+                                     qualities[q].large_filter, 1, 8000,
+                                     11025, 80, &resample);
+#if PJMEDIA_RESAMPLE_IMP==PJMEDIA_RESAMPLE_POLYPHASE
+    /* Every frame must start at filter phase zero */
+    PJ_TEST_EQ(status, PJ_ENOTSUP, "fractional output frame accepted",
+               {if (status == PJ_SUCCESS) pjmedia_resample_destroy(resample);
+                return -60;});
+#else
+    if (status == PJ_SUCCESS)
+        pjmedia_resample_destroy(resample);
+#endif
+
+    return test_convert(pool, q, 1, 8000, 11025, 40);
+}
+
+#if WITH_BENCHMARK
+/* Time the conversion of BENCH_FRAMES mono frames, in usec per frame. */
+static int bench_convert(pj_pool_t *pool, unsigned q, unsigned rate_in,
+                         unsigned rate_out, float *usec)
+{
+    pjmedia_resample *resample;
+    pj_int16_t input[MAX_FRAME], output[MAX_FRAME];
+    unsigned in_len = rate_in * FRAME_MSEC / 1000;
+    pj_timestamp t0, t1;
+    unsigned i;
+
+    PJ_TEST_SUCCESS(pjmedia_resample_create(pool, qualities[q].high_quality,
+                                            qualities[q].large_filter, 1,
+                                            rate_in, rate_out, in_len,
+                                            &resample),
+                    NULL, return -100);
+
+    for (i = 0; i < in_len; ++i)
+        input[i] = (pj_int16_t)(AMPLITUDE * sin(2.0 * PJ_PI * i / 16));
+
+    pj_get_timestamp(&t0);
+    for (i = 0; i < BENCH_FRAMES; ++i)
+        pjmedia_resample_run(resample, input, output);
+    pj_get_timestamp(&t1);
+    *usec = (float)pj_elapsed_usec(&t0, &t1) / BENCH_FRAMES;
+
+    pjmedia_resample_destroy(resample);
+    return 0;
+}
+#endif
+
+int resample_test(void)
+{
+    pj_pool_t *pool;
+    unsigned q, i, j;
+    int rc = 0;
+
+    pool = pj_pool_create(mem, "resample", 4000, 4000, NULL);
+    PJ_TEST_NOT_NULL(pool, "pool create", return -1);
+
+    for (q = 0; q < PJ_ARRAY_SIZE(qualities); ++q) {
+        PJ_LOG(3,(THIS_FILE, "  testing %s filter", qualities[q].name));
+
+        for (i = 0; i < PJ_ARRAY_SIZE(rates); ++i) {
+            for (j = 0; j < PJ_ARRAY_SIZE(rates); ++j) {
+                if (i == j)
+                    continue;
+
+                rc = test_convert(pool, q, 1, rates[i], rates[j],
+                                  FRAME_MSEC);
+                if (rc != 0)
+                    goto on_return;
+            }
+        }
+
+        /* Stereo, with a different tone in each channel */
+        rc = test_convert(pool, q, 2, 16000, 48000, FRAME_MSEC);
+        if (rc == 0)
+            rc = test_convert(pool, q, 2, 48000, 8000, FRAME_MSEC);
+        if (rc != 0)
+            goto on_return;
+
+        rc = test_uneven_ratio(pool, q);
+        if (rc != 0)
+            goto on_return;
+    }
+
+#if WITH_BENCHMARK
+    PJ_LOG(3,(THIS_FILE, "  usec per %d ms mono frame:", FRAME_MSEC));
+    PJ_LOG(3,(THIS_FILE, "  filter    8->48    48->8   16->48   48->16"));
+    for (q = 0; q < PJ_ARRAY_SIZE(qualities); ++q) {
+        float usec[4];
+
+        rc = bench_convert(pool, q, 8000, 48000, &usec[0]);
+        if (rc == 0)
+            rc = bench_convert(pool, q, 48000, 8000, &usec[1]);
+        if (rc == 0)
+            rc = bench_convert(pool, q, 16000, 48000, &usec[2]);
+        if (rc == 0)
+            rc = bench_convert(pool, q, 48000, 16000, &usec[3]);
+        if (rc != 0)
+            goto on_return;
+
+        PJ_LOG(3,(THIS_FILE, "  %-7s %8.2f %8.2f %8.2f %8.2f",
+                  qualities[q].name, usec[0], usec[1], usec[2], usec[3]));
+    }
+#endif
+
+on_return:
+    pj_pool_release(pool);
+    return rc;
+}
@@ -0,0 +1,465 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <pjmedia/endpoint.h>
+#include <pjmedia/rtp.h>
+#include <pjmedia/transport_loop.h>
+#include <pjmedia/transport_srtp.h>
+#include <pjmedia/transport_udp.h>
+#include <pj/ioqueue.h>
+#include <pj/log.h>
+#include <pj/os.h>
+#include <pj/pool.h>
+#include <pj/sock.h>
+#include <pj/string.h>
+#include "test.h"
+
+#if defined(PJMEDIA_HAS_SRTP) && (PJMEDIA_HAS_SRTP != 0)
+
+#define THIS_FILE       "srtp_test.c"
+
+#define SESSION_CNT     8
+#define PAYLOAD_LEN     160
+#define PKT_LEN         (sizeof(pjmedia_rtp_hdr) + PAYLOAD_LEN)
+#define BUF_SIZE        (PKT_LEN + PJMEDIA_SRTP_MAX_TAG_LEN)
+#define BENCH_TICKS     2000
+
+typedef struct suite
+{
+    const char      *name;
+    unsigned         key_len;
+} suite;
+
+static const suite suites[] =
+{
+    { "AES_CM_128_HMAC_SHA1_80", 30 },
+#if defined(PJMEDIA_SRTP_HAS_AES_GCM_128) && PJMEDIA_SRTP_HAS_AES_GCM_128!=0
+    { "AEAD_AES_128_GCM", 28 },
+#endif
+};
+
+typedef struct session
+{
+    pjmedia_transport   *tp;
+    pj_uint16_t          seq;
+    pj_uint32_t         *buf;
+} session;
+
+
+/* Write a new RTP packet of the session into its buffer */
+static void init_pkt(session *s, unsigned idx)
+{
+    pjmedia_rtp_hdr *hdr = (pjmedia_rtp_hdr*)s->buf;
+
+    pj_bzero(hdr, sizeof(*hdr));
+    hdr->v = 2;
+    hdr->seq = pj_htons(s->seq++);
+    hdr->ts = pj_htonl(s->seq * PAYLOAD_LEN);
+    hdr->ssrc = pj_htonl(0x1000 + idx);
+    pj_memset(hdr + 1, 'a' + idx, PAYLOAD_LEN);
+}
+
+static void init_batch(session sess[], pjmedia_srtp_batch_pkt pkts[])
+{
+    unsigned i;
+
+    for (i = 0; i < SESSION_CNT; ++i) {
+        init_pkt(&sess[i], i);
+        pkts[i].tp = sess[i].tp;
+        pkts[i].pkt = sess[i].buf;
+        pkts[i].len = PKT_LEN;
+        pkts[i].buf_size = BUF_SIZE;
+    }
+}
+
+static int create_sessions(pjmedia_endpt *endpt, pj_pool_t *pool,
+                           const suite *st, session sess[])
+{
+    unsigned i;
+    pj_status_t status;
+
+    for (i = 0; i < SESSION_CNT; ++i) {
+        pjmedia_transport *loop;
+        pjmedia_srtp_crypto crypto;
+        char key[64];
+
+        sess[i].buf = (pj_uint32_t*)pj_pool_alloc(pool, BUF_SIZE);
+        sess[i].seq = (pj_uint16_t)(i * 1000);
+
+        status = pjmedia_transport_loop_create(endpt, &loop);
+        PJ_TEST_SUCCESS(status, "loop transport", return -10);
+
+        status = pjmedia_transport_srtp_create(endpt, loop, NULL,
+                                               &sess[i].tp);
+        PJ_TEST_SUCCESS(status, "srtp transport",
+                        {pjmedia_transport_close(loop); return -11;});
+
+        /* Use the same key in both directions, so that the packets
+         * protected by a session can be unprotected by itself.
+         */
+        pj_memset(key, 'k' + i, st->key_len);
+        pj_bzero(&crypto, sizeof(crypto));
+        crypto.key = pj_str(key);
+        crypto.key.slen = st->key_len;
+        crypto.name = pj_str((char*)st->name);
+
+        status = pjmedia_transport_srtp_start(sess[i].tp, &crypto, &crypto);
+        PJ_TEST_SUCCESS(status, "srtp start", return -12);
+    }
+
+    return 0;
+}
+
+static void destroy_sessions(session sess[])
+{
+    unsigned i;
+
+    for (i = 0; i < SESSION_CNT; ++i) {
+        if (sess[i].tp) {
+            pjmedia_transport_close(sess[i].tp);
+            sess[i].tp = NULL;
+        }
+    }
+}
+
+/* Protect and unprotect a batch, and check the packets come back intact */
+static int roundtrip_test(session sess[])
+{
+    pjmedia_srtp_batch_pkt pkts[SESSION_CNT];
+    unsigned i;
+    pj_status_t status;
+
+    init_batch(sess, pkts);
+    status = pjmedia_transport_srtp_protect_batch(pkts, SESSION_CNT,
+                                                  PJ_FALSE);
+    PJ_TEST_SUCCESS(status, "protect batch", return -20);
+
+    for (i = 0; i < SESSION_CNT; ++i) {
+        const char *payload = (const char*)sess[i].buf +
+                              sizeof(pjmedia_rtp_hdr);
+
+        PJ_TEST_SUCCESS(pkts[i].status, "packet status", return -21);
+        PJ_TEST_TRUE(pkts[i].len > (int)PKT_LEN &&
+                     pkts[i].len <= (int)BUF_SIZE, "protected length",
+                     return -22);
+        PJ_TEST_TRUE(payload[0] != 'a' + (int)i ||
+                     payload[1] != 'a' + (int)i, "payload not encrypted",
+                     return -23);
+    }
+
+    status = pjmedia_transport_srtp_unprotect_batch(pkts, SESSION_CNT);
+    PJ_TEST_SUCCESS(status, "unprotect batch", return -24);
+
+    for (i = 0; i < SESSION_CNT; ++i) {
+        const char *payload = (const char*)sess[i].buf +
+                              sizeof(pjmedia_rtp_hdr);
+
+        PJ_TEST_EQ(pkts[i].len, (int)PKT_LEN, "unprotected length",
+                   return -25);
+        PJ_TEST_TRUE(payload[0] == 'a' + (int)i &&
+                     payload[PAYLOAD_LEN-1] == 'a' + (int)i,
+                     "payload content", return -26);
+    }
+
+    /* A packet that is not protected must be rejected, without failing
+     * the rest of the batch.
+     */
+    init_batch(sess, pkts);
+    status = pjmedia_transport_srtp_protect_batch(pkts + 1, SESSION_CNT - 1,
+                                                  PJ_FALSE);
+    PJ_TEST_SUCCESS(status, "protect batch", return -30);
+    status = pjmedia_transport_srtp_unprotect_batch(pkts, SESSION_CNT);
+    PJ_TEST_TRUE(status != PJ_SUCCESS && pkts[0].status == status,
+                 "plain packet accepted", return -31);
+    for (i = 1; i < SESSION_CNT; ++i) {
+        PJ_TEST_SUCCESS(pkts[i].status, "packet status", return -32);
+    }
+
+    /* No room for the authentication tag */
+    init_batch(sess, pkts);
+    pkts[0].buf_size = PKT_LEN;
+    status = pjmedia_transport_srtp_protect_batch(pkts, 1, PJ_FALSE);
+    PJ_TEST_EQ(status, PJ_ETOOBIG, "small buffer", return -33);
+
+    return 0;
+}
+
+#if WITH_BENCHMARK
+static unsigned get_pps(unsigned cnt, const pj_timestamp *t0,
+                        const pj_timestamp *t1)
+{
+    pj_uint32_t usec = pj_elapsed_usec(t0, t1);
+
+    return usec ? (unsigned)((pj_uint64_t)cnt * 1000000 / usec) : 0;
+}
+
+/* Measure packets/sec on this core for the per-packet send path and the
+ * batch protect and unprotect.
+ */
+static int bench(pj_pool_t *pool, const suite *st, session sess[])
+{
+    pjmedia_srtp_batch_pkt pkts[SESSION_CNT];
+    pjmedia_srtp_batch_pkt *rx_pkts;
+    char *rx_bufs;
+    pj_timestamp t0, t1;
+    unsigned pps[3];
+    unsigned i, j;
+    pj_status_t status;
+
+    /* Per packet, copied into the transport buffer and sent */
+    pj_get_timestamp(&t0);
+    for (i = 0; i < BENCH_TICKS; ++i) {
+        for (j = 0; j < SESSION_CNT; ++j) {
+            init_pkt(&sess[j], j);
+            status = pjmedia_transport_send_rtp(sess[j].tp, sess[j].buf,
+                                                PKT_LEN);
+            PJ_TEST_SUCCESS(status, "send rtp", return -40);
+        }
+    }
+    pj_get_timestamp(&t1);
+    pps[0] = get_pps(BENCH_TICKS * SESSION_CNT, &t0, &t1);
+
+    /* A batch of one packet of each session per tick, protected in place
+     * and sent.
+     */
+    pj_get_timestamp(&t0);
+    for (i = 0; i < BENCH_TICKS; ++i) {
+        init_batch(sess, pkts);
+        status = pjmedia_transport_srtp_protect_batch(pkts, SESSION_CNT,
+                                                      PJ_TRUE);
+        PJ_TEST_SUCCESS(status, "protect batch", return -41);
+    }
+    pj_get_timestamp(&t1);
+    pps[1] = get_pps(BENCH_TICKS * SESSION_CNT, &t0, &t1);
+
+    /* Prepare protected packets to unprotect */
+    rx_pkts = (pjmedia_srtp_batch_pkt*)
+              pj_pool_calloc(pool, BENCH_TICKS * SESSION_CNT,
+                             sizeof(pjmedia_srtp_batch_pkt));
+    rx_bufs = (char*)pj_pool_alloc(pool, BENCH_TICKS * SESSION_CNT *
+                                         BUF_SIZE);
+    for (i = 0; i < BENCH_TICKS; ++i) {
+        pjmedia_srtp_batch_pkt *p = &rx_pkts[i * SESSION_CNT];
+
+        init_batch(sess, p);
+        status = pjmedia_transport_srtp_protect_batch(p, SESSION_CNT,
+                                                      PJ_FALSE);
+        PJ_TEST_SUCCESS(status, "protect batch", return -42);
+
+        for (j = 0; j < SESSION_CNT; ++j) {
+            char *buf = rx_bufs + (i * SESSION_CNT + j) * BUF_SIZE;
+
+            pj_memcpy(buf, p[j].pkt, p[j].len);
+            p[j].pkt = buf;
+        }
+    }
+
+    pj_get_timestamp(&t0);
+    for (i = 0; i < BENCH_TICKS; ++i) {
+        status = pjmedia_transport_srtp_unprotect_batch(
+                                        &rx_pkts[i * SESSION_CNT],
+                                        SESSION_CNT);
+        PJ_TEST_SUCCESS(status, "unprotect batch", return -43);
+    }
+    pj_get_timestamp(&t1);
+    pps[2] = get_pps(BENCH_TICKS * SESSION_CNT, &t0, &t1);
+
+    PJ_LOG(3,(THIS_FILE, "  %-24s %10u %10u %10u",
+              st->name, pps[0], pps[1], pps[2]));
+    return 0;
+}
+#endif  /* WITH_BENCHMARK */
+
+#if defined(PJMEDIA_SRTP_HAS_DTLS) && (PJMEDIA_SRTP_HAS_DTLS != 0)
+
+#define DTLS_PORT       47000
+#define DTLS_TIMEOUT    5000
+
+typedef struct dtls_peer
+{
+    pjmedia_transport   *tp;
+    pj_sockaddr          addr;
+    pj_bool_t            done;
+    pj_status_t          status;
+} dtls_peer;
+
+static void on_dtls_nego_complete(pjmedia_transport *tp, pj_status_t status)
+{
+    dtls_peer *peer = (dtls_peer*)tp->user_data;
+
+    peer->status = status;
+    peer->done = PJ_TRUE;
+}
+
+/* DTLS-SRTP handshake between two transports on the loopback, with the
+ * certificate fingerprint verification. The handshake is done twice, the
+ * second one resumes the session of the first.
+ */
+static int dtls_test(pjmedia_endpt *endpt)
+{
+    pj_ioqueue_t *ioqueue = pjmedia_endpt_get_ioqueue(endpt);
+    pj_str_t loopback = pj_str("127.0.0.1");
+    dtls_peer peers[2];
+    char fp[128];
+    pj_size_t fp_len;
+    unsigned i, round;
+    pj_status_t status;
+    int rc = 0;
+
+    for (round = 0; round < 2 && rc == 0; ++round) {
+        pj_time_val t0, now;
+
+        pj_bzero(peers, sizeof(peers));
+        for (i = 0; i < PJ_ARRAY_SIZE(peers); ++i) {
+            pjmedia_transport *udp;
+            pjmedia_transport_info info;
+            pjmedia_srtp_setting opt;
+
+            status = pjmedia_transport_udp_create3(endpt, pj_AF_INET(),
+                                                   "dtlstest", &loopback,
+                                                   DTLS_PORT + i*2, 0, &udp);
+            PJ_TEST_SUCCESS(status, "udp transport",
+                            {rc=-60; goto on_return;});
+
+            /* Start receiving, as there is no SDP to start the media */
+            status = pjmedia_transport_media_start(udp, NULL, NULL, NULL, 0);
+            PJ_TEST_SUCCESS(status, "udp start",
+                            {pjmedia_transport_close(udp);
+                             rc=-60; goto on_return;});
+
+            pjmedia_transport_info_init(&info);
+            pjmedia_transport_get_info(udp, &info);
+            pj_sockaddr_cp(&peers[i].addr, &info.sock_info.rtp_addr_name);
+
+            pjmedia_srtp_setting_default(&opt);
+            opt.keying_count = 1;
+            opt.keying[0] = PJMEDIA_SRTP_KEYING_DTLS_SRTP;
+            opt.user_data = &peers[i];
+            opt.cb.on_srtp_nego_complete = &on_dtls_nego_complete;
+
+            status = pjmedia_transport_srtp_create(endpt, udp, &opt,
+                                                   &peers[i].tp);
+            PJ_TEST_SUCCESS(status, "srtp transport",
+                            {pjmedia_transport_close(udp);
+                             rc=-61; goto on_return;});
+        }
+
+        /* Both transports use the same certificate */
+        fp_len = sizeof(fp);
+        status = pjmedia_transport_srtp_dtls_get_fingerprint(peers[0].tp,
+                                                             "SHA-256", fp,
+                                                             &fp_len);
+        PJ_TEST_SUCCESS(status, "get fingerprint", {rc=-62; goto on_return;});
+
+        /* Start the passive side first */
+        for (i = 0; i < PJ_ARRAY_SIZE(peers); ++i) {
+            pjmedia_srtp_dtls_nego_param param;
+
+            pj_bzero(&param, sizeof(param));
+            param.rem_fingerprint = pj_str(fp);
+            pj_sockaddr_cp(&param.rem_addr, &peers[1-i].addr);
+            pj_sockaddr_cp(&param.rem_rtcp, &peers[1-i].addr);
+            param.is_role_active = (i == 1);
+
+            status = pjmedia_transport_srtp_dtls_start_nego(peers[i].tp,
+                                                            &param);
+            PJ_TEST_SUCCESS(status, "start nego", {rc=-63; goto on_return;});
+        }
+
+        pj_gettickcount(&t0);
+        while (!peers[0].done || !peers[1].done) {
+            pj_time_val timeout = {0, 10};
+
+            pj_ioqueue_poll(ioqueue, &timeout);
+            pj_gettickcount(&now);
+            if (PJ_TIME_VAL_MSEC(now) - PJ_TIME_VAL_MSEC(t0) > DTLS_TIMEOUT)
+                break;
+        }
+
+        PJ_TEST_TRUE(peers[0].done && peers[1].done, "handshake timed out",
+                     {rc=-64; goto on_return;});
+        PJ_TEST_SUCCESS(peers[0].status, "server nego",
+                        {rc=-65; goto on_return;});
+        PJ_TEST_SUCCESS(peers[1].status, "client nego",
+                        {rc=-66; goto on_return;});
+
+on_return:
+        for (i = 0; i < PJ_ARRAY_SIZE(peers); ++i) {
+            if (peers[i].tp)
+                pjmedia_transport_close(peers[i].tp);
+        }
+    }
+
+    return rc;
+}
+#endif  /* PJMEDIA_SRTP_HAS_DTLS */
+
+int srtp_test(void)
+{
+    pjmedia_endpt *endpt;
+    pj_pool_t *pool;
+    session sess[SESSION_CNT];
+    unsigned i;
+    pj_status_t status;
+    int rc = 0;
+
+    status = pjmedia_endpt_create2(mem, NULL, 0, &endpt);
+    PJ_TEST_SUCCESS(status, "endpoint create", return -1);
+
+    pool = pj_pool_create(mem, "srtptest", 4000, 4000, NULL);
+    PJ_TEST_NOT_NULL(pool, "pool create",
+                     {pjmedia_endpt_destroy2(endpt); return -2;});
+
+#if WITH_BENCHMARK
+    PJ_LOG(3,(THIS_FILE, "  packets/sec with %d sessions:", SESSION_CNT));
+    PJ_LOG(3,(THIS_FILE, "  %-24s %10s %10s %10s",
+              "crypto", "send_rtp", "protect", "unprotect"));
+#endif
+
+    for (i = 0; i < PJ_ARRAY_SIZE(suites) && rc == 0; ++i) {
+        pj_bzero(sess, sizeof(sess));
+
+        rc = create_sessions(endpt, pool, &suites[i], sess);
+        if (rc == 0)
+            rc = roundtrip_test(sess);
+#if WITH_BENCHMARK
+        if (rc == 0)
+            rc = bench(pool, &suites[i], sess);
+#endif
+
+        destroy_sessions(sess);
+    }
+
+#if defined(PJMEDIA_SRTP_HAS_DTLS) && (PJMEDIA_SRTP_HAS_DTLS != 0)
+    if (rc == 0)
+        rc = dtls_test(endpt);
+#endif
+
+    pj_pool_release(pool);
+    pjmedia_endpt_destroy2(endpt);
+    return rc;
+}
+
+#else   /* PJMEDIA_HAS_SRTP */
+
+int srtp_test(void)
+{
+    return 0;
+}
+
+#endif  /* PJMEDIA_HAS_SRTP */
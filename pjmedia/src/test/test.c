@@ -114,6 +114,32 @@ int test_main(int argc, char *argv[])
 #if HAS_TONE_DETECTOR_TEST
     UT_ADD_TEST(&test_app.ut_app, tone_detector_test, 0);
 #endif
+#if HAS_MIX_KERNEL_TEST
+    /* Run in exclusive mode to get the best benchmark result */
+    UT_ADD_TEST(&test_app.ut_app, mix_kernel_test, PJ_TEST_EXCLUSIVE);
+#endif
+#if HAS_G711_TEST
+    /* Run in exclusive mode to get the best benchmark result */
+    UT_ADD_TEST(&test_app.ut_app, g711_test, PJ_TEST_EXCLUSIVE);
+#endif
+#if HAS_RESAMPLE_TEST
+    UT_ADD_TEST(&test_app.ut_app, resample_test, PJ_TEST_EXCLUSIVE);
+#endif
+#if HAS_PKT_BUF_TEST
+    UT_ADD_TEST(&test_app.ut_app, pkt_buf_test, 0);
+#endif
+#if HAS_TICK_POOL_TEST
+    UT_ADD_TEST(&test_app.ut_app, tick_pool_test, 0);
+#endif
+#if HAS_CONF_TEST
+    UT_ADD_TEST(&test_app.ut_app, conf_test, 0);
+#endif
+#if HAS_TRANSPORT_UDP_TEST
+    /* Exclusive, as it creates its own pjmedia_endpt, see
+     * codec_test_vectors below.
+     */
+    UT_ADD_TEST(&test_app.ut_app, transport_udp_test, PJ_TEST_EXCLUSIVE);
+#endif
 #if HAS_CODEC_VECTOR_TEST
     /* Run in exclusive mode: creates/destroys a local pjmedia_endpt which
      * sets/clears the global def_codec_mgr. If sdp_neg_test runs
@@ -122,6 +148,10 @@ int test_main(int argc, char *argv[])
      */
     UT_ADD_TEST(&test_app.ut_app, codec_test_vectors, PJ_TEST_EXCLUSIVE);
 #endif
+#if HAS_SRTP_TEST
+    /* Exclusive for the same reason as above, and for the benchmark */
+    UT_ADD_TEST(&test_app.ut_app, srtp_test, PJ_TEST_EXCLUSIVE);
+#endif
 
     if (ut_run_tests(&test_app.ut_app, "pjmedia tests", argc, argv)) {
         rc = 99;
@@ -39,6 +39,14 @@
 #define HAS_MIPS_TEST           WITH_BENCHMARK
 #define HAS_CODEC_VECTOR_TEST   1
 #define HAS_TONE_DETECTOR_TEST  1
+#define HAS_MIX_KERNEL_TEST     1
+#define HAS_G711_TEST           1
+#define HAS_RESAMPLE_TEST       (PJMEDIA_RESAMPLE_IMP!=PJMEDIA_RESAMPLE_NONE)
+#define HAS_PKT_BUF_TEST        1
+#define HAS_SRTP_TEST           PJMEDIA_HAS_SRTP
+#define HAS_TICK_POOL_TEST      1
+#define HAS_CONF_TEST           1
+#define HAS_TRANSPORT_UDP_TEST  1
 
 int session_test(void);
 int rtp_test(void);
@@ -52,6 +60,14 @@ int vid_codec_test(void);
 int vid_dev_test(void);
 int vid_port_test(void);
 int tone_detector_test(void);
+int mix_kernel_test(void);
+int g711_test(void);
+int resample_test(void);
+int pkt_buf_test(void);
+int srtp_test(void);
+int tick_pool_test(void);
+int conf_test(void);
+int transport_udp_test(void);
 
 extern pj_pool_factory *mem;
 void app_perror(pj_status_t status, const char *title);
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <pjmedia/tick_pool.h>
+#include <pj/log.h>
+#include <pj/os.h>
+#include <pj/pool.h>
+#include <pj/string.h>
+#include "test.h"
+
+#define THIS_FILE       "tick_pool_test.c"
+
+#define PTIME           10
+#define CLOCK_RATE      8000
+#define SPF             (CLOCK_RATE * PTIME / 1000)
+#define PORT_CNT        4
+#define SLOW_DELAY      (PTIME * 4)
+#define RUN_TIME        400
+
+typedef struct test_port
+{
+    pjmedia_port        base;
+    unsigned            delay;          /* Processing time, in msec     */
+    int                 count;          /* Number of get_frame() calls  */
+    int                 inside;         /* Currently in get_frame()     */
+    pj_bool_t           concurrent;     /* Called by two threads at once*/
+    pj_bool_t           bad_ts;         /* Timestamp not contiguous     */
+    pj_timestamp        next_ts;
+} test_port;
+
+static pj_status_t tp_get_frame(pjmedia_port *this_port,
+                                pjmedia_frame *frame)
+{
+    test_port *tp = (test_port*)this_port;
+
+    if (tp->inside++)
+        tp->concurrent = PJ_TRUE;
+    if (frame->timestamp.u64 != tp->next_ts.u64)
+        tp->bad_ts = PJ_TRUE;
+    tp->next_ts.u64 = frame->timestamp.u64 + SPF;
+
+    pj_bzero(frame->buf, frame->size);
+    ++tp->count;
+
+    if (tp->delay)
+        pj_thread_sleep(tp->delay);
+
+    --tp->inside;
+    return PJ_SUCCESS;
+}
+
+int tick_pool_test(void)
+{
+    pj_pool_t *pool;
+    pjmedia_tick_pool_param param;
+    pjmedia_tick_pool *tpool = NULL;
+    test_port *ports;
+    int counts[PORT_CNT];
+    unsigned i;
+    pj_status_t status;
+    int rc = 0;
+
+    pool = pj_pool_create(mem, "tickpool", 4000, 4000, NULL);
+    PJ_TEST_NOT_NULL(pool, "pool create", return -1);
+
+    ports = (test_port*)pj_pool_calloc(pool, PORT_CNT, sizeof(test_port));
+    for (i = 0; i < PORT_CNT; ++i) {
+        pj_str_t name = pj_str("tickport");
+
+        pjmedia_port_info_init(&ports[i].base.info, &name,
+                               PJMEDIA_SIG_CLASS_PORT_AUD('T','P'),
+                               CLOCK_RATE, 1, 16, SPF);
+        ports[i].base.get_frame = &tp_get_frame;
+    }
+    /* The last port is too slow for the tick */
+    ports[PORT_CNT-1].delay = SLOW_DELAY;
+
+    pjmedia_tick_pool_param_default(&param);
+    param.ptime_usec = PTIME * 1000;
+    param.worker_cnt = 2;
+    status = pjmedia_tick_pool_create(pool, &param, &tpool);
+    PJ_TEST_SUCCESS(status, "tick pool create", {rc=-10; goto on_return;});
+
+    /* Port with a different ptime must be rejected */
+    {
+        pjmedia_port bad;
+        pj_str_t name = pj_str("bad");
+
+        pj_bzero(&bad, sizeof(bad));
+        pjmedia_port_info_init(&bad.info, &name,
+                               PJMEDIA_SIG_CLASS_PORT_AUD('T','P'),
+                               CLOCK_RATE, 1, 16, SPF * 2);
+        status = pjmedia_tick_pool_add_port(tpool, &bad);
+        PJ_TEST_NEQ(status, PJ_SUCCESS, "ptime mismatch",
+                    {rc=-20; goto on_return;});
+    }
+
+    for (i = 0; i < PORT_CNT; ++i) {
+        status = pjmedia_tick_pool_add_port(tpool, &ports[i].base);
+        PJ_TEST_SUCCESS(status, "add port", {rc=-30; goto on_return;});
+    }
+
+    pj_thread_sleep(RUN_TIME);
+
+    for (i = 0; i < PORT_CNT; ++i) {
+        status = pjmedia_tick_pool_remove_port(tpool, &ports[i].base);
+        PJ_TEST_SUCCESS(status, "remove port", {rc=-40; goto on_return;});
+        counts[i] = ports[i].count;
+    }
+
+    status = pjmedia_tick_pool_remove_port(tpool, &ports[0].base);
+    PJ_TEST_EQ(status, PJ_ENOTFOUND, "remove twice",
+               {rc=-50; goto on_return;});
+
+    /* Removed ports must not be called anymore */
+    pj_thread_sleep(PTIME * 5);
+
+    for (i = 0; i < PORT_CNT; ++i) {
+        PJ_LOG(3,(THIS_FILE, "  port %d: %d frames", i, counts[i]));
+        PJ_TEST_EQ(ports[i].count, counts[i], "called after removal",
+                   {rc=-60; goto on_return;});
+        PJ_TEST_TRUE(!ports[i].concurrent, "concurrent get_frame()",
+                     {rc=-61; goto on_return;});
+        PJ_TEST_TRUE(!ports[i].bad_ts, "timestamp",
+                     {rc=-62; goto on_return;});
+    }
+
+    /* The slow port must skip ticks without delaying the others. The
+     * limits are loose, to tolerate a busy test machine.
+     */
+    for (i = 0; i < PORT_CNT-1; ++i) {
+        PJ_TEST_GT(counts[i], RUN_TIME / PTIME / 2, "fast port delayed",
+                   {rc=-70; goto on_return;});
+    }
+    PJ_TEST_LT(counts[PORT_CNT-1], RUN_TIME / SLOW_DELAY * 3 / 2 + 1,
+               "slow port not skipping", {rc=-71; goto on_return;});
+
+on_return:
+    if (tpool)
+        pjmedia_tick_pool_destroy(tpool);
+    pj_pool_release(pool);
+    return rc;
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <pjmedia/endpoint.h>
+#include <pjmedia/rtp.h>
+#include <pjmedia/transport_udp.h>
+#include <pj/ioqueue.h>
+#include <pj/log.h>
+#include <pj/os.h>
+#include <pj/pool.h>
+#include <pj/sock.h>
+#include <pj/string.h>
+#include "test.h"
+
+#define THIS_FILE       "transport_udp_test.c"
+
+/* Number of RTP packets sent before the transport is polled, enough to
+ * need several batched receive calls.
+ */
+#define BURST_CNT       (PJMEDIA_UDP_RECV_BATCH_CNT * 3 + 3)
+
+/* Local ports to try for the transport */
+#define PORT_START      40000
+#define PORT_END        40200
+
+#define RTP_HDR_LEN     ((unsigned)sizeof(pjmedia_rtp_hdr))
+#define MAX_PKT_LEN     (RTP_HDR_LEN + 200)
+
+typedef struct rx_state
+{
+    pj_sockaddr         src_addr;
+    unsigned            cnt;
+    unsigned            err_cnt;
+} rx_state;
+
+/* Vary the packet length so that each packet is told apart by its size */
+static unsigned pkt_len(unsigned i)
+{
+    return RTP_HDR_LEN + 20 + (i * 37) % 180;
+}
+
+static void build_pkt(pj_uint8_t *pkt, unsigned i)
+{
+    pjmedia_rtp_hdr *hdr = (pjmedia_rtp_hdr*)pkt;
+
+    pj_bzero(hdr, RTP_HDR_LEN);
+    hdr->v = 2;
+    hdr->pt = 0;
+    hdr->seq = pj_htons((pj_uint16_t)i);
+    hdr->ts = pj_htonl(i * 160);
+    hdr->ssrc = pj_htonl(0x12345678);
+    pj_memset(pkt + RTP_HDR_LEN, (int)i, pkt_len(i) - RTP_HDR_LEN);
+}
+
+static void on_rx_rtp(pjmedia_tp_cb_param *param)
+{
+    rx_state *st = (rx_state*)param->user_data;
+    const pj_uint8_t *pkt = (const pj_uint8_t*)param->pkt;
+    const pjmedia_rtp_hdr *hdr = (const pjmedia_rtp_hdr*)pkt;
+    unsigned expected = st->cnt++;
+
+    if (param->size != (pj_ssize_t)pkt_len(expected) ||
+        pj_ntohs(hdr->seq) != expected ||
+        pkt[param->size-1] != (pj_uint8_t)expected ||
+        pj_sockaddr_cmp(param->src_addr, &st->src_addr) != 0)
+    {
+        PJ_LOG(3,(THIS_FILE, "    packet %u: unexpected seq %u, size %ld",
+                  expected, (param->size >= (pj_ssize_t)RTP_HDR_LEN ?
+                             pj_ntohs(hdr->seq) : 0), (long)param->size));
+        ++st->err_cnt;
+    }
+}
+
+/* Send a burst of RTP packets to a transport created with
+ * PJMEDIA_UDP_BATCH_RECV before polling it, and check that each packet
+ * reaches the attached callback in order, with the right length and
+ * source address.
+ */
+static int batch_recv_test(pjmedia_endpt *endpt, pj_pool_t *pool)
+{
+    pjmedia_transport *tp = NULL;
+    pjmedia_transport_info tpinfo;
+    pjmedia_transport_attach_param ap;
+    pj_sock_t sock = PJ_INVALID_SOCKET;
+    pj_str_t localhost = pj_str("127.0.0.1");
+    pj_sockaddr addr;
+    pj_uint8_t pkt[MAX_PKT_LEN];
+    pj_time_val timeout, now;
+    rx_state st;
+    int namelen, port;
+    unsigned i;
+    pj_status_t status;
+    int rc = 0;
+
+    PJ_LOG(3,(THIS_FILE, "  batched receive of %d packets", BURST_CNT));
+
+    pj_bzero(&st, sizeof(st));
+
+    for (port = PORT_START; port < PORT_END; port += 2) {
+        status = pjmedia_transport_udp_create3(endpt, pj_AF_INET(),
+                                               "udpbatch", &localhost, port,
+                                               PJMEDIA_UDP_BATCH_RECV, &tp);
+        if (status == PJ_SUCCESS)
+            break;
+    }
+    PJ_TEST_SUCCESS(status, "transport create", return -10);
+
+    /* Sender socket */
+    status = pj_sock_socket(pj_AF_INET(), pj_SOCK_DGRAM(), 0, &sock);
+    PJ_TEST_SUCCESS(status, "socket", {rc = -20; goto on_return;});
+    pj_sockaddr_init(pj_AF_INET(), &addr, &localhost, 0);
+    status = pj_sock_bind(sock, &addr, pj_sockaddr_get_len(&addr));
+    PJ_TEST_SUCCESS(status, "bind", {rc = -21; goto on_return;});
+    namelen = sizeof(st.src_addr);
+    status = pj_sock_getsockname(sock, &st.src_addr, &namelen);
+    PJ_TEST_SUCCESS(status, "getsockname", {rc = -22; goto on_return;});
+
+    pj_bzero(&ap, sizeof(ap));
+    ap.user_data = &st;
+    pj_sockaddr_cp(&ap.rem_addr, &st.src_addr);
+    pj_sockaddr_cp(&ap.rem_rtcp, &st.src_addr);
+    ap.addr_len = pj_sockaddr_get_len(&st.src_addr);
+    ap.rtp_cb2 = &on_rx_rtp;
+    status = pjmedia_transport_attach2(tp, &ap);
+    PJ_TEST_SUCCESS(status, "attach", {rc = -30; goto on_return;});
+
+    status = pjmedia_transport_media_start(tp, pool, NULL, NULL, 0);
+    PJ_TEST_SUCCESS(status, "media start", {rc = -31; goto on_return;});
+
+    pjmedia_transport_info_init(&tpinfo);
+    pjmedia_transport_get_info(tp, &tpinfo);
+
+    for (i = 0; i < BURST_CNT; ++i) {
+        pj_ssize_t len = pkt_len(i);
+
+        build_pkt(pkt, i);
+        status = pj_sock_sendto(sock, pkt, &len, 0,
+                                &tpinfo.sock_info.rtp_addr_name,
+                                pj_sockaddr_get_len(
+                                    &tpinfo.sock_info.rtp_addr_name));
+        PJ_TEST_SUCCESS(status, "sendto", {rc = -40; goto on_return;});
+    }
+
+    pj_gettickcount(&timeout);
+    timeout.sec += 5;
+    do {
+        pj_time_val poll_delay = { 0, 10 };
+
+        pj_ioqueue_poll(pjmedia_endpt_get_ioqueue(endpt), &poll_delay);
+        pj_gettickcount(&now);
+    } while (st.cnt < BURST_CNT && PJ_TIME_VAL_LT(now, timeout));
+
+    PJ_TEST_EQ(st.cnt, BURST_CNT, "packets lost", {rc = -50;
+                                                   goto on_return;});
+    PJ_TEST_EQ(st.err_cnt, 0, "reordered or corrupt packets", rc = -51);
+
+on_return:
+    if (tp) {
+        pjmedia_transport_media_stop(tp);
+        pjmedia_transport_detach(tp, &st);
+        pjmedia_transport_close(tp);
+    }
+    if (sock != PJ_INVALID_SOCKET)
+        pj_sock_close(sock);
+    return rc;
+}
+
+int transport_udp_test(void)
+{
+    pj_pool_t *pool;
+    pjmedia_endpt *endpt;
+    pj_status_t status;
+    int rc;
+
+    pool = pj_pool_create(mem, "udptest", 4000, 4000, NULL);
+    PJ_TEST_NOT_NULL(pool, "pool create", return -1);
+
+    status = pjmedia_endpt_create2(mem, NULL, 0, &endpt);
+    PJ_TEST_SUCCESS(status, "endpt create", {pj_pool_release(pool);
+                                             return -2;});
+
+    rc = batch_recv_test(endpt, pool);
+
+    pjmedia_endpt_destroy2(endpt);
+    pj_pool_release(pool);
+    return rc;
+}
@@ -84,6 +84,7 @@ SAMPLES = $(BINDIR)\aidemo.exe \
 	  $(BINDIR)\encdec.exe \
 	  $(BINDIR)\httpdemo.exe \
 	  $(BINDIR)\icedemo.exe \
+	  $(BINDIR)\jbreplay.exe \
 	  $(BINDIR)\jbsim.exe \
 	  $(BINDIR)\latency.exe \
 	  $(BINDIR)\level.exe \
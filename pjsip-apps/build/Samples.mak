@@ -25,6 +25,7 @@ SAMPLES := aidemo \
 	   encdec \
 	   httpdemo \
 	   icedemo \
+	   jbreplay \
 	   jbsim \
 	   latency \
 	   level \
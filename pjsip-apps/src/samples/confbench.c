@@ -45,6 +45,7 @@
  *   LARGE_SET will create in total of about 232 ports.
  *   HAS_RESAMPLE will activate resampling on about half
  *     the port.
+ * The room and mix-minus settings are command line options, see desc.
  */
 #define TEST_SET            LARGE_SET
 #define HAS_RESAMPLE        0
@@ -70,6 +71,16 @@
 #define IDLE_COUNT          32
 
 
+static const char *desc = 
+" confbench [options]                                               \n"
+"                                                                   \n"
+" options:                                                          \n"
+"  -r N  Replace the test set with a full-mesh room of N parties,   \n"
+"        where every party hears every other party (max 253).       \n"
+"  -m    Create the bridge with PJMEDIA_CONF_MIX_MINUS option, to   \n"
+"        compare the mixing cost of large rooms.                    \n";
+
+
 static void app_perror(const char *sender, const char *title, pj_status_t status)
 {
     char errmsg[PJ_ERR_MSG_SIZE];
@@ -225,59 +236,26 @@ static pj_status_t create_sine_port(pj_pool_t *pool,
     return PJ_SUCCESS;
 }
 
-int main()
+/*
+ * Create the test set: sine generators, each connected to port zero and
+ * to all null ports, and idle ports.
+ */
+static pj_status_t create_test_set(pj_pool_t *pool, pjmedia_conf *conf)
 {
-    pj_caching_pool cp;
-    pjmedia_endpt *med_endpt;
-    pj_pool_t *pool;
-    pjmedia_conf *conf;
     int i;
-    pjmedia_port *sine_port[SINE_COUNT], *null_port, *conf_port;
+    pjmedia_port *sine_port[SINE_COUNT];
     pjmedia_port *nulls[NULL_COUNT];
     unsigned null_slots[NULL_COUNT];
-    pjmedia_master_port *master_port;
     pj_status_t status;
 
-
-    pj_log_set_level(3);
-
-    status = pj_init();
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, 1);
-
-    pj_caching_pool_init(&cp, &pj_pool_factory_default_policy, 0);
-    pool = pj_pool_create( &cp.factory,     /* pool factory         */
-                           "wav",           /* pool name.           */
-                           4000,            /* init size            */
-                           4000,            /* increment size       */
-                           NULL             /* callback on error    */
-                           );
-
-    status = pjmedia_endpt_create(&cp.factory, NULL, 1, &med_endpt);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, 1);
-
-
-
-    status = pjmedia_conf_create( pool,
-                                  PORT_COUNT,
-                                  CLOCK_RATE,
-                                  1, SAMPLES_PER_FRAME, 16,
-                                  PJMEDIA_CONF_NO_DEVICE,
-                                  &conf);
-    if (status != PJ_SUCCESS) {
-        app_perror(THIS_FILE, "Unable to create conference bridge", status);
-        return 1;
-    }
-
-    printf("Resampling is %s\n", (HAS_RESAMPLE?"active":"disabled"));
-
     /* Create Null ports */
     printf("Creating %d null ports..\n", NULL_COUNT);
     for (i=0; i<NULL_COUNT; ++i) {
         status = pjmedia_null_port_create(pool, CLOCK_RATE, 1, SAMPLES_PER_FRAME*2, 16, &nulls[i]);
-        PJ_ASSERT_RETURN(status == PJ_SUCCESS, 1);
+        PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
         status = pjmedia_conf_add_port(conf, pool, nulls[i], NULL, &null_slots[i]);
-        PJ_ASSERT_RETURN(status == PJ_SUCCESS, 1);
+        PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
     }
 
     /* Create sine ports. */
@@ -287,7 +265,7 @@ int main()
 
         /* Load the WAV file to file port. */
         status = create_sine_port(pool, SINE_CLOCK, 1, &sine_port[i]);
-        PJ_ASSERT_RETURN(status == PJ_SUCCESS, 1);
+        PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
         /* Add the file port to conference bridge */
         status = pjmedia_conf_add_port( conf,           /* The bridge       */
@@ -298,15 +276,15 @@ int main()
                                         );
         if (status != PJ_SUCCESS) {
             app_perror(THIS_FILE, "Unable to add conference port", status);
-            return 1;
+            return status;
         }
 
         status = pjmedia_conf_connect_port(conf, slot, 0, 0);
-        PJ_ASSERT_RETURN(status == PJ_SUCCESS, 1);
+        PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
         for (j=0; j<NULL_COUNT; ++j) {
             status = pjmedia_conf_connect_port(conf, slot, null_slots[j], 0);
-            PJ_ASSERT_RETURN(status == PJ_SUCCESS, 1);
+            PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
         }
     }
 
@@ -315,11 +293,149 @@ int main()
     for (i=0; i<IDLE_COUNT; ++i) {
         pjmedia_port *dummy;
         status = pjmedia_null_port_create(pool, CLOCK_RATE, 1, SAMPLES_PER_FRAME, 16, &dummy);
-        PJ_ASSERT_RETURN(status == PJ_SUCCESS, 1);
+        PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
         status = pjmedia_conf_add_port(conf, pool, dummy, NULL, NULL);
-        PJ_ASSERT_RETURN(status == PJ_SUCCESS, 1);
+        PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
     }
 
+    return PJ_SUCCESS;
+}
+
+/* Room parties discard the mixed signal they receive. */
+static pj_status_t party_put_frame( pjmedia_port *port, 
+                                    pjmedia_frame *frame)
+{
+    PJ_UNUSED_ARG(port);
+    PJ_UNUSED_ARG(frame);
+    return PJ_SUCCESS;
+}
+
+/*
+ * Create a full-mesh room of sine generator parties.
+ */
+static pj_status_t create_room(pj_pool_t *pool, pjmedia_conf *conf,
+                               unsigned room_size)
+{
+    unsigned *slots;
+    unsigned i, j;
+    pj_status_t status;
+
+    slots = pj_pool_calloc(pool, room_size, sizeof(unsigned));
+    PJ_ASSERT_RETURN(slots != NULL, PJ_ENOMEM);
+
+    printf("Creating %d party full-mesh room..\n", room_size);
+    for (i=0; i<room_size; ++i) {
+        pjmedia_port *party;
+
+        status = create_sine_port(pool, SINE_CLOCK, 1, &party);
+        PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
+
+        party->put_frame = &party_put_frame;
+
+        status = pjmedia_conf_add_port(conf, pool, party, NULL, &slots[i]);
+        if (status != PJ_SUCCESS) {
+            app_perror(THIS_FILE, "Unable to add conference port", status);
+            return status;
+        }
+    }
+
+    for (i=0; i<room_size; ++i) {
+        for (j=0; j<room_size; ++j) {
+            if (i == j)
+                continue;
+
+            status = pjmedia_conf_connect_port(conf, slots[i], slots[j], 0);
+            PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
+        }
+    }
+
+    return PJ_SUCCESS;
+}
+
+/* Wait until the bridge has set up all the requested connections. */
+static void wait_connections(pjmedia_conf *conf, unsigned connect_cnt)
+{
+    while (pjmedia_conf_get_connect_count(conf) < connect_cnt)
+        pj_thread_sleep(10);
+}
+
+int main(int argc, char *argv[])
+{
+    pj_caching_pool cp;
+    pjmedia_endpt *med_endpt;
+    pj_pool_t *pool;
+    pjmedia_conf *conf;
+    pjmedia_port *null_port, *conf_port;
+    int c;
+    unsigned room_size = 0, connect_cnt;
+    pj_bool_t mix_minus = PJ_FALSE;
+    pjmedia_master_port *master_port;
+    pj_status_t status;
+
+
+    pj_optind = 0;
+    while ((c=pj_getopt(argc, argv, "r:m")) != -1) {
+        switch (c) {
+        case 'r':
+            room_size = atoi(pj_optarg);
+            if (room_size < 2 || room_size > PORT_COUNT-1) {
+                puts("Invalid room size");
+                puts(desc);
+                return 1;
+            }
+            break;
+        case 'm':
+            mix_minus = PJ_TRUE;
+            break;
+        default:
+            puts(desc);
+            return 1;
+        }
+    }
+
+    pj_log_set_level(3);
+
+    status = pj_init();
+    PJ_ASSERT_RETURN(status == PJ_SUCCESS, 1);
+
+    pj_caching_pool_init(&cp, &pj_pool_factory_default_policy, 0);
+    pool = pj_pool_create( &cp.factory,     /* pool factory         */
+                           "wav",           /* pool name.           */
+                           4000,            /* init size            */
+                           4000,            /* increment size       */
+                           NULL             /* callback on error    */
+                           );
+
+    status = pjmedia_endpt_create(&cp.factory, NULL, 1, &med_endpt);
+    PJ_ASSERT_RETURN(status == PJ_SUCCESS, 1);
+
+
+
+    status = pjmedia_conf_create( pool,
+                                  PORT_COUNT,
+                                  CLOCK_RATE,
+                                  1, SAMPLES_PER_FRAME, 16,
+                                  PJMEDIA_CONF_NO_DEVICE |
+                                  (mix_minus ? PJMEDIA_CONF_MIX_MINUS : 0),
+                                  &conf);
+    if (status != PJ_SUCCESS) {
+        app_perror(THIS_FILE, "Unable to create conference bridge", status);
+        return 1;
+    }
+
+    printf("Resampling is %s\n", (HAS_RESAMPLE?"active":"disabled"));
+    printf("Mix-minus is %s\n", (mix_minus?"active":"disabled"));
+
+    if (room_size) {
+        status = create_room(pool, conf, room_size);
+        connect_cnt = room_size * (room_size - 1);
+    } else {
+        status = create_test_set(pool, conf);
+        connect_cnt = SINE_COUNT * (NULL_COUNT + 1);
+    }
+    if (status != PJ_SUCCESS)
+        return 1;
+
     /* Create null port */
     status = pjmedia_null_port_create(pool, CLOCK_RATE, 1, SAMPLES_PER_FRAME, 16,
                                       &null_port);
@@ -334,6 +450,7 @@ int main()
     pjmedia_master_port_start(master_port);
 
     puts("Waiting to settle.."); fflush(stdout);
+    wait_connections(conf, connect_cnt);
     pj_thread_sleep(5000);
 
 
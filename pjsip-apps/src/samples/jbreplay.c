@@ -0,0 +1,583 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* jbreplay:
+
+    This program replays RTP packets captured in a PCAP file through
+    the jitter buffer and the decoding path of an audio stream, using
+    the capture timestamps as packet arrival times. The playout clock
+    is simulated and keeps running after the last packet until the
+    jitter buffer is empty, so the replay runs faster than real time and
+    gives the same result on every run, which makes it suitable for
+    tuning the jitter buffer settings against real network traces.
+
+    Test setup:
+
+    PCAP file --> Loop transport --> RX Stream --> get_frame() at ptime
+ */
+
+#include <pjlib.h>
+#include <pjlib-util.h>
+#include <pjmedia.h>
+#include <pjmedia-codec.h>
+
+#define THIS_FILE       "jbreplay.c"
+
+/* Maximum number of discard algorithms to compare in one run */
+#define MAX_ALGO        8
+
+/* Stop playing out the jitter buffer after the last packet if it has not
+ * shrunk for this many frames, e.g: it is waiting for prefetch.
+ */
+#define MAX_DRAIN_STALL 50
+
+static const char *USAGE =
+"jbreplay [options] INPUT\n"
+"\n"
+"  Replay captured RTP packets in PCAP file through the jitter buffer and\n"
+"  the audio stream decoder, using the packet capture time as the arrival\n"
+"  time, and report the jitter buffer performance of each discard\n"
+"  algorithm.\n"
+"\n"
+"  INPUT  is the PCAP file name/path.\n"
+"\n"
+"Options to filter packets from PCAP file:\n"
+"  --src-ip=IP            Only include packets from this source address\n"
+"  --dst-ip=IP            Only include packets destined to this address\n"
+"  --src-port=port        Only include packets from this source port number\n"
+"  --dst-port=port        Only include packets destined to this port number\n"
+"\n"
+"Options for RTP packet processing:\n"
+"  --codec=codec_id       The codec ID formatted \"name/clock-rate/channel-count\"\n"
+"                         must be specified for codec with dynamic PT,\n"
+"                         e.g: \"Speex/8000\"\n"
+"  --no-plc               Disable codec PLC\n"
+"\n"
+"Jitter buffer options (in msec, -1 for stream default):\n"
+"  --jb-algo=LIST         Comma separated discard algorithms to compare,\n"
+"                         from none, static, progressive, and histogram\n"
+"                         (default: static,progressive,histogram)\n"
+"  --jb-init=MSEC         Initial prefetch\n"
+"  --jb-min-pre=MSEC      Minimum prefetch\n"
+"  --jb-max-pre=MSEC      Maximum prefetch\n"
+"  --jb-max=MSEC          Maximum size\n"
+"\n"
+"Output options:\n"
+"  --csv                  Print the result as CSV rows instead of a table\n"
+"\n"
+"  Example:\n"
+"    jbreplay --dst-port=4000 --jb-algo=progressive,histogram file.pcap\n"
+"\n"
+;
+
+/* A captured RTP packet */
+struct packet
+{
+    pj_uint64_t          arrival;       /* Arrival time, in usec, since
+                                           the first packet             */
+    unsigned             len;
+    pj_uint8_t          *buf;
+};
+
+/* Replay result of one algorithm */
+struct result
+{
+    pjmedia_jb_state     jb_state;      /* Final jitter buffer state    */
+    unsigned             frames;        /* # of frames played           */
+    unsigned             concealed;     /* # of frames with no frame
+                                           from the jitter buffer       */
+    pj_uint64_t          put_nsec;      /* Total time in RX path        */
+    pj_uint64_t          get_nsec;      /* Total time in get_frame()    */
+};
+
+struct args
+{
+    pj_str_t                     codec;
+    pj_bool_t                    no_plc;
+    int                          jb_init;
+    int                          jb_min_pre;
+    int                          jb_max_pre;
+    int                          jb_max;
+    unsigned                     algo_cnt;
+    pjmedia_jb_discard_algo      algo[MAX_ALGO];
+    pj_bool_t                    csv;
+};
+
+static struct app
+{
+    pj_caching_pool      cp;
+    pj_pool_t           *pool;
+    pjmedia_endpt       *mept;
+    pjmedia_transport   *loop;
+    pj_pcap_file        *pcap;
+    const pjmedia_codec_info *ci;
+    unsigned             pt;
+    struct packet       *pkt;
+    unsigned             pkt_cnt;
+    unsigned             pkt_max;
+} app;
+
+static const char *algo_names[] =
+{
+    "none", "static", "progressive", "histogram"
+};
+
+
+static void cleanup()
+{
+    if (app.pcap) pj_pcap_close(app.pcap);
+    if (app.loop) pjmedia_transport_close(app.loop);
+    if (app.mept) pjmedia_endpt_destroy(app.mept);
+    if (app.pool) pj_pool_release(app.pool);
+    pjmedia_event_mgr_destroy(NULL);
+    pj_caching_pool_destroy(&app.cp);
+    pj_shutdown();
+}
+
+static void err_exit(const char *title, pj_status_t status)
+{
+    if (status != PJ_SUCCESS) {
+        char errmsg[PJ_ERR_MSG_SIZE];
+        pj_strerror(status, errmsg, sizeof(errmsg));
+        printf("Error: %s: %s\n", title, errmsg);
+    } else {
+        printf("Error: %s\n", title);
+    }
+    cleanup();
+    exit(1);
+}
+
+#define T(op)       do { \
+                        status = op; \
+                        if (status != PJ_SUCCESS) \
+                            err_exit(#op, status); \
+                    } while (0)
+
+
+/* Read all RTP packets with the payload type of the first packet from
+ * the PCAP file.
+ */
+static void read_packets(void)
+{
+    pjmedia_rtp_session rtp_sess;
+    pj_timestamp first_ts;
+    pj_status_t status;
+
+    T( pjmedia_rtp_session_init(&rtp_sess, 0, 0) );
+
+    for (;;) {
+        pj_uint8_t buf[PJMEDIA_MAX_MTU];
+        pj_size_t sz = sizeof(buf);
+        pj_timestamp ts;
+        const pjmedia_rtp_hdr *r;
+        const void *p;
+        unsigned payload_len;
+        struct packet *pkt;
+
+        status = pj_pcap_read_udp_with_timestamp(app.pcap, NULL, buf, &sz,
+                                                 &ts);
+        if (status == PJ_EEOF)
+            break;
+        if (status != PJ_SUCCESS)
+            err_exit("Error reading PCAP file", status);
+
+        status = pjmedia_rtp_decode_rtp(&rtp_sess, buf, (int)sz, &r,
+                                        &p, &payload_len);
+        if (status != PJ_SUCCESS || payload_len == 0)
+            continue;
+
+        if (app.pkt_cnt == 0) {
+            app.pt = r->pt;
+            first_ts = ts;
+        } else if (r->pt != app.pt) {
+            continue;
+        }
+
+        /* Grow the packet array */
+        if (app.pkt_cnt == app.pkt_max) {
+            struct packet *old = app.pkt;
+
+            app.pkt_max = app.pkt_max ? app.pkt_max * 2 : 1024;
+            app.pkt = (struct packet*)
+                      pj_pool_alloc(app.pool,
+                                    app.pkt_max * sizeof(struct packet));
+            if (old)
+                pj_memcpy(app.pkt, old, app.pkt_cnt * sizeof(struct packet));
+        }
+
+        pkt = &app.pkt[app.pkt_cnt++];
+        pkt->arrival = (ts.u64 - first_ts.u64) / 1000;
+        pkt->len = (unsigned)sz;
+        pkt->buf = (pj_uint8_t*)pj_pool_alloc(app.pool, sz);
+        pj_memcpy(pkt->buf, buf, sz);
+    }
+
+    if (app.pkt_cnt == 0)
+        err_exit("No RTP packet found", PJ_ENOTFOUND);
+}
+
+static void find_codec(const struct args *args)
+{
+    pjmedia_codec_mgr *cmgr;
+    pj_status_t status;
+
+    cmgr = pjmedia_endpt_get_codec_mgr(app.mept);
+
+    if (app.pt < 96) {
+        T( pjmedia_codec_mgr_get_codec_info(cmgr, app.pt, &app.ci) );
+    } else {
+        unsigned cnt = 2;
+        const pjmedia_codec_info *info[2];
+        T( pjmedia_codec_mgr_find_codecs_by_id(cmgr, &args->codec, &cnt,
+                                               info, NULL) );
+        if (cnt != 1)
+            err_exit("Codec ID must be specified and unique!", 0);
+
+        app.ci = info[0];
+    }
+}
+
+/* Replay all packets through a new stream using the specified discard
+ * algorithm.
+ */
+static void replay(const struct args *args, pjmedia_jb_discard_algo algo,
+                   struct result *res)
+{
+    pj_pool_t *pool;
+    pjmedia_codec_mgr *cmgr;
+    pjmedia_stream_info si;
+    pjmedia_stream *strm;
+    pjmedia_port *port;
+    pjmedia_jb_state jb_state;
+    pj_uint8_t pkt_buf[PJMEDIA_MAX_MTU];
+    pj_int16_t *frm_buf;
+    pj_uint64_t clock, ptime;
+    unsigned i, prev_missing, stall;
+    pj_status_t status;
+
+    pj_bzero(res, sizeof(*res));
+
+    pool = pj_pool_create(&app.cp.factory, "replay", 1000, 1000, NULL);
+
+    /* Create stream info */
+    pj_bzero(&si, sizeof(si));
+    si.type = PJMEDIA_TYPE_AUDIO;
+    si.proto = PJMEDIA_TP_PROTO_RTP_AVP;
+    si.dir = PJMEDIA_DIR_DECODING;
+    pj_sockaddr_in_init(&si.rem_addr.ipv4, NULL, 4000); /* dummy */
+    pj_sockaddr_in_init(&si.rem_rtcp.ipv4, NULL, 4001); /* dummy */
+    pj_memcpy(&si.fmt, app.ci, sizeof(*app.ci));
+    si.fmt.pt = app.pt;
+    si.tx_pt = si.rx_pt = app.pt;
+    si.jb_init = args->jb_init;
+    si.jb_min_pre = args->jb_min_pre;
+    si.jb_max_pre = args->jb_max_pre;
+    si.jb_max = args->jb_max;
+    si.jb_discard_algo = algo;
+
+    cmgr = pjmedia_endpt_get_codec_mgr(app.mept);
+    si.param = PJ_POOL_ALLOC_T(pool, pjmedia_codec_param);
+    T( pjmedia_codec_mgr_get_default_param(cmgr, app.ci, si.param) );
+    si.param->setting.plc = !args->no_plc;
+
+    T( pjmedia_stream_create(app.mept, pool, &si, app.loop, NULL, &strm) );
+    T( pjmedia_stream_get_port(strm, &port) );
+    T( pjmedia_stream_start(strm) );
+
+    frm_buf = (pj_int16_t*)
+              pj_pool_alloc(pool, PJMEDIA_PIA_AVG_FSZ(&port->info));
+    ptime = PJMEDIA_PIA_PTIME(&port->info) * 1000;
+
+    /* Run the playout clock until the last packet has arrived and the
+     * jitter buffer has been played out.
+     */
+    pj_bzero(&jb_state, sizeof(jb_state));
+    prev_missing = 0;
+    stall = 0;
+    i = 0;
+    for (clock = ptime;
+         i < app.pkt_cnt || (jb_state.size && stall < MAX_DRAIN_STALL);
+         clock += ptime)
+    {
+        pjmedia_frame frame;
+        pj_timestamp t0, t1;
+        unsigned missing, prev_size = jb_state.size;
+
+        /* Deliver the packets that have arrived by now */
+        while (i < app.pkt_cnt && app.pkt[i].arrival <= clock) {
+            /* Stream may modify the packet (e.g: SRTP), so copy it */
+            pj_memcpy(pkt_buf, app.pkt[i].buf, app.pkt[i].len);
+
+            pj_get_timestamp(&t0);
+            pjmedia_transport_send_rtp(app.loop, pkt_buf, app.pkt[i].len);
+            pj_get_timestamp(&t1);
+            res->put_nsec += pj_elapsed_nanosec(&t0, &t1);
+            ++i;
+        }
+
+        /* Play a frame */
+        pj_bzero(&frame, sizeof(frame));
+        frame.buf = frm_buf;
+        frame.size = PJMEDIA_PIA_AVG_FSZ(&port->info);
+
+        pj_get_timestamp(&t0);
+        status = pjmedia_port_get_frame(port, &frame);
+        pj_get_timestamp(&t1);
+        res->get_nsec += pj_elapsed_nanosec(&t0, &t1);
+        if (status != PJ_SUCCESS)
+            err_exit("Error getting frame from stream", status);
+
+        ++res->frames;
+
+        /* The stream had nothing from the jitter buffer to decode in this
+         * frame when the lost or empty count increases, so the frame was
+         * concealed by PLC (or zero filled).
+         */
+        pjmedia_stream_get_stat_jbuf(strm, &jb_state);
+        missing = jb_state.lost + jb_state.empty;
+        if (missing != prev_missing)
+            ++res->concealed;
+        prev_missing = missing;
+
+        if (i < app.pkt_cnt || jb_state.size < prev_size)
+            stall = 0;
+        else
+            ++stall;
+    }
+
+    pjmedia_stream_get_stat_jbuf(strm, &res->jb_state);
+
+    pjmedia_stream_destroy(strm);
+    pj_pool_release(pool);
+}
+
+static void print_result(const struct args *args,
+                         pjmedia_jb_discard_algo algo,
+                         const struct result *res)
+{
+    const pjmedia_jb_state *st = &res->jb_state;
+    double put_usec, get_usec;
+    double late_pct, conceal_pct;
+
+    put_usec = (double)res->put_nsec / 1000;
+    get_usec = (double)res->get_nsec / 1000;
+    late_pct = res->frames ? st->late * 100.0 / res->frames : 0;
+    conceal_pct = res->frames ? res->concealed * 100.0 / res->frames : 0;
+
+    if (args->csv) {
+        printf("%s,%d,%d,%d,%d,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%.0f,%.0f\n",
+               algo_names[algo], args->jb_init, args->jb_min_pre,
+               args->jb_max_pre, args->jb_max, res->frames,
+               st->avg_delay, st->min_delay, st->max_delay, st->dev_delay,
+               st->late, st->lost, st->discard, st->empty,
+               res->concealed, put_usec, get_usec);
+    } else {
+        printf("%-12s %4u/%4u/%4u/%4u    %6u %6.2f %6u %6u %6u %6u %6.2f "
+               "%6.2f %6.2f\n",
+               algo_names[algo],
+               st->avg_delay, st->min_delay, st->max_delay, st->dev_delay,
+               st->late, late_pct, st->lost, st->discard, st->empty,
+               res->concealed, conceal_pct,
+               app.pkt_cnt ? put_usec / app.pkt_cnt : 0,
+               res->frames ? get_usec / res->frames : 0);
+    }
+}
+
+static pj_status_t parse_algo(const char *list, struct args *args)
+{
+    pj_str_t input = pj_str((char*)list);
+    pj_str_t token;
+    pj_ssize_t found_idx;
+
+    args->algo_cnt = 0;
+    for (found_idx = pj_strtok2(&input, ",", &token, 0);
+         found_idx != input.slen;
+         found_idx = pj_strtok2(&input, ",", &token,
+                               found_idx + token.slen))
+    {
+        unsigned i;
+
+        for (i = 0; i < PJ_ARRAY_SIZE(algo_names); ++i) {
+            if (pj_stricmp2(&token, algo_names[i]) == 0)
+                break;
+        }
+        if (i == PJ_ARRAY_SIZE(algo_names) || args->algo_cnt == MAX_ALGO)
+            return PJ_EINVAL;
+
+        args->algo[args->algo_cnt++] = (pjmedia_jb_discard_algo)i;
+    }
+
+    return args->algo_cnt ? PJ_SUCCESS : PJ_EINVAL;
+}
+
+
+int main(int argc, char *argv[])
+{
+    pj_str_t input;
+    pj_pcap_filter filter;
+    pj_status_t status;
+    struct args args;
+    unsigned i;
+
+    enum {
+        OPT_SRC_IP = 1,
+        OPT_DST_IP,
+        OPT_SRC_PORT,
+        OPT_DST_PORT,
+        OPT_CODEC,
+        OPT_NO_PLC,
+        OPT_JB_ALGO,
+        OPT_JB_INIT,
+        OPT_JB_MIN_PRE,
+        OPT_JB_MAX_PRE,
+        OPT_JB_MAX,
+        OPT_CSV
+    };
+    struct pj_getopt_option long_options[] = {
+        { "src-ip",         1, 0, OPT_SRC_IP },
+        { "dst-ip",         1, 0, OPT_DST_IP },
+        { "src-port",       1, 0, OPT_SRC_PORT },
+        { "dst-port",       1, 0, OPT_DST_PORT },
+        { "codec",          1, 0, OPT_CODEC },
+        { "no-plc",         0, 0, OPT_NO_PLC },
+        { "jb-algo",        1, 0, OPT_JB_ALGO },
+        { "jb-init",        1, 0, OPT_JB_INIT },
+        { "jb-min-pre",     1, 0, OPT_JB_MIN_PRE },
+        { "jb-max-pre",     1, 0, OPT_JB_MAX_PRE },
+        { "jb-max",         1, 0, OPT_JB_MAX },
+        { "csv",            0, 0, OPT_CSV },
+        { NULL, 0, 0, 0}
+    };
+    int c;
+    int option_index;
+
+    pj_bzero(&args, sizeof(args));
+    args.jb_init = args.jb_min_pre = args.jb_max_pre = args.jb_max = -1;
+    parse_algo("static,progressive,histogram", &args);
+
+    pj_pcap_filter_default(&filter);
+    filter.link = PJ_PCAP_LINK_TYPE_ETH;
+    filter.proto = PJ_PCAP_PROTO_TYPE_UDP;
+
+    /* Parse arguments */
+    pj_optind = 0;
+    while((c=pj_getopt_long(argc,argv, "", long_options, &option_index))!=-1) {
+        switch (c) {
+        case OPT_SRC_IP:
+            {
+                pj_str_t t = pj_str(pj_optarg);
+                pj_in_addr a = pj_inet_addr(&t);
+                filter.ip_src = a.s_addr;
+            }
+            break;
+        case OPT_DST_IP:
+            {
+                pj_str_t t = pj_str(pj_optarg);
+                pj_in_addr a = pj_inet_addr(&t);
+                filter.ip_dst = a.s_addr;
+            }
+            break;
+        case OPT_SRC_PORT:
+            filter.src_port = pj_htons((pj_uint16_t)atoi(pj_optarg));
+            break;
+        case OPT_DST_PORT:
+            filter.dst_port = pj_htons((pj_uint16_t)atoi(pj_optarg));
+            break;
+        case OPT_CODEC:
+            args.codec = pj_str(pj_optarg);
+            break;
+        case OPT_NO_PLC:
+            args.no_plc = PJ_TRUE;
+            break;
+        case OPT_JB_ALGO:
+            if (parse_algo(pj_optarg, &args) != PJ_SUCCESS) {
+                puts("Error: invalid jitter buffer algorithm list");
+                return 1;
+            }
+            break;
+        case OPT_JB_INIT:
+            args.jb_init = atoi(pj_optarg);
+            break;
+        case OPT_JB_MIN_PRE:
+            args.jb_min_pre = atoi(pj_optarg);
+            break;
+        case OPT_JB_MAX_PRE:
+            args.jb_max_pre = atoi(pj_optarg);
+            break;
+        case OPT_JB_MAX:
+            args.jb_max = atoi(pj_optarg);
+            break;
+        case OPT_CSV:
+            args.csv = PJ_TRUE;
+            break;
+        default:
+            puts("Error: invalid option");
+            return 1;
+        }
+    }
+
+    if (pj_optind != argc - 1) {
+        puts(USAGE);
+        return 1;
+    }
+
+    input = pj_str(argv[pj_optind]);
+
+    pj_log_set_level(2);
+    T( pj_init() );
+
+    pj_caching_pool_init(&app.cp, NULL, 0);
+    app.pool = pj_pool_create(&app.cp.factory, "jbreplay", 4000, 4000, NULL);
+
+    T( pjlib_util_init() );
+    T( pjmedia_event_mgr_create(app.pool, 0, NULL) );
+    T( pjmedia_endpt_create(&app.cp.factory, NULL, 0, &app.mept) );
+    T( pjmedia_codec_register_audio_codecs(app.mept, NULL) );
+    T( pjmedia_transport_loop_create(app.mept, &app.loop) );
+
+    T( pj_pcap_open(app.pool, input.ptr, &app.pcap) );
+    T( pj_pcap_set_filter(app.pcap, &filter) );
+
+    read_packets();
+    find_codec(&args);
+
+    if (args.csv) {
+        puts("algo,jb_init,jb_min_pre,jb_max_pre,jb_max,frames,"
+             "avg_delay,min_delay,max_delay,dev_delay,"
+             "late,lost,discard,empty,concealed,put_usec,get_usec");
+    } else {
+        printf("Replaying %u packets (%.*s, PT %u, %u.%03us)\n\n",
+               app.pkt_cnt, (int)app.ci->encoding_name.slen,
+               app.ci->encoding_name.ptr, app.pt,
+               (unsigned)(app.pkt[app.pkt_cnt-1].arrival / 1000000),
+               (unsigned)(app.pkt[app.pkt_cnt-1].arrival / 1000 % 1000));
+        printf("%-12s %-22s %6s %6s %6s %6s %6s %6s %6s %6s %6s\n",
+               "algorithm", "delay avg/min/max/dev", "late", "late%",
+               "lost", "disc", "empty", "concl", "concl%", "put us", "get us");
+    }
+
+    for (i = 0; i < args.algo_cnt; ++i) {
+        struct result res;
+
+        replay(&args, args.algo[i], &res);
+        print_result(&args, args.algo[i], &res);
+    }
+
+    cleanup();
+    return 0;
+}
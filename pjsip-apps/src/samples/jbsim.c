@@ -50,6 +50,9 @@
 #define LOSS_CORR       0
 #define LOSS_EXTRA      2
 #define SILENT          1
+#define JB_ALGO         PJMEDIA_JB_DISCARD_PROGRESSIVE
+#define MAX_TRACE       100000
+#define TRACE_LOST      -1
 
 /*
    Test setup:
@@ -139,6 +142,7 @@ struct test_cfg
     unsigned         tx_min_lost_burst; /* Min lost burst in #pkt   */
     unsigned         tx_max_lost_burst; /* Max lost burst in #pkt   */
     unsigned         tx_pct_loss_corr;  /* Loss correlation in pct  */
+    const char      *tx_trace;          /* Network trace file       */
 
     /* Receiver setting */
     const char      *rx_wav_out;        /* Output WAV file          */
@@ -149,6 +153,7 @@ struct test_cfg
     int              rx_jb_min_pre;     /* JB minimum prefetch (ms) */
     int              rx_jb_max_pre;     /* JB maximum prefetch (ms) */
     int              rx_jb_max;         /* JB maximum size (ms)     */
+    pjmedia_jb_discard_algo rx_jb_algo; /* JB discard algorithm     */
 };
 
 /*
@@ -173,6 +178,10 @@ struct global_app
     pjmedia_port        *rx_wav;
 
     pj_time_val          wall_clock;
+
+    int                 *trace;         /* Per packet delay in ms, or
+                                           TRACE_LOST                */
+    unsigned             trace_cnt;     /* Number of packets in trace */
 };
 
 static struct global_app g_app;
@@ -339,7 +348,7 @@ static pj_status_t stream_init(const struct stream_cfg *cfg, struct stream **p_s
         si.jb_min_pre = g_app.cfg.rx_jb_min_pre;
         si.jb_max_pre = g_app.cfg.rx_jb_max_pre;
         si.jb_max = g_app.cfg.rx_jb_max;
-        si.jb_discard_algo = PJMEDIA_JB_DISCARD_PROGRESSIVE;
+        si.jb_discard_algo = g_app.cfg.rx_jb_algo;
     }
 
     /* Get the codec info and param */
@@ -409,6 +418,60 @@ on_error:
 }
 
 
+/*****************************************************************************
+ * Network trace
+ */
+
+/* Load network trace, containing one packet per line: the packet delay in
+ * msec, or 'x' for lost packet. Lines started with '#' are ignored.
+ */
+static pj_status_t load_trace(const char *filename)
+{
+    FILE *f;
+    char line[80];
+    int min_delay = 0;
+    unsigned i;
+
+    f = fopen(filename, "rt");
+    if (!f)
+        return PJ_ENOTFOUND;
+
+    g_app.trace = (int*)pj_pool_calloc(g_app.pool, MAX_TRACE, sizeof(int));
+    g_app.trace_cnt = 0;
+
+    while (g_app.trace_cnt < MAX_TRACE && fgets(line, sizeof(line), f)) {
+        char *p = line;
+        int delay;
+
+        while (pj_isspace(*p)) ++p;
+        if (*p == '\0' || *p == '#')
+            continue;
+
+        if (*p == 'x' || *p == 'X') {
+            g_app.trace[g_app.trace_cnt++] = TRACE_LOST;
+            continue;
+        }
+
+        delay = atoi(p);
+        if (g_app.trace_cnt == 0 || delay < min_delay)
+            min_delay = delay;
+        g_app.trace[g_app.trace_cnt++] = delay;
+    }
+    fclose(f);
+
+    if (g_app.trace_cnt == 0)
+        return PJ_ETOOSMALL;
+
+    /* Only the delay variation matters */
+    for (i = 0; i < g_app.trace_cnt; ++i) {
+        if (g_app.trace[i] != TRACE_LOST)
+            g_app.trace[i] -= min_delay;
+    }
+
+    return PJ_SUCCESS;
+}
+
+
 /*****************************************************************************
  * The test session
  */
@@ -469,6 +532,15 @@ static pj_status_t test_init(void)
         pj_log_set_log_func(&log_cb);
     }
 
+    /* Network trace */
+    if (g_app.cfg.tx_trace) {
+        status = load_trace(g_app.cfg.tx_trace);
+        if (status != PJ_SUCCESS) {
+            jbsim_perror("Error reading network trace file", status);
+            goto on_error;
+        }
+    }
+
     /* 
      * Initialize media endpoint.
      * This will implicitly initialize PJMEDIA too.
@@ -634,7 +706,12 @@ static void tx_tick(const pj_time_val *t)
         /* 
          * Determine whether to drop this packet 
          */
-        if (strm->state.tx.cur_lost_burst) {
+        if (g_app.trace) {
+            /* Replaying network trace */
+            drop_this_pkt = (g_app.trace[strm->state.tx.total_tx %
+                                         g_app.trace_cnt] == TRACE_LOST);
+
+        } else if (strm->state.tx.cur_lost_burst) {
             /* We are currently dropping packet */
 
             /* Make it comply to minimum lost burst */
@@ -660,7 +737,7 @@ static void tx_tick(const pj_time_val *t)
         }
 
         /* If we're not dropping packet then use randomly distributed loss */
-        if (!drop_this_pkt &&
+        if (!drop_this_pkt && !g_app.trace &&
             MAX(strm->state.tx.total_lost-LOSS_EXTRA,0) * 100 / MAX(strm->state.tx.total_tx,1) < g_app.cfg.tx_pct_avg_lost)
         {
             strm->state.tx.drop_prob = pj_rand() % 100;
@@ -715,7 +792,14 @@ static void tx_tick(const pj_time_val *t)
         strm->state.tx.next_schedule.msec = (strm->state.tx.total_tx + 1) * pkt_interval;
 
         /* Apply jitter */
-        if (g_app.cfg.tx_max_jitter || g_app.cfg.tx_min_jitter) {
+        if (g_app.trace) {
+            /* Delay of the next packet in the trace */
+            jitter = g_app.trace[(strm->state.tx.total_tx + 1) %
+                                 g_app.trace_cnt];
+            if (jitter == TRACE_LOST)
+                jitter = 0;
+
+        } else if (g_app.cfg.tx_max_jitter || g_app.cfg.tx_min_jitter) {
 
             if (g_app.cfg.tx_max_jitter == g_app.cfg.tx_min_jitter) {
                 /* Fixed jitter */
@@ -875,6 +959,8 @@ enum {
     OPT_MIN_LOST_BURST = 1,
     OPT_MAX_LOST_BURST,
     OPT_LOSS_CORR,
+    OPT_TRACE,
+    OPT_JB_ALGO,
 };
 
 
@@ -915,6 +1001,9 @@ static void usage(void)
     printf("                         Default: 0\n");
     printf("  --max-jitter, -%c MSEC  Set maximum network jitter to MSEC\n", OPT_MAX_JITTER);
     printf("                         Default: 0\n");
+    printf("  --trace FILE           Replay network trace FILE instead of the loss and\n");
+    printf("                         jitter settings above. FILE contains one packet\n");
+    printf("                         per line, the packet delay in msec or 'x' if lost\n");
     printf("  --snd-burst, -%c VAL    Set RX sound burst value to VAL frames.\n", OPT_SND_BURST);
     printf("                         Default: 1\n");
     printf("  --tx-ptime, -%c MSEC    Set transmitter ptime to MSEC\n", OPT_TX_PTIME);
@@ -928,6 +1017,8 @@ static void usage(void)
     printf("  --jb-max-pre, -%c MSEC  Jitter buffer maximum prefetch delay in msec\n", OPT_JB_MAX_PRE);
     printf("  --jb-max, -%c MSEC      Set maximum delay that can be accomodated by the\n", OPT_JB_MAX);
     printf("                         jitter buffer msec.\n");
+    printf("  --jb-algo NAME         Jitter buffer discard algorithm: none, static,\n");
+    printf("                         progressive, or histogram. Default: progressive\n");
 }
 
 
@@ -943,6 +1034,7 @@ static int init_options(int argc, char *argv[])
         { "min-lost-burst", 1, 0, OPT_MIN_LOST_BURST},
         { "max-lost-burst", 1, 0, OPT_MAX_LOST_BURST},
         { "loss-corr",      1, 0, OPT_LOSS_CORR},
+        { "trace",          1, 0, OPT_TRACE},
         { "min-jitter",     1, 0, OPT_MIN_JITTER },
         { "max-jitter",     1, 0, OPT_MAX_JITTER },
         { "snd-burst",      1, 0, OPT_SND_BURST },
@@ -954,6 +1046,7 @@ static int init_options(int argc, char *argv[])
         { "jb-min-pre",     1, 0, OPT_JB_MIN_PRE },
         { "jb-max-pre",     1, 0, OPT_JB_MAX_PRE },
         { "jb-max",         1, 0, OPT_JB_MAX },
+        { "jb-algo",        1, 0, OPT_JB_ALGO },
         { "help",           0, 0, OPT_HELP},
         { NULL, 0, 0, 0 },
     };
@@ -984,6 +1077,7 @@ static int init_options(int argc, char *argv[])
     g_app.cfg.rx_jb_min_pre = -1;
     g_app.cfg.rx_jb_max_pre = -1;
     g_app.cfg.rx_jb_max = -1;
+    g_app.cfg.rx_jb_algo = JB_ALGO;
 
     /* Build format */
     format[0] = '\0';
@@ -1043,6 +1137,9 @@ static int init_options(int argc, char *argv[])
                 return 1;
             }
             break;
+        case OPT_TRACE:
+            g_app.cfg.tx_trace = pj_optarg;
+            break;
         case OPT_MIN_JITTER:
             g_app.cfg.tx_min_jitter = atoi(pj_optarg);
             break;
@@ -1076,6 +1173,20 @@ static int init_options(int argc, char *argv[])
         case OPT_JB_MAX:
             g_app.cfg.rx_jb_max = atoi(pj_optarg);
             break;
+        case OPT_JB_ALGO:
+            if (pj_ansi_stricmp(pj_optarg, "none") == 0)
+                g_app.cfg.rx_jb_algo = PJMEDIA_JB_DISCARD_NONE;
+            else if (pj_ansi_stricmp(pj_optarg, "static") == 0)
+                g_app.cfg.rx_jb_algo = PJMEDIA_JB_DISCARD_STATIC;
+            else if (pj_ansi_stricmp(pj_optarg, "progressive") == 0)
+                g_app.cfg.rx_jb_algo = PJMEDIA_JB_DISCARD_PROGRESSIVE;
+            else if (pj_ansi_stricmp(pj_optarg, "histogram") == 0)
+                g_app.cfg.rx_jb_algo = PJMEDIA_JB_DISCARD_HISTOGRAM;
+            else {
+                puts("Error: Invalid jitter buffer algorithm?");
+                return 1;
+            }
+            break;
         case OPT_HELP:
             usage();
             return 1;
@@ -1132,11 +1243,16 @@ int main(int argc, char *argv[])
     PJ_LOG(3,(THIS_FILE, " TX jitter min=%dms, max=%dms",
               g_app.cfg.tx_min_jitter, 
               g_app.cfg.tx_max_jitter));
+    if (g_app.trace) {
+        PJ_LOG(3,(THIS_FILE, " TX trace=%s (%u packets)",
+                  g_app.cfg.tx_trace, g_app.trace_cnt));
+    }
     PJ_LOG(3,(THIS_FILE, " RX jb init:%dms, min_pre=%dms, max_pre=%dms, max=%dms",
               g_app.cfg.rx_jb_init,
               g_app.cfg.rx_jb_min_pre,
               g_app.cfg.rx_jb_max_pre,
               g_app.cfg.rx_jb_max));
+    PJ_LOG(3,(THIS_FILE, " RX jb algo:%d", g_app.cfg.rx_jb_algo));
     PJ_LOG(3,(THIS_FILE, " RX sound burst:%d frames",
               g_app.cfg.rx_snd_burst));
     PJ_LOG(3,(THIS_FILE, " DTX=%d, PLC=%d",
@@ -1151,6 +1267,16 @@ int main(int argc, char *argv[])
               g_app.tx->state.tx.total_tx,
               g_app.tx->state.tx.total_lost,
               (float)(g_app.tx->state.tx.total_lost * 100.0 / g_app.tx->state.tx.total_tx)));
+    {
+        pjmedia_jb_state jstate;
+
+        pjmedia_stream_get_stat_jbuf(g_app.rx->strm, &jstate);
+        PJ_LOG(3,(THIS_FILE, " RX jb delay (min/max/avg/dev)=%u/%u/%u/%u ms",
+                  jstate.min_delay, jstate.max_delay, jstate.avg_delay,
+                  jstate.dev_delay));
+        PJ_LOG(3,(THIS_FILE, " RX jb lost=%u, discard=%u, empty=%u",
+                  jstate.lost, jstate.discard, jstate.empty));
+    }
 
     /* Done */
     test_destroy();
@@ -629,28 +629,28 @@ static void simple_registrar(pjsip_rx_data *rdata)
     exp = (pjsip_expires_hdr*)
           pjsip_msg_find_hdr(rdata->msg_info.msg, PJSIP_H_EXPIRES, NULL);
 
-    h = rdata->msg_info.msg->hdr.next;
-    while (h != &rdata->msg_info.msg->hdr) {
-        if (h->type == PJSIP_H_CONTACT) {
-            const pjsip_contact_hdr *c = (const pjsip_contact_hdr*)h;
-            int e = c->expires;
-
-            if (e < 0) {
-                if (exp)
-                    e = exp->ivalue;
-                else
-                    e = 3600;
-            }
+    h = (const pjsip_hdr*)
+        pjsip_msg_find_hdr(rdata->msg_info.msg, PJSIP_H_CONTACT, NULL);
+    while (h) {
+        const pjsip_contact_hdr *c = (const pjsip_contact_hdr*)h;
+        int e = c->expires;
+
+        if (e < 0) {
+            if (exp)
+                e = exp->ivalue;
+            else
+                e = 3600;
+        }
 
-            if (e > 0) {
-                pjsip_contact_hdr *nc = (pjsip_contact_hdr*)
-                                        pjsip_hdr_clone(tdata->pool, h);
-                nc->expires = e;
-                pjsip_msg_add_hdr(tdata->msg, (pjsip_hdr*)nc);
-                ++cnt;
-            }
+        if (e > 0) {
+            pjsip_contact_hdr *nc = (pjsip_contact_hdr*)
+                                    pjsip_hdr_clone(tdata->pool, h);
+            nc->expires = e;
+            pjsip_msg_add_hdr(tdata->msg, (pjsip_hdr*)nc);
+            ++cnt;
         }
-        h = h->next;
+        h = (const pjsip_hdr*)
+            pjsip_msg_find_hdr(rdata->msg_info.msg, PJSIP_H_CONTACT, h->next);
     }
 
     srv = pjsip_generic_string_hdr_create(tdata->pool, NULL, NULL);
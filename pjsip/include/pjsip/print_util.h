@@ -162,6 +162,7 @@ PJ_INLINE(void) init_hdr(void *hptr, pjsip_hdr_e htype, void *vptr)
         hdr->sname = hdr->name;
     }
     hdr->vptr = (pjsip_hdr_vptr*) vptr;
+    hdr->print_cache = NULL;
     pj_list_init(hdr);
 }
 
@@ -188,6 +188,19 @@ typedef struct pjsip_cfg_t
          */
         pj_bool_t keep_inv_after_tsx_timeout;
 
+        /**
+         * Parse incoming messages lazily. When enabled, the parser only
+         * parses the headers needed by the core stack (Via, From, To,
+         * Call-ID, CSeq, Route, Record-Route, Max-Forwards, Content-Type,
+         * Content-Length, Require and Supported), and keeps the other
+         * known headers as unparsed pjsip_lazy_hdr pointing to the packet
+         * buffer, to be parsed when they are first searched with
+         * pjsip_msg_find_hdr() and friends.
+         *
+         * Default is PJSIP_LAZY_HDR_PARSE.
+         */
+        pj_bool_t lazy_hdr_parse;
+
     } endpt;
 
     /** Transaction layer settings. */
@@ -316,6 +329,21 @@ PJ_INLINE(pjsip_cfg_t*) pjsip_cfg(void)
 #   define PJSIP_MAX_TSX_COUNT          (1024-1)
 #endif
 
+/**
+ * Specify the number of shards of the transaction table. Each shard has
+ * its own hash tables and mutex, and a transaction is put in the shard
+ * selected by the hash of its key, so that lookups from different worker
+ * threads rarely contend on the same lock. The hash table size of each
+ * shard is PJSIP_MAX_TSX_COUNT divided by this value.
+ *
+ * Set this to 1 to use a single table as in previous versions.
+ *
+ * Default value is 16.
+ */
+#ifndef PJSIP_TSX_TABLE_SHARD_CNT
+#   define PJSIP_TSX_TABLE_SHARD_CNT    16
+#endif
+
 /**
  * Specify maximum number of dialogs in the dialog hash table.
  * For efficiency, the value should be 2^n-1 since it will be
@@ -515,6 +543,25 @@ PJ_INLINE(pjsip_cfg_t*) pjsip_cfg(void)
 #endif
 
 
+/**
+ * Default maximum number of datagrams that the UDP transport drains from
+ * its socket with one batched receive call (recvmmsg() where available)
+ * each time the socket becomes readable. Batched receive reduces the
+ * number of system calls and ioqueue callbacks under heavy load, at the
+ * cost of one additional receive buffer (of PJSIP_MAX_PKT_LEN size) per
+ * batch entry for each asynchronous read.
+ *
+ * Value 0 or 1 disables batched receive, i.e. one datagram is read per
+ * ioqueue callback. This can also be set per transport with the
+ * \a recv_batch_cnt field of pjsip_udp_transport_cfg.
+ *
+ * Default is 0 (disabled)
+ */
+#ifndef PJSIP_UDP_RECV_BATCH_CNT
+#   define PJSIP_UDP_RECV_BATCH_CNT     0
+#endif
+
+
 /**
  * Encode SIP headers in their short forms to reduce size. By default,
  * SIP headers in outgoing messages will be encoded in their full names. 
@@ -534,6 +581,48 @@ PJ_INLINE(pjsip_cfg_t*) pjsip_cfg(void)
 #endif
 
 
+/**
+ * Parse incoming SIP messages lazily. When enabled, headers which are not
+ * needed by the core stack (such as Contact, Accept, Allow, Expires and
+ * the Authorization headers) are not parsed when the message is received,
+ * but kept as pjsip_lazy_hdr referring to the raw header text in the
+ * packet buffer. Such a header is parsed the first time it is searched
+ * with pjsip_msg_find_hdr(), pjsip_msg_find_hdr_by_name() and friends,
+ * and is replaced in the message by the parsed header. Messages which are
+ * only forwarded (e.g. by a proxy) never need these headers parsed.
+ *
+ * Note that code walking the header list directly sees unparsed headers
+ * as generic string headers (of type PJSIP_H_OTHER). Also, syntax errors
+ * in these headers are only detected when the header is parsed, after
+ * which the header is left unparsed.
+ *
+ * This option can also be controlled at run-time by the
+ * \a lazy_hdr_parse setting in pjsip_cfg_t.
+ *
+ * Default is 0 (no)
+ */
+#ifndef PJSIP_LAZY_HDR_PARSE
+#   define PJSIP_LAZY_HDR_PARSE         0
+#endif
+
+
+/**
+ * Keep the printed value of the endpoint capability headers (Accept, Allow
+ * and Supported, see pjsip_endpt_add_capability()), so that outgoing
+ * messages carrying these headers copy the cached text instead of
+ * printing the header again (see pjsip_hdr_cache_print()).
+ *
+ * Since the cache is shared by shallow clones of the headers, application
+ * that modifies such a clone in an outgoing message must call
+ * pjsip_hdr_invalidate_cache() on it.
+ *
+ * Default is 1 (yes)
+ */
+#ifndef PJSIP_CACHE_CAPABILITY_HDR
+#   define PJSIP_CACHE_CAPABILITY_HDR   1
+#endif
+
+
 /**
  * Send Allow header in dialog establishing requests?
  * RFC 3261 Allow header SHOULD be included in dialog establishing
@@ -669,6 +758,31 @@ PJ_INLINE(pjsip_cfg_t*) pjsip_cfg(void)
 #endif
 
 
+/**
+ * Default number of SIP worker threads to which the transport (I/O)
+ * threads hand off incoming messages, see pjsip_endpt_start_rx_workers().
+ * Messages are assigned to the workers by their Call-ID, so messages of
+ * the same dialog are always processed in order by the same worker.
+ *
+ * Default: 0 (incoming messages are processed by the I/O thread)
+ */
+#ifndef PJSIP_RX_WORKER_CNT
+#   define PJSIP_RX_WORKER_CNT          0
+#endif
+
+
+/**
+ * Default maximum number of incoming messages waiting to be processed by
+ * a single SIP worker thread. When a worker is this far behind, further
+ * messages for it are dropped (and are expected to be retransmitted).
+ *
+ * Default: 0 (no limit)
+ */
+#ifndef PJSIP_RX_WORKER_MAX_PENDING
+#   define PJSIP_RX_WORKER_MAX_PENDING  0
+#endif
+
+
 /**
  * Idle timeout interval to be applied to outgoing transports (i.e. client
  * side) with no usage before the transport is destroyed. Value is in
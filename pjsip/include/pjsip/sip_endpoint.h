@@ -323,6 +323,77 @@ PJ_DECL(pj_status_t) pjsip_endpt_process_rx_data(pjsip_endpoint *endpt,
                                                  pjsip_process_rdata_param *p,
                                                  pj_bool_t *p_handled);
 
+/**
+ * This describes the parameters of pjsip_endpt_start_rx_workers().
+ * Application MUST call pjsip_rx_worker_param_default() to initialize
+ * this structure.
+ */
+typedef struct pjsip_rx_worker_param
+{
+    /**
+     * Number of SIP worker threads to start.
+     *
+     * Default: PJSIP_RX_WORKER_CNT, or 1 if that is zero.
+     */
+    unsigned worker_cnt;
+
+    /**
+     * Maximum number of messages waiting to be processed by a single
+     * worker, after which further messages for that worker are dropped.
+     * Zero means no limit.
+     *
+     * Default: PJSIP_RX_WORKER_MAX_PENDING
+     */
+    unsigned max_pending;
+
+} pjsip_rx_worker_param;
+
+/**
+ * Initialize with default.
+ *
+ * @param p     The param.
+ */
+PJ_DECL(void) pjsip_rx_worker_param_default(pjsip_rx_worker_param *p);
+
+/**
+ * Start SIP worker threads to process incoming messages. Once started, the
+ * thread that receives a message from a transport (i.e. the thread that
+ * polls the ioqueue) only parses the message, then clones the rdata (see
+ * pjsip_rx_data_clone()) and hands it off to one of the workers, which
+ * distributes it to the modules. The hand-off queue is lock-free on
+ * compilers that support atomic builtins.
+ *
+ * The worker is chosen by the hash of the Call-ID of the message, so all
+ * messages of a dialog are processed in the order they are received, by
+ * the same worker.
+ *
+ * Note that since modules receive a cloned rdata, they must not keep
+ * pointers to the rdata after returning from their callbacks (which is
+ * already the rule for rdata given by transports), and should use
+ * pjsip_rx_data_clone() when they need to postpone the processing.
+ *
+ * @param endpt         The endpoint instance.
+ * @param param         Optional parameters, NULL to use the default.
+ *
+ * @return              PJ_SUCCESS on success, or PJ_EEXISTS if the workers
+ *                      have already been started.
+ */
+PJ_DECL(pj_status_t) pjsip_endpt_start_rx_workers(
+                                        pjsip_endpoint *endpt,
+                                        const pjsip_rx_worker_param *param);
+
+/**
+ * Stop the SIP worker threads started by pjsip_endpt_start_rx_workers(),
+ * after they have processed the messages already handed off to them.
+ * Incoming messages will be processed by the receiving thread again.
+ * This function is called by pjsip_endpt_destroy().
+ *
+ * @param endpt         The endpoint instance.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjsip_endpt_stop_rx_workers(pjsip_endpoint *endpt);
+
 /**
  * Create pool from the endpoint. All SIP components should allocate their
  * memory pool by calling this function, to make sure that the pools are
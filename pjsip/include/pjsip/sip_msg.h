@@ -313,7 +313,9 @@ typedef struct pjsip_hdr_vptr
     /** Header short name version. */   \
     pj_str_t        sname;              \
     /** Virtual function table. */      \
-    pjsip_hdr_vptr *vptr
+    pjsip_hdr_vptr *vptr;               \
+    /** Cached printed value, or NULL. See #pjsip_hdr_cache_print() */ \
+    const pj_str_t *print_cache
 
 
 /**
@@ -361,9 +363,45 @@ PJ_DECL(void*) pjsip_hdr_shallow_clone( pj_pool_t *pool, const void *hdr );
  */
 PJ_DECL(int) pjsip_hdr_print_on( void *hdr, char *buf, pj_size_t len);
 
+/**
+ * Print the header value once and keep the result in the header, so that
+ * subsequent pjsip_hdr_print_on() of the header (for example when a
+ * message containing it is encoded with pjsip_tx_data_encode()) only
+ * copies the cached string. The header name is still selected at print
+ * time according to the compact form setting.
+ *
+ * This is meant for headers that are printed many times without being
+ * changed, such as the endpoint capability headers. The cache is shared
+ * by shallow clones of the header and is not copied by
+ * pjsip_hdr_clone(). Any modification to the header, or to a shallow
+ * clone of it, must be followed by pjsip_hdr_invalidate_cache(),
+ * otherwise the old value will be printed.
+ *
+ * @param pool      Pool to allocate the cached string from. It must
+ *                  remain valid as long as the header (and its shallow
+ *                  clones) is in use.
+ * @param hdr       The header.
+ *
+ * @return          PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjsip_hdr_cache_print( pj_pool_t *pool, void *hdr );
+
+/**
+ * Discard the cached printed value of the header, if any, so that it will
+ * be printed from its fields again. See #pjsip_hdr_cache_print().
+ *
+ * @param hdr       The header.
+ */
+PJ_DECL(void) pjsip_hdr_invalidate_cache( void *hdr );
+
 /**
  * Find a header in a header list by the header type.
  *
+ * When lazy header parsing is enabled (see PJSIP_LAZY_HDR_PARSE), an
+ * unparsed header which matches the search is parsed and replaced in the
+ * list by the parsed header(s), so the list is modified even though it is
+ * declared const. The same applies to the other header search functions.
+ *
  * @param hdr_list  The "head" of the header list.
  * @param type      The header type to find.
  * @param start     The first header field where the search should begin.
@@ -1133,6 +1171,71 @@ PJ_DECL(void) pjsip_generic_string_hdr_init2(pjsip_generic_string_hdr *h,
                                              pj_str_t *hvalue);
 
 
+/* **************************************************************************/
+
+/**
+ * Unparsed SIP header, created by the parser for known headers which have
+ * not been parsed yet when lazy header parsing is enabled (see
+ * PJSIP_LAZY_HDR_PARSE). The header has PJSIP_H_OTHER type, and has the
+ * same layout as pjsip_generic_string_hdr, so it can be printed, cloned
+ * and read as a generic string header. It is parsed and replaced in its
+ * list by the parsed header(s) when it is found by pjsip_hdr_find(),
+ * pjsip_hdr_find_by_name() and friends, or explicitly with
+ * pjsip_lazy_hdr_parse().
+ */
+typedef struct pjsip_lazy_hdr
+{
+    /** Standard header field. */
+    PJSIP_DECL_HDR_MEMBER(struct pjsip_lazy_hdr);
+    /** The raw header value. */
+    pj_str_t hvalue;
+    /** The type of the header once it is parsed. */
+    pjsip_hdr_e htype;
+    /** The pool to allocate the parsed header from. */
+    pj_pool_t *pool;
+} pjsip_lazy_hdr;
+
+
+/**
+ * Create an unparsed header. The header is given the standard name of
+ * \a htype. The value is not set, and the caller must set it to a string
+ * which remains valid as long as the header is used. The value must be
+ * followed by a character which can not be part of the header value, such
+ * as newline or NULL character.
+ *
+ * @param pool      The pool, which is also used to parse the header later.
+ * @param htype     The type of the header once it is parsed.
+ *
+ * @return          The header.
+ */
+PJ_DECL(pjsip_lazy_hdr*) pjsip_lazy_hdr_create(pj_pool_t *pool,
+                                               pjsip_hdr_e htype);
+
+
+/**
+ * Check whether the header is an unparsed header.
+ *
+ * @param hdr       The header.
+ *
+ * @return          PJ_TRUE if the header is a pjsip_lazy_hdr.
+ */
+PJ_DECL(pj_bool_t) pjsip_hdr_is_lazy(const void *hdr);
+
+
+/**
+ * Parse an unparsed header, and replace it in its list with the parsed
+ * header(s). A single header may yield several headers, e.g. a Contact
+ * header containing several contacts. If the header fails to parse, it
+ * is left in the list as a generic string header, so that it is not
+ * parsed again.
+ *
+ * @param hdr       The unparsed header.
+ *
+ * @return          The first parsed header, or NULL on syntax error.
+ */
+PJ_DECL(pjsip_hdr*) pjsip_lazy_hdr_parse(pjsip_lazy_hdr *hdr);
+
+
 /* **************************************************************************/
 
 /**
@@ -120,6 +120,15 @@ typedef struct pjsip_udp_transport_cfg
      */
     pj_sockopt_params   sockopt_params;
 
+    /**
+     * Maximum number of datagrams to drain from the socket with a single
+     * batched receive call (recvmmsg() where available) each time the
+     * socket becomes readable. Value 0 or 1 disables batched receive.
+     *
+     * Default: PJSIP_UDP_RECV_BATCH_CNT
+     */
+    unsigned            recv_batch_cnt;
+
 } pjsip_udp_transport_cfg;
 
 
@@ -282,6 +282,9 @@ typedef int pjsua_avi_rec_id;
 /** Conference port identification */
 typedef int pjsua_conf_port_id;
 
+/** Conference room identification */
+typedef int pjsua_conf_room_id;
+
 /** Opaque declaration for server side presence subscription */
 typedef struct pjsua_srv_pres pjsua_srv_pres;
 
@@ -2539,6 +2542,31 @@ typedef struct pjsua_config
      */
     unsigned        thread_cnt;
 
+    /**
+     * Split the SIP endpoint timer heap into one sub-heap per worker
+     * thread, so that the worker threads don't contend on a single timer
+     * heap lock and the timers sharing a group lock (e.g. of a call) are
+     * always run by the same worker thread. See
+     * pj_timer_heap_set_thread_heaps() for more info. This setting only
+     * takes effect when \a thread_cnt is greater than one, and is ignored
+     * when PJSUA_SEPARATE_WORKER_FOR_TIMER is enabled.
+     *
+     * Default: PJ_FALSE
+     */
+    pj_bool_t       timer_heap_per_thread;
+
+    /**
+     * Number of SIP worker threads to which the threads polling the network
+     * (see \a thread_cnt) hand off incoming messages after parsing them.
+     * Messages are assigned to these threads by their Call-ID, so that the
+     * messages of a call are still processed in order. See
+     * pjsip_endpt_start_rx_workers() for more info.
+     *
+     * Default: PJSIP_RX_WORKER_CNT (zero, i.e. incoming messages are
+     * processed by the polling thread)
+     */
+    unsigned        rx_worker_cnt;
+
     /**
      * Number of nameservers. If no name server is configured, the SIP SRV
      * resolution would be disabled, and domain will be resolved with
@@ -6560,6 +6588,37 @@ PJ_DECL(pj_bool_t) pjsua_call_has_media(pjsua_call_id call_id);
 PJ_DECL(pjsua_conf_port_id) pjsua_call_get_conf_port(pjsua_call_id call_id);
 
 
+/**
+ * Move the audio of the call to a conference room, or back to the main
+ * conference bridge. In a room, the call is connected to every other
+ * call of the room and is not in the main conference bridge, so
+ * #pjsua_call_get_conf_port() returns PJSUA_INVALID_ID. When it moves
+ * back, the call gets a new port in the main bridge, which application
+ * needs to connect again. The setting is kept for the lifetime of the
+ * call and is applied to the audio streams which are (re)created later,
+ * e.g. after a re-INVITE.
+ *
+ * @param call_id       Call identification.
+ * @param room_id       The room, or PJSUA_INVALID_ID to move the call
+ *                      back to the main conference bridge.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjsua_call_set_conf_room(pjsua_call_id call_id,
+                                              pjsua_conf_room_id room_id);
+
+
+/**
+ * Get the conference room of the call.
+ *
+ * @param call_id       Call identification.
+ *
+ * @return              The room, or PJSUA_INVALID_ID if the call is in
+ *                      the main conference bridge.
+ */
+PJ_DECL(pjsua_conf_room_id) pjsua_call_get_conf_room(pjsua_call_id call_id);
+
+
 /**
  * Get the video window associated with the call. Note that this function
  * will only evaluate the first video stream in the call, to query any other
@@ -8060,6 +8119,13 @@ PJ_DECL(pj_status_t) pjsua_im_typing(pjsua_acc_id acc_id,
 #   define PJSUA_MAX_AVI_RECORDERS          4
 #endif
 
+/**
+ * The maximum number of conference rooms.
+ */
+#ifndef PJSUA_MAX_CONF_ROOMS
+#   define PJSUA_MAX_CONF_ROOMS         16
+#endif
+
 /**
  * Enable/disable "c=" line in SDP session level. Set to zero to disable it.
  */
@@ -8166,6 +8232,16 @@ struct pjsua_media_config
      */
     unsigned            conf_threads;
 
+    /**
+     * Number of worker threads driving the conference rooms (see
+     * #pjsua_conf_room_create()). All rooms share one clock and these
+     * threads, so independent rooms are mixed concurrently. The threads
+     * are only created when the first room is created.
+     *
+     * Default value: PJMEDIA_TICK_POOL_WORKERS
+     */
+    unsigned            conf_room_threads;
+
     /**
      * Specify whether the media manager should manage its own
      * ioqueue for the RTP/RTCP sockets. If yes, ioqueue will be created
@@ -8701,6 +8777,40 @@ typedef struct pjsua_conf_connect_param
 PJ_DECL(void) pjsua_conf_connect_param_default(pjsua_conf_connect_param *prm);
 
 
+/**
+ * This structure specifies the settings of a conference room. Use
+ * pjsua_conf_room_config_default() to initialize this structure with
+ * default values.
+ */
+typedef struct pjsua_conf_room_config
+{
+    /**
+     * Maximum number of calls in the room.
+     *
+     * Default: 32
+     */
+    unsigned            max_members;
+
+    /**
+     * Options for the conference bridge of the room, bitmask combinations
+     * of #pjmedia_conf_option. PJMEDIA_CONF_NO_DEVICE is always added.
+     *
+     * Default: PJMEDIA_CONF_MIX_MINUS, plus the resampling options derived
+     * from pjsua_media_config::quality.
+     */
+    unsigned            options;
+
+} pjsua_conf_room_config;
+
+
+/**
+ * Initialize pjsua_conf_room_config with default values.
+ *
+ * @param cfg           The settings.
+ */
+PJ_DECL(void) pjsua_conf_room_config_default(pjsua_conf_room_config *cfg);
+
+
 /**
  * Get maxinum number of conference ports.
  *
@@ -8913,6 +9023,41 @@ PJ_DECL(pj_status_t) pjsua_conf_get_signal_level(pjsua_conf_port_id slot,
                                                  unsigned *rx_level);
 
 
+/*****************************************************************************
+ * Conference rooms.
+ */
+
+/**
+ * Create a conference room. A room is a separate conference bridge which
+ * only mixes the calls moved into it with #pjsua_call_set_conf_room(),
+ * every call hearing all other calls of the room. All rooms are driven by
+ * a shared clock and pool of worker threads (see
+ * pjsua_media_config::conf_room_threads) instead of the sound device, so
+ * many rooms can be mixed concurrently, independently of the main
+ * conference bridge.
+ *
+ * Conference rooms are not supported with the audio switchboard.
+ *
+ * @param cfg           The room settings, or NULL for the default.
+ * @param p_id          Pointer to receive the room ID.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjsua_conf_room_create(const pjsua_conf_room_config *cfg,
+                                            pjsua_conf_room_id *p_id);
+
+
+/**
+ * Destroy a conference room. The calls in the room are moved back to the
+ * main conference bridge.
+ *
+ * @param id            The room ID.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjsua_conf_room_destroy(pjsua_conf_room_id id);
+
+
 /*****************************************************************************
  * File player and playlist.
  */
@@ -55,6 +55,9 @@ struct pjsua_call_media
             pjmedia_port   *media_port;/**< The media port.                 */
             pj_bool_t       destroy_port;/**< Destroy the media port?       */
             int             conf_slot; /**< Slot # in conference bridge.    */
+            pjsua_conf_room_id room_id;/**< Conference room, if any.        */
+            pjmedia_port   *room_member;/**< Port of the stream in the room.*/
+            int             room_slot; /**< Slot # in the room bridge.      */
         } a;
 
         /** Video stream */
@@ -213,6 +216,7 @@ struct pjsua_call
     pj_bool_t            med_update_success;
                                     /**< Is media update successful?        */
     pj_bool_t            hanging_up;/**< Is call in the process of hangup?  */
+    pjsua_conf_room_id   conf_room; /**< Conference room of the audio.      */
 
     int                  audio_idx; /**< First active audio media.          */
     pj_mutex_t          *med_ch_mutex;/**< Media channel callback's mutex.  */
@@ -495,6 +499,20 @@ typedef struct pjsua_file_data
     unsigned         slot;
 } pjsua_file_data;
 
+
+/**
+ * Conference room data.
+ */
+typedef struct pjsua_conf_room
+{
+    pj_pool_t       *pool;
+    pjmedia_conf    *conf;
+    pj_mutex_t      *mutex;         /* Protects the member list */
+    unsigned         member_cnt;
+    unsigned        *member;        /* Slots of the members     */
+    unsigned         max_members;
+} pjsua_conf_room;
+
 /**
  * AVI player data.
  */
@@ -678,6 +696,8 @@ struct pjsua_data
     pjmedia_endpt       *med_endpt; /**< Media endpoint.                */
     pjsua_conf_setting   mconf_cfg; /**< Additionan conf. bridge. param */
     pjmedia_conf        *mconf;     /**< Conference bridge.             */
+    pjmedia_conf_op_cb   mconf_op_cb;/**< Application's op callback of
+                                         the conference bridge.         */
     pj_bool_t            is_mswitch;/**< Are we using audio switchboard
                                          (a.k.a APS-Direct)             */
 
@@ -717,6 +737,14 @@ struct pjsua_data
     unsigned             rec_cnt;   /**< Number of file recorders.      */
     pjsua_file_data      recorder[PJSUA_MAX_RECORDERS];/**< Array of recs.*/
 
+    /* Conference rooms: */
+    pjmedia_tick_pool   *room_ticks;/**< Clock and workers of the rooms.*/
+    pj_lock_t           *room_lock; /**< Protects room_held.            */
+    pjmedia_port       **room_held; /**< Room members waiting for the
+                                         conference bridge to release
+                                         their stream, by bridge slot.  */
+    pjsua_conf_room      room[PJSUA_MAX_CONF_ROOMS];/**< Array of rooms.*/
+
 #if PJSUA_HAS_VIDEO
     /* AVI file players: */
     pjmedia_vid_dev_factory *avi_factory;      /**< AVI player factory.       */
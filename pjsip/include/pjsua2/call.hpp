@@ -1577,6 +1577,24 @@ public:
      * @return              True if yes.
      */
     bool hasMedia() const;
+
+    /**
+     * Move the audio of this call to a conference room created with
+     * Endpoint::confRoomCreate(), or back to the main conference bridge.
+     * While in a room, the call has no audio media in the main bridge.
+     *
+     * @param room_id       The room ID, or PJSUA_INVALID_ID for the main
+     *                      conference bridge.
+     */
+    void setConfRoom(int room_id) PJSUA2_THROW(Error);
+
+    /**
+     * Get the conference room of this call.
+     *
+     * @return              The room ID, or PJSUA_INVALID_ID if the call is
+     *                      in the main conference bridge.
+     */
+    int getConfRoom() const;
     
     /**
      * Warning: deprecated, use getAudioMedia() instead. This function is not
@@ -873,6 +873,25 @@ struct UaConfig : public PersistentObject
      */
     unsigned            threadCnt;
 
+    /**
+     * Split the SIP timer heap into one sub-heap per worker thread, so
+     * that timers sharing a group lock are always run by the same worker
+     * thread. Only takes effect when threadCnt is greater than one.
+     * See pjsua_config.timer_heap_per_thread for more info.
+     *
+     * Default: false
+     */
+    bool                timerHeapPerThread;
+
+    /**
+     * Number of SIP worker threads to which the threads polling the
+     * network hand off incoming messages, assigned by Call-ID.
+     * See pjsua_config.rx_worker_cnt for more info.
+     *
+     * Default: 0
+     */
+    unsigned            rxWorkerCnt;
+
     /**
      * When this flag is non-zero, all callbacks that come from thread
      * other than main thread will be posted to the main thread and
@@ -1221,6 +1240,14 @@ public:
      */
     unsigned            confThreads;
 
+    /**
+     * Number of worker threads driving the conference rooms, see
+     * Endpoint::confRoomCreate().
+     *
+     * Default value: PJMEDIA_TICK_POOL_WORKERS
+     */
+    unsigned            confRoomThreads;
+
     /**
      * Specify whether the media manager should manage its own
      * ioqueue for the RTP/RTCP sockets. If yes, ioqueue will be created
@@ -1434,6 +1461,34 @@ struct EpConfig : public PersistentObject
 
 };
 
+/**
+ * Conference room settings, see Endpoint::confRoomCreate().
+ */
+struct ConfRoomConfig
+{
+    /**
+     * Maximum number of calls in the room.
+     *
+     * Default: 32
+     */
+    unsigned            maxMembers;
+
+    /**
+     * Options for the conference bridge of the room, bitmask combinations
+     * of #pjmedia_conf_option.
+     *
+     * Default: PJMEDIA_CONF_MIX_MINUS
+     */
+    unsigned            options;
+
+public:
+    /** Default constructor initialises with default values */
+    ConfRoomConfig();
+
+    /** Export to pjsua_conf_room_config */
+    pjsua_conf_room_config toPj() const;
+};
+
 /* This represents posted job */
 struct PendingJob
 {
@@ -1898,6 +1953,25 @@ public:
      */
     unsigned mediaActivePorts() const;
 
+    /**
+     * Create a conference room, a separate conference bridge mixing the
+     * calls moved into it with Call::setConfRoom(). All rooms are driven
+     * by a shared clock and pool of worker threads.
+     *
+     * @param cfg       The room settings.
+     *
+     * @return          The room ID.
+     */
+    int confRoomCreate(const ConfRoomConfig &cfg) PJSUA2_THROW(Error);
+
+    /**
+     * Destroy a conference room. The calls in the room are moved back to
+     * the main conference bridge.
+     *
+     * @param room_id   The room ID.
+     */
+    void confRoomDestroy(int room_id) PJSUA2_THROW(Error);
+
 #if !DEPRECATED_FOR_TICKET_2232
     /**
      * Warning: deprecated, use mediaEnumPorts2() instead. This function is
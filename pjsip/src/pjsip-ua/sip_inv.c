@@ -2139,6 +2139,8 @@ static void remove_val_from_array_hdr(pjsip_generic_array_hdr *arr_hdr,
             pj_array_erase(arr_hdr->values, sizeof(arr_hdr->values[0]),
                            arr_hdr->count, i);
             --arr_hdr->count;
+            /* The header may be a shallow clone of a capability header */
+            pjsip_hdr_invalidate_cache(arr_hdr);
             break;
         }
     }
@@ -5997,7 +5999,8 @@ static void inv_on_state_confirmed( pjsip_inv_session *inv, pjsip_event *e)
                                                         NULL);
                     if (accept) {
                         pjsip_msg_add_hdr(tdata->msg, (pjsip_hdr*)
-                                          pjsip_hdr_clone(tdata->pool, accept));
+                                          pjsip_hdr_shallow_clone(tdata->pool,
+                                                                  accept));
                     }
 
                     status = pjsip_dlg_send_response(dlg, tsx, tdata);
@@ -671,7 +671,7 @@ PJ_DEF(pj_status_t) pjsip_regc_register(pjsip_regc *regc, pj_bool_t autoreg,
     h_allow = pjsip_endpt_get_capability(regc->endpt, PJSIP_H_ALLOW, NULL);
     if (h_allow) {
         pjsip_msg_add_hdr(msg, (pjsip_hdr*)
-                               pjsip_hdr_clone(tdata->pool, h_allow));
+                               pjsip_hdr_shallow_clone(tdata->pool, h_allow));
 
     }
 
@@ -994,13 +994,13 @@ static pj_uint32_t calculate_response_expiration(const pjsip_regc *regc,
 
     /* Enumerate all Contact headers in the response */
     *contact_cnt = 0;
-    for (hdr=msg->hdr.next; hdr!=&msg->hdr; hdr=hdr->next) {
-        if (hdr->type == PJSIP_H_CONTACT && 
-            *contact_cnt < max_contact) 
-        {
-            contacts[*contact_cnt] = (pjsip_contact_hdr*)hdr;
-            ++(*contact_cnt);
-        }
+    hdr = (const pjsip_hdr*) pjsip_msg_find_hdr(msg, PJSIP_H_CONTACT, NULL);
+    for (; hdr && *contact_cnt < max_contact;
+         hdr = (const pjsip_hdr*) pjsip_msg_find_hdr(msg, PJSIP_H_CONTACT,
+                                                     hdr->next))
+    {
+        contacts[*contact_cnt] = (pjsip_contact_hdr*)hdr;
+        ++(*contact_cnt);
     }
 
     if (regc->current_op == REGC_REGISTERING) {
@@ -1531,7 +1531,7 @@ static void dlg_beautify_response(pjsip_dialog *dlg,
             c_hdr = pjsip_endpt_get_capability(dlg->endpt,
                                                PJSIP_H_ALLOW, NULL);
             if (c_hdr) {
-                hdr = (pjsip_hdr*) pjsip_hdr_clone(tdata->pool, c_hdr);
+                hdr = (pjsip_hdr*) pjsip_hdr_shallow_clone(tdata->pool, c_hdr);
                 pjsip_msg_add_hdr(tdata->msg, hdr);
             }
         }
@@ -1543,7 +1543,7 @@ static void dlg_beautify_response(pjsip_dialog *dlg,
             c_hdr = pjsip_endpt_get_capability(dlg->endpt,
                                                PJSIP_H_SUPPORTED, NULL);
             if (c_hdr) {
-                hdr = (pjsip_hdr*) pjsip_hdr_clone(tdata->pool, c_hdr);
+                hdr = (pjsip_hdr*) pjsip_hdr_shallow_clone(tdata->pool, c_hdr);
                 pjsip_msg_add_hdr(tdata->msg, hdr);
             }
         }
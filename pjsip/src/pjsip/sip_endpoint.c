@@ -33,6 +33,7 @@
 #include <pj/assert.h>
 #include <pj/errno.h>
 #include <pj/lock.h>
+#include <pj/limits.h>
 #include <pj/math.h>
 
 #define PJSIP_EX_NO_MEMORY  pj_NO_MEMORY_EXCEPTION()
@@ -49,6 +50,77 @@ typedef struct exit_cb
 } exit_cb;
 
 
+/* Hand-off of incoming messages to the SIP worker threads (see
+ * pjsip_endpt_start_rx_workers()). Each worker has an intrusive
+ * multi-producer single-consumer queue: transport threads append with an
+ * atomic exchange of the head, and the worker takes from the tail without
+ * any lock. Without atomic builtins, the queue operations are serialized
+ * with the endpoint mutex instead.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#   define RX_HAS_ATOMIC        1
+#   define RX_LOCK(endpt)
+#   define RX_UNLOCK(endpt)
+#   define RX_XCHG(p, v)        __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST)
+#   define RX_LOAD(p)           __atomic_load_n(p, __ATOMIC_SEQ_CST)
+#   define RX_STORE(p, v)       __atomic_store_n(p, v, __ATOMIC_SEQ_CST)
+#   define RX_ADD(p, v)         __atomic_add_fetch(p, v, __ATOMIC_SEQ_CST)
+#else
+#   define RX_HAS_ATOMIC        0
+#   define RX_LOCK(endpt)       pj_mutex_lock((endpt)->mutex)
+#   define RX_UNLOCK(endpt)     pj_mutex_unlock((endpt)->mutex)
+#   define RX_XCHG(p, v)        rx_xchg(p, v)
+#   define RX_LOAD(p)           (*(p))
+#   define RX_STORE(p, v)       (*(p) = (v))
+#   define RX_ADD(p, v)         (*(p) += (v))
+#endif
+
+/* Queue node, allocated from the pool of the cloned rdata. */
+typedef struct rx_node
+{
+    struct rx_node      *next;
+    pjsip_rx_data       *rdata;
+} rx_node;
+
+#if !RX_HAS_ATOMIC
+static rx_node *rx_xchg(rx_node **p, rx_node *v)
+{
+    rx_node *old = *p;
+    *p = v;
+    return old;
+}
+#endif
+
+/* A SIP worker thread. */
+typedef struct rx_worker
+{
+    pjsip_endpoint      *endpt;
+    pj_thread_t         *thread;
+    pj_sem_t            *sem;
+
+    /* Producer end, written by the transport threads. */
+    rx_node             *head;
+    int                  pending;
+
+    /* Keep the consumer end on another cache line. */
+    char                 pad[64];
+
+    /* Consumer end, only used by the worker. */
+    rx_node             *tail;
+    rx_node              stub;
+    rx_node              quit;
+} rx_worker;
+
+/* The set of SIP worker threads. */
+typedef struct rx_workers
+{
+    pj_pool_t           *pool;
+    unsigned             max_pending;
+    unsigned             cnt;
+    rx_worker           *worker;
+} rx_workers;
+
+
 /**
  * The SIP endpoint.
  */
@@ -104,6 +176,12 @@ struct pjsip_endpoint
 
     /** List of exit callback. */
     exit_cb              exit_cb_list;
+
+    /** SIP worker threads for incoming messages, NULL if not started. */
+    rx_workers          *rx_workers;
+
+    /** Number of transport threads currently handing off a message. */
+    int                  rx_busy;
 };
 
 
@@ -430,6 +508,11 @@ PJ_DEF(pj_status_t) pjsip_endpt_add_capability( pjsip_endpoint *endpt,
         ++hdr->count;
     }
 
+#if PJSIP_CACHE_CAPABILITY_HDR
+    /* Print the header once for the outgoing messages */
+    pjsip_hdr_cache_print(endpt->pool, hdr);
+#endif
+
     /* Done. */
     return PJ_SUCCESS;
 }
@@ -603,6 +686,9 @@ PJ_DEF(void) pjsip_endpt_destroy(pjsip_endpoint *endpt)
 
     PJ_LOG(5, (THIS_FILE, "Destroying endpoint instance.."));
 
+    /* Finish the messages handed off to the SIP worker threads. */
+    pjsip_endpt_stop_rx_workers(endpt);
+
     /* Phase 1: stop all modules */
     mod = endpt->module_list.prev;
     while (mod != &endpt->module_list) {
@@ -988,6 +1074,339 @@ on_return:
     return status;
 }
 
+/*
+ * Distribute incoming message to modules, on behalf of endpt_on_rx_msg().
+ */
+static void endpt_distribute_rx( pjsip_endpoint *endpt,
+                                 pjsip_rx_data *rdata )
+{
+    pjsip_process_rdata_param proc_prm;
+    pj_bool_t handled = PJ_FALSE;
+
+    pjsip_process_rdata_param_default(&proc_prm);
+    proc_prm.silent = PJ_TRUE;
+
+    pjsip_endpt_process_rx_data(endpt, rdata, &proc_prm, &handled);
+
+    /* No module is able to handle the message */
+    if (!handled) {
+        PJ_LOG(4,(THIS_FILE, "%s from %s:%d was dropped/unhandled by"
+                             " any modules",
+                             pjsip_rx_data_get_info(rdata),
+                             rdata->pkt_info.src_name,
+                             rdata->pkt_info.src_port));
+    }
+
+    /* Must clear mod_data before returning rdata to transport, since
+     * rdata may be reused.
+     */
+    pj_bzero(&rdata->endpt_info, sizeof(rdata->endpt_info));
+}
+
+/* Append node to the worker queue. May be called by any thread. */
+static void rx_push(rx_worker *w, rx_node *node)
+{
+    rx_node *prev;
+
+    node->next = NULL;
+    prev = RX_XCHG(&w->head, node);
+    RX_STORE(&prev->next, node);
+}
+
+/* Take the oldest node from the worker queue. Must only be called by the
+ * worker (or after the worker has quit). Returns NULL if the queue is
+ * empty, or if the oldest node is still being appended by another thread.
+ */
+static rx_node *rx_pop(rx_worker *w)
+{
+    rx_node *tail = w->tail;
+    rx_node *next = RX_LOAD(&tail->next);
+
+    if (tail == &w->stub) {
+        if (next == NULL)
+            return NULL;
+        w->tail = next;
+        tail = next;
+        next = RX_LOAD(&tail->next);
+    }
+
+    if (next) {
+        w->tail = next;
+        return tail;
+    }
+
+    if (tail != RX_LOAD(&w->head))
+        return NULL;
+
+    /* Tail is the last node, put the stub back behind it so that the
+     * tail can be taken.
+     */
+    rx_push(w, &w->stub);
+
+    next = RX_LOAD(&tail->next);
+    if (next) {
+        w->tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+/* Wait for the next node of the worker queue. */
+static rx_node *rx_wait(rx_worker *w)
+{
+    rx_node *node;
+
+    pj_sem_wait(w->sem);
+
+    /* The semaphore is posted once per completed append, so a node is
+     * there, but an append by another thread may be in progress in front
+     * of it.
+     */
+    for (;;) {
+        RX_LOCK(w->endpt);
+        node = rx_pop(w);
+        RX_UNLOCK(w->endpt);
+
+        if (node)
+            return node;
+        pj_thread_sleep(0);
+    }
+}
+
+/* SIP worker thread. */
+static int PJ_THREAD_FUNC rx_worker_thread(void *arg)
+{
+    rx_worker *w = (rx_worker*)arg;
+
+    for (;;) {
+        rx_node *node = rx_wait(w);
+        pjsip_rx_data *rdata;
+
+        if (node == &w->quit)
+            break;
+
+        RX_LOCK(w->endpt);
+        RX_ADD(&w->pending, -1);
+        RX_UNLOCK(w->endpt);
+
+        rdata = node->rdata;
+        endpt_distribute_rx(w->endpt, rdata);
+        pjsip_rx_data_free_cloned(rdata);
+    }
+
+    return 0;
+}
+
+/* Hand off incoming message to the SIP worker selected by its Call-ID.
+ * Returns PJ_TRUE if the message has been consumed (queued or dropped),
+ * or PJ_FALSE if it must be processed by the calling thread.
+ */
+static pj_bool_t rx_workers_hand_off( pjsip_endpoint *endpt,
+                                      pjsip_rx_data *rdata )
+{
+    rx_workers *ws;
+    pj_bool_t consumed = PJ_FALSE;
+
+    if (RX_LOAD(&endpt->rx_workers) == NULL)
+        return PJ_FALSE;
+
+    RX_LOCK(endpt);
+    RX_ADD(&endpt->rx_busy, 1);
+
+    ws = RX_LOAD(&endpt->rx_workers);
+    if (ws) {
+        const pjsip_cid_hdr *cid = rdata->msg_info.cid;
+        rx_worker *w;
+        pjsip_rx_data *clone;
+        rx_node *node;
+        int pending;
+        pj_status_t status;
+
+        w = &ws->worker[cid ? pj_hash_calc(0, cid->id.ptr,
+                                           (unsigned)cid->id.slen) % ws->cnt
+                            : 0];
+
+        pending = RX_ADD(&w->pending, 1);
+        if (ws->max_pending && pending > (int)ws->max_pending) {
+            RX_ADD(&w->pending, -1);
+            PJ_LOG(4,(THIS_FILE, "Dropping %s from %s:%d, SIP worker is "
+                                 "overloaded",
+                                 pjsip_rx_data_get_info(rdata),
+                                 rdata->pkt_info.src_name,
+                                 rdata->pkt_info.src_port));
+            consumed = PJ_TRUE;
+            goto on_return;
+        }
+
+        status = pjsip_rx_data_clone(rdata, 0, &clone);
+        if (status != PJ_SUCCESS) {
+            RX_ADD(&w->pending, -1);
+            PJ_PERROR(4,(THIS_FILE, status, "Error cloning %s, processing "
+                         "it in place", pjsip_rx_data_get_info(rdata)));
+            goto on_return;
+        }
+
+        node = PJ_POOL_ZALLOC_T(clone->tp_info.pool, rx_node);
+        node->rdata = clone;
+        rx_push(w, node);
+        pj_sem_post(w->sem);
+        consumed = PJ_TRUE;
+    }
+
+on_return:
+    RX_ADD(&endpt->rx_busy, -1);
+    RX_UNLOCK(endpt);
+    return consumed;
+}
+
+/* Stop the worker threads and free the messages they have not taken. */
+static void rx_workers_destroy(rx_workers *ws)
+{
+    unsigned i;
+
+    for (i=0; i<ws->cnt; ++i) {
+        rx_worker *w = &ws->worker[i];
+
+        if (w->thread) {
+            RX_LOCK(w->endpt);
+            rx_push(w, &w->quit);
+            RX_UNLOCK(w->endpt);
+            pj_sem_post(w->sem);
+        }
+    }
+
+    for (i=0; i<ws->cnt; ++i) {
+        rx_worker *w = &ws->worker[i];
+        rx_node *node;
+
+        if (w->thread) {
+            pj_thread_join(w->thread);
+            pj_thread_destroy(w->thread);
+            w->thread = NULL;
+        }
+
+        while ((node = rx_pop(w)) != NULL) {
+            if (node != &w->quit)
+                pjsip_rx_data_free_cloned(node->rdata);
+        }
+
+        if (w->sem) {
+            pj_sem_destroy(w->sem);
+            w->sem = NULL;
+        }
+    }
+
+    pj_pool_release(ws->pool);
+}
+
+/* Init with default */
+PJ_DEF(void) pjsip_rx_worker_param_default(pjsip_rx_worker_param *p)
+{
+    pj_bzero(p, sizeof(*p));
+    p->worker_cnt = PJSIP_RX_WORKER_CNT ? PJSIP_RX_WORKER_CNT : 1;
+    p->max_pending = PJSIP_RX_WORKER_MAX_PENDING;
+}
+
+/*
+ * Start SIP worker threads.
+ */
+PJ_DEF(pj_status_t) pjsip_endpt_start_rx_workers(
+                                        pjsip_endpoint *endpt,
+                                        const pjsip_rx_worker_param *param)
+{
+    pjsip_rx_worker_param def_prm;
+    pj_pool_t *pool;
+    rx_workers *ws;
+    unsigned i;
+    pj_status_t status;
+
+    PJ_ASSERT_RETURN(endpt, PJ_EINVAL);
+
+    if (param == NULL) {
+        pjsip_rx_worker_param_default(&def_prm);
+        param = &def_prm;
+    }
+    PJ_ASSERT_RETURN(param->worker_cnt > 0, PJ_EINVAL);
+
+    if (endpt->rx_workers)
+        return PJ_EEXISTS;
+
+    pool = pj_pool_create(endpt->pf, "rxw%p", 512, 512, NULL);
+    if (!pool)
+        return PJ_ENOMEM;
+
+    ws = PJ_POOL_ZALLOC_T(pool, rx_workers);
+    ws->pool = pool;
+    ws->max_pending = param->max_pending;
+    ws->cnt = param->worker_cnt;
+    ws->worker = (rx_worker*)
+                 pj_pool_calloc(pool, ws->cnt, sizeof(rx_worker));
+
+    for (i=0; i<ws->cnt; ++i) {
+        rx_worker *w = &ws->worker[i];
+
+        w->endpt = endpt;
+        w->head = w->tail = &w->stub;
+
+        status = pj_sem_create(pool, "rxw%p", 0, PJ_MAXINT32, &w->sem);
+        if (status != PJ_SUCCESS)
+            goto on_error;
+
+        status = pj_thread_create(pool, "rxw%p", &rx_worker_thread, w,
+                                  0, 0, &w->thread);
+        if (status != PJ_SUCCESS)
+            goto on_error;
+    }
+
+    RX_LOCK(endpt);
+    RX_STORE(&endpt->rx_workers, ws);
+    RX_UNLOCK(endpt);
+
+    PJ_LOG(4, (THIS_FILE, "Started %d SIP worker thread(s)", ws->cnt));
+    return PJ_SUCCESS;
+
+on_error:
+    PJ_PERROR(1, (THIS_FILE, status, "Error starting SIP worker threads"));
+    rx_workers_destroy(ws);
+    return status;
+}
+
+/*
+ * Stop SIP worker threads.
+ */
+PJ_DEF(pj_status_t) pjsip_endpt_stop_rx_workers(pjsip_endpoint *endpt)
+{
+    rx_workers *ws;
+    unsigned i;
+
+    PJ_ASSERT_RETURN(endpt, PJ_EINVAL);
+
+    ws = endpt->rx_workers;
+    if (!ws)
+        return PJ_SUCCESS;
+
+    /* Must not be called by a worker, as it waits for the workers */
+    for (i=0; i<ws->cnt; ++i) {
+        PJ_ASSERT_RETURN(ws->worker[i].thread != pj_thread_this(),
+                         PJ_EINVALIDOP);
+    }
+
+    /* New messages are processed in place from now on. Wait until the
+     * threads already handing off a message are done with the workers.
+     */
+    RX_LOCK(endpt);
+    RX_STORE(&endpt->rx_workers, NULL);
+    RX_UNLOCK(endpt);
+
+    while (RX_LOAD(&endpt->rx_busy) != 0)
+        pj_thread_sleep(0);
+
+    rx_workers_destroy(ws);
+
+    PJ_LOG(4, (THIS_FILE, "SIP worker threads stopped"));
+    return PJ_SUCCESS;
+}
+
 /*
  * This is the callback that is called by the transport manager when it 
  * receives a message from the network.
@@ -997,8 +1416,6 @@ static void endpt_on_rx_msg( pjsip_endpoint *endpt,
                              pjsip_rx_data *rdata )
 {
     pjsip_msg *msg = rdata->msg_info.msg;
-    pjsip_process_rdata_param proc_prm;
-    pj_bool_t handled = PJ_FALSE;
 
     PJ_UNUSED_ARG(msg);
 
@@ -1107,24 +1524,9 @@ static void endpt_on_rx_msg( pjsip_endpoint *endpt,
     }
 #endif
 
-    pjsip_process_rdata_param_default(&proc_prm);
-    proc_prm.silent = PJ_TRUE;
-
-    pjsip_endpt_process_rx_data(endpt, rdata, &proc_prm, &handled);
-
-    /* No module is able to handle the message */
-    if (!handled) {
-        PJ_LOG(4,(THIS_FILE, "%s from %s:%d was dropped/unhandled by"
-                             " any modules",
-                             pjsip_rx_data_get_info(rdata),
-                             rdata->pkt_info.src_name,
-                             rdata->pkt_info.src_port));
-    }
-
-    /* Must clear mod_data before returning rdata to transport, since
-     * rdata may be reused.
-     */
-    pj_bzero(&rdata->endpt_info, sizeof(rdata->endpt_info));
+    /* Let the SIP worker threads process the message, if started */
+    if (!rx_workers_hand_off(endpt, rdata))
+        endpt_distribute_rx(endpt, rdata);
 
     pj_log_pop_indent();
 }
@@ -369,6 +369,11 @@ PJ_DEF(pjsip_msg*) pjsip_msg_clone( pj_pool_t *pool, const pjsip_msg *src)
     return dst;
 }
 
+/*
+ * Note that the header list is declared const, but unparsed headers found
+ * by the search functions below are parsed and replaced in the list (see
+ * pjsip_lazy_hdr_parse()), hence the const casts.
+ */
 PJ_DEF(void*)  pjsip_hdr_find( const void *hdr_list,
                                pjsip_hdr_e hdr_type, const void *start)
 {
@@ -380,6 +385,13 @@ PJ_DEF(void*)  pjsip_hdr_find( const void *hdr_list,
     for (; hdr!=end; hdr = hdr->next) {
         if (hdr->type == hdr_type)
             return (void*)hdr;
+        if (pjsip_hdr_is_lazy(hdr) &&
+            ((const pjsip_lazy_hdr*)hdr)->htype == hdr_type)
+        {
+            pjsip_hdr *parsed = pjsip_lazy_hdr_parse((pjsip_lazy_hdr*)hdr);
+            if (parsed)
+                return parsed;
+        }
     }
     return NULL;
 }
@@ -394,8 +406,15 @@ PJ_DEF(void*)  pjsip_hdr_find_by_name( const void *hdr_list,
         hdr = end->next;
     }
     for (; hdr!=end; hdr = hdr->next) {
-        if (pj_stricmp(&hdr->name, name) == 0)
+        if (pj_stricmp(&hdr->name, name) == 0) {
+            if (pjsip_hdr_is_lazy(hdr)) {
+                pjsip_hdr *parsed = pjsip_lazy_hdr_parse((pjsip_lazy_hdr*)hdr);
+                if (parsed)
+                    return parsed;
+                continue;
+            }
             return (void*)hdr;
+        }
     }
     return NULL;
 }
@@ -411,10 +430,17 @@ PJ_DEF(void*)  pjsip_hdr_find_by_names( const void *hdr_list,
         hdr = end->next;
     }
     for (; hdr!=end; hdr = hdr->next) {
-        if (pj_stricmp(&hdr->name, name) == 0)
-            return (void*)hdr;
-        if (pj_stricmp(&hdr->name, sname) == 0)
+        if (pj_stricmp(&hdr->name, name) == 0 ||
+            pj_stricmp(&hdr->name, sname) == 0)
+        {
+            if (pjsip_hdr_is_lazy(hdr)) {
+                pjsip_hdr *parsed = pjsip_lazy_hdr_parse((pjsip_lazy_hdr*)hdr);
+                if (parsed)
+                    return parsed;
+                continue;
+            }
             return (void*)hdr;
+        }
     }
     return NULL;
 }
@@ -645,9 +671,70 @@ PJ_DEF(int) pjsip_hdr_print_on( void *hdr_ptr, char *buf, pj_size_t len)
 {
     pjsip_hdr *hdr = (pjsip_hdr*) hdr_ptr;
     PJ_ASSERT_RETURN(hdr->vptr, -2);
+
+    if (hdr->print_cache) {
+        char *p = buf, *endbuf = buf+len;
+        const pj_str_t *hname = pjsip_cfg()->endpt.use_compact_form? 
+                                &hdr->sname : &hdr->name;
+
+        copy_advance(p, (*hname));
+        copy_advance_char_check(p, ':');
+        copy_advance_char_check(p, ' ');
+        copy_advance(p, (*hdr->print_cache));
+        return (int)(p - buf);
+    }
+
     return (*hdr->vptr->print_on)(hdr_ptr, buf, len);
 }
 
+PJ_DEF(pj_status_t) pjsip_hdr_cache_print( pj_pool_t *pool, void *hdr_ptr )
+{
+    pjsip_hdr *hdr = (pjsip_hdr*) hdr_ptr;
+    const pj_str_t *hname;
+    pj_str_t *cache;
+    pj_size_t size;
+    char *buf;
+    int len, pos;
+
+    PJ_ASSERT_RETURN(pool && hdr && hdr->vptr, PJ_EINVAL);
+
+    /* Print the header from its fields, growing the buffer as needed */
+    hdr->print_cache = NULL;
+    for (size=256; ; size*=2) {
+        buf = (char*) pj_pool_alloc(pool, size);
+        len = (*hdr->vptr->print_on)(hdr, buf, size);
+        if (len >= 0)
+            break;
+        if (size >= PJSIP_MAX_PKT_LEN)
+            return PJSIP_EMSGTOOLONG;
+    }
+
+    /* Only keep the value, the name depends on the compact form setting
+     * at the time the header is printed.
+     */
+    hname = pjsip_cfg()->endpt.use_compact_form? &hdr->sname : &hdr->name;
+    pos = (int)hname->slen;
+    if (len < pos + 2 || pj_memcmp(buf, hname->ptr, pos) != 0 ||
+        buf[pos] != ':' || buf[pos+1] != ' ')
+    {
+        /* Not printed as "name: value", leave it uncached */
+        return PJ_ENOTSUP;
+    }
+
+    cache = PJ_POOL_ALLOC_T(pool, pj_str_t);
+    cache->ptr = buf + pos + 2;
+    cache->slen = len - pos - 2;
+
+    hdr->print_cache = cache;
+    return PJ_SUCCESS;
+}
+
+PJ_DEF(void) pjsip_hdr_invalidate_cache( void *hdr_ptr )
+{
+    pjsip_hdr *hdr = (pjsip_hdr*) hdr_ptr;
+    hdr->print_cache = NULL;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /*
  * Status/Reason Phrase
@@ -852,6 +939,84 @@ static pjsip_generic_string_hdr* pjsip_generic_string_hdr_shallow_clone( pj_pool
     return hdr;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/*
+ * Unparsed header.
+ */
+
+static pjsip_lazy_hdr* pjsip_lazy_hdr_clone( pj_pool_t *pool,
+                                             const pjsip_lazy_hdr *hdr);
+static pjsip_lazy_hdr* pjsip_lazy_hdr_shallow_clone( pj_pool_t *pool,
+                                                     const pjsip_lazy_hdr *hdr);
+
+static pjsip_hdr_vptr lazy_hdr_vptr = 
+{
+    (pjsip_hdr_clone_fptr) &pjsip_lazy_hdr_clone,
+    (pjsip_hdr_clone_fptr) &pjsip_lazy_hdr_shallow_clone,
+    (pjsip_hdr_print_fptr) &pjsip_generic_string_hdr_print,
+};
+
+PJ_DEF(pjsip_lazy_hdr*) pjsip_lazy_hdr_create(pj_pool_t *pool,
+                                              pjsip_hdr_e htype)
+{
+    pjsip_lazy_hdr *hdr = PJ_POOL_ZALLOC_T(pool, pjsip_lazy_hdr);
+
+    /* Use the standard names, so it can be searched by name */
+    init_hdr(hdr, htype, &lazy_hdr_vptr);
+    hdr->type = PJSIP_H_OTHER;
+    hdr->htype = htype;
+    hdr->pool = pool;
+    return hdr;
+}
+
+PJ_DEF(pj_bool_t) pjsip_hdr_is_lazy(const void *hdr)
+{
+    return ((const pjsip_hdr*)hdr)->vptr == &lazy_hdr_vptr;
+}
+
+PJ_DEF(pjsip_hdr*) pjsip_lazy_hdr_parse(pjsip_lazy_hdr *lhdr)
+{
+    pjsip_hdr *hdr;
+
+    PJ_ASSERT_RETURN(lhdr && pjsip_hdr_is_lazy(lhdr), NULL);
+
+    hdr = (pjsip_hdr*) pjsip_parse_hdr(lhdr->pool, &lhdr->name,
+                                       lhdr->hvalue.ptr, lhdr->hvalue.slen,
+                                       NULL);
+    if (!hdr) {
+        /* Keep it as a generic string header (it has the same layout),
+         * so that it is not parsed again on every search.
+         */
+        lhdr->vptr = &generic_hdr_vptr;
+        return NULL;
+    }
+
+    /* Replace the unparsed header with the parsed header(s) */
+    pj_list_insert_nodes_before(lhdr, hdr);
+    pj_list_erase(lhdr);
+
+    return hdr;
+}
+
+static pjsip_lazy_hdr* pjsip_lazy_hdr_clone( pj_pool_t *pool,
+                                             const pjsip_lazy_hdr *rhs)
+{
+    pjsip_lazy_hdr *hdr = pjsip_lazy_hdr_create(pool, rhs->htype);
+
+    /* The parser needs a terminated value */
+    pj_strdup_with_null(pool, &hdr->hvalue, &rhs->hvalue);
+    return hdr;
+}
+
+static pjsip_lazy_hdr* pjsip_lazy_hdr_shallow_clone( pj_pool_t *pool,
+                                                     const pjsip_lazy_hdr *rhs)
+{
+    pjsip_lazy_hdr *hdr = PJ_POOL_ALLOC_T(pool, pjsip_lazy_hdr);
+    pj_memcpy(hdr, rhs, sizeof(*hdr));
+    hdr->pool = pool;
+    return hdr;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /*
  * Generic pjsip_hdr_names/integer value header.
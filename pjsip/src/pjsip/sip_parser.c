@@ -71,6 +71,8 @@ typedef struct handler_rec
     pj_size_t             hname_len;
     pj_uint32_t           hname_hash;
     pjsip_parse_hdr_func *handler;
+    int                   lazy_type;    /* Header type if the header may be
+                                           parsed lazily, or -1.        */
 } handler_rec;
 
 static handler_rec handler[PJSIP_MAX_HEADER_TYPES];
@@ -185,6 +187,8 @@ static pjsip_hdr*   parse_hdr_to( pjsip_parse_ctx *ctx );
 static pjsip_hdr*   parse_hdr_unsupported( pjsip_parse_ctx *ctx );
 static pjsip_hdr*   parse_hdr_via( pjsip_parse_ctx *ctx );
 static pjsip_hdr*   parse_hdr_generic_string( pjsip_parse_ctx *ctx);
+static pjsip_hdr*   parse_hdr_lazy( pjsip_parse_ctx *ctx, pjsip_hdr_e htype);
+static void         init_lazy_hdr_types(void);
 
 /* Convert non NULL terminated string to integer. */
 static unsigned long pj_strtoul_mindigit(const pj_str_t *str, 
@@ -541,6 +545,9 @@ static pj_status_t init_parser()
      */
 
     status = pjsip_auth_init_parser();
+    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
+
+    init_lazy_hdr_types();
 
     return status;
 }
@@ -618,6 +625,7 @@ static pj_status_t int_register_parser( const char *name,
 
     /* Initialize temporary handler. */
     rec.handler = fptr;
+    rec.lazy_type = -1;
     rec.hname_len = strlen(name);
     if (rec.hname_len >= sizeof(rec.hname)) {
         pj_assert(!"Header name is too long!");
@@ -705,8 +713,8 @@ PJ_DEF(pj_status_t) pjsip_register_hdr_parser( const char *hname,
 
 
 /* Find handler to parse the header name. */
-static pjsip_parse_hdr_func * find_handler_imp(pj_uint32_t  hash, 
-                                               const pj_str_t *hname)
+static handler_rec * find_handler_imp(pj_uint32_t  hash,
+                                      const pj_str_t *hname)
 {
     handler_rec *first;
     int          comp;
@@ -732,17 +740,17 @@ static pjsip_parse_hdr_func * find_handler_imp(pj_uint32_t  hash,
         }
     }
 
-    return comp==0 ? first->handler : NULL;
+    return comp==0 ? first : NULL;
 }
 
 
-/* Find handler to parse the header name. */
-static pjsip_parse_hdr_func* find_handler(const pj_str_t *hname)
+/* Find handler record to parse the header name. */
+static handler_rec* find_handler_rec(const pj_str_t *hname)
 {
     pj_uint32_t hash;
     char hname_copy[PJSIP_MAX_HNAME_LEN];
     pj_str_t tmp;
-    pjsip_parse_hdr_func *func;
+    handler_rec *rec;
 
     if (hname->slen >= PJSIP_MAX_HNAME_LEN) {
         /* Guaranteed not to be able to find handler. */
@@ -751,9 +759,9 @@ static pjsip_parse_hdr_func* find_handler(const pj_str_t *hname)
 
     /* First, common case, try to find handler with exact name */
     hash = pj_hash_calc(0, hname->ptr, (unsigned)hname->slen);
-    func = find_handler_imp(hash, hname);
-    if (func)
-        return func;
+    rec = find_handler_imp(hash, hname);
+    if (rec)
+        return rec;
 
 
     /* If not found, try converting the header name to lowercase and
@@ -766,6 +774,50 @@ static pjsip_parse_hdr_func* find_handler(const pj_str_t *hname)
 }
 
 
+/* Find handler to parse the header name. */
+static pjsip_parse_hdr_func* find_handler(const pj_str_t *hname)
+{
+    handler_rec *rec = find_handler_rec(hname);
+    return rec ? rec->handler : NULL;
+}
+
+
+/* Mark the handlers of the headers which may be parsed lazily, i.e.
+ * built-in headers which are not needed by the core stack to process the
+ * message. Headers which the parser stores in pjsip_rx_data are always
+ * parsed.
+ */
+static void init_lazy_hdr_types(void)
+{
+    static const struct {
+        const char  *hname;
+        pjsip_hdr_e  htype;
+    } lazy_hdrs[] = {
+        { "Accept",              PJSIP_H_ACCEPT },
+        { "Allow",               PJSIP_H_ALLOW },
+        { "Authorization",       PJSIP_H_AUTHORIZATION },
+        { "Contact",             PJSIP_H_CONTACT },
+        { "Expires",             PJSIP_H_EXPIRES },
+        { "Min-Expires",         PJSIP_H_MIN_EXPIRES },
+        { "Proxy-Authorization", PJSIP_H_PROXY_AUTHORIZATION },
+        { "Retry-After",         PJSIP_H_RETRY_AFTER },
+        { "Unsupported",         PJSIP_H_UNSUPPORTED },
+    };
+    unsigned i, j;
+
+    for (i=0; i<PJ_ARRAY_SIZE(lazy_hdrs); ++i) {
+        pj_str_t hname = pj_str((char*)lazy_hdrs[i].hname);
+        pjsip_parse_hdr_func *func = find_handler(&hname);
+
+        /* Mark all names (normal, lower-case, and short) of the header */
+        for (j=0; func && j<handler_count; ++j) {
+            if (handler[j].handler == func)
+                handler[j].lazy_type = lazy_hdrs[i].htype;
+        }
+    }
+}
+
+
 /* Find URI handler. */
 static pjsip_parse_uri_func* find_uri_handler(const pj_str_t *scheme)
 {
@@ -1034,6 +1086,7 @@ static pjsip_msg *int_parse_msg( pjsip_parse_ctx *ctx,
     pj_str_t hname;
     pj_scanner *scanner = ctx->scanner;
     pj_pool_t *pool = ctx->pool;
+    pj_bool_t lazy = pjsip_cfg()->endpt.lazy_hdr_parse;
     PJ_USE_EXCEPTION;
 
     parsing_headers = PJ_FALSE;
@@ -1070,7 +1123,7 @@ retry_parse:
 parse_headers:
         /* Parse headers. */
         do {
-            pjsip_parse_hdr_func * func;
+            handler_rec *rec;
             pjsip_hdr *hdr = NULL;
 
             /* Init hname just in case parsing fails.
@@ -1097,14 +1150,18 @@ parse_headers:
             }
             
             /* Find handler. */
-            func = find_handler(&hname);
+            rec = find_handler_rec(&hname);
             
             /* Call the handler if found.
              * If no handler is found, then treat the header as generic
-             * hname/hvalue pair.
+             * hname/hvalue pair. Headers which may be parsed lazily are
+             * only parsed when they are first searched.
              */
-            if (func) {
-                hdr = (*func)(ctx);
+            if (rec && lazy && rec->lazy_type >= 0) {
+                hdr = parse_hdr_lazy(ctx, (pjsip_hdr_e)rec->lazy_type);
+
+            } else if (rec) {
+                hdr = (*rec->handler)(ctx);
 
                 /* Note:
                  *  hdr MAY BE NULL, if parsing does not yield a new header
@@ -2446,6 +2503,17 @@ static pjsip_hdr* parse_hdr_generic_string( pjsip_parse_ctx *ctx )
 
 }
 
+/* Keep the header value unparsed, to be parsed on first access. */
+static pjsip_hdr* parse_hdr_lazy(pjsip_parse_ctx *ctx, pjsip_hdr_e htype)
+{
+    pjsip_lazy_hdr *hdr;
+
+    /* The unparsed header has the layout of generic string header */
+    hdr = pjsip_lazy_hdr_create(ctx->pool, htype);
+    parse_generic_string_hdr((pjsip_generic_string_hdr*)hdr, ctx);
+    return (pjsip_hdr*)hdr;
+}
+
 /* Public function to parse a header value. */
 PJ_DEF(void*) pjsip_parse_hdr( pj_pool_t *pool, const pj_str_t *hname,
                                char *buf, pj_size_t size, int *parsed_len )
@@ -66,15 +66,25 @@ static pj_status_t mod_tsx_layer_unload(void);
 static pj_bool_t   mod_tsx_layer_on_rx_request(pjsip_rx_data *rdata);
 static pj_bool_t   mod_tsx_layer_on_rx_response(pjsip_rx_data *rdata);
 
+/* One shard of the transaction table. A transaction is put in the
+ * shard selected by the hash of its key (htable), and for UAS, in the
+ * shard selected by the hash of its secondary key (htable2).
+ */
+struct tsx_shard
+{
+    pj_mutex_t          *mutex;
+    pj_hash_table_t     *htable;
+    pj_hash_table_t     *htable2;
+};
+
 /* Transaction layer module definition. */
 static struct mod_tsx_layer
 {
     struct pjsip_module  mod;
     pj_pool_t           *pool;
     pjsip_endpoint      *endpt;
-    pj_mutex_t          *mutex;
-    pj_hash_table_t     *htable;
-    pj_hash_table_t     *htable2;
+    unsigned             shard_cnt;
+    struct tsx_shard    *shard;
 } mod_tsx_layer = 
 {   {
         NULL, NULL,                     /* List's prev and next.    */
@@ -501,6 +511,7 @@ PJ_DEF(void) pjsip_tsx_set_max_retransmit_count(int max)
 PJ_DEF(pj_status_t) pjsip_tsx_layer_init_module(pjsip_endpoint *endpt)
 {
     pj_pool_t *pool;
+    unsigned i, shard_size;
     pj_status_t status;
 
 
@@ -529,30 +540,36 @@ PJ_DEF(pj_status_t) pjsip_tsx_layer_init_module(pjsip_endpoint *endpt)
     mod_tsx_layer.endpt = endpt;
 
 
-    /* Create hash table. */
-    mod_tsx_layer.htable = pj_hash_create( pool, pjsip_cfg()->tsx.max_count );
-    mod_tsx_layer.htable2 = pj_hash_create(pool, pjsip_cfg()->tsx.max_count);
-    if (!mod_tsx_layer.htable || !mod_tsx_layer.htable2) {
-        pjsip_endpt_release_pool(endpt, pool);
-        return PJ_ENOMEM;
-    }
+    /* Create the table shards, each with its own hash tables and mutex. */
+    mod_tsx_layer.shard_cnt = PJSIP_TSX_TABLE_SHARD_CNT;
+    if (mod_tsx_layer.shard_cnt == 0)
+        mod_tsx_layer.shard_cnt = 1;
+    mod_tsx_layer.shard = (struct tsx_shard*)
+                          pj_pool_calloc(pool, mod_tsx_layer.shard_cnt,
+                                         sizeof(struct tsx_shard));
 
-    /* Create group lock. */
-    status = pj_mutex_create_recursive(pool, "tsxlayer", &mod_tsx_layer.mutex);
-    if (status != PJ_SUCCESS) {
-        pjsip_endpt_release_pool(endpt, pool);
-        return status;
+    shard_size = pjsip_cfg()->tsx.max_count / mod_tsx_layer.shard_cnt;
+    for (i=0; i<mod_tsx_layer.shard_cnt; ++i) {
+        struct tsx_shard *shard = &mod_tsx_layer.shard[i];
+
+        shard->htable = pj_hash_create(pool, shard_size);
+        shard->htable2 = pj_hash_create(pool, shard_size);
+        if (!shard->htable || !shard->htable2) {
+            status = PJ_ENOMEM;
+            goto on_error;
+        }
+
+        status = pj_mutex_create_simple(pool, "tsxlayer", &shard->mutex);
+        if (status != PJ_SUCCESS)
+            goto on_error;
     }
 
     /*
      * Register transaction layer module to endpoint.
      */
     status = pjsip_endpt_register_module( endpt, &mod_tsx_layer.mod );
-    if (status != PJ_SUCCESS) {
-        pj_mutex_destroy(mod_tsx_layer.mutex);
-        pjsip_endpt_release_pool(endpt, pool);
-        return status;
-    }
+    if (status != PJ_SUCCESS)
+        goto on_error;
 
     /* Register mod_stateful_util module (sip_util_statefull.c) */
     status = pjsip_endpt_register_module(endpt, &mod_stateful_util);
@@ -561,6 +578,18 @@ PJ_DEF(pj_status_t) pjsip_tsx_layer_init_module(pjsip_endpoint *endpt)
     }
 
     return PJ_SUCCESS;
+
+on_error:
+    for (i=0; i<mod_tsx_layer.shard_cnt; ++i) {
+        if (mod_tsx_layer.shard[i].mutex)
+            pj_mutex_destroy(mod_tsx_layer.shard[i].mutex);
+    }
+    mod_tsx_layer.shard = NULL;
+    mod_tsx_layer.shard_cnt = 0;
+    mod_tsx_layer.pool = NULL;
+    mod_tsx_layer.endpt = NULL;
+    pjsip_endpt_release_pool(endpt, pool);
+    return status;
 }
 
 
@@ -589,26 +618,78 @@ PJ_DEF(pj_status_t) pjsip_tsx_layer_destroy(void)
 }
 
 
+/*
+ * Get the table shard for the specified (lowercase) key hash value.
+ * The high bits are used since the low bits select the bucket inside
+ * the shard's hash table.
+ */
+static struct tsx_shard *get_shard(pj_uint32_t hval)
+{
+    return &mod_tsx_layer.shard[(hval >> 16) % mod_tsx_layer.shard_cnt];
+}
+
+/*
+ * Lock the shards of the primary and secondary key of a transaction.
+ * The secondary shard may be NULL or the same as the primary. When the
+ * shards differ they are locked in address order, so that two threads
+ * never wait for each other's shard.
+ */
+static void lock_shards(struct tsx_shard *shard, struct tsx_shard *shard2)
+{
+    if (shard2 == NULL || shard2 == shard) {
+        pj_mutex_lock(shard->mutex);
+    } else if (shard < shard2) {
+        pj_mutex_lock(shard->mutex);
+        pj_mutex_lock(shard2->mutex);
+    } else {
+        pj_mutex_lock(shard2->mutex);
+        pj_mutex_lock(shard->mutex);
+    }
+}
+
+static void unlock_shards(struct tsx_shard *shard, struct tsx_shard *shard2)
+{
+    if (shard2 != NULL && shard2 != shard)
+        pj_mutex_unlock(shard2->mutex);
+    pj_mutex_unlock(shard->mutex);
+}
+
 /*
  * Register the transaction to the hash table.
  */
 static pj_status_t mod_tsx_layer_register_tsx( pjsip_transaction *tsx)
 {
+    struct tsx_shard *shard, *shard2 = NULL;
+    pj_uint32_t hval, hval2 = 0;
+
     pj_assert(tsx->transaction_key.slen != 0);
 
-    /* Lock hash table mutex. */
-    pj_mutex_lock(mod_tsx_layer.mutex);
+#ifdef PRECALC_HASH
+    hval = tsx->hashed_key;
+    if (tsx->role == PJSIP_ROLE_UAS)
+        hval2 = tsx->hashed_key2;
+#else
+    hval = pj_hash_calc_tolower(0, NULL, &tsx->transaction_key);
+    if (tsx->role == PJSIP_ROLE_UAS)
+        hval2 = pj_hash_calc_tolower(0, NULL, &tsx->transaction_key2);
+#endif
+
+    /* Lock hash table mutexes. */
+    shard = get_shard(hval);
+    if (tsx->role == PJSIP_ROLE_UAS)
+        shard2 = get_shard(hval2);
+    lock_shards(shard, shard2);
 
     /* Check if no transaction with the same key exists. 
      * Do not use PJ_ASSERT_RETURN since it evaluates the expression
      * twice!
      */
-    if(pj_hash_get_lower(mod_tsx_layer.htable, 
+    if(pj_hash_get_lower(shard->htable, 
                          tsx->transaction_key.ptr,
                          (unsigned)tsx->transaction_key.slen, 
                          NULL))
     {
-        pj_mutex_unlock(mod_tsx_layer.mutex);
+        unlock_shards(shard, shard2);
         PJ_LOG(2,(THIS_FILE, 
                   "Unable to register %.*s transaction (key exists)",
                   (int)tsx->method.name.slen,
@@ -623,32 +704,22 @@ static pj_status_t mod_tsx_layer_register_tsx( pjsip_transaction *tsx)
 
     /* Register the transaction to the hash tables. We register the tsx
      * to the secondary hash table only if it's UAS, for the purpose of
-     * detecting merged requests.
+     * detecting merged requests. The secondary key may live in another
+     * shard, which is locked together with the primary one above.
      */
-#ifdef PRECALC_HASH
-    pj_hash_set_lower( tsx->pool, mod_tsx_layer.htable,
+    pj_hash_set_lower( tsx->pool, shard->htable,
                        tsx->transaction_key.ptr,
                        (unsigned)tsx->transaction_key.slen, 
-                       tsx->hashed_key, tsx);
-    if (tsx->role == PJSIP_ROLE_UAS) {
-        pj_hash_set_lower( tsx->pool, mod_tsx_layer.htable2,
+                       hval, tsx);
+    if (shard2) {
+        pj_hash_set_lower( tsx->pool, shard2->htable2,
                            tsx->transaction_key2.ptr,
                            (unsigned)tsx->transaction_key2.slen,
-                           tsx->hashed_key2, tsx);
+                           hval2, tsx);
     }
-#else
-    pj_hash_set_lower( tsx->pool, mod_tsx_layer.htable,
-                       tsx->transaction_key.ptr,
-                       tsx->transaction_key.slen, 0, tsx);
-    if (tsx->role == PJSIP_ROLE_UAS) {
-        pj_hash_set_lower( tsx->pool, mod_tsx_layer.htable2,
-                           tsx->transaction_key2.ptr,
-                           tsx->transaction_key2.slen, 0, tsx);
-    }
-#endif
 
-    /* Unlock mutex. */
-    pj_mutex_unlock(mod_tsx_layer.mutex);
+    /* Unlock mutexes. */
+    unlock_shards(shard, shard2);
 
     return PJ_SUCCESS;
 }
@@ -659,6 +730,9 @@ static pj_status_t mod_tsx_layer_register_tsx( pjsip_transaction *tsx)
  */
 static void mod_tsx_layer_unregister_tsx( pjsip_transaction *tsx)
 {
+    struct tsx_shard *shard, *shard2 = NULL;
+    pj_uint32_t hval, hval2 = 0;
+
     if (mod_tsx_layer.mod.id == -1) {
         /* The transaction layer has been unregistered. This could happen
          * if the transaction was pending on transport and the application
@@ -671,37 +745,39 @@ static void mod_tsx_layer_unregister_tsx( pjsip_transaction *tsx)
     pj_assert(tsx->transaction_key.slen != 0);
     //pj_assert(tsx->state != PJSIP_TSX_STATE_NULL);
 
-    /* Lock hash table mutex. */
-    pj_mutex_lock(mod_tsx_layer.mutex);
-
-    /* Unregister the transaction from the hash tables. */
 #ifdef PRECALC_HASH
-    pj_hash_set_lower( NULL, mod_tsx_layer.htable, tsx->transaction_key.ptr,
-                       (unsigned)tsx->transaction_key.slen, tsx->hashed_key,
-                       NULL);
-    if (tsx->role == PJSIP_ROLE_UAS) {
-        pj_hash_set_lower(NULL, mod_tsx_layer.htable2,
-                          tsx->transaction_key2.ptr,
-                          (unsigned)tsx->transaction_key2.slen,
-                          tsx->hashed_key2, NULL);
-    }
+    hval = tsx->hashed_key;
+    if (tsx->role == PJSIP_ROLE_UAS)
+        hval2 = tsx->hashed_key2;
 #else
-    pj_hash_set_lower( NULL, mod_tsx_layer.htable, tsx->transaction_key.ptr,
-                       tsx->transaction_key.slen, 0, NULL);
-    if (tsx->role == PJSIP_ROLE_UAS) {
-        pj_hash_set_lower(NULL, mod_tsx_layer.htable2,
-                          tsx->transaction_key2.ptr,
-                          tsx->transaction_key2.slen, 0, NULL);
-    }
+    hval = pj_hash_calc_tolower(0, NULL, &tsx->transaction_key);
+    if (tsx->role == PJSIP_ROLE_UAS)
+        hval2 = pj_hash_calc_tolower(0, NULL, &tsx->transaction_key2);
 #endif
 
+    /* Lock hash table mutexes. */
+    shard = get_shard(hval);
+    if (tsx->role == PJSIP_ROLE_UAS)
+        shard2 = get_shard(hval2);
+    lock_shards(shard, shard2);
+
+    /* Unregister the transaction from the hash tables. */
+    pj_hash_set_lower( NULL, shard->htable, tsx->transaction_key.ptr,
+                       (unsigned)tsx->transaction_key.slen, hval, NULL);
+    if (shard2) {
+        pj_hash_set_lower( NULL, shard2->htable2,
+                           tsx->transaction_key2.ptr,
+                           (unsigned)tsx->transaction_key2.slen,
+                           hval2, NULL);
+    }
+
+    /* Unlock mutexes. */
+    unlock_shards(shard, shard2);
+
     TSX_TRACE_((THIS_FILE, 
                 "Transaction %p unregistered, hkey=0x%p and key=%.*s",
                 tsx, tsx->hashed_key, tsx->transaction_key.slen,
                 tsx->transaction_key.ptr));
-
-    /* Unlock mutex. */
-    pj_mutex_unlock(mod_tsx_layer.mutex);
 }
 
 
@@ -711,14 +787,18 @@ static void mod_tsx_layer_unregister_tsx( pjsip_transaction *tsx)
  */
 PJ_DEF(unsigned) pjsip_tsx_layer_get_tsx_count(void)
 {
-    unsigned count;
+    unsigned i, count = 0;
 
     /* Are we registered? */
     PJ_ASSERT_RETURN(mod_tsx_layer.endpt!=NULL, 0);
 
-    pj_mutex_lock(mod_tsx_layer.mutex);
-    count = pj_hash_count(mod_tsx_layer.htable);
-    pj_mutex_unlock(mod_tsx_layer.mutex);
+    for (i=0; i<mod_tsx_layer.shard_cnt; ++i) {
+        struct tsx_shard *shard = &mod_tsx_layer.shard[i];
+
+        pj_mutex_lock(shard->mutex);
+        count += pj_hash_count(shard->htable);
+        pj_mutex_unlock(shard->mutex);
+    }
 
     return count;
 }
@@ -731,11 +811,15 @@ static pjsip_transaction* find_tsx( const pj_str_t *key, pj_bool_t lock,
                                     pj_bool_t add_ref )
 {
     pjsip_transaction *tsx;
-    pj_uint32_t hval = 0;
+    struct tsx_shard *shard;
+    pj_uint32_t hval;
 
-    pj_mutex_lock(mod_tsx_layer.mutex);
+    hval = pj_hash_calc_tolower(0, NULL, key);
+    shard = get_shard(hval);
+
+    pj_mutex_lock(shard->mutex);
     tsx = (pjsip_transaction*)
-          pj_hash_get_lower( mod_tsx_layer.htable, key->ptr, 
+          pj_hash_get_lower( shard->htable, key->ptr, 
                              (unsigned)key->slen, &hval );
     
     /* Prevent the transaction to get deleted before we have chance to lock it.
@@ -743,7 +827,7 @@ static pjsip_transaction* find_tsx( const pj_str_t *key, pj_bool_t lock,
     if (tsx)
         pj_grp_lock_add_ref(tsx->grp_lock);
     
-    pj_mutex_unlock(mod_tsx_layer.mutex);
+    pj_mutex_unlock(shard->mutex);
 
     TSX_TRACE_((THIS_FILE, 
                 "Finding tsx with hkey=0x%p and key=%.*s: found %p",
@@ -803,28 +887,39 @@ static pj_status_t mod_tsx_layer_start(void)
 static pj_status_t mod_tsx_layer_stop(void)
 {
     pj_hash_iterator_t it_buf, *it;
+    unsigned i;
 
     PJ_LOG(4,(THIS_FILE, "Stopping transaction layer module"));
 
     /* Destroy all transactions. */
-    do {
-        pjsip_transaction *tsx = NULL;
+    for (i=0; i<mod_tsx_layer.shard_cnt; ++i) {
+        struct tsx_shard *shard = &mod_tsx_layer.shard[i];
 
-        pj_mutex_lock(mod_tsx_layer.mutex);
+        do {
+            pjsip_transaction *tsx = NULL;
 
-        it = pj_hash_first(mod_tsx_layer.htable, &it_buf);
-        if (it) {
-            tsx = (pjsip_transaction *)pj_hash_this(mod_tsx_layer.htable, it);
-            if (tsx) mod_tsx_layer_unregister_tsx(tsx);
-        }
+            pj_mutex_lock(shard->mutex);
+
+            it = pj_hash_first(shard->htable, &it_buf);
+            if (it) {
+                tsx = (pjsip_transaction *)pj_hash_this(shard->htable, it);
+                if (tsx)
+                    pj_grp_lock_add_ref(tsx->grp_lock);
+            }
 
-        pj_mutex_unlock(mod_tsx_layer.mutex);
+            pj_mutex_unlock(shard->mutex);
 
-        if (tsx) {
-            pjsip_tsx_terminate(tsx, PJSIP_SC_SERVICE_UNAVAILABLE);
-            tsx_shutdown(tsx);
-        }
-    } while (it);
+            /* Unregistration locks the shards, so it is done after
+             * releasing the shard's mutex.
+             */
+            if (tsx) {
+                mod_tsx_layer_unregister_tsx(tsx);
+                pjsip_tsx_terminate(tsx, PJSIP_SC_SERVICE_UNAVAILABLE);
+                tsx_shutdown(tsx);
+                pj_grp_lock_dec_ref(tsx->grp_lock);
+            }
+        } while (it);
+    }
 
     PJ_LOG(4,(THIS_FILE, "Stopped transaction layer module"));
 
@@ -835,10 +930,15 @@ static pj_status_t mod_tsx_layer_stop(void)
 /* Destroy this module */
 static void tsx_layer_destroy(pjsip_endpoint *endpt)
 {
+    unsigned i;
+
     PJ_UNUSED_ARG(endpt);
 
     /* Destroy mutex. */
-    pj_mutex_destroy(mod_tsx_layer.mutex);
+    for (i=0; i<mod_tsx_layer.shard_cnt; ++i)
+        pj_mutex_destroy(mod_tsx_layer.shard[i].mutex);
+    mod_tsx_layer.shard = NULL;
+    mod_tsx_layer.shard_cnt = 0;
 
     /* Release pool. */
     pjsip_endpt_release_pool(mod_tsx_layer.endpt, mod_tsx_layer.pool);
@@ -861,7 +961,7 @@ static pj_status_t mod_tsx_layer_unload(void)
      * crash when the pending transaction finally got error response
      * from transport and when it tries to unregister itself.
      */
-    if (pj_hash_count(mod_tsx_layer.htable) != 0) {
+    if (pjsip_tsx_layer_get_tsx_count() != 0) {
         pj_status_t status;
         status = pjsip_endpt_atexit(mod_tsx_layer.endpt, &tsx_layer_destroy);
         if (status != PJ_SUCCESS) {
@@ -883,6 +983,7 @@ pjsip_tsx_detect_merged_requests(pjsip_rx_data *rdata)
 {
     pj_str_t key, key2;
     pj_uint32_t hval = 0;
+    struct tsx_shard *shard;
     pjsip_transaction *tsx = NULL;
     pj_status_t status;
 
@@ -899,18 +1000,22 @@ pjsip_tsx_detect_merged_requests(pjsip_rx_data *rdata)
     if (status != PJ_SUCCESS)
         return NULL;
 
-    pj_mutex_lock( mod_tsx_layer.mutex );
+    hval = pj_hash_calc_tolower(0, NULL, &key);
+    shard = get_shard(hval);
+    pj_mutex_lock( shard->mutex );
 
     /* This request must not match any transaction in our primary hash
      * table.
      */
-    if (pj_hash_get_lower(mod_tsx_layer.htable, key.ptr, (unsigned)key.slen,
+    if (pj_hash_get_lower(shard->htable, key.ptr, (unsigned)key.slen,
                           &hval) != NULL)
     {
-        pj_mutex_unlock( mod_tsx_layer.mutex);
+        pj_mutex_unlock( shard->mutex);
         return NULL;
     }
 
+    pj_mutex_unlock( shard->mutex);
+
     /* Now check it against our secondary hash table, based on a key that
      * consists of From tag, CSeq, and Call-ID.
      */
@@ -918,15 +1023,16 @@ pjsip_tsx_detect_merged_requests(pjsip_rx_data *rdata)
                                  &rdata->msg_info.cseq->method, rdata,
                                  PJ_FALSE);
     if (status != PJ_SUCCESS) {
-        pj_mutex_unlock( mod_tsx_layer.mutex);
         return NULL;
     }
 
-    hval = 0;
-    tsx = pj_hash_get_lower(mod_tsx_layer.htable2, key2.ptr,
+    hval = pj_hash_calc_tolower(0, NULL, &key2);
+    shard = get_shard(hval);
+    pj_mutex_lock( shard->mutex );
+    tsx = pj_hash_get_lower(shard->htable2, key2.ptr,
                             (unsigned)key2.slen, &hval);
 
-    pj_mutex_unlock( mod_tsx_layer.mutex);
+    pj_mutex_unlock( shard->mutex);
 
     return tsx;
 }
@@ -937,17 +1043,20 @@ pjsip_tsx_detect_merged_requests(pjsip_rx_data *rdata)
 static pj_bool_t mod_tsx_layer_on_rx_request(pjsip_rx_data *rdata)
 {
     pj_str_t key;
-    pj_uint32_t hval = 0;
+    pj_uint32_t hval;
+    struct tsx_shard *shard;
     pjsip_transaction *tsx;
 
     pjsip_tsx_create_key(rdata->tp_info.pool, &key, PJSIP_ROLE_UAS,
                          &rdata->msg_info.cseq->method, rdata);
 
     /* Find transaction. */
-    pj_mutex_lock( mod_tsx_layer.mutex );
+    hval = pj_hash_calc_tolower(0, NULL, &key);
+    shard = get_shard(hval);
+    pj_mutex_lock( shard->mutex );
 
     tsx = (pjsip_transaction*) 
-          pj_hash_get_lower( mod_tsx_layer.htable, key.ptr, (unsigned)key.slen, 
+          pj_hash_get_lower( shard->htable, key.ptr, (unsigned)key.slen, 
                              &hval );
 
 
@@ -961,7 +1070,7 @@ static pj_bool_t mod_tsx_layer_on_rx_request(pjsip_rx_data *rdata)
          * Reject the request so that endpoint passes the request to
          * upper layer modules.
          */
-        pj_mutex_unlock( mod_tsx_layer.mutex);
+        pj_mutex_unlock( shard->mutex);
         return PJ_FALSE;
     }
 
@@ -973,7 +1082,7 @@ static pj_bool_t mod_tsx_layer_on_rx_request(pjsip_rx_data *rdata)
         tsx->method.id == PJSIP_INVITE_METHOD &&
         tsx->status_code/100 == 2)
     {
-        pj_mutex_unlock( mod_tsx_layer.mutex);
+        pj_mutex_unlock( shard->mutex);
         return PJ_FALSE;
     }
 
@@ -982,7 +1091,7 @@ static pj_bool_t mod_tsx_layer_on_rx_request(pjsip_rx_data *rdata)
         rdata->msg_info.cseq->cseq != tsx->cseq)
     {
         pjsip_endpoint* endpt = mod_tsx_layer.endpt;
-        pj_mutex_unlock( mod_tsx_layer.mutex);
+        pj_mutex_unlock( shard->mutex);
         if (endpt) {
             pj_str_t hdr_name = pj_str("Warning");
             pj_str_t warn_text = pj_str("Retransmission with different CSeq");
@@ -1004,7 +1113,7 @@ static pj_bool_t mod_tsx_layer_on_rx_request(pjsip_rx_data *rdata)
     pj_grp_lock_add_ref(tsx->grp_lock);
     
     /* Unlock hash table. */
-    pj_mutex_unlock( mod_tsx_layer.mutex );
+    pj_mutex_unlock( shard->mutex );
 
     /* Simulate race condition! */
     PJ_RACE_ME(5);
@@ -1024,17 +1133,20 @@ static pj_bool_t mod_tsx_layer_on_rx_request(pjsip_rx_data *rdata)
 static pj_bool_t mod_tsx_layer_on_rx_response(pjsip_rx_data *rdata)
 {
     pj_str_t key;
-    pj_uint32_t hval = 0;
+    pj_uint32_t hval;
+    struct tsx_shard *shard;
     pjsip_transaction *tsx;
 
     pjsip_tsx_create_key(rdata->tp_info.pool, &key, PJSIP_ROLE_UAC,
                          &rdata->msg_info.cseq->method, rdata);
 
     /* Find transaction. */
-    pj_mutex_lock( mod_tsx_layer.mutex );
+    hval = pj_hash_calc_tolower(0, NULL, &key);
+    shard = get_shard(hval);
+    pj_mutex_lock( shard->mutex );
 
     tsx = (pjsip_transaction*) 
-          pj_hash_get_lower( mod_tsx_layer.htable, key.ptr, (unsigned)key.slen, 
+          pj_hash_get_lower( shard->htable, key.ptr, (unsigned)key.slen, 
                              &hval );
 
 
@@ -1048,7 +1160,7 @@ static pj_bool_t mod_tsx_layer_on_rx_response(pjsip_rx_data *rdata)
          * Reject the request so that endpoint passes the request to
          * upper layer modules.
          */
-        pj_mutex_unlock( mod_tsx_layer.mutex);
+        pj_mutex_unlock( shard->mutex);
         return PJ_FALSE;
     }
 
@@ -1058,7 +1170,7 @@ static pj_bool_t mod_tsx_layer_on_rx_response(pjsip_rx_data *rdata)
     pj_grp_lock_add_ref(tsx->grp_lock);
 
     /* Unlock hash table. */
-    pj_mutex_unlock( mod_tsx_layer.mutex );
+    pj_mutex_unlock( shard->mutex );
 
     /* Simulate race condition! */
     PJ_RACE_ME(5);
@@ -1089,38 +1201,42 @@ PJ_DEF(void) pjsip_tsx_layer_dump(pj_bool_t detail)
 {
 #if PJ_LOG_MAX_LEVEL >= 3
     pj_hash_iterator_t itbuf, *it;
+    unsigned i, count;
 
-    /* Lock mutex. */
-    pj_mutex_lock(mod_tsx_layer.mutex);
+    count = pjsip_tsx_layer_get_tsx_count();
 
     PJ_LOG(3, (THIS_FILE, "Dumping transaction table:"));
-    PJ_LOG(3, (THIS_FILE, " Total %d transactions", 
-                          pj_hash_count(mod_tsx_layer.htable)));
+    PJ_LOG(3, (THIS_FILE, " Total %d transactions", count));
 
-    if (detail) {
-        it = pj_hash_first(mod_tsx_layer.htable, &itbuf);
-        if (it == NULL) {
-            PJ_LOG(3, (THIS_FILE, " - none - "));
-        } else {
-            while (it != NULL) {
-                pjsip_transaction *tsx = (pjsip_transaction*) 
-                                         pj_hash_this(mod_tsx_layer.htable,it);
-
-                PJ_LOG(3, (THIS_FILE, " %s %s|%d|%s",
-                           tsx->obj_name,
-                           (tsx->last_tx? 
-                                pjsip_tx_data_get_info(tsx->last_tx): 
-                                "none"),
-                           tsx->status_code,
-                           pjsip_tsx_state_str(tsx->state)));
-
-                it = pj_hash_next(mod_tsx_layer.htable, it);
-            }
-        }
+    if (detail && count == 0) {
+        PJ_LOG(3, (THIS_FILE, " - none - "));
     }
 
-    /* Unlock mutex. */
-    pj_mutex_unlock(mod_tsx_layer.mutex);
+    for (i=0; detail && i<mod_tsx_layer.shard_cnt; ++i) {
+        struct tsx_shard *shard = &mod_tsx_layer.shard[i];
+
+        /* Lock mutex. */
+        pj_mutex_lock(shard->mutex);
+
+        it = pj_hash_first(shard->htable, &itbuf);
+        while (it != NULL) {
+            pjsip_transaction *tsx = (pjsip_transaction*) 
+                                     pj_hash_this(shard->htable,it);
+
+            PJ_LOG(3, (THIS_FILE, " %s %s|%d|%s",
+                       tsx->obj_name,
+                       (tsx->last_tx? 
+                            pjsip_tx_data_get_info(tsx->last_tx): 
+                            "none"),
+                       tsx->status_code,
+                       pjsip_tsx_state_str(tsx->state)));
+
+            it = pj_hash_next(shard->htable, it);
+        }
+
+        /* Unlock mutex. */
+        pj_mutex_unlock(shard->mutex);
+    }
 #endif
 }
 
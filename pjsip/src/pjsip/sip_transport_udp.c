@@ -77,6 +77,11 @@ struct udp_transport
     pj_bool_t           is_paused;
     int                 read_loop_spin;
 
+    /* Batched receive rings, batch_cnt rdata for each of rdata_cnt slots */
+    unsigned            batch_cnt;
+    pjsip_rx_data    ***batch_rdata;
+    pj_sock_mmsg      **batch_msg;
+
     /* Group lock to be used by UDP transport and ioqueue key */
     pj_grp_lock_t      *grp_lock;
 };
@@ -111,6 +116,128 @@ static void init_rdata(struct udp_transport *tp, unsigned rdata_index,
 }
 
 
+/*
+ * Initialize an entry of the batched receive ring of the specified read
+ * slot from the specified pool.
+ */
+static void init_batch_rdata(struct udp_transport *tp, unsigned rdata_index,
+                             unsigned batch_index, pj_pool_t *pool)
+{
+    pjsip_rx_data *rdata;
+
+    rdata = PJ_POOL_ZALLOC_T(pool, pjsip_rx_data);
+
+    /* Init tp_info part. These are never submitted to the ioqueue. */
+    rdata->tp_info.pool = pool;
+    rdata->tp_info.transport = &tp->base;
+    rdata->tp_info.tp_data = (void*)(pj_ssize_t)rdata_index;
+    rdata->tp_info.op_key.rdata = rdata;
+
+    tp->batch_rdata[rdata_index][batch_index] = rdata;
+}
+
+
+/*
+ * Report a received datagram to the transport manager.
+ */
+static void udp_report_packet(pjsip_rx_data *rdata, pj_ssize_t bytes_read)
+{
+    enum { MIN_SIZE = 32 };
+
+    /* Report the packet to transport manager. Only do so if packet size
+     * is relatively big enough for a SIP packet.
+     */
+    if (bytes_read > MIN_SIZE) {
+        pj_ssize_t size_eaten;
+        const pj_sockaddr *src_addr = &rdata->pkt_info.src_addr;
+
+        /* Init pkt_info part. */
+        rdata->pkt_info.len = bytes_read;
+        rdata->pkt_info.zero = 0;
+        pj_gettimeofday(&rdata->pkt_info.timestamp);
+        pj_sockaddr_print(src_addr, rdata->pkt_info.src_name,
+                          sizeof(rdata->pkt_info.src_name), 0);
+        rdata->pkt_info.src_port = pj_sockaddr_get_port(src_addr);
+
+        size_eaten = 
+            pjsip_tpmgr_receive_packet(rdata->tp_info.transport->tpmgr, 
+                                       rdata);
+
+        if (size_eaten < 0) {
+            pj_assert(!"It shouldn't happen!");
+            size_eaten = rdata->pkt_info.len;
+        }
+
+        /* Since this is UDP, the whole buffer is the message. */
+        rdata->pkt_info.len = 0;
+
+    } else if (bytes_read >= 0 && bytes_read <= MIN_SIZE) {
+
+        /* TODO: */
+
+    } else if (-bytes_read != PJ_STATUS_FROM_OS(OSERR_EWOULDBLOCK) &&
+               -bytes_read != PJ_STATUS_FROM_OS(OSERR_EINPROGRESS) && 
+               -bytes_read != PJ_STATUS_FROM_OS(OSERR_ECONNRESET)) 
+    {
+
+        /* Report error to endpoint. */
+        PJSIP_ENDPT_LOG_ERROR((rdata->tp_info.transport->endpt,
+                               rdata->tp_info.transport->obj_name,
+                               (pj_status_t)-bytes_read, 
+                               "Warning: pj_ioqueue_recvfrom()"
+                               " callback error"));
+    }
+}
+
+
+/*
+ * Drain datagrams that are already queued in the socket with one batched
+ * receive call into the ring of the specified read slot, and report them
+ * to the transport manager. Returns the number of datagrams received.
+ */
+static unsigned udp_drain_batch(struct udp_transport *tp,
+                                unsigned rdata_index)
+{
+    pjsip_rx_data **ring = tp->batch_rdata[rdata_index];
+    pj_sock_mmsg *msg = tp->batch_msg[rdata_index];
+    unsigned i, cnt;
+    pj_status_t status;
+
+    for (i=0; i<tp->batch_cnt; ++i) {
+        msg[i].buf = ring[i]->pkt_info.packet;
+        msg[i].len = sizeof(ring[i]->pkt_info.packet);
+        msg[i].addr = &ring[i]->pkt_info.src_addr;
+        msg[i].addr_len = sizeof(ring[i]->pkt_info.src_addr);
+    }
+
+    cnt = tp->batch_cnt;
+    status = pj_sock_recvmmsg(tp->sock, msg, &cnt, 0);
+    if (status != PJ_SUCCESS) {
+        if (status != PJ_STATUS_FROM_OS(OSERR_EWOULDBLOCK) &&
+            status != PJ_STATUS_FROM_OS(OSERR_EINPROGRESS) && 
+            status != PJ_STATUS_FROM_OS(OSERR_ECONNRESET)) 
+        {
+            PJSIP_ENDPT_LOG_ERROR((tp->base.endpt, tp->base.obj_name,
+                                   status, "Warning: pj_sock_recvmmsg"));
+        }
+        return 0;
+    }
+
+    for (i=0; i<cnt; ++i) {
+        pjsip_rx_data *rdata = ring[i];
+        pj_pool_t *rdata_pool = rdata->tp_info.pool;
+
+        rdata->pkt_info.src_addr_len = msg[i].addr_len;
+        udp_report_packet(rdata, msg[i].len);
+
+        pj_pool_reset(rdata_pool);
+        init_batch_rdata(tp, rdata_index, i, rdata_pool);
+    }
+
+    return cnt;
+}
+
+
 /*
  * udp_on_read_complete()
  *
@@ -171,52 +298,9 @@ static void udp_on_read_complete( pj_ioqueue_key_t *key,
      * complete asynchronously, to allow other sockets to get their data.
      */
     for (i=0;; ++i) {
-        enum { MIN_SIZE = 32 };
         pj_uint32_t flags;
 
-        /* Report the packet to transport manager. Only do so if packet size
-         * is relatively big enough for a SIP packet.
-         */
-        if (bytes_read > MIN_SIZE) {
-            pj_ssize_t size_eaten;
-            const pj_sockaddr *src_addr = &rdata->pkt_info.src_addr;
-
-            /* Init pkt_info part. */
-            rdata->pkt_info.len = bytes_read;
-            rdata->pkt_info.zero = 0;
-            pj_gettimeofday(&rdata->pkt_info.timestamp);
-            pj_sockaddr_print(src_addr, rdata->pkt_info.src_name,
-                              sizeof(rdata->pkt_info.src_name), 0);
-            rdata->pkt_info.src_port = pj_sockaddr_get_port(src_addr);
-
-            size_eaten = 
-                pjsip_tpmgr_receive_packet(rdata->tp_info.transport->tpmgr, 
-                                           rdata);
-
-            if (size_eaten < 0) {
-                pj_assert(!"It shouldn't happen!");
-                size_eaten = rdata->pkt_info.len;
-            }
-
-            /* Since this is UDP, the whole buffer is the message. */
-            rdata->pkt_info.len = 0;
-
-        } else if (bytes_read >= 0 && bytes_read <= MIN_SIZE) {
-
-            /* TODO: */
-
-        } else if (-bytes_read != PJ_STATUS_FROM_OS(OSERR_EWOULDBLOCK) &&
-                   -bytes_read != PJ_STATUS_FROM_OS(OSERR_EINPROGRESS) && 
-                   -bytes_read != PJ_STATUS_FROM_OS(OSERR_ECONNRESET)) 
-        {
-
-            /* Report error to endpoint. */
-            PJSIP_ENDPT_LOG_ERROR((rdata->tp_info.transport->endpt,
-                                   rdata->tp_info.transport->obj_name,
-                                   (pj_status_t)-bytes_read, 
-                                   "Warning: pj_ioqueue_recvfrom()"
-                                   " callback error"));
-        }
+        udp_report_packet(rdata, bytes_read);
 
         if (i >= MAX_IMMEDIATE_PACKET) {
             /* Force ioqueue_recvfrom() to return PJ_EPENDING */
@@ -254,6 +338,28 @@ static void udp_on_read_complete( pj_ioqueue_key_t *key,
         if (tp->is_paused)
             break;
 
+        /* With batched receive, drain whatever else is already queued in
+         * the socket with as few system calls as possible, before going
+         * back to the ioqueue.
+         */
+        if (tp->batch_cnt > 1 && bytes_read > 0) {
+            unsigned rdata_index, cnt;
+
+            rdata_index = (unsigned)(unsigned long)(pj_ssize_t)
+                          rdata->tp_info.tp_data;
+            do {
+                cnt = udp_drain_batch(tp, rdata_index);
+                i += (int)cnt;
+            } while (cnt == tp->batch_cnt && i < MAX_IMMEDIATE_PACKET &&
+                     !tp->is_paused);
+
+            if (tp->is_paused)
+                break;
+
+            if (i >= MAX_IMMEDIATE_PACKET)
+                flags = PJ_IOQUEUE_ALWAYS_ASYNC;
+        }
+
         /* Read next packet. */
         bytes_read = sizeof(rdata->pkt_info.packet);
         rdata->pkt_info.src_addr_len = sizeof(rdata->pkt_info.src_addr);
@@ -423,6 +529,16 @@ static void udp_on_destroy(void *arg)
         pj_pool_release(tp->rdata[i]->tp_info.pool);
     }
 
+    /* Destroy batched receive rings */
+    for (i=0; tp->batch_rdata && i<tp->rdata_cnt; ++i) {
+        unsigned j;
+
+        for (j=0; tp->batch_rdata[i] && j<tp->batch_cnt; ++j) {
+            if (tp->batch_rdata[i][j])
+                pj_pool_release(tp->batch_rdata[i][j]->tp_info.pool);
+        }
+    }
+
     /* Destroy reference counter. */
     if (tp->base.ref_cnt)
         pj_atomic_destroy(tp->base.ref_cnt);
@@ -773,6 +889,7 @@ static pj_status_t transport_attach( pjsip_endpoint *endpt,
                                      pj_sock_t sock,
                                      const pjsip_host_port *a_name,
                                      unsigned async_cnt,
+                                     unsigned batch_cnt,
                                      pjsip_transport **p_transport)
 {
     pj_pool_t *pool;
@@ -907,6 +1024,41 @@ static pj_status_t transport_attach( pjsip_endpoint *endpt,
         tp->rdata_cnt++;
     }
 
+    /* Create batched receive ring for each rdata. */
+    if (batch_cnt > 1) {
+        tp->batch_cnt = batch_cnt;
+        tp->batch_rdata = (pjsip_rx_data***)
+                          pj_pool_calloc(tp->base.pool, async_cnt,
+                                         sizeof(pjsip_rx_data**));
+        tp->batch_msg = (pj_sock_mmsg**)
+                        pj_pool_calloc(tp->base.pool, async_cnt,
+                                       sizeof(pj_sock_mmsg*));
+        for (i=0; i<async_cnt; ++i) {
+            unsigned j;
+
+            tp->batch_rdata[i] = (pjsip_rx_data**)
+                                 pj_pool_calloc(tp->base.pool, batch_cnt,
+                                                sizeof(pjsip_rx_data*));
+            tp->batch_msg[i] = (pj_sock_mmsg*)
+                               pj_pool_calloc(tp->base.pool, batch_cnt,
+                                              sizeof(pj_sock_mmsg));
+            for (j=0; j<batch_cnt; ++j) {
+                pj_pool_t *rdata_pool;
+
+                rdata_pool = pjsip_endpt_create_pool(endpt, "rtb%p",
+                                                     PJSIP_POOL_RDATA_LEN,
+                                                     PJSIP_POOL_RDATA_INC);
+                if (!rdata_pool) {
+                    pj_atomic_set(tp->base.ref_cnt, 0);
+                    pjsip_transport_destroy(&tp->base);
+                    return PJ_ENOMEM;
+                }
+
+                init_batch_rdata(tp, i, j, rdata_pool);
+            }
+        }
+    }
+
     /* Start reading the ioqueue. */
     status = start_async_read(tp);
     if (status != PJ_SUCCESS) {
@@ -942,7 +1094,8 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_attach( pjsip_endpoint *endpt,
                                                 pjsip_transport **p_transport)
 {
     return transport_attach(endpt, PJSIP_TRANSPORT_UDP, sock, a_name,
-                            async_cnt, p_transport);
+                            async_cnt, PJSIP_UDP_RECV_BATCH_CNT,
+                            p_transport);
 }
 
 PJ_DEF(pj_status_t) pjsip_udp_transport_attach2( pjsip_endpoint *endpt,
@@ -953,7 +1106,8 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_attach2( pjsip_endpoint *endpt,
                                                  pjsip_transport **p_transport)
 {
     return transport_attach(endpt, type, sock, a_name,
-                            async_cnt, p_transport);
+                            async_cnt, PJSIP_UDP_RECV_BATCH_CNT,
+                            p_transport);
 }
 
 
@@ -967,6 +1121,7 @@ PJ_DEF(void) pjsip_udp_transport_cfg_default(pjsip_udp_transport_cfg *cfg,
     cfg->af = af;
     pj_sockaddr_init(cfg->af, &cfg->bind_addr, NULL, 0);
     cfg->async_cnt = 1;
+    cfg->recv_batch_cnt = PJSIP_UDP_RECV_BATCH_CNT;
 }
 
 
@@ -1026,9 +1181,9 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_start2(
         addr_name = cfg->addr_name;
     }
 
-    return pjsip_udp_transport_attach2(endpt, transport_type, sock,
-                                       &addr_name, cfg->async_cnt,
-                                       p_transport);
+    return transport_attach(endpt, transport_type, sock, &addr_name,
+                            cfg->async_cnt, cfg->recv_batch_cnt,
+                            p_transport);
 }
 
 /*
@@ -106,20 +106,19 @@ PJ_DEF(pj_status_t) pjsip_target_set_add_from_msg( pjsip_target_set *tset,
     PJ_ASSERT_RETURN(tset && pool && msg, PJ_EINVAL);
 
     /* Scan for Contact headers and add the URI */
-    hdr = msg->hdr.next;
-    while (hdr != &msg->hdr) {
-        if (hdr->type == PJSIP_H_CONTACT) {
-            const pjsip_contact_hdr *cn_hdr = (const pjsip_contact_hdr*)hdr;
-
-            if (!cn_hdr->star) {
-                pj_status_t rc;
-                rc = pjsip_target_set_add_uri(tset, pool, cn_hdr->uri, 
-                                              cn_hdr->q1000);
-                if (rc == PJ_SUCCESS)
-                    ++added;
-            }
+    hdr = (const pjsip_hdr*) pjsip_msg_find_hdr(msg, PJSIP_H_CONTACT, NULL);
+    while (hdr) {
+        const pjsip_contact_hdr *cn_hdr = (const pjsip_contact_hdr*)hdr;
+
+        if (!cn_hdr->star) {
+            pj_status_t rc;
+            rc = pjsip_target_set_add_uri(tset, pool, cn_hdr->uri, 
+                                          cn_hdr->q1000);
+            if (rc == PJ_SUCCESS)
+                ++added;
         }
-        hdr = hdr->next;
+        hdr = (const pjsip_hdr*) pjsip_msg_find_hdr(msg, PJSIP_H_CONTACT,
+                                                    hdr->next);
     }
 
     return added ? PJ_SUCCESS : PJ_EEXISTS;
@@ -2081,7 +2081,8 @@ PJ_DEF(pj_status_t) pjsua_acc_send_request(pjsua_acc_id acc_id,
     cap_hdr = pjsip_endpt_get_capability(pjsua_var.endpt, PJSIP_H_ACCEPT, NULL);
     if (cap_hdr) {
         pjsip_msg_add_hdr(tdata->msg,
-                          (pjsip_hdr*) pjsip_hdr_clone(tdata->pool, cap_hdr));
+                          (pjsip_hdr*) pjsip_hdr_shallow_clone(tdata->pool,
+                                                               cap_hdr));
     }
 
     status = pjsip_endpt_send_request(pjsua_var.endpt, tdata, -1, request_data, &on_send_request);
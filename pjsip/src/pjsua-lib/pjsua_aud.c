@@ -46,6 +46,18 @@ static pj_status_t create_aud_param(pjmedia_aud_param *param,
                                     unsigned samples_per_frame,
                                     unsigned bits_per_sample,
                                     pj_bool_t use_default_settings);
+/* Get the name of the conference port of a call stream */
+static void get_call_port_name(pjsua_call *call, unsigned strm_idx,
+                               char *buf, unsigned buf_len, pj_str_t *name);
+/* Add a call stream to a conference room */
+static pj_status_t room_attach(pjsua_call_media *call_med,
+                               pjsua_conf_room_id room_id,
+                               const pj_str_t *name,
+                               pjsua_conf_port_id held_slot);
+/* Remove a call stream from its conference room */
+static void room_detach(pjsua_call_media *call_med);
+/* Conference bridge operation callback */
+static void on_mconf_op(const pjmedia_conf_op_info *info);
 
 /*****************************************************************************
  *
@@ -93,6 +105,112 @@ on_return:
 }
 
 
+/*
+ * Move the audio of the call to a conference room or to the main bridge.
+ */
+PJ_DEF(pj_status_t) pjsua_call_set_conf_room(pjsua_call_id call_id,
+                                             pjsua_conf_room_id room_id)
+{
+    pjsua_call *call;
+    pjsip_dialog *dlg = NULL;
+    unsigned mi;
+    pj_status_t status;
+
+    PJ_ASSERT_RETURN(call_id>=0 && call_id<(int)pjsua_var.ua_cfg.max_calls,
+                     PJ_EINVAL);
+    PJ_ASSERT_RETURN(room_id == PJSUA_INVALID_ID ||
+                     (room_id >= 0 &&
+                      room_id < (int)PJ_ARRAY_SIZE(pjsua_var.room)),
+                     PJ_EINVAL);
+
+    status = acquire_call("pjsua_call_set_conf_room()", call_id, &call, &dlg);
+    if (status != PJ_SUCCESS)
+        return status;
+
+    PJSUA_LOCK();
+
+    if (!call->inv) {
+        status = PJ_EINVALIDOP;
+        goto on_return;
+    }
+    if (room_id != PJSUA_INVALID_ID && !pjsua_var.room[room_id].conf) {
+        status = PJ_EINVAL;
+        goto on_return;
+    }
+    if (call->conf_room == room_id)
+        goto on_return;
+
+    call->conf_room = room_id;
+
+    for (mi = 0; mi < call->med_cnt; ++mi) {
+        pjsua_call_media *call_med = &call->media[mi];
+        char tmp[PJSIP_MAX_URL_SIZE];
+        pj_str_t port_name;
+        pjsua_conf_port_id held_slot = PJSUA_INVALID_ID;
+
+        if (call_med->type != PJMEDIA_TYPE_AUDIO ||
+            !call_med->strm.a.stream || !call_med->strm.a.media_port)
+        {
+            continue;
+        }
+
+        /* Leave the current room, the room doesn't use the stream
+         * anymore once detached.
+         */
+        if (call_med->strm.a.room_member) {
+            room_detach(call_med);
+        } else if (room_id == PJSUA_INVALID_ID) {
+            if (call_med->strm.a.conf_slot != PJSUA_INVALID_ID)
+                continue;
+        } else {
+            held_slot = call_med->strm.a.conf_slot;
+        }
+
+        /* Join the new one. When leaving the main bridge, the room is
+         * attached before the port is removed, so that it doesn't miss
+         * the completion of the removal, which may be reported right
+         * away.
+         */
+        get_call_port_name(call, mi, tmp, sizeof(tmp), &port_name);
+        if (room_id != PJSUA_INVALID_ID) {
+            status = room_attach(call_med, room_id, &port_name, held_slot);
+        } else {
+            status = pjmedia_conf_add_port(pjsua_var.mconf,
+                                           call->inv->pool,
+                                           call_med->strm.a.media_port,
+                                           &port_name,
+                                           (unsigned*)
+                                           &call_med->strm.a.conf_slot);
+        }
+        if (held_slot != PJSUA_INVALID_ID) {
+            pjsua_conf_remove_port(held_slot);
+            call_med->strm.a.conf_slot = PJSUA_INVALID_ID;
+        }
+        if (status != PJ_SUCCESS) {
+            pjsua_perror(THIS_FILE, "Error moving call audio", status);
+            break;
+        }
+    }
+
+on_return:
+    PJSUA_UNLOCK();
+    if (dlg) pjsip_dlg_dec_lock(dlg);
+    return status;
+}
+
+
+/*
+ * Get the conference room of the call.
+ */
+PJ_DEF(pjsua_conf_room_id) pjsua_call_get_conf_room(pjsua_call_id call_id)
+{
+    PJ_ASSERT_RETURN(call_id>=0 && call_id<(int)pjsua_var.ua_cfg.max_calls,
+                     PJSUA_INVALID_ID);
+
+    return pjsua_var.calls[call_id].conf_room;
+}
+
+
 /*
  * Modify audio stream's codec parameters.
  */
@@ -373,11 +491,23 @@ pj_status_t pjsua_aud_subsys_init()
                                       &pjsua_var.null_port);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    /* Set conf operation callback. */
-    if (pjsua_var.ua_cfg.cb.on_conf_op_completed) {
-        pjmedia_conf_set_op_cb(pjsua_var.mconf,
-                               pjsua_var.ua_cfg.cb.on_conf_op_completed);
+    /* Set conf operation callback. The bridge always reports to us, as
+     * a stream moved to a conference room must wait until the bridge
+     * has released it.
+     */
+    pjsua_var.mconf_op_cb = pjsua_var.ua_cfg.cb.on_conf_op_completed;
+    pjmedia_conf_set_op_cb(pjsua_var.mconf, &on_mconf_op);
+
+    status = pj_lock_create_simple_mutex(pjsua_var.pool, "room",
+                                         &pjsua_var.room_lock);
+    if (status != PJ_SUCCESS) {
+        pjsua_perror(THIS_FILE, "Error creating room lock", status);
+        goto on_error;
     }
+    pjsua_var.room_held = (pjmedia_port**)
+                          pj_pool_calloc(pjsua_var.pool,
+                                         pjsua_var.media_cfg.max_media_ports,
+                                         sizeof(pjsua_var.room_held[0]));
 
     return status;
 
@@ -493,11 +623,29 @@ pj_status_t pjsua_aud_subsys_destroy()
         }
     }
 
+    /* Destroy conference rooms */
+    for (i=0; i<PJ_ARRAY_SIZE(pjsua_var.room); ++i) {
+        if (pjsua_var.room[i].conf) {
+            pjsua_conf_room_destroy(i);
+        }
+    }
+
+    if (pjsua_var.room_ticks) {
+        pjmedia_tick_pool_destroy(pjsua_var.room_ticks);
+        pjsua_var.room_ticks = NULL;
+    }
+
     if (pjsua_var.mconf) {
         pjmedia_conf_destroy(pjsua_var.mconf);
         pjsua_var.mconf = NULL;
     }
 
+    if (pjsua_var.room_lock) {
+        pj_lock_destroy(pjsua_var.room_lock);
+        pjsua_var.room_lock = NULL;
+        pjsua_var.room_held = NULL;
+    }
+
     if (pjsua_var.null_port) {
         pjmedia_port_destroy(pjsua_var.null_port);
         pjsua_var.null_port = NULL;
@@ -523,6 +671,10 @@ void pjsua_aud_stop_stream(pjsua_call_media *call_med)
 
         pjmedia_stream_send_rtcp_bye(strm);
 
+        if (call_med->strm.a.room_member) {
+            room_detach(call_med);
+        }
+
         if (call_med->strm.a.conf_slot != PJSUA_INVALID_ID) {
             if (pjsua_var.mconf) {
                 pjsua_conf_remove_port(call_med->strm.a.conf_slot);
@@ -797,27 +949,24 @@ pj_status_t pjsua_aud_channel_update(pjsua_call_media *call_med,
         }
 
         /*
-         * Add the call to conference bridge.
+         * Add the call to conference bridge, or to its conference room.
          */
         {
             char tmp[PJSIP_MAX_URL_SIZE];
             pj_str_t port_name;
 
-            port_name.ptr = tmp;
-            port_name.slen = pjsip_uri_print(PJSIP_URI_IN_REQ_URI,
-                                             call->inv->dlg->remote.info->uri,
-                                             tmp, sizeof(tmp));
-            if (port_name.slen < 1 || pj_strchr(&port_name, '%')) {
-                pj_ansi_snprintf(tmp, sizeof(tmp), "call %d:%d",
-                                 call->index, strm_idx);
-                port_name = pj_str(tmp);
+            get_call_port_name(call, strm_idx, tmp, sizeof(tmp), &port_name);
+            if (call->conf_room != PJSUA_INVALID_ID) {
+                status = room_attach(call_med, call->conf_room, &port_name,
+                                     PJSUA_INVALID_ID);
+            } else {
+                status = pjmedia_conf_add_port(pjsua_var.mconf,
+                                               call->inv->pool,
+                                               call_med->strm.a.media_port,
+                                               &port_name,
+                                               (unsigned*)
+                                               &call_med->strm.a.conf_slot);
             }
-            status = pjmedia_conf_add_port(pjsua_var.mconf,
-                                           call->inv->pool,
-                                           call_med->strm.a.media_port,
-                                           &port_name,
-                                           (unsigned*)
-                                           &call_med->strm.a.conf_slot);
             if (status != PJ_SUCCESS) {
                 goto on_return;
             }
@@ -1236,7 +1385,435 @@ PJ_DEF(pj_status_t) pjsua_conf_get_signal_level(pjsua_conf_port_id slot,
 
 PJ_DEF(pj_status_t) pjsua_conf_set_op_cb(pjmedia_conf_op_cb cb)
 {
-    return pjmedia_conf_set_op_cb(pjsua_var.mconf, cb);
+    /* Called by on_mconf_op() */
+    pjsua_var.mconf_op_cb = cb;
+    return PJ_SUCCESS;
+}
+
+/*****************************************************************************
+ * Conference rooms.
+ */
+
+#define ROOM_MEMBER_SIGNATURE   PJMEDIA_SIG_CLASS_APP('R','M','B')
+
+/* The port of a call stream in a conference room. It forwards the frames
+ * to the stream port until it is detached. Detaching is synchronous,
+ * while the room bridge removes the member port asynchronously and may
+ * still call it for a while. Likewise, a stream moved from the main
+ * bridge is held until the main bridge has removed its port.
+ */
+typedef struct room_member
+{
+    pjmedia_port         base;
+    pj_pool_t           *pool;
+    pj_lock_t           *lock;
+    pjmedia_port        *target;        /* Stream port, NULL if detached  */
+    pj_bool_t            held;          /* Main bridge still uses stream  */
+    pjsua_conf_port_id   held_slot;     /* Slot of stream in main bridge  */
+} room_member;
+
+/* Check if the member may use the stream, must be called with the lock */
+static pj_bool_t room_member_active(room_member *rm)
+{
+    return rm->target && !rm->held;
+}
+
+static pj_status_t room_member_get_frame(pjmedia_port *this_port,
+                                         pjmedia_frame *frame)
+{
+    room_member *rm = (room_member*)this_port;
+    pj_status_t status = PJ_SUCCESS;
+
+    pj_lock_acquire(rm->lock);
+    if (room_member_active(rm)) {
+        status = pjmedia_port_get_frame(rm->target, frame);
+    } else {
+        frame->type = PJMEDIA_FRAME_TYPE_NONE;
+        frame->size = 0;
+    }
+    pj_lock_release(rm->lock);
+
+    return status;
+}
+
+static pj_status_t room_member_put_frame(pjmedia_port *this_port,
+                                         pjmedia_frame *frame)
+{
+    room_member *rm = (room_member*)this_port;
+    pj_status_t status = PJ_SUCCESS;
+
+    pj_lock_acquire(rm->lock);
+    if (room_member_active(rm))
+        status = pjmedia_port_put_frame(rm->target, frame);
+    pj_lock_release(rm->lock);
+
+    return status;
+}
+
+static pj_status_t room_member_on_destroy(pjmedia_port *this_port)
+{
+    room_member *rm = (room_member*)this_port;
+
+    pj_lock_destroy(rm->lock);
+    pj_pool_safe_release(&rm->pool);
+
+    return PJ_SUCCESS;
+}
+
+static pj_status_t room_member_create(pjmedia_port *target,
+                                      const pj_str_t *name,
+                                      room_member **p_rm)
+{
+    pj_pool_t *pool;
+    room_member *rm;
+    pj_str_t port_name;
+    pj_status_t status;
+
+    pool = pjsua_pool_create("roommember%p", 512, 512);
+    if (!pool)
+        return PJ_ENOMEM;
+
+    rm = PJ_POOL_ZALLOC_T(pool, room_member);
+    rm->pool = pool;
+    rm->target = target;
+    rm->held_slot = PJSUA_INVALID_ID;
+
+    status = pj_lock_create_simple_mutex(pool, "roommember%p", &rm->lock);
+    if (status != PJ_SUCCESS) {
+        pj_pool_release(pool);
+        return status;
+    }
+
+    pj_strdup(pool, &port_name, name);
+    pjmedia_port_info_init2(&rm->base.info, &port_name, ROOM_MEMBER_SIGNATURE,
+                            PJMEDIA_DIR_ENCODING_DECODING,
+                            &target->info.fmt);
+    rm->base.get_frame = &room_member_get_frame;
+    rm->base.put_frame = &room_member_put_frame;
+    rm->base.on_destroy = &room_member_on_destroy;
+
+    status = pjmedia_port_init_grp_lock(&rm->base, pool, NULL);
+    if (status != PJ_SUCCESS) {
+        room_member_on_destroy(&rm->base);
+        return status;
+    }
+
+    *p_rm = rm;
+    return PJ_SUCCESS;
+}
+
+/* Get the name of the conference port of a call stream */
+static void get_call_port_name(pjsua_call *call, unsigned strm_idx,
+                               char *buf, unsigned buf_len, pj_str_t *name)
+{
+    name->ptr = buf;
+    name->slen = pjsip_uri_print(PJSIP_URI_IN_REQ_URI,
+                                 call->inv->dlg->remote.info->uri,
+                                 buf, buf_len);
+    if (name->slen < 1 || pj_strchr(name, '%')) {
+        pj_ansi_snprintf(buf, buf_len, "call %d:%d", call->index, strm_idx);
+        *name = pj_str(buf);
+    }
+}
+
+/* Let the room use a stream that the main bridge has released */
+static void room_member_release(unsigned held_slot)
+{
+    room_member *rm;
+
+    if (!pjsua_var.room_lock ||
+        held_slot >= pjsua_var.media_cfg.max_media_ports)
+    {
+        return;
+    }
+
+    pj_lock_acquire(pjsua_var.room_lock);
+    rm = (room_member*)pjsua_var.room_held[held_slot];
+    if (rm) {
+        pjsua_var.room_held[held_slot] = NULL;
+        pj_lock_acquire(rm->lock);
+        rm->held = PJ_FALSE;
+        rm->held_slot = PJSUA_INVALID_ID;
+        pj_lock_release(rm->lock);
+    }
+    pj_lock_release(pjsua_var.room_lock);
+}
+
+/* Conference bridge operation callback, called by the bridge clock or
+ * by the thread removing a port.
+ */
+static void on_mconf_op(const pjmedia_conf_op_info *info)
+{
+    pjmedia_conf_op_cb cb = pjsua_var.mconf_op_cb;
+
+    if (info->op_type == PJMEDIA_CONF_OP_REMOVE_PORT)
+        room_member_release(info->op_param.remove_port.port);
+
+    if (cb)
+        (*cb)(info);
+}
+
+/* Add a call stream to a conference room, connected with all other
+ * members of the room. If held_slot is valid, the stream is still in
+ * the main bridge, and the room won't use it until the main bridge has
+ * removed it from that slot.
+ */
+static pj_status_t room_attach(pjsua_call_media *call_med,
+                               pjsua_conf_room_id room_id,
+                               const pj_str_t *name,
+                               pjsua_conf_port_id held_slot)
+{
+    pjsua_conf_room *room = &pjsua_var.room[room_id];
+    room_member *rm;
+    unsigned slot, i;
+    pj_status_t status;
+
+    status = room_member_create(call_med->strm.a.media_port, name, &rm);
+    if (status != PJ_SUCCESS)
+        return status;
+
+    if (held_slot != PJSUA_INVALID_ID) {
+        rm->held = PJ_TRUE;
+        rm->held_slot = held_slot;
+        pj_lock_acquire(pjsua_var.room_lock);
+        pjsua_var.room_held[held_slot] = &rm->base;
+        pj_lock_release(pjsua_var.room_lock);
+    }
+
+    pj_mutex_lock(room->mutex);
+
+    status = pjmedia_conf_add_port(room->conf, rm->pool, &rm->base, name,
+                                   &slot);
+    if (status != PJ_SUCCESS) {
+        pj_mutex_unlock(room->mutex);
+        room_member_release(held_slot);
+        pjmedia_port_destroy(&rm->base);
+        return status;
+    }
+
+    for (i = 0; i < room->member_cnt; ++i) {
+        pjmedia_conf_connect_port(room->conf, slot, room->member[i], 0);
+        pjmedia_conf_connect_port(room->conf, room->member[i], slot, 0);
+    }
+    room->member[room->member_cnt++] = slot;
+
+    pj_mutex_unlock(room->mutex);
+
+    call_med->strm.a.room_id = room_id;
+    call_med->strm.a.room_member = &rm->base;
+    call_med->strm.a.room_slot = slot;
+
+    PJ_LOG(4,(THIS_FILE, "Call %d:%d added to conference room %d, slot %d",
+              call_med->call->index, call_med->idx, room_id, slot));
+
+    return PJ_SUCCESS;
+}
+
+/* Remove a call stream from its conference room. The stream is not used
+ * by the room anymore once this function returns.
+ */
+static void room_detach(pjsua_call_media *call_med)
+{
+    pjsua_conf_room *room = &pjsua_var.room[call_med->strm.a.room_id];
+    room_member *rm = (room_member*)call_med->strm.a.room_member;
+    unsigned slot = (unsigned)call_med->strm.a.room_slot;
+    unsigned i;
+
+    pj_lock_acquire(pjsua_var.room_lock);
+    pj_lock_acquire(rm->lock);
+    if (rm->held) {
+        pjsua_var.room_held[rm->held_slot] = NULL;
+        rm->held = PJ_FALSE;
+        rm->held_slot = PJSUA_INVALID_ID;
+    }
+    rm->target = NULL;
+    pj_lock_release(rm->lock);
+    pj_lock_release(pjsua_var.room_lock);
+
+    pj_mutex_lock(room->mutex);
+    for (i = 0; i < room->member_cnt; ++i) {
+        if (room->member[i] == slot) {
+            pj_array_erase(room->member, sizeof(room->member[0]),
+                           room->member_cnt, i);
+            --room->member_cnt;
+            break;
+        }
+    }
+    pjmedia_conf_remove_port(room->conf, slot);
+    pj_mutex_unlock(room->mutex);
+
+    PJ_LOG(4,(THIS_FILE, "Call %d:%d removed from conference room %d",
+              call_med->call->index, call_med->idx,
+              call_med->strm.a.room_id));
+
+    /* Released when the room bridge is done with it */
+    pjmedia_port_destroy(&rm->base);
+
+    call_med->strm.a.room_id = PJSUA_INVALID_ID;
+    call_med->strm.a.room_member = NULL;
+    call_med->strm.a.room_slot = PJSUA_INVALID_ID;
+}
+
+PJ_DEF(void) pjsua_conf_room_config_default(pjsua_conf_room_config *cfg)
+{
+    pj_bzero(cfg, sizeof(*cfg));
+    cfg->max_members = 32;
+    cfg->options = PJMEDIA_CONF_MIX_MINUS;
+}
+
+/*
+ * Create a conference room.
+ */
+PJ_DEF(pj_status_t) pjsua_conf_room_create(const pjsua_conf_room_config *cfg,
+                                           pjsua_conf_room_id *p_id)
+{
+    pjsua_conf_room_config default_cfg;
+    pjsua_conf_room *room = NULL;
+    pjmedia_conf_param param;
+    pjmedia_port *master;
+    unsigned id;
+    pj_status_t status;
+
+    PJ_ASSERT_RETURN(p_id, PJ_EINVAL);
+    PJ_ASSERT_RETURN(pjsua_var.mconf, PJ_EINVALIDOP);
+
+    if (!cfg) {
+        pjsua_conf_room_config_default(&default_cfg);
+        cfg = &default_cfg;
+    }
+    PJ_ASSERT_RETURN(cfg->max_members > 0, PJ_EINVAL);
+
+    /* The switchboard can't run without the sound device */
+    if (pjsua_var.is_mswitch)
+        return PJ_ENOTSUP;
+
+    PJSUA_LOCK();
+
+    for (id = 0; id < PJ_ARRAY_SIZE(pjsua_var.room); ++id) {
+        if (pjsua_var.room[id].conf == NULL)
+            break;
+    }
+    if (id == PJ_ARRAY_SIZE(pjsua_var.room)) {
+        status = PJ_ETOOMANY;
+        goto on_error;
+    }
+
+    room = &pjsua_var.room[id];
+    room->pool = pjsua_pool_create("confroom%p", 1000, 1000);
+    if (!room->pool) {
+        status = PJ_ENOMEM;
+        goto on_error;
+    }
+    room->max_members = cfg->max_members;
+    room->member = (unsigned*) pj_pool_calloc(room->pool, cfg->max_members,
+                                              sizeof(unsigned));
+
+    status = pj_mutex_create_simple(room->pool, "confroom%p", &room->mutex);
+    if (status != PJ_SUCCESS)
+        goto on_error;
+
+    /* Same format and resampling quality as the main bridge */
+    pjmedia_conf_param_default(&param);
+    param.max_slots = cfg->max_members + 1;
+    param.sampling_rate = pjsua_var.media_cfg.clock_rate;
+    param.channel_count = pjsua_var.mconf_cfg.channel_count;
+    param.samples_per_frame = pjsua_var.mconf_cfg.samples_per_frame;
+    param.bits_per_sample = pjsua_var.mconf_cfg.bits_per_sample;
+    param.options = cfg->options | PJMEDIA_CONF_NO_DEVICE;
+    if (pjsua_var.media_cfg.quality >= 3 &&
+        pjsua_var.media_cfg.quality <= 4)
+    {
+        param.options |= PJMEDIA_CONF_SMALL_FILTER;
+    }
+    else if (pjsua_var.media_cfg.quality < 3) {
+        param.options |= PJMEDIA_CONF_USE_LINEAR;
+    }
+    /* The rooms run concurrently in the tick pool instead */
+    param.worker_threads = 0;
+
+    status = pjmedia_conf_create2(room->pool, &param, &room->conf);
+    if (status != PJ_SUCCESS)
+        goto on_error;
+
+    master = pjmedia_conf_get_master_port(room->conf);
+
+    if (!pjsua_var.room_ticks) {
+        pjmedia_tick_pool_param tparam;
+
+        pjmedia_tick_pool_param_default(&tparam);
+        tparam.ptime_usec = master->info.fmt.det.aud.frame_time_usec;
+        tparam.worker_cnt = pjsua_var.media_cfg.conf_room_threads;
+        status = pjmedia_tick_pool_create(pjsua_var.pool, &tparam,
+                                          &pjsua_var.room_ticks);
+        if (status != PJ_SUCCESS)
+            goto on_error;
+    }
+
+    status = pjmedia_tick_pool_add_port(pjsua_var.room_ticks, master);
+    if (status != PJ_SUCCESS)
+        goto on_error;
+
+    PJ_LOG(4,(THIS_FILE, "Conference room %d created", id));
+
+    *p_id = id;
+    PJSUA_UNLOCK();
+    return PJ_SUCCESS;
+
+on_error:
+    if (room) {
+        if (room->conf)
+            pjmedia_conf_destroy(room->conf);
+        if (room->mutex)
+            pj_mutex_destroy(room->mutex);
+        pj_pool_safe_release(&room->pool);
+        pj_bzero(room, sizeof(*room));
+    }
+    PJSUA_UNLOCK();
+    pjsua_perror(THIS_FILE, "Error creating conference room", status);
+    return status;
+}
+
+/*
+ * Destroy a conference room.
+ */
+PJ_DEF(pj_status_t) pjsua_conf_room_destroy(pjsua_conf_room_id id)
+{
+    pjsua_conf_room *room;
+    unsigned i;
+
+    PJ_ASSERT_RETURN(id >= 0 && id < (int)PJ_ARRAY_SIZE(pjsua_var.room),
+                     PJ_EINVAL);
+
+    PJSUA_LOCK();
+
+    room = &pjsua_var.room[id];
+    if (!room->conf) {
+        PJSUA_UNLOCK();
+        return PJ_EINVAL;
+    }
+
+    /* Move the calls back to the main bridge */
+    for (i = 0; i < pjsua_var.ua_cfg.max_calls; ++i) {
+        if (pjsua_var.calls[i].conf_room == id) {
+            if (pjsua_var.calls[i].inv)
+                pjsua_call_set_conf_room(i, PJSUA_INVALID_ID);
+            pjsua_var.calls[i].conf_room = PJSUA_INVALID_ID;
+        }
+    }
+
+    /* Wait until the room is not being processed */
+    pjmedia_tick_pool_remove_port(pjsua_var.room_ticks,
+                                  pjmedia_conf_get_master_port(room->conf));
+
+    pjmedia_conf_destroy(room->conf);
+    pj_mutex_destroy(room->mutex);
+    pj_pool_release(room->pool);
+    pj_bzero(room, sizeof(*room));
+
+    PJ_LOG(4,(THIS_FILE, "Conference room %d destroyed", id));
+
+    PJSUA_UNLOCK();
+    return PJ_SUCCESS;
 }
 
 /*****************************************************************************
@@ -171,6 +171,7 @@ static void reset_call(pjsua_call_id id)
     }
     pj_bzero(call, sizeof(*call));
     call->index = id;
+    call->conf_room = PJSUA_INVALID_ID;
     call->last_text.ptr = call->last_text_buf_;
     call->cname.ptr = call->cname_buf;
     call->cname.slen = sizeof(call->cname_buf);
@@ -178,6 +179,8 @@ static void reset_call(pjsua_call_id id)
         pjsua_call_media *call_med = &call->media[i];
         call_med->ssrc = pj_rand();
         call_med->strm.a.conf_slot = PJSUA_INVALID_ID;
+        call_med->strm.a.room_id = PJSUA_INVALID_ID;
+        call_med->strm.a.room_slot = PJSUA_INVALID_ID;
         call_med->strm.v.cap_win_id = PJSUA_INVALID_ID;
         call_med->strm.v.rdr_win_id = PJSUA_INVALID_ID;
         call_med->strm.v.strm_dec_slot = PJSUA_INVALID_ID;
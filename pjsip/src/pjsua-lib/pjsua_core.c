@@ -114,6 +114,7 @@ PJ_DEF(void) pjsua_config_default(pjsua_config *cfg)
 
     cfg->max_calls = PJSUA_MAX_CALLS;
     cfg->thread_cnt = PJSUA_SEPARATE_WORKER_FOR_TIMER? 2 : 1;
+    cfg->rx_worker_cnt = PJSIP_RX_WORKER_CNT;
     cfg->nat_type_in_sdp = 1;
     cfg->stun_ignore_failure = PJ_TRUE;
     cfg->force_lr = PJ_TRUE;
@@ -441,6 +442,7 @@ PJ_DEF(void) pjsua_media_config_default(pjsua_media_config *cfg)
     cfg->audio_frame_ptime = PJSUA_DEFAULT_AUDIO_FRAME_PTIME;
     cfg->max_media_ports = PJSUA_MAX_CONF_PORTS;
     cfg->conf_threads = PJMEDIA_CONF_THREADS;
+    cfg->conf_room_threads = PJMEDIA_TICK_POOL_WORKERS;
     cfg->has_ioqueue = PJ_TRUE;
     cfg->thread_cnt = 1;
     cfg->quality = PJSUA_DEFAULT_CODEC_QUALITY;
@@ -590,28 +592,32 @@ static pj_bool_t options_on_rx_request(pjsip_rx_data *rdata)
     cap_hdr = pjsip_endpt_get_capability(pjsua_var.endpt, PJSIP_H_ALLOW, NULL);
     if (cap_hdr) {
         pjsip_msg_add_hdr(tdata->msg, 
-                          (pjsip_hdr*) pjsip_hdr_clone(tdata->pool, cap_hdr));
+                          (pjsip_hdr*) pjsip_hdr_shallow_clone(tdata->pool,
+                                                               cap_hdr));
     }
 
     /* Add Accept header */
     cap_hdr = pjsip_endpt_get_capability(pjsua_var.endpt, PJSIP_H_ACCEPT, NULL);
     if (cap_hdr) {
         pjsip_msg_add_hdr(tdata->msg, 
-                          (pjsip_hdr*) pjsip_hdr_clone(tdata->pool, cap_hdr));
+                          (pjsip_hdr*) pjsip_hdr_shallow_clone(tdata->pool,
+                                                               cap_hdr));
     }
 
     /* Add Supported header */
     cap_hdr = pjsip_endpt_get_capability(pjsua_var.endpt, PJSIP_H_SUPPORTED, NULL);
     if (cap_hdr) {
         pjsip_msg_add_hdr(tdata->msg, 
-                          (pjsip_hdr*) pjsip_hdr_clone(tdata->pool, cap_hdr));
+                          (pjsip_hdr*) pjsip_hdr_shallow_clone(tdata->pool,
+                                                               cap_hdr));
     }
 
     /* Add Allow-Events header from the evsub module */
     cap_hdr = pjsip_evsub_get_allow_events_hdr(NULL);
     if (cap_hdr) {
         pjsip_msg_add_hdr(tdata->msg, 
-                          (pjsip_hdr*) pjsip_hdr_clone(tdata->pool, cap_hdr));
+                          (pjsip_hdr*) pjsip_hdr_shallow_clone(tdata->pool,
+                                                               cap_hdr));
     }
 
     /* Add User-Agent header */
@@ -926,6 +932,12 @@ PJ_DEF(void) pjsua_stop_worker_threads(void)
             pjsua_var.thread[i] = NULL;
         }
     }
+
+    /* Finish the incoming messages already handed off to the SIP rx
+     * workers.
+     */
+    if (pjsua_var.endpt)
+        pjsip_endpt_stop_rx_workers(pjsua_var.endpt);
 }
 
 /* Init random seed */
@@ -1353,6 +1365,19 @@ PJ_DEF(pj_status_t) pjsua_init( const pjsua_config *ua_cfg,
     pjsip_endpt_add_capability(pjsua_var.endpt, NULL, PJSIP_H_ALLOW,
                                NULL, 1, &STR_OPTIONS);
 
+    /* Start the SIP worker threads for incoming messages if needed. */
+    if (pjsua_var.ua_cfg.rx_worker_cnt) {
+        pjsip_rx_worker_param rx_prm;
+
+        pjsip_rx_worker_param_default(&rx_prm);
+        rx_prm.worker_cnt = pjsua_var.ua_cfg.rx_worker_cnt;
+        status = pjsip_endpt_start_rx_workers(pjsua_var.endpt, &rx_prm);
+        if (status != PJ_SUCCESS) {
+            pjsua_perror(THIS_FILE, "Error starting SIP rx workers", status);
+            goto on_error;
+        }
+    }
+
     /* Start worker thread if needed. */
     if (pjsua_var.ua_cfg.thread_cnt) {
         unsigned ii;
@@ -1363,6 +1388,19 @@ PJ_DEF(pj_status_t) pjsua_init( const pjsua_config *ua_cfg,
 #if PJSUA_SEPARATE_WORKER_FOR_TIMER
         if (pjsua_var.ua_cfg.thread_cnt < 2)
             pjsua_var.ua_cfg.thread_cnt = 2;
+#else
+        if (pjsua_var.ua_cfg.timer_heap_per_thread &&
+            pjsua_var.ua_cfg.thread_cnt > 1)
+        {
+            pj_timer_heap_t *ht = pjsip_endpt_get_timer_heap(pjsua_var.endpt);
+
+            status = pj_timer_heap_set_thread_heaps(
+                                        ht, pjsua_var.ua_cfg.thread_cnt);
+            if (status != PJ_SUCCESS) {
+                pjsua_perror(THIS_FILE, "Error splitting timer heap", status);
+                goto on_error;
+            }
+        }
 #endif
 
         for (ii=0; ii<pjsua_var.ua_cfg.thread_cnt; ++ii) {
@@ -100,6 +100,10 @@ pj_status_t pjsua_media_subsys_init(const pjsua_media_config *cfg)
         pjsua_var.media_cfg.conf_threads = 1;
     }
 
+    if (pjsua_var.media_cfg.conf_room_threads < 1) {
+        pjsua_var.media_cfg.conf_room_threads = 1;
+    }
+
     /* Create media endpoint. */
     status = pjmedia_endpt_create(&pjsua_var.cp.factory, 
                                   pjsua_var.media_cfg.has_ioqueue? NULL :
@@ -3505,6 +3509,9 @@ static void stop_media_stream(pjsua_call *call, unsigned med_idx)
         /* Stream */
         if (call_med->type == PJMEDIA_TYPE_AUDIO) {
             prov_med->strm.a.conf_slot = call_med->strm.a.conf_slot;
+            prov_med->strm.a.room_id   = call_med->strm.a.room_id;
+            prov_med->strm.a.room_member = call_med->strm.a.room_member;
+            prov_med->strm.a.room_slot = call_med->strm.a.room_slot;
             prov_med->strm.a.stream    = call_med->strm.a.stream;
         }
 #if PJMEDIA_HAS_VIDEO
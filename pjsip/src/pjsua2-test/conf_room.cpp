@@ -0,0 +1,382 @@
+/*
+ * Copyright (C) 2025 Teluu Inc. (http://www.teluu.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * pjsua2-level tests for conference rooms (Endpoint::confRoomCreate() and
+ * Call::setConfRoom()), using a loopback call between two accounts of
+ * the same endpoint, both sides of which are moved around.
+ *
+ * Scenarios covered:
+ *   1. Move a call into a room and back to the main conference bridge.
+ *   2. Destroy a room while calls are attached to it, the calls must be
+ *      moved back to the main bridge.
+ *   3. Hang up a call while it is in a room.
+ */
+
+#include <iostream>
+#include <memory>
+
+#include "conf_room.hpp"
+
+#define THIS_FILE "conf_room.cpp"
+
+/* Always-active assertion (not compiled out by NDEBUG). */
+#define TEST_ASSERT(expr) \
+    do { \
+        if (!(expr)) { \
+            PJ_LOG(1,(THIS_FILE, "TEST ASSERT FAILED: %s (%s:%d)", \
+                      #expr, THIS_FILE, __LINE__)); \
+            pj_log_push_indent(); \
+            throw Error(PJ_EINVAL, "test assertion", \
+                        #expr, THIS_FILE, __LINE__); \
+        } \
+    } while (0)
+#define CALLEE_USER "pjsua2-room-callee"
+
+using namespace pj;
+
+
+/*****************************************************************************
+ * TestCall — tracks the call and media state
+ *****************************************************************************/
+
+class TestCall : public Call
+{
+public:
+    bool confirmed;
+    bool mediaActive;
+    bool disconnected;
+
+    TestCall(Account &acc, int call_id = PJSUA_INVALID_ID)
+    : Call(acc, call_id), confirmed(false), mediaActive(false),
+      disconnected(false)
+    {}
+
+    virtual void onCallState(OnCallStateParam &prm) override
+    {
+        CallInfo ci = getInfo();
+
+        PJ_UNUSED_ARG(prm);
+        if (ci.state == PJSIP_INV_STATE_CONFIRMED)
+            confirmed = true;
+        else if (ci.state == PJSIP_INV_STATE_DISCONNECTED)
+            disconnected = true;
+    }
+
+    virtual void onCallMediaState(OnCallMediaStateParam &prm) override
+    {
+        PJ_UNUSED_ARG(prm);
+        mediaActive = hasMedia();
+    }
+
+    /* Number of RTP packets sent by the audio stream so far, these are
+     * only sent while a bridge is clocking the stream.
+     */
+    unsigned txPackets()
+    {
+        return getStreamStat(0).rtcp.txStat.pkt;
+    }
+};
+
+static std::unique_ptr<TestCall> g_incoming;
+
+
+/*****************************************************************************
+ * CalleeAccount — answers incoming calls right away
+ *****************************************************************************/
+
+class CalleeAccount : public Account
+{
+public:
+    using Account::Account;
+
+    virtual void onIncomingCall(OnIncomingCallParam &prm) override
+    {
+        CallOpParam op;
+
+        g_incoming.reset(new TestCall(*this, prm.callId));
+        op.statusCode = PJSIP_SC_OK;
+        g_incoming->answer(op);
+    }
+};
+
+
+/*****************************************************************************
+ * Helpers
+ *****************************************************************************/
+
+struct LoopbackCall {
+    std::unique_ptr<CalleeAccount>      calleeAcc;
+    std::unique_ptr<Account>            callerAcc;
+    std::unique_ptr<TestCall>           caller;
+    std::unique_ptr<TestCall>           callee;
+};
+
+static void poll_events(unsigned max_ms, bool (*done)(LoopbackCall&),
+                        LoopbackCall &lc)
+{
+    unsigned elapsed = 0;
+    while (elapsed < max_ms && !done(lc)) {
+        pjsua_handle_events(50);
+        elapsed += 50;
+    }
+}
+
+static bool both_active(LoopbackCall &lc)
+{
+    return g_incoming && g_incoming->mediaActive &&
+           lc.caller->confirmed && lc.caller->mediaActive;
+}
+
+static bool both_disconnected(LoopbackCall &lc)
+{
+    return lc.caller->disconnected && lc.callee->disconnected;
+}
+
+static void start_call(LoopbackCall &lc, pj_uint16_t port)
+{
+    AccountConfig cfg;
+    CallOpParam op(true);
+
+    cfg.idUri = "sip:" CALLEE_USER "@127.0.0.1";
+    lc.calleeAcc.reset(new CalleeAccount);
+    lc.calleeAcc->create(cfg);
+
+    cfg.idUri = "sip:pjsua2-room-caller@127.0.0.1";
+    lc.callerAcc.reset(new Account);
+    lc.callerAcc->create(cfg);
+
+    g_incoming.reset();
+    lc.caller.reset(new TestCall(*lc.callerAcc));
+    lc.caller->makeCall("sip:" CALLEE_USER "@127.0.0.1:" +
+                        std::to_string(port), op);
+
+    poll_events(10000, &both_active, lc);
+    TEST_ASSERT(both_active(lc));
+    lc.callee = std::move(g_incoming);
+}
+
+static void end_call(LoopbackCall &lc)
+{
+    CallOpParam op;
+
+    if (!lc.caller->disconnected)
+        lc.caller->hangup(op);
+    poll_events(10000, &both_disconnected, lc);
+    TEST_ASSERT(both_disconnected(lc));
+
+    lc.caller.reset();
+    lc.callee.reset();
+    lc.callerAcc.reset();
+    lc.calleeAcc.reset();
+    pjsua_handle_events(100);
+}
+
+static void check_in_main_bridge(TestCall &call)
+{
+    TEST_ASSERT(call.getConfRoom() == PJSUA_INVALID_ID);
+    TEST_ASSERT(pjsua_call_get_conf_port(call.getId()) != PJSUA_INVALID_ID);
+}
+
+static void check_in_room(TestCall &call, int room_id)
+{
+    TEST_ASSERT(call.getConfRoom() == room_id);
+    TEST_ASSERT(pjsua_call_get_conf_port(call.getId()) == PJSUA_INVALID_ID);
+}
+
+/* The room clocks its members, so their streams keep sending */
+static void check_room_clocks(TestCall &call)
+{
+    unsigned pkt = call.txPackets();
+
+    pjsua_handle_events(300);
+    TEST_ASSERT(call.txPackets() > pkt);
+}
+
+
+/*****************************************************************************
+ * ConfRoomTests implementation
+ *****************************************************************************/
+
+ConfRoomTests::ConfRoomTests()
+    : port(0)
+{
+    ep.libCreate();
+
+    EpConfig epCfg;
+    epCfg.logConfig.level = 3;
+    epCfg.logConfig.consoleLevel = 3;
+    epCfg.uaConfig.userAgent = "pjsua2-room-test";
+    epCfg.uaConfig.threadCnt = 0;  /* Single-threaded: drive events manually */
+    /* Keep the streams sending while they're clocked, see
+     * check_room_clocks()
+     */
+    epCfg.medConfig.noVad = true;
+    ep.libInit(epCfg);
+
+    TransportConfig tcfg;
+    tcfg.port = 0; /* ephemeral */
+    TransportId tpId = ep.transportCreate(PJSIP_TRANSPORT_UDP, tcfg);
+
+    ep.libStart();
+    ep.audDevManager().setNullDev();
+
+    /* Get ephemeral port via C API */
+    {
+        pjsua_transport_info ti;
+        pjsua_transport_get_info(tpId, &ti);
+        port = pj_sockaddr_get_port(&ti.local_addr);
+    }
+
+    std::cout << "*** ConfRoomTests started on port " << port << std::endl;
+}
+
+ConfRoomTests::~ConfRoomTests()
+{
+    g_incoming.reset();
+
+    try {
+        ep.libDestroy();
+    } catch (const Error &e) {
+        std::cerr << "Error during libDestroy: " << e.reason << std::endl;
+    }
+}
+
+
+/*****************************************************************************
+ * Test 1: moveToRoomAndBack
+ *
+ * Both sides of the call are moved into a room, where they are mixed by
+ * the room, then one side is moved back to the main bridge and gets a
+ * new port there.
+ *****************************************************************************/
+void ConfRoomTests::moveToRoomAndBack()
+{
+    std::cout << "\n=== CONF ROOM TEST: moveToRoomAndBack ===" << std::endl;
+
+    LoopbackCall lc;
+    start_call(lc, port);
+    check_in_main_bridge(*lc.caller);
+    check_in_main_bridge(*lc.callee);
+
+    int room_id = ep.confRoomCreate(ConfRoomConfig());
+    TEST_ASSERT(room_id != PJSUA_INVALID_ID);
+
+    lc.caller->setConfRoom(room_id);
+    lc.callee->setConfRoom(room_id);
+    check_in_room(*lc.caller, room_id);
+    check_in_room(*lc.callee, room_id);
+    check_room_clocks(*lc.caller);
+
+    /* Moving to the same room again is a no-op */
+    lc.caller->setConfRoom(room_id);
+    check_in_room(*lc.caller, room_id);
+
+    lc.caller->setConfRoom(PJSUA_INVALID_ID);
+    check_in_main_bridge(*lc.caller);
+    check_in_room(*lc.callee, room_id);
+    pjsua_handle_events(100);
+
+    /* And in again, after having been in the main bridge */
+    lc.caller->setConfRoom(room_id);
+    check_in_room(*lc.caller, room_id);
+    check_room_clocks(*lc.caller);
+
+    lc.caller->setConfRoom(PJSUA_INVALID_ID);
+    lc.callee->setConfRoom(PJSUA_INVALID_ID);
+    check_in_main_bridge(*lc.caller);
+    check_in_main_bridge(*lc.callee);
+
+    ep.confRoomDestroy(room_id);
+    end_call(lc);
+
+    std::cout << "  moveToRoomAndBack: PASSED\n";
+}
+
+
+/*****************************************************************************
+ * Test 2: destroyWithMembers
+ *
+ * The room is destroyed while both sides of the call are attached to it.
+ * The calls must be back in the main bridge, and the room must be gone.
+ *****************************************************************************/
+void ConfRoomTests::destroyWithMembers()
+{
+    std::cout << "\n=== CONF ROOM TEST: destroyWithMembers ===\n";
+
+    LoopbackCall lc;
+    start_call(lc, port);
+
+    int room_id = ep.confRoomCreate(ConfRoomConfig());
+    lc.caller->setConfRoom(room_id);
+    lc.callee->setConfRoom(room_id);
+    check_room_clocks(*lc.callee);
+
+    ep.confRoomDestroy(room_id);
+    check_in_main_bridge(*lc.caller);
+    check_in_main_bridge(*lc.callee);
+
+    /* The room can't be used anymore */
+    {
+        bool failed = false;
+        try {
+            lc.caller->setConfRoom(room_id);
+        } catch (Error &err) {
+            failed = true;
+        }
+        TEST_ASSERT(failed);
+        check_in_main_bridge(*lc.caller);
+    }
+    pjsua_handle_events(100);
+
+    end_call(lc);
+
+    std::cout << "  destroyWithMembers: PASSED\n";
+}
+
+
+/*****************************************************************************
+ * Test 3: hangupInRoom
+ *
+ * The call is hung up while both sides are in the room, the room must
+ * release them and stay usable.
+ *****************************************************************************/
+void ConfRoomTests::hangupInRoom()
+{
+    std::cout << "\n=== CONF ROOM TEST: hangupInRoom ===\n";
+
+    int room_id = ep.confRoomCreate(ConfRoomConfig());
+
+    LoopbackCall lc;
+    start_call(lc, port);
+    lc.caller->setConfRoom(room_id);
+    lc.callee->setConfRoom(room_id);
+    pjsua_handle_events(100);
+    end_call(lc);
+
+    /* A new call can join the room */
+    start_call(lc, port);
+    lc.caller->setConfRoom(room_id);
+    check_in_room(*lc.caller, room_id);
+    check_room_clocks(*lc.caller);
+    end_call(lc);
+
+    ep.confRoomDestroy(room_id);
+
+    std::cout << "  hangupInRoom: PASSED\n";
+}
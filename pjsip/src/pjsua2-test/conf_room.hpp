@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2025 Teluu Inc. (http://www.teluu.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef CONF_ROOM_TESTS_HPP
+#define CONF_ROOM_TESTS_HPP
+
+#include <pjsua2.hpp>
+#include <memory>
+
+using namespace pj;
+
+class ConfRoomTests
+{
+public:
+    ConfRoomTests();
+    ConfRoomTests(const ConfRoomTests&) = delete;
+    ConfRoomTests& operator=(const ConfRoomTests&) = delete;
+    ~ConfRoomTests();
+
+    void moveToRoomAndBack();
+    void destroyWithMembers();
+    void hangupInRoom();
+
+private:
+    Endpoint ep;
+    pj_uint16_t port;
+};
+
+#endif // CONF_ROOM_TESTS_HPP
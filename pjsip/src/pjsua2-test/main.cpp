@@ -19,6 +19,7 @@
 #include <pjsua2/endpoint.hpp>
 #include "instant_messaging.hpp"
 #include "auth_challenge.hpp"
+#include "conf_room.hpp"
 
 using namespace pj;
 
@@ -41,6 +42,14 @@ int main(int argc, char *argv[])
             authChallengeTests.deferredAbandon();
             authChallengeTests.accountDeleteWithPending();
         }
+
+        {
+            ConfRoomTests confRoomTests;
+
+            confRoomTests.moveToRoomAndBack();
+            confRoomTests.destroyWithMembers();
+            confRoomTests.hangupInRoom();
+        }
     } catch (...) {
         return 1;
     }
@@ -590,6 +590,16 @@ bool Call::hasMedia() const
     return (pjsua_call_has_media(id) != 0);
 }
 
+void Call::setConfRoom(int room_id) PJSUA2_THROW(Error)
+{
+    PJSUA2_CHECK_EXPR( pjsua_call_set_conf_room(id, room_id) );
+}
+
+int Call::getConfRoom() const
+{
+    return pjsua_call_get_conf_room(id);
+}
+
 Media *Call::getMedia(unsigned med_idx) const
 {
     /* Check if the media index is valid and if the media has a valid port ID */
@@ -313,6 +313,8 @@ void UaConfig::fromPj(const pjsua_config &ua_cfg)
 
     this->maxCalls = ua_cfg.max_calls;
     this->threadCnt = ua_cfg.thread_cnt;
+    this->timerHeapPerThread = PJ2BOOL(ua_cfg.timer_heap_per_thread);
+    this->rxWorkerCnt = ua_cfg.rx_worker_cnt;
     this->userAgent = pj2Str(ua_cfg.user_agent);
 
     for (i=0; i<ua_cfg.nameserver_count; ++i) {
@@ -345,6 +347,8 @@ pjsua_config UaConfig::toPj() const
 
     pua_cfg.max_calls = this->maxCalls;
     pua_cfg.thread_cnt = this->threadCnt;
+    pua_cfg.timer_heap_per_thread = this->timerHeapPerThread;
+    pua_cfg.rx_worker_cnt = this->rxWorkerCnt;
     pua_cfg.user_agent = str2Pj(this->userAgent);
 
     for (i=0; i<this->nameserver.size() && i<PJ_ARRAY_SIZE(pua_cfg.nameserver);
@@ -398,6 +402,8 @@ void UaConfig::readObject(const ContainerNode &node) PJSUA2_THROW(Error)
     NODE_READ_STRING  ( this_node, upnpIfName);
     NODE_READ_BOOL_OPT( this_node, noRefersub);
     NODE_READ_BOOL_OPT( this_node, accServerAffinityDefault);
+    NODE_READ_BOOL_OPT( this_node, timerHeapPerThread);
+    NODE_READ_UNSIGNED_OPT( this_node, rxWorkerCnt);
 }
 
 void UaConfig::writeObject(ContainerNode &node) const PJSUA2_THROW(Error)
@@ -418,6 +424,8 @@ void UaConfig::writeObject(ContainerNode &node) const PJSUA2_THROW(Error)
     NODE_WRITE_STRING  ( this_node, upnpIfName);
     NODE_WRITE_BOOL    ( this_node, noRefersub);
     NODE_WRITE_BOOL    ( this_node, accServerAffinityDefault);
+    NODE_WRITE_BOOL    ( this_node, timerHeapPerThread);
+    NODE_WRITE_UNSIGNED( this_node, rxWorkerCnt);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -500,6 +508,7 @@ void MediaConfig::fromPj(const pjsua_media_config &mc)
     this->audioFramePtime = mc.audio_frame_ptime;
     this->maxMediaPorts = mc.max_media_ports;
     this->confThreads = mc.conf_threads;
+    this->confRoomThreads = mc.conf_room_threads;
     this->hasIoqueue = PJ2BOOL(mc.has_ioqueue);
     this->threadCnt = mc.thread_cnt;
     this->quality = mc.quality;
@@ -534,6 +543,7 @@ pjsua_media_config MediaConfig::toPj() const
     mcfg.audio_frame_ptime = this->audioFramePtime;
     mcfg.max_media_ports = this->maxMediaPorts;
     mcfg.conf_threads = this->confThreads;
+    mcfg.conf_room_threads = this->confRoomThreads;
     mcfg.has_ioqueue = this->hasIoqueue;
     mcfg.thread_cnt = this->threadCnt;
     mcfg.quality = this->quality;
@@ -567,6 +577,7 @@ void MediaConfig::readObject(const ContainerNode &node) PJSUA2_THROW(Error)
     NODE_READ_UNSIGNED( this_node, audioFramePtime);
     NODE_READ_UNSIGNED( this_node, maxMediaPorts);
     NODE_READ_UNSIGNED( this_node, confThreads);
+    NODE_READ_UNSIGNED( this_node, confRoomThreads);
     NODE_READ_BOOL    ( this_node, hasIoqueue);
     NODE_READ_UNSIGNED( this_node, threadCnt);
     NODE_READ_UNSIGNED( this_node, quality);
@@ -599,6 +610,7 @@ void MediaConfig::writeObject(ContainerNode &node) const PJSUA2_THROW(Error)
     NODE_WRITE_UNSIGNED( this_node, audioFramePtime);
     NODE_WRITE_UNSIGNED( this_node, maxMediaPorts);
     NODE_WRITE_UNSIGNED( this_node, confThreads);
+    NODE_WRITE_UNSIGNED( this_node, confRoomThreads);
     NODE_WRITE_BOOL    ( this_node, hasIoqueue);
     NODE_WRITE_UNSIGNED( this_node, threadCnt);
     NODE_WRITE_UNSIGNED( this_node, quality);
@@ -2750,6 +2762,39 @@ unsigned Endpoint::mediaActivePorts() const
     return pjsua_conf_get_active_ports();
 }
 
+ConfRoomConfig::ConfRoomConfig()
+{
+    pjsua_conf_room_config cfg;
+
+    pjsua_conf_room_config_default(&cfg);
+    maxMembers = cfg.max_members;
+    options = cfg.options;
+}
+
+pjsua_conf_room_config ConfRoomConfig::toPj() const
+{
+    pjsua_conf_room_config cfg;
+
+    pjsua_conf_room_config_default(&cfg);
+    cfg.max_members = maxMembers;
+    cfg.options = options;
+    return cfg;
+}
+
+int Endpoint::confRoomCreate(const ConfRoomConfig &cfg) PJSUA2_THROW(Error)
+{
+    pjsua_conf_room_config room_cfg = cfg.toPj();
+    pjsua_conf_room_id room_id;
+
+    PJSUA2_CHECK_EXPR( pjsua_conf_room_create(&room_cfg, &room_id) );
+    return room_id;
+}
+
+void Endpoint::confRoomDestroy(int room_id) PJSUA2_THROW(Error)
+{
+    PJSUA2_CHECK_EXPR( pjsua_conf_room_destroy(room_id) );
+}
+
 #if !DEPRECATED_FOR_TICKET_2232
 const AudioMediaVector &Endpoint::mediaEnumPorts() const PJSUA2_THROW(Error)
 {
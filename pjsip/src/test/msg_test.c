@@ -827,9 +827,13 @@ static pj_status_t simple_test(void)
     char stbuf[] = "SIP/2.0 180 Ringing like it never rings before";
     unsigned i;
     pjsip_status_line st_line;
+    pj_bool_t saved_lazy = pjsip_cfg()->endpt.lazy_hdr_parse;
     pj_status_t status;
 
     PJ_LOG(3,(THIS_FILE, "  simple test.."));
+
+    /* Messages are compared header by header with the reference */
+    pjsip_cfg()->endpt.lazy_hdr_parse = PJ_FALSE;
     
     status = pjsip_parse_status_line(stbuf, pj_ansi_strlen(stbuf), &st_line);
     if (status != PJ_SUCCESS)
@@ -842,10 +846,11 @@ static pj_status_t simple_test(void)
         pjsip_endpt_release_pool(endpt, pool);
 
         if (status != PJ_SUCCESS)
-            return status;
+            break;
     }
 
-    return PJ_SUCCESS;
+    pjsip_cfg()->endpt.lazy_hdr_parse = saved_lazy;
+    return status;
 }
 
 
@@ -858,22 +863,31 @@ static int msg_benchmark(unsigned *p_detect, unsigned *p_parse,
     pj_timestamp zero;
     pj_time_val elapsed;
     pj_highprec_t avg_detect, avg_parse, avg_print, kbytes;
+    pj_bool_t saved_lazy;
     pj_status_t status = PJ_SUCCESS;
 
     pj_bzero(&var, sizeof(var));
     zero.u64 = 0;
 
-    for (loop=0; loop<LOOP; ++loop) {
+    /* Messages are compared header by header with the reference */
+    saved_lazy = pjsip_cfg()->endpt.lazy_hdr_parse;
+    pjsip_cfg()->endpt.lazy_hdr_parse = PJ_FALSE;
+
+    for (loop=0; loop<LOOP && status==PJ_SUCCESS; ++loop) {
         for (i=0; i<(int)PJ_ARRAY_SIZE(test_array); ++i) {
             pool = pjsip_endpt_create_pool(endpt, NULL, POOL_SIZE, POOL_SIZE);
             status = test_entry( pool, &test_array[i] );
             pjsip_endpt_release_pool(endpt, pool);
 
             if (status != PJ_SUCCESS)
-                return status;
+                break;
         }
     }
 
+    pjsip_cfg()->endpt.lazy_hdr_parse = saved_lazy;
+    if (status != PJ_SUCCESS)
+        return status;
+
     kbytes = var.detect_len;
     pj_highprec_mod(kbytes, 1000000);
     pj_highprec_div(kbytes, 100000);
@@ -924,6 +938,66 @@ static int msg_benchmark(unsigned *p_detect, unsigned *p_parse,
     *p_print = (unsigned)avg_print;
     return status;
 }
+
+/* Compare the parsing speed and pool usage of normal and lazy parsing. */
+static int lazy_parse_benchmark(unsigned *p_lazy_parse)
+{
+    pj_bool_t saved_lazy = pjsip_cfg()->endpt.lazy_hdr_parse;
+    pj_timestamp zero;
+    unsigned parse[2], mem[2];
+    int lazy, i, loop;
+    pj_status_t status = PJ_SUCCESS;
+
+    zero.u64 = 0;
+
+    for (lazy=0; lazy<2; ++lazy) {
+        pj_size_t used = 0;
+        unsigned cnt = 0;
+        pj_uint32_t usec;
+
+        pj_bzero(&var, sizeof(var));
+        var.flag = FLAG_PARSE_ONLY;
+        pjsip_cfg()->endpt.lazy_hdr_parse = lazy;
+
+        for (loop=0; loop<LOOP && status==PJ_SUCCESS; ++loop) {
+            for (i=0; i<(int)PJ_ARRAY_SIZE(test_array); ++i) {
+                pj_pool_t *pool;
+                pj_size_t used0;
+
+                pool = pjsip_endpt_create_pool(endpt, NULL, POOL_SIZE,
+                                               POOL_SIZE);
+                used0 = pj_pool_get_used_size(pool);
+                status = test_entry( pool, &test_array[i] );
+                used += pj_pool_get_used_size(pool) - used0;
+                ++cnt;
+                pjsip_endpt_release_pool(endpt, pool);
+
+                if (status != PJ_SUCCESS)
+                    break;
+            }
+        }
+        if (status != PJ_SUCCESS)
+            break;
+
+        usec = pj_elapsed_usec(&zero, &var.parse_time);
+        if (usec == 0) usec = 1;
+        parse[lazy] = (unsigned)((pj_uint64_t)cnt * 1000000 / usec);
+        mem[lazy] = (unsigned)(used / cnt);
+    }
+
+    var.flag = 0;
+    pjsip_cfg()->endpt.lazy_hdr_parse = saved_lazy;
+    if (status != PJ_SUCCESS)
+        return status;
+
+    PJ_LOG(3,(THIS_FILE, "    normal parsing: %u msg/sec, %u bytes/msg",
+              parse[0], mem[0]));
+    PJ_LOG(3,(THIS_FILE, "    lazy parsing  : %u msg/sec, %u bytes/msg",
+              parse[1], mem[1]));
+
+    *p_lazy_parse = parse[1];
+    return PJ_SUCCESS;
+}
 #endif  /* INCLUDE_BENCHMARKS */
 
 /*****************************************************************************/
@@ -2359,6 +2433,400 @@ static int route_hide_lr_test(void)
 }
 
 
+/*****************************************************************************/
+/* Lazy header parsing: unparsed headers must be parsed on first access
+ * and yield the same message as the normal parsing.
+ */
+static int lazy_parse_test(void)
+{
+    static const char msg_text[] =
+        "REGISTER sip:example.com SIP/2.0\r\n"
+        "Via: SIP/2.0/UDP 1.2.3.4:5060;branch=z9hG4bKlazy\r\n"
+        "Max-Forwards: 70\r\n"
+        "From: <sip:alice@example.com>;tag=1234\r\n"
+        "To: <sip:alice@example.com>\r\n"
+        "Call-ID: lazy-parse@1.2.3.4\r\n"
+        "CSeq: 1 REGISTER\r\n"
+        "m: <sip:alice@1.2.3.4>;q=0.5;expires=60,\r\n"
+        " sip:alice@5.6.7.8\r\n"
+        "Authorization: Digest username=\"alice\", realm=\"example.com\", "
+            "nonce=\"abc\", uri=\"sip:example.com\", response=\"def\"\r\n"
+        "X-Custom: some value\r\n"
+        "Expires: notanumber\r\n"
+        "Allow: INVITE, ACK, BYE\r\n"
+        "Content-Length: 0\r\n"
+        "\r\n";
+    const pj_str_t STR_CONTACT = { "Contact", 7 };
+    const pj_str_t STR_ALLOW = { "Allow", 5 };
+    const pj_str_t STR_EXPIRES = { "Expires", 7 };
+    pj_bool_t saved_lazy = pjsip_cfg()->endpt.lazy_hdr_parse;
+    pj_pool_t *pool;
+    char buf[sizeof(msg_text)];
+    pjsip_parser_err_report err_list;
+    pjsip_msg *lazy_msg, *clone_msg, *ref_msg = NULL;
+    pjsip_hdr *hdr;
+    pjsip_contact_hdr *contact;
+    char print1[PJSIP_MAX_PKT_LEN], print2[PJSIP_MAX_PKT_LEN];
+    pj_ssize_t len1, len2;
+    pj_size_t used;
+    unsigned lazy_cnt;
+    int rc = 0;
+
+    PJ_LOG(3,(THIS_FILE, "  lazy header parsing test.."));
+
+    pool = pjsip_endpt_create_pool(endpt, NULL, POOL_SIZE, POOL_SIZE);
+
+    pjsip_cfg()->endpt.lazy_hdr_parse = PJ_TRUE;
+    pj_memcpy(buf, msg_text, sizeof(msg_text));
+    pj_list_init(&err_list);
+    lazy_msg = pjsip_parse_msg(pool, buf, sizeof(msg_text)-1, &err_list);
+    if (!lazy_msg || !pj_list_empty(&err_list)) {
+        PJ_LOG(3,(THIS_FILE, "   error: lazy parsing failed"));
+        rc = -900;
+        goto on_return;
+    }
+
+    /* Contact, Authorization, Expires and Allow must be unparsed */
+    for (hdr=lazy_msg->hdr.next, lazy_cnt=0; hdr!=&lazy_msg->hdr;
+         hdr=hdr->next)
+    {
+        if (pjsip_hdr_is_lazy(hdr))
+            ++lazy_cnt;
+    }
+    if (lazy_cnt != 4) {
+        PJ_LOG(3,(THIS_FILE, "   error: expecting 4 unparsed headers, "
+                             "got %d", lazy_cnt));
+        rc = -910;
+        goto on_return;
+    }
+
+    /* Clone while the headers are still unparsed */
+    clone_msg = pjsip_msg_clone(pool, lazy_msg);
+
+    /* Searching Contact parses both contacts of the short form header */
+    contact = (pjsip_contact_hdr*)
+              pjsip_msg_find_hdr(lazy_msg, PJSIP_H_CONTACT, NULL);
+    if (!contact || pjsip_hdr_is_lazy(contact) || contact->q1000 != 500 ||
+        contact->expires != 60)
+    {
+        PJ_LOG(3,(THIS_FILE, "   error: Contact is not parsed properly"));
+        rc = -920;
+        goto on_return;
+    }
+    if (!pjsip_msg_find_hdr(lazy_msg, PJSIP_H_CONTACT, contact->next)) {
+        PJ_LOG(3,(THIS_FILE, "   error: second Contact not found"));
+        rc = -930;
+        goto on_return;
+    }
+
+    /* Malformed header is not found, and is kept as a generic string
+     * header which is not parsed again.
+     */
+    if (pjsip_msg_find_hdr(lazy_msg, PJSIP_H_EXPIRES, NULL)) {
+        PJ_LOG(3,(THIS_FILE, "   error: malformed Expires is found"));
+        rc = -940;
+        goto on_return;
+    }
+    used = pj_pool_get_used_size(pool);
+    hdr = (pjsip_hdr*) pjsip_msg_find_hdr_by_name(lazy_msg, &STR_EXPIRES,
+                                                  NULL);
+    if (!hdr || pjsip_hdr_is_lazy(hdr) || hdr->type != PJSIP_H_OTHER) {
+        PJ_LOG(3,(THIS_FILE, "   error: malformed Expires is not kept as "
+                             "generic header"));
+        rc = -942;
+        goto on_return;
+    }
+    if (pjsip_msg_find_hdr(lazy_msg, PJSIP_H_EXPIRES, NULL) ||
+        pj_pool_get_used_size(pool) != used)
+    {
+        PJ_LOG(3,(THIS_FILE, "   error: malformed Expires is parsed again"));
+        rc = -944;
+        goto on_return;
+    }
+
+    /* Searching by name parses the header too */
+    hdr = (pjsip_hdr*) pjsip_msg_find_hdr_by_name(lazy_msg, &STR_ALLOW, NULL);
+    if (!hdr || hdr->type != PJSIP_H_ALLOW ||
+        ((pjsip_allow_hdr*)hdr)->count != 3)
+    {
+        PJ_LOG(3,(THIS_FILE, "   error: Allow is not parsed properly"));
+        rc = -950;
+        goto on_return;
+    }
+    if (!pjsip_msg_find_hdr(lazy_msg, PJSIP_H_AUTHORIZATION, NULL)) {
+        PJ_LOG(3,(THIS_FILE, "   error: Authorization is not found"));
+        rc = -960;
+        goto on_return;
+    }
+
+    /* The cloned message must be searchable too */
+    hdr = (pjsip_hdr*) pjsip_msg_find_hdr_by_name(clone_msg, &STR_CONTACT,
+                                                  NULL);
+    if (!hdr || hdr->type != PJSIP_H_CONTACT) {
+        PJ_LOG(3,(THIS_FILE, "   error: cloned Contact is not parsed"));
+        rc = -970;
+        goto on_return;
+    }
+
+    /* Once all searched, the message must print the same as when it's
+     * parsed normally (except the malformed Expires which is dropped).
+     */
+    pjsip_cfg()->endpt.lazy_hdr_parse = PJ_FALSE;
+    pj_memcpy(buf, msg_text, sizeof(msg_text));
+    pj_list_init(&err_list);
+    ref_msg = pjsip_parse_msg(pool, buf, sizeof(msg_text)-1, &err_list);
+    if (!ref_msg) {
+        rc = -980;
+        goto on_return;
+    }
+    hdr = (pjsip_hdr*) pjsip_msg_find_hdr_by_name(lazy_msg, &STR_EXPIRES,
+                                                  NULL);
+    if (hdr)
+        pj_list_erase(hdr);
+
+    len1 = pjsip_msg_print(lazy_msg, print1, sizeof(print1));
+    len2 = pjsip_msg_print(ref_msg, print2, sizeof(print2));
+    if (len1 < 0 || len1 != len2 || pj_memcmp(print1, print2, len1) != 0) {
+        PJ_LOG(3,(THIS_FILE, "   error: lazily parsed message differs"));
+        rc = -990;
+        goto on_return;
+    }
+
+on_return:
+    pjsip_cfg()->endpt.lazy_hdr_parse = saved_lazy;
+    pjsip_endpt_release_pool(endpt, pool);
+    return rc;
+}
+
+
+/*****************************************************************************/
+/*
+ * Header print cache test.
+ */
+static pjsip_msg *create_cache_test_msg(pj_pool_t *pool)
+{
+    static const char *methods[] = { "INVITE", "ACK", "BYE", "CANCEL",
+                                     "OPTIONS", "PRACK", "UPDATE", "INFO",
+                                     "MESSAGE", "SUBSCRIBE", "NOTIFY",
+                                     "REFER", "PUBLISH" };
+    const pj_str_t STR_UA = { "User-Agent", 10 };
+    const pj_str_t STR_UA_VAL = { "PJSUA v2.x Linux-6.0/x86_64/glibc-2.36",
+                                  38 };
+    pjsip_msg *msg;
+    pjsip_allow_hdr *allow;
+    pjsip_supported_hdr *sup;
+    pjsip_accept_hdr *accept;
+    pjsip_contact_hdr *contact;
+    pjsip_cid_hdr *cid;
+    pjsip_name_addr *name_addr;
+    pjsip_sip_uri *uri;
+    pjsip_via_hdr *via;
+    unsigned i;
+
+    msg = pjsip_msg_create(pool, PJSIP_REQUEST_MSG);
+    pjsip_method_set(&msg->line.req.method, PJSIP_OPTIONS_METHOD);
+    uri = pjsip_sip_uri_create(pool, PJ_FALSE);
+    uri->host = pj_str("example.com");
+    msg->line.req.uri = (pjsip_uri*)uri;
+
+    via = pjsip_via_hdr_create(pool);
+    via->transport = pj_str("UDP");
+    via->sent_by.host = pj_str("192.168.0.1");
+    via->sent_by.port = 5060;
+    via->branch_param = pj_str("z9hG4bKcachetest");
+    pjsip_msg_add_hdr(msg, (pjsip_hdr*)via);
+
+    pjsip_msg_add_hdr(msg, (pjsip_hdr*)pjsip_max_fwd_hdr_create(pool, 70));
+
+    cid = pjsip_cid_hdr_create(pool);
+    cid->id = pj_str("cache-test@192.168.0.1");
+    pjsip_msg_add_hdr(msg, (pjsip_hdr*)cid);
+
+    contact = pjsip_contact_hdr_create(pool);
+    name_addr = pjsip_name_addr_create(pool);
+    uri = pjsip_sip_uri_create(pool, PJ_FALSE);
+    uri->user = pj_str("alice");
+    uri->host = pj_str("192.168.0.1");
+    uri->port = 5060;
+    uri->transport_param = pj_str("udp");
+    name_addr->uri = (pjsip_uri*)uri;
+    contact->uri = (pjsip_uri*)name_addr;
+    contact->expires = 300;
+    pjsip_msg_add_hdr(msg, (pjsip_hdr*)contact);
+
+    allow = pjsip_allow_hdr_create(pool);
+    for (i=0; i<PJ_ARRAY_SIZE(methods); ++i)
+        allow->values[allow->count++] = pj_str((char*)methods[i]);
+    pjsip_msg_add_hdr(msg, (pjsip_hdr*)allow);
+
+    sup = pjsip_supported_hdr_create(pool);
+    sup->values[sup->count++] = pj_str("replaces");
+    sup->values[sup->count++] = pj_str("100rel");
+    sup->values[sup->count++] = pj_str("timer");
+    sup->values[sup->count++] = pj_str("norefersub");
+    pjsip_msg_add_hdr(msg, (pjsip_hdr*)sup);
+
+    accept = pjsip_accept_hdr_create(pool);
+    accept->values[accept->count++] = pj_str("application/sdp");
+    accept->values[accept->count++] = pj_str("application/pidf+xml");
+    accept->values[accept->count++] = pj_str("message/sipfrag");
+    pjsip_msg_add_hdr(msg, (pjsip_hdr*)accept);
+
+    pjsip_msg_add_hdr(msg, (pjsip_hdr*)
+                      pjsip_generic_string_hdr_create(pool, &STR_UA,
+                                                      &STR_UA_VAL));
+    return msg;
+}
+
+/* Cache the printed value of the headers which don't change per request */
+static pj_status_t cache_msg_hdrs(pj_pool_t *pool, pjsip_msg *msg)
+{
+    pjsip_hdr *hdr;
+
+    for (hdr=msg->hdr.next; hdr!=&msg->hdr; hdr=hdr->next) {
+        if (hdr->type == PJSIP_H_VIA || hdr->type == PJSIP_H_CALL_ID)
+            continue;
+        if (pjsip_hdr_cache_print(pool, hdr) != PJ_SUCCESS)
+            return PJ_EBUG;
+    }
+    return PJ_SUCCESS;
+}
+
+static int hdr_cache_test(void)
+{
+    const char *SUP_PRINTED = "Supported: replaces, 100rel, timer";
+    const pj_bool_t saved_compact = pjsip_cfg()->endpt.use_compact_form;
+    pj_pool_t *pool;
+    pjsip_msg *msg, *ref_msg;
+    pjsip_supported_hdr *sup, *sup2;
+    const pjsip_hdr *cap;
+    char print1[PJSIP_MAX_PKT_LEN], print2[PJSIP_MAX_PKT_LEN];
+    pj_ssize_t len1, len2;
+    int compact, rc = 0;
+
+    PJ_LOG(3,(THIS_FILE, "  header print cache test.."));
+
+    pool = pjsip_endpt_create_pool(endpt, NULL, POOL_SIZE, POOL_SIZE);
+
+    ref_msg = create_cache_test_msg(pool);
+    msg = create_cache_test_msg(pool);
+    if (cache_msg_hdrs(pool, msg) != PJ_SUCCESS) {
+        rc = -1000;
+        goto on_return;
+    }
+
+    /* Cached message must print the same, in both normal and compact form */
+    for (compact=0; compact<2; ++compact) {
+        pjsip_cfg()->endpt.use_compact_form = compact;
+        len1 = pjsip_msg_print(msg, print1, sizeof(print1));
+        len2 = pjsip_msg_print(ref_msg, print2, sizeof(print2));
+        if (len1 < 0 || len1 != len2 || pj_memcmp(print1, print2, len1)) {
+            PJ_LOG(3,(THIS_FILE, "   error: cached message differs "
+                                 "(compact=%d)", compact));
+            rc = -1010;
+            goto on_return;
+        }
+    }
+    pjsip_cfg()->endpt.use_compact_form = saved_compact;
+
+    /* Shallow clone shares the cache, full clone doesn't */
+    sup = (pjsip_supported_hdr*)
+          pjsip_msg_find_hdr(msg, PJSIP_H_SUPPORTED, NULL);
+    sup2 = (pjsip_supported_hdr*) pjsip_hdr_shallow_clone(pool, sup);
+    if (sup2->print_cache != sup->print_cache) {
+        rc = -1020;
+        goto on_return;
+    }
+    if (((pjsip_hdr*)pjsip_hdr_clone(pool, sup))->print_cache != NULL) {
+        rc = -1030;
+        goto on_return;
+    }
+
+    /* Modified header prints its new value once the cache is invalidated */
+    --sup2->count;
+    pjsip_hdr_invalidate_cache(sup2);
+    len1 = pjsip_hdr_print_on(sup2, print1, sizeof(print1));
+    len2 = pj_ansi_strlen(SUP_PRINTED);
+    if (len1 != len2 || pj_memcmp(print1, SUP_PRINTED, len1) != 0) {
+        PJ_LOG(3,(THIS_FILE, "   error: invalidated cache is still used"));
+        rc = -1040;
+        goto on_return;
+    }
+
+    /* Too small buffer */
+    if (pjsip_hdr_print_on(sup, print1, 20) != -1) {
+        rc = -1050;
+        goto on_return;
+    }
+
+#if PJSIP_CACHE_CAPABILITY_HDR
+    /* Endpoint capability headers are cached */
+    cap = pjsip_endpt_get_capability(endpt, PJSIP_H_ALLOW, NULL);
+    if (cap && cap->print_cache == NULL) {
+        PJ_LOG(3,(THIS_FILE, "   error: Allow capability is not cached"));
+        rc = -1060;
+        goto on_return;
+    }
+#else
+    PJ_UNUSED_ARG(cap);
+#endif
+
+on_return:
+    pjsip_cfg()->endpt.use_compact_form = saved_compact;
+    pjsip_endpt_release_pool(endpt, pool);
+    return rc;
+}
+
+#if INCLUDE_BENCHMARKS
+static int hdr_cache_benchmark(unsigned *p_cached_print)
+{
+    pj_pool_t *pool;
+    pjsip_msg *msg;
+    char *buf;
+    unsigned print[2];
+    int cached, loop;
+    pj_status_t status = PJ_SUCCESS;
+
+    pool = pjsip_endpt_create_pool(endpt, NULL, POOL_SIZE, POOL_SIZE);
+    buf = (char*) pj_pool_alloc(pool, PJSIP_MAX_PKT_LEN);
+    msg = create_cache_test_msg(pool);
+
+    for (cached=0; cached<2; ++cached) {
+        pj_timestamp t1, t2;
+        pj_uint32_t usec;
+
+        if (cached) {
+            status = cache_msg_hdrs(pool, msg);
+            if (status != PJ_SUCCESS)
+                break;
+        }
+
+        pj_get_timestamp(&t1);
+        for (loop=0; loop<LOOP; ++loop) {
+            if (pjsip_msg_print(msg, buf, PJSIP_MAX_PKT_LEN) < 0) {
+                status = PJSIP_EMSGTOOLONG;
+                break;
+            }
+        }
+        pj_get_timestamp(&t2);
+
+        usec = pj_elapsed_usec(&t1, &t2);
+        if (usec == 0) usec = 1;
+        print[cached] = (unsigned)((pj_uint64_t)LOOP * 1000000 / usec);
+    }
+
+    pjsip_endpt_release_pool(endpt, pool);
+    if (status != PJ_SUCCESS)
+        return status;
+
+    PJ_LOG(3,(THIS_FILE, "    normal print: %u msg/sec", print[0]));
+    PJ_LOG(3,(THIS_FILE, "    cached print: %u msg/sec", print[1]));
+
+    *p_cached_print = print[1];
+    return PJ_SUCCESS;
+}
+#endif  /* INCLUDE_BENCHMARKS */
+
 /*****************************************************************************/
 
 int msg_test(void)
@@ -2389,6 +2857,14 @@ int msg_test(void)
     if (status != PJ_SUCCESS)
         return status;
 
+    status = lazy_parse_test();
+    if (status != PJ_SUCCESS)
+        return status;
+
+    status = hdr_cache_test();
+    if (status != PJ_SUCCESS)
+        return status;
+
 #if INCLUDE_BENCHMARKS
     for (i=0; i<COUNT; ++i) {
         PJ_LOG(3,(THIS_FILE, "  benchmarking (%d of %d)..", i+1, COUNT));
@@ -2460,6 +2936,33 @@ int msg_test(void)
                 "SIP messages printed per second). "
                 "The value is derived from msg-print-per-sec above.");
 
+    /* Lazy header parsing */
+    PJ_LOG(3,(THIS_FILE, "  benchmarking lazy header parsing.."));
+    status = lazy_parse_benchmark(&max);
+    if (status != PJ_SUCCESS)
+        return status;
+
+    pj_ansi_snprintf(desc, sizeof(desc),
+                          "Number of SIP messages "
+                          "can be parsed by <tt>pjsip_parse_msg()</tt> "
+                          "per second with lazy header parsing enabled "
+                          "(tested with %d message sets with "
+                          "average message length of "
+                          "%d bytes)", (int)PJ_ARRAY_SIZE(test_array), avg_len);
+    report_ival("msg-lazy-parse-per-sec", max, "msg/sec", desc);
+
+    /* Header print cache */
+    PJ_LOG(3,(THIS_FILE, "  benchmarking header print cache.."));
+    status = hdr_cache_benchmark(&max);
+    if (status != PJ_SUCCESS)
+        return status;
+
+    report_ival("msg-cached-print-per-sec", max, "msg/sec",
+                "Number of OPTIONS requests can be printed by "
+                "<tt>pjsip_msg_print()</tt> per second when the headers "
+                "other than Via and Call-ID have their printed value "
+                "cached with <tt>pjsip_hdr_cache_print()</tt>");
+
 #endif  /* INCLUDE_BENCHMARKS */
 
     return PJ_SUCCESS;
@@ -401,6 +401,14 @@ int test_main(int argc, char *argv[])
                 PJ_TEST_EXCLUSIVE | PJ_TEST_KEEP_LAST);
 #endif
 
+    /* This needs to be exclusive, because the SIP worker threads would
+     * process the messages of the other tests too.
+     */
+#if INCLUDE_LOOP_TEST
+    UT_ADD_TEST(&test_app.ut_app, transport_loop_rx_worker_test,
+                PJ_TEST_EXCLUSIVE | PJ_TEST_KEEP_LAST);
+#endif
+
     /* This needs to be exclusive, because there must NOT be any other
      * loop transport otherwise some test will fail (e.g. sending will
      * fallback to that transport)
@@ -109,6 +109,7 @@ int transport_udp_test(void);
 int transport_loop_test(void);
 int transport_loop_multi_test(void);
 int transport_loop_resolve_error_test(void);
+int transport_loop_rx_worker_test(void);
 int transport_tcp_test(void);
 int transport_tcp_keep_alive_test(void);
 int resolve_test(void);
@@ -175,6 +175,199 @@ on_return:
 #undef ERR
 }
 
+/*
+ * SIP rx worker test: requests of several Call-IDs are handed off to the
+ * SIP worker threads, and must be processed in order, each Call-ID by a
+ * single worker.
+ */
+enum { RXW_CALLS = 8, RXW_CSEQS = 32 };
+
+static struct rxw_state
+{
+    pj_mutex_t      *mutex;
+    pj_thread_t     *sender;
+    int              count;
+    int              in_sender;
+    int              status;
+    int              last_cseq[RXW_CALLS];
+    pj_thread_t     *thread[RXW_CALLS];
+} rxw;
+
+static pj_bool_t rxw_on_rx_request(pjsip_rx_data *rdata)
+{
+    const pj_str_t *cid = &rdata->msg_info.cid->id;
+    unsigned call;
+    int cseq;
+
+    if (!is_user_equal(rdata->msg_info.from, "transport_loop_rxw_test"))
+        return PJ_FALSE;
+
+    call = (unsigned)(cid->ptr[cid->slen-1] - '0');
+    cseq = rdata->msg_info.cseq->cseq;
+
+    pj_mutex_lock(rxw.mutex);
+    if (pj_thread_this() == rxw.sender) {
+        ++rxw.in_sender;
+    } else if (call >= RXW_CALLS) {
+        rxw.status = -300;
+    } else {
+        /* Requests of a Call-ID are processed in order */
+        if (cseq != rxw.last_cseq[call] + 1)
+            rxw.status = -310;
+        rxw.last_cseq[call] = cseq;
+
+        /* ..and by the same worker */
+        if (rxw.thread[call] == NULL)
+            rxw.thread[call] = pj_thread_this();
+        else if (rxw.thread[call] != pj_thread_this())
+            rxw.status = -320;
+    }
+    ++rxw.count;
+    pj_mutex_unlock(rxw.mutex);
+
+    return PJ_TRUE;
+}
+
+static pjsip_module rxw_tester_mod =
+{
+    NULL, NULL,                         /* prev and next        */
+    { "transport_rxw_test", 18},        /* Name.                */
+    -1,                                 /* Id                   */
+    PJSIP_MOD_PRIORITY_UA_PROXY_LAYER-1,/* Priority             */
+    NULL,                               /* load()               */
+    NULL,                               /* start()              */
+    NULL,                               /* stop()               */
+    NULL,                               /* unload()             */
+    &rxw_on_rx_request,                 /* on_rx_request()      */
+    NULL,                               /* on_rx_response()     */
+    NULL,                               /* on_tx_request()      */
+    NULL,                               /* on_tx_response()     */
+    NULL,                               /* on_tsx_state()       */
+};
+
+static pj_status_t rxw_send(pjsip_transport *loop, unsigned call, int cseq)
+{
+    pj_str_t url = pj_str("sip:transport_loop_rxw_test@127.0.0.1");
+    char cid_buf[16];
+    pj_str_t cid;
+    pjsip_tpselector tp_sel;
+    pjsip_tx_data *tdata;
+    pj_status_t status;
+
+    cid.ptr = cid_buf;
+    cid.slen = pj_ansi_snprintf(cid_buf, sizeof(cid_buf), "rxw-%u", call);
+
+    status = pjsip_endpt_create_request(endpt, &pjsip_options_method,
+                                        &url, &url, &url, NULL, &cid, cseq,
+                                        NULL, &tdata);
+    if (status != PJ_SUCCESS)
+        return status;
+
+    pj_bzero(&tp_sel, sizeof(tp_sel));
+    tp_sel.type = PJSIP_TPSELECTOR_TRANSPORT;
+    tp_sel.u.transport = loop;
+    pjsip_tx_data_set_transport(tdata, &tp_sel);
+
+    return pjsip_endpt_send_request_stateless(endpt, tdata, NULL, NULL);
+}
+
+/* Wait until the module has received the specified number of requests */
+static int rxw_wait(int count)
+{
+    enum { TIMEOUT = 5000 };
+    pj_time_val timeout, now;
+    int received;
+
+    pj_gettimeofday(&timeout);
+    now = timeout;
+    timeout.msec += TIMEOUT;
+    pj_time_val_normalize(&timeout);
+
+    for (;;) {
+        pj_mutex_lock(rxw.mutex);
+        received = rxw.count;
+        pj_mutex_unlock(rxw.mutex);
+
+        if (received >= count || !PJ_TIME_VAL_LT(now, timeout))
+            break;
+
+        pj_thread_sleep(10);
+        pj_gettimeofday(&now);
+    }
+
+    return received;
+}
+
+int transport_loop_rx_worker_test(void)
+{
+#define ERR(rc__)   { rc=rc__; goto on_return; }
+    pj_pool_t *pool;
+    pjsip_transport *loop = NULL;
+    pjsip_rx_worker_param prm;
+    unsigned call;
+    int cseq, rc;
+
+    pj_bzero(&rxw, sizeof(rxw));
+    rxw.sender = pj_thread_this();
+
+    pool = pjsip_endpt_create_pool(endpt, "rxw", 512, 512);
+    PJ_TEST_NOT_NULL(pool, NULL, return -200);
+    PJ_TEST_SUCCESS(pj_mutex_create_simple(pool, "rxw", &rxw.mutex),
+                    NULL, ERR(-205));
+
+    PJ_TEST_SUCCESS(pjsip_endpt_register_module(endpt, &rxw_tester_mod),
+                    NULL, ERR(-210));
+    PJ_TEST_SUCCESS(pjsip_loop_start(endpt, &loop), NULL, ERR(-215));
+    pjsip_transport_add_ref(loop);
+    pjsip_loop_set_delay(loop, 0);
+
+    pjsip_rx_worker_param_default(&prm);
+    prm.worker_cnt = 4;
+    PJ_TEST_SUCCESS(pjsip_endpt_start_rx_workers(endpt, &prm),
+                    NULL, ERR(-220));
+    PJ_TEST_EQ(pjsip_endpt_start_rx_workers(endpt, &prm), PJ_EEXISTS,
+               NULL, ERR(-225));
+
+    /* Interleave the requests of the Call-IDs */
+    for (cseq=1; cseq<=RXW_CSEQS; ++cseq) {
+        for (call=0; call<RXW_CALLS; ++call) {
+            PJ_TEST_SUCCESS(rxw_send(loop, call, cseq), NULL, ERR(-230));
+        }
+    }
+
+    PJ_TEST_EQ(rxw_wait(RXW_CALLS * RXW_CSEQS), RXW_CALLS * RXW_CSEQS,
+               "timed-out waiting for requests", ERR(-235));
+    PJ_TEST_EQ(rxw.in_sender, 0, "request processed by the sender thread",
+               ERR(-240));
+    PJ_TEST_EQ(rxw.status, 0, NULL, ERR(rxw.status));
+
+    /* After the workers are stopped, the receiving thread processes
+     * the requests again.
+     */
+    PJ_TEST_SUCCESS(pjsip_endpt_stop_rx_workers(endpt), NULL, ERR(-250));
+    PJ_TEST_SUCCESS(rxw_send(loop, 0, RXW_CSEQS+1), NULL, ERR(-255));
+    PJ_TEST_EQ(rxw.in_sender, 1, "request not processed in place",
+               ERR(-260));
+
+    rc = 0;
+
+on_return:
+    pjsip_endpt_stop_rx_workers(endpt);
+    if (loop) {
+        pjsip_transport_shutdown(loop);
+        pjsip_transport_dec_ref(loop);
+    }
+    if (rxw_tester_mod.id != -1) {
+        pjsip_endpt_unregister_module(endpt, &rxw_tester_mod);
+    }
+    if (rxw.mutex)
+        pj_mutex_destroy(rxw.mutex);
+    pjsip_endpt_release_pool(endpt, pool);
+    flush_events(500);
+    return rc;
+#undef ERR
+}
+
 static void send_cb(pjsip_send_state *st, pj_ssize_t sent, pj_bool_t *cont)
 {
     int *loop_resolve_status = (int*)st->token;
@@ -45,9 +45,19 @@ static pj_status_t multi_transport_test(pjsip_transport *tp[], unsigned max_tp)
 
         pj_sockaddr_in_init(&addr, NULL, (pj_uint16_t)(TEST_UDP_PORT+i));
 
-        /* Start UDP transport. */
-        PJ_TEST_SUCCESS(pjsip_udp_transport_start( endpt, &addr, NULL, 1, &udp_tp),
-                        NULL, ERR(-110));
+        /* Start UDP transport. The last one uses batched receive. */
+        if (i == max_tp-1) {
+            pjsip_udp_transport_cfg cfg;
+
+            pjsip_udp_transport_cfg_default(&cfg, pj_AF_INET());
+            pj_sockaddr_cp(&cfg.bind_addr, &addr);
+            cfg.recv_batch_cnt = 8;
+            PJ_TEST_SUCCESS(pjsip_udp_transport_start2(endpt, &cfg, &udp_tp),
+                            NULL, ERR(-115));
+        } else {
+            PJ_TEST_SUCCESS(pjsip_udp_transport_start( endpt, &addr, NULL, 1, &udp_tp),
+                            NULL, ERR(-110));
+        }
 
         /* UDP transport must have initial reference counter set to 1. */
         PJ_TEST_EQ(pj_atomic_get(udp_tp->ref_cnt), 1, NULL, ERR(-120));
@@ -118,6 +128,120 @@ on_return:
 #undef ERR
 }
 
+/*
+ * Burst test for the batched receive transport: requests are queued in the
+ * socket faster than they are polled, so that each wakeup drains several
+ * datagrams, the receive ring is reused and the read is re-armed.
+ */
+#define BURST_USER      "udp_burst_test"
+#define BURST_CNT       64
+
+static struct
+{
+    pjsip_transport *rx_tp;
+    pj_sockaddr_in   src_addr;
+    int              recv_cnt;
+    int              err_cnt;
+} burst;
+
+static pj_bool_t burst_on_rx_request(pjsip_rx_data *rdata)
+{
+    if (!is_user_equal(rdata->msg_info.from, BURST_USER))
+        return PJ_FALSE;
+
+    /* Must arrive on the batched transport, in order, from the sender */
+    if (rdata->tp_info.transport != burst.rx_tp ||
+        rdata->msg_info.cseq->cseq != burst.recv_cnt + 1 ||
+        pj_sockaddr_cmp(&rdata->pkt_info.src_addr, &burst.src_addr) != 0)
+    {
+        PJ_LOG(3,(THIS_FILE, "    burst request %d: unexpected CSeq %d "
+                  "or source %s:%d", burst.recv_cnt + 1,
+                  rdata->msg_info.cseq->cseq, rdata->pkt_info.src_name,
+                  rdata->pkt_info.src_port));
+        ++burst.err_cnt;
+    }
+    ++burst.recv_cnt;
+
+    return PJ_TRUE;
+}
+
+static pjsip_module burst_module =
+{
+    NULL, NULL,                         /* prev and next        */
+    { "UDP-Burst-Test", 14},            /* Name.                */
+    -1,                                 /* Id                   */
+    PJSIP_MOD_PRIORITY_TSX_LAYER-1,     /* Priority             */
+    NULL,                               /* load()               */
+    NULL,                               /* start()              */
+    NULL,                               /* stop()               */
+    NULL,                               /* unload()             */
+    &burst_on_rx_request,               /* on_rx_request()      */
+    NULL,                               /* on_rx_response()     */
+    NULL,                               /* on_tsx_state()       */
+};
+
+static int burst_recv_test(pjsip_transport *tx_tp, pjsip_transport *rx_tp,
+                           const char *host_port)
+{
+    pj_str_t target, from, call_id;
+    pjsip_tpselector tp_sel;
+    pj_time_val timeout, now;
+    char target_buf[64];
+    int i, rc = 0;
+
+    PJ_LOG(3,(THIS_FILE, "  burst of %d requests to batched transport",
+              BURST_CNT));
+
+    pj_bzero(&burst, sizeof(burst));
+    burst.rx_tp = rx_tp;
+    pj_sockaddr_in_init(&burst.src_addr, pj_cstr(&target, "127.0.0.1"),
+                        pj_sockaddr_get_port(&tx_tp->local_addr));
+
+    PJ_TEST_SUCCESS(pjsip_endpt_register_module(endpt, &burst_module),
+                    NULL, return -300);
+
+    pj_ansi_snprintf(target_buf, sizeof(target_buf), "sip:%s", host_port);
+    target = pj_str(target_buf);
+    from = pj_str("<sip:" BURST_USER "@127.0.0.1>");
+    call_id = pj_str("UDP-Burst-Call-Id");
+
+    pj_bzero(&tp_sel, sizeof(tp_sel));
+    tp_sel.type = PJSIP_TPSELECTOR_TRANSPORT;
+    tp_sel.u.transport = tx_tp;
+
+    /* Send all requests before polling any of them */
+    for (i = 0; i < BURST_CNT; ++i) {
+        pjsip_tx_data *tdata;
+
+        PJ_TEST_SUCCESS(pjsip_endpt_create_request(endpt,
+                                                   &pjsip_options_method,
+                                                   &target, &from, &target,
+                                                   NULL, &call_id, i + 1,
+                                                   NULL, &tdata),
+                        NULL, {rc = -310; goto on_return;});
+        pjsip_tx_data_set_transport(tdata, &tp_sel);
+        PJ_TEST_SUCCESS(pjsip_endpt_send_request_stateless(endpt, tdata,
+                                                           NULL, NULL),
+                        NULL, {rc = -320; goto on_return;});
+    }
+
+    pj_gettickcount(&timeout);
+    timeout.sec += 5;
+    do {
+        pj_time_val poll_delay = { 0, 10 };
+
+        pjsip_endpt_handle_events(endpt, &poll_delay);
+        pj_gettickcount(&now);
+    } while (burst.recv_cnt < BURST_CNT && PJ_TIME_VAL_LT(now, timeout));
+
+    PJ_TEST_EQ(burst.recv_cnt, BURST_CNT, "requests lost", rc = -330);
+    PJ_TEST_EQ(burst.err_cnt, 0, "reordered or corrupt requests", rc = -340);
+
+on_return:
+    pjsip_endpt_unregister_module(endpt, &burst_module);
+    return rc;
+}
+
 /*
  * UDP transport test.
  */
@@ -131,6 +255,7 @@ int transport_udp_test(void)
     pj_status_t status;
     int rtt[SEND_RECV_LOOP], min_rtt;
     int i, pkt_lost;
+    char batch_host_port[32];
 
     status = multi_transport_test(&tp[0], NUM_TP);
     if (status != PJ_SUCCESS)
@@ -155,8 +280,23 @@ int transport_udp_test(void)
                 "(time from sending request until response is received. "
                 "Tests were performed on local machine only)");
 
+    /* Loopback test with the batched receive transport. */
+    pj_ansi_snprintf(batch_host_port, sizeof(batch_host_port),
+                     "127.0.0.1:%d", TEST_UDP_PORT+NUM_TP-1);
+    for (i=0; i<SEND_RECV_LOOP; ++i) {
+        status = transport_send_recv_test(PJSIP_TRANSPORT_UDP, tp[NUM_TP-1],
+                                          batch_host_port, &rtt[i]);
+        if (status != 0)
+            return status;
+    }
+
+    status = burst_recv_test(tp[0], tp[NUM_TP-1], batch_host_port);
+    if (status != 0)
+        return status;
 
-    /* Multi-threaded round-trip test. */
+    /* Multi-threaded round-trip test, on the default and on the batched
+     * receive transport.
+     */
     status = transport_rt_test(PJSIP_TRANSPORT_UDP, tp[0], 
                                "127.0.0.1:"TEST_UDP_PORT_STR, 
                                &pkt_lost);
@@ -166,6 +306,15 @@ int transport_udp_test(void)
     if (pkt_lost != 0)
         PJ_LOG(3,(THIS_FILE, "   note: %d packet(s) was lost", pkt_lost));
 
+    status = transport_rt_test(PJSIP_TRANSPORT_UDP, tp[NUM_TP-1],
+                               batch_host_port, &pkt_lost);
+    if (status != 0)
+        return status;
+
+    if (pkt_lost != 0)
+        PJ_LOG(3,(THIS_FILE, "   note: %d packet(s) was lost on the batched "
+                  "transport", pkt_lost));
+
     for (i = 0; i < NUM_TP; ++i) {
         udp_tp = tp[i];
 
@@ -191,9 +191,139 @@ on_error:
 
 
 
+/*
+ * Multi-threaded transaction lookup benchmark. This measures how well
+ * pjsip_tsx_layer_find_tsx2() scales when several worker threads look up
+ * transactions concurrently.
+ */
+struct lookup_param
+{
+    pj_thread_t        *thread;
+    const pj_str_t     *keys;
+    unsigned            key_cnt;
+    unsigned            start;
+    unsigned            loop;
+    unsigned            found;
+};
+
+static int lookup_thread(void *arg)
+{
+    struct lookup_param *prm = (struct lookup_param*)arg;
+    unsigned i, idx = prm->start;
+
+    for (i=0; i<prm->loop; ++i) {
+        if (pjsip_tsx_layer_find_tsx2(&prm->keys[idx], PJ_FALSE))
+            ++prm->found;
+
+        /* Stride through the working set with a prime step */
+        idx = (idx + 7919) % prm->key_cnt;
+    }
+
+    return 0;
+}
+
+static int lookup_tsx_bench(unsigned working_set, unsigned thread_cnt,
+                            unsigned loop, pj_timestamp *p_elapsed)
+{
+    unsigned i;
+    pj_pool_t *pool;
+    pjsip_tx_data *request;
+    pjsip_transaction **tsx;
+    pj_str_t *keys;
+    struct lookup_param *prm;
+    pj_timestamp t1, t2;
+    pjsip_via_hdr *via;
+    int rc;
+
+    pj_str_t str_target = pj_str("sip:someuser@someprovider.com");
+    pj_str_t str_from = pj_str("\"Local User\" <sip:tsx_bench@serviceprovider.com>");
+    pj_str_t str_to = pj_str("\"Remote User\" <sip:remoteuser@serviceprovider.com>");
+    pj_str_t str_contact = str_from;
+
+    pool = pjsip_endpt_create_pool(endpt, "tsxlookup", 4000, 4000);
+    PJ_TEST_NOT_NULL(pool, NULL, return -310);
+
+    PJ_TEST_SUCCESS(pjsip_endpt_create_request(endpt, &pjsip_invite_method,
+                                        &str_target, &str_from, &str_to,
+                                        &str_contact, NULL, -1, NULL,
+                                        &request),
+                    NULL, { pj_pool_release(pool); return -320; });
+
+    via = (pjsip_via_hdr*) pjsip_msg_find_hdr(request->msg, PJSIP_H_VIA,
+                                              NULL);
+
+    tsx = (pjsip_transaction**) pj_pool_zalloc(pool, working_set *
+                                               sizeof(pjsip_transaction*));
+    keys = (pj_str_t*) pj_pool_zalloc(pool, working_set * sizeof(pj_str_t));
+    prm = (struct lookup_param*) pj_pool_zalloc(pool, thread_cnt *
+                                                sizeof(struct lookup_param));
+
+    pj_bzero(&mod_tsx_user, sizeof(mod_tsx_user));
+    mod_tsx_user.id = -1;
+
+    /* Populate the transaction table */
+    for (i=0; i<working_set; ++i) {
+        PJ_TEST_SUCCESS(pjsip_tsx_create_uac(&mod_tsx_user, request, &tsx[i]),
+                        NULL, {rc=-330; goto on_error;});
+        pj_strdup(pool, &keys[i], &tsx[i]->transaction_key);
+
+        /* Reset branch param */
+        via->branch_param.slen = 0;
+    }
+
+    /* Create the lookup threads suspended, so they start together */
+    rc = 0;
+    for (i=0; i<thread_cnt; ++i) {
+        prm[i].keys = keys;
+        prm[i].key_cnt = working_set;
+        prm[i].start = i * (working_set / thread_cnt);
+        prm[i].loop = loop;
+        PJ_TEST_SUCCESS(pj_thread_create(pool, "tsxlookup%p", &lookup_thread,
+                                         &prm[i], 0, PJ_THREAD_SUSPENDED,
+                                         &prm[i].thread),
+                        NULL, {rc=-340; break;});
+    }
+    thread_cnt = i;
+
+    pj_get_timestamp(&t1);
+    for (i=0; i<thread_cnt; ++i)
+        pj_thread_resume(prm[i].thread);
+    for (i=0; i<thread_cnt; ++i) {
+        pj_thread_join(prm[i].thread);
+        pj_thread_destroy(prm[i].thread);
+    }
+    pj_get_timestamp(&t2);
+    pj_sub_timestamp(&t2, &t1);
+    p_elapsed->u64 = t2.u64;
+
+    for (i=0; i<thread_cnt && rc==0; ++i) {
+        PJ_TEST_EQ(prm[i].found, loop, "all lookups must succeed",
+                   rc = -350);
+    }
+
+on_error:
+    for (i=0; i<working_set; ++i) {
+        if (tsx[i]) {
+            pj_timer_heap_t *th;
+
+            pjsip_tsx_terminate(tsx[i], 601);
+            tsx[i] = NULL;
+
+            th = pjsip_endpt_get_timer_heap(endpt);
+            pj_timer_heap_poll(th, NULL);
+        }
+    }
+    pjsip_tx_data_dec_ref(request);
+    pj_pool_release(pool);
+    flush_events(2000);
+    return rc;
+}
+
+
 int tsx_bench(void)
 {
-    enum { WORKING_SET=10000, REPEAT = 4 };
+    enum { WORKING_SET=10000, REPEAT = 4, LOOKUP_LOOP = 200000 };
+    static const unsigned lookup_threads[] = { 1, 4, 16 };
     unsigned i, speed;
     pj_timestamp usec[REPEAT], min, freq;
     char desc[250];
@@ -286,6 +416,36 @@ int tsx_bench(void)
     report_ival("create-uas-tsx-per-sec", 
                 speed, "tsx/sec", desc);
 
+
+    /*
+     * Benchmark multi-threaded transaction lookup
+     */
+    PJ_LOG(3,(THIS_FILE, "   benchmarking multi-threaded transaction lookup:"));
+    for (i=0; i<PJ_ARRAY_SIZE(lookup_threads); ++i) {
+        unsigned thread_cnt = lookup_threads[i];
+        char name[80];
+
+        status = lookup_tsx_bench(WORKING_SET, thread_cnt, LOOKUP_LOOP,
+                                  &usec[0]);
+        if (status != PJ_SUCCESS)
+            return status;
+
+        speed = (unsigned)(freq.u64 * thread_cnt * LOOKUP_LOOP /
+                           usec[0].u64);
+        PJ_LOG(3,(THIS_FILE, "    %2d thread(s): %d lookups/sec",
+                  thread_cnt, speed));
+
+        pj_ansi_snprintf(name, sizeof(name), "lookup-tsx-%d-thread-per-sec",
+                         thread_cnt);
+        pj_ansi_snprintf(desc, sizeof(desc), 
+                         "Number of transaction lookups per second with "
+                         "<tt>pjsip_tsx_layer_find_tsx2()</tt> by %d "
+                         "concurrent threads, with %d transactions in "
+                         "the table.",
+                         thread_cnt, WORKING_SET);
+        report_ival(name, speed, "lookup/sec", desc);
+    }
+
     return PJ_SUCCESS;
 }
 